@@ -25,6 +25,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkMessage.h"
 #include <MitkCoreExports.h>
 #include <map>
+#include <memory>
+#include <set>
 
 namespace mitk
 {
@@ -197,6 +199,34 @@ namespace mitk
     //##
     const DataNode::GroupTagList GetGroupTags() const;
 
+    //##Documentation
+    //## @brief Maintains an index of all nodes on the given property key
+    //##
+    //## GetSubset() and all methods based on it (e.g. GetNamedNode(), GetNode()) use the
+    //## indices to narrow down the nodes that have to be checked, if the condition is a
+    //## NodePredicateDataType, a NodePredicateProperty on an indexed (non-renderer-specific)
+    //## property key, or a NodePredicateAnd containing one of them. The data type is always indexed,
+    //## the "name" property by default.
+    //## StringProperty values are indexed by value, for all other property types the index
+    //## only contains which nodes have the property at all.
+    //##
+    //## Only the renderer independent property list of each node is indexed. Nodes that do not
+    //## have the property in this list are always checked by the predicate, so properties found
+    //## elsewhere (e.g. in the property list of the node's data) never lead to missing results.
+    //## The indices are updated on Add() and Remove(), on modification of the node (which includes
+    //## modifications of its property list) and on modification of an indexed property object.
+    void AddIndexedPropertyKey(const std::string &propertyKey);
+
+    //##Documentation
+    //## @brief Stops maintaining the index of the given property key (see AddIndexedPropertyKey())
+    //##
+    void RemoveIndexedPropertyKey(const std::string &propertyKey);
+
+    //##Documentation
+    //## @brief Returns the property keys that are indexed (see AddIndexedPropertyKey())
+    //##
+    std::set<std::string> GetIndexedPropertyKeys() const;
+
     /*ITK Mutex */
     mutable itk::SimpleFastMutexLock m_MutexOne;
 
@@ -405,6 +435,23 @@ namespace mitk
     //## @brief  Removes a Modified-Listener from the given Node.
     void RemoveListeners(const mitk::DataNode *_Node);
 
+    //##Documentation
+    //## @brief Callback for modifications of indexed property objects.
+    void OnIndexedPropertyModified(const itk::Object *caller, const itk::EventObject &event);
+
+    //##Documentation
+    //## @brief  Adds the node to the indices or updates its index entries.
+    void IndexNode(const mitk::DataNode *node);
+
+    //##Documentation
+    //## @brief  Removes the node from all indices.
+    void UnindexNode(const mitk::DataNode *node);
+
+    //##Documentation
+    //## @brief  Collects the nodes that can fulfill the condition according to the indices.
+    //## @return false if the condition can not be answered with the indices.
+    bool GetIndexedCandidates(const NodePredicateBase *condition, std::set<const mitk::DataNode *> &candidates) const;
+
     //##Documentation
     //## @brief  Saves Modified-Observer Tags for each node in order to remove the event listeners again.
     std::map<const mitk::DataNode *, unsigned long> m_NodeModifiedObserverTags;
@@ -420,6 +467,15 @@ namespace mitk
     //## to suppress NodeChangedEvent to be emitted.
     bool m_BlockNodeModifiedEvents;
 
+    //##Documentation
+    //## @brief Secondary indices used by GetSubset(), see AddIndexedPropertyKey().
+    struct NodeIndex;
+    std::unique_ptr<NodeIndex> m_NodeIndex;
+
+    //##Documentation
+    //## @brief Protects m_NodeIndex.
+    mutable itk::SimpleFastMutexLock m_NodeIndexMutex;
+
     //##Documentation
     //## @brief Standard Constructor for ::New() instantiation
     DataStorage();
@@ -165,6 +165,13 @@ namespace mitk
     virtual vtkImageData *GetVtkImageData(int t = 0, int n = 0);
     virtual const vtkImageData *GetVtkImageData(int t = 0, int n = 0) const;
 
+    //##Documentation
+    //## @brief Number of write accesses (ImageWriteAccessor) which have been released so far.
+    //##
+    //## Writers are supposed to call Modified(), but many only write through an accessor. Caches
+    //## of pixel data, e.g. the slices of ImageVtkMapper2D, compare this count to notice such writes.
+    unsigned long GetWriteAccessCount() const;
+
     //##Documentation
     //## @brief Get the complete image, i.e., all channels linked together, as a @a mitkIpPicDescriptor.
     //##
@@ -734,6 +741,8 @@ namespace mitk
     mutable std::vector<ImageAccessorBase *> m_Readers;
     /** Stores all existing ImageWriteAccessors */
     mutable std::vector<ImageAccessorBase *> m_Writers;
+    /** Number of released ImageWriteAccessors, see GetWriteAccessCount() */
+    unsigned long m_WriteAccessCount;
     /** Stores all existing ImageVtkAccessors */
     mutable std::vector<ImageAccessorBase *> m_VtkReaders;
 
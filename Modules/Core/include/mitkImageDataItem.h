@@ -134,6 +134,9 @@ namespace mitk
     unsigned long GetSize() const { return m_Size; }
     virtual void Modified() const;
 
+    /** \brief Returns true if the data buffer is backed by a swap file of mitk::ImageDataItemPager. */
+    bool IsPagedMemory() const { return m_Parent.IsNull() ? m_PagedMemory : m_Parent->IsPagedMemory(); }
+
   protected:
     unsigned char *m_Data;
 
@@ -153,6 +156,10 @@ namespace mitk
   private:
     void ComputeItemSize(const unsigned int *dimensions, unsigned int dimension);
 
+    void AllocateData();
+
+    bool m_PagedMemory;
+
     ImageDataItem::ConstPointer m_Parent;
 
     unsigned int m_Dimension;
@@ -0,0 +1,163 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIMAGEDATAITEMPAGER_H
+#define MITKIMAGEDATAITEMPAGER_H
+
+#include <MitkCoreExports.h>
+
+#include <itkSimpleFastMutexLock.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mitk
+{
+  /**
+   * \brief Optional disk backed storage for the pixel buffers of mitk::ImageDataItem.
+   *
+   * When enabled, every ImageDataItem that owns a buffer of at least GetMinimumPagedSize() bytes
+   * allocates it as a shared memory mapping of an anonymous (already unlinked) swap file instead
+   * of heap memory. Pixel addresses stay valid for the whole lifetime of the item, so sub items
+   * (slices, volumes) and vtkImageData wrappers keep working unchanged; pages that are not
+   * resident are faulted in by the operating system on access.
+   *
+   * Every ImageReadAccessor and ImageWriteAccessor reports the region it is about to access via
+   * Touch(). The pager keeps these regions in a least recently used list and, as soon as the
+   * accumulated size of resident regions exceeds GetMemoryBudget(), writes the least recently used
+   * regions back to their swap file and releases their physical memory. This allows to open
+   * time series that are considerably larger than the available RAM without swapping.
+   *
+   * Resident regions never overlap: touching a region cuts it out of all resident regions it overlaps,
+   * so every byte is counted once, no matter how often it is accessed via slices or volumes. Regions
+   * are only selected for eviction while the pager is locked, writing them back to disk happens
+   * afterwards, so other threads are not blocked by disk I/O.
+   *
+   * Paging is disabled by default and currently only available on POSIX systems. On other
+   * platforms (or if the swap file cannot be created) Allocate() returns nullptr and the caller
+   * falls back to regular heap memory.
+   *
+   * \ingroup Data
+   */
+  class MITKCORE_EXPORT ImageDataItemPager
+  {
+  public:
+    static ImageDataItemPager *GetInstance();
+
+    /** \brief Enable or disable paging for all buffers allocated from now on. */
+    void SetEnabled(bool enabled);
+    bool GetEnabled() const;
+
+    /** \brief Maximum number of bytes of touched regions that are kept resident. */
+    void SetMemoryBudget(size_t bytes);
+    size_t GetMemoryBudget() const;
+
+    /** \brief Buffers smaller than this are always allocated on the heap. */
+    void SetMinimumPagedSize(size_t bytes);
+    size_t GetMinimumPagedSize() const;
+
+    /** \brief Directory for swap files. Defaults to mitk::IOUtil::GetTempPath(). */
+    void SetSwapDirectory(const std::string &directory);
+    std::string GetSwapDirectory() const;
+
+    /**
+     * \brief Allocates a disk backed buffer of the given size.
+     * \return nullptr if paging is disabled, the buffer is too small or the swap file could not
+     *         be created. In this case, the caller is expected to allocate heap memory.
+     */
+    unsigned char *Allocate(size_t size);
+
+    /** \brief Releases a buffer previously returned by Allocate(). */
+    void Release(unsigned char *data);
+
+    /** \brief Returns true if \a data points into a buffer that was returned by Allocate(). */
+    bool IsPaged(const unsigned char *data) const;
+
+    /**
+     * \brief Marks the given region as most recently used and evicts least recently used regions
+     *        until the memory budget is met again. Regions outside of paged buffers are ignored.
+     */
+    void Touch(const unsigned char *begin, size_t size);
+
+    /** \brief Writes the given region back to disk and releases its physical memory. */
+    void Evict(const unsigned char *begin, size_t size);
+
+    /** \brief Accumulated size of all regions that are currently considered resident. */
+    size_t GetResidentSize() const;
+
+  private:
+    ImageDataItemPager();
+    ~ImageDataItemPager();
+
+    ImageDataItemPager(const ImageDataItemPager &) = delete;
+    ImageDataItemPager &operator=(const ImageDataItemPager &) = delete;
+
+    struct Mapping
+    {
+      int FileDescriptor;
+      size_t Size;
+      /** Number of evictions that are running outside of the lock. */
+      unsigned int PendingEvictions;
+      /** Release() was called while evictions were pending, the last one unmaps the buffer. */
+      bool Released;
+    };
+
+    /** Whole pages of a mapping that are written back and released outside of the lock. */
+    struct Eviction
+    {
+      const unsigned char *MappingBegin;
+      int FileDescriptor;
+      size_t Offset;
+      size_t Length;
+    };
+
+    typedef std::pair<const unsigned char *, size_t> RegionType;
+    typedef std::list<RegionType> RegionListType;
+    typedef std::map<const unsigned char *, Mapping> MappingMapType;
+    /** Resident regions by their begin, regions do not overlap. */
+    typedef std::map<const unsigned char *, RegionListType::iterator> RegionMapType;
+    typedef std::vector<Eviction> EvictionListType;
+
+    MappingMapType::iterator FindMapping(const unsigned char *data);
+    MappingMapType::const_iterator FindMapping(const unsigned char *data) const;
+    void PrepareEviction(const RegionType &region, MappingMapType::iterator mappingIter, EvictionListType &evictions);
+    void EvictLeastRecentlyUsedRegions(EvictionListType &evictions);
+    void ForgetRegions(const unsigned char *begin, size_t size);
+    void AddRegion(const RegionType &region, RegionListType::iterator position);
+
+    /** Writes the given pages back to disk and releases them. Must be called without holding the lock. */
+    void EvictPages(const EvictionListType &evictions);
+
+    void Unmap(MappingMapType::iterator mappingIter);
+
+    bool m_Enabled;
+    size_t m_MemoryBudget;
+    size_t m_MinimumPagedSize;
+    std::string m_SwapDirectory;
+
+    size_t m_ResidentSize;
+    MappingMapType m_Mappings;
+    RegionListType m_LeastRecentlyUsed;
+    RegionMapType m_Regions;
+
+    mutable itk::SimpleFastMutexLock m_Mutex;
+  };
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIMAGEPIXELSAMPLER_H
+#define MITKIMAGEPIXELSAMPLER_H
+
+#include <MitkCoreExports.h>
+
+#include "mitkAffineTransform3D.h"
+#include "mitkNumericTypes.h"
+
+#include <memory>
+#include <vector>
+
+namespace mitk
+{
+  class Image;
+  class ImageReadAccessor;
+
+  /**
+   * @brief Samples the pixel values of one time step and component of an image at many positions at once.
+   *
+   * In contrast to Image::GetPixelValueByIndex(), the pixel type is dispatched and read access to the
+   * image is acquired only once, when the sampler is constructed. All subsequent calls sample directly
+   * from the image buffer, either by nearest neighbor or by trilinear interpolation.
+   *
+   * Positions are given as continuous indices (pixel centers at integer positions, as returned by
+   * BaseGeometry::WorldToIndex()) or as world coordinates. A position is inside the image if its
+   * rounded index is inside; positions outside of the image result in the outside value without any
+   * logging. Trilinear interpolation clamps the neighborhood at the image border.
+   *
+   * For multi-component pixels (e.g. RGB or vector images) the component given at construction is sampled.
+   *
+   * The sampler holds a read accessor for its whole lifetime, so write accessors on the same image will
+   * wait until it is destroyed. Keep it local to the code that samples.
+   *
+   * @ingroup Data
+   */
+  class MITKCORE_EXPORT ImagePixelSampler
+  {
+  public:
+    enum InterpolationMode
+    {
+      NearestNeighbor,
+      Trilinear
+    };
+
+    /**
+     * \throws mitk::Exception if the image is not initialized, the time step or component does not exist
+     *         or the pixel type is not supported
+     */
+    ImagePixelSampler(const Image *image, unsigned int timeStep = 0, unsigned int component = 0);
+    ~ImagePixelSampler();
+
+    void SetInterpolationMode(InterpolationMode mode);
+    InterpolationMode GetInterpolationMode() const;
+
+    /** \brief Value returned for positions outside of the image (default 0). */
+    void SetOutsideValue(ScalarType value);
+    ScalarType GetOutsideValue() const;
+
+    /** \brief Samples @a numberOfPositions continuous indices, @a values has to provide as many elements. */
+    void SampleByIndex(const Point3D *indices, std::size_t numberOfPositions, ScalarType *values) const;
+
+    /** \brief Samples @a numberOfPositions world coordinates, @a values has to provide as many elements. */
+    void SampleByWorldCoordinate(const Point3D *points, std::size_t numberOfPositions, ScalarType *values) const;
+
+    std::vector<ScalarType> SampleByIndex(const std::vector<Point3D> &indices) const;
+    std::vector<ScalarType> SampleByWorldCoordinate(const std::vector<Point3D> &points) const;
+
+    ScalarType SampleByIndex(const Point3D &index) const;
+    ScalarType SampleByWorldCoordinate(const Point3D &point) const;
+
+  private:
+    typedef void (*SampleFunctionType)(const ImagePixelSampler &, const Point3D *, std::size_t, ScalarType *);
+
+    template <typename TPixel>
+    static void SampleTemplate(const ImagePixelSampler &sampler,
+                               const Point3D *indices,
+                               std::size_t numberOfPositions,
+                               ScalarType *values);
+
+    ImagePixelSampler(const ImagePixelSampler &);
+    ImagePixelSampler &operator=(const ImagePixelSampler &);
+
+    std::unique_ptr<ImageReadAccessor> m_Accessor;
+    const void *m_Data;
+    SampleFunctionType m_SampleFunction;
+
+    std::size_t m_Dimensions[3];
+    std::size_t m_NumberOfComponents;
+    std::size_t m_Component;
+
+    AffineTransform3D::MatrixType m_WorldToIndexMatrix;
+    AffineTransform3D::OffsetType m_WorldToIndexOffset;
+
+    InterpolationMode m_InterpolationMode;
+    ScalarType m_OutsideValue;
+  };
+}
+
+#endif // MITKIMAGEPIXELSAMPLER_H
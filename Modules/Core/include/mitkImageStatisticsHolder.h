@@ -24,6 +24,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkHistogram.h>
 #endif
 
+#include <list>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+
 namespace mitk
 {
   /**
@@ -35,6 +41,9 @@ namespace mitk
     Each mitk::Image holds a normal pointer to its StatisticsHolder object. To get access to the methods, use the
     GetStatistics() method
     in mitk::Image class.
+
+    Statistics are cached per time step and component until the image is modified. Extrema and histogram
+    are computed together by a parallel reduction over regions of the pixel buffer.
     */
   class MITKCORE_EXPORT ImageStatisticsHolder
   {
@@ -47,7 +56,9 @@ namespace mitk
 
     typedef itk::Statistics::Histogram<double> HistogramType;
 
-    virtual const HistogramType *GetScalarHistogram(int t = 0, unsigned int = 0);
+    //##Documentation
+    //## \brief Get the histogram with 256 bins between minimum and maximum. Recomputation performed only when necessary.
+    virtual const HistogramType *GetScalarHistogram(int t = 0, unsigned int component = 0);
 
     //##Documentation
     //## \brief Get the minimum for scalar images. Recomputation performed only when necessary.
@@ -63,23 +74,11 @@ namespace mitk
 
     //##Documentation
     //## \brief Get the smallest value for scalar images, but do not recompute it first
-    virtual mitk::ScalarType GetScalarValueMinNoRecompute(unsigned int t = 0) const
-    {
-      if (t < m_ScalarMin.size())
-        return m_ScalarMin[t];
-      else
-        return itk::NumericTraits<ScalarType>::max();
-    }
+    virtual mitk::ScalarType GetScalarValueMinNoRecompute(unsigned int t = 0) const;
 
     //##Documentation
     //## \brief Get the second smallest value for scalar images, but do not recompute it first
-    virtual mitk::ScalarType GetScalarValue2ndMinNoRecompute(unsigned int t = 0) const
-    {
-      if (t < m_Scalar2ndMin.size())
-        return m_Scalar2ndMin[t];
-      else
-        return itk::NumericTraits<ScalarType>::max();
-    }
+    virtual mitk::ScalarType GetScalarValue2ndMinNoRecompute(unsigned int t = 0) const;
 
     //##Documentation
     //## \brief Get the second largest value for scalar images
@@ -87,23 +86,11 @@ namespace mitk
 
     //##Documentation
     //## \brief Get the largest value for scalar images, but do not recompute it first
-    virtual mitk::ScalarType GetScalarValueMaxNoRecompute(unsigned int t = 0)
-    {
-      if (t < m_ScalarMax.size())
-        return m_ScalarMax[t];
-      else
-        return itk::NumericTraits<ScalarType>::NonpositiveMin();
-    }
+    virtual mitk::ScalarType GetScalarValueMaxNoRecompute(unsigned int t = 0);
 
     //##Documentation
     //## \brief Get the second largest value for scalar images, but do not recompute it first
-    virtual mitk::ScalarType GetScalarValue2ndMaxNoRecompute(unsigned int t = 0)
-    {
-      if (t < m_Scalar2ndMax.size())
-        return m_Scalar2ndMax[t];
-      else
-        return itk::NumericTraits<ScalarType>::NonpositiveMin();
-    }
+    virtual mitk::ScalarType GetScalarValue2ndMaxNoRecompute(unsigned int t = 0);
 
     //##Documentation
     //## \brief Get the count of voxels with the smallest scalar value in the dataset
@@ -115,57 +102,91 @@ namespace mitk
 
     //##Documentation
     //## \brief Get the count of voxels with the largest scalar value in the dataset
-    virtual unsigned int GetCountOfMaxValuedVoxelsNoRecompute(unsigned int t = 0)
-    {
-      if (t < m_CountOfMaxValuedVoxels.size())
-        return m_CountOfMaxValuedVoxels[t];
-      else
-        return 0;
-    }
+    virtual unsigned int GetCountOfMaxValuedVoxelsNoRecompute(unsigned int t = 0);
 
     //##Documentation
     //## \brief Get the count of voxels with the smallest scalar value in the dataset
-    virtual unsigned int GetCountOfMinValuedVoxelsNoRecompute(unsigned int t = 0) const
-    {
-      if (t < m_CountOfMinValuedVoxels.size())
-        return m_CountOfMinValuedVoxels[t];
-      else
-        return 0;
-    }
+    virtual unsigned int GetCountOfMinValuedVoxelsNoRecompute(unsigned int t = 0) const;
 
     bool IsValidTimeStep(int t) const;
 
-    template <typename ItkImageType>
-    friend void _ComputeExtremaInItkImage(const ItkImageType *itkImage,
-                                          mitk::ImageStatisticsHolder *statisticsHolder,
-                                          int t);
+    //##Documentation
+    //## \brief Compute the statistics of large volumes in the background.
+    //##
+    //## When enabled, the first request for a time step and component computes the statistics from
+    //## a regular subsample of the pixels and returns these coarse values immediately. Voxel counts and
+    //## histogram frequencies of coarse statistics are extrapolated from the subsample. The exact
+    //## statistics are computed by a background thread and replace the coarse ones with the first
+    //## request after they are ready. The background thread holds read access to the time step, so
+    //## write accessors wait until it is finished. Disabled by default.
+    void SetComputeInBackground(bool computeInBackground);
+    bool GetComputeInBackground() const;
+
+    //##Documentation
+    //## \brief Returns true as long as only the coarse statistics of a time step and component are available.
+    bool IsCoarse(int t = 0, unsigned int component = 0) const;
 
-    template <typename ItkImageType>
-    friend void _ComputeExtremaInItkVectorImage(const ItkImageType *itkImage,
-                                                mitk::ImageStatisticsHolder *statisticsHolder,
-                                                int t,
-                                                unsigned int component);
+    //##Documentation
+    //## \brief Blocks until all background computations are finished and their results are available.
+    void WaitForBackgroundComputations();
 
   protected:
+    /** Extrema and histogram of one time step and component */
+    struct Statistics
+    {
+      Statistics();
+
+      ScalarType Min;
+      ScalarType Max;
+      ScalarType SecondMin;
+      ScalarType SecondMax;
+      std::size_t CountOfMin;
+      std::size_t CountOfMax;
+      HistogramType::Pointer Histogram;
+      bool Coarse;
+    };
+
+    struct BackgroundComputation;
+
+    typedef std::pair<unsigned int, unsigned int> StatisticsKey;
+    typedef std::map<StatisticsKey, Statistics> StatisticsMap;
+    typedef std::list<std::pair<std::thread, std::shared_ptr<BackgroundComputation>>> BackgroundThreadList;
+
     virtual void ResetImageStatistics();
 
     virtual void ComputeImageStatistics(int t = 0, unsigned int component = 0);
 
     virtual void Expand(unsigned int timeSteps);
 
-    ImageTimeSelector::Pointer GetTimeSelector();
+    /** \brief Computes the statistics if necessary, returns default statistics for invalid time steps. */
+    const Statistics &GetComponentStatistics(int t, unsigned int component);
 
-    mitk::Image *m_Image;
+    /** \brief Cached statistics of time step @a t and @a component (0 for scalar images), or default statistics. */
+    const Statistics &FindComponentStatistics(unsigned int t, unsigned int component) const;
+
+    /** \brief Joins finished (or, if @a wait is true, all) background threads and caches their results. */
+    void CollectBackgroundComputations(bool wait) const;
+
+    /**
+      \brief Computes the statistics of every @a sampleStride-th pixel of time step @a t of @a image.
+      \return false if the pixel type is not supported
+    */
+    static bool ComputeStatistics(const Image *image,
+                                  unsigned int t,
+                                  unsigned int component,
+                                  std::size_t sampleStride,
+                                  Statistics &statistics);
+
+    static void ComputeInBackground(Image::ConstPointer image,
+                                    unsigned int t,
+                                    unsigned int component,
+                                    std::shared_ptr<BackgroundComputation> computation);
 
-    mutable itk::Object::Pointer m_HistogramGeneratorObject;
+    mitk::Image *m_Image;
 
-    mutable itk::Object::Pointer m_TimeSelectorForExtremaObject;
-    mutable std::vector<unsigned int> m_CountOfMinValuedVoxels;
-    mutable std::vector<unsigned int> m_CountOfMaxValuedVoxels;
-    mutable std::vector<ScalarType> m_ScalarMin;
-    mutable std::vector<ScalarType> m_ScalarMax;
-    mutable std::vector<ScalarType> m_Scalar2ndMin;
-    mutable std::vector<ScalarType> m_Scalar2ndMax;
+    mutable StatisticsMap m_Statistics;
+    mutable BackgroundThreadList m_BackgroundThreads;
+    bool m_ComputeInBackground;
 
     itk::TimeStamp m_LastRecomputeTimeStamp;
   };
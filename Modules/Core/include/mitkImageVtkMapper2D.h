@@ -184,6 +184,37 @@ namespace mitk
       /** \brief Timestamp of last update of stored data. */
       itk::TimeStamp m_LastUpdateTime;
 
+      /** \brief Everything m_ReslicedImage depends on.
+          GenerateDataForRenderer() only re-executes the reslicer if this state changes, so that
+          e.g. level window changes only re-execute m_LevelWindowFilter. Besides the MTime of the
+          image, the MTime of its vtkImageData (see ImageDataItem::Modified()) and its write access
+          count (see Image::GetWriteAccessCount()) are compared, so pixels written without calling
+          Image::Modified() do not leave a stale slice. Only writes through a raw pointer of
+          Image::GetData() remain undetected. */
+      struct ResliceState
+      {
+        ResliceState();
+        bool operator==(const ResliceState &other) const;
+        bool operator!=(const ResliceState &other) const { return !(*this == other); }
+
+        const mitk::Image *Image;
+        unsigned long ImageMTime;
+        unsigned long ImageWriteAccessCount;
+        unsigned long VolumeMTime;
+        unsigned long ImageGeometryMTime;
+        const mitk::PlaneGeometry *WorldGeometry;
+        unsigned long WorldGeometryMTime;
+        unsigned long WorldGeometryUpdateTime;
+        int TimeStep;
+        int InterpolationMode;
+        bool InPlaneResampleExtentByGeometry;
+        int ThickSlicesMode;
+        int ThickSlicesNum;
+      };
+
+      /** \brief State m_ReslicedImage was extracted for. Reset to ResliceState() to enforce reslicing. */
+      ResliceState m_ResliceState;
+
       /** \brief mmPerPixel relation between pixel and mm. (World spacing).*/
       mitk::ScalarType *m_mmPerPixel;
 
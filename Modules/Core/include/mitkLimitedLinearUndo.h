@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkUndoModel.h"
 #include <MitkCoreExports.h>
 // STL header
+#include <cstddef>
 #include <vector>
 // ITK header
 #pragma GCC visibility push(default)
@@ -101,6 +102,24 @@ namespace mitk
     //## corresponding to the given values; if nothing found, then returns nullptr
     virtual OperationEvent *GetLastOfType(OperationActor *destination, OperationType opType) override;
 
+    //##Documentation
+    //## @brief Limits the memory held by the undo and redo stacks (see UndoStackItem::GetMemoryUsage())
+    //##
+    //## Whenever a new item exceeds the limit, the oldest undo items are discarded (complete object
+    //## events at a time) and an UndoFullEvent is invoked. The most recent object event is always kept.
+    //## The limit defaults to DefaultMemoryLimit; a limit of 0 disables the check.
+    void SetMemoryLimit(std::size_t bytes);
+    std::size_t GetMemoryLimit() const;
+
+    //##Documentation
+    //## @brief Returns the memory currently held by the undo and redo stacks
+    //##
+    //## The total is updated whenever items are added or discarded, so this is cheap to call.
+    std::size_t GetMemoryUsage() const;
+
+    //## @brief Memory limit of a newly created undo model (1 GiB)
+    static const std::size_t DefaultMemoryLimit;
+
   protected:
     //##Documentation
     //## Constructor
@@ -118,6 +137,17 @@ namespace mitk
 
     UndoContainer m_RedoList;
 
+    //## @brief Discards the oldest undo items until the memory limit is met
+    void EnforceMemoryLimit();
+
+    //## @brief Subtracts the memory of an item which is discarded from m_MemoryUsage
+    void ReleaseMemoryUsage(const UndoStackItem *item);
+
+    std::size_t m_MemoryLimit;
+
+    //## @brief Memory held by all items of the undo and redo stacks
+    std::size_t m_MemoryUsage;
+
   private:
     int FirstObjectEventIdOfCurrentGroup(UndoContainer &stack);
   };
@@ -131,7 +161,8 @@ namespace mitk
   itkEventMacro(RedoEmptyEvent, UndoStackEvent);
   itkEventMacro(UndoNotEmptyEvent, UndoStackEvent);
   itkEventMacro(RedoNotEmptyEvent, UndoStackEvent);
-  /// Additional unused events, if anybody wants to put an artificial limit to the possible number of items in the stack
+  /// Invoked when old items are discarded to meet the memory limit (see LimitedLinearUndo::SetMemoryLimit()).
+  /// RedoFullEvent is currently unused.
   itkEventMacro(UndoFullEvent, UndoStackEvent);
   itkEventMacro(RedoFullEvent, UndoStackEvent);
 
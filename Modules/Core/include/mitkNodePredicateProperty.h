@@ -49,6 +49,16 @@ namespace mitk
     //## @brief Checks, if the nodes contains a property that is equal to m_ValidProperty
     virtual bool CheckNode(const mitk::DataNode *node) const override;
 
+    //##Documentation
+    //## @brief Name of the checked property
+    const std::string &GetValidPropertyName() const { return m_ValidPropertyName; }
+    //##Documentation
+    //## @brief Property the node's property is compared to, nullptr if only the existence is checked
+    const mitk::BaseProperty *GetValidProperty() const { return m_ValidProperty; }
+    //##Documentation
+    //## @brief Renderer of the checked renderer-specific property, nullptr for the non-renderer-specific property
+    const mitk::BaseRenderer *GetRenderer() const { return m_Renderer; }
+
   protected:
     //##Documentation
     //## @brief Constructor to check for a named property
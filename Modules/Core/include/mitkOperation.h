@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkCommon.h>
 
+#include <cstddef>
+
 namespace mitk
 {
   typedef int OperationType;
@@ -43,6 +45,13 @@ namespace mitk
 
     OperationType GetOperationType();
 
+    //##Documentation
+    //## @brief Approximate number of bytes of data held by this operation.
+    //##
+    //## Used by undo models to limit their memory consumption. Operations that
+    //## keep large data (e.g. image slices) should override this, the default is 0.
+    virtual std::size_t GetMemoryUsage() const;
+
   protected:
     OperationType m_OperationType;
   };
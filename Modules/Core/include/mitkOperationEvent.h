@@ -78,6 +78,10 @@ namespace mitk
     virtual void ReverseOperations();
     virtual void ReverseAndExecute();
 
+    //##Documentation
+    //## @brief Approximate number of bytes of data held by this item, see Operation::GetMemoryUsage()
+    virtual std::size_t GetMemoryUsage() const;
+
     //##Documentation
     //## @brief Increases the current ObjectEventId
     //## For example if a button click generates operations the ObjectEventId has to be incremented to be able to undo
@@ -170,6 +174,9 @@ namespace mitk
     //##reverses and executes both operations (used, when moved from undo to redo stack)
     virtual void ReverseAndExecute() override;
 
+    //## @brief Sum of the memory usage of operation and undo operation
+    virtual std::size_t GetMemoryUsage() const override;
+
     //## @brief returns true if the destination still is present
     //## and false if it already has been deleted
     virtual bool IsValid();
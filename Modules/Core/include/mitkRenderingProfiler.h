@@ -0,0 +1,185 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKRENDERINGPROFILER_H
+#define MITKRENDERINGPROFILER_H
+
+#include <MitkCoreExports.h>
+
+#include <itkSimpleFastMutexLock.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mitk
+{
+  class BaseRenderer;
+  class DataNode;
+
+  /**
+   * \brief Records where the time of the render loop is spent.
+   *
+   * When enabled, the rendering classes record an event with wall time for
+   *  - every Mapper::Update() and Mapper::GenerateDataForRenderer() call (categories "Update" and "GenerateData"),
+   *  - every paint pass of a mapper in VtkPropRenderer::Render() (category "Paint", named after the pass),
+   *  - every frame of a render window, from the start to the end event of the vtkRenderWindow (category "Frame"),
+   *  - every level of detail decision of the RenderingManager (category "LOD", an instant event).
+   *
+   * Events carry the name of the renderer and, for mapper events, of the data node. They can be queried via
+   * GetEvents() and summarized per data node via GetTimingSummariesPerNode(), which points to the node that makes
+   * a scene slow. WriteChromeTrace() writes all events in the Chrome trace event format, which can be loaded
+   * in chrome://tracing or similar viewers. Each renderer shows up as a separate thread there.
+   *
+   * Profiling is disabled by default; a disabled profiler costs one atomic load per instrumented call.
+   * At most GetMaximumNumberOfEvents() events are kept, older ones are dropped first.
+   *
+   * \ingroup Rendering
+   */
+  class MITKCORE_EXPORT RenderingProfiler
+  {
+  public:
+    struct Event
+    {
+      std::string Category;
+      std::string Name;
+      std::string RendererName;
+      std::string NodeName;
+
+      /** Microseconds since the profiler was created */
+      double StartTime;
+
+      /** Microseconds, 0 for instant events */
+      double Duration;
+
+      /** Level of detail of frames and LOD decisions, -1 for other events */
+      int LevelOfDetail;
+    };
+
+    struct TimingSummary
+    {
+      TimingSummary() : Count(0), TotalTime(0.0), MaximumTime(0.0) {}
+
+      unsigned int Count;
+
+      /** Microseconds */
+      double TotalTime;
+      double MaximumTime;
+    };
+
+    /**
+     * \brief Records the duration of its own lifetime as an event, if profiling is enabled at construction.
+     *
+     * \a category and \a name are not copied unless profiling is enabled, so they have to live at least as long
+     * as the ScopedEvent (string literals or class names as returned by GetNameOfClass()).
+     */
+    class MITKCORE_EXPORT ScopedEvent
+    {
+    public:
+      ScopedEvent(const char *category,
+                  const char *name,
+                  const BaseRenderer *renderer,
+                  const DataNode *node = nullptr);
+      ~ScopedEvent();
+
+    private:
+      ScopedEvent(const ScopedEvent &);
+      ScopedEvent &operator=(const ScopedEvent &);
+
+      bool m_Active;
+      const char *m_Category;
+      const char *m_Name;
+      const BaseRenderer *m_Renderer;
+      std::string m_NodeName;
+      double m_StartTime;
+    };
+
+    static RenderingProfiler *GetInstance();
+
+    void SetEnabled(bool enabled);
+    bool GetEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    /** \brief Maximum number of events that are kept (default 1000000). */
+    void SetMaximumNumberOfEvents(std::size_t maximumNumberOfEvents);
+    std::size_t GetMaximumNumberOfEvents() const;
+
+    /** \brief Removes all recorded events. */
+    void Clear();
+
+    /** \brief Records a completed event, times in microseconds as returned by GetTime(). */
+    void RecordEvent(const std::string &category,
+                     const std::string &name,
+                     const BaseRenderer *renderer,
+                     const std::string &nodeName,
+                     double startTime,
+                     double duration,
+                     int levelOfDetail = -1);
+
+    /** \brief Marks the start of a frame of \a renderer. */
+    void BeginFrame(const BaseRenderer *renderer);
+
+    /** \brief Records the frame of \a renderer started by the last BeginFrame() call. */
+    void EndFrame(const BaseRenderer *renderer, int levelOfDetail);
+
+    /** \brief Records the decision to render \a renderer with \a levelOfDetail next. */
+    void RecordLevelOfDetailDecision(const BaseRenderer *renderer, int levelOfDetail);
+
+    /** \brief Microseconds since the profiler was created. */
+    double GetTime() const;
+
+    std::vector<Event> GetEvents() const;
+
+    /** \brief Summary of all events of \a category (and \a rendererName, if not empty). */
+    TimingSummary GetTimingSummary(const std::string &category, const std::string &rendererName = "") const;
+
+    /** \brief Summaries of all events of \a category (and \a rendererName, if not empty) per data node name. */
+    std::map<std::string, TimingSummary> GetTimingSummariesPerNode(const std::string &category,
+                                                                   const std::string &rendererName = "") const;
+
+    /** \brief Summaries of all events of \a category per renderer name. */
+    std::map<std::string, TimingSummary> GetTimingSummariesPerRenderer(const std::string &category) const;
+
+    /** \brief Writes all events as JSON object in the Chrome trace event format. */
+    void WriteChromeTrace(std::ostream &stream) const;
+
+    /** \return false if the file could not be written */
+    bool WriteChromeTrace(const std::string &fileName) const;
+
+  private:
+    RenderingProfiler();
+    ~RenderingProfiler();
+
+    RenderingProfiler(const RenderingProfiler &) = delete;
+    RenderingProfiler &operator=(const RenderingProfiler &) = delete;
+
+    void AddEvent(const Event &event);
+
+    std::atomic<bool> m_Enabled;
+    std::size_t m_MaximumNumberOfEvents;
+    std::chrono::steady_clock::time_point m_StartTime;
+
+    std::deque<Event> m_Events;
+    std::map<const BaseRenderer *, double> m_FrameStartTimes;
+
+    mutable itk::SimpleFastMutexLock m_Mutex;
+  };
+}
+
+#endif // MITKRENDERINGPROFILER_H
@@ -119,7 +119,10 @@ namespace mitk
 
     //##Documentation
     //## @brief deletes all references to a node in a given relation (used in Remove() and TreeListener)
-    void RemoveFromRelation(const mitk::DataNode *node, AdjacencyList &relation);
+    //##
+    //## Only the relation lists of relatedNodes are searched for node, i.e. the derivations of node
+    //## for the sources relation and the sources of node for the derivations relation.
+    void RemoveFromRelation(const mitk::DataNode *node, AdjacencyList &relation, const SetOfObjects *relatedNodes);
 
     //##Documentation
     //## @brief Prints the contents of the StandaloneDataStorage to os. Do not call directly, call ->Print() instead
@@ -17,9 +17,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkLimitedLinearUndo.h"
 #include <mitkRenderingManager.h>
 
-mitk::LimitedLinearUndo::LimitedLinearUndo()
+const std::size_t mitk::LimitedLinearUndo::DefaultMemoryLimit = std::size_t(1) << 30;
+
+mitk::LimitedLinearUndo::LimitedLinearUndo() : m_MemoryLimit(DefaultMemoryLimit), m_MemoryUsage(0)
 {
-  // nothing to do
 }
 
 mitk::LimitedLinearUndo::~LimitedLinearUndo()
@@ -35,6 +36,7 @@ void mitk::LimitedLinearUndo::ClearList(UndoContainer *list)
   {
     UndoStackItem *item = list->back();
     list->pop_back();
+    this->ReleaseMemoryUsage(item);
     delete item;
   }
 }
@@ -53,12 +55,68 @@ bool mitk::LimitedLinearUndo::SetOperationEvent(UndoStackItem *stackItem)
   }
 
   m_UndoList.push_back(operationEvent);
+  m_MemoryUsage += operationEvent->GetMemoryUsage();
 
   InvokeEvent(UndoNotEmptyEvent());
 
+  this->EnforceMemoryLimit();
+
   return true;
 }
 
+void mitk::LimitedLinearUndo::SetMemoryLimit(std::size_t bytes)
+{
+  m_MemoryLimit = bytes;
+  this->EnforceMemoryLimit();
+}
+
+std::size_t mitk::LimitedLinearUndo::GetMemoryLimit() const
+{
+  return m_MemoryLimit;
+}
+
+std::size_t mitk::LimitedLinearUndo::GetMemoryUsage() const
+{
+  return m_MemoryUsage;
+}
+
+void mitk::LimitedLinearUndo::ReleaseMemoryUsage(const UndoStackItem *item)
+{
+  const std::size_t memoryUsage = item->GetMemoryUsage();
+  m_MemoryUsage = memoryUsage < m_MemoryUsage ? m_MemoryUsage - memoryUsage : 0;
+}
+
+void mitk::LimitedLinearUndo::EnforceMemoryLimit()
+{
+  if (m_MemoryLimit == 0 || m_UndoList.empty())
+    return;
+
+  if (m_MemoryUsage <= m_MemoryLimit)
+    return;
+
+  // never discard (parts of) the most recent object event
+  const int lastObjectEventId = m_UndoList.back()->GetObjectEventId();
+
+  auto end = m_UndoList.begin();
+  while (m_MemoryUsage > m_MemoryLimit && end != m_UndoList.end() && (*end)->GetObjectEventId() != lastObjectEventId)
+  {
+    // discard all items of the oldest object event together, undoing only a part of it is not meaningful
+    const int objectEventId = (*end)->GetObjectEventId();
+    while (end != m_UndoList.end() && (*end)->GetObjectEventId() == objectEventId)
+    {
+      this->ReleaseMemoryUsage(*end);
+      delete *end;
+      ++end;
+    }
+  }
+
+  if (end != m_UndoList.begin())
+  {
+    m_UndoList.erase(m_UndoList.begin(), end);
+    InvokeEvent(UndoFullEvent());
+  }
+}
+
 bool mitk::LimitedLinearUndo::Undo(bool fine)
 {
   if (fine)
@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNodePredicateProperty.h"
 #include "mitkProportionalTimeGeometry.h"
 #include "mitkRenderingManagerFactory.h"
+#include "mitkRenderingProfiler.h"
 
 #include <vtkRenderWindow.h>
 
@@ -543,6 +544,7 @@ namespace mitk
     if (renderWindow)
     {
       renderWindowList[renderWindow] = RENDERING_INPROGRESS;
+      RenderingProfiler::GetInstance()->BeginFrame(BaseRenderer::GetInstance(renderWindow));
     }
 
     renman->m_UpdatePending = false;
@@ -584,13 +586,21 @@ namespace mitk
       {
         renderWindowList[renderer->GetRenderWindow()] = RENDERING_INACTIVE;
 
+        RenderingProfiler *profiler = RenderingProfiler::GetInstance();
+        profiler->EndFrame(renderer, nextLODMap[renderer]);
+
         // Level-of-Detail handling
         if (renderer->GetNumberOfVisibleLODEnabledMappers() > 0)
         {
           if (nextLODMap[renderer] == 0)
+          {
             renman->StartOrResetTimer();
+          }
           else
+          {
             nextLODMap[renderer] = 0;
+            profiler->RecordLevelOfDetailDecision(renderer, 0);
+          }
         }
       }
     }
@@ -646,6 +656,7 @@ namespace mitk
         if (m_NextLODMap[renderer] == 0)
         {
           m_NextLODMap[renderer] = 1;
+          RenderingProfiler::GetInstance()->RecordLevelOfDetailDecision(renderer, 1);
           RequestUpdate(it->first);
         }
       }
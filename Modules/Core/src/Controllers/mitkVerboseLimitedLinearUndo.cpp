@@ -38,9 +38,12 @@ bool mitk::VerboseLimitedLinearUndo::SetOperationEvent(UndoStackItem *undoStackI
   }
 
   m_UndoList.push_back(undoStackItem);
+  m_MemoryUsage += undoStackItem->GetMemoryUsage();
 
   InvokeEvent(UndoNotEmptyEvent());
 
+  this->EnforceMemoryLimit();
+
   return true;
 }
 
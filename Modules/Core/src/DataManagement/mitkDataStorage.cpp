@@ -21,16 +21,267 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDataNode.h"
 #include "mitkGroupTagProperty.h"
 #include "mitkImage.h"
+#include "mitkNodePredicateAnd.h"
 #include "mitkNodePredicateBase.h"
+#include "mitkNodePredicateDataType.h"
 #include "mitkNodePredicateProperty.h"
 #include "mitkProperties.h"
+#include "mitkStringProperty.h"
 
-mitk::DataStorage::DataStorage() : itk::Object(), m_BlockNodeModifiedEvents(false)
+/**
+ * Secondary indices of the DataStorage. All methods expect m_NodeIndexMutex to be locked.
+ */
+struct mitk::DataStorage::NodeIndex
 {
+  typedef std::set<const mitk::DataNode *> NodeSet;
+
+  struct IndexedProperty
+  {
+    mitk::BaseProperty::Pointer Property;
+    unsigned long ObserverTag;
+    bool IsString;
+    std::string StringValue;
+  };
+
+  struct NodeEntry
+  {
+    std::string DataType;
+    std::map<std::string, IndexedProperty> Properties;
+  };
+
+  struct PropertyKeyIndex
+  {
+    NodeSet Nodes;
+    std::map<std::string, NodeSet> NodesByStringValue;
+    /** Nodes without the property in their own property list, they are always checked by the predicate. */
+    NodeSet NodesWithoutProperty;
+  };
+
+  std::set<std::string> Keys;
+  std::map<const mitk::DataNode *, NodeEntry> Nodes;
+  std::map<std::string, NodeSet> NodesByDataType;
+  std::map<std::string, PropertyKeyIndex> NodesByProperty;
+  std::multimap<const itk::Object *, const mitk::DataNode *> NodesByObservedProperty;
+
+  static void EraseNode(std::map<std::string, NodeSet> &index, const std::string &key, const mitk::DataNode *node)
+  {
+    auto iter = index.find(key);
+    if (iter != index.end())
+    {
+      iter->second.erase(node);
+      if (iter->second.empty())
+        index.erase(iter);
+    }
+  }
+
+  void UpdateNode(const mitk::DataNode *node, mitk::DataStorage *storage)
+  {
+    auto insertion = Nodes.insert(std::make_pair(node, NodeEntry()));
+    NodeEntry &entry = insertion.first->second;
+
+    const std::string dataType = node->GetData() != nullptr ? node->GetData()->GetNameOfClass() : std::string();
+    if (insertion.second || entry.DataType != dataType)
+    {
+      if (!insertion.second)
+        EraseNode(NodesByDataType, entry.DataType, node);
+
+      NodesByDataType[dataType].insert(node);
+      entry.DataType = dataType;
+    }
+
+    for (const auto &key : Keys)
+      this->UpdateProperty(node, entry, key, storage);
+  }
+
+  void UpdateProperty(const mitk::DataNode *node, NodeEntry &entry, const std::string &key, mitk::DataStorage *storage)
+  {
+    // only the node's own property list is indexed, its modifications are reported by the node
+    mitk::BaseProperty *property = node->GetPropertyList()->GetProperty(key);
+
+    auto propertyIter = entry.Properties.find(key);
+    if (propertyIter != entry.Properties.end() && propertyIter->second.Property != property)
+    {
+      this->RemoveProperty(node, key, propertyIter->second);
+      entry.Properties.erase(propertyIter);
+      propertyIter = entry.Properties.end();
+    }
+
+    PropertyKeyIndex &keyIndex = NodesByProperty[key];
+
+    if (property == nullptr)
+    {
+      keyIndex.NodesWithoutProperty.insert(node);
+      return;
+    }
+
+    keyIndex.NodesWithoutProperty.erase(node);
+
+    if (propertyIter == entry.Properties.end())
+    {
+      // observe the property itself, as changing its value does not modify the node
+      itk::MemberCommand<mitk::DataStorage>::Pointer propertyModifiedCommand =
+        itk::MemberCommand<mitk::DataStorage>::New();
+      propertyModifiedCommand->SetCallbackFunction(storage, &mitk::DataStorage::OnIndexedPropertyModified);
+
+      IndexedProperty indexedProperty;
+      indexedProperty.Property = property;
+      indexedProperty.ObserverTag = property->AddObserver(itk::ModifiedEvent(), propertyModifiedCommand);
+      indexedProperty.IsString = false;
+
+      propertyIter = entry.Properties.insert(std::make_pair(key, indexedProperty)).first;
+      NodesByObservedProperty.insert(std::make_pair(property, node));
+      keyIndex.Nodes.insert(node);
+    }
+
+    IndexedProperty &indexedProperty = propertyIter->second;
+    if (indexedProperty.IsString)
+      EraseNode(keyIndex.NodesByStringValue, indexedProperty.StringValue, node);
+
+    const mitk::StringProperty *stringProperty = dynamic_cast<const mitk::StringProperty *>(property);
+    indexedProperty.IsString = stringProperty != nullptr;
+    if (indexedProperty.IsString)
+    {
+      indexedProperty.StringValue = stringProperty->GetValue();
+      keyIndex.NodesByStringValue[indexedProperty.StringValue].insert(node);
+    }
+  }
+
+  void RemoveProperty(const mitk::DataNode *node, const std::string &key, IndexedProperty &indexedProperty)
+  {
+    indexedProperty.Property->RemoveObserver(indexedProperty.ObserverTag);
+
+    auto observedRange = NodesByObservedProperty.equal_range(indexedProperty.Property.GetPointer());
+    for (auto observedIter = observedRange.first; observedIter != observedRange.second; ++observedIter)
+    {
+      if (observedIter->second == node)
+      {
+        NodesByObservedProperty.erase(observedIter);
+        break;
+      }
+    }
+
+    auto keyIter = NodesByProperty.find(key);
+    if (keyIter != NodesByProperty.end())
+    {
+      keyIter->second.Nodes.erase(node);
+      if (indexedProperty.IsString)
+        EraseNode(keyIter->second.NodesByStringValue, indexedProperty.StringValue, node);
+    }
+  }
+
+  void RemoveNode(const mitk::DataNode *node)
+  {
+    auto nodeIter = Nodes.find(node);
+    if (nodeIter == Nodes.end())
+      return;
+
+    for (auto &property : nodeIter->second.Properties)
+      this->RemoveProperty(node, property.first, property.second);
+
+    for (auto &keyIndex : NodesByProperty)
+      keyIndex.second.NodesWithoutProperty.erase(node);
+
+    EraseNode(NodesByDataType, nodeIter->second.DataType, node);
+    Nodes.erase(nodeIter);
+  }
+
+  void AddKey(const std::string &key, mitk::DataStorage *storage)
+  {
+    if (!Keys.insert(key).second)
+      return;
+
+    for (auto &nodeEntry : Nodes)
+      this->UpdateProperty(nodeEntry.first, nodeEntry.second, key, storage);
+  }
+
+  void RemoveKey(const std::string &key)
+  {
+    if (Keys.erase(key) == 0)
+      return;
+
+    for (auto &nodeEntry : Nodes)
+    {
+      auto propertyIter = nodeEntry.second.Properties.find(key);
+      if (propertyIter != nodeEntry.second.Properties.end())
+      {
+        this->RemoveProperty(nodeEntry.first, key, propertyIter->second);
+        nodeEntry.second.Properties.erase(propertyIter);
+      }
+    }
+    NodesByProperty.erase(key);
+  }
+
+  void Clear()
+  {
+    while (!Nodes.empty())
+      this->RemoveNode(Nodes.begin()->first);
+  }
+
+  bool GetCandidates(const mitk::NodePredicateBase *condition, NodeSet &candidates) const
+  {
+    if (auto dataTypePredicate = dynamic_cast<const mitk::NodePredicateDataType *>(condition))
+    {
+      auto typeIter = NodesByDataType.find(dataTypePredicate->GetValidDataType());
+      candidates = typeIter != NodesByDataType.cend() ? typeIter->second : NodeSet();
+      return true;
+    }
+
+    if (auto propertyPredicate = dynamic_cast<const mitk::NodePredicateProperty *>(condition))
+    {
+      const std::string &key = propertyPredicate->GetValidPropertyName();
+      if (propertyPredicate->GetRenderer() != nullptr || key.empty() || Keys.count(key) == 0)
+        return false;
+
+      candidates.clear();
+      auto keyIter = NodesByProperty.find(key);
+      if (keyIter != NodesByProperty.cend())
+      {
+        auto stringProperty = dynamic_cast<const mitk::StringProperty *>(propertyPredicate->GetValidProperty());
+        if (stringProperty != nullptr)
+        {
+          auto valueIter = keyIter->second.NodesByStringValue.find(stringProperty->GetValue());
+          if (valueIter != keyIter->second.NodesByStringValue.cend())
+            candidates = valueIter->second;
+        }
+        else
+        {
+          candidates = keyIter->second.Nodes;
+        }
+
+        candidates.insert(keyIter->second.NodesWithoutProperty.cbegin(), keyIter->second.NodesWithoutProperty.cend());
+      }
+      return true;
+    }
+
+    if (auto andPredicate = dynamic_cast<const mitk::NodePredicateAnd *>(condition))
+    {
+      // all children have to be fulfilled, so the smallest candidate set of any child is sufficient
+      bool found = false;
+      for (const auto &child : andPredicate->GetPredicates())
+      {
+        NodeSet childCandidates;
+        if (this->GetCandidates(child, childCandidates) && (!found || childCandidates.size() < candidates.size()))
+        {
+          candidates.swap(childCandidates);
+          found = true;
+        }
+      }
+      return found;
+    }
+
+    return false;
+  }
+};
+
+mitk::DataStorage::DataStorage() : itk::Object(), m_BlockNodeModifiedEvents(false), m_NodeIndex(new NodeIndex)
+{
+  m_NodeIndex->Keys.insert("name");
 }
 
 mitk::DataStorage::~DataStorage()
 {
+  m_NodeIndex->Clear();
+
   ///// we can not call GetAll() in destructor, because it is implemented in a subclass
   // SetOfObjects::ConstPointer all = this->GetAll();
   // for (SetOfObjects::ConstIterator it = all->Begin(); it != all->End(); ++it)
@@ -57,10 +308,74 @@ void mitk::DataStorage::Remove(const mitk::DataStorage::SetOfObjects *nodes)
 
 mitk::DataStorage::SetOfObjects::ConstPointer mitk::DataStorage::GetSubset(const NodePredicateBase *condition) const
 {
+  std::set<const mitk::DataNode *> candidates;
+  if (condition != nullptr && this->GetIndexedCandidates(condition, candidates))
+  {
+    // candidates are ordered by address like the nodes of StandaloneDataStorage::GetAll()
+    mitk::DataStorage::SetOfObjects::Pointer candidateSet = mitk::DataStorage::SetOfObjects::New();
+    for (auto candidate : candidates)
+      candidateSet->InsertElement(candidateSet->Size(), const_cast<mitk::DataNode *>(candidate));
+
+    return this->FilterSetOfObjects(candidateSet, condition);
+  }
+
   mitk::DataStorage::SetOfObjects::ConstPointer result = this->FilterSetOfObjects(this->GetAll(), condition);
   return result;
 }
 
+void mitk::DataStorage::AddIndexedPropertyKey(const std::string &propertyKey)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+  m_NodeIndex->AddKey(propertyKey, this);
+}
+
+void mitk::DataStorage::RemoveIndexedPropertyKey(const std::string &propertyKey)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+  m_NodeIndex->RemoveKey(propertyKey);
+}
+
+std::set<std::string> mitk::DataStorage::GetIndexedPropertyKeys() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+  return m_NodeIndex->Keys;
+}
+
+bool mitk::DataStorage::GetIndexedCandidates(const NodePredicateBase *condition,
+                                             std::set<const mitk::DataNode *> &candidates) const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+  return m_NodeIndex->GetCandidates(condition, candidates);
+}
+
+void mitk::DataStorage::IndexNode(const mitk::DataNode *node)
+{
+  if (node == nullptr)
+    return;
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+  m_NodeIndex->UpdateNode(node, this);
+}
+
+void mitk::DataStorage::UnindexNode(const mitk::DataNode *node)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+  m_NodeIndex->RemoveNode(node);
+}
+
+void mitk::DataStorage::OnIndexedPropertyModified(const itk::Object *caller, const itk::EventObject &)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_NodeIndexMutex);
+
+  std::vector<const mitk::DataNode *> nodes;
+  auto observedRange = m_NodeIndex->NodesByObservedProperty.equal_range(caller);
+  for (auto observedIter = observedRange.first; observedIter != observedRange.second; ++observedIter)
+    nodes.push_back(observedIter->second);
+
+  for (auto node : nodes)
+    m_NodeIndex->UpdateNode(node, this);
+}
+
 mitk::DataNode *mitk::DataStorage::GetNamedNode(const char *name) const
 
 {
@@ -197,6 +512,10 @@ void mitk::DataStorage::OnNodeInteractorChanged(itk::Object *caller, const itk::
 
 void mitk::DataStorage::OnNodeModifiedOrDeleted(const itk::Object *caller, const itk::EventObject &event)
 {
+  // the indices have to be up to date even if the events are blocked
+  if (dynamic_cast<const itk::ModifiedEvent *>(&event) != nullptr)
+    this->IndexNode(dynamic_cast<const mitk::DataNode *>(caller));
+
   if (m_BlockNodeModifiedEvents)
     return;
 
@@ -234,6 +553,8 @@ void mitk::DataStorage::AddListeners(const mitk::DataNode *_Node)
     // add observer
     m_NodeDeleteObserverTags[NonConstNode] = NonConstNode->AddObserver(itk::DeleteEvent(), deleteCommand);
   }
+
+  this->IndexNode(_Node);
 }
 
 void mitk::DataStorage::RemoveListeners(const mitk::DataNode *_Node)
@@ -253,6 +574,8 @@ void mitk::DataStorage::RemoveListeners(const mitk::DataNode *_Node)
     m_NodeDeleteObserverTags.erase(NonConstNode);
     m_NodeInteractorChangedObserverTags.erase(NonConstNode);
   }
+
+  this->UnindexNode(_Node);
 }
 
 mitk::TimeGeometry::Pointer mitk::DataStorage::ComputeBoundingGeometry3D(const SetOfObjects *input,
@@ -45,7 +45,8 @@ mitk::Image::Image()
     m_ImageDescriptor(nullptr),
     m_OffsetTable(nullptr),
     m_CompleteData(nullptr),
-    m_ImageStatistics(nullptr)
+    m_ImageStatistics(nullptr),
+    m_WriteAccessCount(0)
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY(m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -60,7 +61,8 @@ mitk::Image::Image(const Image &other)
     m_ImageDescriptor(nullptr),
     m_OffsetTable(nullptr),
     m_CompleteData(nullptr),
-    m_ImageStatistics(nullptr)
+    m_ImageStatistics(nullptr),
+    m_WriteAccessCount(0)
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY(m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -231,6 +233,14 @@ vtkImageData *mitk::Image::GetVtkImageData(int t, int n)
   return volume.GetPointer() == nullptr ? nullptr : volume->GetVtkImageAccessor(this)->GetVtkImageData();
 }
 
+unsigned long mitk::Image::GetWriteAccessCount() const
+{
+  m_ReadWriteLock.Lock();
+  const unsigned long writeAccessCount = m_WriteAccessCount;
+  m_ReadWriteLock.Unlock();
+  return writeAccessCount;
+}
+
 const vtkImageData *mitk::Image::GetVtkImageData(int t, int n) const
 {
   if (m_Initialized == false)
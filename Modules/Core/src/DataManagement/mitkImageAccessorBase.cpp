@@ -16,6 +16,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkImageAccessorBase.h"
 #include "mitkImage.h"
+#include "mitkImageDataItemPager.h"
 
 mitk::ImageAccessorBase::ThreadIDType mitk::ImageAccessorBase::CurrentThreadHandle()
 {
@@ -112,6 +113,13 @@ mitk::ImageAccessorBase::ImageAccessorBase(ImageConstPointer image,
     m_AddressEnd = (unsigned char *)m_AddressBegin + imageDataItem->m_Size;
   }
 
+  // Let a paged image fault in the accessed memory area and update its residency
+  if (m_CoherentMemory && imageDataItem->IsPagedMemory())
+  {
+    ImageDataItemPager::GetInstance()->Touch(static_cast<const unsigned char *>(m_AddressBegin),
+                                             imageDataItem->m_Size);
+  }
+
   // Case 3: No ImageDataItem but a SubRegion
   if (imageDataItem == nullptr && m_SubRegion)
   {
@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkImageDataItem.h"
+#include "mitkImageDataItemPager.h"
 #include "mitkMemoryUtilities.h"
 #include <vtkImageData.h>
 #include <vtkPointData.h>
@@ -51,6 +52,7 @@ mitk::ImageDataItem::ImageDataItem(const ImageDataItem &aParent,
     m_Offset(offset),
     m_IsComplete(false),
     m_Size(0),
+    m_PagedMemory(false),
     m_Parent(&aParent),
     m_Dimension(dimension),
     m_Timestep(timestep)
@@ -94,7 +96,12 @@ mitk::ImageDataItem::~ImageDataItem()
   if (m_Parent.IsNull())
   {
     if (m_ManageMemory)
-      delete[] m_Data;
+    {
+      if (m_PagedMemory)
+        ImageDataItemPager::GetInstance()->Release(m_Data);
+      else
+        delete[] m_Data;
+    }
   }
   delete m_PixelType;
 }
@@ -112,6 +119,7 @@ mitk::ImageDataItem::ImageDataItem(const mitk::ImageDescriptor::Pointer desc,
     m_Offset(0),
     m_IsComplete(false),
     m_Size(0),
+    m_PagedMemory(false),
     m_Dimension(desc->GetNumberOfDimensions()),
     m_Timestep(timestep)
 {
@@ -126,8 +134,7 @@ mitk::ImageDataItem::ImageDataItem(const mitk::ImageDescriptor::Pointer desc,
 
   if (m_Data == nullptr)
   {
-    m_Data = mitk::MemoryUtilities::AllocateElements<unsigned char>(m_Size);
-    m_ManageMemory = true;
+    this->AllocateData();
   }
 
   m_ReferenceCount = 0;
@@ -148,6 +155,7 @@ mitk::ImageDataItem::ImageDataItem(const mitk::PixelType &type,
     m_Offset(0),
     m_IsComplete(false),
     m_Size(0),
+    m_PagedMemory(false),
     m_Parent(nullptr),
     m_Dimension(dimension),
     m_Timestep(timestep)
@@ -161,8 +169,7 @@ mitk::ImageDataItem::ImageDataItem(const mitk::PixelType &type,
 
   if (m_Data == nullptr)
   {
-    m_Data = mitk::MemoryUtilities::AllocateElements<unsigned char>(m_Size);
-    m_ManageMemory = true;
+    this->AllocateData();
   }
 
   m_ReferenceCount = 0;
@@ -179,6 +186,7 @@ mitk::ImageDataItem::ImageDataItem(const ImageDataItem &other)
     m_Offset(other.m_Offset),
     m_IsComplete(other.m_IsComplete),
     m_Size(other.m_Size),
+    m_PagedMemory(other.m_PagedMemory),
     m_Parent(other.m_Parent),
     m_Dimension(other.m_Dimension),
     m_Timestep(other.m_Timestep)
@@ -204,6 +212,20 @@ void mitk::ImageDataItem::ComputeItemSize(const unsigned int *dimensions, unsign
   }
 }
 
+void mitk::ImageDataItem::AllocateData()
+{
+  // large buffers are preferably backed by a swap file if paging is enabled
+  m_Data = ImageDataItemPager::GetInstance()->Allocate(m_Size);
+  m_PagedMemory = (m_Data != nullptr);
+
+  if (m_Data == nullptr)
+  {
+    m_Data = mitk::MemoryUtilities::AllocateElements<unsigned char>(m_Size);
+  }
+
+  m_ManageMemory = true;
+}
+
 void mitk::ImageDataItem::ConstructVtkImageData(ImageConstPointer iP) const
 {
   vtkImageData *inData = vtkImageData::New();
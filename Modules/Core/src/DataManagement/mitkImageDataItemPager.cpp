@@ -0,0 +1,420 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImageDataItemPager.h"
+
+#include "mitkIOUtil.h"
+#include "mitkLogMacros.h"
+#include "mitkMemoryUtilities.h"
+
+#include <itkMutexLockHolder.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  typedef itk::MutexLockHolder<itk::SimpleFastMutexLock> MutexHolder;
+
+  size_t GetPageSize()
+  {
+#ifndef _WIN32
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+#else
+    return 4096;
+#endif
+  }
+}
+
+mitk::ImageDataItemPager *mitk::ImageDataItemPager::GetInstance()
+{
+  static ImageDataItemPager instance;
+  return &instance;
+}
+
+mitk::ImageDataItemPager::ImageDataItemPager()
+  : m_Enabled(false),
+    m_MemoryBudget(MemoryUtilities::GetTotalSizeOfPhysicalRam() / 2),
+    m_MinimumPagedSize(64 * 1024 * 1024),
+    m_ResidentSize(0)
+{
+}
+
+mitk::ImageDataItemPager::~ImageDataItemPager()
+{
+#ifndef _WIN32
+  for (auto &mapping : m_Mappings)
+  {
+    munmap(const_cast<unsigned char *>(mapping.first), mapping.second.Size);
+    close(mapping.second.FileDescriptor);
+  }
+#endif
+}
+
+void mitk::ImageDataItemPager::SetEnabled(bool enabled)
+{
+  MutexHolder lock(m_Mutex);
+  m_Enabled = enabled;
+}
+
+bool mitk::ImageDataItemPager::GetEnabled() const
+{
+  MutexHolder lock(m_Mutex);
+  return m_Enabled;
+}
+
+void mitk::ImageDataItemPager::SetMemoryBudget(size_t bytes)
+{
+  EvictionListType evictions;
+  {
+    MutexHolder lock(m_Mutex);
+    m_MemoryBudget = bytes;
+    this->EvictLeastRecentlyUsedRegions(evictions);
+  }
+  this->EvictPages(evictions);
+}
+
+size_t mitk::ImageDataItemPager::GetMemoryBudget() const
+{
+  MutexHolder lock(m_Mutex);
+  return m_MemoryBudget;
+}
+
+void mitk::ImageDataItemPager::SetMinimumPagedSize(size_t bytes)
+{
+  MutexHolder lock(m_Mutex);
+  m_MinimumPagedSize = bytes;
+}
+
+size_t mitk::ImageDataItemPager::GetMinimumPagedSize() const
+{
+  MutexHolder lock(m_Mutex);
+  return m_MinimumPagedSize;
+}
+
+void mitk::ImageDataItemPager::SetSwapDirectory(const std::string &directory)
+{
+  MutexHolder lock(m_Mutex);
+  m_SwapDirectory = directory;
+}
+
+std::string mitk::ImageDataItemPager::GetSwapDirectory() const
+{
+  MutexHolder lock(m_Mutex);
+  return m_SwapDirectory.empty() ? IOUtil::GetTempPath() : m_SwapDirectory;
+}
+
+unsigned char *mitk::ImageDataItemPager::Allocate(size_t size)
+{
+#ifndef _WIN32
+  std::string directory;
+  {
+    MutexHolder lock(m_Mutex);
+    if (!m_Enabled || size == 0 || size < m_MinimumPagedSize)
+      return nullptr;
+    directory = m_SwapDirectory;
+  }
+
+  if (directory.empty())
+    directory = IOUtil::GetTempPath();
+
+  std::string path = directory + "/mitk-image-swap-XXXXXX";
+  std::vector<char> pathBuffer(path.begin(), path.end());
+  pathBuffer.push_back('\0');
+
+  int fd = mkstemp(pathBuffer.data());
+  if (fd < 0)
+  {
+    MITK_WARN << "Could not create image swap file in " << directory << ". Falling back to heap memory.";
+    return nullptr;
+  }
+
+  // The file only has to live as long as its descriptor is open
+  unlink(pathBuffer.data());
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+  {
+    MITK_WARN << "Could not resize image swap file to " << size << " bytes. Falling back to heap memory.";
+    close(fd);
+    return nullptr;
+  }
+
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+  {
+    MITK_WARN << "Could not map image swap file of " << size << " bytes. Falling back to heap memory.";
+    close(fd);
+    return nullptr;
+  }
+
+  MutexHolder lock(m_Mutex);
+  Mapping mapping = {fd, size, 0, false};
+  m_Mappings[static_cast<const unsigned char *>(data)] = mapping;
+  return static_cast<unsigned char *>(data);
+#else
+  (void)size;
+  return nullptr;
+#endif
+}
+
+void mitk::ImageDataItemPager::Release(unsigned char *data)
+{
+  if (data == nullptr)
+    return;
+
+  MutexHolder lock(m_Mutex);
+
+  auto mappingIter = m_Mappings.find(data);
+  if (mappingIter == m_Mappings.end() || mappingIter->second.Released)
+  {
+    MITK_ERROR << "Attempt to release an image buffer that was not allocated by the ImageDataItemPager.";
+    return;
+  }
+
+  this->ForgetRegions(data, mappingIter->second.Size);
+
+  // Pages of this buffer are still written back by another thread, which unmaps it when done
+  if (mappingIter->second.PendingEvictions > 0)
+  {
+    mappingIter->second.Released = true;
+    return;
+  }
+
+  this->Unmap(mappingIter);
+}
+
+bool mitk::ImageDataItemPager::IsPaged(const unsigned char *data) const
+{
+  MutexHolder lock(m_Mutex);
+  return this->FindMapping(data) != m_Mappings.end();
+}
+
+void mitk::ImageDataItemPager::Touch(const unsigned char *begin, size_t size)
+{
+  if (begin == nullptr || size == 0)
+    return;
+
+  EvictionListType evictions;
+  {
+    MutexHolder lock(m_Mutex);
+
+    if (m_Mappings.empty())
+      return;
+
+    auto mappingIter = this->FindMapping(begin);
+    if (mappingIter == m_Mappings.end())
+      return;
+
+    size = std::min(size, static_cast<size_t>(mappingIter->first + mappingIter->second.Size - begin));
+
+    auto regionIter = m_Regions.find(begin);
+    if (regionIter != m_Regions.end() && regionIter->second->second == size)
+    {
+      m_LeastRecentlyUsed.splice(m_LeastRecentlyUsed.begin(), m_LeastRecentlyUsed, regionIter->second);
+      return;
+    }
+
+    // Parts of the region that are already resident must not be counted twice
+    this->ForgetRegions(begin, size);
+    this->AddRegion(RegionType(begin, size), m_LeastRecentlyUsed.begin());
+
+#ifndef _WIN32
+    // Ask the kernel to read ahead the region that is about to be accessed
+    const size_t pageSize = GetPageSize();
+    const size_t offset = static_cast<size_t>(begin - mappingIter->first);
+    const size_t alignedOffset = offset - offset % pageSize;
+    madvise(const_cast<unsigned char *>(mappingIter->first) + alignedOffset, size + offset - alignedOffset, MADV_WILLNEED);
+#endif
+
+    this->EvictLeastRecentlyUsedRegions(evictions);
+  }
+  this->EvictPages(evictions);
+}
+
+void mitk::ImageDataItemPager::Evict(const unsigned char *begin, size_t size)
+{
+  EvictionListType evictions;
+  {
+    MutexHolder lock(m_Mutex);
+
+    auto mappingIter = this->FindMapping(begin);
+    if (mappingIter == m_Mappings.end())
+      return;
+
+    this->ForgetRegions(begin, size);
+    this->PrepareEviction(RegionType(begin, size), mappingIter, evictions);
+  }
+  this->EvictPages(evictions);
+}
+
+size_t mitk::ImageDataItemPager::GetResidentSize() const
+{
+  MutexHolder lock(m_Mutex);
+  return m_ResidentSize;
+}
+
+mitk::ImageDataItemPager::MappingMapType::iterator mitk::ImageDataItemPager::FindMapping(const unsigned char *data)
+{
+  auto mappingIter = m_Mappings.upper_bound(data);
+
+  if (mappingIter == m_Mappings.begin())
+    return m_Mappings.end();
+
+  --mappingIter;
+
+  if (data >= mappingIter->first + mappingIter->second.Size || mappingIter->second.Released)
+    return m_Mappings.end();
+
+  return mappingIter;
+}
+
+mitk::ImageDataItemPager::MappingMapType::const_iterator mitk::ImageDataItemPager::FindMapping(
+  const unsigned char *data) const
+{
+  return const_cast<ImageDataItemPager *>(this)->FindMapping(data);
+}
+
+void mitk::ImageDataItemPager::PrepareEviction(const RegionType &region,
+                                               MappingMapType::iterator mappingIter,
+                                               EvictionListType &evictions)
+{
+#ifndef _WIN32
+  Mapping &mapping = mappingIter->second;
+
+  // Only whole pages can be released, partially covered pages at the borders stay resident
+  const size_t pageSize = GetPageSize();
+  const size_t offset = static_cast<size_t>(region.first - mappingIter->first);
+  const size_t end = std::min(offset + region.second, mapping.Size);
+  const size_t alignedBegin = (offset + pageSize - 1) / pageSize * pageSize;
+  const size_t alignedEnd = end / pageSize * pageSize;
+
+  if (alignedEnd <= alignedBegin)
+    return;
+
+  Eviction eviction = {mappingIter->first, mapping.FileDescriptor, alignedBegin, alignedEnd - alignedBegin};
+  evictions.push_back(eviction);
+  ++mapping.PendingEvictions;
+#else
+  (void)region;
+  (void)mappingIter;
+  (void)evictions;
+#endif
+}
+
+void mitk::ImageDataItemPager::EvictPages(const EvictionListType &evictions)
+{
+  if (evictions.empty())
+    return;
+
+#ifndef _WIN32
+  // The buffers cannot be unmapped meanwhile, Release() defers this until no eviction is pending
+  for (const auto &eviction : evictions)
+  {
+    auto pageBegin = const_cast<unsigned char *>(eviction.MappingBegin) + eviction.Offset;
+
+    msync(pageBegin, eviction.Length, MS_SYNC);
+    madvise(pageBegin, eviction.Length, MADV_DONTNEED);
+    posix_fadvise(eviction.FileDescriptor,
+                  static_cast<off_t>(eviction.Offset),
+                  static_cast<off_t>(eviction.Length),
+                  POSIX_FADV_DONTNEED);
+  }
+#endif
+
+  MutexHolder lock(m_Mutex);
+
+  for (const auto &eviction : evictions)
+  {
+    auto mappingIter = m_Mappings.find(eviction.MappingBegin);
+    if (mappingIter == m_Mappings.end())
+      continue;
+
+    if (--mappingIter->second.PendingEvictions == 0 && mappingIter->second.Released)
+      this->Unmap(mappingIter);
+  }
+}
+
+void mitk::ImageDataItemPager::Unmap(MappingMapType::iterator mappingIter)
+{
+#ifndef _WIN32
+  munmap(const_cast<unsigned char *>(mappingIter->first), mappingIter->second.Size);
+  close(mappingIter->second.FileDescriptor);
+#endif
+
+  m_Mappings.erase(mappingIter);
+}
+
+void mitk::ImageDataItemPager::EvictLeastRecentlyUsedRegions(EvictionListType &evictions)
+{
+  // The most recently used region is never evicted, even if it exceeds the budget on its own
+  while (m_ResidentSize > m_MemoryBudget && m_LeastRecentlyUsed.size() > 1)
+  {
+    RegionType region = m_LeastRecentlyUsed.back();
+    m_LeastRecentlyUsed.pop_back();
+    m_Regions.erase(region.first);
+    m_ResidentSize -= region.second;
+
+    auto mappingIter = this->FindMapping(region.first);
+    if (mappingIter != m_Mappings.end())
+      this->PrepareEviction(region, mappingIter, evictions);
+  }
+}
+
+void mitk::ImageDataItemPager::ForgetRegions(const unsigned char *begin, size_t size)
+{
+  const unsigned char *end = begin + size;
+
+  // Start at the region that contains begin, if there is one
+  auto regionIter = m_Regions.upper_bound(begin);
+  if (regionIter != m_Regions.begin())
+  {
+    auto previousIter = std::prev(regionIter);
+    if (previousIter->first + previousIter->second->second > begin)
+      regionIter = previousIter;
+  }
+
+  while (regionIter != m_Regions.end() && regionIter->first < end)
+  {
+    const RegionType region = *regionIter->second;
+    const unsigned char *regionEnd = region.first + region.second;
+    auto position = regionIter->second;
+
+    regionIter = m_Regions.erase(regionIter);
+    m_ResidentSize -= region.second;
+
+    // Parts outside of [begin, end) stay resident and keep their position in the list
+    if (region.first < begin)
+      this->AddRegion(RegionType(region.first, static_cast<size_t>(begin - region.first)), position);
+    if (regionEnd > end)
+      this->AddRegion(RegionType(end, static_cast<size_t>(regionEnd - end)), position);
+
+    m_LeastRecentlyUsed.erase(position);
+  }
+}
+
+void mitk::ImageDataItemPager::AddRegion(const RegionType &region, RegionListType::iterator position)
+{
+  m_Regions[region.first] = m_LeastRecentlyUsed.insert(position, region);
+  m_ResidentSize += region.second;
+}
@@ -0,0 +1,286 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImagePixelSampler.h"
+
+#include "mitkExceptionMacro.h"
+#include "mitkImage.h"
+#include "mitkImageReadAccessor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  /** Number of world coordinates that are converted to indices at once, bounds the size of the stack buffer. */
+  const std::size_t WorldCoordinateBlockSize = 256;
+
+  /** Rounds like BaseGeometry::WorldToIndex() and checks the result against [0, maxIndex]. */
+  inline bool RoundToIndex(mitk::ScalarType continuousIndex, mitk::ScalarType maxIndex, std::size_t &index)
+  {
+    const mitk::ScalarType rounded = std::floor(continuousIndex + 0.5);
+    // also rejects NaN
+    if (!(rounded >= 0.0 && rounded <= maxIndex))
+      return false;
+
+    index = static_cast<std::size_t>(rounded);
+    return true;
+  }
+}
+
+template <typename TPixel>
+void mitk::ImagePixelSampler::SampleTemplate(const ImagePixelSampler &sampler,
+                                             const Point3D *indices,
+                                             std::size_t numberOfPositions,
+                                             ScalarType *values)
+{
+  const TPixel *data = static_cast<const TPixel *>(sampler.m_Data) + sampler.m_Component;
+
+  const std::size_t strideX = sampler.m_NumberOfComponents;
+  const std::size_t strideY = strideX * sampler.m_Dimensions[0];
+  const std::size_t strideZ = strideY * sampler.m_Dimensions[1];
+
+  const ScalarType maxIndex[3] = {static_cast<ScalarType>(sampler.m_Dimensions[0] - 1),
+                                  static_cast<ScalarType>(sampler.m_Dimensions[1] - 1),
+                                  static_cast<ScalarType>(sampler.m_Dimensions[2] - 1)};
+
+  const ScalarType outsideValue = sampler.m_OutsideValue;
+
+  if (sampler.m_InterpolationMode == NearestNeighbor)
+  {
+    for (std::size_t i = 0; i < numberOfPositions; ++i)
+    {
+      std::size_t x, y, z;
+      if (RoundToIndex(indices[i][0], maxIndex[0], x) && RoundToIndex(indices[i][1], maxIndex[1], y) &&
+          RoundToIndex(indices[i][2], maxIndex[2], z))
+      {
+        values[i] = static_cast<ScalarType>(data[x * strideX + y * strideY + z * strideZ]);
+      }
+      else
+      {
+        values[i] = outsideValue;
+      }
+    }
+    return;
+  }
+
+  for (std::size_t i = 0; i < numberOfPositions; ++i)
+  {
+    std::size_t lower[3];
+    if (!RoundToIndex(indices[i][0], maxIndex[0], lower[0]) || !RoundToIndex(indices[i][1], maxIndex[1], lower[1]) ||
+        !RoundToIndex(indices[i][2], maxIndex[2], lower[2]))
+    {
+      values[i] = outsideValue;
+      continue;
+    }
+
+    // the neighborhood is clamped to the image, so positions in the outer half of the border pixels
+    // get the value of the border pixel
+    ScalarType weight[3];
+    std::size_t upperOffset[3];
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      const ScalarType position = std::min(std::max(indices[i][d], ScalarType(0.0)), maxIndex[d]);
+      const ScalarType floored = std::floor(position);
+      lower[d] = static_cast<std::size_t>(floored);
+      weight[d] = position - floored;
+      upperOffset[d] = (weight[d] > 0.0) ? 1 : 0;
+    }
+
+    const TPixel *p000 = data + lower[0] * strideX + lower[1] * strideY + lower[2] * strideZ;
+    const std::size_t dx = upperOffset[0] * strideX;
+    const std::size_t dy = upperOffset[1] * strideY;
+    const std::size_t dz = upperOffset[2] * strideZ;
+
+    const ScalarType v00 = p000[0] + weight[0] * (static_cast<ScalarType>(p000[dx]) - p000[0]);
+    const ScalarType v10 = p000[dy] + weight[0] * (static_cast<ScalarType>(p000[dy + dx]) - p000[dy]);
+    const ScalarType v01 = p000[dz] + weight[0] * (static_cast<ScalarType>(p000[dz + dx]) - p000[dz]);
+    const ScalarType v11 =
+      p000[dz + dy] + weight[0] * (static_cast<ScalarType>(p000[dz + dy + dx]) - p000[dz + dy]);
+
+    const ScalarType v0 = v00 + weight[1] * (v10 - v00);
+    const ScalarType v1 = v01 + weight[1] * (v11 - v01);
+
+    values[i] = v0 + weight[2] * (v1 - v0);
+  }
+}
+
+mitk::ImagePixelSampler::ImagePixelSampler(const Image *image, unsigned int timeStep, unsigned int component)
+  : m_Data(nullptr),
+    m_SampleFunction(nullptr),
+    m_NumberOfComponents(1),
+    m_Component(component),
+    m_InterpolationMode(NearestNeighbor),
+    m_OutsideValue(0.0)
+{
+  if (image == nullptr || !image->IsInitialized())
+  {
+    mitkThrow() << "ImagePixelSampler requires an initialized image.";
+  }
+
+  if (timeStep >= image->GetTimeSteps())
+  {
+    mitkThrow() << "ImagePixelSampler: time step " << timeStep << " does not exist, image has "
+                << image->GetTimeSteps() << " time steps.";
+  }
+
+  const PixelType pixelType = image->GetPixelType();
+  m_NumberOfComponents = pixelType.GetNumberOfComponents();
+  if (component >= m_NumberOfComponents)
+  {
+    mitkThrow() << "ImagePixelSampler: component " << component << " does not exist, pixel type has "
+                << m_NumberOfComponents << " components.";
+  }
+
+  switch (pixelType.GetComponentType())
+  {
+    case itk::ImageIOBase::CHAR:
+      m_SampleFunction = &SampleTemplate<char>;
+      break;
+    case itk::ImageIOBase::UCHAR:
+      m_SampleFunction = &SampleTemplate<unsigned char>;
+      break;
+    case itk::ImageIOBase::SHORT:
+      m_SampleFunction = &SampleTemplate<short>;
+      break;
+    case itk::ImageIOBase::USHORT:
+      m_SampleFunction = &SampleTemplate<unsigned short>;
+      break;
+    case itk::ImageIOBase::INT:
+      m_SampleFunction = &SampleTemplate<int>;
+      break;
+    case itk::ImageIOBase::UINT:
+      m_SampleFunction = &SampleTemplate<unsigned int>;
+      break;
+    case itk::ImageIOBase::LONG:
+      m_SampleFunction = &SampleTemplate<long int>;
+      break;
+    case itk::ImageIOBase::ULONG:
+      m_SampleFunction = &SampleTemplate<unsigned long int>;
+      break;
+    case itk::ImageIOBase::FLOAT:
+      m_SampleFunction = &SampleTemplate<float>;
+      break;
+    case itk::ImageIOBase::DOUBLE:
+      m_SampleFunction = &SampleTemplate<double>;
+      break;
+    default:
+      mitkThrow() << "ImagePixelSampler: pixel component type " << pixelType.GetComponentTypeAsString()
+                  << " is not supported.";
+  }
+
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    m_Dimensions[i] = (i < image->GetDimension()) ? std::max(1u, image->GetDimension(i)) : 1;
+  }
+
+  BaseGeometry *geometry = image->GetTimeGeometry()->GetGeometryForTimeStep(timeStep);
+  AffineTransform3D::Pointer worldToIndex = AffineTransform3D::New();
+  if (!geometry->GetIndexToWorldTransform()->GetInverse(worldToIndex.GetPointer()))
+  {
+    mitkThrow() << "ImagePixelSampler: index to world transform of the image is not invertible.";
+  }
+  m_WorldToIndexMatrix = worldToIndex->GetMatrix();
+  m_WorldToIndexOffset = worldToIndex->GetOffset();
+
+  m_Accessor.reset(new ImageReadAccessor(image, image->GetVolumeData(timeStep).GetPointer()));
+  m_Data = m_Accessor->GetData();
+}
+
+mitk::ImagePixelSampler::~ImagePixelSampler()
+{
+}
+
+void mitk::ImagePixelSampler::SetInterpolationMode(InterpolationMode mode)
+{
+  m_InterpolationMode = mode;
+}
+
+mitk::ImagePixelSampler::InterpolationMode mitk::ImagePixelSampler::GetInterpolationMode() const
+{
+  return m_InterpolationMode;
+}
+
+void mitk::ImagePixelSampler::SetOutsideValue(ScalarType value)
+{
+  m_OutsideValue = value;
+}
+
+mitk::ScalarType mitk::ImagePixelSampler::GetOutsideValue() const
+{
+  return m_OutsideValue;
+}
+
+void mitk::ImagePixelSampler::SampleByIndex(const Point3D *indices,
+                                            std::size_t numberOfPositions,
+                                            ScalarType *values) const
+{
+  m_SampleFunction(*this, indices, numberOfPositions, values);
+}
+
+void mitk::ImagePixelSampler::SampleByWorldCoordinate(const Point3D *points,
+                                                      std::size_t numberOfPositions,
+                                                      ScalarType *values) const
+{
+  Point3D indices[WorldCoordinateBlockSize];
+
+  for (std::size_t blockStart = 0; blockStart < numberOfPositions; blockStart += WorldCoordinateBlockSize)
+  {
+    const std::size_t blockSize = std::min(WorldCoordinateBlockSize, numberOfPositions - blockStart);
+
+    for (std::size_t i = 0; i < blockSize; ++i)
+    {
+      const Point3D &point = points[blockStart + i];
+      for (unsigned int row = 0; row < 3; ++row)
+      {
+        indices[i][row] = m_WorldToIndexMatrix[row][0] * point[0] + m_WorldToIndexMatrix[row][1] * point[1] +
+                          m_WorldToIndexMatrix[row][2] * point[2] + m_WorldToIndexOffset[row];
+      }
+    }
+
+    m_SampleFunction(*this, indices, blockSize, values + blockStart);
+  }
+}
+
+std::vector<mitk::ScalarType> mitk::ImagePixelSampler::SampleByIndex(const std::vector<Point3D> &indices) const
+{
+  std::vector<ScalarType> values(indices.size());
+  if (!indices.empty())
+    this->SampleByIndex(indices.data(), indices.size(), values.data());
+  return values;
+}
+
+std::vector<mitk::ScalarType> mitk::ImagePixelSampler::SampleByWorldCoordinate(const std::vector<Point3D> &points) const
+{
+  std::vector<ScalarType> values(points.size());
+  if (!points.empty())
+    this->SampleByWorldCoordinate(points.data(), points.size(), values.data());
+  return values;
+}
+
+mitk::ScalarType mitk::ImagePixelSampler::SampleByIndex(const Point3D &index) const
+{
+  ScalarType value;
+  this->SampleByIndex(&index, 1, &value);
+  return value;
+}
+
+mitk::ScalarType mitk::ImagePixelSampler::SampleByWorldCoordinate(const Point3D &point) const
+{
+  ScalarType value;
+  this->SampleByWorldCoordinate(&point, 1, &value);
+  return value;
+}
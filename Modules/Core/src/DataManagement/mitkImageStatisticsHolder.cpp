@@ -15,52 +15,339 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 #include "mitkImageStatisticsHolder.h"
 
-#include "mitkHistogramGenerator.h"
-//#include "mitkImageTimeSelector.h"
+#include "mitkExceptionMacro.h"
+#include "mitkImageReadAccessor.h"
 #include <mitkProperties.h>
 
-mitk::ImageStatisticsHolder::ImageStatisticsHolder(mitk::Image *image)
-  : m_Image(image) /*, m_TimeSelectorForExtremaObject(nullptr)*/
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <type_traits>
+
+namespace
 {
-  m_CountOfMinValuedVoxels.resize(1, 0);
-  m_CountOfMaxValuedVoxels.resize(1, 0);
-  m_ScalarMin.resize(1, itk::NumericTraits<ScalarType>::max());
-  m_ScalarMax.resize(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
-  m_Scalar2ndMin.resize(1, itk::NumericTraits<ScalarType>::max());
-  m_Scalar2ndMax.resize(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
+  const unsigned int NumberOfHistogramBins = 256;
+
+  /** Number of samples processed as one unit of the parallel reduction */
+  const std::size_t ChunkSize = 65536;
+
+  /** Approximate number of samples the coarse statistics of background computations are based on */
+  const std::size_t NumberOfCoarseSamples = 65536;
+
+  /** Partial result of the reduction, 2nd min/max are the values next to min/max, not the second occurrences */
+  struct Extrema
+  {
+    Extrema()
+      : Min(itk::NumericTraits<mitk::ScalarType>::max()),
+        Max(itk::NumericTraits<mitk::ScalarType>::NonpositiveMin()),
+        SecondMin(itk::NumericTraits<mitk::ScalarType>::max()),
+        SecondMax(itk::NumericTraits<mitk::ScalarType>::NonpositiveMin()),
+        CountOfMin(0),
+        CountOfMax(0)
+    {
+    }
+
+    // NaN fails all comparisons and is ignored
+    void Add(mitk::ScalarType value)
+    {
+      if (value < Min)
+      {
+        SecondMin = Min;
+        Min = value;
+        CountOfMin = 1;
+      }
+      else if (value == Min)
+      {
+        ++CountOfMin;
+      }
+      else if (value < SecondMin)
+      {
+        SecondMin = value;
+      }
+
+      if (value > Max)
+      {
+        SecondMax = Max;
+        Max = value;
+        CountOfMax = 1;
+      }
+      else if (value == Max)
+      {
+        ++CountOfMax;
+      }
+      else if (value > SecondMax)
+      {
+        SecondMax = value;
+      }
+    }
+
+    void Merge(const Extrema &other)
+    {
+      if (other.Min < Min)
+      {
+        SecondMin = std::min(Min, other.SecondMin);
+        Min = other.Min;
+        CountOfMin = other.CountOfMin;
+      }
+      else if (other.Min == Min)
+      {
+        SecondMin = std::min(SecondMin, other.SecondMin);
+        CountOfMin += other.CountOfMin;
+      }
+      else
+      {
+        SecondMin = std::min(SecondMin, other.Min);
+      }
+
+      if (other.Max > Max)
+      {
+        SecondMax = std::max(Max, other.SecondMax);
+        Max = other.Max;
+        CountOfMax = other.CountOfMax;
+      }
+      else if (other.Max == Max)
+      {
+        SecondMax = std::max(SecondMax, other.SecondMax);
+        CountOfMax += other.CountOfMax;
+      }
+      else
+      {
+        SecondMax = std::max(SecondMax, other.Max);
+      }
+    }
+
+    mitk::ScalarType Min;
+    mitk::ScalarType Max;
+    mitk::ScalarType SecondMin;
+    mitk::ScalarType SecondMax;
+    std::size_t CountOfMin;
+    std::size_t CountOfMax;
+  };
+
+  /** Maps values of [min, max] to the histogram bins */
+  class HistogramBinning
+  {
+  public:
+    HistogramBinning(mitk::ScalarType min, mitk::ScalarType max)
+      : m_Min(min), m_Scale(max > min ? NumberOfHistogramBins / (max - min) : 0.0)
+    {
+    }
+
+    unsigned int GetBin(mitk::ScalarType value) const
+    {
+      return std::min(NumberOfHistogramBins - 1, static_cast<unsigned int>((value - m_Min) * m_Scale));
+    }
+
+  private:
+    mitk::ScalarType m_Min;
+    mitk::ScalarType m_Scale;
+  };
+
+  /** Samples of one component: every step-th element of the pixel buffer */
+  template <typename TPixel>
+  struct Samples
+  {
+    const TPixel *Data;
+    std::size_t Step;
+    std::size_t Size;
+
+    int GetNumberOfChunks() const { return static_cast<int>((Size + ChunkSize - 1) / ChunkSize); }
+    std::size_t GetChunkBegin(int chunk) const { return chunk * ChunkSize; }
+    std::size_t GetChunkEnd(int chunk) const { return std::min(Size, (chunk + 1) * ChunkSize); }
+    TPixel operator[](std::size_t i) const { return Data[i * Step]; }
+  };
+
+  template <typename TPixel>
+  struct UseCountTable
+    : std::integral_constant<bool, std::numeric_limits<TPixel>::is_integer && sizeof(TPixel) <= 2>
+  {
+  };
+
+  /**
+    Pixel types with up to 16 bit are reduced in a single pass to a table holding the count of every
+    possible value. Extrema and histogram are derived from this table.
+  */
+  template <typename TPixel>
+  void ComputeExtremaAndHistogram(const Samples<TPixel> &samples,
+                                  Extrema &extrema,
+                                  std::vector<std::size_t> &histogram,
+                                  std::true_type)
+  {
+    const int lowest = std::numeric_limits<TPixel>::min();
+    const std::size_t tableSize = std::size_t(1) << (8 * sizeof(TPixel));
+    const int numberOfChunks = samples.GetNumberOfChunks();
+
+    std::vector<std::size_t> counts(tableSize, 0);
 
-  mitk::HistogramGenerator::Pointer generator = mitk::HistogramGenerator::New();
-  m_HistogramGeneratorObject = generator;
+#pragma omp parallel if (numberOfChunks > 1)
+    {
+      std::vector<std::size_t> threadCounts(tableSize, 0);
+
+#pragma omp for schedule(dynamic)
+      for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+      {
+        const std::size_t end = samples.GetChunkEnd(chunk);
+        for (std::size_t i = samples.GetChunkBegin(chunk); i < end; ++i)
+          ++threadCounts[static_cast<int>(samples[i]) - lowest];
+      }
+
+#pragma omp critical
+      for (std::size_t value = 0; value < tableSize; ++value)
+        counts[value] += threadCounts[value];
+    }
+
+    std::vector<std::size_t> occurringValues;
+    for (std::size_t value = 0; value < tableSize; ++value)
+    {
+      if (counts[value] != 0)
+        occurringValues.push_back(value);
+    }
 
-  // m_Image = image;
+    if (occurringValues.empty())
+      return;
+
+    extrema.Min = static_cast<mitk::ScalarType>(static_cast<int>(occurringValues.front()) + lowest);
+    extrema.Max = static_cast<mitk::ScalarType>(static_cast<int>(occurringValues.back()) + lowest);
+    extrema.CountOfMin = counts[occurringValues.front()];
+    extrema.CountOfMax = counts[occurringValues.back()];
+    if (occurringValues.size() > 1)
+    {
+      extrema.SecondMin = static_cast<mitk::ScalarType>(static_cast<int>(occurringValues[1]) + lowest);
+      extrema.SecondMax =
+        static_cast<mitk::ScalarType>(static_cast<int>(occurringValues[occurringValues.size() - 2]) + lowest);
+    }
+
+    const HistogramBinning binning(extrema.Min, extrema.Max);
+    for (std::size_t value : occurringValues)
+      histogram[binning.GetBin(static_cast<int>(value) + lowest)] += counts[value];
+  }
 
-  // create time selector
-  // this->GetTimeSelector();
+  /** All other pixel types need a second pass for the histogram, after the extrema are known */
+  template <typename TPixel>
+  void ComputeExtremaAndHistogram(const Samples<TPixel> &samples,
+                                  Extrema &extrema,
+                                  std::vector<std::size_t> &histogram,
+                                  std::false_type)
+  {
+    const int numberOfChunks = samples.GetNumberOfChunks();
+
+    // one partial result per chunk keeps the merge order and thereby the result independent of the thread count
+    std::vector<Extrema> chunkExtrema(numberOfChunks);
+
+#pragma omp parallel for schedule(dynamic) if (numberOfChunks > 1)
+    for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+    {
+      Extrema &partial = chunkExtrema[chunk];
+      const std::size_t end = samples.GetChunkEnd(chunk);
+      for (std::size_t i = samples.GetChunkBegin(chunk); i < end; ++i)
+        partial.Add(samples[i]);
+    }
+
+    for (const Extrema &partial : chunkExtrema)
+      extrema.Merge(partial);
+
+    if (extrema.Min > extrema.Max)
+      return;
+
+    const HistogramBinning binning(extrema.Min, extrema.Max);
+    const mitk::ScalarType min = extrema.Min;
+    const mitk::ScalarType max = extrema.Max;
+
+#pragma omp parallel if (numberOfChunks > 1)
+    {
+      std::vector<std::size_t> threadHistogram(NumberOfHistogramBins, 0);
+
+#pragma omp for schedule(dynamic)
+      for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+      {
+        const std::size_t end = samples.GetChunkEnd(chunk);
+        for (std::size_t i = samples.GetChunkBegin(chunk); i < end; ++i)
+        {
+          const mitk::ScalarType value = samples[i];
+          if (value >= min && value <= max)
+            ++threadHistogram[binning.GetBin(value)];
+        }
+      }
+
+#pragma omp critical
+      for (unsigned int bin = 0; bin < NumberOfHistogramBins; ++bin)
+        histogram[bin] += threadHistogram[bin];
+    }
+  }
+
+  template <typename TPixel>
+  void ComputeExtremaAndHistogram(const void *data,
+                                  std::size_t numberOfPixels,
+                                  std::size_t numberOfComponents,
+                                  unsigned int component,
+                                  std::size_t sampleStride,
+                                  Extrema &extrema,
+                                  std::vector<std::size_t> &histogram)
+  {
+    Samples<TPixel> samples;
+    samples.Data = static_cast<const TPixel *>(data) + component;
+    samples.Step = sampleStride * numberOfComponents;
+    samples.Size = (numberOfPixels + sampleStride - 1) / sampleStride;
+
+    ComputeExtremaAndHistogram(samples, extrema, histogram, UseCountTable<TPixel>());
+  }
+
+  std::size_t GetNumberOfPixelsPerTimeStep(const mitk::Image *image)
+  {
+    std::size_t numberOfPixels = 1;
+    for (unsigned int i = 0; i < std::min(3u, image->GetDimension()); ++i)
+      numberOfPixels *= image->GetDimension(i);
+    return numberOfPixels;
+  }
 }
 
-mitk::ImageStatisticsHolder::~ImageStatisticsHolder()
+struct mitk::ImageStatisticsHolder::BackgroundComputation
+{
+  BackgroundComputation(const StatisticsKey &key) : Key(key), Finished(false), Succeeded(false), Discarded(false) {}
+
+  StatisticsKey Key;
+  Statistics Result;
+
+  /** Set by the background thread after Result and Succeeded are written */
+  std::atomic<bool> Finished;
+  bool Succeeded;
+
+  /** Only accessed by the holder, set if the image was modified after the computation was started */
+  bool Discarded;
+};
+
+mitk::ImageStatisticsHolder::Statistics::Statistics()
+  : Min(itk::NumericTraits<ScalarType>::max()),
+    Max(itk::NumericTraits<ScalarType>::NonpositiveMin()),
+    SecondMin(itk::NumericTraits<ScalarType>::max()),
+    SecondMax(itk::NumericTraits<ScalarType>::NonpositiveMin()),
+    CountOfMin(0),
+    CountOfMax(0),
+    Coarse(false)
 {
-  m_HistogramGeneratorObject = nullptr;
-  // m_TimeSelectorForExtremaObject = nullptr;
-  // m_Image = nullptr;
 }
 
-const mitk::ImageStatisticsHolder::HistogramType *mitk::ImageStatisticsHolder::GetScalarHistogram(
-  int t, unsigned int /*component*/)
+mitk::ImageStatisticsHolder::ImageStatisticsHolder(mitk::Image *image) : m_Image(image), m_ComputeInBackground(false)
 {
-  mitk::ImageTimeSelector *timeSelector = this->GetTimeSelector();
-  if (timeSelector != nullptr)
+}
+
+mitk::ImageStatisticsHolder::~ImageStatisticsHolder()
+{
+  for (auto &backgroundThread : m_BackgroundThreads)
   {
-    timeSelector->SetTimeNr(t);
-    timeSelector->UpdateLargestPossibleRegion();
-
-    mitk::HistogramGenerator *generator =
-      static_cast<mitk::HistogramGenerator *>(m_HistogramGeneratorObject.GetPointer());
-    generator->SetImage(timeSelector->GetOutput());
-    generator->ComputeHistogram();
-    return static_cast<const mitk::ImageStatisticsHolder::HistogramType *>(generator->GetHistogram());
+    // A background thread may hold the last reference to the image and thereby run this destructor.
+    // It does not touch the holder anymore at this point and must not join itself.
+    if (backgroundThread.first.get_id() == std::this_thread::get_id())
+      backgroundThread.first.detach();
+    else
+      backgroundThread.first.join();
   }
-  return nullptr;
+}
+
+const mitk::ImageStatisticsHolder::HistogramType *mitk::ImageStatisticsHolder::GetScalarHistogram(
+  int t, unsigned int component)
+{
+  return this->GetComponentStatistics(t, component).Histogram.GetPointer();
 }
 
 bool mitk::ImageStatisticsHolder::IsValidTimeStep(int t) const
@@ -68,18 +355,28 @@ bool mitk::ImageStatisticsHolder::IsValidTimeStep(int t) const
   return m_Image->IsValidTimeStep(t);
 }
 
-mitk::ImageTimeSelector::Pointer mitk::ImageStatisticsHolder::GetTimeSelector()
+void mitk::ImageStatisticsHolder::SetComputeInBackground(bool computeInBackground)
 {
-  // if(m_TimeSelectorForExtremaObject.IsNull())
-  //{
-  //  m_TimeSelectorForExtremaObject = ImageTimeSelector::New();
+  m_ComputeInBackground = computeInBackground;
+}
 
-  ImageTimeSelector::Pointer timeSelector =
-    ImageTimeSelector::New(); // static_cast<mitk::ImageTimeSelector*>( m_TimeSelectorForExtremaObject.GetPointer() );
-  timeSelector->SetInput(m_Image);
-  //}
+bool mitk::ImageStatisticsHolder::GetComputeInBackground() const
+{
+  return m_ComputeInBackground;
+}
 
-  return timeSelector; // static_cast<ImageTimeSelector*>( m_TimeSelectorForExtremaObject.GetPointer() );
+bool mitk::ImageStatisticsHolder::IsCoarse(int t, unsigned int component) const
+{
+  if (!m_Image->IsValidTimeStep(t))
+    return false;
+
+  this->CollectBackgroundComputations(false);
+  return this->FindComponentStatistics(t, component).Coarse;
+}
+
+void mitk::ImageStatisticsHolder::WaitForBackgroundComputations()
+{
+  this->CollectBackgroundComputations(true);
 }
 
 void mitk::ImageStatisticsHolder::Expand(unsigned int timeSteps)
@@ -89,211 +386,146 @@ void mitk::ImageStatisticsHolder::Expand(unsigned int timeSteps)
 
   // The BaseData needs to be expanded, call the mitk::Image::Expand() method
   m_Image->Expand(timeSteps);
-
-  if (timeSteps > m_ScalarMin.size())
-  {
-    m_ScalarMin.resize(timeSteps, itk::NumericTraits<ScalarType>::max());
-    m_ScalarMax.resize(timeSteps, itk::NumericTraits<ScalarType>::NonpositiveMin());
-    m_Scalar2ndMin.resize(timeSteps, itk::NumericTraits<ScalarType>::max());
-    m_Scalar2ndMax.resize(timeSteps, itk::NumericTraits<ScalarType>::NonpositiveMin());
-    m_CountOfMinValuedVoxels.resize(timeSteps, 0);
-    m_CountOfMaxValuedVoxels.resize(timeSteps, 0);
-  }
 }
 
 void mitk::ImageStatisticsHolder::ResetImageStatistics()
 {
-  m_ScalarMin.assign(1, itk::NumericTraits<ScalarType>::max());
-  m_ScalarMax.assign(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
-  m_Scalar2ndMin.assign(1, itk::NumericTraits<ScalarType>::max());
-  m_Scalar2ndMax.assign(1, itk::NumericTraits<ScalarType>::NonpositiveMin());
-  m_CountOfMinValuedVoxels.assign(1, 0);
-  m_CountOfMaxValuedVoxels.assign(1, 0);
-}
-
-#include "mitkImageAccessByItk.h"
+  m_Statistics.clear();
 
-//#define BOUNDINGOBJECT_IGNORE
+  // running computations are joined later on, but their results are outdated
+  for (auto &backgroundThread : m_BackgroundThreads)
+    backgroundThread.second->Discarded = true;
+}
 
-template <typename ItkImageType>
-void mitk::_ComputeExtremaInItkImage(const ItkImageType *itkImage, mitk::ImageStatisticsHolder *statisticsHolder, int t)
+void mitk::ImageStatisticsHolder::CollectBackgroundComputations(bool wait) const
 {
-  typename ItkImageType::RegionType region;
-  region = itkImage->GetBufferedRegion();
-  if (region.Crop(itkImage->GetRequestedRegion()) == false)
-    return;
-  if (region != itkImage->GetRequestedRegion())
-    return;
-
-  itk::ImageRegionConstIterator<ItkImageType> it(itkImage, region);
-  typedef typename ItkImageType::PixelType TPixel;
-  TPixel value = 0;
-
-  if (statisticsHolder == nullptr || !statisticsHolder->IsValidTimeStep(t))
-    return;
-  statisticsHolder->Expand(t + 1); // make sure we have initialized all arrays
-  statisticsHolder->m_CountOfMinValuedVoxels[t] = 0;
-  statisticsHolder->m_CountOfMaxValuedVoxels[t] = 0;
-
-  statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMin[t] = itk::NumericTraits<ScalarType>::max();
-  statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_ScalarMax[t] =
-    itk::NumericTraits<ScalarType>::NonpositiveMin();
-
-  while (!it.IsAtEnd())
+  for (auto iter = m_BackgroundThreads.begin(); iter != m_BackgroundThreads.end();)
   {
-    value = it.Get();
-//  if ( (value > mitkImage->m_ScalarMin) && (value < mitkImage->m_Scalar2ndMin) )        mitkImage->m_Scalar2ndMin =
-//  value;
-//  else if ( (value < mitkImage->m_ScalarMax) && (value > mitkImage->m_Scalar2ndMax) )   mitkImage->m_Scalar2ndMax =
-//  value;
-//  else if (value > mitkImage->m_ScalarMax)                                              mitkImage->m_ScalarMax =
-//  value;
-//  else if (value < mitkImage->m_ScalarMin)                                              mitkImage->m_ScalarMin =
-//  value;
-
-// if numbers start with 2ndMin or 2ndMax and never have that value again, the previous above logic failed
-#ifdef BOUNDINGOBJECT_IGNORE
-    if (value > -32765)
+    const BackgroundComputation &computation = *iter->second;
+    if (!wait && !computation.Finished)
     {
-#endif
-      // update min
-      if (value < statisticsHolder->m_ScalarMin[t])
-      {
-        statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMin[t];
-        statisticsHolder->m_ScalarMin[t] = value;
-        statisticsHolder->m_CountOfMinValuedVoxels[t] = 1;
-      }
-      else if (value == statisticsHolder->m_ScalarMin[t])
-      {
-        ++statisticsHolder->m_CountOfMinValuedVoxels[t];
-      }
-      else if (value < statisticsHolder->m_Scalar2ndMin[t])
-      {
-        statisticsHolder->m_Scalar2ndMin[t] = value;
-      }
-
-      // update max
-      if (value > statisticsHolder->m_ScalarMax[t])
-      {
-        statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_ScalarMax[t];
-        statisticsHolder->m_ScalarMax[t] = value;
-        statisticsHolder->m_CountOfMaxValuedVoxels[t] = 1;
-      }
-      else if (value == statisticsHolder->m_ScalarMax[t])
-      {
-        ++statisticsHolder->m_CountOfMaxValuedVoxels[t];
-      }
-      else if (value > statisticsHolder->m_Scalar2ndMax[t])
-      {
-        statisticsHolder->m_Scalar2ndMax[t] = value;
-      }
-#ifdef BOUNDINGOBJECT_IGNORE
+      ++iter;
+      continue;
     }
-#endif
 
-    ++it;
-  }
+    iter->first.join();
+    if (computation.Succeeded && !computation.Discarded)
+      m_Statistics[computation.Key] = computation.Result;
 
-  //// guard for wrong 2dMin/Max on single constant value images
-  if (statisticsHolder->m_ScalarMax[t] == statisticsHolder->m_ScalarMin[t])
-  {
-    statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMax[t];
+    iter = m_BackgroundThreads.erase(iter);
   }
-  statisticsHolder->m_LastRecomputeTimeStamp.Modified();
-  // MITK_DEBUG <<"extrema "<<itk::NumericTraits<TPixel>::NonpositiveMin()<<" "<<mitkImage->m_ScalarMin<<"
-  // "<<mitkImage->m_Scalar2ndMin<<" "<<mitkImage->m_Scalar2ndMax<<" "<<mitkImage->m_ScalarMax<<"
-  // "<<itk::NumericTraits<TPixel>::max();
 }
 
-template <typename ItkImageType>
-void mitk::_ComputeExtremaInItkVectorImage(const ItkImageType *itkImage,
-                                           mitk::ImageStatisticsHolder *statisticsHolder,
-                                           int t,
-                                           unsigned int component)
+bool mitk::ImageStatisticsHolder::ComputeStatistics(
+  const Image *image, unsigned int t, unsigned int component, std::size_t sampleStride, Statistics &statistics)
 {
-  typename ItkImageType::RegionType region;
-  region = itkImage->GetBufferedRegion();
-  if (region.Crop(itkImage->GetRequestedRegion()) == false)
-    return;
-  if (region != itkImage->GetRequestedRegion())
-    return;
+  const PixelType pixelType = image->GetPixelType();
+  const std::size_t numberOfPixels = GetNumberOfPixelsPerTimeStep(image);
+  const std::size_t numberOfComponents = pixelType.GetNumberOfComponents();
 
-  itk::ImageRegionConstIterator<ItkImageType> it(itkImage, region);
+  ImageReadAccessor accessor(image, image->GetVolumeData(t).GetPointer());
+  const void *data = accessor.GetData();
 
-  if (statisticsHolder == nullptr || !statisticsHolder->IsValidTimeStep(t))
-    return;
-  statisticsHolder->Expand(t + 1); // make sure we have initialized all arrays
-  statisticsHolder->m_CountOfMinValuedVoxels[t] = 0;
-  statisticsHolder->m_CountOfMaxValuedVoxels[t] = 0;
-
-  statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMin[t] = itk::NumericTraits<ScalarType>::max();
-  statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_ScalarMax[t] =
-    itk::NumericTraits<ScalarType>::NonpositiveMin();
+  Extrema extrema;
+  std::vector<std::size_t> histogram(NumberOfHistogramBins, 0);
 
-  while (!it.IsAtEnd())
+  switch (pixelType.GetComponentType())
   {
-    double value = it.Get()[component];
-//  if ( (value > mitkImage->m_ScalarMin) && (value < mitkImage->m_Scalar2ndMin) )        mitkImage->m_Scalar2ndMin =
-//  value;
-//  else if ( (value < mitkImage->m_ScalarMax) && (value > mitkImage->m_Scalar2ndMax) )   mitkImage->m_Scalar2ndMax =
-//  value;
-//  else if (value > mitkImage->m_ScalarMax)                                              mitkImage->m_ScalarMax =
-//  value;
-//  else if (value < mitkImage->m_ScalarMin)                                              mitkImage->m_ScalarMin =
-//  value;
-
-// if numbers start with 2ndMin or 2ndMax and never have that value again, the previous above logic failed
-#ifdef BOUNDINGOBJECT_IGNORE
-    if (value > -32765)
-    {
-#endif
-      // update min
-      if (value < statisticsHolder->m_ScalarMin[t])
-      {
-        statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMin[t];
-        statisticsHolder->m_ScalarMin[t] = value;
-        statisticsHolder->m_CountOfMinValuedVoxels[t] = 1;
-      }
-      else if (value == statisticsHolder->m_ScalarMin[t])
-      {
-        ++statisticsHolder->m_CountOfMinValuedVoxels[t];
-      }
-      else if (value < statisticsHolder->m_Scalar2ndMin[t])
-      {
-        statisticsHolder->m_Scalar2ndMin[t] = value;
-      }
+    case itk::ImageIOBase::CHAR:
+      ComputeExtremaAndHistogram<char>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::UCHAR:
+      ComputeExtremaAndHistogram<unsigned char>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::SHORT:
+      ComputeExtremaAndHistogram<short>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::USHORT:
+      ComputeExtremaAndHistogram<unsigned short>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::INT:
+      ComputeExtremaAndHistogram<int>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::UINT:
+      ComputeExtremaAndHistogram<unsigned int>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::LONG:
+      ComputeExtremaAndHistogram<long int>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::ULONG:
+      ComputeExtremaAndHistogram<unsigned long int>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::FLOAT:
+      ComputeExtremaAndHistogram<float>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    case itk::ImageIOBase::DOUBLE:
+      ComputeExtremaAndHistogram<double>(
+        data, numberOfPixels, numberOfComponents, component, sampleStride, extrema, histogram);
+      break;
+    default:
+      return false;
+  }
 
-      // update max
-      if (value > statisticsHolder->m_ScalarMax[t])
-      {
-        statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_ScalarMax[t];
-        statisticsHolder->m_ScalarMax[t] = value;
-        statisticsHolder->m_CountOfMaxValuedVoxels[t] = 1;
-      }
-      else if (value == statisticsHolder->m_ScalarMax[t])
-      {
-        ++statisticsHolder->m_CountOfMaxValuedVoxels[t];
-      }
-      else if (value > statisticsHolder->m_Scalar2ndMax[t])
-      {
-        statisticsHolder->m_Scalar2ndMax[t] = value;
-      }
-#ifdef BOUNDINGOBJECT_IGNORE
-    }
-#endif
+  statistics = Statistics();
+  statistics.Min = extrema.Min;
+  statistics.Max = extrema.Max;
+  statistics.SecondMin = extrema.SecondMin;
+  statistics.SecondMax = extrema.SecondMax;
+  statistics.CountOfMin = extrema.CountOfMin * sampleStride;
+  statistics.CountOfMax = extrema.CountOfMax * sampleStride;
+  statistics.Coarse = sampleStride > 1;
+
+  // guard for wrong 2dMin/Max on single constant value images
+  if (statistics.Max == statistics.Min)
+  {
+    statistics.SecondMax = statistics.SecondMin = statistics.Max;
+  }
 
-    ++it;
+  if (statistics.Min <= statistics.Max)
+  {
+    HistogramType::SizeType size(1);
+    size.Fill(NumberOfHistogramBins);
+    HistogramType::MeasurementVectorType lowerBound(1);
+    HistogramType::MeasurementVectorType upperBound(1);
+    lowerBound[0] = statistics.Min;
+    upperBound[0] = statistics.Max > statistics.Min ? statistics.Max : statistics.Min + 1.0;
+
+    statistics.Histogram = HistogramType::New();
+    statistics.Histogram->SetMeasurementVectorSize(1);
+    statistics.Histogram->Initialize(size, lowerBound, upperBound);
+    for (unsigned int bin = 0; bin < NumberOfHistogramBins; ++bin)
+      statistics.Histogram->SetFrequency(bin, histogram[bin] * sampleStride);
   }
 
-  //// guard for wrong 2dMin/Max on single constant value images
-  if (statisticsHolder->m_ScalarMax[t] == statisticsHolder->m_ScalarMin[t])
+  return true;
+}
+
+void mitk::ImageStatisticsHolder::ComputeInBackground(Image::ConstPointer image,
+                                                      unsigned int t,
+                                                      unsigned int component,
+                                                      std::shared_ptr<BackgroundComputation> computation)
+{
+  try
   {
-    statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMax[t];
+    computation->Succeeded = ComputeStatistics(image, t, component, 1, computation->Result);
   }
-  statisticsHolder->m_LastRecomputeTimeStamp.Modified();
-  // MITK_DEBUG <<"extrema "<<itk::NumericTraits<TPixel>::NonpositiveMin()<<" "<<mitkImage->m_ScalarMin<<"
-  // "<<mitkImage->m_Scalar2ndMin<<" "<<mitkImage->m_Scalar2ndMax<<" "<<mitkImage->m_ScalarMax<<"
-  // "<<itk::NumericTraits<TPixel>::max();
+  catch (const std::exception &e)
+  {
+    MITK_ERROR << "Background computation of image statistics failed: " << e.what();
+  }
+  computation->Finished = true;
+
+  // Releasing the image may destroy it together with its statistics holder,
+  // so nothing but the computation must be used from here on.
 }
 
 void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t, unsigned int component)
@@ -308,82 +540,147 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t, unsigned int com
 
   Expand(t + 1);
 
-  // do we have valid information already?
-  if (m_ScalarMin[t] != itk::NumericTraits<ScalarType>::max() ||
-      m_Scalar2ndMin[t] != itk::NumericTraits<ScalarType>::max())
-    return; // Values already calculated before...
+  this->CollectBackgroundComputations(false);
 
   // used to avoid statistics calculation on qball images. property will be replaced as soons as bug 17928 is merged and
   // the diffusion image refactoring is complete.
   mitk::BoolProperty *isqball = dynamic_cast<mitk::BoolProperty *>(m_Image->GetProperty("IsQballImage").GetPointer());
   const mitk::PixelType pType = m_Image->GetPixelType(0);
-  if (pType.GetNumberOfComponents() == 1 && (pType.GetPixelType() != itk::ImageIOBase::UNKNOWNPIXELTYPE) &&
-      (pType.GetPixelType() != itk::ImageIOBase::VECTOR))
+  const bool isScalar = pType.GetNumberOfComponents() == 1 &&
+                        (pType.GetPixelType() != itk::ImageIOBase::UNKNOWNPIXELTYPE) &&
+                        (pType.GetPixelType() != itk::ImageIOBase::VECTOR);
+  const bool isVector =
+    pType.GetPixelType() == itk::ImageIOBase::VECTOR && (!isqball || !isqball->GetValue()); // we have a vector image
+
+  // the component is ignored for scalar images
+  if (!isVector)
+    component = 0;
+  else if (component >= pType.GetNumberOfComponents())
+    mitkThrow() << "ImageStatisticsHolder: component " << component << " does not exist, pixel type has "
+                << pType.GetNumberOfComponents() << " components.";
+
+  // do we have valid information already?
+  const StatisticsKey key(t, component);
+  if (m_Statistics.find(key) != m_Statistics.end())
+    return; // Values already calculated before...
+
+  Statistics statistics;
+  if (isScalar || isVector)
   {
-    // recompute
-    mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
-    if (timeSelector.IsNotNull())
+    const std::size_t numberOfPixels = GetNumberOfPixelsPerTimeStep(m_Image);
+    std::size_t sampleStride = 1;
+    if (m_ComputeInBackground && numberOfPixels >= 2 * NumberOfCoarseSamples)
+      sampleStride = numberOfPixels / NumberOfCoarseSamples;
+
+    if (!ComputeStatistics(m_Image, t, component, sampleStride, statistics))
     {
-      timeSelector->SetTimeNr(t);
-      timeSelector->UpdateLargestPossibleRegion();
-      const mitk::Image *image = timeSelector->GetOutput();
-      AccessByItk_2(image, _ComputeExtremaInItkImage, this, t);
+      mitkThrow() << "ImageStatisticsHolder: pixel component type " << pType.GetComponentTypeAsString()
+                  << " is not supported.";
     }
-  }
-  else if (pType.GetPixelType() == itk::ImageIOBase::VECTOR &&
-           (!isqball || !isqball->GetValue())) // we have a vector image
-  {
-    // recompute
-    mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
-    if (timeSelector.IsNotNull())
+
+    if (statistics.Coarse)
     {
-      timeSelector->SetTimeNr(t);
-      timeSelector->UpdateLargestPossibleRegion();
-      const mitk::Image *image = timeSelector->GetOutput();
-      AccessVectorPixelTypeByItk_n(image, _ComputeExtremaInItkVectorImage, (this, t, component));
+      auto computation = std::make_shared<BackgroundComputation>(key);
+      m_BackgroundThreads.emplace_back(
+        std::thread(&ImageStatisticsHolder::ComputeInBackground, Image::ConstPointer(m_Image), t, component, computation),
+        computation);
     }
   }
   else
   {
-    m_ScalarMin[t] = 0;
-    m_ScalarMax[t] = 255;
-    m_Scalar2ndMin[t] = 0;
-    m_Scalar2ndMax[t] = 255;
+    statistics.Min = 0;
+    statistics.Max = 255;
+    statistics.SecondMin = 0;
+    statistics.SecondMax = 255;
   }
+
+  m_Statistics[key] = statistics;
+  m_LastRecomputeTimeStamp.Modified();
 }
 
-mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValueMin(int t, unsigned int component)
+const mitk::ImageStatisticsHolder::Statistics &mitk::ImageStatisticsHolder::GetComponentStatistics(
+  int t, unsigned int component)
 {
   ComputeImageStatistics(t, component);
-  return m_ScalarMin[t];
+  return this->FindComponentStatistics(t, component);
+}
+
+const mitk::ImageStatisticsHolder::Statistics &mitk::ImageStatisticsHolder::FindComponentStatistics(
+  unsigned int t, unsigned int component) const
+{
+  static const Statistics defaultStatistics;
+
+  auto iter = m_Statistics.find(StatisticsKey(t, component));
+
+  // statistics of scalar images are cached for component 0 only
+  if (iter == m_Statistics.end())
+    iter = m_Statistics.find(StatisticsKey(t, 0));
+
+  return iter != m_Statistics.end() ? iter->second : defaultStatistics;
+}
+
+mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValueMin(int t, unsigned int component)
+{
+  return this->GetComponentStatistics(t, component).Min;
 }
 
 mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValueMax(int t, unsigned int component)
 {
-  ComputeImageStatistics(t, component);
-  return m_ScalarMax[t];
+  return this->GetComponentStatistics(t, component).Max;
 }
 
 mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValue2ndMin(int t, unsigned int component)
 {
-  ComputeImageStatistics(t, component);
-  return m_Scalar2ndMin[t];
+  return this->GetComponentStatistics(t, component).SecondMin;
 }
 
 mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValue2ndMax(int t, unsigned int component)
 {
-  ComputeImageStatistics(t, component);
-  return m_Scalar2ndMax[t];
+  return this->GetComponentStatistics(t, component).SecondMax;
 }
 
 mitk::ScalarType mitk::ImageStatisticsHolder::GetCountOfMinValuedVoxels(int t, unsigned int component)
 {
-  ComputeImageStatistics(t, component);
-  return m_CountOfMinValuedVoxels[t];
+  return this->GetComponentStatistics(t, component).CountOfMin;
 }
 
 mitk::ScalarType mitk::ImageStatisticsHolder::GetCountOfMaxValuedVoxels(int t, unsigned int component)
 {
-  ComputeImageStatistics(t, component);
-  return m_CountOfMaxValuedVoxels[t];
+  return this->GetComponentStatistics(t, component).CountOfMax;
+}
+
+mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValueMinNoRecompute(unsigned int t) const
+{
+  this->CollectBackgroundComputations(false);
+  return this->FindComponentStatistics(t, 0).Min;
+}
+
+mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValue2ndMinNoRecompute(unsigned int t) const
+{
+  this->CollectBackgroundComputations(false);
+  return this->FindComponentStatistics(t, 0).SecondMin;
+}
+
+mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValueMaxNoRecompute(unsigned int t)
+{
+  this->CollectBackgroundComputations(false);
+  return this->FindComponentStatistics(t, 0).Max;
+}
+
+mitk::ScalarType mitk::ImageStatisticsHolder::GetScalarValue2ndMaxNoRecompute(unsigned int t)
+{
+  this->CollectBackgroundComputations(false);
+  return this->FindComponentStatistics(t, 0).SecondMax;
+}
+
+unsigned int mitk::ImageStatisticsHolder::GetCountOfMaxValuedVoxelsNoRecompute(unsigned int t)
+{
+  this->CollectBackgroundComputations(false);
+  return static_cast<unsigned int>(this->FindComponentStatistics(t, 0).CountOfMax);
+}
+
+unsigned int mitk::ImageStatisticsHolder::GetCountOfMinValuedVoxelsNoRecompute(unsigned int t) const
+{
+  this->CollectBackgroundComputations(false);
+  return static_cast<unsigned int>(this->FindComponentStatistics(t, 0).CountOfMin);
 }
@@ -33,6 +33,7 @@ mitk::ImageWriteAccessor::~ImageWriteAccessor()
   // delete self from list of ImageReadAccessors in Image
   auto it = std::find(m_Image->m_Writers.begin(), m_Image->m_Writers.end(), this);
   m_Image->m_Writers.erase(it);
+  ++m_Image->m_WriteAccessCount;
 
   // delete lock, if there are no waiting ImageAccessors
   if (m_WaitLock->m_WaiterCount <= 0)
@@ -24,6 +24,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNodePredicateProperty.h"
 #include "mitkProperties.h"
 
+#include <algorithm>
+#include <set>
+
 mitk::StandaloneDataStorage::StandaloneDataStorage() : mitk::DataStorage()
 {
 }
@@ -113,9 +116,19 @@ void mitk::StandaloneDataStorage::Remove(const mitk::DataNode *node)
   EmitRemoveNodeEvent(node);
   {
     itk::MutexLockHolder<itk::SimpleFastMutexLock> locked(m_Mutex);
-    /* remove node from both relation adjacency lists */
-    this->RemoveFromRelation(node, m_SourceNodes);
-    this->RemoveFromRelation(node, m_DerivedNodes);
+    /* remove node from both relation adjacency lists. Only the relation lists of the
+       derivations (sources) of node can contain node as source (derivation). */
+    SetOfObjects::ConstPointer sources;
+    SetOfObjects::ConstPointer derivations;
+    AdjacencyList::const_iterator sourcesIt = m_SourceNodes.find(node);
+    if (sourcesIt != m_SourceNodes.cend())
+      sources = sourcesIt->second;
+    AdjacencyList::const_iterator derivationsIt = m_DerivedNodes.find(node);
+    if (derivationsIt != m_DerivedNodes.cend())
+      derivations = derivationsIt->second;
+
+    this->RemoveFromRelation(node, m_SourceNodes, derivations);
+    this->RemoveFromRelation(node, m_DerivedNodes, sources);
   }
 }
 
@@ -125,12 +138,18 @@ bool mitk::StandaloneDataStorage::Exists(const mitk::DataNode *node) const
   return (m_SourceNodes.find(node) != m_SourceNodes.end());
 }
 
-void mitk::StandaloneDataStorage::RemoveFromRelation(const mitk::DataNode *node, AdjacencyList &relation)
+void mitk::StandaloneDataStorage::RemoveFromRelation(const mitk::DataNode *node,
+                                                     AdjacencyList &relation,
+                                                     const SetOfObjects *relatedNodes)
 {
-  for (AdjacencyList::const_iterator mapIter = relation.cbegin(); mapIter != relation.cend();
-       ++mapIter)                    // for each node in the relation
-    if (mapIter->second.IsNotNull()) // if node has a relation list
+  if (relatedNodes != nullptr)
+    for (SetOfObjects::ConstIterator relatedIt = relatedNodes->Begin(); relatedIt != relatedNodes->End();
+         ++relatedIt) // for each node whose relation list can contain node
     {
+      AdjacencyList::const_iterator mapIter = relation.find(relatedIt.Value().GetPointer());
+      if ((mapIter == relation.cend()) || (mapIter->second.IsNull())) // if node has no relation list
+        continue;
+
       SetOfObjects::Pointer s =
         const_cast<SetOfObjects *>(mapIter->second.GetPointer()); // search for node to be deleted in the relation list
       SetOfObjects::STLContainerType::iterator relationListIter = std::find(
@@ -187,10 +206,12 @@ mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetRe
   /* Or traverse adjacency list to collect all related nodes */
   std::vector<mitk::DataNode::ConstPointer> resultset;
   std::vector<mitk::DataNode::ConstPointer> openlist;
+  std::set<const mitk::DataNode *> visited; // nodes that are in resultset or openlist
 
   /* Initialize openlist with node. this will add node to resultset,
      but that is necessary to detect circular relations that would lead to endless recursion */
   openlist.push_back(node);
+  visited.insert(node);
 
   while (openlist.size() > 0)
   {
@@ -209,10 +230,7 @@ mitk::DataStorage::SetOfObjects::ConstPointer mitk::StandaloneDataStorage::GetRe
            ++parentIt) // for each parent of current node
       {
         mitk::DataNode::ConstPointer p = parentIt.Value().GetPointer();
-        if (!(std::find(resultset.cbegin(), resultset.cend(), p) !=
-              resultset.end()) // if it is not already in resultset
-            &&
-            !(std::find(openlist.cbegin(), openlist.cend(), p) != openlist.cend())) // and not already in openlist
+        if (visited.insert(p.GetPointer()).second) // if it is not already in resultset or openlist
           openlist.push_back(p); // then add it to openlist, so that it can be processed
       }
   }
@@ -146,6 +146,7 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
     // the latest image is used there if the plane is out of the geometry
     // see bug-13275
     localStorage->m_ReslicedImage = nullptr;
+    localStorage->m_ResliceState = LocalStorage::ResliceState();
     localStorage->m_Mapper->SetInputData(localStorage->m_EmptyPolyData);
     return;
   }
@@ -166,12 +167,12 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
 
   // Initialize the interpolation mode for resampling; switch to nearest
   // neighbor if the input image is too small.
+  int interpolationMode = VTK_RESLICE_NEAREST;
   if ((image->GetDimension() >= 3) && (image->GetDimension(2) > 1))
   {
     VtkResliceInterpolationProperty *resliceInterpolationProperty;
     datanode->GetProperty(resliceInterpolationProperty, "reslice interpolation", renderer);
 
-    int interpolationMode = VTK_RESLICE_NEAREST;
     if (resliceInterpolationProperty != nullptr)
     {
       interpolationMode = resliceInterpolationProperty->GetInterpolation();
@@ -229,60 +230,85 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rendere
 
   const PlaneGeometry *planeGeometry = dynamic_cast<const PlaneGeometry *>(worldGeometry);
 
-  if (thickSlicesMode > 0)
+  // The slice only has to be extracted again if the data or the plane changed. Everything
+  // else (level window, color, opacity, ...) is applied to the cached slice further below.
+  LocalStorage::ResliceState resliceState;
+  resliceState.Image = image;
+  resliceState.ImageMTime = image->GetMTime();
+  resliceState.ImageWriteAccessCount = image->GetWriteAccessCount();
+  vtkImageData *volume = image->GetVtkImageData(this->GetTimestep());
+  resliceState.VolumeMTime = (volume != nullptr ? volume->GetMTime() : 0);
+  resliceState.ImageGeometryMTime = image->GetTimeGeometry()->GetGeometryForTimeStep(this->GetTimestep())->GetMTime();
+  resliceState.WorldGeometry = worldGeometry;
+  resliceState.WorldGeometryMTime = worldGeometry->GetMTime();
+  resliceState.WorldGeometryUpdateTime = renderer->GetCurrentWorldPlaneGeometryUpdateTime();
+  resliceState.TimeStep = this->GetTimestep();
+  resliceState.InterpolationMode = interpolationMode;
+  resliceState.InPlaneResampleExtentByGeometry = inPlaneResampleExtentByGeometry;
+  resliceState.ThickSlicesMode = thickSlicesMode;
+  resliceState.ThickSlicesNum = thickSlicesNum;
+
+  const bool resliceRequired =
+    localStorage->m_ReslicedImage == nullptr || resliceState != localStorage->m_ResliceState;
+
+  if (resliceRequired)
   {
-    double dataZSpacing = 1.0;
+    if (thickSlicesMode > 0)
+    {
+      double dataZSpacing = 1.0;
 
-    Vector3D normInIndex, normal;
+      Vector3D normInIndex, normal;
 
-    const mitk::AbstractTransformGeometry *abstractGeometry =
-      dynamic_cast<const AbstractTransformGeometry *>(worldGeometry);
-    if (abstractGeometry != nullptr)
-      normal = abstractGeometry->GetPlane()->GetNormal();
-    else
-    {
-      if (planeGeometry != nullptr)
+      const mitk::AbstractTransformGeometry *abstractGeometry =
+        dynamic_cast<const AbstractTransformGeometry *>(worldGeometry);
+      if (abstractGeometry != nullptr)
+        normal = abstractGeometry->GetPlane()->GetNormal();
+      else
       {
-        normal = planeGeometry->GetNormal();
+        if (planeGeometry != nullptr)
+        {
+          normal = planeGeometry->GetNormal();
+        }
+        else
+          return; // no fitting geometry set
       }
-      else
-        return; // no fitting geometry set
-    }
-    normal.Normalize();
+      normal.Normalize();
 
-    image->GetTimeGeometry()->GetGeometryForTimeStep(this->GetTimestep())->WorldToIndex(normal, normInIndex);
+      image->GetTimeGeometry()->GetGeometryForTimeStep(this->GetTimestep())->WorldToIndex(normal, normInIndex);
 
-    dataZSpacing = 1.0 / normInIndex.GetNorm();
+      dataZSpacing = 1.0 / normInIndex.GetNorm();
 
-    localStorage->m_Reslicer->SetOutputDimensionality(3);
-    localStorage->m_Reslicer->SetOutputSpacingZDirection(dataZSpacing);
-    localStorage->m_Reslicer->SetOutputExtentZDirection(-thickSlicesNum, 0 + thickSlicesNum);
+      localStorage->m_Reslicer->SetOutputDimensionality(3);
+      localStorage->m_Reslicer->SetOutputSpacingZDirection(dataZSpacing);
+      localStorage->m_Reslicer->SetOutputExtentZDirection(-thickSlicesNum, 0 + thickSlicesNum);
 
-    // Do the reslicing. Modified() is called to make sure that the reslicer is
-    // executed even though the input geometry information did not change; this
-    // is necessary when the input /em data, but not the /em geometry changes.
-    localStorage->m_TSFilter->SetThickSliceMode(thickSlicesMode - 1);
-    localStorage->m_TSFilter->SetInputData(localStorage->m_Reslicer->GetVtkOutput());
+      // Do the reslicing. Modified() is called to make sure that the reslicer is
+      // executed even though the input geometry information did not change; this
+      // is necessary when the input /em data, but not the /em geometry changes.
+      localStorage->m_TSFilter->SetThickSliceMode(thickSlicesMode - 1);
+      localStorage->m_TSFilter->SetInputData(localStorage->m_Reslicer->GetVtkOutput());
 
-    // vtkFilter=>mitkFilter=>vtkFilter update mechanism will fail without calling manually
-    localStorage->m_Reslicer->Modified();
-    localStorage->m_Reslicer->Update();
+      // vtkFilter=>mitkFilter=>vtkFilter update mechanism will fail without calling manually
+      localStorage->m_Reslicer->Modified();
+      localStorage->m_Reslicer->Update();
 
-    localStorage->m_TSFilter->Modified();
-    localStorage->m_TSFilter->Update();
-    localStorage->m_ReslicedImage = localStorage->m_TSFilter->GetOutput();
-  }
-  else
-  {
-    // this is needed when thick mode was enable bevore. These variable have to be reset to default values
-    localStorage->m_Reslicer->SetOutputDimensionality(2);
-    localStorage->m_Reslicer->SetOutputSpacingZDirection(1.0);
-    localStorage->m_Reslicer->SetOutputExtentZDirection(0, 0);
-
-    localStorage->m_Reslicer->Modified();
-    // start the pipeline with updating the largest possible, needed if the geometry of the input has changed
-    localStorage->m_Reslicer->UpdateLargestPossibleRegion();
-    localStorage->m_ReslicedImage = localStorage->m_Reslicer->GetVtkOutput();
+      localStorage->m_TSFilter->Modified();
+      localStorage->m_TSFilter->Update();
+      localStorage->m_ReslicedImage = localStorage->m_TSFilter->GetOutput();
+    }
+    else
+    {
+      // this is needed when thick mode was enable bevore. These variable have to be reset to default values
+      localStorage->m_Reslicer->SetOutputDimensionality(2);
+      localStorage->m_Reslicer->SetOutputSpacingZDirection(1.0);
+      localStorage->m_Reslicer->SetOutputExtentZDirection(0, 0);
+
+      localStorage->m_Reslicer->Modified();
+      // start the pipeline with updating the largest possible, needed if the geometry of the input has changed
+      localStorage->m_Reslicer->UpdateLargestPossibleRegion();
+      localStorage->m_ReslicedImage = localStorage->m_Reslicer->GetVtkOutput();
+    }
+    localStorage->m_ResliceState = resliceState;
   }
 
   // Bounds information for reslicing (only reuqired if reference geometry
@@ -1081,6 +1107,35 @@ mitk::ImageVtkMapper2D::LocalStorage::~LocalStorage()
 {
 }
 
+mitk::ImageVtkMapper2D::LocalStorage::ResliceState::ResliceState()
+  : Image(nullptr),
+    ImageMTime(0),
+    ImageWriteAccessCount(0),
+    VolumeMTime(0),
+    ImageGeometryMTime(0),
+    WorldGeometry(nullptr),
+    WorldGeometryMTime(0),
+    WorldGeometryUpdateTime(0),
+    TimeStep(-1),
+    InterpolationMode(-1),
+    InPlaneResampleExtentByGeometry(false),
+    ThickSlicesMode(-1),
+    ThickSlicesNum(-1)
+{
+}
+
+bool mitk::ImageVtkMapper2D::LocalStorage::ResliceState::operator==(const ResliceState &other) const
+{
+  return Image == other.Image && ImageMTime == other.ImageMTime &&
+         ImageWriteAccessCount == other.ImageWriteAccessCount && VolumeMTime == other.VolumeMTime &&
+         ImageGeometryMTime == other.ImageGeometryMTime &&
+         WorldGeometry == other.WorldGeometry && WorldGeometryMTime == other.WorldGeometryMTime &&
+         WorldGeometryUpdateTime == other.WorldGeometryUpdateTime && TimeStep == other.TimeStep &&
+         InterpolationMode == other.InterpolationMode &&
+         InPlaneResampleExtentByGeometry == other.InPlaneResampleExtentByGeometry &&
+         ThickSlicesMode == other.ThickSlicesMode && ThickSlicesNum == other.ThickSlicesNum;
+}
+
 mitk::ImageVtkMapper2D::LocalStorage::LocalStorage()
   : m_VectorComponentExtractor(vtkSmartPointer<vtkImageExtractComponents>::New())
 {
@@ -1103,7 +1158,8 @@ mitk::ImageVtkMapper2D::LocalStorage::LocalStorage()
 
   // the following actions are always the same and thus can be performed
   // in the constructor for each image (i.e. the image-corresponding local storage)
-  m_TSFilter->ReleaseDataFlagOn();
+  // the output of m_TSFilter is kept as cached slice (see ResliceState), so it must not be released
+  m_TSFilter->ReleaseDataFlagOff();
 
   mitk::LookupTable::Pointer mitkLUT = mitk::LookupTable::New();
   // built a default lookuptable
@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseRenderer.h"
 #include "mitkDataNode.h"
 #include "mitkProperties.h"
+#include "mitkRenderingProfiler.h"
 
 mitk::Mapper::Mapper() : m_DataNode(nullptr), m_TimeStep(0)
 {
@@ -117,6 +118,7 @@ void mitk::Mapper::Update(mitk::BaseRenderer *renderer)
     return;
   }
 
+  RenderingProfiler::ScopedEvent profilerEvent("GenerateData", this->GetNameOfClass(), renderer, node);
   this->GenerateDataForRenderer(renderer);
 }
 
@@ -0,0 +1,342 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkRenderingProfiler.h"
+
+#include "mitkBaseRenderer.h"
+#include "mitkDataNode.h"
+
+#include <itkMutexLockHolder.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+  typedef itk::MutexLockHolder<itk::SimpleFastMutexLock> MutexHolder;
+
+  std::string GetRendererName(const mitk::BaseRenderer *renderer)
+  {
+    return (renderer != nullptr && renderer->GetName() != nullptr) ? renderer->GetName() : "";
+  }
+
+  void AddToSummary(mitk::RenderingProfiler::TimingSummary &summary, double duration)
+  {
+    ++summary.Count;
+    summary.TotalTime += duration;
+    summary.MaximumTime = std::max(summary.MaximumTime, duration);
+  }
+
+  void WriteJSONString(std::ostream &stream, const std::string &text)
+  {
+    stream << '"';
+    for (char c : text)
+    {
+      switch (c)
+      {
+        case '"':
+          stream << "\\\"";
+          break;
+        case '\\':
+          stream << "\\\\";
+          break;
+        case '\n':
+          stream << "\\n";
+          break;
+        case '\t':
+          stream << "\\t";
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20)
+          {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+            stream << escaped;
+          }
+          else
+          {
+            stream << c;
+          }
+      }
+    }
+    stream << '"';
+  }
+}
+
+mitk::RenderingProfiler::ScopedEvent::ScopedEvent(const char *category,
+                                                  const char *name,
+                                                  const BaseRenderer *renderer,
+                                                  const DataNode *node)
+  : m_Active(RenderingProfiler::GetInstance()->GetEnabled()),
+    m_Category(category),
+    m_Name(name),
+    m_Renderer(renderer),
+    m_StartTime(0.0)
+{
+  if (!m_Active)
+    return;
+
+  if (node != nullptr)
+    m_NodeName = node->GetName();
+
+  m_StartTime = RenderingProfiler::GetInstance()->GetTime();
+}
+
+mitk::RenderingProfiler::ScopedEvent::~ScopedEvent()
+{
+  if (!m_Active)
+    return;
+
+  RenderingProfiler *profiler = RenderingProfiler::GetInstance();
+  profiler->RecordEvent(m_Category, m_Name, m_Renderer, m_NodeName, m_StartTime, profiler->GetTime() - m_StartTime);
+}
+
+mitk::RenderingProfiler *mitk::RenderingProfiler::GetInstance()
+{
+  static RenderingProfiler instance;
+  return &instance;
+}
+
+mitk::RenderingProfiler::RenderingProfiler()
+  : m_Enabled(false), m_MaximumNumberOfEvents(1000000), m_StartTime(std::chrono::steady_clock::now())
+{
+}
+
+mitk::RenderingProfiler::~RenderingProfiler()
+{
+}
+
+void mitk::RenderingProfiler::SetEnabled(bool enabled)
+{
+  MutexHolder lock(m_Mutex);
+  m_Enabled = enabled;
+
+  // frames that started before disabling must not be completed with a stale start time later on
+  m_FrameStartTimes.clear();
+}
+
+void mitk::RenderingProfiler::SetMaximumNumberOfEvents(std::size_t maximumNumberOfEvents)
+{
+  MutexHolder lock(m_Mutex);
+  m_MaximumNumberOfEvents = maximumNumberOfEvents;
+  while (m_Events.size() > m_MaximumNumberOfEvents)
+    m_Events.pop_front();
+}
+
+std::size_t mitk::RenderingProfiler::GetMaximumNumberOfEvents() const
+{
+  MutexHolder lock(m_Mutex);
+  return m_MaximumNumberOfEvents;
+}
+
+void mitk::RenderingProfiler::Clear()
+{
+  MutexHolder lock(m_Mutex);
+  m_Events.clear();
+  m_FrameStartTimes.clear();
+}
+
+double mitk::RenderingProfiler::GetTime() const
+{
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_StartTime).count();
+}
+
+void mitk::RenderingProfiler::AddEvent(const Event &event)
+{
+  if (m_MaximumNumberOfEvents == 0)
+    return;
+
+  if (m_Events.size() >= m_MaximumNumberOfEvents)
+    m_Events.pop_front();
+
+  m_Events.push_back(event);
+}
+
+void mitk::RenderingProfiler::RecordEvent(const std::string &category,
+                                          const std::string &name,
+                                          const BaseRenderer *renderer,
+                                          const std::string &nodeName,
+                                          double startTime,
+                                          double duration,
+                                          int levelOfDetail)
+{
+  if (!this->GetEnabled())
+    return;
+
+  Event event;
+  event.Category = category;
+  event.Name = name;
+  event.RendererName = GetRendererName(renderer);
+  event.NodeName = nodeName;
+  event.StartTime = startTime;
+  event.Duration = duration;
+  event.LevelOfDetail = levelOfDetail;
+
+  MutexHolder lock(m_Mutex);
+  this->AddEvent(event);
+}
+
+void mitk::RenderingProfiler::BeginFrame(const BaseRenderer *renderer)
+{
+  if (!this->GetEnabled())
+    return;
+
+  const double time = this->GetTime();
+
+  MutexHolder lock(m_Mutex);
+  m_FrameStartTimes[renderer] = time;
+}
+
+void mitk::RenderingProfiler::EndFrame(const BaseRenderer *renderer, int levelOfDetail)
+{
+  if (!this->GetEnabled())
+    return;
+
+  const double time = this->GetTime();
+  double startTime;
+  {
+    MutexHolder lock(m_Mutex);
+    auto iter = m_FrameStartTimes.find(renderer);
+    if (iter == m_FrameStartTimes.end())
+      return;
+
+    startTime = iter->second;
+    m_FrameStartTimes.erase(iter);
+  }
+
+  this->RecordEvent("Frame", "Frame", renderer, "", startTime, time - startTime, levelOfDetail);
+}
+
+void mitk::RenderingProfiler::RecordLevelOfDetailDecision(const BaseRenderer *renderer, int levelOfDetail)
+{
+  if (!this->GetEnabled())
+    return;
+
+  this->RecordEvent("LOD", "LOD " + std::to_string(levelOfDetail), renderer, "", this->GetTime(), 0.0, levelOfDetail);
+}
+
+std::vector<mitk::RenderingProfiler::Event> mitk::RenderingProfiler::GetEvents() const
+{
+  MutexHolder lock(m_Mutex);
+  return std::vector<Event>(m_Events.begin(), m_Events.end());
+}
+
+mitk::RenderingProfiler::TimingSummary mitk::RenderingProfiler::GetTimingSummary(const std::string &category,
+                                                                               const std::string &rendererName) const
+{
+  TimingSummary summary;
+
+  MutexHolder lock(m_Mutex);
+  for (const Event &event : m_Events)
+  {
+    if (event.Category == category && (rendererName.empty() || event.RendererName == rendererName))
+      AddToSummary(summary, event.Duration);
+  }
+
+  return summary;
+}
+
+std::map<std::string, mitk::RenderingProfiler::TimingSummary> mitk::RenderingProfiler::GetTimingSummariesPerNode(
+  const std::string &category, const std::string &rendererName) const
+{
+  std::map<std::string, TimingSummary> summaries;
+
+  MutexHolder lock(m_Mutex);
+  for (const Event &event : m_Events)
+  {
+    if (event.Category == category && (rendererName.empty() || event.RendererName == rendererName))
+      AddToSummary(summaries[event.NodeName], event.Duration);
+  }
+
+  return summaries;
+}
+
+std::map<std::string, mitk::RenderingProfiler::TimingSummary> mitk::RenderingProfiler::GetTimingSummariesPerRenderer(
+  const std::string &category) const
+{
+  std::map<std::string, TimingSummary> summaries;
+
+  MutexHolder lock(m_Mutex);
+  for (const Event &event : m_Events)
+  {
+    if (event.Category == category)
+      AddToSummary(summaries[event.RendererName], event.Duration);
+  }
+
+  return summaries;
+}
+
+void mitk::RenderingProfiler::WriteChromeTrace(std::ostream &stream) const
+{
+  const std::vector<Event> events = this->GetEvents();
+
+  // every renderer is shown as a thread of its own
+  std::map<std::string, unsigned int> threadIds;
+  for (const Event &event : events)
+    threadIds.insert(std::make_pair(event.RendererName, static_cast<unsigned int>(threadIds.size()) + 1));
+
+  stream << "{\"traceEvents\":[";
+
+  bool first = true;
+  for (const auto &threadId : threadIds)
+  {
+    stream << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId.second
+           << ",\"args\":{\"name\":";
+    WriteJSONString(stream, threadId.first.empty() ? std::string("(no renderer)") : threadId.first);
+    stream << "}}";
+    first = false;
+  }
+
+  const std::streamsize precision = stream.precision(3);
+  const std::ios_base::fmtflags flags = stream.setf(std::ios_base::fixed, std::ios_base::floatfield);
+
+  for (const Event &event : events)
+  {
+    stream << (first ? "\n" : ",\n") << "{\"name\":";
+    WriteJSONString(stream, event.NodeName.empty() ? event.Name : event.Name + " " + event.NodeName);
+    stream << ",\"cat\":";
+    WriteJSONString(stream, event.Category);
+    if (event.Duration > 0.0)
+      stream << ",\"ph\":\"X\",\"dur\":" << event.Duration;
+    else
+      stream << ",\"ph\":\"i\",\"s\":\"t\"";
+    stream << ",\"ts\":" << event.StartTime << ",\"pid\":1,\"tid\":" << threadIds[event.RendererName]
+           << ",\"args\":{\"renderer\":";
+    WriteJSONString(stream, event.RendererName);
+    stream << ",\"node\":";
+    WriteJSONString(stream, event.NodeName);
+    if (event.LevelOfDetail >= 0)
+      stream << ",\"lod\":" << event.LevelOfDetail;
+    stream << "}}";
+    first = false;
+  }
+
+  stream << "\n]}\n";
+
+  stream.precision(precision);
+  stream.flags(flags);
+}
+
+bool mitk::RenderingProfiler::WriteChromeTrace(const std::string &fileName) const
+{
+  std::ofstream file(fileName.c_str());
+  if (!file.is_open())
+    return false;
+
+  this->WriteChromeTrace(file);
+  return file.good();
+}
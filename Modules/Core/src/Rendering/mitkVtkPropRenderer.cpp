@@ -31,6 +31,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkPlaneGeometry.h>
 #include <mitkProperties.h>
 #include <mitkRenderingManager.h>
+#include <mitkRenderingProfiler.h>
 #include <mitkSurface.h>
 #include <mitkVtkInteractorStyle.h>
 
@@ -171,10 +172,13 @@ int mitk::VtkPropRenderer::Render(mitk::VtkPropRenderer::RenderType type)
   if (type == VtkPropRenderer::Opaque)
     this->PrepareMapperQueue();
 
+  static const char *renderTypeNames[] = {"Opaque", "Translucent", "Overlay", "Volumetric"};
+
   // go through the generated list and let the sorted mappers paint
   for (auto it = m_MappersMap.cbegin(); it != m_MappersMap.cend(); it++)
   {
     Mapper *mapper = (*it).second;
+    RenderingProfiler::ScopedEvent profilerEvent("Paint", renderTypeNames[type], this, mapper->GetDataNode());
     mapper->MitkRender(this, type);
   }
 
@@ -267,6 +271,7 @@ void mitk::VtkPropRenderer::Update(mitk::DataNode *datatreenode)
     {
       if (GetCurrentWorldPlaneGeometry()->IsValid())
       {
+        RenderingProfiler::ScopedEvent profilerEvent("Update", mapper->GetNameOfClass(), this, datatreenode);
         mapper->Update(this);
         {
           VtkMapper *vtkmapper = dynamic_cast<VtkMapper *>(mapper.GetPointer());
@@ -29,11 +29,31 @@ See LICENSE.txt or http://www.mitk.org for details.
 // used for acos etc.
 #include <cmath>
 
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
 // used for PI
 #include <itkMath.h>
 
 #include <mitkLogMacros.h>
 
+// SSE4.1 and AVX2 kernels for the linear lookup table, selected at runtime
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && \
+  (defined(__GNUC__) || defined(_MSC_VER))
+#define VTK_MITK_LEVEL_WINDOW_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define VTK_MITK_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#else
+#define VTK_MITK_TARGET(instructionSet)
+#endif
+#endif
+
 static const double PI = itk::Math::pi;
 
 vtkStandardNewMacro(vtkMitkLevelWindowFilter);
@@ -277,199 +297,620 @@ void vtkApplyLookupTableOnRGBA(vtkMitkLevelWindowFilter *self,
   }
 }
 
-// Internal method which should never be used anywhere else and should not be in th header.
+// Internal classes which should never be used anywhere else and should not be in th header.
 //----------------------------------------------------------------------------
-// This templated function executes the filter for any type of data.
+// The mappers below convert a scalar value into an RGBA pixel, which is returned
+// as a single int. MapSpan() maps a contiguous span of pixels without any
+// clipping checks.
+
+#ifdef VTK_MITK_LEVEL_WINDOW_SIMD
+
+// Instruction sets for which the kernels of the linear lookup table mapper are compiled.
+enum vtkLevelWindowInstructionSet
+{
+  VTK_LEVEL_WINDOW_SCALAR,
+  VTK_LEVEL_WINDOW_SSE41,
+  VTK_LEVEL_WINDOW_AVX2
+};
+
+static vtkLevelWindowInstructionSet vtkDetectLevelWindowInstructionSet()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  const bool sse41 = (info[2] & (1 << 19)) != 0;
+  // the AVX registers also have to be enabled by the operating system
+  const bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+  bool avx2 = false;
+  if (avx && maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  const bool sse41 = __builtin_cpu_supports("sse4.1");
+  const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+  if (avx2)
+    return VTK_LEVEL_WINDOW_AVX2;
+  if (sse41)
+    return VTK_LEVEL_WINDOW_SSE41;
+  return VTK_LEVEL_WINDOW_SCALAR;
+}
+
+static vtkLevelWindowInstructionSet vtkGetLevelWindowInstructionSet()
+{
+  static const vtkLevelWindowInstructionSet instructionSet = vtkDetectLevelWindowInstructionSet();
+  return instructionSet;
+}
+
+// Loading of 4 (SSE4.1) or 8 (AVX2) 16 bit pixels, converted to int.
+VTK_MITK_TARGET("sse4.1") static inline __m128i vtkLoadIntegersSSE41(const short *input)
+{
+  return _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(input)));
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128i vtkLoadIntegersSSE41(const unsigned short *input)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(input)));
+}
+
+VTK_MITK_TARGET("avx2") static inline __m256i vtkLoadIntegersAVX2(const short *input)
+{
+  return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input)));
+}
+
+VTK_MITK_TARGET("avx2") static inline __m256i vtkLoadIntegersAVX2(const unsigned short *input)
+{
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input)));
+}
+
+// Loading of 4 (SSE4.1) or 8 (AVX2) pixels, converted to float.
+VTK_MITK_TARGET("sse4.1") static inline __m128 vtkLoadSSE41(const short *input)
+{
+  return _mm_cvtepi32_ps(vtkLoadIntegersSSE41(input));
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128 vtkLoadSSE41(const unsigned short *input)
+{
+  return _mm_cvtepi32_ps(vtkLoadIntegersSSE41(input));
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128 vtkLoadSSE41(const int *input)
+{
+  return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input)));
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128 vtkLoadSSE41(const float *input)
+{
+  return _mm_loadu_ps(input);
+}
+
+VTK_MITK_TARGET("avx2") static inline __m256 vtkLoadAVX2(const short *input)
+{
+  return _mm256_cvtepi32_ps(vtkLoadIntegersAVX2(input));
+}
+
+VTK_MITK_TARGET("avx2") static inline __m256 vtkLoadAVX2(const unsigned short *input)
+{
+  return _mm256_cvtepi32_ps(vtkLoadIntegersAVX2(input));
+}
+
+VTK_MITK_TARGET("avx2") static inline __m256 vtkLoadAVX2(const int *input)
+{
+  return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input)));
+}
+
+VTK_MITK_TARGET("avx2") static inline __m256 vtkLoadAVX2(const float *input)
+{
+  return _mm256_loadu_ps(input);
+}
+
+// Same computation as vtkLinearLookupTableMapper::Map(). maxps returns its second
+// operand if the first one is NaN, so NaN is mapped to the first table entry as well.
+// Returns the number of mapped pixels, the remaining ones are mapped by the caller.
 template <class T>
-void vtkApplyLookupTableOnScalarsFast(
-  vtkMitkLevelWindowFilter *self, vtkImageData *inData, vtkImageData *outData, int outExt[6], T *)
+VTK_MITK_TARGET("sse4.1")
+int vtkMapLinearSpanSSE41(
+  const T *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
 {
-  vtkImageIterator<T> inputIt(inData, outExt);
-  vtkImageIterator<unsigned char> outputIt(outData, outExt);
+  const __m128 scaleVector = _mm_set1_ps(scale);
+  const __m128 biasVector = _mm_set1_ps(bias);
+  const __m128 zeroVector = _mm_setzero_ps();
+  const __m128 maxIndexVector = _mm_set1_ps(static_cast<float>(maxIndex));
 
-  double tableRange[2];
+  int i = 0;
+  for (; i + 4 <= length; i += 4)
+  {
+    __m128 index = _mm_add_ps(_mm_mul_ps(vtkLoadSSE41(input + i), scaleVector), biasVector);
+    index = _mm_min_ps(_mm_max_ps(index, zeroVector), maxIndexVector);
+
+    // there is no gather instruction before AVX2
+    const __m128i indices = _mm_cvttps_epi32(index);
+    output[i] = table[_mm_cvtsi128_si32(indices)];
+    output[i + 1] = table[_mm_extract_epi32(indices, 1)];
+    output[i + 2] = table[_mm_extract_epi32(indices, 2)];
+    output[i + 3] = table[_mm_extract_epi32(indices, 3)];
+  }
+  return i;
+}
 
-  // access vtkLookupTable
-  vtkLookupTable *lookupTable = dynamic_cast<vtkLookupTable *>(self->GetLookupTable());
-  lookupTable->GetTableRange(tableRange);
+template <class T>
+VTK_MITK_TARGET("avx2")
+int vtkMapLinearSpanAVX2(
+  const T *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
+{
+  const __m256 scaleVector = _mm256_set1_ps(scale);
+  const __m256 biasVector = _mm256_set1_ps(bias);
+  const __m256 zeroVector = _mm256_setzero_ps();
+  const __m256 maxIndexVector = _mm256_set1_ps(static_cast<float>(maxIndex));
 
-  // access elements of the vtkLookupTable
-  const int *realLookupTable = reinterpret_cast<int *>(lookupTable->GetTable()->GetPointer(0));
-  int maxIndex = lookupTable->GetNumberOfColors() - 1;
+  int i = 0;
+  for (; i + 8 <= length; i += 8)
+  {
+    __m256 index = _mm256_add_ps(_mm256_mul_ps(vtkLoadAVX2(input + i), scaleVector), biasVector);
+    index = _mm256_min_ps(_mm256_max_ps(index, zeroVector), maxIndexVector);
 
-  const float scale = (tableRange[1] - tableRange[0] > 0 ? (maxIndex + 1) / (tableRange[1] - tableRange[0]) : 0.0);
-  // ensuring that starting point is zero
-  float bias = -tableRange[0] * scale;
-  // due to later conversion to int for rounding
-  bias += 0.5f;
+    const __m256i colors = _mm256_i32gather_epi32(table, _mm256_cvttps_epi32(index), 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), colors);
+  }
+  return i;
+}
 
-  // Loop through ouput pixels
-  while (!outputIt.IsAtEnd())
+template <class T>
+int vtkMapLinearSpanDispatched(
+  const T *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
+{
+  switch (vtkGetLevelWindowInstructionSet())
   {
-    unsigned char *outputSI = outputIt.BeginSpan();
-    unsigned char *outputSIEnd = outputIt.EndSpan();
+    case VTK_LEVEL_WINDOW_AVX2:
+      return vtkMapLinearSpanAVX2(input, output, length, table, scale, bias, maxIndex);
+    case VTK_LEVEL_WINDOW_SSE41:
+      return vtkMapLinearSpanSSE41(input, output, length, table, scale, bias, maxIndex);
+    default:
+      return 0;
+  }
+}
 
-    T *inputSI = inputIt.BeginSpan();
+// Lookup of pixel - minimum in a table, see vtkValueRangeTableMapper.
+template <class T>
+VTK_MITK_TARGET("sse4.1")
+int vtkMapTableSpanSSE41(const T *input, int *output, int length, const int *table, int minimum)
+{
+  const __m128i minimumVector = _mm_set1_epi32(minimum);
 
-    while (outputSI != outputSIEnd)
-    {
-      // map to an index
-      int idx = static_cast<int>(*inputSI * scale + bias);
+  int i = 0;
+  for (; i + 4 <= length; i += 4)
+  {
+    const __m128i indices = _mm_sub_epi32(vtkLoadIntegersSSE41(input + i), minimumVector);
+    output[i] = table[_mm_cvtsi128_si32(indices)];
+    output[i + 1] = table[_mm_extract_epi32(indices, 1)];
+    output[i + 2] = table[_mm_extract_epi32(indices, 2)];
+    output[i + 3] = table[_mm_extract_epi32(indices, 3)];
+  }
+  return i;
+}
 
-      if (idx < 0)
-        idx = 0;
-      else if (idx > maxIndex)
-        idx = maxIndex;
+template <class T>
+VTK_MITK_TARGET("avx2")
+int vtkMapTableSpanAVX2(const T *input, int *output, int length, const int *table, int minimum)
+{
+  const __m256i minimumVector = _mm256_set1_epi32(minimum);
 
-      *reinterpret_cast<int *>(outputSI) = realLookupTable[idx];
+  int i = 0;
+  for (; i + 8 <= length; i += 8)
+  {
+    const __m256i indices = _mm256_sub_epi32(vtkLoadIntegersAVX2(input + i), minimumVector);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), _mm256_i32gather_epi32(table, indices, 4));
+  }
+  return i;
+}
 
-      inputSI++;
-      outputSI += 4;
-    }
+template <class T>
+int vtkMapTableSpanDispatched(const T *input, int *output, int length, const int *table, int minimum)
+{
+  switch (vtkGetLevelWindowInstructionSet())
+  {
+    case VTK_LEVEL_WINDOW_AVX2:
+      return vtkMapTableSpanAVX2(input, output, length, table, minimum);
+    case VTK_LEVEL_WINDOW_SSE41:
+      return vtkMapTableSpanSSE41(input, output, length, table, minimum);
+    default:
+      return 0;
+  }
+}
 
-    inputIt.NextSpan();
-    outputIt.NextSpan();
+// Minimum and maximum of 8 pixels at a time, which is fast enough with SSE4.1 for a single pass.
+VTK_MITK_TARGET("sse4.1") static inline __m128i vtkMinSSE41(__m128i a, __m128i b, short)
+{
+  return _mm_min_epi16(a, b);
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128i vtkMaxSSE41(__m128i a, __m128i b, short)
+{
+  return _mm_max_epi16(a, b);
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128i vtkMinSSE41(__m128i a, __m128i b, unsigned short)
+{
+  return _mm_min_epu16(a, b);
+}
+
+VTK_MITK_TARGET("sse4.1") static inline __m128i vtkMaxSSE41(__m128i a, __m128i b, unsigned short)
+{
+  return _mm_max_epu16(a, b);
+}
+
+template <class T>
+VTK_MITK_TARGET("sse4.1")
+int vtkScalarRangeOfSpanSSE41(const T *input, int length, T &minimum, T &maximum)
+{
+  __m128i minimumVector = _mm_set1_epi16(static_cast<short>(minimum));
+  __m128i maximumVector = _mm_set1_epi16(static_cast<short>(maximum));
+
+  int i = 0;
+  for (; i + 8 <= length; i += 8)
+  {
+    const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+    minimumVector = vtkMinSSE41(minimumVector, values, T());
+    maximumVector = vtkMaxSSE41(maximumVector, values, T());
   }
+
+  T minima[8];
+  T maxima[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(minima), minimumVector);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(maxima), maximumVector);
+  minimum = *std::min_element(minima, minima + 8);
+  maximum = *std::max_element(maxima, maxima + 8);
+  return i;
 }
 
-// Internal method which should never be used anywhere else and should not be in th header.
-//----------------------------------------------------------------------------
-// This templated function executes the filter for any type of data.
 template <class T>
-void vtkApplyLookupTableOnScalars(vtkMitkLevelWindowFilter *self,
-                                  vtkImageData *inData,
-                                  vtkImageData *outData,
-                                  int outExt[6],
-                                  double *clippingBounds,
-                                  T *)
+int vtkScalarRangeOfSpanDispatched(const T *input, int length, T &minimum, T &maximum)
 {
-  vtkImageIterator<T> inputIt(inData, outExt);
-  vtkImageIterator<unsigned char> outputIt(outData, outExt);
-  vtkScalarsToColors *lookupTable = self->GetLookupTable();
+  if (vtkGetLevelWindowInstructionSet() == VTK_LEVEL_WINDOW_SCALAR)
+    return 0;
+  return vtkScalarRangeOfSpanSSE41(input, length, minimum, maximum);
+}
 
-  int y = outExt[2];
+#endif
 
-  // Loop through ouput pixels
-  while (!outputIt.IsAtEnd())
+// Vectorized part of vtkLinearLookupTableMapper::MapSpan(). Only the common pixel
+// types of CT and MR images have kernels, all other types are mapped by the caller.
+template <class T>
+int vtkMapLinearSpan(const T *, int *, int, const int *, float, float, int)
+{
+  return 0;
+}
+
+#ifdef VTK_MITK_LEVEL_WINDOW_SIMD
+static int vtkMapLinearSpan(
+  const short *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
+{
+  return vtkMapLinearSpanDispatched(input, output, length, table, scale, bias, maxIndex);
+}
+
+static int vtkMapLinearSpan(
+  const unsigned short *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
+{
+  return vtkMapLinearSpanDispatched(input, output, length, table, scale, bias, maxIndex);
+}
+
+static int vtkMapLinearSpan(
+  const int *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
+{
+  return vtkMapLinearSpanDispatched(input, output, length, table, scale, bias, maxIndex);
+}
+
+static int vtkMapLinearSpan(
+  const float *input, int *output, int length, const int *table, float scale, float bias, int maxIndex)
+{
+  return vtkMapLinearSpanDispatched(input, output, length, table, scale, bias, maxIndex);
+}
+#endif
+
+// Vectorized parts of vtkValueRangeTableMapper, which is only used for 16 bit pixels.
+template <class T>
+int vtkMapTableSpan(const T *, int *, int, const int *, int)
+{
+  return 0;
+}
+
+template <class T>
+int vtkScalarRangeOfSpan(const T *, int, T &, T &)
+{
+  return 0;
+}
+
+#ifdef VTK_MITK_LEVEL_WINDOW_SIMD
+static int vtkMapTableSpan(const short *input, int *output, int length, const int *table, int minimum)
+{
+  return vtkMapTableSpanDispatched(input, output, length, table, minimum);
+}
+
+static int vtkMapTableSpan(const unsigned short *input, int *output, int length, const int *table, int minimum)
+{
+  return vtkMapTableSpanDispatched(input, output, length, table, minimum);
+}
+
+static int vtkScalarRangeOfSpan(const short *input, int length, short &minimum, short &maximum)
+{
+  return vtkScalarRangeOfSpanDispatched(input, length, minimum, maximum);
+}
+
+static int vtkScalarRangeOfSpan(const unsigned short *input, int length, unsigned short &minimum, unsigned short &maximum)
+{
+  return vtkScalarRangeOfSpanDispatched(input, length, minimum, maximum);
+}
+#endif
+
+// Mapping through the table of a vtkLookupTable with linear scale, only used for
+// unclipped slices. In contrast to vtkLookupTable::MapValue(), values are rounded
+// to the nearest table index and the below and above range colors are not supported.
+template <class T>
+class vtkLinearLookupTableMapper
+{
+public:
+  explicit vtkLinearLookupTableMapper(vtkLookupTable *lookupTable)
+    : m_Table(reinterpret_cast<const int *>(lookupTable->GetTable()->GetPointer(0))),
+      m_MaxIndex(lookupTable->GetNumberOfColors() - 1)
   {
-    unsigned char *outputSI = outputIt.BeginSpan();
-    unsigned char *outputSIEnd = outputIt.EndSpan();
+    double tableRange[2];
+    lookupTable->GetTableRange(tableRange);
+
+    m_Scale = (tableRange[1] - tableRange[0] > 0 ? (m_MaxIndex + 1) / (tableRange[1] - tableRange[0]) : 0.0);
+    // ensuring that starting point is zero
+    m_Bias = -tableRange[0] * m_Scale;
+    // due to later conversion to int for rounding
+    m_Bias += 0.5f;
+  }
 
-    // do we iterate over the inner vertical clipping bounds
-    if (y >= clippingBounds[2] && y < clippingBounds[3])
-    {
-      T *inputSI = inputIt.BeginSpan();
+  int Map(T value) const
+  {
+    // float precision is sufficient for the index, only double input is mapped in double
+    typedef typename std::conditional<std::is_same<T, double>::value, double, float>::type ComputeType;
+
+    // clamping before the conversion to int also maps NaN to the first table entry
+    ComputeType index = static_cast<ComputeType>(value) * m_Scale + m_Bias;
+    index = (index > 0 ? index : 0);
+    index = (index < m_MaxIndex ? index : m_MaxIndex);
+    return m_Table[static_cast<int>(index)];
+  }
 
-      int x = outExt[0];
+  void MapSpan(const T *input, int *output, int length) const
+  {
+    int i = vtkMapLinearSpan(input, output, length, m_Table, m_Scale, m_Bias, m_MaxIndex);
+    for (; i < length; ++i)
+      output[i] = this->Map(input[i]);
+  }
 
-      while (outputSI != outputSIEnd)
-      {
-        // is this pixel within horizontal clipping bounds
-        if (x >= clippingBounds[0] && x < clippingBounds[1])
-        {
-          // fetching original value
-          double grayValue = static_cast<double>(*inputSI);
-          // applying lookuptable - copy the 4 (RGBA) chars as a single int
-          *reinterpret_cast<int *>(outputSI) = *reinterpret_cast<int *>(lookupTable->MapValue(grayValue));
-        }
-        else
-        {
-          // outer horizontal clipping bounds - write a transparent RGBA pixel as a single int
-          *reinterpret_cast<int *>(outputSI) = 0;
-        }
+private:
+  const int *m_Table;
+  int m_MaxIndex;
+  float m_Scale;
+  float m_Bias;
+};
 
-        inputSI++;
-        outputSI += 4;
-        x++;
-      }
+// Mapping through any vtkScalarsToColors, e.g. a vtkLookupTable with logarithmic scale.
+// Also used for clipped slices, so their colors are exactly the ones of VTK.
+template <class T>
+class vtkScalarsToColorsMapper
+{
+public:
+  explicit vtkScalarsToColorsMapper(vtkScalarsToColors *lookupTable) : m_LookupTable(lookupTable) {}
+
+  int Map(T value) const
+  {
+    // copy the 4 (RGBA) chars as a single int
+    return *reinterpret_cast<const int *>(m_LookupTable->MapValue(static_cast<double>(value)));
+  }
+
+  void MapSpan(const T *input, int *output, int length) const
+  {
+    for (int i = 0; i < length; ++i)
+      output[i] = this->Map(input[i]);
+  }
+
+private:
+  vtkScalarsToColors *m_LookupTable;
+};
+
+// Mapping through a vtkColorTransferFunction and an optional opacity function.
+template <class T>
+class vtkColorTransferFunctionMapper
+{
+public:
+  vtkColorTransferFunctionMapper(vtkColorTransferFunction *colorTransferFunction, vtkPiecewiseFunction *opacityFunction)
+    : m_ColorTransferFunction(colorTransferFunction), m_OpacityFunction(opacityFunction)
+  {
+  }
+
+  int Map(T value) const
+  {
+    const double grayValue = static_cast<double>(value);
+
+    // applying directly colortransferfunction
+    // because vtkColorTransferFunction::MapValue is not threadsafe
+    double rgba[4];
+    m_ColorTransferFunction->GetColor(grayValue, rgba); // RGB mapping
+    rgba[3] = 1.0;
+    if (m_OpacityFunction)
+      rgba[3] = m_OpacityFunction->GetValue(grayValue); // Alpha mapping
+
+    unsigned char color[4];
+    for (int i = 0; i < 4; ++i)
+    {
+      color[i] = static_cast<unsigned char>(255.0 * rgba[i] + 0.5);
     }
-    else
+
+    int result;
+    std::memcpy(&result, color, sizeof(int));
+    return result;
+  }
+
+  void MapSpan(const T *input, int *output, int length) const
+  {
+    for (int i = 0; i < length; ++i)
+      output[i] = this->Map(input[i]);
+  }
+
+private:
+  vtkColorTransferFunction *m_ColorTransferFunction;
+  vtkPiecewiseFunction *m_OpacityFunction;
+};
+
+// For 8 bit input there are less possible values than pixels in a slice, so the
+// result of another mapper is computed once for each value and looked up afterwards.
+template <class T, class TMapper>
+class vtkByteTableMapper
+{
+public:
+  explicit vtkByteTableMapper(const TMapper &mapper)
+  {
+    for (int i = 0; i < 256; ++i)
+      m_Table[i] = mapper.Map(static_cast<T>(static_cast<unsigned char>(i)));
+  }
+
+  int Map(T value) const { return m_Table[static_cast<unsigned char>(value)]; }
+
+  void MapSpan(const T *input, int *output, int length) const
+  {
+    for (int i = 0; i < length; ++i)
+      output[i] = m_Table[static_cast<unsigned char>(input[i])];
+  }
+
+private:
+  int m_Table[256];
+};
+
+// For 16 bit input the pixels of a slice usually take much less values than there are
+// pixels, e.g. 4096 in CT. Like vtkByteTableMapper, the result of another mapper is
+// computed once for each value between the minimum and maximum of the slice.
+template <class T, class TMapper>
+class vtkValueRangeTableMapper
+{
+public:
+  vtkValueRangeTableMapper(const TMapper &mapper, T minimum, T maximum)
+    : m_Minimum(minimum), m_Table(static_cast<int>(maximum) - static_cast<int>(minimum) + 1)
+  {
+    for (std::size_t i = 0; i < m_Table.size(); ++i)
+      m_Table[i] = mapper.Map(static_cast<T>(m_Minimum + static_cast<int>(i)));
+  }
+
+  int Map(T value) const { return m_Table[static_cast<int>(value) - m_Minimum]; }
+
+  void MapSpan(const T *input, int *output, int length) const
+  {
+    int i = vtkMapTableSpan(input, output, length, m_Table.data(), m_Minimum);
+    for (; i < length; ++i)
+      output[i] = this->Map(input[i]);
+  }
+
+private:
+  int m_Minimum;
+  std::vector<int> m_Table;
+};
+
+// The linear lookup table mapper is vectorized itself, so it is never tabulated for 16 bit input.
+template <class TMapper>
+struct vtkIsLinearLookupTableMapper : std::false_type
+{
+};
+
+template <class T>
+struct vtkIsLinearLookupTableMapper<vtkLinearLookupTableMapper<T>> : std::true_type
+{
+};
+
+// How vtkApplyMapperOnScalars() maps the pixels.
+enum vtkMapperTabulation
+{
+  VTK_MAP_EACH_PIXEL,
+  VTK_MAP_BYTE_TABLE,
+  VTK_MAP_VALUE_RANGE_TABLE
+};
+
+template <class T, class TMapper>
+struct vtkMapperTabulationOf
+  : std::integral_constant<int,
+                           sizeof(T) == 1 ? VTK_MAP_BYTE_TABLE
+                                          : (std::is_integral<T>::value && sizeof(T) == 2 &&
+                                             !vtkIsLinearLookupTableMapper<TMapper>::value)
+                                              ? VTK_MAP_VALUE_RANGE_TABLE
+                                              : VTK_MAP_EACH_PIXEL>
+{
+};
+
+// Minimum and maximum of the pixels in the given extent.
+template <class T>
+void vtkGetScalarRange(vtkImageData *inData, int outExt[6], T &minimum, T &maximum)
+{
+  vtkImageIterator<T> inputIt(inData, outExt);
+  minimum = maximum = T();
+  if (inputIt.IsAtEnd())
+    return;
+
+  minimum = maximum = *inputIt.BeginSpan();
+  while (!inputIt.IsAtEnd())
+  {
+    const T *span = inputIt.BeginSpan();
+    const int length = static_cast<int>(inputIt.EndSpan() - span);
+
+    int i = vtkScalarRangeOfSpan(span, length, minimum, maximum);
+    for (; i < length; ++i)
     {
-      // outer vertical clipping bounds - write a transparent RGBA line as ints
-      while (outputSI != outputSIEnd)
-      {
-        *reinterpret_cast<int *>(outputSI) = 0;
-        outputSI += 4;
-      }
+      minimum = std::min(minimum, span[i]);
+      maximum = std::max(maximum, span[i]);
     }
 
     inputIt.NextSpan();
-    outputIt.NextSpan();
-    y++;
   }
 }
 
 // Internal method which should never be used anywhere else and should not be in th header.
 //----------------------------------------------------------------------------
-// This templated function executes the filter for any type of data.
-template <class T>
-void vtkApplyLookupTableOnScalarsCTF(vtkMitkLevelWindowFilter *self,
-                                     vtkImageData *inData,
-                                     vtkImageData *outData,
-                                     int outExt[6],
-                                     double *clippingBounds,
-                                     T *)
+// Applies the given mapper to all pixels inside of the clipping bounds,
+// all other pixels are set to transparent.
+template <class T, class TMapper>
+void vtkApplyMapperOnScalarSpans(
+  vtkImageData *inData, vtkImageData *outData, int outExt[6], double *clippingBounds, const TMapper &mapper)
 {
   vtkImageIterator<T> inputIt(inData, outExt);
   vtkImageIterator<unsigned char> outputIt(outData, outExt);
-  vtkColorTransferFunction *lookupTable = dynamic_cast<vtkColorTransferFunction *>(self->GetLookupTable());
-  vtkPiecewiseFunction *opacityFunction = self->GetOpacityPiecewiseFunction();
+
+  // horizontal clipping bounds are the same for every span: pixel x is mapped
+  // if clippingBounds[0] <= x < clippingBounds[1]
+  const int spanLength = outExt[1] - outExt[0] + 1;
+  const int mappedBegin =
+    std::min(spanLength, std::max(0, static_cast<int>(std::ceil(clippingBounds[0])) - outExt[0]));
+  const int mappedEnd =
+    std::min(spanLength, std::max(mappedBegin, static_cast<int>(std::ceil(clippingBounds[1])) - outExt[0]));
 
   int y = outExt[2];
 
   // Loop through ouput pixels
   while (!outputIt.IsAtEnd())
   {
-    unsigned char *outputSI = outputIt.BeginSpan();
-    unsigned char *outputSIEnd = outputIt.EndSpan();
+    int *outputSI = reinterpret_cast<int *>(outputIt.BeginSpan());
 
     // do we iterate over the inner vertical clipping bounds
     if (y >= clippingBounds[2] && y < clippingBounds[3])
     {
-      T *inputSI = inputIt.BeginSpan();
+      const T *inputSI = inputIt.BeginSpan();
 
-      int x = outExt[0];
-
-      while (outputSI != outputSIEnd)
-      {
-        // is this pixel within horizontal clipping bounds
-        if (x >= clippingBounds[0] && x < clippingBounds[1])
-        {
-          // fetching original value
-          double grayValue = static_cast<double>(*inputSI);
-
-          // applying directly colortransferfunction
-          // because vtkColorTransferFunction::MapValue is not threadsafe
-          double rgba[4];
-          lookupTable->GetColor(grayValue, rgba); // RGB mapping
-          rgba[3] = 1.0;
-          if (opacityFunction)
-            rgba[3] = opacityFunction->GetValue(grayValue); // Alpha mapping
-
-          for (int i = 0; i < 4; ++i)
-          {
-            outputSI[i] = static_cast<unsigned char>(255.0 * rgba[i] + 0.5);
-          }
-        }
-        else
-        {
-          // outer horizontal clipping bounds - write a transparent RGBA pixel as a single int
-          *reinterpret_cast<int *>(outputSI) = 0;
-        }
-
-        inputSI++;
-        outputSI += 4;
-        x++;
-      }
+      // outer horizontal clipping bounds - write transparent RGBA pixels as ints
+      std::fill(outputSI, outputSI + mappedBegin, 0);
+      mapper.MapSpan(inputSI + mappedBegin, outputSI + mappedBegin, mappedEnd - mappedBegin);
+      std::fill(outputSI + mappedEnd, outputSI + spanLength, 0);
     }
     else
     {
       // outer vertical clipping bounds - write a transparent RGBA line as ints
-      while (outputSI != outputSIEnd)
-      {
-        *reinterpret_cast<int *>(outputSI) = 0;
-        outputSI += 4;
-      }
+      std::fill(outputSI, outputSI + spanLength, 0);
     }
 
     inputIt.NextSpan();
@@ -478,6 +919,70 @@ void vtkApplyLookupTableOnScalarsCTF(vtkMitkLevelWindowFilter *self,
   }
 }
 
+template <class T, class TMapper>
+void vtkApplyMapperOnScalars(vtkImageData *inData,
+                             vtkImageData *outData,
+                             int outExt[6],
+                             double *clippingBounds,
+                             const TMapper &mapper,
+                             std::integral_constant<int, VTK_MAP_EACH_PIXEL>)
+{
+  vtkApplyMapperOnScalarSpans<T>(inData, outData, outExt, clippingBounds, mapper);
+}
+
+template <class T, class TMapper>
+void vtkApplyMapperOnScalars(vtkImageData *inData,
+                             vtkImageData *outData,
+                             int outExt[6],
+                             double *clippingBounds,
+                             const TMapper &mapper,
+                             std::integral_constant<int, VTK_MAP_BYTE_TABLE>)
+{
+  vtkApplyMapperOnScalarSpans<T>(
+    inData, outData, outExt, clippingBounds, vtkByteTableMapper<T, TMapper>(mapper));
+}
+
+template <class T, class TMapper>
+void vtkApplyMapperOnScalars(vtkImageData *inData,
+                             vtkImageData *outData,
+                             int outExt[6],
+                             double *clippingBounds,
+                             const TMapper &mapper,
+                             std::integral_constant<int, VTK_MAP_VALUE_RANGE_TABLE>)
+{
+  T minimum, maximum;
+  vtkGetScalarRange(inData, outExt, minimum, maximum);
+
+  // the table only pays off if there are less values than pixels
+  const long numberOfValues = static_cast<long>(maximum) - static_cast<long>(minimum) + 1;
+  const long numberOfPixels = static_cast<long>(outExt[1] - outExt[0] + 1) * (outExt[3] - outExt[2] + 1) *
+                              (outExt[5] - outExt[4] + 1);
+  if (numberOfValues < numberOfPixels)
+  {
+    vtkApplyMapperOnScalarSpans<T>(
+      inData, outData, outExt, clippingBounds, vtkValueRangeTableMapper<T, TMapper>(mapper, minimum, maximum));
+  }
+  else
+  {
+    vtkApplyMapperOnScalarSpans<T>(inData, outData, outExt, clippingBounds, mapper);
+  }
+}
+
+// Internal method which should never be used anywhere else and should not be in th header.
+//----------------------------------------------------------------------------
+// This templated function executes the filter for any type of data.
+template <class T, class TMapper>
+void vtkApplyMapperOnScalars(
+  vtkImageData *inData, vtkImageData *outData, int outExt[6], double *clippingBounds, const TMapper &mapper, T *)
+{
+  vtkApplyMapperOnScalars<T>(inData,
+                             outData,
+                             outExt,
+                             clippingBounds,
+                             mapper,
+                             std::integral_constant<int, vtkMapperTabulationOf<T, TMapper>::value>());
+}
+
 int vtkMitkLevelWindowFilter::RequestInformation(vtkInformation *request,
                                                  vtkInformationVector **inputVector,
                                                  vtkInformationVector *outputVector)
@@ -517,7 +1022,8 @@ void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageDat
     vtkLookupTable *vlt = dynamic_cast<vtkLookupTable *>(this->GetLookupTable());
     vtkColorTransferFunction *ctf = dynamic_cast<vtkColorTransferFunction *>(this->GetLookupTable());
 
-    bool linearLookupTable = vlt && vlt->GetScale() == VTK_SCALE_LINEAR;
+    bool linearLookupTable = vlt && vlt->GetScale() == VTK_SCALE_LINEAR && !vlt->GetUseBelowRangeColor() &&
+                             !vlt->GetUseAboveRangeColor();
 
     bool useFast = dontClip && linearLookupTable;
 
@@ -525,8 +1031,12 @@ void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageDat
     {
       switch (inData->GetScalarType())
       {
-        vtkTemplateMacro(vtkApplyLookupTableOnScalarsCTF(
-          this, inData, outData, extent, m_ClippingBounds, static_cast<VTK_TT *>(nullptr)));
+        vtkTemplateMacro(vtkApplyMapperOnScalars(inData,
+                                                 outData,
+                                                 extent,
+                                                 m_ClippingBounds,
+                                                 vtkColorTransferFunctionMapper<VTK_TT>(ctf, m_OpacityFunction),
+                                                 static_cast<VTK_TT *>(nullptr)));
         default:
           vtkErrorMacro(<< "Execute: Unknown ScalarType");
           return;
@@ -536,8 +1046,12 @@ void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageDat
     {
       switch (inData->GetScalarType())
       {
-        vtkTemplateMacro(
-          vtkApplyLookupTableOnScalarsFast(this, inData, outData, extent, static_cast<VTK_TT *>(nullptr)));
+        vtkTemplateMacro(vtkApplyMapperOnScalars(inData,
+                                                 outData,
+                                                 extent,
+                                                 m_ClippingBounds,
+                                                 vtkLinearLookupTableMapper<VTK_TT>(vlt),
+                                                 static_cast<VTK_TT *>(nullptr)));
         default:
           vtkErrorMacro(<< "Execute: Unknown ScalarType");
           return;
@@ -547,8 +1061,12 @@ void vtkMitkLevelWindowFilter::ThreadedExecute(vtkImageData *inData, vtkImageDat
     {
       switch (inData->GetScalarType())
       {
-        vtkTemplateMacro(vtkApplyLookupTableOnScalars(
-          this, inData, outData, extent, m_ClippingBounds, static_cast<VTK_TT *>(nullptr)));
+        vtkTemplateMacro(vtkApplyMapperOnScalars(inData,
+                                                 outData,
+                                                 extent,
+                                                 m_ClippingBounds,
+                                                 vtkScalarsToColorsMapper<VTK_TT>(this->GetLookupTable()),
+                                                 static_cast<VTK_TT *>(nullptr)));
         default:
           vtkErrorMacro(<< "Execute: Unknown ScalarType");
           return;
@@ -536,6 +536,66 @@ void TestDataStorage(mitk::DataStorage *ds, std::string filename)
     MITK_TEST_CONDITION(ds->GetNamedDerivedNode("Node 3 - Empty Node", n1, true) == nullptr,
                         "Checking GetNamedDerivedNode with valid Name but direct derivation only");
 
+    /* Checking that the node index follows name changes */
+    {
+      n5->SetName("Node 5 - Renamed");
+      MITK_TEST_CONDITION(ds->GetNamedNode("Node 5 - Renamed") == n5 && ds->GetNamedNode("Node 5") == nullptr,
+                          "Checking named node method after SetName()");
+
+      auto nameProperty = dynamic_cast<mitk::StringProperty *>(n5->GetProperty("name"));
+      MITK_TEST_CONDITION_REQUIRED(nameProperty != nullptr, "Checking name property of renamed node");
+      nameProperty->SetValue("Node 5");
+      MITK_TEST_CONDITION(ds->GetNamedNode("Node 5") == n5 && ds->GetNamedNode("Node 5 - Renamed") == nullptr,
+                          "Checking named node method after changing the name property in place");
+    }
+
+    /* Checking GetSubset with an additionally indexed property key */
+    {
+      ds->AddIndexedPropertyKey("Resection Proposal 2");
+      MITK_TEST_CONDITION(ds->GetIndexedPropertyKeys().count("Resection Proposal 2") == 1,
+                          "Checking AddIndexedPropertyKey()");
+
+      mitk::NodePredicateProperty::Pointer proposal2 = mitk::NodePredicateProperty::New("Resection Proposal 2");
+      mitk::DataStorage::SetOfObjects::ConstPointer all = ds->GetSubset(proposal2);
+      std::vector<mitk::DataNode::Pointer> stlAll = all->CastToSTLConstContainer();
+      MITK_TEST_CONDITION((all->Size() == 2) && (std::find(stlAll.begin(), stlAll.end(), n3) != stlAll.end()) &&
+                            (std::find(stlAll.begin(), stlAll.end(), n4) != stlAll.end()),
+                          "Checking GetSubset() with indexed property key");
+
+      n4->GetPropertyList()->DeleteProperty("Resection Proposal 2");
+      MITK_TEST_CONDITION(ds->GetSubset(proposal2)->Size() == 1, "Checking GetSubset() after removing an indexed property");
+      n4->SetProperty("Resection Proposal 2", mitk::GroupTagProperty::New());
+      MITK_TEST_CONDITION(ds->GetSubset(proposal2)->Size() == 2, "Checking GetSubset() after adding an indexed property");
+
+      mitk::NodePredicateAnd::Pointer imageAndName = mitk::NodePredicateAnd::New(
+        mitk::NodePredicateDataType::New("Image"),
+        mitk::NodePredicateProperty::New("name", mitk::StringProperty::New("Node 1 - Image Node")));
+      all = ds->GetSubset(imageAndName);
+      MITK_TEST_CONDITION((all->Size() == 1) && (all->GetElement(0) == n1),
+                          "Checking GetSubset() with conjunction of indexed predicates");
+
+      ds->RemoveIndexedPropertyKey("Resection Proposal 2");
+      MITK_TEST_CONDITION(ds->GetSubset(proposal2)->Size() == 2, "Checking GetSubset() after RemoveIndexedPropertyKey()");
+    }
+
+    /* Checking that GetSubset() with an indexed key returns the same nodes as a linear scan */
+    {
+      n1->GetData()->SetProperty("name", mitk::StringProperty::New("Data of Node 1"));
+      mitk::NodePredicateProperty::Pointer dataName =
+        mitk::NodePredicateProperty::New("name", mitk::StringProperty::New("Data of Node 1"));
+
+      unsigned int expectedSize = 0;
+      mitk::DataStorage::SetOfObjects::ConstPointer all = ds->GetAll();
+      for (auto it = all->Begin(); it != all->End(); ++it)
+      {
+        if (dataName->CheckNode(it->Value()))
+          ++expectedSize;
+      }
+      MITK_TEST_CONDITION(ds->GetSubset(dataName)->Size() == expectedSize,
+                          "Checking GetSubset() with a property of the data against a linear scan");
+      n1->GetData()->GetPropertyList()->DeleteProperty("name");
+    }
+
     /* Checking GetNode with valid predicate */
     {
       mitk::NodePredicateDataType::Pointer p(mitk::NodePredicateDataType::New("Image"));
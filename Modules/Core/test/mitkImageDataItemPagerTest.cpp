@@ -0,0 +1,134 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <mitkImage.h>
+#include <mitkImageDataItemPager.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+
+class mitkImageDataItemPagerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageDataItemPagerTestSuite);
+  MITK_TEST(Allocate_Disabled_ReturnsNullptr);
+  MITK_TEST(Allocate_BelowMinimumSize_ReturnsNullptr);
+  MITK_TEST(Image_Paged_KeepsDataAfterEviction);
+  MITK_TEST(Touch_ExceedingBudget_EvictsLeastRecentlyUsed);
+  MITK_TEST(Touch_OverlappingRegions_CountedOnce);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::ImageDataItemPager *m_Pager;
+
+  mitk::Image::Pointer CreateTimeSeries(unsigned int timeSteps)
+  {
+    unsigned int dimensions[4] = {64, 64, 16, timeSteps};
+    auto image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<unsigned short>(), 4, dimensions);
+    return image;
+  }
+
+public:
+  void setUp() override
+  {
+    m_Pager = mitk::ImageDataItemPager::GetInstance();
+    m_Pager->SetEnabled(true);
+    m_Pager->SetMinimumPagedSize(1024);
+    m_Pager->SetMemoryBudget(1024 * 1024 * 1024);
+  }
+
+  void tearDown() override
+  {
+    m_Pager->SetEnabled(false);
+    m_Pager->SetMinimumPagedSize(64 * 1024 * 1024);
+  }
+
+  void Allocate_Disabled_ReturnsNullptr()
+  {
+    m_Pager->SetEnabled(false);
+    CPPUNIT_ASSERT(m_Pager->Allocate(1024 * 1024) == nullptr);
+  }
+
+  void Allocate_BelowMinimumSize_ReturnsNullptr()
+  {
+    CPPUNIT_ASSERT(m_Pager->Allocate(512) == nullptr);
+  }
+
+  void Image_Paged_KeepsDataAfterEviction()
+  {
+    auto image = this->CreateTimeSeries(2);
+
+    {
+      mitk::ImageWriteAccessor writeAccessor(image, image->GetVolumeData(1));
+      auto data = static_cast<unsigned short *>(writeAccessor.GetData());
+      for (unsigned int i = 0; i < 64 * 64 * 16; ++i)
+        data[i] = static_cast<unsigned short>(i % 4096);
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Volume should be backed by a swap file", image->GetVolumeData(1)->IsPagedMemory());
+
+    mitk::ImageReadAccessor firstAccessor(image, image->GetVolumeData(1));
+    m_Pager->Evict(static_cast<const unsigned char *>(firstAccessor.GetData()), image->GetVolumeData(1)->GetSize());
+
+    mitk::ImageReadAccessor readAccessor(image, image->GetVolumeData(1));
+    auto data = static_cast<const unsigned short *>(readAccessor.GetData());
+    for (unsigned int i = 0; i < 64 * 64 * 16; ++i)
+    {
+      if (data[i] != static_cast<unsigned short>(i % 4096))
+        CPPUNIT_FAIL("Pixel data changed after eviction");
+    }
+  }
+
+  void Touch_ExceedingBudget_EvictsLeastRecentlyUsed()
+  {
+    auto image = this->CreateTimeSeries(4);
+    const size_t volumeSize = image->GetVolumeData(0)->GetSize();
+
+    m_Pager->SetMemoryBudget(2 * volumeSize);
+
+    for (unsigned int t = 0; t < 4; ++t)
+    {
+      mitk::ImageReadAccessor accessor(image, image->GetVolumeData(t));
+    }
+
+    CPPUNIT_ASSERT(m_Pager->GetResidentSize() <= 2 * volumeSize);
+  }
+
+  void Touch_OverlappingRegions_CountedOnce()
+  {
+    auto image = this->CreateTimeSeries(2);
+    const size_t volumeSize = image->GetVolumeData(0)->GetSize();
+    const size_t residentSize = m_Pager->GetResidentSize();
+
+    mitk::ImageReadAccessor seriesAccessor(image);
+    auto data = static_cast<const unsigned char *>(seriesAccessor.GetData());
+    CPPUNIT_ASSERT_EQUAL(residentSize + 2 * volumeSize, m_Pager->GetResidentSize());
+
+    // volumes, slices and regions across the volume border are part of the touched series
+    m_Pager->Touch(data, volumeSize);
+    m_Pager->Touch(data + volumeSize, volumeSize);
+    m_Pager->Touch(data + volumeSize / 2, volumeSize);
+    m_Pager->Touch(data + 100, 64 * 64 * 2);
+    CPPUNIT_ASSERT_EQUAL(residentSize + 2 * volumeSize, m_Pager->GetResidentSize());
+
+    m_Pager->Evict(data, 2 * volumeSize);
+    CPPUNIT_ASSERT_EQUAL(residentSize, m_Pager->GetResidentSize());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageDataItemPager)
@@ -0,0 +1,252 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <mitkImage.h>
+#include <mitkImagePixelReadAccessor.h>
+#include <mitkImagePixelSampler.h>
+#include <mitkImageWriteAccessor.h>
+
+#include <itkTimeProbe.h>
+
+#include <cstdlib>
+#include <vector>
+
+class mitkImagePixelSamplerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImagePixelSamplerTestSuite);
+  MITK_TEST(NearestNeighbor_Index_EqualsPixelAccessor);
+  MITK_TEST(NearestNeighbor_WorldCoordinate_EqualsGetPixelValueByWorldCoordinate);
+  MITK_TEST(Trilinear_BetweenPixels_InterpolatesLinearFunction);
+  MITK_TEST(Outside_ReturnsOutsideValue);
+  MITK_TEST(TimeStepAndComponent_SampledFromCorrectPart);
+  MITK_TEST(InvalidArguments_Throw);
+  MITK_TEST(SampleByWorldCoordinate_Performance);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::Image::Pointer m_Image;
+
+  /** Image with value x + 10 * y + 100 * z + 1000 * t + 10000 * c, i.e. linear in the index. */
+  template <typename TPixel>
+  mitk::Image::Pointer CreateLinearImage(unsigned int timeSteps, unsigned int components)
+  {
+    unsigned int dimensions[4] = {8, 7, 6, timeSteps};
+    auto image = mitk::Image::New();
+    if (components == 1)
+    {
+      image->Initialize(mitk::MakeScalarPixelType<TPixel>(), 4, dimensions);
+    }
+    else
+    {
+      image->Initialize(mitk::MakePixelType<itk::VectorImage<TPixel, 3>>(components), 4, dimensions);
+    }
+
+    mitk::ImageWriteAccessor accessor(image);
+    auto data = static_cast<TPixel *>(accessor.GetData());
+    for (unsigned int t = 0; t < dimensions[3]; ++t)
+      for (unsigned int z = 0; z < dimensions[2]; ++z)
+        for (unsigned int y = 0; y < dimensions[1]; ++y)
+          for (unsigned int x = 0; x < dimensions[0]; ++x)
+            for (unsigned int c = 0; c < components; ++c)
+              *data++ = static_cast<TPixel>(x + 10 * y + 100 * z + 1000 * t + 10000 * c);
+
+    return image;
+  }
+
+public:
+  void setUp() override
+  {
+    m_Image = this->CreateLinearImage<short>(1, 1);
+
+    mitk::Vector3D spacing;
+    spacing[0] = 0.5;
+    spacing[1] = 2.0;
+    spacing[2] = 3.0;
+    m_Image->GetGeometry()->SetSpacing(spacing);
+
+    mitk::Point3D origin;
+    origin[0] = -10.0;
+    origin[1] = 5.0;
+    origin[2] = 1.0;
+    m_Image->GetGeometry()->SetOrigin(origin);
+  }
+
+  void tearDown() override { m_Image = nullptr; }
+
+  void NearestNeighbor_Index_EqualsPixelAccessor()
+  {
+    std::vector<mitk::Point3D> indices;
+    std::vector<itk::Index<3>> discreteIndices;
+    for (unsigned int i = 0; i < 200; ++i)
+    {
+      mitk::Point3D index;
+      index[0] = (i * 7 % 75) / 10.0 - 0.4;
+      index[1] = (i * 3 % 65) / 10.0 - 0.4;
+      index[2] = (i % 55) / 10.0 - 0.4;
+      indices.push_back(index);
+
+      itk::Index<3> discreteIndex;
+      for (unsigned int d = 0; d < 3; ++d)
+        discreteIndex[d] = itk::Math::RoundHalfIntegerUp<itk::IndexValueType>(index[d]);
+      discreteIndices.push_back(discreteIndex);
+    }
+
+    std::vector<mitk::ScalarType> values;
+    {
+      mitk::ImagePixelSampler sampler(m_Image);
+      values = sampler.SampleByIndex(indices);
+    }
+
+    mitk::ImagePixelReadAccessor<short, 3> accessor(m_Image, m_Image->GetVolumeData(0));
+    for (std::size_t i = 0; i < indices.size(); ++i)
+    {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(accessor.GetPixelByIndex(discreteIndices[i]), values[i], mitk::eps);
+    }
+  }
+
+  void NearestNeighbor_WorldCoordinate_EqualsGetPixelValueByWorldCoordinate()
+  {
+    std::vector<mitk::Point3D> points;
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+      mitk::Point3D index;
+      index[0] = (i * 7) % 8 + 0.3;
+      index[1] = (i * 3) % 7 - 0.2;
+      index[2] = i % 6;
+
+      mitk::Point3D point;
+      m_Image->GetGeometry()->IndexToWorld(index, point);
+      points.push_back(point);
+    }
+
+    std::vector<mitk::ScalarType> values;
+    {
+      mitk::ImagePixelSampler sampler(m_Image);
+      values = sampler.SampleByWorldCoordinate(points);
+    }
+
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(m_Image->GetPixelValueByWorldCoordinate(points[i]), values[i], mitk::eps);
+    }
+  }
+
+  void Trilinear_BetweenPixels_InterpolatesLinearFunction()
+  {
+    mitk::ImagePixelSampler sampler(m_Image);
+    sampler.SetInterpolationMode(mitk::ImagePixelSampler::Trilinear);
+
+    mitk::Point3D index;
+    index[0] = 2.25;
+    index[1] = 3.5;
+    index[2] = 4.75;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2.25 + 35.0 + 475.0, sampler.SampleByIndex(index), 1e-9);
+
+    mitk::Point3D point;
+    m_Image->GetGeometry()->IndexToWorld(index, point);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2.25 + 35.0 + 475.0, sampler.SampleByWorldCoordinate(point), 1e-9);
+
+    // outer half of the border pixels is clamped
+    index[0] = 7.4;
+    index[1] = -0.3;
+    index[2] = 0.0;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(7.0, sampler.SampleByIndex(index), 1e-9);
+  }
+
+  void Outside_ReturnsOutsideValue()
+  {
+    mitk::ImagePixelSampler sampler(m_Image);
+    sampler.SetOutsideValue(-1.0);
+
+    mitk::Point3D index;
+    index[0] = 7.6;
+    index[1] = 0.0;
+    index[2] = 0.0;
+    CPPUNIT_ASSERT_EQUAL(-1.0, sampler.SampleByIndex(index));
+
+    index[0] = -0.6;
+    CPPUNIT_ASSERT_EQUAL(-1.0, sampler.SampleByIndex(index));
+
+    sampler.SetInterpolationMode(mitk::ImagePixelSampler::Trilinear);
+    index[0] = 0.0;
+    index[2] = 5.5;
+    CPPUNIT_ASSERT_EQUAL(-1.0, sampler.SampleByIndex(index));
+  }
+
+  void TimeStepAndComponent_SampledFromCorrectPart()
+  {
+    mitk::Image::Pointer image = this->CreateLinearImage<float>(3, 2);
+
+    mitk::Point3D index;
+    index[0] = 1.0;
+    index[1] = 2.0;
+    index[2] = 3.0;
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(321.0, mitk::ImagePixelSampler(image, 0, 0).SampleByIndex(index), mitk::eps);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2321.0, mitk::ImagePixelSampler(image, 2, 0).SampleByIndex(index), mitk::eps);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(11321.0, mitk::ImagePixelSampler(image, 1, 1).SampleByIndex(index), mitk::eps);
+  }
+
+  void InvalidArguments_Throw()
+  {
+    CPPUNIT_ASSERT_THROW(mitk::ImagePixelSampler(nullptr), mitk::Exception);
+    CPPUNIT_ASSERT_THROW(mitk::ImagePixelSampler(m_Image, 1), mitk::Exception);
+    CPPUNIT_ASSERT_THROW(mitk::ImagePixelSampler(m_Image, 0, 1), mitk::Exception);
+  }
+
+  void SampleByWorldCoordinate_Performance()
+  {
+    const std::size_t numberOfPoints = 1000000;
+    std::vector<mitk::Point3D> points(numberOfPoints);
+    for (std::size_t i = 0; i < numberOfPoints; ++i)
+    {
+      mitk::Point3D index;
+      index[0] = std::rand() % 8;
+      index[1] = std::rand() % 7;
+      index[2] = std::rand() % 6;
+      m_Image->GetGeometry()->IndexToWorld(index, points[i]);
+    }
+
+    std::vector<mitk::ScalarType> values;
+    itk::TimeProbe samplerProbe;
+    samplerProbe.Start();
+    {
+      mitk::ImagePixelSampler sampler(m_Image);
+      values = sampler.SampleByWorldCoordinate(points);
+    }
+    samplerProbe.Stop();
+
+    std::vector<mitk::ScalarType> referenceValues(numberOfPoints);
+    itk::TimeProbe referenceProbe;
+    referenceProbe.Start();
+    for (std::size_t i = 0; i < numberOfPoints; ++i)
+    {
+      referenceValues[i] = m_Image->GetPixelValueByWorldCoordinate(points[i]);
+    }
+    referenceProbe.Stop();
+
+    CPPUNIT_ASSERT(values == referenceValues);
+
+    MITK_INFO << "Sampling " << numberOfPoints << " points: " << samplerProbe.GetTotal() * 1000.0
+              << " ms (ImagePixelSampler), " << referenceProbe.GetTotal() * 1000.0
+              << " ms (GetPixelValueByWorldCoordinate)";
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImagePixelSampler)
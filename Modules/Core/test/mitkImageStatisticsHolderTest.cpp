@@ -0,0 +1,265 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <mitkImage.h>
+#include <mitkImageStatisticsHolder.h>
+#include <mitkImageWriteAccessor.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+class mitkImageStatisticsHolderTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageStatisticsHolderTestSuite);
+  MITK_TEST(ShortImage_EqualsSerialReference);
+  MITK_TEST(FloatImage_EqualsSerialReference);
+  MITK_TEST(ConstantImage_SecondExtremaEqualValue);
+  MITK_TEST(VectorImage_ComputedPerComponent);
+  MITK_TEST(ModifiedImage_Recomputed);
+  MITK_TEST(ComputeInBackground_CoarseValuesRefined);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  struct Reference
+  {
+    double Min = itk::NumericTraits<double>::max();
+    double Max = itk::NumericTraits<double>::NonpositiveMin();
+    double SecondMin = itk::NumericTraits<double>::max();
+    double SecondMax = itk::NumericTraits<double>::NonpositiveMin();
+    unsigned int CountOfMin = 0;
+    unsigned int CountOfMax = 0;
+  };
+
+  template <typename TPixel>
+  mitk::Image::Pointer CreateImage(unsigned int size, unsigned int timeSteps, unsigned int components)
+  {
+    unsigned int dimensions[4] = {size, size + 1, size + 2, timeSteps};
+    auto image = mitk::Image::New();
+    if (components == 1)
+    {
+      image->Initialize(mitk::MakeScalarPixelType<TPixel>(), 4, dimensions);
+    }
+    else
+    {
+      image->Initialize(mitk::MakePixelType<itk::VectorImage<TPixel, 3>>(components), 4, dimensions);
+    }
+    return image;
+  }
+
+  template <typename TPixel>
+  TPixel *GetData(mitk::Image *image, std::unique_ptr<mitk::ImageWriteAccessor> &accessor)
+  {
+    accessor.reset(new mitk::ImageWriteAccessor(image));
+    return static_cast<TPixel *>(accessor->GetData());
+  }
+
+  /** Straight forward single threaded computation of every @a step-th value */
+  template <typename TPixel>
+  Reference ComputeReference(const TPixel *data, std::size_t numberOfValues, std::size_t step)
+  {
+    Reference reference;
+    for (std::size_t i = 0; i < numberOfValues; ++i)
+    {
+      const double value = data[i * step];
+      reference.Min = std::min(reference.Min, value);
+      reference.Max = std::max(reference.Max, value);
+    }
+    for (std::size_t i = 0; i < numberOfValues; ++i)
+    {
+      const double value = data[i * step];
+      if (value == reference.Min)
+        ++reference.CountOfMin;
+      else
+        reference.SecondMin = std::min(reference.SecondMin, value);
+
+      if (value == reference.Max)
+        ++reference.CountOfMax;
+      else
+        reference.SecondMax = std::max(reference.SecondMax, value);
+    }
+    return reference;
+  }
+
+  void AssertStatistics(const Reference &reference, mitk::Image *image, int t, unsigned int component = 0)
+  {
+    mitk::ImageStatisticsHolder *statistics = image->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(reference.Min, statistics->GetScalarValueMin(t, component));
+    CPPUNIT_ASSERT_EQUAL(reference.Max, statistics->GetScalarValueMax(t, component));
+    CPPUNIT_ASSERT_EQUAL(reference.SecondMin, statistics->GetScalarValue2ndMin(t, component));
+    CPPUNIT_ASSERT_EQUAL(reference.SecondMax, statistics->GetScalarValue2ndMax(t, component));
+    CPPUNIT_ASSERT_EQUAL(static_cast<double>(reference.CountOfMin),
+                         statistics->GetCountOfMinValuedVoxels(t, component));
+    CPPUNIT_ASSERT_EQUAL(static_cast<double>(reference.CountOfMax),
+                         statistics->GetCountOfMaxValuedVoxels(t, component));
+  }
+
+  void AssertHistogram(mitk::Image *image, int t, std::size_t numberOfPixels, unsigned int component = 0)
+  {
+    mitk::ImageStatisticsHolder *statistics = image->GetStatistics();
+    const mitk::ImageStatisticsHolder::HistogramType *histogram = statistics->GetScalarHistogram(t, component);
+    CPPUNIT_ASSERT(histogram != nullptr);
+    CPPUNIT_ASSERT_EQUAL(256u, static_cast<unsigned int>(histogram->GetSize(0)));
+    CPPUNIT_ASSERT_EQUAL(static_cast<double>(numberOfPixels), static_cast<double>(histogram->GetTotalFrequency()));
+    CPPUNIT_ASSERT_EQUAL(statistics->GetScalarValueMin(t, component), histogram->GetBinMin(0, 0));
+    CPPUNIT_ASSERT(histogram->GetFrequency(0) >= statistics->GetCountOfMinValuedVoxels(t, component));
+    CPPUNIT_ASSERT(histogram->GetFrequency(255) >= statistics->GetCountOfMaxValuedVoxels(t, component));
+  }
+
+public:
+  void ShortImage_EqualsSerialReference()
+  {
+    mitk::Image::Pointer image = this->CreateImage<short>(20, 2, 1);
+    const std::size_t numberOfPixels = 20 * 21 * 22;
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      short *data = this->GetData<short>(image, accessor);
+      for (std::size_t i = 0; i < 2 * numberOfPixels; ++i)
+        data[i] = static_cast<short>(std::rand() % 3000 - 1000);
+    }
+
+    std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+    const short *data = this->GetData<short>(image, accessor);
+    const Reference reference0 = this->ComputeReference(data, numberOfPixels, 1);
+    const Reference reference1 = this->ComputeReference(data + numberOfPixels, numberOfPixels, 1);
+    accessor.reset();
+
+    this->AssertStatistics(reference1, image, 1);
+    this->AssertStatistics(reference0, image, 0);
+    this->AssertHistogram(image, 0, numberOfPixels);
+    this->AssertHistogram(image, 1, numberOfPixels);
+  }
+
+  void FloatImage_EqualsSerialReference()
+  {
+    mitk::Image::Pointer image = this->CreateImage<float>(30, 1, 1);
+    const std::size_t numberOfPixels = 30 * 31 * 32;
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      float *data = this->GetData<float>(image, accessor);
+      for (std::size_t i = 0; i < numberOfPixels; ++i)
+        data[i] = static_cast<float>(std::rand() % 100000) / 7.0f - 5000.0f;
+    }
+
+    std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+    const Reference reference = this->ComputeReference(this->GetData<float>(image, accessor), numberOfPixels, 1);
+    accessor.reset();
+
+    this->AssertStatistics(reference, image, 0);
+    this->AssertHistogram(image, 0, numberOfPixels);
+  }
+
+  void ConstantImage_SecondExtremaEqualValue()
+  {
+    mitk::Image::Pointer image = this->CreateImage<unsigned char>(10, 1, 1);
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      unsigned char *data = this->GetData<unsigned char>(image, accessor);
+      std::fill(data, data + 10 * 11 * 12, 42);
+    }
+
+    mitk::ImageStatisticsHolder *statistics = image->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(42.0, statistics->GetScalarValueMin());
+    CPPUNIT_ASSERT_EQUAL(42.0, statistics->GetScalarValueMax());
+    CPPUNIT_ASSERT_EQUAL(42.0, statistics->GetScalarValue2ndMin());
+    CPPUNIT_ASSERT_EQUAL(42.0, statistics->GetScalarValue2ndMax());
+    CPPUNIT_ASSERT_EQUAL(1320.0, statistics->GetCountOfMinValuedVoxels());
+    CPPUNIT_ASSERT_EQUAL(1320.0, statistics->GetCountOfMaxValuedVoxels());
+  }
+
+  void VectorImage_ComputedPerComponent()
+  {
+    mitk::Image::Pointer image = this->CreateImage<double>(12, 1, 3);
+    const std::size_t numberOfPixels = 12 * 13 * 14;
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      double *data = this->GetData<double>(image, accessor);
+      for (std::size_t i = 0; i < 3 * numberOfPixels; ++i)
+        data[i] = (i % 3) * 1000.0 + std::rand() % 500;
+    }
+
+    std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+    const double *data = this->GetData<double>(image, accessor);
+    Reference references[3];
+    for (unsigned int component = 0; component < 3; ++component)
+      references[component] = this->ComputeReference(data + component, numberOfPixels, 3);
+    accessor.reset();
+
+    this->AssertStatistics(references[2], image, 0, 2);
+    this->AssertStatistics(references[0], image, 0, 0);
+    this->AssertStatistics(references[1], image, 0, 1);
+    this->AssertHistogram(image, 0, numberOfPixels, 1);
+
+    CPPUNIT_ASSERT_THROW(image->GetStatistics()->GetScalarValueMin(0, 3), mitk::Exception);
+  }
+
+  void ModifiedImage_Recomputed()
+  {
+    mitk::Image::Pointer image = this->CreateImage<int>(10, 1, 1);
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      int *data = this->GetData<int>(image, accessor);
+      std::fill(data, data + 10 * 11 * 12, 1);
+    }
+    CPPUNIT_ASSERT_EQUAL(1.0, image->GetStatistics()->GetScalarValueMax());
+
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      int *data = this->GetData<int>(image, accessor);
+      data[17] = 7;
+    }
+    image->Modified();
+
+    CPPUNIT_ASSERT_EQUAL(7.0, image->GetStatistics()->GetScalarValueMax());
+    CPPUNIT_ASSERT_EQUAL(1.0, image->GetStatistics()->GetScalarValue2ndMax());
+    CPPUNIT_ASSERT_EQUAL(1.0, image->GetStatistics()->GetCountOfMaxValuedVoxels());
+  }
+
+  void ComputeInBackground_CoarseValuesRefined()
+  {
+    // 64 * 65 * 66 pixels are subsampled with a stride of 4 for the coarse statistics
+    mitk::Image::Pointer image = this->CreateImage<short>(64, 1, 1);
+    {
+      std::unique_ptr<mitk::ImageWriteAccessor> accessor;
+      short *data = this->GetData<short>(image, accessor);
+      for (std::size_t i = 0; i < 64 * 65 * 66; ++i)
+        data[i] = static_cast<short>(i % 1000);
+      data[1] = -1000;
+      data[2] = 5000;
+    }
+
+    mitk::ImageStatisticsHolder *statistics = image->GetStatistics();
+    statistics->SetComputeInBackground(true);
+
+    // the first request always returns the coarse statistics, later ones may already return the refined ones
+    CPPUNIT_ASSERT_EQUAL(0.0, statistics->GetScalarValueMin());
+
+    statistics->WaitForBackgroundComputations();
+    CPPUNIT_ASSERT(!statistics->IsCoarse());
+
+    CPPUNIT_ASSERT_EQUAL(-1000.0, statistics->GetScalarValueMin());
+    CPPUNIT_ASSERT_EQUAL(5000.0, statistics->GetScalarValueMax());
+    CPPUNIT_ASSERT_EQUAL(0.0, statistics->GetScalarValue2ndMin());
+    CPPUNIT_ASSERT_EQUAL(999.0, statistics->GetScalarValue2ndMax());
+    CPPUNIT_ASSERT_EQUAL(1.0, statistics->GetCountOfMinValuedVoxels());
+    this->AssertHistogram(image, 0, 64 * 65 * 66);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageStatisticsHolder)
@@ -0,0 +1,172 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// MITK
+#include <mitkImageVtkMapper2D.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkLevelWindowProperty.h>
+#include <mitkRenderingTestHelper.h>
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+// VTK
+#include <vtkImageData.h>
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Checks when ImageVtkMapper2D extracts its slice again. The modification time of the extracted
+ * slice changes whenever the reslicer is executed, so it tells cached and re-extracted slices apart.
+ */
+class mitkImageVtkMapper2DResliceCacheTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkImageVtkMapper2DResliceCacheTestSuite);
+  MITK_TEST(LevelWindowChange_KeepsSlice);
+  MITK_TEST(PlaneChange_ReextractsSlice);
+  MITK_TEST(ImageModified_ReextractsSlice);
+  MITK_TEST(WriteAccessWithoutModified_ReextractsSlice);
+  MITK_TEST(PlaneAndImageChange_ReextractsSlice);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  /** Members used inside the different test methods. All members are initialized via setUp().*/
+  mitk::RenderingTestHelper m_RenderingTestHelper;
+  mitk::Image::Pointer m_Image;
+  mitk::DataNode::Pointer m_Node;
+
+  /** Fills every axial slice z with the value z + 1 + offset, without calling Modified(). */
+  void FillImage(unsigned char offset)
+  {
+    mitk::ImageWriteAccessor accessor(m_Image);
+    auto pixels = static_cast<unsigned char *>(accessor.GetData());
+    for (unsigned int z = 0; z < 16; ++z)
+    {
+      std::fill(pixels + z * 16 * 16, pixels + (z + 1) * 16 * 16, static_cast<unsigned char>(z + 1 + offset));
+    }
+  }
+
+  mitk::BaseRenderer *GetRenderer()
+  {
+    return mitk::BaseRenderer::GetInstance(m_RenderingTestHelper.GetVtkRenderWindow());
+  }
+
+  mitk::ImageVtkMapper2D::LocalStorage *GetLocalStorage()
+  {
+    auto mapper = dynamic_cast<mitk::ImageVtkMapper2D *>(m_Node->GetMapper(mitk::BaseRenderer::Standard2D));
+    CPPUNIT_ASSERT(mapper != nullptr);
+    return mapper->GetLocalStorage(this->GetRenderer());
+  }
+
+  /** Renders and returns the modification time of the extracted slice. */
+  unsigned long RenderAndGetSliceMTime()
+  {
+    m_RenderingTestHelper.Render();
+    vtkImageData *slice = this->GetLocalStorage()->m_ReslicedImage;
+    CPPUNIT_ASSERT(slice != nullptr);
+    return slice->GetMTime();
+  }
+
+  double GetSliceMaximum() { return this->GetLocalStorage()->m_ReslicedImage->GetScalarRange()[1]; }
+
+public:
+  /**
+   * @brief Because the RenderingTestHelper does not have an empty default constructor, we need
+   * this constructor to initialize the helper with a resolution.
+   */
+  mitkImageVtkMapper2DResliceCacheTestSuite() : m_RenderingTestHelper(640, 480) {}
+
+  void setUp()
+  {
+    m_RenderingTestHelper = mitk::RenderingTestHelper(640, 480);
+
+    m_Image = mitk::Image::New();
+    unsigned int dimensions[3] = {16, 16, 16};
+    m_Image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 3, dimensions);
+    this->FillImage(0);
+
+    m_Node = mitk::DataNode::New();
+    m_Node->SetData(m_Image);
+    m_RenderingTestHelper.AddNodeToStorage(m_Node);
+    m_RenderingTestHelper.SetViewDirection(mitk::SliceNavigationController::Axial);
+  }
+
+  void tearDown()
+  {
+    m_Node = nullptr;
+    m_Image = nullptr;
+  }
+
+  void LevelWindowChange_KeepsSlice()
+  {
+    const unsigned long sliceMTime = this->RenderAndGetSliceMTime();
+
+    m_Node->SetProperty("levelwindow", mitk::LevelWindowProperty::New(mitk::LevelWindow(5.0, 4.0)));
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Slice kept for a level window change", sliceMTime, this->RenderAndGetSliceMTime());
+  }
+
+  void PlaneChange_ReextractsSlice()
+  {
+    const unsigned long sliceMTime = this->RenderAndGetSliceMTime();
+    const double sliceMaximum = this->GetSliceMaximum();
+
+    this->GetRenderer()->GetSliceNavigationController()->GetSlice()->Next();
+
+    CPPUNIT_ASSERT_MESSAGE("Slice re-extracted for another plane", this->RenderAndGetSliceMTime() > sliceMTime);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, std::abs(this->GetSliceMaximum() - sliceMaximum), 0.0);
+  }
+
+  void ImageModified_ReextractsSlice()
+  {
+    const unsigned long sliceMTime = this->RenderAndGetSliceMTime();
+
+    m_Image->Modified();
+
+    CPPUNIT_ASSERT_MESSAGE("Slice re-extracted for a modified image", this->RenderAndGetSliceMTime() > sliceMTime);
+  }
+
+  void WriteAccessWithoutModified_ReextractsSlice()
+  {
+    const unsigned long sliceMTime = this->RenderAndGetSliceMTime();
+    const double sliceMaximum = this->GetSliceMaximum();
+
+    // the pixels change without Modified(), a property change makes the mapper generate its data
+    this->FillImage(100);
+    m_Node->SetOpacity(0.5);
+
+    CPPUNIT_ASSERT_MESSAGE("Slice re-extracted after a write access", this->RenderAndGetSliceMTime() > sliceMTime);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sliceMaximum + 100.0, this->GetSliceMaximum(), 0.0);
+  }
+
+  void PlaneAndImageChange_ReextractsSlice()
+  {
+    const unsigned long sliceMTime = this->RenderAndGetSliceMTime();
+    const double sliceMaximum = this->GetSliceMaximum();
+
+    this->GetRenderer()->GetSliceNavigationController()->GetSlice()->Next();
+    this->FillImage(100);
+    m_Image->Modified();
+
+    CPPUNIT_ASSERT_MESSAGE("Slice re-extracted for another plane and a modified image",
+                           this->RenderAndGetSliceMTime() > sliceMTime);
+    // the next slice is one above or below, both now offset by 100
+    const double difference = this->GetSliceMaximum() - sliceMaximum;
+    CPPUNIT_ASSERT(difference == 101.0 || difference == 99.0);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkImageVtkMapper2DResliceCache)
@@ -0,0 +1,308 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <vtkMitkLevelWindowFilter.h>
+
+#include <itkTimeProbe.h>
+
+#include <vtkColorTransferFunction.h>
+#include <vtkImageData.h>
+#include <vtkLookupTable.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+class mitkLevelWindowFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkLevelWindowFilterTestSuite);
+  MITK_TEST(LinearLookupTable_Unclipped_EqualsReference);
+  MITK_TEST(LinearLookupTable_Clipped_EqualsMapValue);
+  MITK_TEST(LinearLookupTable_RangeColors_EqualsMapValue);
+  MITK_TEST(ColorTransferFunction_Clipped_EqualsGetColor);
+  MITK_TEST(ColorTransferFunction_Opacity_EqualsGetColor);
+  MITK_TEST(Performance);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  template <typename TPixel>
+  vtkSmartPointer<vtkImageData> CreateImage(int scalarType, int size, double minimum, double step)
+  {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(size, size, 1);
+    image->AllocateScalars(scalarType, 1);
+
+    auto pixels = static_cast<TPixel *>(image->GetScalarPointer());
+    for (int i = 0; i < size * size; ++i)
+    {
+      pixels[i] = static_cast<TPixel>(minimum + (i % 997) * step);
+    }
+    if (std::numeric_limits<TPixel>::has_quiet_NaN)
+    {
+      for (int i = 0; i < size * size; i += 101)
+        pixels[i] = std::numeric_limits<TPixel>::quiet_NaN();
+    }
+    return image;
+  }
+
+  vtkSmartPointer<vtkImageData> ApplyFilter(vtkImageData *image, vtkScalarsToColors *lookupTable, double *clippingBounds)
+  {
+    vtkSmartPointer<vtkMitkLevelWindowFilter> filter = vtkSmartPointer<vtkMitkLevelWindowFilter>::New();
+    filter->SetInputData(image);
+    filter->SetLookupTable(lookupTable);
+    filter->SetClippingBounds(clippingBounds);
+    filter->Update();
+    return filter->GetOutput();
+  }
+
+  /** Straightforward per pixel mapping as reference for the filter output. */
+  template <typename TPixel, typename TMapFunction>
+  std::vector<unsigned char> MapPixelByPixel(vtkImageData *image, double *clippingBounds, TMapFunction mapFunction)
+  {
+    int dimensions[3];
+    image->GetDimensions(dimensions);
+    auto pixels = static_cast<TPixel *>(image->GetScalarPointer());
+
+    std::vector<unsigned char> result(dimensions[0] * dimensions[1] * 4, 0);
+    for (int y = 0; y < dimensions[1]; ++y)
+    {
+      for (int x = 0; x < dimensions[0]; ++x)
+      {
+        if (y >= clippingBounds[2] && y < clippingBounds[3] && x >= clippingBounds[0] && x < clippingBounds[1])
+        {
+          const int index = y * dimensions[0] + x;
+          mapFunction(static_cast<double>(pixels[index]), &result[index * 4]);
+        }
+      }
+    }
+    return result;
+  }
+
+  /** Compares the filter output with vtkLookupTable::MapValue(), i.e. the mapping of VTK. */
+  template <typename TPixel>
+  void CheckMapValue(vtkLookupTable *lookupTable, int scalarType, double minimum, double step, double *clippingBounds)
+  {
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<TPixel>(scalarType, 67, minimum, step);
+    vtkSmartPointer<vtkImageData> output = this->ApplyFilter(image, lookupTable, clippingBounds);
+
+    std::vector<unsigned char> reference = this->MapPixelByPixel<TPixel>(
+      image, clippingBounds, [lookupTable](double value, unsigned char *rgba) {
+        std::memcpy(rgba, lookupTable->MapValue(value), 4);
+      });
+
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(output->GetScalarPointer(), reference.data(), reference.size()));
+  }
+
+  /**
+   * Unclipped slices are mapped by rounding to the nearest table index. The table ranges have a power of two
+   * as scale, so the reference is exact in double precision. The width of 67 pixels is no multiple of the
+   * vector size, so the vectorized spans and the remaining pixels are both checked.
+   */
+  template <typename TPixel>
+  void CheckLinearLookupTable(int scalarType, double minimum, double step, double tableMinimum, double tableSize)
+  {
+    vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    lookupTable->SetRange(tableMinimum, tableMinimum + tableSize);
+    lookupTable->Build();
+
+    double clippingBounds[4] = {0.0, 67.0, 0.0, 67.0};
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<TPixel>(scalarType, 67, minimum, step);
+    vtkSmartPointer<vtkImageData> output = this->ApplyFilter(image, lookupTable, clippingBounds);
+
+    const double scale = lookupTable->GetNumberOfColors() / tableSize;
+    const vtkIdType maxIndex = lookupTable->GetNumberOfColors() - 1;
+
+    std::vector<unsigned char> reference = this->MapPixelByPixel<TPixel>(
+      image, clippingBounds, [&lookupTable, tableMinimum, scale, maxIndex](double value, unsigned char *rgba) {
+        // NaN is mapped to the first table entry
+        vtkIdType index = 0;
+        if (value == value)
+          index = static_cast<vtkIdType>(std::floor((value - tableMinimum) * scale + 0.5));
+        index = std::max<vtkIdType>(0, std::min(maxIndex, index));
+        std::memcpy(rgba, lookupTable->GetPointer(index), 4);
+      });
+
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(output->GetScalarPointer(), reference.data(), reference.size()));
+  }
+
+public:
+  void LinearLookupTable_Unclipped_EqualsReference()
+  {
+    this->CheckLinearLookupTable<unsigned char>(VTK_UNSIGNED_CHAR, 0.0, 0.25, 16.0, 128.0);
+    this->CheckLinearLookupTable<short>(VTK_SHORT, -1000.0, 3.0, -900.0, 1024.0);
+    this->CheckLinearLookupTable<unsigned short>(VTK_UNSIGNED_SHORT, 0.0, 50.0, 4000.0, 32768.0);
+    this->CheckLinearLookupTable<int>(VTK_INT, -50000.0, 101.0, -20000.0, 65536.0);
+    this->CheckLinearLookupTable<float>(VTK_FLOAT, -1.0, 1.0 / 512.0, -0.75, 1.0);
+    this->CheckLinearLookupTable<double>(VTK_DOUBLE, -1.0, 1.0 / 512.0, -0.75, 1.0);
+  }
+
+  void LinearLookupTable_Clipped_EqualsMapValue()
+  {
+    vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    lookupTable->SetRange(-123.4, 2345.6);
+    lookupTable->Build();
+
+    double clippingBounds[4] = {3.5, 57.0, 2.0, 60.0};
+    this->CheckMapValue<unsigned char>(lookupTable, VTK_UNSIGNED_CHAR, 0.0, 0.25, clippingBounds);
+    this->CheckMapValue<short>(lookupTable, VTK_SHORT, -1000.0, 3.0, clippingBounds);
+    this->CheckMapValue<unsigned short>(lookupTable, VTK_UNSIGNED_SHORT, 0.0, 2.7, clippingBounds);
+    this->CheckMapValue<float>(lookupTable, VTK_FLOAT, -200.0, 2.71, clippingBounds);
+
+    // more values than pixels, so 16 bit pixels are mapped one by one instead of by a table
+    this->CheckMapValue<unsigned short>(lookupTable, VTK_UNSIGNED_SHORT, 0.0, 50.0, clippingBounds);
+  }
+
+  void LinearLookupTable_RangeColors_EqualsMapValue()
+  {
+    vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    lookupTable->SetRange(-123.4, 2345.6);
+    lookupTable->SetBelowRangeColor(1.0, 0.0, 0.0, 1.0);
+    lookupTable->UseBelowRangeColorOn();
+    lookupTable->SetAboveRangeColor(0.0, 1.0, 0.0, 1.0);
+    lookupTable->UseAboveRangeColorOn();
+    lookupTable->Build();
+
+    double unclippedBounds[4] = {0.0, 67.0, 0.0, 67.0};
+    this->CheckMapValue<short>(lookupTable, VTK_SHORT, -1000.0, 3.0, unclippedBounds);
+    this->CheckMapValue<float>(lookupTable, VTK_FLOAT, -200.0, 2.71, unclippedBounds);
+
+    double clippingBounds[4] = {3.5, 57.0, 2.0, 60.0};
+    this->CheckMapValue<unsigned short>(lookupTable, VTK_UNSIGNED_SHORT, 0.0, 2.7, clippingBounds);
+  }
+
+  void ColorTransferFunction_Clipped_EqualsGetColor()
+  {
+    vtkSmartPointer<vtkColorTransferFunction> colorTransferFunction = vtkSmartPointer<vtkColorTransferFunction>::New();
+    colorTransferFunction->AddRGBPoint(0.0, 0.0, 0.0, 1.0);
+    colorTransferFunction->AddRGBPoint(200.0, 1.0, 0.5, 0.0);
+
+    double clippingBounds[4] = {0.0, 40.0, 10.0, 64.0};
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<unsigned char>(VTK_UNSIGNED_CHAR, 64, 0.0, 0.25);
+    vtkSmartPointer<vtkImageData> output = this->ApplyFilter(image, colorTransferFunction, clippingBounds);
+
+    std::vector<unsigned char> reference = this->MapPixelByPixel<unsigned char>(
+      image, clippingBounds, [&colorTransferFunction](double value, unsigned char *rgba) {
+        double color[3];
+        colorTransferFunction->GetColor(value, color);
+        for (int i = 0; i < 3; ++i)
+          rgba[i] = static_cast<unsigned char>(255.0 * color[i] + 0.5);
+        rgba[3] = 255;
+      });
+
+    CPPUNIT_ASSERT_EQUAL(0, std::memcmp(output->GetScalarPointer(), reference.data(), reference.size()));
+  }
+
+  void ColorTransferFunction_Opacity_EqualsGetColor()
+  {
+    vtkSmartPointer<vtkColorTransferFunction> colorTransferFunction = vtkSmartPointer<vtkColorTransferFunction>::New();
+    colorTransferFunction->AddRGBPoint(-500.0, 0.0, 0.0, 1.0);
+    colorTransferFunction->AddRGBPoint(1500.0, 1.0, 0.5, 0.0);
+    vtkSmartPointer<vtkPiecewiseFunction> opacityFunction = vtkSmartPointer<vtkPiecewiseFunction>::New();
+    opacityFunction->AddPoint(-1000.0, 0.0);
+    opacityFunction->AddPoint(2000.0, 1.0);
+
+    double clippingBounds[4] = {3.5, 57.0, 2.0, 60.0};
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<short>(VTK_SHORT, 67, -1000.0, 3.0);
+
+    vtkSmartPointer<vtkMitkLevelWindowFilter> filter = vtkSmartPointer<vtkMitkLevelWindowFilter>::New();
+    filter->SetInputData(image);
+    filter->SetLookupTable(colorTransferFunction);
+    filter->SetOpacityPiecewiseFunction(opacityFunction);
+    filter->SetClippingBounds(clippingBounds);
+    filter->Update();
+
+    std::vector<unsigned char> reference = this->MapPixelByPixel<short>(
+      image, clippingBounds, [&colorTransferFunction, &opacityFunction](double value, unsigned char *rgba) {
+        double color[3];
+        colorTransferFunction->GetColor(value, color);
+        for (int i = 0; i < 3; ++i)
+          rgba[i] = static_cast<unsigned char>(255.0 * color[i] + 0.5);
+        rgba[3] = static_cast<unsigned char>(255.0 * opacityFunction->GetValue(value) + 0.5);
+      });
+
+    CPPUNIT_ASSERT_EQUAL(
+      0, std::memcmp(filter->GetOutput()->GetScalarPointer(), reference.data(), reference.size()));
+  }
+
+  /** Compares the filter with the per pixel mapping of VTK for the unclipped, clipped and color transfer function paths. */
+  void Performance()
+  {
+    vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    lookupTable->SetRange(0.0, 4096.0);
+    lookupTable->Build();
+
+    vtkSmartPointer<vtkColorTransferFunction> colorTransferFunction = vtkSmartPointer<vtkColorTransferFunction>::New();
+    colorTransferFunction->AddRGBPoint(0.0, 0.0, 0.0, 1.0);
+    colorTransferFunction->AddRGBPoint(4096.0, 1.0, 0.5, 0.0);
+
+    double unclippedBounds[4] = {0.0, 1024.0, 0.0, 1024.0};
+    double clippingBounds[4] = {16.0, 1008.0, 16.0, 1008.0};
+    vtkSmartPointer<vtkImageData> image = this->CreateImage<unsigned short>(VTK_UNSIGNED_SHORT, 1024, 0.0, 4.0);
+
+    itk::TimeProbe unclippedProbe;
+    itk::TimeProbe clippedProbe;
+    itk::TimeProbe colorTransferFunctionProbe;
+    itk::TimeProbe mapValueProbe;
+    itk::TimeProbe getColorProbe;
+    for (int run = 0; run < 10; ++run)
+    {
+      unclippedProbe.Start();
+      this->ApplyFilter(image, lookupTable, unclippedBounds);
+      unclippedProbe.Stop();
+
+      clippedProbe.Start();
+      this->ApplyFilter(image, lookupTable, clippingBounds);
+      clippedProbe.Stop();
+
+      colorTransferFunctionProbe.Start();
+      this->ApplyFilter(image, colorTransferFunction, clippingBounds);
+      colorTransferFunctionProbe.Stop();
+
+      mapValueProbe.Start();
+      this->MapPixelByPixel<unsigned short>(image, clippingBounds, [&lookupTable](double value, unsigned char *rgba) {
+        std::memcpy(rgba, lookupTable->MapValue(value), 4);
+      });
+      mapValueProbe.Stop();
+
+      getColorProbe.Start();
+      this->MapPixelByPixel<unsigned short>(
+        image, clippingBounds, [&colorTransferFunction](double value, unsigned char *rgba) {
+          double color[3];
+          colorTransferFunction->GetColor(value, color);
+          for (int i = 0; i < 3; ++i)
+            rgba[i] = static_cast<unsigned char>(255.0 * color[i] + 0.5);
+          rgba[3] = 255;
+        });
+      getColorProbe.Stop();
+    }
+
+    MITK_INFO << "Level window of 1024x1024 unsigned short slice: " << unclippedProbe.GetMean() * 1000.0
+              << " ms (unclipped), " << clippedProbe.GetMean() * 1000.0 << " ms (clipped), "
+              << mapValueProbe.GetMean() * 1000.0 << " ms (pixel by pixel MapValue)";
+    MITK_INFO << "Color transfer function of 1024x1024 unsigned short slice: "
+              << colorTransferFunctionProbe.GetMean() * 1000.0 << " ms (filter), " << getColorProbe.GetMean() * 1000.0
+              << " ms (pixel by pixel GetColor)";
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkLevelWindowFilter)
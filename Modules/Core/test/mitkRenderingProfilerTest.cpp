@@ -0,0 +1,168 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <mitkDataNode.h>
+#include <mitkRenderingProfiler.h>
+
+#include <sstream>
+
+class mitkRenderingProfilerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkRenderingProfilerTestSuite);
+  MITK_TEST(Disabled_RecordsNothing);
+  MITK_TEST(ScopedEvent_RecordsCategoryNameAndNode);
+  MITK_TEST(TimingSummariesPerNode_AccumulateDurations);
+  MITK_TEST(Frames_RecordedFromBeginToEnd);
+  MITK_TEST(MaximumNumberOfEvents_DropsOldestEvents);
+  MITK_TEST(WriteChromeTrace_WritesCompleteAndInstantEvents);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::RenderingProfiler *m_Profiler;
+
+public:
+  void setUp() override
+  {
+    m_Profiler = mitk::RenderingProfiler::GetInstance();
+    m_Profiler->Clear();
+    m_Profiler->SetEnabled(true);
+  }
+
+  void tearDown() override
+  {
+    m_Profiler->SetEnabled(false);
+    m_Profiler->SetMaximumNumberOfEvents(1000000);
+    m_Profiler->Clear();
+  }
+
+  void Disabled_RecordsNothing()
+  {
+    m_Profiler->SetEnabled(false);
+    {
+      mitk::RenderingProfiler::ScopedEvent event("Update", "Mapper", nullptr);
+    }
+    m_Profiler->RecordLevelOfDetailDecision(nullptr, 1);
+    m_Profiler->BeginFrame(nullptr);
+    m_Profiler->EndFrame(nullptr, 0);
+
+    CPPUNIT_ASSERT(m_Profiler->GetEvents().empty());
+  }
+
+  void ScopedEvent_RecordsCategoryNameAndNode()
+  {
+    auto node = mitk::DataNode::New();
+    node->SetName("liver");
+
+    const double before = m_Profiler->GetTime();
+    {
+      mitk::RenderingProfiler::ScopedEvent event("GenerateData", "ImageVtkMapper2D", nullptr, node);
+    }
+    const double after = m_Profiler->GetTime();
+
+    const std::vector<mitk::RenderingProfiler::Event> events = m_Profiler->GetEvents();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), events.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("GenerateData"), events[0].Category);
+    CPPUNIT_ASSERT_EQUAL(std::string("ImageVtkMapper2D"), events[0].Name);
+    CPPUNIT_ASSERT_EQUAL(std::string("liver"), events[0].NodeName);
+    CPPUNIT_ASSERT_EQUAL(std::string(""), events[0].RendererName);
+    CPPUNIT_ASSERT_EQUAL(-1, events[0].LevelOfDetail);
+    CPPUNIT_ASSERT(events[0].StartTime >= before);
+    CPPUNIT_ASSERT(events[0].StartTime + events[0].Duration <= after);
+  }
+
+  void TimingSummariesPerNode_AccumulateDurations()
+  {
+    m_Profiler->RecordEvent("Paint", "Opaque", nullptr, "liver", 0.0, 10.0);
+    m_Profiler->RecordEvent("Paint", "Opaque", nullptr, "liver", 20.0, 30.0);
+    m_Profiler->RecordEvent("Paint", "Overlay", nullptr, "tumor", 60.0, 5.0);
+    m_Profiler->RecordEvent("Update", "SurfaceVtkMapper3D", nullptr, "liver", 70.0, 100.0);
+
+    std::map<std::string, mitk::RenderingProfiler::TimingSummary> summaries =
+      m_Profiler->GetTimingSummariesPerNode("Paint");
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), summaries.size());
+    CPPUNIT_ASSERT_EQUAL(2u, summaries["liver"].Count);
+    CPPUNIT_ASSERT_EQUAL(40.0, summaries["liver"].TotalTime);
+    CPPUNIT_ASSERT_EQUAL(30.0, summaries["liver"].MaximumTime);
+    CPPUNIT_ASSERT_EQUAL(1u, summaries["tumor"].Count);
+
+    mitk::RenderingProfiler::TimingSummary summary = m_Profiler->GetTimingSummary("Paint");
+    CPPUNIT_ASSERT_EQUAL(3u, summary.Count);
+    CPPUNIT_ASSERT_EQUAL(45.0, summary.TotalTime);
+
+    CPPUNIT_ASSERT_EQUAL(0u, m_Profiler->GetTimingSummary("Paint", "stdmulti.widget1").Count);
+    CPPUNIT_ASSERT_EQUAL(1u, m_Profiler->GetTimingSummariesPerRenderer("Update")[""].Count);
+  }
+
+  void Frames_RecordedFromBeginToEnd()
+  {
+    // a frame end without start (e.g. profiling was enabled during a frame) is ignored
+    m_Profiler->EndFrame(nullptr, 0);
+    CPPUNIT_ASSERT(m_Profiler->GetEvents().empty());
+
+    m_Profiler->BeginFrame(nullptr);
+    m_Profiler->EndFrame(nullptr, 1);
+    m_Profiler->RecordLevelOfDetailDecision(nullptr, 0);
+
+    const std::vector<mitk::RenderingProfiler::Event> events = m_Profiler->GetEvents();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), events.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("Frame"), events[0].Category);
+    CPPUNIT_ASSERT_EQUAL(1, events[0].LevelOfDetail);
+    CPPUNIT_ASSERT(events[0].Duration >= 0.0);
+    CPPUNIT_ASSERT_EQUAL(std::string("LOD"), events[1].Category);
+    CPPUNIT_ASSERT_EQUAL(0, events[1].LevelOfDetail);
+    CPPUNIT_ASSERT_EQUAL(0.0, events[1].Duration);
+  }
+
+  void MaximumNumberOfEvents_DropsOldestEvents()
+  {
+    m_Profiler->SetMaximumNumberOfEvents(3);
+    for (int i = 0; i < 5; ++i)
+      m_Profiler->RecordEvent("Update", "Mapper", nullptr, "node", i, 1.0);
+
+    std::vector<mitk::RenderingProfiler::Event> events = m_Profiler->GetEvents();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), events.size());
+    CPPUNIT_ASSERT_EQUAL(2.0, events[0].StartTime);
+    CPPUNIT_ASSERT_EQUAL(4.0, events[2].StartTime);
+
+    m_Profiler->SetMaximumNumberOfEvents(1);
+    events = m_Profiler->GetEvents();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), events.size());
+    CPPUNIT_ASSERT_EQUAL(4.0, events[0].StartTime);
+  }
+
+  void WriteChromeTrace_WritesCompleteAndInstantEvents()
+  {
+    m_Profiler->RecordEvent("Paint", "Opaque", nullptr, "say \"cheese\"", 1.5, 2.25);
+    m_Profiler->RecordLevelOfDetailDecision(nullptr, 1);
+
+    std::ostringstream stream;
+    m_Profiler->WriteChromeTrace(stream);
+    const std::string trace = stream.str();
+
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), trace.find("{\"traceEvents\":["));
+    CPPUNIT_ASSERT(trace.find("\"name\":\"thread_name\",\"ph\":\"M\"") != std::string::npos);
+    CPPUNIT_ASSERT(trace.find("\"name\":\"Opaque say \\\"cheese\\\"\",\"cat\":\"Paint\",\"ph\":\"X\",\"dur\":2.250,"
+                              "\"ts\":1.500") != std::string::npos);
+    CPPUNIT_ASSERT(trace.find("\"cat\":\"LOD\",\"ph\":\"i\"") != std::string::npos);
+    CPPUNIT_ASSERT(trace.find("\"lod\":1") != std::string::npos);
+    CPPUNIT_ASSERT(trace.rfind("]}") != std::string::npos);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkRenderingProfiler)
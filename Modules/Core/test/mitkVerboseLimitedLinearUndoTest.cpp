@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkInteractionConst.h"
+#include "mitkLimitedLinearUndo.h"
 #include "mitkOperation.h"
 #include "mitkUndoController.h"
 #include "mitkVerboseLimitedLinearUndo.h"
@@ -33,8 +34,16 @@ namespace mitk
   class TestOperation : public Operation
   {
   public:
-    TestOperation(OperationType operationType) : Operation(operationType) { g_GlobalCounter++; };
+    TestOperation(OperationType operationType, std::size_t memoryUsage = 0)
+      : Operation(operationType), m_MemoryUsage(memoryUsage)
+    {
+      g_GlobalCounter++;
+    };
     virtual ~TestOperation() { g_GlobalCounter--; };
+    virtual std::size_t GetMemoryUsage() const override { return m_MemoryUsage; }
+
+  private:
+    std::size_t m_MemoryUsage;
   };
 } // namespace
 
@@ -111,6 +120,36 @@ int mitkVerboseLimitedLinearUndoTest(int /* argc */, char * /*argv*/ [])
   myUndoController->Clear();
   MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 0, "checking deleting all operations in UndoModel");
 
+  // limit the memory of the undo model: the oldest operations are deleted first
+  auto limitedLinearUndo = dynamic_cast<mitk::LimitedLinearUndo *>(mitk::UndoController::GetCurrentUndoModel());
+  MITK_TEST_CONDITION_REQUIRED(limitedLinearUndo != nullptr, "checking type of UndoModel");
+  const std::size_t defaultMemoryLimit = limitedLinearUndo->GetMemoryLimit();
+  MITK_TEST_CONDITION_REQUIRED(defaultMemoryLimit == mitk::LimitedLinearUndo::DefaultMemoryLimit,
+                               "checking the default memory limit");
+  limitedLinearUndo->SetMemoryLimit(1000);
+
+  for (int i = 0; i < 4; i++)
+  {
+    auto doOp = new mitk::TestOperation(mitk::OpTEST, 300);
+    auto undoOp = new mitk::TestOperation(mitk::OpTEST);
+    myUndoController->SetOperationEvent(new mitk::OperationEvent(nullptr, doOp, undoOp, "Test"));
+    mitk::OperationEvent::IncCurrObjectEventId();
+  }
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 6 && limitedLinearUndo->GetMemoryUsage() == 900,
+                               "checking deleting oldest operations when exceeding the memory limit");
+
+  // the most recent operation is kept even if it exceeds the limit on its own
+  myUndoController->SetOperationEvent(new mitk::OperationEvent(
+    nullptr, new mitk::TestOperation(mitk::OpTEST, 5000), new mitk::TestOperation(mitk::OpTEST), "Test"));
+  mitk::OperationEvent::IncCurrObjectEventId();
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 2 && limitedLinearUndo->GetMemoryUsage() == 5000,
+                               "checking keeping the most recent operation");
+
+  limitedLinearUndo->SetMemoryLimit(defaultMemoryLimit);
+  myUndoController->Clear();
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 0 && limitedLinearUndo->GetMemoryUsage() == 0,
+                               "checking deleting all operations in UndoModel");
+
   // sending two new OperationEvents
   for (int i = 0; i < 2; i++)
   {
@@ -46,6 +46,7 @@ class MITKDICOMREADER_EXPORT DICOMDatasetSorter : public itk::LightObject
   public:
 
     mitkClassMacroItkParent( DICOMDatasetSorter, itk::LightObject )
+    itkCloneMacro( Self )
 
     /**
       \brief Return the tags of interest (to facilitate scanning)
@@ -72,6 +73,12 @@ class MITKDICOMREADER_EXPORT DICOMDatasetSorter : public itk::LightObject
 
     virtual bool operator==(const DICOMDatasetSorter& other) const = 0;
 
+    /**
+      \brief Sub-classes must provide a complete copy of their configuration (see mitkCloneMacro).
+      Clones are used to sort independent blocks concurrently.
+    */
+    virtual itk::LightObject::Pointer InternalClone() const override = 0;
+
   protected:
 
     DICOMDatasetSorter();
@@ -18,7 +18,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define mitkDICOMGDCMTagCache_h
 
 #include "mitkDICOMTagCache.h"
+#include "mitkDICOMGDCMTagIndex.h"
 
+#include <map>
 #include <set>
 #include <memory>
 
@@ -47,6 +49,26 @@ namespace mitk
 
       void InitCache(const std::set<DICOMTag>& scannedTags, const std::shared_ptr<gdcm::Scanner>& scanner, const StringList& inputFiles);
 
+      /**
+        \brief Initializes the cache from the results of several scanners that each scanned a part of the input.
+        The frame info list is composed in the order of the given file lists, so passing contiguous shards
+        of the original input list yields the same result as a single scanner.
+        @pre scanners.size() == inputFilesPerScanner.size()
+      */
+      void InitCache(const std::set<DICOMTag>& scannedTags,
+                     const std::vector<std::shared_ptr<gdcm::Scanner> >& scanners,
+                     const std::vector<StringList>& inputFilesPerScanner);
+
+      /**
+        \brief Initializes the cache from a persistent tag index that contains all input files.
+        The cache keeps a reference on the index, because the frame infos point to its values.
+      */
+      void InitCache(const std::set<DICOMTag>& scannedTags, const DICOMGDCMTagIndex* index, const StringList& inputFiles);
+
+      /**
+        \brief Returns the (first) scanner that provided the cached values.
+        @pre The cache was not initialized from a DICOMGDCMTagIndex.
+      */
       const gdcm::Scanner& GetScanner() const;
 
   protected:
@@ -58,8 +80,16 @@ namespace mitk
 
       std::shared_ptr<gdcm::Scanner> m_Scanner;
 
+      /** The frame infos reference values owned by the scanners, so all of them are kept alive. */
+      std::vector<std::shared_ptr<gdcm::Scanner> > m_Scanners;
+
+      DICOMGDCMTagIndex::ConstPointer m_Index;
+
       DICOMDatasetAccessingImageFrameList m_ScanResult;
 
+      /** Index of each scanned file in m_ScanResult, avoids linear searches in GetTagValue(). */
+      std::map<std::string, size_t> m_ScanResultIndex;
+
     private:
       DICOMGDCMTagCache(const DICOMGDCMTagCache&);
   };
@@ -0,0 +1,143 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkDICOMGDCMTagIndex_h
+#define mitkDICOMGDCMTagIndex_h
+
+#include "mitkDICOMTag.h"
+#include "mitkDICOMEnums.h"
+
+#include <itkLightObject.h>
+#include <mitkCommon.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <gdcmScanner.h>
+
+namespace mitk
+{
+
+  /**
+    \ingroup DICOMReaderModule
+    \brief Persistent index of DICOM tag values, used by DICOMGDCMTagScanner to avoid re-parsing file headers.
+
+    The index stores the values of scanned tags per file, together with the file size and modification
+    time at the moment of scanning. A file is only considered up to date (see IsUpToDate()) if size and
+    modification time are unchanged and all requested tags have been scanned before. Tags that were
+    scanned but not present in a file are remembered as well, so they are not scanned again.
+
+    The index is stored in a compact binary file (see Load() and Save()). Files with a different magic
+    number or version are ignored, which simply results in a complete re-scan.
+
+    Value pointers handed out by GetMapping() stay valid for the lifetime of the index, even if the
+    entry of the file is updated later on. DICOMGDCMTagCache therefore keeps a reference on the index.
+
+    The class is not thread-safe.
+  */
+  class MITKDICOMREADER_EXPORT DICOMGDCMTagIndex : public itk::LightObject
+  {
+    public:
+
+      mitkClassMacroItkParent(DICOMGDCMTagIndex, itk::LightObject);
+      itkFactorylessNewMacro( DICOMGDCMTagIndex );
+
+      /**
+        \brief Replaces the content of the index by the content of the given file.
+        \return false if the file does not exist or could not be read. The index is empty in this case.
+      */
+      bool Load(const std::string& indexFilename);
+
+      /**
+        \brief Writes the index to the given file.
+        The file is written to a uniquely named temporary file next to it first and then renamed,
+        so concurrent readers never see an incomplete index and concurrent writers do not interfere.
+      */
+      bool Save(const std::string& indexFilename) const;
+
+      /**
+        \brief Checks if the values of all given tags are indexed for the current state of the file on disk.
+      */
+      bool IsUpToDate(const std::string& filename, const std::set<DICOMTag>& tags) const;
+
+      /**
+        \brief Returns the indexed values of a file in the representation used by gdcm::Scanner.
+        Tags that are not present in the file are not part of the mapping.
+      */
+      gdcm::Scanner::TagToValue GetMapping(const std::string& filename) const;
+
+      /**
+        \brief Stores the scanning result of a file.
+        Values of other tags that were indexed before are kept as long as the file did not change.
+      */
+      void Update(const std::string& filename, const std::set<DICOMTag>& scannedTags, const gdcm::Scanner::TagToValue& mapping);
+
+      /**
+        \brief Removes all entries of files that no longer exist.
+      */
+      void RemoveMissingFiles();
+
+      /** \brief Number of indexed files. */
+      std::size_t GetNumberOfFiles() const;
+
+      /** \brief True if Update() or RemoveMissingFiles() changed the index since the last Load() or Save(). */
+      bool IsModified() const;
+
+      /**
+        \brief Directory for index files that are created automatically by DICOMGDCMTagScanner.
+        An empty directory (default) disables automatic index usage.
+      */
+      static void SetDefaultIndexDirectory(const std::string& directory);
+      static std::string GetDefaultIndexDirectory();
+
+      /**
+        \brief Name of the index file in GetDefaultIndexDirectory() used for the files of the given directory.
+        \return an empty string if no default index directory is set.
+      */
+      static std::string GetDefaultIndexFilename(const std::string& dicomDirectory);
+
+    protected:
+
+      DICOMGDCMTagIndex();
+      virtual ~DICOMGDCMTagIndex();
+
+      struct FileEntry
+      {
+        unsigned long long Size;
+        long int ModificationTime;
+        /** Value of each scanned tag, nullptr if the tag is not present in the file. */
+        std::map<gdcm::Tag, const char*> Values;
+      };
+
+      static bool GetFileState(const std::string& filename, unsigned long long& size, long int& modificationTime);
+
+      const char* StoreValue(const std::string& value);
+
+      std::map<std::string, FileEntry> m_Entries;
+
+      /** Owns all value strings, entries only point into this set. */
+      std::set<std::string> m_Values;
+
+      mutable bool m_Modified;
+
+    private:
+      DICOMGDCMTagIndex(const DICOMGDCMTagIndex&);
+      DICOMGDCMTagIndex& operator=(const DICOMGDCMTagIndex&);
+  };
+}
+
+#endif
@@ -86,9 +86,30 @@ namespace mitk
         Calling Scan() will invalidate previous scans, forgetting
         all about files and tags from files that have been scanned
         previously.
+
+        Large file lists are split into contiguous shards which are scanned
+        concurrently by separate gdcm::Scanner instances (see SetNumberOfThreads()).
+        The per-shard results are merged in input order, so the scan result
+        does not depend on the number of threads.
       */
       virtual void Scan();
 
+      /**
+        \brief Maximum number of threads used by Scan().
+        0 (default) uses as many threads as OpenMP provides, 1 disables parallel scanning.
+      */
+      void SetNumberOfThreads(unsigned int numberOfThreads);
+      unsigned int GetNumberOfThreads() const;
+
+      /**
+        \brief Persistent tag index (see DICOMGDCMTagIndex) that is consulted and updated by Scan().
+        Only files that are not indexed yet or changed since indexing are parsed. If no file name is set,
+        the default index of the directory of the first input file is used, provided that
+        DICOMGDCMTagIndex::SetDefaultIndexDirectory() has been called. Otherwise no index is used.
+      */
+      void SetTagIndexFilename(const std::string& filename);
+      std::string GetTagIndexFilename() const;
+
       /**
         \brief Retrieve a result list for file-by-file tag access.
       */
@@ -110,6 +131,20 @@ namespace mitk
       DICOMGDCMTagScanner();
       virtual ~DICOMGDCMTagScanner();
 
+      /** \brief Number of shards the given number of files is split into for scanning. */
+      unsigned int GetNumberOfScanShards(std::size_t numberOfFiles) const;
+
+      /** \brief Scans the given files, potentially in parallel by several scanners. */
+      void ScanFiles(const StringList& filenames,
+                     std::vector<std::shared_ptr<gdcm::Scanner> >& scanners,
+                     std::vector<StringList>& filenamesPerScanner);
+
+      /** \brief Tag index file used by Scan(), empty if no index should be used. */
+      std::string GetEffectiveTagIndexFilename() const;
+
+      unsigned int m_NumberOfThreads;
+      std::string m_TagIndexFilename;
+
       std::set<DICOMTag> m_ScannedTags;
       StringList m_InputFilenames;
       DICOMGDCMTagCache::Pointer m_Cache;
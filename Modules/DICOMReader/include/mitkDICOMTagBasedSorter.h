@@ -76,6 +76,7 @@ class MITKDICOMREADER_EXPORT DICOMTagBasedSorter : public DICOMDatasetSorter
 
     mitkClassMacro( DICOMTagBasedSorter, DICOMDatasetSorter )
     itkNewMacro( DICOMTagBasedSorter )
+    mitkCloneMacro( DICOMTagBasedSorter )
 
     /**
       \brief Datasets that differ in given tag's value will be sorted into separate outputs.
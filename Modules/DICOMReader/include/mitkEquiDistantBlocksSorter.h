@@ -60,6 +60,7 @@ class MITKDICOMREADER_EXPORT EquiDistantBlocksSorter : public DICOMDatasetSorter
 
     mitkClassMacro( EquiDistantBlocksSorter, DICOMDatasetSorter )
     itkNewMacro( EquiDistantBlocksSorter )
+    mitkCloneMacro( EquiDistantBlocksSorter )
 
     virtual DICOMTagList GetTagsOfInterest() override;
 
@@ -45,6 +45,7 @@ class MITKDICOMREADER_EXPORT NormalDirectionConsistencySorter : public DICOMData
 
     mitkClassMacro( NormalDirectionConsistencySorter, DICOMDatasetSorter )
     itkNewMacro( NormalDirectionConsistencySorter )
+    mitkCloneMacro( NormalDirectionConsistencySorter )
 
     virtual DICOMTagList GetTagsOfInterest() override;
 
@@ -30,12 +30,10 @@ mitk::DICOMDatasetFinding mitk::DICOMGDCMTagCache::GetTagValue( DICOMImageFrameI
 {
   assert( frame );
 
-  for ( auto frameIter = m_ScanResult.cbegin(); frameIter != m_ScanResult.cend(); ++frameIter )
+  auto indexIter = m_ScanResultIndex.find( frame->Filename );
+  if ( indexIter != m_ScanResultIndex.cend() && *(m_ScanResult[indexIter->second]) == *frame )
   {
-    if ( **frameIter == *frame )
-    {
-      return (*frameIter)->GetTagValueAsString(tag);
-    }
+    return m_ScanResult[indexIter->second]->GetTagValueAsString(tag);
   }
 
   if ( m_ScannedTags.find( tag ) != m_ScannedTags.cend() )
@@ -87,22 +85,83 @@ mitk::DICOMDatasetAccessingImageFrameList mitk::DICOMGDCMTagCache::GetFrameInfoL
 void
 mitk::DICOMGDCMTagCache::InitCache(const std::set<DICOMTag>& scannedTags, const std::shared_ptr<gdcm::Scanner>& scanner, const StringList& inputFiles)
 {
+  std::vector<std::shared_ptr<gdcm::Scanner> > scanners(1, scanner);
+  std::vector<StringList> inputFilesPerScanner(1, inputFiles);
+
+  this->InitCache(scannedTags, scanners, inputFilesPerScanner);
+}
+
+void
+mitk::DICOMGDCMTagCache::InitCache(const std::set<DICOMTag>& scannedTags,
+                                   const std::vector<std::shared_ptr<gdcm::Scanner> >& scanners,
+                                   const std::vector<StringList>& inputFilesPerScanner)
+{
+  if (scanners.empty() || scanners.size() != inputFilesPerScanner.size())
+  {
+    mitkThrow() << "Invalid call to DICOMGDCMTagCache::InitCache(). Each scanner needs exactly one list of input files.";
+  }
+
+  m_ScannedTags = scannedTags;
+  m_Scanners = scanners;
+  m_Scanner = scanners.front();
+  m_Index = nullptr;
+
+  m_InputFilenames.clear();
+  for (const auto& inputFiles : inputFilesPerScanner)
+  {
+    m_InputFilenames.insert(m_InputFilenames.end(), inputFiles.cbegin(), inputFiles.cend());
+  }
+
+  m_ScanResult.clear();
+  m_ScanResult.reserve(m_InputFilenames.size());
+  m_ScanResultIndex.clear();
+
+  for (size_t scannerIndex = 0; scannerIndex < scanners.size(); ++scannerIndex)
+  {
+    const StringList& inputFiles = inputFilesPerScanner[scannerIndex];
+
+    for (auto inputIter = inputFiles.cbegin(); inputIter != inputFiles.cend(); ++inputIter)
+    {
+      m_ScanResultIndex.insert(std::make_pair(*inputIter, m_ScanResult.size()));
+      m_ScanResult.push_back(DICOMGDCMImageFrameInfo::New(DICOMImageFrameInfo::New(*inputIter, 0),
+        scanners[scannerIndex]->GetMapping(inputIter->c_str())).GetPointer());
+    }
+  }
+}
+
+void
+mitk::DICOMGDCMTagCache::InitCache(const std::set<DICOMTag>& scannedTags, const DICOMGDCMTagIndex* index, const StringList& inputFiles)
+{
+  if (index == nullptr)
+  {
+    mitkThrow() << "Invalid call to DICOMGDCMTagCache::InitCache(). No tag index given.";
+  }
+
   m_ScannedTags = scannedTags;
   m_InputFilenames = inputFiles;
-  m_Scanner = scanner;
+  m_Scanners.clear();
+  m_Scanner = nullptr;
+  m_Index = index;
 
   m_ScanResult.clear();
   m_ScanResult.reserve(m_InputFilenames.size());
+  m_ScanResultIndex.clear();
 
   for (auto inputIter = m_InputFilenames.cbegin(); inputIter != m_InputFilenames.cend(); ++inputIter)
   {
+    m_ScanResultIndex.insert(std::make_pair(*inputIter, m_ScanResult.size()));
     m_ScanResult.push_back(DICOMGDCMImageFrameInfo::New(DICOMImageFrameInfo::New(*inputIter, 0),
-      m_Scanner->GetMapping(inputIter->c_str())).GetPointer());
+      m_Index->GetMapping(*inputIter)).GetPointer());
   }
 }
 
 const gdcm::Scanner&
 mitk::DICOMGDCMTagCache::GetScanner() const
 {
+  if (!m_Scanner)
+  {
+    mitkThrow() << "DICOMGDCMTagCache::GetScanner() is not available, cache was initialized from a tag index.";
+  }
+
   return *(this->m_Scanner);
 }
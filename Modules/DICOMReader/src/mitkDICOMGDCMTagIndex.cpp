@@ -0,0 +1,434 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDICOMGDCMTagIndex.h"
+
+#include <mitkException.h>
+#include <mitkIOUtil.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <itkMutexLockHolder.h>
+#include <itkSimpleFastMutexLock.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace
+{
+  const char IndexMagic[8] = { 'M', 'I', 'T', 'K', 'D', 'I', 'D', 'X' };
+  const std::uint32_t IndexVersion = 1;
+
+  std::string s_DefaultIndexDirectory;
+  itk::SimpleFastMutexLock s_DefaultIndexDirectoryMutex;
+
+  template <typename T>
+  void WriteValue(std::ostream& stream, T value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void WriteString(std::ostream& stream, const std::string& value)
+  {
+    WriteValue<std::uint32_t>(stream, static_cast<std::uint32_t>(value.size()));
+    stream.write(value.data(), value.size());
+  }
+
+  /** Reads values from the bytes of a loaded index file, without copying them into a stream first. */
+  class IndexBufferReader
+  {
+  public:
+    IndexBufferReader(const std::string& buffer) : m_Buffer(buffer), m_Position(0) {}
+
+    template <typename T>
+    bool ReadValue(T& value)
+    {
+      if (sizeof(T) > m_Buffer.size() - m_Position)
+      {
+        return false;
+      }
+      std::memcpy(&value, m_Buffer.data() + m_Position, sizeof(T));
+      m_Position += sizeof(T);
+      return true;
+    }
+
+    bool ReadBytes(char* bytes, std::size_t length)
+    {
+      if (length > m_Buffer.size() - m_Position)
+      {
+        return false;
+      }
+      std::memcpy(bytes, m_Buffer.data() + m_Position, length);
+      m_Position += length;
+      return true;
+    }
+
+    /** Reads a string, whose length may not exceed the number of bytes that are left in the buffer. */
+    bool ReadString(std::string& value)
+    {
+      std::uint32_t length = 0;
+      if (!this->ReadValue(length) || length > m_Buffer.size() - m_Position)
+      {
+        return false;
+      }
+      value.assign(m_Buffer.data() + m_Position, length);
+      m_Position += length;
+      return true;
+    }
+
+  private:
+    const std::string& m_Buffer;
+    std::size_t m_Position;
+  };
+
+  /** Replaces the target file by the source file in one step, so readers see either the old or the new file. */
+  bool ReplaceIndexFile(const std::string& source, const std::string& target)
+  {
+#ifdef _WIN32
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+  }
+
+  /** 64 bit FNV-1a hash, which unlike std::hash gives the same index filename for every build and platform. */
+  std::uint64_t HashFNV1a(const std::string& value)
+  {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const char character : value)
+    {
+      hash ^= static_cast<unsigned char>(character);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+}
+
+mitk::DICOMGDCMTagIndex::DICOMGDCMTagIndex()
+  : m_Modified(false)
+{
+}
+
+mitk::DICOMGDCMTagIndex::~DICOMGDCMTagIndex()
+{
+}
+
+bool mitk::DICOMGDCMTagIndex::GetFileState(const std::string& filename, unsigned long long& size, long int& modificationTime)
+{
+  if (!itksys::SystemTools::FileExists(filename.c_str(), true))
+  {
+    return false;
+  }
+
+  size = static_cast<unsigned long long>(itksys::SystemTools::FileLength(filename));
+  modificationTime = itksys::SystemTools::ModifiedTime(filename);
+  return true;
+}
+
+const char* mitk::DICOMGDCMTagIndex::StoreValue(const std::string& value)
+{
+  return m_Values.insert(value).first->c_str();
+}
+
+bool mitk::DICOMGDCMTagIndex::IsUpToDate(const std::string& filename, const std::set<DICOMTag>& tags) const
+{
+  auto entryIter = m_Entries.find(filename);
+  if (entryIter == m_Entries.cend())
+  {
+    return false;
+  }
+
+  const FileEntry& entry = entryIter->second;
+  for (const auto& tag : tags)
+  {
+    if (entry.Values.find(gdcm::Tag(tag.GetGroup(), tag.GetElement())) == entry.Values.cend())
+    {
+      return false;
+    }
+  }
+
+  unsigned long long size = 0;
+  long int modificationTime = 0;
+  if (!GetFileState(filename, size, modificationTime))
+  {
+    return false;
+  }
+
+  return size == entry.Size && modificationTime == entry.ModificationTime;
+}
+
+gdcm::Scanner::TagToValue mitk::DICOMGDCMTagIndex::GetMapping(const std::string& filename) const
+{
+  gdcm::Scanner::TagToValue mapping;
+
+  auto entryIter = m_Entries.find(filename);
+  if (entryIter != m_Entries.cend())
+  {
+    for (const auto& value : entryIter->second.Values)
+    {
+      if (value.second != nullptr)
+      {
+        mapping.insert(value);
+      }
+    }
+  }
+
+  return mapping;
+}
+
+void mitk::DICOMGDCMTagIndex::Update(const std::string& filename, const std::set<DICOMTag>& scannedTags, const gdcm::Scanner::TagToValue& mapping)
+{
+  FileEntry newEntry;
+  if (!GetFileState(filename, newEntry.Size, newEntry.ModificationTime))
+  {
+    // nothing to index for files that cannot be accessed
+    m_Modified = m_Entries.erase(filename) > 0 || m_Modified;
+    return;
+  }
+
+  auto entryIter = m_Entries.find(filename);
+  if (entryIter != m_Entries.end() && entryIter->second.Size == newEntry.Size &&
+      entryIter->second.ModificationTime == newEntry.ModificationTime)
+  {
+    // file did not change, keep what we know about other tags
+    newEntry.Values = entryIter->second.Values;
+  }
+
+  for (const auto& tag : scannedTags)
+  {
+    const gdcm::Tag gdcmTag(tag.GetGroup(), tag.GetElement());
+    auto valueIter = mapping.find(gdcmTag);
+
+    newEntry.Values[gdcmTag] =
+      (valueIter != mapping.cend() && valueIter->second != nullptr) ? this->StoreValue(valueIter->second) : nullptr;
+  }
+
+  m_Entries[filename] = newEntry;
+  m_Modified = true;
+}
+
+void mitk::DICOMGDCMTagIndex::RemoveMissingFiles()
+{
+  for (auto entryIter = m_Entries.begin(); entryIter != m_Entries.end();)
+  {
+    if (!itksys::SystemTools::FileExists(entryIter->first.c_str(), true))
+    {
+      entryIter = m_Entries.erase(entryIter);
+      m_Modified = true;
+    }
+    else
+    {
+      ++entryIter;
+    }
+  }
+}
+
+std::size_t mitk::DICOMGDCMTagIndex::GetNumberOfFiles() const
+{
+  return m_Entries.size();
+}
+
+bool mitk::DICOMGDCMTagIndex::IsModified() const
+{
+  return m_Modified;
+}
+
+bool mitk::DICOMGDCMTagIndex::Load(const std::string& indexFilename)
+{
+  m_Entries.clear();
+  m_Modified = false;
+
+  std::ifstream stream(indexFilename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+  {
+    return false;
+  }
+
+  // read the whole index at once, it is small compared to the files it describes
+  stream.seekg(0, std::ios::end);
+  const std::streamoff fileSize = stream.tellg();
+  stream.seekg(0, std::ios::beg);
+  if (fileSize < 0)
+  {
+    return false;
+  }
+
+  std::string buffer(static_cast<std::size_t>(fileSize), '\0');
+  if (!buffer.empty() && !stream.read(&buffer[0], fileSize))
+  {
+    MITK_WARN << "Could not read DICOM tag index " << indexFilename;
+    return false;
+  }
+  stream.close();
+
+  IndexBufferReader input(buffer);
+
+  char magic[sizeof(IndexMagic)];
+  std::uint32_t version = 0;
+  std::uint32_t numberOfEntries = 0;
+
+  if (!input.ReadBytes(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), IndexMagic) ||
+      !input.ReadValue(version) || version != IndexVersion || !input.ReadValue(numberOfEntries))
+  {
+    MITK_DEBUG << "Ignoring incompatible DICOM tag index " << indexFilename;
+    return false;
+  }
+
+  for (std::uint32_t entryIndex = 0; entryIndex < numberOfEntries; ++entryIndex)
+  {
+    std::string filename;
+    FileEntry entry;
+    std::uint64_t size = 0;
+    std::int64_t modificationTime = 0;
+    std::uint32_t numberOfTags = 0;
+
+    if (!input.ReadString(filename) || !input.ReadValue(size) || !input.ReadValue(modificationTime) ||
+        !input.ReadValue(numberOfTags))
+    {
+      MITK_WARN << "DICOM tag index " << indexFilename << " is truncated, ignoring it.";
+      m_Entries.clear();
+      return false;
+    }
+
+    entry.Size = size;
+    entry.ModificationTime = static_cast<long int>(modificationTime);
+
+    for (std::uint32_t tagIndex = 0; tagIndex < numberOfTags; ++tagIndex)
+    {
+      std::uint16_t group = 0;
+      std::uint16_t element = 0;
+      std::uint8_t hasValue = 0;
+      std::string value;
+
+      if (!input.ReadValue(group) || !input.ReadValue(element) || !input.ReadValue(hasValue) ||
+          (hasValue && !input.ReadString(value)))
+      {
+        MITK_WARN << "DICOM tag index " << indexFilename << " is truncated, ignoring it.";
+        m_Entries.clear();
+        return false;
+      }
+
+      entry.Values[gdcm::Tag(group, element)] = hasValue ? this->StoreValue(value) : nullptr;
+    }
+
+    m_Entries[filename] = entry;
+  }
+
+  return true;
+}
+
+bool mitk::DICOMGDCMTagIndex::Save(const std::string& indexFilename) const
+{
+  std::ostringstream output(std::ios::out | std::ios::binary);
+
+  output.write(IndexMagic, sizeof(IndexMagic));
+  WriteValue<std::uint32_t>(output, IndexVersion);
+  WriteValue<std::uint32_t>(output, static_cast<std::uint32_t>(m_Entries.size()));
+
+  for (const auto& entry : m_Entries)
+  {
+    WriteString(output, entry.first);
+    WriteValue<std::uint64_t>(output, entry.second.Size);
+    WriteValue<std::int64_t>(output, entry.second.ModificationTime);
+    WriteValue<std::uint32_t>(output, static_cast<std::uint32_t>(entry.second.Values.size()));
+
+    for (const auto& value : entry.second.Values)
+    {
+      WriteValue<std::uint16_t>(output, value.first.GetGroup());
+      WriteValue<std::uint16_t>(output, value.first.GetElement());
+      WriteValue<std::uint8_t>(output, value.second != nullptr ? 1 : 0);
+      if (value.second != nullptr)
+      {
+        WriteString(output, value.second);
+      }
+    }
+  }
+
+  // several processes may save the same index, so each one writes its own uniquely named temporary file
+  std::string temporaryFilename;
+  {
+    std::ofstream stream;
+    try
+    {
+      temporaryFilename = mitk::IOUtil::CreateTemporaryFile(stream,
+                                                            std::ios::binary,
+                                                            itksys::SystemTools::GetFilenameName(indexFilename) + "-XXXXXX.tmp",
+                                                            itksys::SystemTools::GetFilenamePath(indexFilename));
+    }
+    catch (const mitk::Exception& e)
+    {
+      MITK_WARN << "Could not write DICOM tag index " << indexFilename << ": " << e.GetDescription();
+      return false;
+    }
+
+    const std::string data = output.str();
+    stream.write(data.data(), data.size());
+    stream.close();
+    if (!stream)
+    {
+      MITK_WARN << "Could not write DICOM tag index " << indexFilename;
+      itksys::SystemTools::RemoveFile(temporaryFilename);
+      return false;
+    }
+  }
+
+  if (!ReplaceIndexFile(temporaryFilename, indexFilename))
+  {
+    MITK_WARN << "Could not write DICOM tag index " << indexFilename;
+    itksys::SystemTools::RemoveFile(temporaryFilename);
+    return false;
+  }
+
+  m_Modified = false;
+  return true;
+}
+
+void mitk::DICOMGDCMTagIndex::SetDefaultIndexDirectory(const std::string& directory)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(s_DefaultIndexDirectoryMutex);
+  s_DefaultIndexDirectory = directory;
+}
+
+std::string mitk::DICOMGDCMTagIndex::GetDefaultIndexDirectory()
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(s_DefaultIndexDirectoryMutex);
+  return s_DefaultIndexDirectory;
+}
+
+std::string mitk::DICOMGDCMTagIndex::GetDefaultIndexFilename(const std::string& dicomDirectory)
+{
+  const std::string indexDirectory = GetDefaultIndexDirectory();
+  if (indexDirectory.empty())
+  {
+    return std::string();
+  }
+
+  const std::string normalizedDirectory = itksys::SystemTools::CollapseFullPath(dicomDirectory);
+
+  std::ostringstream filename;
+  filename << indexDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << HashFNV1a(normalizedDirectory)
+           << ".mitkdcmidx";
+  return filename.str();
+}
@@ -17,10 +17,28 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDICOMGDCMTagScanner.h"
 #include "mitkDICOMGDCMTagCache.h"
 #include "mitkDICOMGDCMImageFrameInfo.h"
+#include "mitkDICOMGDCMTagIndex.h"
 
 #include <gdcmScanner.h>
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+  // scanning a handful of files is dominated by thread startup, keep small shards serial
+  const std::size_t MinimumFilesPerScanShard = 64;
+
+  // more shards than threads balance the load between fast (cached) and slow files
+  const unsigned int ScanShardsPerThread = 4;
+}
 
 mitk::DICOMGDCMTagScanner::DICOMGDCMTagScanner()
+  : m_NumberOfThreads(0)
 {
   m_GDCMScanner = std::make_shared<gdcm::Scanner>();
 }
@@ -94,13 +112,163 @@ void mitk::DICOMGDCMTagScanner::SetInputFiles( const StringList& filenames )
 }
 
 
+void mitk::DICOMGDCMTagScanner::SetNumberOfThreads(unsigned int numberOfThreads)
+{
+  m_NumberOfThreads = numberOfThreads;
+}
+
+unsigned int mitk::DICOMGDCMTagScanner::GetNumberOfThreads() const
+{
+  return m_NumberOfThreads;
+}
+
+void mitk::DICOMGDCMTagScanner::SetTagIndexFilename(const std::string& filename)
+{
+  m_TagIndexFilename = filename;
+}
+
+std::string mitk::DICOMGDCMTagScanner::GetTagIndexFilename() const
+{
+  return m_TagIndexFilename;
+}
+
+std::string mitk::DICOMGDCMTagScanner::GetEffectiveTagIndexFilename() const
+{
+  if (!m_TagIndexFilename.empty() || m_InputFilenames.empty())
+  {
+    return m_TagIndexFilename;
+  }
+
+  return DICOMGDCMTagIndex::GetDefaultIndexFilename(itksys::SystemTools::GetFilenamePath(m_InputFilenames.front()));
+}
+
+unsigned int mitk::DICOMGDCMTagScanner::GetNumberOfScanShards(std::size_t numberOfFiles) const
+{
+  unsigned int numberOfThreads = m_NumberOfThreads;
+#ifdef _OPENMP
+  if (numberOfThreads == 0)
+  {
+    numberOfThreads = static_cast<unsigned int>(omp_get_max_threads());
+  }
+#else
+  numberOfThreads = 1;
+#endif
+
+  if (numberOfThreads <= 1)
+  {
+    return 1;
+  }
+
+  const std::size_t maximumShardsForInput = numberOfFiles / MinimumFilesPerScanShard;
+  return static_cast<unsigned int>(
+    std::max<std::size_t>(1, std::min<std::size_t>(maximumShardsForInput, numberOfThreads * ScanShardsPerThread)));
+}
+
+void mitk::DICOMGDCMTagScanner::ScanFiles(const StringList& filenames,
+                                          std::vector<std::shared_ptr<gdcm::Scanner> >& scanners,
+                                          std::vector<StringList>& filenamesPerScanner)
+{
+  const unsigned int numberOfShards = this->GetNumberOfScanShards(filenames.size());
+
+  if (numberOfShards <= 1)
+  {
+    m_GDCMScanner->Scan( filenames );
+    scanners.assign(1, m_GDCMScanner);
+    filenamesPerScanner.assign(1, filenames);
+    return;
+  }
+
+  // contiguous shards, so that merging them keeps the input order
+  filenamesPerScanner.assign(numberOfShards, StringList());
+  const std::size_t filesPerShard = filenames.size() / numberOfShards;
+  const std::size_t remainingFiles = filenames.size() % numberOfShards;
+
+  auto shardBegin = filenames.cbegin();
+  for (unsigned int shard = 0; shard < numberOfShards; ++shard)
+  {
+    auto shardEnd = shardBegin + filesPerShard + (shard < remainingFiles ? 1 : 0);
+    filenamesPerScanner[shard].assign(shardBegin, shardEnd);
+    shardBegin = shardEnd;
+  }
+
+  // gdcm::Scanner is not thread-safe, so every shard is scanned by its own instance
+  scanners.assign(numberOfShards, nullptr);
+  for (auto& scanner : scanners)
+  {
+    scanner = std::make_shared<gdcm::Scanner>();
+    for (const auto& tag : m_ScannedTags)
+    {
+      scanner->AddTag(gdcm::Tag(tag.GetGroup(), tag.GetElement()));
+    }
+  }
+
+#ifdef _OPENMP
+  const int numberOfThreads = m_NumberOfThreads > 0 ? static_cast<int>(m_NumberOfThreads) : omp_get_max_threads();
+#endif
+
+#pragma omp parallel for schedule(dynamic) num_threads(numberOfThreads)
+  for (int shard = 0; shard < static_cast<int>(numberOfShards); ++shard)
+  {
+    scanners[shard]->Scan(filenamesPerScanner[shard]);
+  }
+}
+
 void mitk::DICOMGDCMTagScanner::Scan()
 {
   // TODO integrate push/pop locale??
-  m_GDCMScanner->Scan( m_InputFilenames );
-
   DICOMGDCMTagCache::Pointer newCache = DICOMGDCMTagCache::New();
-  newCache->InitCache(m_ScannedTags, m_GDCMScanner, m_InputFilenames);
+
+  std::vector<std::shared_ptr<gdcm::Scanner> > scanners;
+  std::vector<StringList> filenamesPerScanner;
+
+  const std::string indexFilename = this->GetEffectiveTagIndexFilename();
+
+  if (indexFilename.empty())
+  {
+    this->ScanFiles(m_InputFilenames, scanners, filenamesPerScanner);
+    newCache->InitCache(m_ScannedTags, scanners, filenamesPerScanner);
+  }
+  else
+  {
+    // only parse headers of files that are new or changed since they were indexed
+    DICOMGDCMTagIndex::Pointer index = DICOMGDCMTagIndex::New();
+    index->Load(indexFilename);
+
+    StringList filesToScan;
+    for (const auto& filename : m_InputFilenames)
+    {
+      if (!index->IsUpToDate(filename, m_ScannedTags))
+      {
+        filesToScan.push_back(filename);
+      }
+    }
+
+    MITK_DEBUG << "DICOMGDCMTagScanner: " << m_InputFilenames.size() - filesToScan.size() << " of "
+               << m_InputFilenames.size() << " files found in tag index " << indexFilename;
+
+    if (!filesToScan.empty())
+    {
+      this->ScanFiles(filesToScan, scanners, filenamesPerScanner);
+
+      for (std::size_t scannerIndex = 0; scannerIndex < scanners.size(); ++scannerIndex)
+      {
+        for (const auto& filename : filenamesPerScanner[scannerIndex])
+        {
+          index->Update(filename, m_ScannedTags, scanners[scannerIndex]->GetMapping(filename.c_str()));
+        }
+      }
+    }
+
+    // do not let the index grow with files that were deleted or moved since they were indexed
+    index->RemoveMissingFiles();
+
+    if (index->IsModified())
+    {
+      index->Save(indexFilename);
+    }
+
+    newCache->InitCache(m_ScannedTags, index, m_InputFilenames);
+  }
 
   m_Cache = newCache;
 }
@@ -344,11 +344,17 @@ mitk::DICOMITKSeriesGDCMReader::SortingBlockList mitk::DICOMITKSeriesGDCMReader:
 
   MITK_DEBUG << "================================================================================";
   MITK_DEBUG << "DICOMITKSeriesGDCMReader: " << ss.str() << ": " << input.size() << " groups input";
-  unsigned int groupIndex = 0;
 
-  for ( auto blockIter = input.cbegin(); blockIter != input.cend(); ++groupIndex, ++blockIter )
+  // Groups are sorted independently of each other, so they are processed concurrently.
+  // Every group collects its result blocks separately, they are concatenated in input order
+  // afterwards to get exactly the same result as a serial run.
+  const int numberOfGroups = static_cast<int>( input.size() );
+  std::vector<SortingBlockList> resultsPerGroup( input.size() );
+
+#pragma omp parallel for schedule(dynamic) if(numberOfGroups > 1)
+  for ( int groupIndex = 0; groupIndex < numberOfGroups; ++groupIndex )
   {
-    const DICOMDatasetAccessingImageFrameList& gdcmInfoFrameList = *blockIter;
+    const DICOMDatasetAccessingImageFrameList& gdcmInfoFrameList = input[groupIndex];
     const DICOMDatasetList datasetList               = ConvertToDICOMDatasetList( gdcmInfoFrameList );
 
 #if defined( MBILOG_ENABLE_DEBUG )
@@ -361,13 +367,16 @@ mitk::DICOMITKSeriesGDCMReader::SortingBlockList mitk::DICOMITKSeriesGDCMReader:
     }
 #endif
 
-    sorter->SetInput( datasetList );
-    sorter->Sort();
-    unsigned int numberOfResultingBlocks = sorter->GetNumberOfOutputs();
+    // sorters keep their input and output as state, so each group needs its own instance
+    DICOMDatasetSorter::Pointer groupSorter = numberOfGroups > 1 ? sorter->Clone() : sorter;
+
+    groupSorter->SetInput( datasetList );
+    groupSorter->Sort();
+    unsigned int numberOfResultingBlocks = groupSorter->GetNumberOfOutputs();
 
     for ( unsigned int b = 0; b < numberOfResultingBlocks; ++b )
     {
-      const DICOMDatasetList blockResult = sorter->GetOutput( b );
+      const DICOMDatasetList blockResult = groupSorter->GetOutput( b );
 
       for ( auto oi = blockResult.cbegin(); oi != blockResult.cend(); ++oi )
       {
@@ -375,10 +384,15 @@ mitk::DICOMITKSeriesGDCMReader::SortingBlockList mitk::DICOMITKSeriesGDCMReader:
       }
 
       DICOMDatasetAccessingImageFrameList sortedGdcmInfoFrameList = ConvertToDICOMDatasetAccessingImageFrameList( blockResult );
-      nextStepSorting.push_back( sortedGdcmInfoFrameList );
+      resultsPerGroup[groupIndex].push_back( sortedGdcmInfoFrameList );
     }
   }
 
+  for ( auto groupIter = resultsPerGroup.cbegin(); groupIter != resultsPerGroup.cend(); ++groupIter )
+  {
+    nextStepSorting.insert( nextStepSorting.end(), groupIter->cbegin(), groupIter->cend() );
+  }
+
   return nextStepSorting;
 }
 
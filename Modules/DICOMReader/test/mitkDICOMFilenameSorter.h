@@ -32,6 +32,7 @@ class DICOMFilenameSorter : public DICOMDatasetSorter
 
     mitkClassMacro( DICOMFilenameSorter, DICOMDatasetSorter )
     itkNewMacro( DICOMFilenameSorter )
+    mitkCloneMacro( DICOMFilenameSorter )
 
     virtual DICOMTagList GetTagsOfInterest() override;
 
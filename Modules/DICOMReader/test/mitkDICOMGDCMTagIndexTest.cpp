@@ -0,0 +1,153 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDICOMGDCMTagIndex.h"
+#include "mitkDICOMGDCMTagScanner.h"
+
+#include "mitkIOUtil.h"
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstdint>
+#include <fstream>
+
+class mitkDICOMGDCMTagIndexTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkDICOMGDCMTagIndexTestSuite);
+
+  MITK_TEST(SaveAndLoad);
+  MITK_TEST(Load_CorruptedStringLength_ReturnsFalse);
+  MITK_TEST(IsUpToDate_UnscannedTag_ReturnsFalse);
+  MITK_TEST(Scan_WithIndex_EqualsScanWithoutIndex);
+
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::StringList ctFiles;
+  std::set<mitk::DICOMTag> tags;
+  std::string indexFilename;
+
+public:
+
+  void setUp() override
+  {
+    ctFiles.clear();
+    ctFiles.push_back(GetTestDataFilePath("TinyCTAbdomen/100"));
+    ctFiles.push_back(GetTestDataFilePath("TinyCTAbdomen/101"));
+
+    tags.clear();
+    tags.insert(mitk::DICOMTag(0x0008, 0x0018)); // SOP instance UID
+    tags.insert(mitk::DICOMTag(0x0018, 0x9087)); // diffusion b-value, not present in CT files
+
+    indexFilename = mitk::IOUtil::CreateTemporaryFile("DICOMTagIndex-XXXXXX.mitkdcmidx");
+  }
+
+  void tearDown() override
+  {
+    itksys::SystemTools::RemoveFile(indexFilename);
+  }
+
+  void SaveAndLoad()
+  {
+    gdcm::Scanner::TagToValue mapping;
+    mapping[gdcm::Tag(0x0008, 0x0018)] = "1.2.3";
+
+    mitk::DICOMGDCMTagIndex::Pointer index = mitk::DICOMGDCMTagIndex::New();
+    index->Update(ctFiles.front(), tags, mapping);
+    CPPUNIT_ASSERT(index->IsModified());
+    CPPUNIT_ASSERT(index->Save(indexFilename));
+
+    mitk::DICOMGDCMTagIndex::Pointer loadedIndex = mitk::DICOMGDCMTagIndex::New();
+    CPPUNIT_ASSERT(loadedIndex->Load(indexFilename));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), loadedIndex->GetNumberOfFiles());
+    CPPUNIT_ASSERT(loadedIndex->IsUpToDate(ctFiles.front(), tags));
+    CPPUNIT_ASSERT(!loadedIndex->IsUpToDate(ctFiles.back(), tags));
+
+    gdcm::Scanner::TagToValue loadedMapping = loadedIndex->GetMapping(ctFiles.front());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), loadedMapping.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("1.2.3"), std::string(loadedMapping[gdcm::Tag(0x0008, 0x0018)]));
+  }
+
+  void Load_CorruptedStringLength_ReturnsFalse()
+  {
+    mitk::DICOMGDCMTagIndex::Pointer index = mitk::DICOMGDCMTagIndex::New();
+    index->Update(ctFiles.front(), tags, gdcm::Scanner::TagToValue());
+    CPPUNIT_ASSERT(index->Save(indexFilename));
+
+    // the length of the first file name follows magic number, version and number of entries
+    {
+      std::fstream stream(indexFilename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+      const std::uint32_t length = 0xFFFFFFF0;
+      stream.seekp(16);
+      stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    }
+
+    mitk::DICOMGDCMTagIndex::Pointer loadedIndex = mitk::DICOMGDCMTagIndex::New();
+    CPPUNIT_ASSERT(!loadedIndex->Load(indexFilename));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), loadedIndex->GetNumberOfFiles());
+  }
+
+  void IsUpToDate_UnscannedTag_ReturnsFalse()
+  {
+    mitk::DICOMGDCMTagIndex::Pointer index = mitk::DICOMGDCMTagIndex::New();
+    index->Update(ctFiles.front(), tags, gdcm::Scanner::TagToValue());
+
+    std::set<mitk::DICOMTag> moreTags = tags;
+    moreTags.insert(mitk::DICOMTag(0x0020, 0x0013));
+
+    CPPUNIT_ASSERT(index->IsUpToDate(ctFiles.front(), tags));
+    CPPUNIT_ASSERT(!index->IsUpToDate(ctFiles.front(), moreTags));
+  }
+
+  void Scan_WithIndex_EqualsScanWithoutIndex()
+  {
+    mitk::DICOMTag instanceUID(0x0008, 0x0018);
+
+    mitk::DICOMGDCMTagScanner::Pointer scanner = mitk::DICOMGDCMTagScanner::New();
+    scanner->SetInputFiles(ctFiles);
+    scanner->AddTag(instanceUID);
+    scanner->Scan();
+    mitk::DICOMDatasetAccessingImageFrameList referenceFrames = scanner->GetFrameInfoList();
+
+    // first scan fills the index, second one is answered from it
+    for (unsigned int run = 0; run < 2; ++run)
+    {
+      mitk::DICOMGDCMTagScanner::Pointer indexedScanner = mitk::DICOMGDCMTagScanner::New();
+      indexedScanner->SetTagIndexFilename(indexFilename);
+      indexedScanner->SetInputFiles(ctFiles);
+      indexedScanner->AddTag(instanceUID);
+      indexedScanner->Scan();
+      mitk::DICOMDatasetAccessingImageFrameList frames = indexedScanner->GetFrameInfoList();
+
+      CPPUNIT_ASSERT_EQUAL(referenceFrames.size(), frames.size());
+      for (std::size_t i = 0; i < frames.size(); ++i)
+      {
+        CPPUNIT_ASSERT_EQUAL(referenceFrames[i]->GetTagValueAsString(instanceUID).value,
+                             frames[i]->GetTagValueAsString(instanceUID).value);
+      }
+    }
+
+    mitk::DICOMGDCMTagIndex::Pointer index = mitk::DICOMGDCMTagIndex::New();
+    CPPUNIT_ASSERT(index->Load(indexFilename));
+    CPPUNIT_ASSERT_EQUAL(ctFiles.size(), index->GetNumberOfFiles());
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkDICOMGDCMTagIndex)
@@ -0,0 +1,155 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDICOMGDCMTagScanner.h"
+
+#include "mitkIOUtil.h"
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+
+#include <itkTimeProbe.h>
+#include <itksys/SystemTools.hxx>
+
+#include <cstdio>
+
+class mitkDICOMGDCMTagScannerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkDICOMGDCMTagScannerTestSuite);
+
+  MITK_TEST(SerialScanning);
+  MITK_TEST(ParallelScanning_EqualsSerialScanning);
+  MITK_TEST(Performance_ParallelScanningScales);
+
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::StringList ctFiles;
+  mitk::DICOMTag instanceUID;
+
+  mitk::DICOMDatasetAccessingImageFrameList Scan(const mitk::StringList& files, unsigned int numberOfThreads)
+  {
+    mitk::DICOMGDCMTagScanner::Pointer scanner = mitk::DICOMGDCMTagScanner::New();
+    scanner->SetNumberOfThreads(numberOfThreads);
+    scanner->SetInputFiles(files);
+    scanner->AddTag(instanceUID);
+    scanner->Scan();
+    return scanner->GetFrameInfoList();
+  }
+
+public:
+
+  mitkDICOMGDCMTagScannerTestSuite() : instanceUID(0x0008, 0x0018) {}
+
+  void setUp() override
+  {
+    ctFiles.clear();
+    ctFiles.push_back(GetTestDataFilePath("TinyCTAbdomen/100"));
+    ctFiles.push_back(GetTestDataFilePath("TinyCTAbdomen/101"));
+    ctFiles.push_back(GetTestDataFilePath("TinyCTAbdomen/102"));
+    ctFiles.push_back(GetTestDataFilePath("TinyCTAbdomen/104"));
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void SerialScanning()
+  {
+    mitk::DICOMDatasetAccessingImageFrameList frames = this->Scan(ctFiles, 1);
+    CPPUNIT_ASSERT_MESSAGE("Testing DICOMGDCMTagScanner::GetFrameInfoList()", frames.size() == 4);
+
+    mitk::DICOMDatasetFinding finding = frames[0]->GetTagValueAsString(instanceUID);
+    CPPUNIT_ASSERT_MESSAGE("Testing validity of instance uid finding of frame 0", finding.isValid);
+    CPPUNIT_ASSERT_MESSAGE("Testing value of instance uid finding of frame 0", finding.value == "1.2.276.0.99.1.4.8323329.3795.1303917947.940051");
+
+    finding = frames[3]->GetTagValueAsString(instanceUID);
+    CPPUNIT_ASSERT_MESSAGE("Testing validity of instance uid finding of frame 3", finding.isValid);
+    CPPUNIT_ASSERT_MESSAGE("Testing value of instance uid finding of frame 3", finding.value == "1.2.276.0.99.1.4.8323329.3795.1303917947.940055");
+  }
+
+  void ParallelScanning_EqualsSerialScanning()
+  {
+    // enough files to be split into several shards
+    mitk::StringList manyFiles;
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+      manyFiles.insert(manyFiles.end(), ctFiles.cbegin(), ctFiles.cend());
+    }
+
+    mitk::DICOMDatasetAccessingImageFrameList serialFrames = this->Scan(manyFiles, 1);
+    mitk::DICOMDatasetAccessingImageFrameList parallelFrames = this->Scan(manyFiles, 4);
+
+    CPPUNIT_ASSERT_EQUAL(manyFiles.size(), serialFrames.size());
+    CPPUNIT_ASSERT_EQUAL(serialFrames.size(), parallelFrames.size());
+
+    for (std::size_t i = 0; i < serialFrames.size(); ++i)
+    {
+      CPPUNIT_ASSERT_EQUAL(serialFrames[i]->GetFilenameIfAvailable(), parallelFrames[i]->GetFilenameIfAvailable());
+      CPPUNIT_ASSERT_EQUAL(serialFrames[i]->GetTagValueAsString(instanceUID).value,
+                           parallelFrames[i]->GetTagValueAsString(instanceUID).value);
+    }
+  }
+
+
+  void Performance_ParallelScanningScales()
+  {
+    // a synthetic directory of copies of the test files, the smaller sizes scan a prefix of it
+    const unsigned int numbersOfFiles[] = {1000, 10000, 50000};
+    const unsigned int maximumNumberOfFiles = 50000;
+
+    std::string directory = mitk::IOUtil::CreateTemporaryDirectory("DICOMGDCMTagScannerTest_XXXXXX");
+    mitk::StringList syntheticFiles;
+    char filename[32];
+    for (unsigned int i = 0; i < maximumNumberOfFiles; ++i)
+    {
+      std::sprintf(filename, "/%05u.dcm", i);
+      syntheticFiles.push_back(directory + filename);
+      CPPUNIT_ASSERT(itksys::SystemTools::CopyFileAlways(ctFiles[i % ctFiles.size()], syntheticFiles.back()));
+    }
+
+    for (unsigned int numberOfFiles : numbersOfFiles)
+    {
+      const mitk::StringList files(syntheticFiles.cbegin(), syntheticFiles.cbegin() + numberOfFiles);
+
+      // the files were just written, so both scans read them from the file system cache
+      mitk::DICOMDatasetAccessingImageFrameList serialFrames;
+      itk::TimeProbe serialProbe;
+      serialProbe.Start();
+      serialFrames = this->Scan(files, 1);
+      serialProbe.Stop();
+
+      mitk::DICOMDatasetAccessingImageFrameList parallelFrames;
+      itk::TimeProbe parallelProbe;
+      parallelProbe.Start();
+      parallelFrames = this->Scan(files, 0);
+      parallelProbe.Stop();
+
+      CPPUNIT_ASSERT_EQUAL(files.size(), serialFrames.size());
+      CPPUNIT_ASSERT_EQUAL(serialFrames.size(), parallelFrames.size());
+      CPPUNIT_ASSERT_EQUAL(serialFrames.back()->GetTagValueAsString(instanceUID).value,
+                           parallelFrames.back()->GetTagValueAsString(instanceUID).value);
+
+      MITK_INFO << "Scanning " << numberOfFiles << " files: " << serialProbe.GetTotal() * 1000.0 << " ms (serial), "
+                << parallelProbe.GetTotal() * 1000.0 << " ms (parallel), speedup "
+                << serialProbe.GetTotal() / parallelProbe.GetTotal();
+    }
+
+    itksys::SystemTools::RemoveADirectory(directory);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkDICOMGDCMTagScanner)
@@ -19,9 +19,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkAutoSelectingDICOMReaderService.h"
 #include "mitkClassicDICOMSeriesReaderService.h"
 #include "mitkDICOMTagsOfInterestService.h"
+#include "mitkDICOMGDCMTagIndex.h"
 
 #include <usModuleContext.h>
 
+#include <itksys/SystemTools.hxx>
+
 namespace mitk {
 
   void DICOMReaderServicesActivator::Load(us::ModuleContext* context)
@@ -37,6 +40,14 @@ namespace mitk {
     {
       m_DICOMTagsOfInterestService->AddTagOfInterest(tag.first);
     }
+
+    // let re-opened directories skip header parsing if the application provides a persistent storage
+    const std::string tagIndexDirectory = context->GetDataFile("DICOMTagIndex");
+    if (!tagIndexDirectory.empty() && DICOMGDCMTagIndex::GetDefaultIndexDirectory().empty() &&
+        itksys::SystemTools::MakeDirectory(tagIndexDirectory.c_str()))
+    {
+      DICOMGDCMTagIndex::SetDefaultIndexDirectory(tagIndexDirectory);
+    }
   }
 
   void DICOMReaderServicesActivator::Unload(us::ModuleContext*)
@@ -19,6 +19,7 @@ set(CPP_FILES
   mitkEllipsoid.cpp
   mitkGridRepresentationProperty.cpp
   mitkGridVolumeMapperProperty.cpp
+  mitkImageCompressionCodec.cpp
   mitkLabeledImageLookupTable.cpp
   mitkLabeledImageVolumeCalculator.cpp
   mitkLineOperation.cpp
@@ -35,7 +35,7 @@ namespace mitk
    used to keep the image alive -- the purpose of this class is undo and the undo
    stack should not keep things alive forever.
 
-   To save memory, zlib compression is used via CompressedImageContainer.
+   To save memory, the diff image is compressed via CompressedImageContainer.
 
    @ingroup Undo
    @ingroup ToolManagerEtAl
@@ -81,6 +81,9 @@ namespace mitk
     Image::Pointer GetDiffImage();
 
     bool IsImageStillValid() { return m_ImageStillValid; }
+
+    /** \brief Size of the compressed diff image. */
+    virtual std::size_t GetMemoryUsage() const override;
   };
 
 } // namespace mitk
@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkGeometry3D.h"
 #include "mitkImage.h"
 #include "mitkImageDataItem.h"
+#include "mitkImageCompressionCodec.h"
 
 #include <itkObject.h>
 
@@ -32,7 +33,10 @@ namespace mitk
   /**
     \brief Holds one (compressed) mitk::Image
 
-    Uses zlib to compress the data of an mitk::Image.
+    Compresses the data of an mitk::Image using an ImageCompressionCodec (by default a fast
+    LZ4ImageCompressionCodec). Each time step is split into chunks of GetChunkSize() bytes,
+    which are compressed and uncompressed independently and in parallel, so even a single
+    slice benefits from several cores.
 
     $Author$
   */
@@ -56,9 +60,34 @@ namespace mitk
      * This Method hold no buffer, so the uncompression algorithm will be
      * executed every time you call this method. Don't overdo it.
      *
+     * Returns nullptr if no image was set or the compressed data cannot be decompressed.
      */
     Image::Pointer GetImage();
 
+    /**
+     * \brief Sets the codec used by subsequent calls of SetImage().
+     *
+     * The codec is shared, it must not be changed while the container uses it.
+     * Passing nullptr restores the default codec.
+     */
+    void SetCodec(ImageCompressionCodec *codec);
+    ImageCompressionCodec *GetCodec() const;
+
+    /**
+     * \brief Sets the size of the independently compressed chunks for subsequent calls of SetImage().
+     *
+     * Smaller chunks parallelize better, larger ones compress slightly better. Default is 64 KiB.
+     */
+    void SetChunkSize(std::size_t bytes);
+    std::size_t GetChunkSize() const;
+
+    /**
+     * \brief Number of bytes occupied by the compressed data of all time steps.
+     */
+    std::size_t GetCompressedSize() const;
+
+    static const std::size_t DefaultChunkSize;
+
   protected:
     CompressedImageContainer(); // purposely hidden
     virtual ~CompressedImageContainer();
@@ -72,8 +101,20 @@ namespace mitk
 
     unsigned int m_NumberOfTimeSteps;
 
-    /// one for each timestep. first = pointer to compressed data; second = size of buffer in bytes
-    std::vector<std::pair<unsigned char *, unsigned long>> m_ByteBuffers;
+    /// chunk size for the next SetImage() call
+    std::size_t m_ChunkSize;
+
+    /// chunk size of m_ByteBuffers
+    std::size_t m_BufferChunkSize;
+
+    /// compressed data, one buffer for each chunk, ordered by timestep
+    std::vector<std::vector<unsigned char>> m_ByteBuffers;
+
+    /// codec for the next SetImage() call
+    ImageCompressionCodec::Pointer m_Codec;
+
+    /// codec that compressed m_ByteBuffers
+    ImageCompressionCodec::Pointer m_BufferCodec;
 
     BaseGeometry::Pointer m_ImageGeometry;
   };
@@ -0,0 +1,139 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkImageCompressionCodec_h_Included
+#define mitkImageCompressionCodec_h_Included
+
+#include "MitkDataTypesExtExports.h"
+#include "mitkCommon.h"
+
+#include <itkLightObject.h>
+
+#include <cstddef>
+
+namespace mitk
+{
+  /**
+    \brief Compression algorithm used by CompressedImageContainer.
+
+    Sub-classes implement a pair of buffer-to-buffer compression and decompression methods.
+    CompressedImageContainer calls them concurrently for different time steps, so implementations
+    must not modify any state in Compress() and Decompress().
+  */
+  class MITKDATATYPESEXT_EXPORT ImageCompressionCodec : public itk::LightObject
+  {
+  public:
+    mitkClassMacroItkParent(ImageCompressionCodec, itk::LightObject);
+
+    /** \brief Upper bound of the compressed size of @a sourceSize bytes, used to allocate the output buffer. */
+    virtual std::size_t GetMaximumCompressedSize(std::size_t sourceSize) const = 0;
+
+    /**
+      \brief Compresses @a sourceSize bytes into @a destination, which provides @a destinationCapacity bytes.
+      \return the number of bytes written to @a destination, 0 on failure
+    */
+    virtual std::size_t Compress(const unsigned char *source,
+                                 std::size_t sourceSize,
+                                 unsigned char *destination,
+                                 std::size_t destinationCapacity) const = 0;
+
+    /**
+      \brief Decompresses @a sourceSize bytes into @a destination, which has to take exactly @a destinationSize bytes.
+      \return false if the data is corrupted or does not match @a destinationSize
+    */
+    virtual bool Decompress(const unsigned char *source,
+                            std::size_t sourceSize,
+                            unsigned char *destination,
+                            std::size_t destinationSize) const = 0;
+
+  protected:
+    ImageCompressionCodec();
+    virtual ~ImageCompressionCodec();
+
+  private:
+    ImageCompressionCodec(const ImageCompressionCodec &);
+    ImageCompressionCodec &operator=(const ImageCompressionCodec &);
+  };
+
+  /**
+    \brief zlib based ImageCompressionCodec.
+
+    The compression level trades speed for ratio: 1 (default) is fastest and suits interactive
+    use like undo slices, 9 yields the smallest buffers.
+  */
+  class MITKDATATYPESEXT_EXPORT ZLibImageCompressionCodec : public ImageCompressionCodec
+  {
+  public:
+    mitkClassMacro(ZLibImageCompressionCodec, ImageCompressionCodec);
+    itkFactorylessNewMacro(Self);
+
+    /** \brief zlib compression level in the range [1, 9]. */
+    void SetCompressionLevel(int level);
+    int GetCompressionLevel() const;
+
+    virtual std::size_t GetMaximumCompressedSize(std::size_t sourceSize) const override;
+
+    virtual std::size_t Compress(const unsigned char *source,
+                                 std::size_t sourceSize,
+                                 unsigned char *destination,
+                                 std::size_t destinationCapacity) const override;
+
+    virtual bool Decompress(const unsigned char *source,
+                            std::size_t sourceSize,
+                            unsigned char *destination,
+                            std::size_t destinationSize) const override;
+
+  protected:
+    ZLibImageCompressionCodec();
+    virtual ~ZLibImageCompressionCodec();
+
+    int m_CompressionLevel;
+  };
+
+  /**
+    \brief Fast ImageCompressionCodec writing the LZ4 block format.
+
+    Uses a single-pass greedy match search, which compresses and decompresses several times
+    faster than zlib at a somewhat lower ratio. This makes it the default for interactive use
+    like undo slices. The format follows the LZ4 block specification, so the buffers are
+    compatible with other LZ4 implementations; MITK does not depend on liblz4 itself.
+  */
+  class MITKDATATYPESEXT_EXPORT LZ4ImageCompressionCodec : public ImageCompressionCodec
+  {
+  public:
+    mitkClassMacro(LZ4ImageCompressionCodec, ImageCompressionCodec);
+    itkFactorylessNewMacro(Self);
+
+    virtual std::size_t GetMaximumCompressedSize(std::size_t sourceSize) const override;
+
+    virtual std::size_t Compress(const unsigned char *source,
+                                 std::size_t sourceSize,
+                                 unsigned char *destination,
+                                 std::size_t destinationCapacity) const override;
+
+    virtual bool Decompress(const unsigned char *source,
+                            std::size_t sourceSize,
+                            unsigned char *destination,
+                            std::size_t destinationSize) const override;
+
+  protected:
+    LZ4ImageCompressionCodec();
+    virtual ~LZ4ImageCompressionCodec();
+  };
+
+} // namespace
+
+#endif
@@ -62,6 +62,11 @@ void mitk::ApplyDiffImageOperation::OnImageDeleted()
   m_ImageStillValid = false;
 }
 
+std::size_t mitk::ApplyDiffImageOperation::GetMemoryUsage() const
+{
+  return zlibContainer.IsNotNull() ? zlibContainer->GetCompressedSize() : 0;
+}
+
 mitk::Image::Pointer mitk::ApplyDiffImageOperation::GetDiffImage()
 {
   // uncompress image to create a valid mitk::Image
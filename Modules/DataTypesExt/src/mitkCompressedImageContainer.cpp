@@ -16,39 +16,74 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkCompressedImageContainer.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 
-#include "itk_zlib.h"
+#include <algorithm>
+#include <memory>
 
-#include <stdlib.h>
+const std::size_t mitk::CompressedImageContainer::DefaultChunkSize = 64 * 1024;
 
-mitk::CompressedImageContainer::CompressedImageContainer() : m_PixelType(nullptr), m_ImageGeometry(nullptr)
+mitk::CompressedImageContainer::CompressedImageContainer()
+  : m_PixelType(nullptr),
+    m_ChunkSize(DefaultChunkSize),
+    m_BufferChunkSize(DefaultChunkSize),
+    m_Codec(LZ4ImageCompressionCodec::New().GetPointer()),
+    m_ImageGeometry(nullptr)
 {
 }
 
 mitk::CompressedImageContainer::~CompressedImageContainer()
 {
-  for (auto iter = m_ByteBuffers.begin(); iter != m_ByteBuffers.end(); ++iter)
+  delete m_PixelType;
+}
+
+void mitk::CompressedImageContainer::SetCodec(ImageCompressionCodec *codec)
+{
+  if (codec != nullptr)
+  {
+    m_Codec = codec;
+  }
+  else
   {
-    free(iter->first);
+    m_Codec = LZ4ImageCompressionCodec::New().GetPointer();
   }
+}
 
-  delete m_PixelType;
+mitk::ImageCompressionCodec *mitk::CompressedImageContainer::GetCodec() const
+{
+  return m_Codec;
 }
 
-void mitk::CompressedImageContainer::SetImage(Image *image)
+void mitk::CompressedImageContainer::SetChunkSize(std::size_t bytes)
 {
-  for (auto iter = m_ByteBuffers.begin(); iter != m_ByteBuffers.end(); ++iter)
+  m_ChunkSize = std::max<std::size_t>(bytes, 1);
+}
+
+std::size_t mitk::CompressedImageContainer::GetChunkSize() const
+{
+  return m_ChunkSize;
+}
+
+std::size_t mitk::CompressedImageContainer::GetCompressedSize() const
+{
+  std::size_t size(0);
+  for (const auto &buffer : m_ByteBuffers)
   {
-    free(iter->first);
+    size += buffer.size();
   }
+  return size;
+}
 
+void mitk::CompressedImageContainer::SetImage(Image *image)
+{
   m_ByteBuffers.clear();
 
-  // Compress diff image using zlib (will be restored on demand)
+  // Compress diff image (will be restored on demand)
   // determine memory size occupied by voxel data
   m_ImageDimension = image->GetDimension();
   m_ImageDimensions.clear();
 
+  delete m_PixelType;
   m_PixelType = new mitk::PixelType(image->GetPixelType());
 
   m_OneTimeStepImageSizeInBytes = m_PixelType->GetSize(); // bits per element divided by 8
@@ -70,58 +105,47 @@ void mitk::CompressedImageContainer::SetImage(Image *image)
     m_NumberOfTimeSteps = image->GetDimension(3);
   }
 
+  m_BufferCodec = m_Codec;
+  m_BufferChunkSize = m_ChunkSize;
+
+  const std::size_t timeStepSize = m_OneTimeStepImageSizeInBytes;
+  const std::size_t chunkSize = m_BufferChunkSize;
+  const std::size_t chunksPerTimeStep =
+    std::max<std::size_t>(timeStepSize / chunkSize + (timeStepSize % chunkSize != 0 ? 1 : 0), 1);
+  m_ByteBuffers.resize(m_NumberOfTimeSteps * chunksPerTimeStep);
+
+  // access all time steps up front, image accessors are not meant to be requested concurrently
+  std::vector<std::unique_ptr<ImageReadAccessor>> accessors;
   for (unsigned int timestep = 0; timestep < m_NumberOfTimeSteps; ++timestep)
   {
-    // allocate a buffer as specified by zlib
-    unsigned long bufferSize =
-      m_OneTimeStepImageSizeInBytes + static_cast<unsigned long>(m_OneTimeStepImageSizeInBytes * 0.2) + 12;
-    unsigned char *byteBuffer = (unsigned char *)malloc(bufferSize);
+    accessors.emplace_back(new ImageReadAccessor(image, image->GetVolumeData(timestep)));
+  }
 
-    if (itk::Object::GetDebug())
-    {
-      // compress image here into a buffer
-      MITK_INFO << "Using ZLib version: '" << zlibVersion() << "'" << std::endl
-                << "Attempting to compress " << m_OneTimeStepImageSizeInBytes << " image bytes into a buffer of size "
-                << bufferSize << std::endl;
-    }
+  const ImageCompressionCodec *codec = m_BufferCodec;
+  const int numberOfChunks = static_cast<int>(m_ByteBuffers.size());
 
-    ImageReadAccessor imgAcc(image, image->GetVolumeData(timestep));
-    ::Bytef *dest(byteBuffer);
-    ::uLongf destLen(bufferSize);
-    ::Bytef *source((unsigned char *)imgAcc.GetData());
-    ::uLongf sourceLen(m_OneTimeStepImageSizeInBytes);
-    int zlibRetVal = ::compress(dest, &destLen, source, sourceLen);
-    if (itk::Object::GetDebug())
-    {
-      if (zlibRetVal == Z_OK)
-      {
-        MITK_INFO << "Success, using " << destLen << " bytes of the buffer (ratio "
-                  << ((double)destLen / (double)sourceLen) << ")" << std::endl;
-      }
-      else
-      {
-        switch (zlibRetVal)
-        {
-          case Z_MEM_ERROR:
-            MITK_ERROR << "not enough memory" << std::endl;
-            break;
-          case Z_BUF_ERROR:
-            MITK_ERROR << "output buffer too small" << std::endl;
-            break;
-          default:
-            MITK_ERROR << "other, unspecified error" << std::endl;
-            break;
-        }
-      }
-    }
+#pragma omp parallel for schedule(dynamic) if (numberOfChunks > 1)
+  for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+  {
+    const std::size_t timestep = chunk / chunksPerTimeStep;
+    const std::size_t offset = (chunk % chunksPerTimeStep) * chunkSize;
+    const std::size_t sourceSize = std::min(chunkSize, timeStepSize - offset);
+
+    std::vector<unsigned char> &buffer = m_ByteBuffers[chunk];
+    buffer.resize(codec->GetMaximumCompressedSize(sourceSize));
 
-    // only use the neccessary amount of memory, realloc the buffer!
-    byteBuffer = (unsigned char *)realloc(byteBuffer, destLen);
-    bufferSize = destLen;
-    // MITK_INFO << "Using " << bufferSize << " bytes to store compressed image (" << destLen << " needed)" <<
-    // std::endl;
+    const std::size_t compressedSize = codec->Compress(
+      static_cast<const unsigned char *>(accessors[timestep]->GetData()) + offset, sourceSize, buffer.data(), buffer.size());
 
-    m_ByteBuffers.push_back(std::pair<unsigned char *, unsigned long>(byteBuffer, bufferSize));
+    // only keep the neccessary amount of memory
+    buffer.resize(compressedSize);
+    buffer.shrink_to_fit();
+  }
+
+  if (itk::Object::GetDebug())
+  {
+    MITK_INFO << "Compressed " << m_NumberOfTimeSteps * m_OneTimeStepImageSizeInBytes << " image bytes into "
+              << this->GetCompressedSize() << " bytes using " << codec->GetNameOfClass();
   }
 }
 
@@ -139,40 +163,42 @@ mitk::Image::Pointer mitk::CompressedImageContainer::GetImage()
   image->Initialize(*m_PixelType, m_ImageDimension, dims); // this IS needed, right ?? But it does allocate memory ->
                                                            // does create one big lump of memory (also in windows)
 
-  unsigned int timeStep(0);
-  for (auto iter = m_ByteBuffers.begin(); iter != m_ByteBuffers.end(); ++iter, ++timeStep)
+  std::vector<std::unique_ptr<ImageWriteAccessor>> accessors;
+  for (unsigned int timestep = 0; timestep < m_NumberOfTimeSteps; ++timestep)
   {
-    ImageReadAccessor imgAcc(image, image->GetVolumeData(timeStep));
-    ::Bytef *dest((unsigned char *)imgAcc.GetData());
-    ::uLongf destLen(m_OneTimeStepImageSizeInBytes);
-    ::Bytef *source(iter->first);
-    ::uLongf sourceLen(iter->second);
-    int zlibRetVal = ::uncompress(dest, &destLen, source, sourceLen);
-    if (itk::Object::GetDebug())
-    {
-      if (zlibRetVal == Z_OK)
-      {
-        MITK_INFO << "Success, destLen now " << destLen << " bytes" << std::endl;
-      }
-      else
-      {
-        switch (zlibRetVal)
-        {
-          case Z_DATA_ERROR:
-            MITK_ERROR << "compressed data corrupted" << std::endl;
-            break;
-          case Z_MEM_ERROR:
-            MITK_ERROR << "not enough memory" << std::endl;
-            break;
-          case Z_BUF_ERROR:
-            MITK_ERROR << "output buffer too small" << std::endl;
-            break;
-          default:
-            MITK_ERROR << "other, unspecified error" << std::endl;
-            break;
-        }
-      }
-    }
+    accessors.emplace_back(new ImageWriteAccessor(image, image->GetVolumeData(timestep)));
+  }
+
+  const ImageCompressionCodec *codec = m_BufferCodec;
+  const std::size_t timeStepSize = m_OneTimeStepImageSizeInBytes;
+  const std::size_t chunkSize = m_BufferChunkSize;
+  const std::size_t chunksPerTimeStep = m_ByteBuffers.size() / m_NumberOfTimeSteps;
+  const int numberOfChunks = static_cast<int>(m_ByteBuffers.size());
+
+  int numberOfFailures = 0;
+
+#pragma omp parallel for schedule(dynamic) if (numberOfChunks > 1) reduction(+ : numberOfFailures)
+  for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+  {
+    const std::size_t timestep = chunk / chunksPerTimeStep;
+    const std::size_t offset = (chunk % chunksPerTimeStep) * chunkSize;
+    const std::size_t destinationSize = std::min(chunkSize, timeStepSize - offset);
+
+    const std::vector<unsigned char> &buffer = m_ByteBuffers[chunk];
+    if (!codec->Decompress(buffer.data(),
+                           buffer.size(),
+                           static_cast<unsigned char *>(accessors[timestep]->GetData()) + offset,
+                           destinationSize))
+      ++numberOfFailures;
+  }
+
+  accessors.clear();
+
+  if (numberOfFailures > 0)
+  {
+    MITK_ERROR << "Could not decompress " << numberOfFailures << " of " << numberOfChunks << " chunks using "
+               << codec->GetNameOfClass() << ", the compressed data is corrupted.";
+    return nullptr;
   }
 
   image->SetGeometry(m_ImageGeometry);
@@ -0,0 +1,296 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImageCompressionCodec.h"
+
+#include "itk_zlib.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+  // constants of the LZ4 block format
+  const std::size_t LZ4MinMatch = 4;
+  const std::size_t LZ4LastLiterals = 5;   // the last bytes of a block are always literals
+  const std::size_t LZ4MatchFindLimit = 12; // the last match starts at least this far before the end
+  const std::size_t LZ4MaxOffset = 65535;
+  const unsigned int LZ4HashLog = 12;
+
+  inline std::uint32_t ReadUInt32(const unsigned char *p)
+  {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  inline unsigned int LZ4Hash(std::uint32_t sequence)
+  {
+    return (sequence * 2654435761U) >> (32 - LZ4HashLog);
+  }
+
+  // writes the bytes which extend a literal or match length that does not fit into its 4 bit token field
+  inline unsigned char *WriteLZ4Length(unsigned char *op, std::size_t length)
+  {
+    for (length -= 15; length >= 255; length -= 255)
+      *op++ = 255;
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+  }
+
+  inline bool ReadLZ4Length(const unsigned char *&ip, const unsigned char *end, std::size_t &length)
+  {
+    unsigned char byte;
+    do
+    {
+      if (ip >= end)
+        return false;
+      byte = *ip++;
+      length += byte;
+    } while (byte == 255);
+    return true;
+  }
+}
+
+mitk::ImageCompressionCodec::ImageCompressionCodec()
+{
+}
+
+mitk::ImageCompressionCodec::~ImageCompressionCodec()
+{
+}
+
+mitk::ZLibImageCompressionCodec::ZLibImageCompressionCodec() : m_CompressionLevel(Z_BEST_SPEED)
+{
+}
+
+mitk::ZLibImageCompressionCodec::~ZLibImageCompressionCodec()
+{
+}
+
+void mitk::ZLibImageCompressionCodec::SetCompressionLevel(int level)
+{
+  m_CompressionLevel = std::max(static_cast<int>(Z_BEST_SPEED), std::min(static_cast<int>(Z_BEST_COMPRESSION), level));
+}
+
+int mitk::ZLibImageCompressionCodec::GetCompressionLevel() const
+{
+  return m_CompressionLevel;
+}
+
+std::size_t mitk::ZLibImageCompressionCodec::GetMaximumCompressedSize(std::size_t sourceSize) const
+{
+  return ::compressBound(static_cast<uLong>(sourceSize));
+}
+
+std::size_t mitk::ZLibImageCompressionCodec::Compress(const unsigned char *source,
+                                                      std::size_t sourceSize,
+                                                      unsigned char *destination,
+                                                      std::size_t destinationCapacity) const
+{
+  ::uLongf destinationLength(destinationCapacity);
+  const int zlibRetVal =
+    ::compress2(destination, &destinationLength, source, static_cast<uLong>(sourceSize), m_CompressionLevel);
+
+  if (zlibRetVal != Z_OK)
+  {
+    MITK_ERROR << "zlib compression failed with error code " << zlibRetVal;
+    return 0;
+  }
+
+  return destinationLength;
+}
+
+bool mitk::ZLibImageCompressionCodec::Decompress(const unsigned char *source,
+                                                 std::size_t sourceSize,
+                                                 unsigned char *destination,
+                                                 std::size_t destinationSize) const
+{
+  ::uLongf destinationLength(destinationSize);
+  const int zlibRetVal = ::uncompress(destination, &destinationLength, source, static_cast<uLong>(sourceSize));
+
+  if (zlibRetVal != Z_OK || destinationLength != destinationSize)
+  {
+    MITK_ERROR << "zlib decompression failed with error code " << zlibRetVal;
+    return false;
+  }
+
+  return true;
+}
+
+mitk::LZ4ImageCompressionCodec::LZ4ImageCompressionCodec()
+{
+}
+
+mitk::LZ4ImageCompressionCodec::~LZ4ImageCompressionCodec()
+{
+}
+
+std::size_t mitk::LZ4ImageCompressionCodec::GetMaximumCompressedSize(std::size_t sourceSize) const
+{
+  return sourceSize + sourceSize / 255 + 16;
+}
+
+std::size_t mitk::LZ4ImageCompressionCodec::Compress(const unsigned char *source,
+                                                     std::size_t sourceSize,
+                                                     unsigned char *destination,
+                                                     std::size_t destinationCapacity) const
+{
+  // a worst case sized buffer spares the bounds checks while writing
+  if (destinationCapacity < this->GetMaximumCompressedSize(sourceSize))
+  {
+    MITK_ERROR << "LZ4 compression needs an output buffer of " << this->GetMaximumCompressedSize(sourceSize)
+               << " bytes, got " << destinationCapacity;
+    return 0;
+  }
+
+  const unsigned char *ip = source;
+  const unsigned char *anchor = source;
+  const unsigned char *const end = source + sourceSize;
+  unsigned char *op = destination;
+
+  if (sourceSize > LZ4MatchFindLimit)
+  {
+    const unsigned char *const searchLimit = end - LZ4MatchFindLimit;
+    const unsigned char *const matchLimit = end - LZ4LastLiterals;
+
+    // positions of the last occurrence of each hashed 4 byte sequence, local to keep Compress() reentrant
+    std::uint32_t table[1 << LZ4HashLog] = {};
+
+    while (ip <= searchLimit)
+    {
+      const std::uint32_t sequence = ReadUInt32(ip);
+      const unsigned int hash = LZ4Hash(sequence);
+      const unsigned char *reference = source + table[hash];
+      table[hash] = static_cast<std::uint32_t>(ip - source);
+
+      if (reference >= ip || static_cast<std::size_t>(ip - reference) > LZ4MaxOffset || ReadUInt32(reference) != sequence)
+      {
+        // skip faster through incompressible data
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+
+      while (ip > anchor && reference > source && ip[-1] == reference[-1])
+      {
+        --ip;
+        --reference;
+      }
+
+      const unsigned char *matchEnd = ip + LZ4MinMatch;
+      const unsigned char *referenceEnd = reference + LZ4MinMatch;
+      while (matchEnd < matchLimit && *matchEnd == *referenceEnd)
+      {
+        ++matchEnd;
+        ++referenceEnd;
+      }
+
+      const std::size_t literalLength = ip - anchor;
+      const std::size_t matchLength = matchEnd - ip - LZ4MinMatch;
+      const std::size_t offset = ip - reference;
+
+      unsigned char *token = op++;
+      *token = static_cast<unsigned char>(std::min<std::size_t>(literalLength, 15) << 4);
+      if (literalLength >= 15)
+        op = WriteLZ4Length(op, literalLength);
+      std::memcpy(op, anchor, literalLength);
+      op += literalLength;
+
+      *op++ = static_cast<unsigned char>(offset & 0xff);
+      *op++ = static_cast<unsigned char>(offset >> 8);
+
+      *token |= static_cast<unsigned char>(std::min<std::size_t>(matchLength, 15));
+      if (matchLength >= 15)
+        op = WriteLZ4Length(op, matchLength);
+
+      ip = anchor = matchEnd;
+    }
+  }
+
+  // the block ends with a sequence of literals only
+  const std::size_t literalLength = end - anchor;
+  *op++ = static_cast<unsigned char>(std::min<std::size_t>(literalLength, 15) << 4);
+  if (literalLength >= 15)
+    op = WriteLZ4Length(op, literalLength);
+  std::memcpy(op, anchor, literalLength);
+  op += literalLength;
+
+  return op - destination;
+}
+
+bool mitk::LZ4ImageCompressionCodec::Decompress(const unsigned char *source,
+                                                std::size_t sourceSize,
+                                                unsigned char *destination,
+                                                std::size_t destinationSize) const
+{
+  const unsigned char *ip = source;
+  const unsigned char *const end = source + sourceSize;
+  unsigned char *op = destination;
+  unsigned char *const destinationEnd = destination + destinationSize;
+
+  while (ip < end)
+  {
+    const unsigned char token = *ip++;
+
+    std::size_t literalLength = token >> 4;
+    if (literalLength == 15 && !ReadLZ4Length(ip, end, literalLength))
+      break;
+    if (literalLength > static_cast<std::size_t>(end - ip) ||
+        literalLength > static_cast<std::size_t>(destinationEnd - op))
+      break;
+    std::memcpy(op, ip, literalLength);
+    ip += literalLength;
+    op += literalLength;
+
+    if (ip == end)
+    {
+      if (op == destinationEnd)
+        return true;
+      break;
+    }
+
+    if (end - ip < 2)
+      break;
+    const std::size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<std::size_t>(op - destination))
+      break;
+
+    std::size_t matchLength = token & 15;
+    if (matchLength == 15 && !ReadLZ4Length(ip, end, matchLength))
+      break;
+    matchLength += LZ4MinMatch;
+    if (matchLength > static_cast<std::size_t>(destinationEnd - op))
+      break;
+
+    // matches may overlap the bytes they produce, which repeats a pattern
+    const unsigned char *match = op - offset;
+    if (offset >= matchLength)
+    {
+      std::memcpy(op, match, matchLength);
+      op += matchLength;
+    }
+    else
+    {
+      for (unsigned char *const matchEnd = op + matchLength; op < matchEnd;)
+        *op++ = *match++;
+    }
+  }
+
+  MITK_ERROR << "LZ4 decompression failed, the data is corrupted or does not match " << destinationSize << " bytes";
+  return false;
+}
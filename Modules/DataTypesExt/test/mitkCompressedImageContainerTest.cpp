@@ -20,6 +20,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageDataItem.h"
 #include "mitkImageReadAccessor.h"
 
+#include <limits>
+
 class mitkCompressedImageContainerTestClass
 {
 public:
@@ -28,6 +30,13 @@ public:
     container->SetImage(image);                                     // compress
     mitk::Image::Pointer uncompressedImage = container->GetImage(); // uncompress
 
+    if (uncompressedImage.IsNull())
+    {
+      ++numberFailed;
+      std::cerr << "  (EE) Uncompression failed" << std::endl;
+      return;
+    }
+
     // check dimensions
     if (image->GetDimension() != uncompressedImage->GetDimension())
     {
@@ -163,9 +172,42 @@ int mitkCompressedImageContainerTest(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
+  if (dynamic_cast<mitk::LZ4ImageCompressionCodec *>(container->GetCodec()) == nullptr)
+  {
+    ++numberFailed;
+    std::cerr << "  (EE) Default codec is not LZ4" << std::endl;
+  }
+
+  if (container->GetImage().IsNotNull())
+  {
+    ++numberFailed;
+    std::cerr << "  (EE) Empty container returned an image" << std::endl;
+  }
+
   // some real work
   mitkCompressedImageContainerTestClass::Test(container, image, numberFailed);
 
+  if (container->GetCompressedSize() == 0)
+  {
+    ++numberFailed;
+    std::cerr << "  (EE) Compressed size not reported" << std::endl;
+  }
+
+  std::cout << "Testing chunks which do not divide the time steps evenly" << std::endl;
+  container->SetChunkSize(1000);
+  mitkCompressedImageContainerTestClass::Test(container, image, numberFailed);
+
+  std::cout << "Testing one chunk per time step" << std::endl;
+  container->SetChunkSize(std::numeric_limits<std::size_t>::max());
+  mitkCompressedImageContainerTestClass::Test(container, image, numberFailed);
+  container->SetChunkSize(mitk::CompressedImageContainer::DefaultChunkSize);
+
+  std::cout << "Testing strongest zlib compression" << std::endl;
+  mitk::ZLibImageCompressionCodec::Pointer codec = mitk::ZLibImageCompressionCodec::New();
+  codec->SetCompressionLevel(9);
+  container->SetCodec(codec);
+  mitkCompressedImageContainerTestClass::Test(container, image, numberFailed);
+
   std::cout << "Testing destruction" << std::endl;
 
   // freeing
@@ -32,11 +32,23 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkOdfSource.h"
 #include "vtkThickPlane.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 namespace mitk {
 
 //##Documentation
 //## @brief Mapper for spherical object densitiy function representations
 //##
+//## The glyph geometry is built directly from the ODF values, in parallel for all glyphs of a slice, and passed to
+//## VTK as one poly data object. Glyphs are cached per voxel and time step, so revisiting a slice only assembles
+//## the cached geometry. After a slice is shown, the glyphs of its two neighbouring slices are computed in a
+//## background thread. The cache is cleared if the image or a property that changes the glyph shape is modified.
+//##
 template<class TPixelType, int NrOdfDirections>
 class OdfVtkMapper2D : public VtkMapper
 {
@@ -98,6 +110,7 @@ public:
         vtkSmartPointer< vtkPolyData >                        m_TemplateOdf;
 
         itk::TimeStamp                      m_LastUpdateTime;
+        OdfDisplayGeometry                  m_LastDisplayGeometry;
 
         /** \brief Default constructor of the local storage. */
         LocalStorage();
@@ -112,7 +125,6 @@ protected:
     OdfVtkMapper2D();
     virtual ~OdfVtkMapper2D();
 
-    static void GlyphMethod(void *arg);
     bool IsPlaneRotated(mitk::BaseRenderer* renderer);
     static bool m_toggleTensorEllipsoidView;
     static bool m_toggleColourisationMode;
@@ -120,19 +132,72 @@ protected:
 
     typedef vnl_matrix_fixed<double, 3, 3> DirectionsType;
 
+    /** Geometry of one glyph, centered at the origin and without the spacing dependent scaling */
+    struct OdfGlyph
+    {
+        std::vector<float>  Points;     // 3 per template point
+        std::vector<float>  Normals;    // 3 per template point
+        std::vector<float>  CellColors; // 1 per template cell
+        double              Rgba[4];    // tensor colourisation
+    };
+
+    /** Everything besides the voxel values that changes the shape or colour of a glyph */
+    struct GlyphParameters
+    {
+        const mitk::BaseData*   Data;
+        unsigned long           DataMTime;
+        float                   Scaling;
+        int                     Normalization;
+        int                     ScaleBy;
+        float                   IndexParam1;
+        float                   IndexParam2;
+        bool                    TensorEllipsoidView;
+        bool                    ColourisationMode;
+
+        bool operator==(const GlyphParameters& other) const;
+    };
+
+    /** Points and cells of the unit sphere all glyphs are deformed from */
+    struct GlyphTemplate
+    {
+        std::vector<float>      Points;
+        std::vector<vtkIdType>  Cells; // legacy vtkCellArray layout: number of points followed by the point ids
+        vtkIdType               NumberOfCells;
+    };
+
+    struct CachedGlyph
+    {
+        std::shared_ptr<const OdfGlyph> Glyph;
+        unsigned long                   LastUse;
+    };
+
+    typedef unsigned long long GlyphKey;
+
+    static GlyphKey GetGlyphKey(int timeStep, vtkIdType voxel){ return (static_cast<GlyphKey>(timeStep) << 40) | static_cast<GlyphKey>(voxel); }
+    static void ComputeGlyph(const GlyphTemplate& glyphTemplate, const GlyphParameters& parameters, const double* values, int numberOfComponents, OdfGlyph& glyph);
+    static std::vector<vtkIdType> SelectGlyphVoxels(const std::vector<vtkIdType>& voxels, int maxNumber, bool random);
+
+    /** Clears the glyph cache if the image or a glyph property changed */
+    void UpdateGlyphParameters();
+    /** Builds the poly data of the glyphs of the given voxels, computing the ones missing in the cache in parallel */
+    vtkSmartPointer<vtkPolyData> GenerateGlyphs(const std::vector<vtkIdType>& voxels, double additionalScale);
+    /** Starts computing the glyphs of the slices next to the given voxels along @a axis in the background */
+    void PrefetchNeighbouringSlices(const std::vector<vtkIdType>& voxels, int axis);
+    void PrefetchGlyphs(std::vector<vtkIdType> voxels, int timeStep, GlyphParameters parameters, vtkSmartPointer<vtkDataArray> values, unsigned long generation);
+    void StopPrefetching();
+    /** Adds computed glyphs to the cache, unless it was cleared since generation @a generation */
+    void InsertGlyphs(const std::vector<GlyphKey>& keys, const std::vector< std::shared_ptr<const OdfGlyph> >& glyphs, unsigned long generation);
+
 
 private:
 
     mitk::Image* GetInput();
 
-    static vtkSmartPointer<vtkTransform> m_OdfTransform;
-    static vtkSmartPointer<vtkOdfSource> m_OdfSource;
     static float    m_Scaling;
     static int      m_Normalization;
     static int      m_ScaleBy;
     static float    m_IndexParam1;
     static float    m_IndexParam2;
-    static vtkSmartPointer<vtkDoubleArray> m_colourScalars;
 
     int             m_ShowMaxNumber;
 
@@ -143,8 +208,17 @@ private:
     std::vector< vtkSmartPointer<vtkThickPlane> >     m_ThickPlanes2;
     std::vector< vtkSmartPointer<vtkClipPolyData> >  m_Clippers2;
     vtkImageData*                   m_VtkImage ;
-    OdfDisplayGeometry              m_LastDisplayGeometry;
     mitk::LocalStorageHandler<LocalStorage> m_LSH;
+
+    GlyphTemplate                                   m_GlyphTemplate;
+    GlyphParameters                                 m_GlyphParameters;
+    std::unordered_map<GlyphKey, CachedGlyph>       m_GlyphCache;
+    std::mutex                                      m_GlyphCacheMutex;
+    unsigned long                                   m_GlyphCacheGeneration;  ///< incremented whenever the cache is cleared
+    unsigned long                                   m_GlyphCacheUse;
+    std::size_t                                     m_MaxNumberOfCachedGlyphs;
+    std::thread                                     m_PrefetchThread;
+    std::atomic<bool>                               m_StopPrefetching;
 };
 
 } // namespace mitk
@@ -34,22 +34,22 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkMaskedGlyph3D.h"
 #include "vtkGlyph2D.h"
 #include "vtkGlyph3D.h"
-#include "vtkMaskedProgrammableGlyphFilter.h"
 #include "vtkImageData.h"
 #include "vtkLinearTransform.h"
 #include "vtkCamera.h"
 #include "vtkPointData.h"
-#include "vtkTransformPolyDataFilter.h"
 #include "vtkTransform.h"
 #include "vtkOdfSource.h"
 #include "vtkDoubleArray.h"
 #include "vtkLookupTable.h"
 #include "vtkProperty.h"
-#include "vtkPolyDataNormals.h"
 #include "vtkLight.h"
 #include "vtkLightCollection.h"
 #include "vtkMath.h"
 #include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
 #include "vtkDelaunay2D.h"
 #include "vtkMapper.h"
 #include <vtkInformationVector.h>
@@ -67,14 +67,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <math.h>
 
 #include <ciso646>
+#include <algorithm>
 
 
-template<class T, int N>
-vtkSmartPointer<vtkTransform> mitk::OdfVtkMapper2D<T,N>::m_OdfTransform = vtkSmartPointer<vtkTransform>::New();
-
-template<class T, int N>
-vtkSmartPointer<vtkOdfSource> mitk::OdfVtkMapper2D<T,N>::m_OdfSource = vtkSmartPointer<vtkOdfSource>::New();
-
 template<class T, int N>
 float mitk::OdfVtkMapper2D<T,N>::m_Scaling;
 
@@ -99,9 +94,6 @@ bool mitk::OdfVtkMapper2D<T, N>::m_toggleColourisationMode = false;
 template<class T, int N>
 bool mitk::OdfVtkMapper2D<T, N>::m_toggleGlyphPlacementMode = true;
 
-template<class T, int N>
-vtkSmartPointer<vtkDoubleArray> mitk::OdfVtkMapper2D<T, N>::m_colourScalars = nullptr;
-
 #define ODF_MAPPER_PI M_PI
 
 
@@ -192,13 +184,19 @@ mitk::OdfVtkMapper2D<T,N>
     m_Clippers2[2]->SetClipFunction( m_ThickPlanes2[2] );
 
     m_ShowMaxNumber = 500;
+
+    m_GlyphParameters.Data = nullptr;
+    m_GlyphCacheGeneration = 0;
+    m_GlyphCacheUse = 0;
+    m_MaxNumberOfCachedGlyphs = 8192;
+    m_StopPrefetching = false;
 }
 
 template<class T, int N>
 mitk::OdfVtkMapper2D<T,N>
 ::~OdfVtkMapper2D()
 {
-
+    StopPrefetching();
 }
 
 template<class T, int N>
@@ -233,162 +231,480 @@ int  mitk::OdfVtkMapper2D<T,N>
 }
 
 template<class T, int N>
-void  mitk::OdfVtkMapper2D<T,N>
-::GlyphMethod(void *arg)
+bool mitk::OdfVtkMapper2D<T,N>::GlyphParameters
+::operator==(const GlyphParameters& other) const
 {
-    vtkMaskedProgrammableGlyphFilter* pfilter=(vtkMaskedProgrammableGlyphFilter*)arg;
-
-    double point[3];
-    double debugpoint[3];
-    pfilter->GetPoint(point);
-    pfilter->GetPoint(debugpoint);
-
-    itk::Point<double,3> p(point);
-    Vector3D spacing = pfilter->GetGeometry()->GetSpacing();
-    p[0] /= spacing[0];
-    p[1] /= spacing[1];
-    p[2] /= spacing[2];
-
-    mitk::Point3D p2;
-    pfilter->GetGeometry()->IndexToWorld( p, p2 );
-    point[0] = p2[0];
-    point[1] = p2[1];
-    point[2] = p2[2];
-
-    vtkPointData* data = pfilter->GetPointData();
-    vtkDataArray* odfvals = data->GetArray("vector");
-    vtkIdType id = pfilter->GetPointId();
-    m_OdfTransform->Identity();
-    m_OdfTransform->Translate(point[0],point[1],point[2]);
+    return Data == other.Data &&
+            DataMTime == other.DataMTime &&
+            Scaling == other.Scaling &&
+            Normalization == other.Normalization &&
+            ScaleBy == other.ScaleBy &&
+            IndexParam1 == other.IndexParam1 &&
+            IndexParam2 == other.IndexParam2 &&
+            TensorEllipsoidView == other.TensorEllipsoidView &&
+            ColourisationMode == other.ColourisationMode;
+}
 
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::ComputeGlyph(const GlyphTemplate& glyphTemplate, const GlyphParameters& parameters, const double* values, int numberOfComponents, OdfGlyph& glyph)
+{
     typedef itk::OrientationDistributionFunction<float,N> OdfType;
     OdfType odf;
 
-    if( odfvals->GetNumberOfComponents()==6 and not m_toggleTensorEllipsoidView )
+    glyph.Rgba[0] = glyph.Rgba[1] = glyph.Rgba[2] = glyph.Rgba[3] = 0;
+    if( numberOfComponents==6 )
     {
-        float tensorelems[6] = {
-            (float)odfvals->GetComponent(id,0),
-            (float)odfvals->GetComponent(id,1),
-            (float)odfvals->GetComponent(id,2),
-            (float)odfvals->GetComponent(id,3),
-            (float)odfvals->GetComponent(id,4),
-            (float)odfvals->GetComponent(id,5),
+        float tensorElements[6] = {
+            (float)values[0], (float)values[1], (float)values[2],
+            (float)values[3], (float)values[4], (float)values[5],
         };
-        itk::DiffusionTensor3D<float> tensor(tensorelems);
-        odf.InitFromTensor(tensor);
+        itk::DiffusionTensor3D<float> tensor( tensorElements );
+        if( parameters.TensorEllipsoidView )
+            odf.InitFromEllipsoid( tensor );
+        else
+            odf.InitFromTensor( tensor );
 
-        if( (pfilter-> GetColorMode()) == 0 ) // m_ColourisationMode; VTK_COLOR_BY_INPUT=0, VTK_COLOR_BY_SOURCE=1.
+        if( parameters.ColourisationMode )
         { /// \brief Colourisation of glyph like in MitkWorkbench's dti visualisation, r,g,b,a=x,y,z,fa of main direction of diffusion.
-//          unsigned char rgba[4] = {0,0,0,0};
-          double rgba[4] = {0,0,0,0};
-          rgba[3] = fabs(tensor.GetFractionalAnisotropy()); //* 255); // fa = FractionalAnisotropy => Helligkeit = Value, and alpha.
-          typename itk::DiffusionTensor3D<T>::EigenValuesArrayType eigenValues;
-          typename itk::DiffusionTensor3D<T>::EigenVectorsMatrixType eigenVectors;
-          tensor.ComputeEigenAnalysis( eigenValues, eigenVectors ); // normalized eigenvectors as rows in ascending order.
-          rgba[0] = (fabs( eigenVectors(2, 0) ) * rgba[3]);
-          rgba[1] = (fabs( eigenVectors(2, 1) ) * rgba[3]);
-          rgba[2] = (fabs( eigenVectors(2, 2) ) * rgba[3]);
-//#define __IMG_DAT_ITEM__CLIP_00_FF__(val) (val) = ( (val) < 0 ) ? ( 0 ) : ( ( (val) > 255 ) ? ( 255 ) : ( (val) ) );
-#define __IMG_DAT_ITEM__CLIP_0_1__(val) (val) = ( (val) < 0.0 ) ? ( 0.0 ) : ( ( (val) > 1.0 ) ? ( 1.0 ) : ( (val) ) );
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[0]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[1]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[2]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[3]);
-          m_colourScalars-> InsertNextTuple4( rgba[0], rgba[1], rgba[2], rgba[3] ); // Allocates space automaticaly.
-
-          data-> AddArray( m_colourScalars );
-          data-> SetActiveScalars( "GLYPH_COLORS" );
+            glyph.Rgba[3] = fabs( tensor.GetFractionalAnisotropy() );
+            typename itk::DiffusionTensor3D<float>::EigenValuesArrayType eigenValues;
+            typename itk::DiffusionTensor3D<float>::EigenVectorsMatrixType eigenVectors;
+            tensor.ComputeEigenAnalysis( eigenValues, eigenVectors ); // normalized eigenvectors as rows in ascending order.
+            glyph.Rgba[0] = fabs( eigenVectors(2, 0) ) * glyph.Rgba[3];
+            glyph.Rgba[1] = fabs( eigenVectors(2, 1) ) * glyph.Rgba[3];
+            glyph.Rgba[2] = fabs( eigenVectors(2, 2) ) * glyph.Rgba[3];
+            for(int i=0; i<4; i++)
+                glyph.Rgba[i] = glyph.Rgba[i] < 0.0 ? 0.0 : ( glyph.Rgba[i] > 1.0 ? 1.0 : glyph.Rgba[i] );
         }
-        else
+    }
+    else
+    {
+        for(int i=0; i<N; i++)
+            odf[i] = values[i];
+    }
+
+    double scale = parameters.Scaling;
+    switch(parameters.ScaleBy)
+    {
+    case ODFSB_GFA:
+        scale *= odf.GetGeneralizedGFA(parameters.IndexParam1, parameters.IndexParam2);
+        break;
+    case ODFSB_PC:
+        scale *= odf.GetPrincipleCurvature(parameters.IndexParam1, parameters.IndexParam2, 0);
+        break;
+    }
+
+    // same normalization as vtkOdfSource
+    OdfType colorOdf;
+    switch(parameters.Normalization)
+    {
+    case ODFN_MAX:
+        odf = odf.MaxNormalize();
+        colorOdf = odf;
+        break;
+    case ODFN_NONE:
+        colorOdf = odf.MaxNormalize();
+        break;
+    default:
+        odf = odf.MinMaxNormalize();
+        colorOdf = odf;
+    }
+
+    int numPoints = glyphTemplate.Points.size()/3;
+    glyph.Points.resize(3*numPoints);
+    for(int j=0; j<numPoints; j++)
+    {
+        double radius = odf[j]*scale*0.5;
+        glyph.Points[3*j]   = glyphTemplate.Points[3*j]*radius;
+        glyph.Points[3*j+1] = glyphTemplate.Points[3*j+1]*radius;
+        glyph.Points[3*j+2] = glyphTemplate.Points[3*j+2]*radius;
+    }
+
+    // point normals as computed by vtkPolyDataNormals without splitting: normalized sum of the adjacent polygon normals
+    glyph.Normals.assign(3*numPoints, 0.0f);
+    glyph.CellColors.resize(glyphTemplate.NumberOfCells);
+    const float* p = glyph.Points.data();
+    std::size_t cellId = 0;
+    for(std::size_t c=0; c<glyphTemplate.Cells.size(); c+=glyphTemplate.Cells[c]+1)
+    {
+        vtkIdType npts = glyphTemplate.Cells[c];
+        const vtkIdType* pts = &glyphTemplate.Cells[c+1];
+
+        double val = 0;
+        double n[3] = {0,0,0};
+        for(int i=0; i<npts; i++)
         {
-          data-> SetActiveScalars( "vector" );
-          data-> RemoveArray( "GLYPH_COLORS" );
+            val += colorOdf[pts[i]];
+
+            const float* p1 = p + 3*pts[i];
+            const float* p2 = p + 3*pts[(i+1)%npts];
+            n[0] += (p1[1]-p2[1])*(p1[2]+p2[2]);
+            n[1] += (p1[2]-p2[2])*(p1[0]+p2[0]);
+            n[2] += (p1[0]-p2[0])*(p1[1]+p2[1]);
+        }
+        glyph.CellColors[cellId++] = 1-val/npts;
+
+        vtkMath::Normalize(n);
+        for(int i=0; i<npts; i++)
+        {
+            glyph.Normals[3*pts[i]]   += n[0];
+            glyph.Normals[3*pts[i]+1] += n[1];
+            glyph.Normals[3*pts[i]+2] += n[2];
         }
     }
+    for(int j=0; j<numPoints; j++)
+        vtkMath::Normalize(&glyph.Normals[3*j]);
+}
 
-    else if( odfvals->GetNumberOfComponents()==6 and m_toggleTensorEllipsoidView )
+template<class T, int N>
+std::vector<vtkIdType>  mitk::OdfVtkMapper2D<T,N>
+::SelectGlyphVoxels(const std::vector<vtkIdType>& voxels, int maxNumber, bool random)
+{
+    int numVoxels = voxels.size();
+    if( numVoxels<=maxNumber )
+        return voxels;
+
+    std::vector<vtkIdType> selected;
+    if( maxNumber<=0 )
+        return selected;
+    selected.reserve(maxNumber);
+
+    if( !random )
+    {
+        // every n-th voxel, as vtkMaskPoints does
+        int ratio = numVoxels/maxNumber;
+        for(int i=0; i<numVoxels && (int)selected.size()<maxNumber; i+=ratio)
+            selected.push_back(voxels[i]);
+    }
+    else
     {
-      float tensorElements[6] = {
-          (float)odfvals->GetComponent(id, 0), (float)odfvals->GetComponent(id, 1), (float)odfvals->GetComponent(id, 2),
-          (float)odfvals->GetComponent(id, 3), (float)odfvals->GetComponent(id, 4), (float)odfvals->GetComponent(id, 5),
-      };
-      itk::DiffusionTensor3D<float> tensor( tensorElements );
-      odf.InitFromEllipsoid( tensor );
-
-      if( (pfilter-> GetColorMode()) == 0 ) // m_ColourisationMode; VTK_COLOR_BY_INPUT=0, VTK_COLOR_BY_SOURCE=1.
-      { /// \brief Colourisation of glyph like in MitkWorkbench's dti visualisation, r,g,b,a=x,y,z,fa of main direction of diffusion.
-        double rgba[4] = {0,0,0,0};
-        rgba[3] = fabs( tensor.GetFractionalAnisotropy()); // * 255 ); // fa = FractionalAnisotropy => Helligkeit = Value
-        typename itk::DiffusionTensor3D<T>::EigenValuesArrayType eigenValues;
-        typename itk::DiffusionTensor3D<T>::EigenVectorsMatrixType eigenVectors;
-        tensor.ComputeEigenAnalysis( eigenValues, eigenVectors ); // normalized eigenvectors as rows in ascending order.
-        rgba[0] = (fabs( eigenVectors(2, 0) ) * rgba[3]);
-        rgba[1] = (fabs( eigenVectors(2, 1) ) * rgba[3]);
-        rgba[2] = (fabs( eigenVectors(2, 2) ) * rgba[3]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[0]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[1]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[2]);
-        __IMG_DAT_ITEM__CLIP_0_1__(rgba[3]);
-
-        m_colourScalars-> InsertNextTuple4( rgba[0], rgba[1], rgba[2], rgba[3] );
-        data-> CopyScalarsOn();
-        data-> SetCopyAttribute(id, 1);
-        data-> SetCopyScalars(id);
-        data-> CopyAllOn();
-        data-> SetDebug('1');
-
-        pfilter-> DebugOn();
-        pfilter-> GetOutput()-> DebugOn();
-        pfilter-> GetOutput()-> GetPointData()-> CopyScalarsOn();
-
-        data-> AddArray( m_colourScalars );
-        data-> SetActiveScalars( "GLYPH_COLORS" );
-
-#ifndef NDEBUG
+        // Pseudo random subset that only depends on the voxel, so a slice shows the same glyphs whenever it is visited
+        // and the glyphs of the neighbouring slices can be prefetched.
+        double probability = (double)maxNumber/numVoxels;
+        for(int i=0; i<numVoxels && (int)selected.size()<maxNumber; i++)
         {
-          vtkIndent indent;
-          std::cout << "<data>\n";
-          data-> PrintSelf(std::cout, indent.GetNextIndent());
-          std::cout << "</data>\n<pfilter>\n";
-          pfilter-> PrintSelf(std::cout, indent.GetNextIndent());
-          std::cout << pfilter->GetOutput()->GetClassName() << "\n";
-          pfilter-> GetOutput()-> PrintSelf(std::cout, indent.GetNextIndent());
-          pfilter-> GetOutput()->GetPointData()-> PrintSelf(std::cout, indent.GetNextIndent());
-          pfilter-> GetOutput()->GetPointData()->GetScalars()-> PrintSelf(std::cout, indent.GetNextIndent());
-          std::cout << "</pfilter>";
+            unsigned long long h = static_cast<unsigned long long>(voxels[i]) + 0x9E3779B97F4A7C15ULL;
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+            h ^= h >> 31;
+            if( (h >> 11) * (1.0/9007199254740992.0) < probability )
+                selected.push_back(voxels[i]);
         }
-#endif
+    }
+    return selected;
+}
 
-      }
-      else
-      {
-        data-> SetActiveScalars( "vector" );
-        data-> RemoveArray( "GLYPH_COLORS" );
-      }
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::UpdateGlyphParameters()
+{
+    if( m_GlyphTemplate.Points.empty() )
+    {
+        vtkPolyData* baseMesh = itk::OrientationDistributionFunction<float,N>::GetBaseMesh();
+        vtkPoints* points = baseMesh->GetPoints();
+        m_GlyphTemplate.Points.resize(3*points->GetNumberOfPoints());
+        for(vtkIdType i=0; i<points->GetNumberOfPoints(); i++)
+        {
+            double p[3];
+            points->GetPoint(i, p);
+            m_GlyphTemplate.Points[3*i]   = p[0];
+            m_GlyphTemplate.Points[3*i+1] = p[1];
+            m_GlyphTemplate.Points[3*i+2] = p[2];
+        }
+        vtkIdTypeArray* cells = baseMesh->GetPolys()->GetData();
+        m_GlyphTemplate.Cells.assign(cells->GetPointer(0), cells->GetPointer(0) + cells->GetNumberOfTuples());
+        m_GlyphTemplate.NumberOfCells = baseMesh->GetPolys()->GetNumberOfCells();
+    }
+
+    GlyphParameters parameters;
+    parameters.Data = this->GetDataNode()->GetData();
+    parameters.DataMTime = this->GetDataNode()->GetData()->GetMTime();
+    parameters.Scaling = m_Scaling;
+    parameters.Normalization = m_Normalization;
+    parameters.ScaleBy = m_ScaleBy;
+    parameters.IndexParam1 = m_IndexParam1;
+    parameters.IndexParam2 = m_IndexParam2;
+    parameters.TensorEllipsoidView = m_toggleTensorEllipsoidView;
+    parameters.ColourisationMode = m_toggleColourisationMode;
+
+    if( !(parameters == m_GlyphParameters) )
+    {
+        StopPrefetching();
+        std::lock_guard<std::mutex> lock(m_GlyphCacheMutex);
+        m_GlyphCache.clear();
+        ++m_GlyphCacheGeneration;
+        m_GlyphParameters = parameters;
+    }
+}
+
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::InsertGlyphs(const std::vector<GlyphKey>& keys, const std::vector< std::shared_ptr<const OdfGlyph> >& glyphs, unsigned long generation)
+{
+    std::lock_guard<std::mutex> lock(m_GlyphCacheMutex);
+    if( generation != m_GlyphCacheGeneration )
+        return;
+
+    for(std::size_t i=0; i<keys.size(); i++)
+    {
+        CachedGlyph& cached = m_GlyphCache[keys[i]];
+        cached.Glyph = glyphs[i];
+        cached.LastUse = m_GlyphCacheUse;
+    }
+
+    if( m_GlyphCache.size() > m_MaxNumberOfCachedGlyphs )
+    {
+        // drop the least recently used glyphs, down to three quarters of the maximum
+        std::vector<unsigned long> uses;
+        uses.reserve(m_GlyphCache.size());
+        for(const auto& entry : m_GlyphCache)
+            uses.push_back(entry.second.LastUse);
+        std::size_t numErase = m_GlyphCache.size() - 3*m_MaxNumberOfCachedGlyphs/4;
+        std::nth_element(uses.begin(), uses.begin()+numErase, uses.end());
+        unsigned long threshold = uses[numErase];
+        for(auto it = m_GlyphCache.begin(); it != m_GlyphCache.end(); )
+        {
+            if( it->second.LastUse < threshold )
+                it = m_GlyphCache.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+template<class T, int N>
+vtkSmartPointer<vtkPolyData>  mitk::OdfVtkMapper2D<T,N>
+::GenerateGlyphs(const std::vector<vtkIdType>& voxels, double additionalScale)
+{
+    int timeStep = this->GetTimestep();
+    int numGlyphs = voxels.size();
+    std::vector< std::shared_ptr<const OdfGlyph> > glyphs(numGlyphs);
+    std::vector<int> missing;
+    unsigned long generation;
+    {
+        std::lock_guard<std::mutex> lock(m_GlyphCacheMutex);
+        ++m_GlyphCacheUse;
+        generation = m_GlyphCacheGeneration;
+        for(int i=0; i<numGlyphs; i++)
+        {
+            auto it = m_GlyphCache.find(GetGlyphKey(timeStep, voxels[i]));
+            if( it != m_GlyphCache.end() )
+            {
+                it->second.LastUse = m_GlyphCacheUse;
+                glyphs[i] = it->second.Glyph;
+            }
+            else
+                missing.push_back(i);
+        }
+    }
+
+    vtkDataArray* values = m_VtkImage->GetPointData()->GetArray(0);
+    int numComponents = values->GetNumberOfComponents();
+    int numMissing = missing.size();
+#pragma omp parallel for
+    for(int i=0; i<numMissing; i++)
+    {
+        std::vector<double> voxelValues(numComponents);
+        values->GetTuple(voxels[missing[i]], voxelValues.data());
+        std::shared_ptr<OdfGlyph> glyph = std::make_shared<OdfGlyph>();
+        ComputeGlyph(m_GlyphTemplate, m_GlyphParameters, voxelValues.data(), numComponents, *glyph);
+        glyphs[missing[i]] = glyph;
+    }
+
+    if( numMissing>0 )
+    {
+        std::vector<GlyphKey> keys(numMissing);
+        std::vector< std::shared_ptr<const OdfGlyph> > computed(numMissing);
+        for(int i=0; i<numMissing; i++)
+        {
+            keys[i] = GetGlyphKey(timeStep, voxels[missing[i]]);
+            computed[i] = glyphs[missing[i]];
+        }
+        InsertGlyphs(keys, computed, generation);
+    }
+
+    // the image data is in index coordinates scaled by the spacing, the glyphs are placed at the world position of the voxel
+    int dims[3];
+    m_VtkImage->GetDimensions(dims);
+    mitk::BaseGeometry* geometry = this->GetDataNode()->GetData()->GetGeometry();
+    std::vector<mitk::Point3D> centers(numGlyphs);
+    for(int i=0; i<numGlyphs; i++)
+    {
+        mitk::Point3D index;
+        index[0] = voxels[i] % dims[0];
+        index[1] = (voxels[i] / dims[0]) % dims[1];
+        index[2] = voxels[i] / (dims[0]*dims[1]);
+        geometry->IndexToWorld(index, centers[i]);
     }
 
+    // copy all glyphs into one poly data
+    int numPoints = m_GlyphTemplate.Points.size()/3;
+    int cellsSize = m_GlyphTemplate.Cells.size();
+    vtkIdType numCells = m_GlyphTemplate.NumberOfCells;
+    bool rgbaColors = m_GlyphParameters.ColourisationMode && numComponents==6;
+
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents(3);
+    pointArray->SetNumberOfTuples(numGlyphs*numPoints);
+    vtkSmartPointer<vtkFloatArray> normalArray = vtkSmartPointer<vtkFloatArray>::New();
+    normalArray->SetName("Normals");
+    normalArray->SetNumberOfComponents(3);
+    normalArray->SetNumberOfTuples(numGlyphs*numPoints);
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues(numGlyphs*cellsSize);
+    vtkSmartPointer<vtkFloatArray> cellColors = vtkSmartPointer<vtkFloatArray>::New();
+    vtkSmartPointer<vtkDoubleArray> rgba = vtkSmartPointer<vtkDoubleArray>::New();
+    if( rgbaColors )
+    {
+        rgba->SetName("GLYPH_COLORS");
+        rgba->SetNumberOfComponents(4); // red, green, blue and alpha are the 4 components per tuple.
+        rgba->SetNumberOfTuples(numGlyphs*numPoints);
+    }
     else
+        cellColors->SetNumberOfValues(numGlyphs*numCells);
+
+    float* points = pointArray->GetPointer(0);
+    float* normals = normalArray->GetPointer(0);
+    vtkIdType* cells = cellArray->GetPointer(0);
+    double* rgbaValues = rgbaColors ? rgba->GetPointer(0) : nullptr;
+    float* cellColorValues = rgbaColors ? nullptr : cellColors->GetPointer(0);
+#pragma omp parallel for
+    for(int i=0; i<numGlyphs; i++)
     {
-        for(int i=0; i<N; i++)
-            odf[i] = (double)odfvals->GetComponent(id,i);
+        const OdfGlyph& glyph = *glyphs[i];
+
+        float* glyphPoints = points + 3*numPoints*i;
+        for(int j=0; j<numPoints; j++)
+        {
+            glyphPoints[3*j]   = glyph.Points[3*j]*additionalScale + centers[i][0];
+            glyphPoints[3*j+1] = glyph.Points[3*j+1]*additionalScale + centers[i][1];
+            glyphPoints[3*j+2] = glyph.Points[3*j+2]*additionalScale + centers[i][2];
+        }
+        std::copy(glyph.Normals.begin(), glyph.Normals.end(), normals + 3*numPoints*i);
+
+        vtkIdType* glyphCells = cells + cellsSize*i;
+        vtkIdType offset = numPoints*i;
+        for(int c=0; c<cellsSize; c+=m_GlyphTemplate.Cells[c]+1)
+        {
+            glyphCells[c] = m_GlyphTemplate.Cells[c];
+            for(int k=1; k<=m_GlyphTemplate.Cells[c]; k++)
+                glyphCells[c+k] = m_GlyphTemplate.Cells[c+k] + offset;
+        }
+
+        if( rgbaColors )
+        {
+            for(int j=0; j<numPoints; j++)
+                std::copy(glyph.Rgba, glyph.Rgba+4, rgbaValues + 4*(numPoints*i+j));
+        }
+        else
+            std::copy(glyph.CellColors.begin(), glyph.CellColors.end(), cellColorValues + numCells*i);
     }
 
-    switch(m_ScaleBy)
+    vtkSmartPointer<vtkPoints> vtkPointsObject = vtkSmartPointer<vtkPoints>::New();
+    vtkPointsObject->SetData(pointArray);
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells(numGlyphs*numCells, cellArray);
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(vtkPointsObject);
+    polyData->SetPolys(polys);
+    polyData->GetPointData()->SetNormals(normalArray);
+    if( rgbaColors )
     {
-    case ODFSB_NONE:
-        m_OdfSource->SetScale(m_Scaling);
-        break;
-    case ODFSB_GFA:
-        m_OdfSource->SetScale(m_Scaling*odf.GetGeneralizedGFA(m_IndexParam1, m_IndexParam2));
-        break;
-    case ODFSB_PC:
-        m_OdfSource->SetScale(m_Scaling*odf.GetPrincipleCurvature(m_IndexParam1, m_IndexParam2, 0));
-        break;
+        polyData->GetPointData()->AddArray(rgba);
+        polyData->GetPointData()->SetActiveScalars("GLYPH_COLORS");
     }
+    else
+        polyData->GetCellData()->SetScalars(cellColors);
+    return polyData;
+}
+
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::PrefetchNeighbouringSlices(const std::vector<vtkIdType>& voxels, int axis)
+{
+    StopPrefetching();
+    if( axis<0 )
+        return;
 
-    m_OdfSource->SetNormalization(m_Normalization);
-    m_OdfSource->SetOdf(odf);
-    m_OdfSource->Modified();
+    int dims[3];
+    m_VtkImage->GetDimensions(dims);
+    vtkIdType stride = axis==0 ? 1 : ( axis==1 ? dims[0] : dims[0]*dims[1] );
+
+    // the same section of the slices before and after, selected like in Slice()
+    std::vector<vtkIdType> prefetch;
+    for(int direction : {-1, 1})
+    {
+        std::vector<vtkIdType> neighbours;
+        neighbours.reserve(voxels.size());
+        for(vtkIdType voxel : voxels)
+        {
+            int slice = (voxel / stride) % dims[axis];
+            if( slice+direction>=0 && slice+direction<dims[axis] )
+                neighbours.push_back(voxel + direction*stride);
+        }
+        std::vector<vtkIdType> selected = SelectGlyphVoxels(neighbours, m_ShowMaxNumber, m_toggleGlyphPlacementMode);
+        prefetch.insert(prefetch.end(), selected.begin(), selected.end());
+    }
+    if( prefetch.empty() )
+        return;
+
+    unsigned long generation;
+    {
+        std::lock_guard<std::mutex> lock(m_GlyphCacheMutex);
+        generation = m_GlyphCacheGeneration;
+    }
+
+    // the thread keeps its own reference to the voxel values, in case the image data object is replaced meanwhile
+    vtkSmartPointer<vtkDataArray> values = m_VtkImage->GetPointData()->GetArray(0);
+    m_StopPrefetching = false;
+    m_PrefetchThread = std::thread(&OdfVtkMapper2D<T,N>::PrefetchGlyphs, this, prefetch, this->GetTimestep(), m_GlyphParameters, values, generation);
+}
+
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::PrefetchGlyphs(std::vector<vtkIdType> voxels, int timeStep, GlyphParameters parameters, vtkSmartPointer<vtkDataArray> values, unsigned long generation)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_GlyphCacheMutex);
+        voxels.erase(std::remove_if(voxels.begin(), voxels.end(), [&](vtkIdType voxel){ return m_GlyphCache.count(GetGlyphKey(timeStep, voxel))>0; }), voxels.end());
+    }
+
+    const std::size_t batchSize = 64;
+    std::vector<GlyphKey> keys;
+    std::vector< std::shared_ptr<const OdfGlyph> > glyphs;
+    std::vector<double> voxelValues(values->GetNumberOfComponents());
+    for(vtkIdType voxel : voxels)
+    {
+        if( m_StopPrefetching )
+            return;
+
+        values->GetTuple(voxel, voxelValues.data());
+        std::shared_ptr<OdfGlyph> glyph = std::make_shared<OdfGlyph>();
+        ComputeGlyph(m_GlyphTemplate, parameters, voxelValues.data(), voxelValues.size(), *glyph);
+        keys.push_back(GetGlyphKey(timeStep, voxel));
+        glyphs.push_back(glyph);
+
+        if( keys.size()==batchSize )
+        {
+            InsertGlyphs(keys, glyphs, generation);
+            keys.clear();
+            glyphs.clear();
+        }
+    }
+    InsertGlyphs(keys, glyphs, generation);
+}
+
+template<class T, int N>
+void  mitk::OdfVtkMapper2D<T,N>
+::StopPrefetching()
+{
+    if( m_PrefetchThread.joinable() )
+    {
+        m_StopPrefetching = true;
+        m_PrefetchThread.join();
+    }
 }
 
 template<class T, int N>
@@ -524,6 +840,7 @@ void  mitk::OdfVtkMapper2D<T,N>
     m_VtkImage->GetDimensions(dims);
     double spac[3];
     m_VtkImage->GetSpacing(spac);
+    int normalAxis = -1;
     if(fabs(dispGeo.vnormal[0]) > fabs(dispGeo.vnormal[1])
             && fabs(dispGeo.vnormal[0]) > fabs(dispGeo.vnormal[2]) )
     {
@@ -533,6 +850,7 @@ void  mitk::OdfVtkMapper2D<T,N>
             dispGeo.vp[0] = ((dims[0]-1)-0.4)*spac[0];
         dispGeo.vnormal[1] = 0;
         dispGeo.vnormal[2] = 0;
+        normalAxis = 0;
     }
 
     if(fabs(dispGeo.vnormal[1]) > fabs(dispGeo.vnormal[0]) && fabs(dispGeo.vnormal[1]) > fabs(dispGeo.vnormal[2]) )
@@ -543,6 +861,7 @@ void  mitk::OdfVtkMapper2D<T,N>
             dispGeo.vp[1] = ((dims[1]-1)-0.4)*spac[1];
         dispGeo.vnormal[0] = 0;
         dispGeo.vnormal[2] = 0;
+        normalAxis = 1;
     }
 
     if(fabs(dispGeo.vnormal[2]) > fabs(dispGeo.vnormal[1]) && fabs(dispGeo.vnormal[2]) > fabs(dispGeo.vnormal[0]) )
@@ -553,6 +872,7 @@ void  mitk::OdfVtkMapper2D<T,N>
             dispGeo.vp[2] = ((dims[2]-1)-0.4)*spac[2];
         dispGeo.vnormal[0] = 0;
         dispGeo.vnormal[1] = 0;
+        normalAxis = 2;
     }
 
 
@@ -690,60 +1010,25 @@ void  mitk::OdfVtkMapper2D<T,N>
 
         if(cuttedPlane->GetNumberOfPoints())
         {
-            localStorage->m_OdfsPlanes[index]->RemoveAllInputs();
-
-            vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-            normals->SetInputConnection( m_OdfSource->GetOutputPort() );
-            normals->SplittingOff();
-            normals->ConsistencyOff();
-            normals->AutoOrientNormalsOff();
-            normals->ComputePointNormalsOn();
-            normals->ComputeCellNormalsOff();
-            normals->FlipNormalsOff();
-            normals->NonManifoldTraversalOff();
-
-            vtkSmartPointer<vtkTransformPolyDataFilter> trans = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-            trans->SetInputConnection( normals->GetOutputPort() );
-            trans->SetTransform(m_OdfTransform);
-
-            vtkSmartPointer<vtkMaskedProgrammableGlyphFilter> glyphGenerator = vtkSmartPointer<vtkMaskedProgrammableGlyphFilter>::New();
-            glyphGenerator->SetMaximumNumberOfPoints(std::min(m_ShowMaxNumber,(int)cuttedPlane->GetNumberOfPoints()));
-
-            glyphGenerator->SetRandomMode( m_toggleGlyphPlacementMode );
-
-            glyphGenerator->SetUseMaskPoints(1);
-            glyphGenerator->SetSourceConnection(trans->GetOutputPort() );
-            glyphGenerator->SetInput(cuttedPlane);
-
-            if( not m_toggleColourisationMode )
-            {
-              glyphGenerator-> SetColorModeToColorBySource();
-              glyphGenerator-> SetInputArrayToProcess(0,0,0, vtkDataObject::FIELD_ASSOCIATION_POINTS , "vector");
-              if(m_colourScalars != nullptr) { m_colourScalars-> Initialize(); }
-            }
-            else if ( m_toggleColourisationMode )
+            // voxels of the cut points, in the order of the cut
+            std::vector<vtkIdType> voxels(cuttedPlane->GetNumberOfPoints());
+            for(vtkIdType i=0; i<cuttedPlane->GetNumberOfPoints(); i++)
             {
-              m_colourScalars = vtkSmartPointer<vtkDoubleArray>::New();
-              m_colourScalars-> SetNumberOfComponents( 4 ); // red, green, blue and alpha are the 4 components per tuple.
-              m_colourScalars-> SetName( "GLYPH_COLORS" );
-              glyphGenerator-> SetColorModeToColorByInput();
-              glyphGenerator-> SetInputArrayToProcess(0,0,0, vtkDataObject::FIELD_ASSOCIATION_POINTS , "GLYPH_COLORS");
+                double point[3];
+                cuttedPlane->GetPoint(i, point);
+                int ijk[3];
+                for(int k=0; k<3; k++)
+                    ijk[k] = std::min(std::max((int)floor(point[k]/spac[k]+0.5), 0), dims[k]-1);
+                voxels[i] = m_VtkImage->ComputePointId(ijk);
             }
 
-            glyphGenerator->SetGeometry(this->GetDataNode()->GetData()->GetGeometry());
-            glyphGenerator->SetGlyphMethod(&(GlyphMethod),(void *)glyphGenerator);
+            std::vector<vtkIdType> glyphVoxels = SelectGlyphVoxels(voxels, m_ShowMaxNumber, m_toggleGlyphPlacementMode);
 
-            try
-            {
-              glyphGenerator->Update();
-            }
-            catch( itk::ExceptionObject& err )
-            {
-                std::cout << err << std::endl;
-            }
-
-            localStorage->m_OdfsPlanes[index]->AddInputConnection(glyphGenerator->GetOutputPort());
+            localStorage->m_OdfsPlanes[index]->RemoveAllInputs();
+            localStorage->m_OdfsPlanes[index]->AddInputData(GenerateGlyphs(glyphVoxels, GetMinImageSpacing(index)));
             localStorage->m_OdfsPlanes[index]->Update();
+
+            PrefetchNeighbouringSlices(voxels, normalAxis);
         }
     }
     localStorage->m_PropAssemblies[index]->VisibilityOn();
@@ -833,13 +1118,15 @@ void mitk::OdfVtkMapper2D<T,N>
     mitk::Image::Pointer input = const_cast<mitk::Image*>( this->GetInput() );
     if ( input.IsNull() ) return ;
 
+    this->CalculateTimeStep(renderer);
+
     std::string classname("TensorImage");
     if(classname.compare(input->GetNameOfClass())==0)
-        m_VtkImage = dynamic_cast<mitk::TensorImage*>( this->GetInput() )->GetNonRgbVtkImageData();
+        m_VtkImage = dynamic_cast<mitk::TensorImage*>( this->GetInput() )->GetNonRgbVtkImageData(this->GetTimestep());
 
     std::string qclassname("QBallImage");
     if(qclassname.compare(input->GetNameOfClass())==0)
-        m_VtkImage = dynamic_cast<mitk::QBallImage*>( this->GetInput() )->GetNonRgbVtkImageData();
+        m_VtkImage = dynamic_cast<mitk::QBallImage*>( this->GetInput() )->GetNonRgbVtkImageData(this->GetTimestep());
 
     if( m_VtkImage )
     {
@@ -887,7 +1174,7 @@ void  mitk::OdfVtkMapper2D<T,N>
     if ( (localStorage->m_LastUpdateTime >= m_DataNode->GetMTime()) //was the node modified?
       && (localStorage->m_LastUpdateTime >= m_DataNode->GetPropertyList()->GetMTime()) //was a property modified?
       && (localStorage->m_LastUpdateTime >= m_DataNode->GetPropertyList(renderer)->GetMTime())
-      && dispGeo.Equals(m_LastDisplayGeometry))
+      && dispGeo.Equals(localStorage->m_LastDisplayGeometry))
     {
       return;
     }
@@ -906,8 +1193,8 @@ void  mitk::OdfVtkMapper2D<T,N>
       localStorage->m_OdfsActors[1]->VisibilityOn();
       localStorage->m_OdfsActors[2]->VisibilityOn();
 
-      m_OdfSource->SetAdditionalScale(GetMinImageSpacing(GetIndex(renderer)));
       ApplyPropertySettings();
+      UpdateGlyphParameters();
 
       for(unsigned iter=0; iter<3; ++iter)
       {
@@ -929,7 +1216,7 @@ void  mitk::OdfVtkMapper2D<T,N>
       }
 
       Slice(renderer, dispGeo);
-      m_LastDisplayGeometry = dispGeo;
+      localStorage->m_LastDisplayGeometry = dispGeo;
     }
 }
 
@@ -32,8 +32,39 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkTrackvis.h>
 #include <mitkCustomMimeType.h>
 #include "mitkDiffusionIOMimeTypes.h"
-#include <vtkTransformPolyDataFilter.h>
+#include <vtkIdTypeArray.h>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+  // Number of points searched for fiber delimiters by one thread
+  const vtkIdType TckChunkSize = 1024 * 1024;
+
+  // Number of bytes from the current position to the end of the file, -1 if it cannot be determined
+  long long GetRemainingFileSize(std::FILE* file)
+  {
+#ifdef _WIN32
+    const long long begin = _ftelli64(file);
+    if (begin < 0 || _fseeki64(file, 0, SEEK_END) != 0)
+      return -1;
+    const long long end = _ftelli64(file);
+    if (_fseeki64(file, begin, SEEK_SET) != 0)
+      return -1;
+#else
+    const long long begin = ftello(file);
+    if (begin < 0 || fseeko(file, 0, SEEK_END) != 0)
+      return -1;
+    const long long end = ftello(file);
+    if (fseeko(file, begin, SEEK_SET) != 0)
+      return -1;
+#endif
+    return end < begin ? -1 : end - begin;
+  }
+}
 
 
 mitk::FiberBundleTckReader::FiberBundleTckReader()
@@ -70,6 +101,8 @@ std::vector<itk::SmartPointer<mitk::BaseData> > mitk::FiberBundleTckReader::Read
         if (ext==".tck")
         {
             std::FILE* filePointer = std::fopen(filename.c_str(),"r+b");
+            if (filePointer == nullptr)
+                mitkThrow() << "Could not open " << filename;
             std::string header = "";
 
             bool header_end = false;
@@ -106,51 +139,103 @@ std::vector<itk::SmartPointer<mitk::BaseData> > mitk::FiberBundleTckReader::Read
 
             MITK_INFO << "Reading TCK file";
 
+            // Read all coordinates with a single call into a buffer of the remaining file size
+            const long long remainingSize = GetRemainingFileSize(filePointer);
+            if (remainingSize < 0)
+            {
+              std::fclose(filePointer);
+              mitkThrow() << "Could not determine the size of " << filename;
+            }
 
-            vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-            vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+            std::vector<float> data(static_cast<std::size_t>(remainingSize) / sizeof(float));
+            const std::size_t size = std::fread(data.data(), sizeof(float), data.size(), filePointer);
+            std::fclose(filePointer);
 
-            float tmp[3];
-            count = 1;
-            int fiber_length = 0;
-            while (std::fread((char*)tmp, 1, 12, filePointer)==12)
+            // Find the delimiters of the fibers (NaN) and the end of the data (Inf) in parallel chunks
+            const vtkIdType numTriplets = size / 3;
+            const int numChunks = static_cast<int>((numTriplets + TckChunkSize - 1) / TckChunkSize);
+            std::vector< std::vector<vtkIdType> > chunkDelimiters(numChunks);
+            std::vector<vtkIdType> chunkEndOfData(numChunks, -1);
+
+#pragma omp parallel for
+            for (int c = 0; c < numChunks; ++c)
             {
-              if (std::isinf(tmp[0]) || std::isinf(tmp[1]) || std::isinf(tmp[1]))
-                break;
-              else if (std::isnan(tmp[0]) || std::isnan(tmp[1]) || std::isnan(tmp[2]))
+              const vtkIdType chunkEnd = std::min(numTriplets, (c + 1) * TckChunkSize);
+              for (vtkIdType t = c * TckChunkSize; t < chunkEnd; ++t)
+              {
+                const float* p = &data[3 * t];
+                if (std::isinf(p[0]) || std::isinf(p[1]) || std::isinf(p[2]))
+                {
+                  chunkEndOfData[c] = t;
+                  break;
+                }
+                else if (std::isnan(p[0]) || std::isnan(p[1]) || std::isnan(p[2]))
+                {
+                  chunkDelimiters[c].push_back(t);
+                }
+              }
+            }
+
+            // Each fiber ends with a delimiter, points after the last one do not belong to a complete fiber
+            std::vector<vtkIdType> fiberBegins;
+            std::vector<vtkIdType> fiberPointOffsets(1, 0);
+            vtkIdType begin = 0;
+            for (int c = 0; c < numChunks; ++c)
+            {
+              for (vtkIdType delimiter : chunkDelimiters[c])
               {
-                count++;
-                fiber_length = 0;
-                vtkNewCells->InsertNextCell(container);
-                container = vtkSmartPointer<vtkPolyLine>::New();
+                if (delimiter > begin)
+                {
+                  fiberBegins.push_back(begin);
+                  fiberPointOffsets.push_back(fiberPointOffsets.back() + delimiter - begin);
+                }
+                begin = delimiter + 1;
               }
-              else
+              if (chunkEndOfData[c] >= 0)
+                break;
+            }
+
+            // Decode the points into preallocated arrays and transform them from RAS (MRtrix) to LPS (MITK)
+            const int numFibers = fiberBegins.size();
+            const vtkIdType totalNumPoints = fiberPointOffsets.back();
+
+            vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+            vtkNewPoints->SetDataTypeToFloat();
+            vtkNewPoints->SetNumberOfPoints(totalNumPoints);
+            float* pointData = static_cast<vtkFloatArray*>(vtkNewPoints->GetData())->GetPointer(0);
+
+            vtkSmartPointer<vtkIdTypeArray> cellData = vtkSmartPointer<vtkIdTypeArray>::New();
+            cellData->SetNumberOfValues(numFibers + totalNumPoints);
+            vtkIdType* cellIds = cellData->GetPointer(0);
+
+#pragma omp parallel for
+            for (int i = 0; i < numFibers; ++i)
+            {
+              const vtkIdType firstPoint = fiberPointOffsets[i];
+              const vtkIdType numPoints = fiberPointOffsets[i + 1] - firstPoint;
+              const float* fiberData = &data[3 * fiberBegins[i]];
+
+              vtkIdType* ids = cellIds + firstPoint + i;
+              *ids++ = numPoints;
+
+              for (vtkIdType j = 0; j < numPoints; ++j)
               {
-                fiber_length++;
-                vtkIdType id = vtkNewPoints->InsertNextPoint(tmp);
-                container->GetPointIds()->InsertNextId(id);
+                float* p = pointData + 3 * (firstPoint + j);
+                p[0] = -fiberData[3 * j];
+                p[1] = -fiberData[3 * j + 1];
+                p[2] = fiberData[3 * j + 2];
+                ids[j] = firstPoint + j;
               }
             }
 
+            vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+            vtkNewCells->SetCells(numFibers, cellData);
+
             vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
             fiberPolyData->SetPoints(vtkNewPoints);
             fiberPolyData->SetLines(vtkNewCells);
 
-            // transform polydata from RAS (MRtrix) to LPS (MITK)
-            mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
-            vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
-            matrix->Identity();
-            matrix->SetElement(0,0,-matrix->GetElement(0,0));
-            matrix->SetElement(1,1,-matrix->GetElement(1,1));
-            geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
-
-            vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-            transformFilter->SetInputData(fiberPolyData);
-            transformFilter->SetTransform(geometry->GetVtkTransform());
-            transformFilter->Update();
-
-            FiberBundle::Pointer fib = FiberBundle::New(transformFilter->GetOutput());
+            FiberBundle::Pointer fib = FiberBundle::New(fiberPolyData);
             result.push_back(fib.GetPointer());
         }
 
@@ -85,6 +85,11 @@ EnergyComputer::EnergyComputer(ItkFloatImageType* mask, ParticleGrid* particleGr
     for (int k = 0; k < m_NumActiveVoxels; k++)
         m_CumulatedSpatialProbability[k] /= m_CumulatedSpatialProbability[m_NumActiveVoxels];
 
+    m_SamplingBegin = 0;
+    m_SamplingEnd = m_NumActiveVoxels;
+    m_SamplingLowerBound = 0;
+    m_SamplingUpperBound = 1;
+
     std::cout << "EnergyComputer: " << m_NumActiveVoxels << " active voxels found" << std::endl;
 }
 
@@ -107,10 +112,10 @@ void EnergyComputer::SetParameters(float particleWeight, float particleWidth, fl
 // draw random position from active voxels
 void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
 {
-    float r = m_RandGen->GetVariate();//m_RandGen->frand();
+    float r = m_SamplingLowerBound + (m_SamplingUpperBound-m_SamplingLowerBound)*m_RandGen->GetVariate();//m_RandGen->frand();
     int j;
-    int rl = 1;
-    int rh = m_NumActiveVoxels;
+    int rl = m_SamplingBegin+1;
+    int rh = m_SamplingEnd;
     while(rh != rl)
     {
         j = rl + (rh-rl)/2;
@@ -131,6 +136,30 @@ void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
     R[2] = m_Spacing[2]*((float)(m_ActiveIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
 }
 
+// the active voxels are ordered by their x index, so the sampling range is a contiguous part of the cumulated probabilities
+void EnergyComputer::SetSamplingRangeX(int firstX, int lastX)
+{
+    m_SamplingBegin = 0;
+    while (m_SamplingBegin<m_NumActiveVoxels && m_ActiveIndices[m_SamplingBegin]%m_Size[0]<firstX)
+        m_SamplingBegin++;
+    m_SamplingEnd = m_SamplingBegin;
+    while (m_SamplingEnd<m_NumActiveVoxels && m_ActiveIndices[m_SamplingEnd]%m_Size[0]<lastX)
+        m_SamplingEnd++;
+
+    m_SamplingLowerBound = m_CumulatedSpatialProbability[m_SamplingBegin];
+    if (m_SamplingEnd<m_NumActiveVoxels)
+        m_SamplingUpperBound = m_CumulatedSpatialProbability[m_SamplingEnd];
+    else
+        m_SamplingUpperBound = 1;
+}
+
+float EnergyComputer::GetSamplingWeight()
+{
+    if (m_SamplingEnd<=m_SamplingBegin)
+        return 0;
+    return m_SamplingUpperBound-m_SamplingLowerBound;
+}
+
 // return spatial probability of position
 float EnergyComputer::SpatProb(vnl_vector_fixed<float, 3> pos)
 {
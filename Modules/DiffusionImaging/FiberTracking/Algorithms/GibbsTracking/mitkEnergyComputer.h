@@ -44,6 +44,11 @@ public:
     // get random position inside mask
     void DrawRandomPosition(vnl_vector_fixed<float, 3>& R);
 
+    // restrict the random positions to the voxels with x index in [firstX, lastX) (domains of the parallel tracking)
+    void SetSamplingRangeX(int firstX, int lastX);
+    // share of the spatial probability that lies inside of the sampling range
+    float GetSamplingWeight();
+
     // external energy calculation
     virtual float ComputeExternalEnergy(vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<float, 3>& N, Particle* dp) =0;
 
@@ -65,6 +70,10 @@ protected:
     vnl_vector_fixed<float, 3>      m_Spacing;
     std::vector< float >            m_CumulatedSpatialProbability;
     std::vector< int >              m_ActiveIndices;    // indices inside mask
+    int                             m_SamplingBegin;    // first active index of the sampling range
+    int                             m_SamplingEnd;      // end of the sampling range
+    float                           m_SamplingLowerBound;   // cumulated probability at the sampling range
+    float                           m_SamplingUpperBound;
 
     bool    m_UseTrilinearInterpolation;    // is deactivated if less than 3 image slices are available
     int     m_NumActiveVoxels;              // voxels inside mask
@@ -115,27 +115,33 @@ void MetropolisHastingsSampler::MakeProposal()
     if (randnum < m_BirthProb)
     {
         m_BirthTime.Start();
+        float samplingWeight = m_EnergyComputer->GetSamplingWeight();
         vnl_vector_fixed<float, 3> R;
-        m_EnergyComputer->DrawRandomPosition(R);
-        vnl_vector_fixed<float, 3> N = GetRandomDirection();
-        Particle prop;
-        prop.GetPos() = R;
-        prop.GetDir() = N;
+        if (samplingWeight > 0)
+            m_EnergyComputer->DrawRandomPosition(R);
+        if (samplingWeight > 0 && m_ParticleGrid->IsActive(R))
+        {
+            vnl_vector_fixed<float, 3> N = GetRandomDirection();
+            Particle prop;
+            prop.GetPos() = R;
+            prop.GetDir() = N;
 
-        float prob =  m_Density * m_DeathProb /((m_BirthProb)*(m_ParticleGrid->m_NumParticles+1));
+            float prob =  m_Density * m_DeathProb /((m_BirthProb)*(m_ParticleGrid->m_NumParticles+1));
+            prob *= samplingWeight; // positions are only drawn from the sampling range of the energy computer
 
-        float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,nullptr);
-        float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
-        prob *= exp((in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
+            float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,nullptr);
+            float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
+            prob *= exp((in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
 
-        if (prob > 1 || m_RandGen->GetVariate() < prob)
-        {
-            Particle *p = m_ParticleGrid->NewParticle(R);
-            if (p!=nullptr)
+            if (prob > 1 || m_RandGen->GetVariate() < prob)
             {
-                p->GetPos() = R;
-                p->GetDir() = N;
-                m_AcceptedProposals++;
+                Particle *p = m_ParticleGrid->NewParticle(R);
+                if (p!=nullptr)
+                {
+                    p->GetPos() = R;
+                    p->GetDir() = N;
+                    m_AcceptedProposals++;
+                }
             }
         }
         m_BirthTime.Stop();
@@ -148,12 +154,13 @@ void MetropolisHastingsSampler::MakeProposal()
         {
             int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
             Particle *dp = m_ParticleGrid->GetParticle(pnum);
-            if (dp->pID == -1 && dp->mID == -1)
+            if (dp->pID == -1 && dp->mID == -1 && m_ParticleGrid->IsActive(dp))
             {
                 float ex_energy = m_EnergyComputer->ComputeExternalEnergy(dp->GetPos(),dp->GetDir(),dp);
                 float in_energy = m_EnergyComputer->ComputeInternalEnergy(dp);
 
                 float prob = m_ParticleGrid->m_NumParticles * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                prob /= m_EnergyComputer->GetSamplingWeight();
                 prob *= exp(-(in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
                 if (prob > 1 || m_RandGen->GetVariate() < prob)
                 {
@@ -178,24 +185,26 @@ void MetropolisHastingsSampler::MakeProposal()
             DistortVector(m_Sigma/(2*m_ParticleLength), prop_p.GetDir());
             prop_p.GetDir().normalize();
 
-
-            float ex_energy = m_EnergyComputer->ComputeExternalEnergy(prop_p.GetPos(),prop_p.GetDir(),p)
-                    - m_EnergyComputer->ComputeExternalEnergy(p->GetPos(),p->GetDir(),p);
-            float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop_p) - m_EnergyComputer->ComputeInternalEnergy(p);
-
-            float prob = exp(ex_energy/m_ExTemp+in_energy/m_InTemp);
-            if (m_RandGen->GetVariate() < prob)
+            if (m_ParticleGrid->IsActive(p) && m_ParticleGrid->IsActive(prop_p.GetPos()))
             {
-                vnl_vector_fixed<float, 3> Rtmp = p->GetPos();
-                vnl_vector_fixed<float, 3> Ntmp = p->GetDir();
-                p->GetPos() = prop_p.GetPos();
-                p->GetDir() = prop_p.GetDir();
-                if (!m_ParticleGrid->TryUpdateGrid(pnum))
+                float ex_energy = m_EnergyComputer->ComputeExternalEnergy(prop_p.GetPos(),prop_p.GetDir(),p)
+                        - m_EnergyComputer->ComputeExternalEnergy(p->GetPos(),p->GetDir(),p);
+                float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop_p) - m_EnergyComputer->ComputeInternalEnergy(p);
+
+                float prob = exp(ex_energy/m_ExTemp+in_energy/m_InTemp);
+                if (m_RandGen->GetVariate() < prob)
                 {
-                    p->GetPos() = Rtmp;
-                    p->GetDir() = Ntmp;
+                    vnl_vector_fixed<float, 3> Rtmp = p->GetPos();
+                    vnl_vector_fixed<float, 3> Ntmp = p->GetDir();
+                    p->GetPos() = prop_p.GetPos();
+                    p->GetDir() = prop_p.GetDir();
+                    if (!m_ParticleGrid->TryUpdateGrid(pnum))
+                    {
+                        p->GetPos() = Rtmp;
+                        p->GetDir() = Ntmp;
+                    }
+                    m_AcceptedProposals++;
                 }
-                m_AcceptedProposals++;
             }
             m_ShiftTime.Stop();
         }
@@ -239,7 +248,7 @@ void MetropolisHastingsSampler::MakeProposal()
             else
                 no_proposal = true;
 
-            if (!no_proposal)
+            if (!no_proposal && m_ParticleGrid->IsActive(p) && m_ParticleGrid->IsActive(prop_p.GetPos()))
             {
                 float cos = dot_product(prop_p.GetDir(), p->GetDir());
                 float p_rev = exp(-((prop_p.GetPos()-p->GetPos()).squared_magnitude() + (1-cos*cos))*m_Gamma)/m_Z;
@@ -325,6 +334,14 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
 
     for (;;)
     {
+        // frozen particles of the parallel tracking keep their connections
+        int nextID = (Current.ep == 1) ? Current.p->pID : Current.p->mID;
+        if (!m_ParticleGrid->IsActive(Current.p) || (nextID != -1 && !m_ParticleGrid->IsActive(m_ParticleGrid->GetParticle(nextID))))
+        {
+            AccumProb = 0;
+            break;
+        }
+
         Next.p = nullptr;
         if (Current.ep == 1)
         {
@@ -458,7 +475,7 @@ void MetropolisHastingsSampler::ComputeEndPointProposalDistribution(EndPoint P)
     {
         Particle *p2 =  m_ParticleGrid->GetNextNeighbor();
         if (p2 == nullptr) break;
-        if (p!=p2 && p2->label == 0)
+        if (p!=p2 && p2->label == 0 && m_ParticleGrid->IsActive(p2))
         {
             if (p2->mID == -1)
             {
@@ -18,10 +18,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkParticleGrid.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <algorithm>
 
 using namespace mitk;
 
-ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity)
+ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity, int numCellsX)
 {
     // initialize counters
     m_NumParticles = 0;
@@ -38,6 +39,15 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
     m_GridScale[1] = 1/cellSize;
     m_GridScale[2] = 1/cellSize;
 
+    // all particles are active unless the grid is restricted to a domain
+    m_NumCellsX = m_GridSize[0];
+    if (numCellsX>0)
+        m_GridSize[0] = numCellsX;
+    m_GridOffsetX = 0;
+    m_FirstActiveCellX = itk::NumericTraits<int>::NonpositiveMin();
+    m_LastActiveCellX = itk::NumericTraits<int>::max();
+    m_NumFrozenParticles = 0;
+
     m_CellCapacity = cellCapacity;          // maximum number of particles per grid cell
     m_ContainerCapacity = 100000;           // initial particle container capacity
     unsigned long  numCells = m_GridSize[0]*m_GridSize[1]*m_GridSize[2];   // number of grid cells
@@ -69,6 +79,8 @@ void ParticleGrid::ResetGrid()
     m_NumParticles = 0;
     m_NumConnections = 0;
     m_NumCellOverflows = 0;
+    m_NumFrozenParticles = 0;
+    m_SourceIDs.clear();
     m_Particles.clear();
     m_Grid.clear();
     m_OccupationCount.clear();
@@ -127,7 +139,7 @@ Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
             return nullptr;
     }
 
-    int xint = int(R[0]*m_GridScale[0]);
+    int xint = int(R[0]*m_GridScale[0]) - m_GridOffsetX;
     if (xint < 0)
         return nullptr;
     if (xint >= m_GridSize[0])
@@ -167,7 +179,7 @@ bool ParticleGrid::TryUpdateGrid(int k)
 {
     Particle* p = &(m_Particles[k]);
 
-    int xint = int(p->GetPos()[0]*m_GridScale[0]);
+    int xint = int(p->GetPos()[0]*m_GridScale[0]) - m_GridOffsetX;
     if (xint < 0)
         return false;
     if (xint >= m_GridSize[0])
@@ -273,6 +285,7 @@ void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
 
     int dx = -1;
     if (xfrac-xint > 0.5) dx = 1;
+    xint -= m_GridOffsetX;
     if (xint <= 0) { xint = 0; dx = 1; }
     if (xint >= m_GridSize[0]-1) { xint = m_GridSize[0]-1; dx = -1; }
     if (m_GridSize[0] <= 1) { dx = 0; } // Necessary with 2d images (bug 15416)
@@ -418,3 +431,160 @@ bool ParticleGrid::CheckConsistency()
     }
     return true;
 }
+
+int ParticleGrid::GetNumCellsX() const
+{
+    return m_NumCellsX;
+}
+
+// remove all particles without reallocating the grid
+void ParticleGrid::ClearGrid()
+{
+    m_NumParticles = 0;
+    m_NumConnections = 0;
+    m_NumFrozenParticles = 0;
+    m_SourceIDs.clear();
+    std::fill(m_OccupationCount.begin(), m_OccupationCount.end(), 0);
+}
+
+void ParticleGrid::SetDomain(int firstCellX, int numCellsX, int firstActiveCellX, int lastActiveCellX)
+{
+    m_GridOffsetX = firstCellX;
+    m_GridSize[0] = numCellsX;
+    m_FirstActiveCellX = firstActiveCellX;
+    m_LastActiveCellX = lastActiveCellX;
+    m_NumCellOverflows = 0;
+
+    int numCells = m_GridSize[0]*m_GridSize[1]*m_GridSize[2];
+    if ( (unsigned long)itk::NumericTraits<int>::max()<(unsigned long)numCells*m_CellCapacity )
+        throw std::bad_alloc();
+    m_Grid.resize(numCells*m_CellCapacity, nullptr);
+    m_OccupationCount.resize(numCells);
+    ClearGrid();
+}
+
+void ParticleGrid::CopyDomain(ParticleGrid* source)
+{
+    ClearGrid();
+    std::vector< int > localIDs(source->m_NumParticles, -1);
+
+    // frozen particles first, they are never removed and thus keep their IDs
+    for (int pass=0; pass<2; pass++)
+    {
+        for (int i=0; i<source->m_NumParticles; i++)
+        {
+            Particle* sp = &source->m_Particles[i];
+            int cellX = GetCellX(sp->GetPos());
+            if (cellX<m_GridOffsetX || cellX>=m_GridOffsetX+m_GridSize[0] || IsActive(sp)!=(pass==1))
+                continue;
+
+            Particle* p = NewParticle(sp->GetPos());
+            if (p==nullptr)
+                continue;
+            p->GetDir() = sp->GetDir();
+            localIDs[i] = p->ID;
+            if (pass==0)
+                m_SourceIDs.push_back(i);
+        }
+        if (pass==0)
+            m_NumFrozenParticles = m_NumParticles;
+    }
+
+    // connections to particles outside of the domain are dropped, only frozen particles can have them
+    int numLinks = 0;
+    for (int i=0; i<source->m_NumParticles; i++)
+    {
+        if (localIDs[i]==-1)
+            continue;
+        Particle* sp = &source->m_Particles[i];
+        Particle* p = &m_Particles[localIDs[i]];
+        p->pID = sp->pID!=-1 ? localIDs[sp->pID] : -1;
+        p->mID = sp->mID!=-1 ? localIDs[sp->mID] : -1;
+        numLinks += (p->pID!=-1) + (p->mID!=-1);
+    }
+    m_NumConnections = numLinks/2;
+}
+
+void ParticleGrid::MergeDomains(const std::vector< ParticleGrid* >& domains)
+{
+    // the domains do not overlap, so a particle is either active in exactly one domain or frozen in all of them
+    std::vector< Particle > merged;
+    std::vector< int > mergedIDs(m_NumParticles, -1);
+    for (int i=0; i<m_NumParticles; i++)
+    {
+        bool active = false;
+        for (auto domain : domains)
+            active |= domain->IsActive(&m_Particles[i]);
+        if (active)
+            continue;
+        mergedIDs[i] = merged.size();
+        merged.push_back(m_Particles[i]);
+    }
+    for (auto& p : merged)
+    {
+        p.pID = p.pID!=-1 ? mergedIDs[p.pID] : -1;
+        p.mID = p.mID!=-1 ? mergedIDs[p.mID] : -1;
+    }
+
+    // the active particles and their connections are taken from their domain
+    int numCellOverflows = m_NumCellOverflows;
+    for (auto domain : domains)
+    {
+        int base = merged.size() - domain->m_NumFrozenParticles;
+        for (int i=domain->m_NumFrozenParticles; i<domain->m_NumParticles; i++)
+            merged.push_back(domain->m_Particles[i]);
+
+        for (int i=domain->m_NumFrozenParticles; i<domain->m_NumParticles; i++)
+        {
+            Particle* p = &domain->m_Particles[i];
+            Particle& mp = merged[base+i];
+            int* links[2] = { &mp.pID, &mp.mID };
+            for (int ep=0; ep<2; ep++)
+            {
+                int id = *links[ep];
+                if (id==-1)
+                    continue;
+                if (id>=domain->m_NumFrozenParticles)
+                {
+                    *links[ep] = base+id;
+                    continue;
+                }
+
+                // connection to a frozen particle, update the frozen side as well
+                Particle* fp = &domain->m_Particles[id];
+                *links[ep] = mergedIDs[domain->m_SourceIDs[id]];
+                if (*links[ep]==-1)
+                    continue;
+                if (fp->pID==p->ID)
+                    merged[*links[ep]].pID = base+i;
+                else
+                    merged[*links[ep]].mID = base+i;
+            }
+        }
+        numCellOverflows += domain->m_NumCellOverflows;
+    }
+
+    // rebuild the grid
+    ClearGrid();
+    std::vector< int > newIDs(merged.size(), -1);
+    for (unsigned int i=0; i<merged.size(); i++)
+    {
+        Particle* p = NewParticle(merged[i].GetPos());
+        if (p==nullptr)
+            continue;
+        p->GetDir() = merged[i].GetDir();
+        newIDs[i] = p->ID;
+    }
+    int numLinks = 0;
+    for (unsigned int i=0; i<merged.size(); i++)
+    {
+        if (newIDs[i]==-1)
+            continue;
+        Particle* p = &m_Particles[newIDs[i]];
+        p->pID = merged[i].pID!=-1 ? newIDs[merged[i].pID] : -1;
+        p->mID = merged[i].mID!=-1 ? newIDs[merged[i].mID] : -1;
+        numLinks += (p->pID!=-1) + (p->mID!=-1);
+    }
+    m_NumConnections = numLinks/2;
+    m_NumCellOverflows = numCellOverflows;
+}
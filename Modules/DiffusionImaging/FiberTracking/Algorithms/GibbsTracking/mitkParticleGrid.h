@@ -42,7 +42,7 @@ public:
     int m_NumCellOverflows;     // number of cell overflows
     float m_ParticleLength;
 
-    ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity);
+    ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity, int numCellsX=0);   ///< numCellsX=0 covers the whole image along x
     ~ParticleGrid();
 
     Particle* GetParticle(int ID);
@@ -61,9 +61,34 @@ public:
     bool CheckConsistency();
     void ResetGrid();
 
+    /** Domain decomposition of the parallel tracking. A domain grid covers a slab of grid cells along x and contains
+      * copies of the particles of the whole grid. Only the particles inside its active cells may be created, moved,
+      * removed or (dis)connected. The other particles are frozen and only contribute to the energies. */
+    int GetNumCellsX() const;                                   ///< number of grid cells of the whole image along x
+    void SetDomain(int firstCellX, int numCellsX, int firstActiveCellX, int lastActiveCellX);   ///< removes all particles
+    void CopyDomain(ParticleGrid* source);                      ///< copy all particles of source that lie inside of the domain
+    void MergeDomains(const std::vector< ParticleGrid* >& domains);  ///< replace the particles that are active in one of the domains by the domain particles
+
+    inline int GetCellX(const vnl_vector_fixed<float, 3>& R) const
+    {
+        return int(R[0]*m_GridScale[0]);
+    }
+
+    inline bool IsActive(const vnl_vector_fixed<float, 3>& R) const
+    {
+        int cellX = GetCellX(R);
+        return cellX>=m_FirstActiveCellX && cellX<m_LastActiveCellX;
+    }
+
+    inline bool IsActive(Particle* p) const
+    {
+        return IsActive(p->GetPos());
+    }
+
 protected:
 
     bool ReallocateGrid();
+    void ClearGrid();
 
     std::vector< Particle* >    m_Grid;             // the grid
     std::vector< Particle >     m_Particles;        // particle container
@@ -76,6 +101,13 @@ protected:
 
     int m_CellCapacity;      // particle capacity of single cell in grid
 
+    int m_NumCellsX;            // grid cells of the whole image along x
+    int m_GridOffsetX;          // first grid cell along x covered by this grid
+    int m_FirstActiveCellX;     // first grid cell along x whose particles are not frozen
+    int m_LastActiveCellX;      // end of the active grid cells along x
+    int m_NumFrozenParticles;   // frozen copies, they are stored in front of the active particles and keep their IDs
+    std::vector< int > m_SourceIDs; // IDs of the frozen copies in the source grid
+
     struct NeighborTracker  // to run over the neighbors
     {
         std::vector< int > cellidx;
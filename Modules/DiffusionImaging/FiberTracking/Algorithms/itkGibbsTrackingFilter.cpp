@@ -64,6 +64,7 @@ GibbsTrackingFilter< ItkQBallImageType >::GibbsTrackingFilter():
   m_NumParticles(0),
   m_NumConnections(0),
   m_RandomSeed(-1),
+  m_NumberOfDomains(1),
   m_LoadParameterFile(""),
   m_LutPath(""),
   m_IsInValidState(true)
@@ -274,6 +275,7 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
   MITK_INFO << "Min. fiber length: " << m_MinFiberLength;
   MITK_INFO << "Curvature threshold: " << m_CurvatureThreshold;
   MITK_INFO << "Random seed: " << m_RandomSeed;
+  MITK_INFO << "Parallel domains: " << m_NumberOfDomains;
   MITK_INFO << "----------------------------------------";
 
   // main loop
@@ -282,8 +284,20 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
   m_NumAcceptedFibers = 0;
   m_CurrentIteration = 0;
   bool just_built_fibers = false;
-  boost::progress_display disp(m_Iterations);
-  if (!m_AbortTracking)
+
+  // the domains need at least two active grid cells
+  int numDomains = std::min(m_NumberOfDomains, particleGrid->GetNumCellsX()/m_MinDomainWidth);
+  if (m_NumberOfDomains>1 && numDomains<2)
+    MITK_WARN << "GibbsTrackingFilter: image too small for " << m_NumberOfDomains << " parallel domains. Using the serial sampler.";
+
+  if (numDomains>1)
+  {
+    if (!m_AbortTracking)
+      just_built_fibers = TrackInDomains(particleGrid, interpolator, randGen, numDomains);
+  }
+  else if (!m_AbortTracking)
+  {
+    boost::progress_display disp(m_Iterations);
     while (m_CurrentIteration<m_Iterations)
     {
       just_built_fibers = false;
@@ -313,6 +327,7 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
         just_built_fibers = true;
       }
     }
+  }
   if (!just_built_fibers)
   {
     FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
@@ -342,6 +357,113 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
   SaveParameters();
 }
 
+// Main loop of the parallel tracking. The particle grid is split into slabs along x that are sampled concurrently,
+// each by its own sampler, energy computer and random generator. The outermost grid cell on each side of a slab border
+// is frozen, so concurrently sampled particles never interact. After each phase the slabs are merged and the borders
+// are shifted randomly, so the frozen cells change. The random generators of the domains are seeded from randGen, so
+// the result only depends on the seed and the number of domains, not on the number of threads.
+template< class ItkQBallImageType >
+bool GibbsTrackingFilter< ItkQBallImageType >::TrackInDomains(mitk::ParticleGrid* particleGrid, SphereInterpolator* interpolator, Statistics::MersenneTwisterRandomVariateGenerator* randGen, int numDomains)
+{
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandGenType;
+
+  float alpha = log(m_EndTemperature/m_StartTemperature);
+  int numCellsX = particleGrid->GetNumCellsX();
+  int domainWidth = numCellsX/numDomains;
+  float cellSize = 2*m_ParticleLength;
+  float spacingX = m_MaskImage->GetSpacing()[0];
+  int sizeX = m_MaskImage->GetLargestPossibleRegion().GetSize()[0];
+
+  std::vector< RandGenType::Pointer > randGens;
+  std::vector< SphereInterpolator* > interpolators;
+  std::vector< ParticleGrid* > grids;
+  std::vector< GibbsEnergyComputer* > encomps;
+  std::vector< MetropolisHastingsSampler* > samplers;
+  try{
+    for (int d=0; d<numDomains; d++)
+    {
+      randGens.push_back(RandGenType::New());
+      randGens.back()->SetSeed(randGen->GetIntegerVariate());
+      interpolators.push_back(new SphereInterpolator(*interpolator));   // the interpolation state is not shared
+      grids.push_back(new ParticleGrid(m_MaskImage, m_ParticleLength, m_ParticleGridCellCapacity, 2*domainWidth+2));
+      encomps.push_back(new GibbsEnergyComputer(m_QBallImage, m_MaskImage, grids.back(), interpolators.back(), randGens.back()));
+      encomps.back()->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
+      samplers.push_back(new MetropolisHastingsSampler(grids.back(), encomps.back(), randGens.back(), m_CurvatureThreshold));
+    }
+  }
+  catch(...)
+  {
+    MITK_ERROR  << "Particle grid allocation failed. Not enough memory? Try to increase the particle length or to decrease the number of domains.";
+    m_IsInValidState = false;
+    m_AbortTracking = true;
+  }
+
+  bool just_built_fibers = false;
+  boost::progress_display disp(m_Iterations);
+  while (m_CurrentIteration<m_Iterations && !m_AbortTracking)
+  {
+    just_built_fibers = false;
+    double phaseStart = m_CurrentIteration;
+    unsigned long phaseProposals = std::min((double)m_DomainPhaseProposals, ceil((m_Iterations-m_CurrentIteration)/numDomains));
+    int shift = (int)randGen->GetIntegerVariate(domainWidth-1) - domainWidth/2;
+
+#pragma omp parallel for
+    for (int d=0; d<numDomains; d++)
+    {
+      // the outer domains extend to the image borders
+      int first = d==0 ? 0 : d*domainWidth+shift;
+      int last = d==numDomains-1 ? numCellsX : (d+1)*domainWidth+shift;
+      int firstActive = d==0 ? NumericTraits<int>::NonpositiveMin() : first+1;
+      int lastActive = d==numDomains-1 ? NumericTraits<int>::max() : last-1;
+
+      grids[d]->SetDomain(first-1, last-first+2, firstActive, lastActive);
+      grids[d]->CopyDomain(particleGrid);
+      encomps[d]->SetSamplingRangeX(d==0 ? 0 : floor(firstActive*cellSize/spacingX), d==numDomains-1 ? sizeX : ceil(lastActive*cellSize/spacingX));
+
+      for (unsigned long i=0; i<phaseProposals; i++)
+      {
+        // same annealing schedule as the serial sampler, the domains take interleaved iterations
+        float temperature = m_StartTemperature * exp(alpha*(phaseStart+i*numDomains+d+1)/m_Iterations);
+        samplers[d]->SetTemperature(temperature);
+        samplers[d]->MakeProposal();
+      }
+    }
+    particleGrid->MergeDomains(grids);
+
+    m_CurrentIteration += phaseProposals*numDomains;
+    disp += phaseProposals*numDomains;
+
+    unsigned long acceptedProposals = 0;
+    for (auto sampler : samplers)
+      acceptedProposals += sampler->GetNumAcceptedProposals();
+    m_ProposalAcceptance = (float)acceptedProposals/m_CurrentIteration;
+    m_NumParticles = particleGrid->m_NumParticles;
+    m_NumConnections = particleGrid->m_NumConnections;
+
+    if (m_AbortTracking)
+      break;
+
+    if (m_BuildFibers)
+    {
+      FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+      m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+      m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+      m_BuildFibers = false;
+      just_built_fibers = true;
+    }
+  }
+
+  for (unsigned int d=0; d<samplers.size(); d++)
+    delete samplers[d];
+  for (unsigned int d=0; d<encomps.size(); d++)
+    delete encomps[d];
+  for (unsigned int d=0; d<grids.size(); d++)
+    delete grids[d];
+  for (unsigned int d=0; d<interpolators.size(); d++)
+    delete interpolators[d];
+  return just_built_fibers;
+}
+
 template< class ItkQBallImageType >
 void GibbsTrackingFilter< ItkQBallImageType >::PrepareMaskImage()
 {
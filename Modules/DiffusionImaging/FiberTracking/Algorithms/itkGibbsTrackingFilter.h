@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // MITK
 #include <mitkSphereInterpolator.h>
+#include <mitkParticleGrid.h>
 
 // ITK
 #include <itkProcessObject.h>
@@ -70,6 +71,7 @@ public:
     itkSetMacro( CurvatureThreshold, float)         ///< Absolute angular threshold between two particles (in radians).
     itkSetMacro( DuplicateImage, bool )             ///< Work on copy of input image.
     itkSetMacro( RandomSeed, int )                  ///< Seed for random generator.
+    itkSetMacro( NumberOfDomains, int )             ///< Number of slabs along x that are sampled in parallel. 1 (default) runs the serial sampler.
     itkSetMacro( LoadParameterFile, std::string )   ///< Parameter file.
     itkSetMacro( SaveParameterFile, std::string )
     itkSetMacro( LutPath, std::string )             ///< Path to lookuptables. Default is binary directory.
@@ -85,6 +87,7 @@ public:
     itkGetMacro( CurrentIteration, double)
     itkGetMacro( Iterations, double)
     itkGetMacro( IsInValidState, bool)
+    itkGetMacro( NumberOfDomains, int )
     FiberPolyDataType GetFiberBundle();             ///< Output fibers
 
     /** Input images. */
@@ -106,6 +109,7 @@ protected:
     void PrepareMaskImage();
     bool LoadParameters();
     bool SaveParameters();
+    bool TrackInDomains(mitk::ParticleGrid* particleGrid, SphereInterpolator* interpolator, Statistics::MersenneTwisterRandomVariateGenerator* randGen, int numDomains);  ///< parallel main loop, returns true if the fibers were just built
 
     // Input Images
     typename ItkQBallImageType::Pointer m_QBallImage;
@@ -134,6 +138,7 @@ protected:
     int             m_NumParticles;         ///< current number of particles in grid
     int             m_NumConnections;       ///< current number of connections between particles in grid
     int             m_RandomSeed;           ///< seed value for random generator (-1 for standard seeding)
+    int             m_NumberOfDomains;      ///< number of spatial domains sampled in parallel
     std::string     m_LoadParameterFile;    ///< filename of parameter file (reader)
     std::string     m_SaveParameterFile;    ///< filename of parameter file (writer)
     std::string     m_LutPath;              ///< path to lookuptables used by the sphere interpolator
@@ -143,6 +148,8 @@ protected:
 
     //Constant values
     static const int m_ParticleGridCellCapacity = 1024;
+    static const int m_MinDomainWidth = 4;                      ///< grid cells along x, the outermost cell on each side of a domain border is frozen
+    static const unsigned long m_DomainPhaseProposals = 100000; ///< proposals per domain before the domains are merged and shifted
 };
 }
 
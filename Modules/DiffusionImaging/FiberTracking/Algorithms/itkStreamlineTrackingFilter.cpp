@@ -29,6 +29,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <set>
 
 namespace itk {
 
@@ -726,39 +729,43 @@ void StreamlineTrackingFilter::GenerateData()
   if (m_Random)
     std::random_shuffle(m_SeedPoints.begin(), m_SeedPoints.end());
 
-  bool stop = false;
-  unsigned int current_tracts = 0;
+  std::atomic<unsigned int> current_tracts(0);
+  std::atomic<int> tried(0);
   int num_seeds = m_SeedPoints.size();
   itk::Index<3> zeroIndex; zeroIndex.Fill(0);
-  int progress = 0;
-  int i = 0;
   int print_interval = num_seeds/100;
   if (print_interval<100)
     m_Verbose=false;
 
-#pragma omp parallel
-  while (i<num_seeds && !stop)
-  {
+  // accepted fibers are collected per thread, together with their seed index, and merged in seed order after the loop
+  int num_threads = omp_get_max_threads();
+  std::vector< std::vector< std::pair< int, FiberType > > > thread_tractograms(num_threads);
+  const unsigned int probmap_flush_size = 1000;
 
+  // with a maximum number of tracts, the accepted fibers of the seeds with the lowest indices are kept, so the result
+  // does not depend on which thread finishes first. once m_MaxNumTracts seeds below the cutoff were accepted, seeds
+  // above it cannot contribute anymore and are skipped.
+  std::set< int > accepted_seeds;
+  std::atomic<int> seed_cutoff(num_seeds);
 
-    int temp_i = 0;
-#pragma omp critical
-    {
-      temp_i = i;
-      i++;
-    }
+  // small seed chunks keep the threads balanced, since the streamline lengths vary strongly
+  int chunk_size = std::max(1, std::min(64, num_seeds/(num_threads*64)));
 
-    if (temp_i>=num_seeds || stop)
+#pragma omp parallel for schedule(dynamic, chunk_size)
+  for (int temp_i=0; temp_i<num_seeds; temp_i++)
+  {
+    if (temp_i>seed_cutoff)
       continue;
-    else if (m_Verbose && i%print_interval==0)
+
+    int num_tried = ++tried;
+    if (m_Verbose && num_tried%print_interval==0)
 #pragma omp critical
     {
-      progress += print_interval;
       std::cout << "                                                                                                     \r";
       if (m_MaxNumTracts>0)
-        std::cout << "Tried: " << progress << "/" << num_seeds << " | Accepted: " << current_tracts << "/" << m_MaxNumTracts << '\r';
+        std::cout << "Tried: " << num_tried << "/" << num_seeds << " | Accepted: " << current_tracts << "/" << m_MaxNumTracts << '\r';
       else
-        std::cout << "Tried: " << progress << "/" << num_seeds << " | Accepted: " << current_tracts << '\r';
+        std::cout << "Tried: " << num_tried << "/" << num_seeds << " | Accepted: " << current_tracts << '\r';
       cout.flush();
     }
 
@@ -818,31 +825,80 @@ void StreamlineTrackingFilter::GenerateData()
       }
       counter = fib.size();
 
-#pragma omp critical
-      if (tractLength>=m_MinTractLength && counter>=2)
+      if (tractLength>=m_MinTractLength && counter>=2 && temp_i<=seed_cutoff)
       {
-        if (!stop)
+        if (m_MaxNumTracts > 0)
         {
-          if (!m_UseOutputProbabilityMap)
-            m_Tractogram.push_back(fib);
-          else
-            FiberToProbmap(&fib);
-          current_tracts++;
+          bool accepted = false;
+#pragma omp critical (StreamlineTrackingMaxNumTracts)
+          {
+            if (temp_i<=seed_cutoff)
+            {
+              accepted = true;
+              accepted_seeds.insert(temp_i);
+              if (accepted_seeds.size()>static_cast<unsigned int>(m_MaxNumTracts))
+                accepted_seeds.erase(std::prev(accepted_seeds.end()));
+              if (accepted_seeds.size()==static_cast<unsigned int>(m_MaxNumTracts))
+              {
+                if (seed_cutoff==num_seeds)
+                {
+                  std::cout << "                                                                                                     \r";
+                  MITK_INFO << "Reconstructed maximum number of tracts (" << m_MaxNumTracts << "). Only seeds before the last accepted one are tracked further.";
+                }
+                seed_cutoff = *accepted_seeds.rbegin();
+              }
+            }
+          }
+          if (!accepted)
+            continue;
         }
-        if (m_MaxNumTracts > 0 && current_tracts>=static_cast<unsigned int>(m_MaxNumTracts))
+        ++current_tracts;
+
+        if (m_DemoMode && !m_UseOutputProbabilityMap) // single threaded, the fibers are displayed while tracking
+          m_Tractogram.push_back(fib);
+        else
         {
-          if (!stop)
+          std::vector< std::pair< int, FiberType > >& thread_tractogram = thread_tractograms.at(omp_get_thread_num());
+          thread_tractogram.push_back(std::make_pair(temp_i, std::move(fib)));
+
+          // with a maximum number of tracts, fibers accepted early may still be replaced by fibers of lower seeds
+          if (m_UseOutputProbabilityMap && m_MaxNumTracts<=0 && thread_tractogram.size()>=probmap_flush_size)
           {
-            std::cout << "                                                                                                     \r";
-            MITK_INFO << "Reconstructed maximum number of tracts (" << current_tracts << "). Stopping tractography.";
+#pragma omp critical (StreamlineTrackingProbmap)
+            {
+              for (auto& seed_fib : thread_tractogram)
+                FiberToProbmap(&seed_fib.second);
+            }
+            thread_tractogram.clear();
           }
-          stop = true;
         }
       }
-
     }
   }
 
+  // merging in seed order makes the output independent of the number of threads and the scheduling
+  std::vector< std::pair< int, FiberType* > > sorted_fibers;
+  for (auto& thread_tractogram : thread_tractograms)
+    for (auto& seed_fib : thread_tractogram)
+      sorted_fibers.push_back(std::make_pair(seed_fib.first, &seed_fib.second));
+  std::sort(sorted_fibers.begin(), sorted_fibers.end(), [](const std::pair< int, FiberType* >& a, const std::pair< int, FiberType* >& b){ return a.first<b.first; });
+
+  // fibers accepted before the cutoff dropped below their seed are not among the first m_MaxNumTracts seeds
+  if (m_MaxNumTracts > 0 && sorted_fibers.size()>static_cast<unsigned int>(m_MaxNumTracts))
+    sorted_fibers.resize(m_MaxNumTracts);
+
+  if (m_UseOutputProbabilityMap)
+  {
+    for (auto& seed_fib : sorted_fibers)
+      FiberToProbmap(seed_fib.second);
+  }
+  else
+  {
+    m_Tractogram.reserve(m_Tractogram.size()+sorted_fibers.size());
+    for (auto& seed_fib : sorted_fibers)
+      m_Tractogram.push_back(std::move(*seed_fib.second));
+  }
+
   this->AfterTracking();
 }
 
@@ -949,8 +1005,8 @@ void StreamlineTrackingFilter::BuildFibers(bool check)
   for (unsigned int i=0; i<m_Tractogram.size(); i++)
   {
     vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-    FiberType fib = m_Tractogram.at(i);
-    for (FiberType::iterator it = fib.begin(); it!=fib.end(); ++it)
+    const FiberType& fib = m_Tractogram.at(i);
+    for (FiberType::const_iterator it = fib.begin(); it!=fib.end(); ++it)
     {
       vtkIdType id = vNewPoints->InsertNextPoint((*it).GetDataPointer());
       container->GetPointIds()->InsertNextId(id);
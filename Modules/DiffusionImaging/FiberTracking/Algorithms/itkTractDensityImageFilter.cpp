@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // misc
 #include <math.h>
+#include <algorithm>
 #include <boost/progress.hpp>
 
 namespace itk{
@@ -56,6 +57,93 @@ itk::Point<float, 3> TractDensityImageFilter< OutputImageType >::GetItkPoint(dou
     return itkPoint;
 }
 
+template< class OutputImageType >
+void TractDensityImageFilter< OutputImageType >::AddFiberContributions(vtkPolyData* fiberPolyData, int fiber, const OutputImageType* outImage, int slabDepth, std::vector< std::vector< VoxelContribution > >& slabContributions)
+{
+    typename OutputImageType::RegionType::SizeType size = outImage->GetLargestPossibleRegion().GetSize();
+    int w = size[0];
+    int h = size[1];
+    int d = size[2];
+    OffsetValueType slabSize = (OffsetValueType)w*h*slabDepth;
+
+    auto addContribution = [&](OffsetValueType offset, float value)
+    {
+        VoxelContribution contribution;
+        contribution.Offset = offset;
+        contribution.Value = value;
+        slabContributions[offset/slabSize].push_back(contribution);
+    };
+
+    // vtkPolyData::GetCell is not thread safe
+    vtkIdType numPoints = 0;
+    vtkIdType* pointIds = nullptr;
+    fiberPolyData->GetCellPoints(fiber, numPoints, pointIds);
+    vtkPoints* points = fiberPolyData->GetPoints();
+
+    float weight = m_FiberBundle->GetFiberWeight(fiber);
+
+    for( int j=0; j<numPoints; j++)
+    {
+        double p[3];
+        points->GetPoint(pointIds[j], p);
+        itk::Point<float, 3> vertex = GetItkPoint(p);
+        itk::Index<3> index;
+        itk::ContinuousIndex<float, 3> contIndex;
+        outImage->TransformPhysicalPointToIndex(vertex, index);
+        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+
+        if (!m_UseTrilinearInterpolation && outImage->GetLargestPossibleRegion().IsInside(index))
+        {
+            addContribution(index[0] + w*(index[1] + (OffsetValueType)h*index[2]), weight);
+            continue;
+        }
+
+        float frac_x = contIndex[0] - index[0];
+        float frac_y = contIndex[1] - index[1];
+        float frac_z = contIndex[2] - index[2];
+
+        if (frac_x<0)
+        {
+            index[0] -= 1;
+            frac_x += 1;
+        }
+        if (frac_y<0)
+        {
+            index[1] -= 1;
+            frac_y += 1;
+        }
+        if (frac_z<0)
+        {
+            index[2] -= 1;
+            frac_z += 1;
+        }
+
+        frac_x = 1-frac_x;
+        frac_y = 1-frac_y;
+        frac_z = 1-frac_z;
+
+        // int coordinates inside image?
+        if (index[0] < 0 || index[0] >= w-1)
+            continue;
+        if (index[1] < 0 || index[1] >= h-1)
+            continue;
+        if (index[2] < 0 || index[2] >= d-1)
+            continue;
+
+        OffsetValueType offset = index[0] + w*(index[1] + (OffsetValueType)h*index[2]);
+        OffsetValueType dy = w;
+        OffsetValueType dz = (OffsetValueType)w*h;
+        addContribution(offset,           (  frac_x)*(  frac_y)*(  frac_z));
+        addContribution(offset+dy,        (  frac_x)*(1-frac_y)*(  frac_z));
+        addContribution(offset+dz,        (  frac_x)*(  frac_y)*(1-frac_z));
+        addContribution(offset+dy+dz,     (  frac_x)*(1-frac_y)*(1-frac_z));
+        addContribution(offset+1,         (1-frac_x)*(  frac_y)*(  frac_z));
+        addContribution(offset+1+dz,      (1-frac_x)*(  frac_y)*(1-frac_z));
+        addContribution(offset+1+dy,      (1-frac_x)*(1-frac_y)*(  frac_z));
+        addContribution(offset+1+dy+dz,   (1-frac_x)*(1-frac_y)*(1-frac_z));
+    }
+}
+
 template< class OutputImageType >
 void TractDensityImageFilter< OutputImageType >::GenerateData()
 {
@@ -140,109 +228,100 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
     MITK_INFO << "TractDensityImageFilter: starting image generation";
 
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-
     int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
+
+    // contiguous blocks of fibers with roughly the same number of points; the first cell access builds the cell links
+    // of the poly data and must not happen in parallel
+    const vtkIdType pointsPerBlock = 16384;
+    const int blocksPerChunk = 64;
+    std::vector< int > blockStarts;
+    vtkIdType blockPoints = pointsPerBlock;
     for( int i=0; i<numFibers; i++ )
     {
-        ++disp;
-        vtkCell* cell = fiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        float weight = m_FiberBundle->GetFiberWeight(i);
-
-        // fill output image
-        for( int j=0; j<numPoints; j++)
+        if (blockPoints>=pointsPerBlock)
         {
-            itk::Point<float, 3> vertex = GetItkPoint(points->GetPoint(j));
-            itk::Index<3> index;
-            itk::ContinuousIndex<float, 3> contIndex;
-            outImage->TransformPhysicalPointToIndex(vertex, index);
-            outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+            blockStarts.push_back(i);
+            blockPoints = 0;
+        }
+        vtkIdType numPoints = 0;
+        vtkIdType* pointIds = nullptr;
+        fiberPolyData->GetCellPoints(i, numPoints, pointIds);
+        blockPoints += numPoints;
+    }
+    int numBlocks = blockStarts.size();
+    blockStarts.push_back(numFibers);
 
-            if (!m_UseTrilinearInterpolation && outImage->GetLargestPossibleRegion().IsInside(index))
-            {
-                if (m_BinaryOutput)
-                    outImage->SetPixel(index, 1);
-                else
-                    outImage->SetPixel(index, outImage->GetPixel(index)+weight);
-                continue;
-            }
+    int numSlabs = std::max(1, std::min(d, 64));
+    int slabDepth = (d+numSlabs-1)/numSlabs;
 
-            float frac_x = contIndex[0] - index[0];
-            float frac_y = contIndex[1] - index[1];
-            float frac_z = contIndex[2] - index[2];
+    boost::progress_display disp(numFibers);
+    for (int chunkStart=0; chunkStart<numBlocks; chunkStart+=blocksPerChunk)
+    {
+        int chunkEnd = std::min(chunkStart+blocksPerChunk, numBlocks);
 
-            if (frac_x<0)
-            {
-                index[0] -= 1;
-                frac_x += 1;
-            }
-            if (frac_y<0)
-            {
-                index[1] -= 1;
-                frac_y += 1;
-            }
-            if (frac_z<0)
-            {
-                index[2] -= 1;
-                frac_z += 1;
-            }
+        // contributions of every block of the chunk, sorted into slabs
+        std::vector< std::vector< std::vector< VoxelContribution > > > contributions(chunkEnd-chunkStart, std::vector< std::vector< VoxelContribution > >(numSlabs));
 
-            frac_x = 1-frac_x;
-            frac_y = 1-frac_y;
-            frac_z = 1-frac_z;
+#pragma omp parallel for schedule(dynamic)
+        for (int b=chunkStart; b<chunkEnd; b++)
+        {
+            for (int i=blockStarts[b]; i<blockStarts[b+1]; i++)
+                this->AddFiberContributions(fiberPolyData, i, outImage, slabDepth, contributions[b-chunkStart]);
 
-            // int coordinates inside image?
-            if (index[0] < 0 || index[0] >= w-1)
-                continue;
-            if (index[1] < 0 || index[1] >= h-1)
-                continue;
-            if (index[2] < 0 || index[2] >= d-1)
-                continue;
+#pragma omp critical
+            disp += blockStarts[b+1]-blockStarts[b];
+        }
 
-            if (m_BinaryOutput)
-            {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] = 1;
-            }
-            else
+        // every slab is written by one thread only, in block and thus in fiber order
+#pragma omp parallel for schedule(dynamic)
+        for (int slab=0; slab<numSlabs; slab++)
+        {
+            for (int b=0; b<chunkEnd-chunkStart; b++)
             {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] += (  frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] += (  frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] += (  frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] += (  frac_x)*(1-frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] += (1-frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] += (1-frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] += (1-frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] += (1-frac_x)*(1-frac_y)*(1-frac_z);
+                const std::vector< VoxelContribution >& slabContributions = contributions[b][slab];
+                if (m_BinaryOutput)
+                {
+                    for (unsigned int c=0; c<slabContributions.size(); c++)
+                        outImageBufferPointer[slabContributions[c].Offset] = 1;
+                }
+                else
+                {
+                    for (unsigned int c=0; c<slabContributions.size(); c++)
+                        outImageBufferPointer[slabContributions[c].Offset] += slabContributions[c].Value;
+                }
             }
         }
     }
 
     m_MaxDensity = 0;
-    for (int i=0; i<w*h*d; i++)
-        if (m_MaxDensity < outImageBufferPointer[i])
-            m_MaxDensity = outImageBufferPointer[i];
+#pragma omp parallel
+    {
+        OutPixelType threadMaxDensity = 0;
+#pragma omp for
+        for (int i=0; i<w*h*d; i++)
+            if (threadMaxDensity < outImageBufferPointer[i])
+                threadMaxDensity = outImageBufferPointer[i];
+
+#pragma omp critical
+        if (m_MaxDensity < threadMaxDensity)
+            m_MaxDensity = threadMaxDensity;
+    }
     if (!m_OutputAbsoluteValues && !m_BinaryOutput)
     {
         MITK_INFO << "TractDensityImageFilter: max-normalizing output image";
         if (m_MaxDensity>0)
+        {
+#pragma omp parallel for
             for (int i=0; i<w*h*d; i++)
             {
                 outImageBufferPointer[i] /= m_MaxDensity;
             }
+        }
     }
     if (m_InvertImage)
     {
         MITK_INFO << "TractDensityImageFilter: inverting image";
+#pragma omp parallel for
         for (int i=0; i<w*h*d; i++)
             outImageBufferPointer[i] = 1-outImageBufferPointer[i];
     }
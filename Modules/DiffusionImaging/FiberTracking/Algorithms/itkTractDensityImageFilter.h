@@ -21,11 +21,18 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkVectorContainer.h>
 #include <itkRGBAPixel.h>
 #include <mitkFiberBundle.h>
+#include <vector>
 
 namespace itk{
 
 /**
-* \brief Generates tract density images from input fiberbundles (Calamante 2010).   */
+* \brief Generates tract density images from input fiberbundles (Calamante 2010).
+*
+* The fibers are rasterized in parallel. The threads compute the voxel contributions of blocks of fibers and sort them
+* into slabs of the output image; afterwards every thread adds the contributions falling into its slabs in fiber
+* order. Each voxel therefore receives the same sequence of additions as in a single threaded run and the output does
+* not depend on the number of threads.
+*/
 
 template< class OutputImageType >
 class TractDensityImageFilter : public ImageSource< OutputImageType >
@@ -64,8 +71,18 @@ public:
 
 protected:
 
+  /** Value added to (or, for binary output, set in) the output buffer at the given offset */
+  struct VoxelContribution
+  {
+    OffsetValueType Offset;
+    float           Value;
+  };
+
   itk::Point<float, 3> GetItkPoint(double point[3]);
 
+  /** Rasterizes one fiber, the contributions are appended to the list of the slab of the respective voxel */
+  void AddFiberContributions(vtkPolyData* fiberPolyData, int fiber, const OutputImageType* outImage, int slabDepth, std::vector< std::vector< VoxelContribution > >& slabContributions);
+
   TractDensityImageFilter();
   virtual ~TractDensityImageFilter();
 
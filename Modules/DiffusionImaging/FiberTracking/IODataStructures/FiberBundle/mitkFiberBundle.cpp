@@ -46,6 +46,145 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkLookupTable.h>
 #include <mitkLookupTable.h>
 #include <vtkCardinalSpline.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <algorithm>
+
+namespace
+{
+  typedef vnl_vector_fixed< double, 3 > FiberPointType;
+  typedef std::vector< FiberPointType > FiberType;
+
+  // vtkPolyData builds its cell links on the first cell access, which must not happen inside a parallel region
+  void PrepareParallelCellAccess(vtkPolyData* polyData)
+  {
+    if (polyData->GetNumberOfCells()<=0)
+      return;
+    vtkIdType numPoints = 0;
+    vtkIdType* pointIds = nullptr;
+    polyData->GetCellPoints(0, numPoints, pointIds);
+  }
+
+  // in contrast to vtkPolyData::GetCell, this may be called from several threads (after PrepareParallelCellAccess)
+  void GetFiberPoints(vtkPolyData* polyData, int fiber, FiberType& fiberPoints)
+  {
+    vtkIdType numPoints = 0;
+    vtkIdType* pointIds = nullptr;
+    polyData->GetCellPoints(fiber, numPoints, pointIds);
+
+    vtkPoints* points = polyData->GetPoints();
+    fiberPoints.resize(numPoints);
+    for (vtkIdType j=0; j<numPoints; j++)
+      points->GetPoint(pointIds[j], fiberPoints[j].data_block());
+  }
+
+  FiberType ResampleFiberLinear(const FiberType& vertices, double pointDistance)
+  {
+    FiberType newVertices;
+    if (vertices.empty())
+      return newVertices;
+
+    FiberPointType lastV = vertices.at(0);
+    newVertices.push_back(lastV);
+    for (unsigned int j=1; j<vertices.size(); j++)
+    {
+      FiberPointType vec = vertices.at(j) - lastV;
+      double new_dist = vec.magnitude();
+
+      if (new_dist >= pointDistance)
+      {
+        FiberPointType newV = lastV;
+        if ( new_dist-pointDistance <= mitk::eps )
+        {
+          vec.normalize();
+          newV += vec * pointDistance;
+        }
+        else
+        {
+          // intersection between sphere (radius 'pointDistance', center 'lastV') and line (direction 'd' and point 'p')
+          FiberPointType p = vertices.at(j-1);
+          FiberPointType d = vertices.at(j) - p;
+
+          double a = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+          double b = 2 * (d[0] * (p[0] - lastV[0]) + d[1] * (p[1] - lastV[1]) + d[2] * (p[2] - lastV[2]));
+          double c = (p[0] - lastV[0])*(p[0] - lastV[0]) + (p[1] - lastV[1])*(p[1] - lastV[1]) + (p[2] - lastV[2])*(p[2] - lastV[2]) - pointDistance*pointDistance;
+
+          double v1 =(-b + std::sqrt(b*b-4*a*c))/(2*a);
+          double v2 =(-b - std::sqrt(b*b-4*a*c))/(2*a);
+
+          if (v1>0)
+            newV = p + d * v1;
+          else if (v2>0)
+            newV = p + d * v2;
+          else
+            MITK_INFO << "ERROR1 - linear resampling";
+
+          j--;
+        }
+
+        newVertices.push_back(newV);
+        lastV = newV;
+      }
+      else if (j==vertices.size()-1 && new_dist>0.0001)
+      {
+        newVertices.push_back(vertices.at(j));
+      }
+    }
+    return newVertices;
+  }
+
+  bool IsInsideMask(const mitk::FiberBundle::ItkUcharImgType* mask, const FiberPointType& p)
+  {
+    itk::Point<float, 3> itkP;
+    itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
+    itk::Index<3> idx;
+    mask->TransformPhysicalPointToIndex(itkP, idx);
+    return mask->GetLargestPossibleRegion().IsInside(idx) && mask->GetPixel(idx) != 0;
+  }
+
+  // world bounds of all non-zero voxels (including a half voxel border); false if the mask is empty
+  bool GetMaskBounds(const mitk::FiberBundle::ItkUcharImgType* mask, double bounds[6])
+  {
+    typedef mitk::FiberBundle::ItkUcharImgType ImageType;
+    itk::Index<3> minIdx;
+    itk::Index<3> maxIdx;
+    bool empty = true;
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it(mask, mask->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      if (it.Get()==0)
+        continue;
+      itk::Index<3> idx = it.GetIndex();
+      for (int d=0; d<3; d++)
+      {
+        if (empty || idx[d]<minIdx[d])
+          minIdx[d] = idx[d];
+        if (empty || idx[d]>maxIdx[d])
+          maxIdx[d] = idx[d];
+      }
+      empty = false;
+    }
+    if (empty)
+      return false;
+
+    double margin = 0.01*std::min(mask->GetSpacing()[0], std::min(mask->GetSpacing()[1], mask->GetSpacing()[2]));
+    for (int c=0; c<8; c++)
+    {
+      itk::ContinuousIndex<double, 3> corner;
+      for (int d=0; d<3; d++)
+        corner[d] = ((c>>d) & 1) ? maxIdx[d]+0.5 : minIdx[d]-0.5;
+      itk::Point<double, 3> p;
+      mask->TransformContinuousIndexToPhysicalPoint(corner, p);
+      for (int d=0; d<3; d++)
+      {
+        if (c==0 || p[d]-margin<bounds[2*d])
+          bounds[2*d] = p[d]-margin;
+        if (c==0 || p[d]+margin>bounds[2*d+1])
+          bounds[2*d+1] = p[d]+margin;
+      }
+    }
+    return true;
+  }
+}
 
 const char* mitk::FiberBundle::FIBER_ID_ARRAY = "Fiber_IDs";
 
@@ -53,6 +192,8 @@ using namespace std;
 
 mitk::FiberBundle::FiberBundle( vtkPolyData* fiberPolyData )
   : m_NumFibers(0)
+  , m_SpatialIndexValid(false)
+  , m_SpatialIndexCellSize(1)
 {
   m_FiberWeights = vtkSmartPointer<vtkFloatArray>::New();
   m_FiberWeights->SetName("FIBER_WEIGHTS");
@@ -192,23 +333,8 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::SubtractBundle(mitk::FiberBundle*
   vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
   vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
 
-  std::vector< std::vector< itk::Point<float, 3> > > points1;
-  for( int i=0; i<m_NumFibers; i++ )
-  {
-    vtkCell* cell = m_FiberPolyData->GetCell(i);
-    int numPoints = cell->GetNumberOfPoints();
-    vtkPoints* points = cell->GetPoints();
-
-    if (points==nullptr || numPoints<=0)
-      continue;
-
-    itk::Point<float, 3> start = GetItkPoint(points->GetPoint(0));
-    itk::Point<float, 3> end = GetItkPoint(points->GetPoint(numPoints-1));
-
-    points1.push_back( {start, end} );
-  }
-
-  std::vector< std::vector< itk::Point<float, 3> > > points2;
+  // start and end point of every fiber of fib, empty for fibers without points
+  std::vector< std::vector< itk::Point<float, 3> > > points2(fib->GetNumFibers());
   for( int i=0; i<fib->GetNumFibers(); i++ )
   {
     vtkCell* cell = fib->GetFiberPolyData()->GetCell(i);
@@ -221,26 +347,35 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::SubtractBundle(mitk::FiberBundle*
     itk::Point<float, 3> start = GetItkPoint(points->GetPoint(0));
     itk::Point<float, 3> end = GetItkPoint(points->GetPoint(numPoints-1));
 
-    points2.push_back( {start, end} );
+    points2.at(i) = {start, end};
   }
 
-  int progress = 0;
-  std::vector< int > ids;
+  // a matching fiber of fib has an end point at the start point of our fiber, so only the fibers of fib passing
+  // close to this point are compared
+  fib->UpdateSpatialIndex();
+  double searchRadius = std::sqrt(mitk::eps);
+
+  std::vector< unsigned char > keep(m_NumFibers, 0);
+  PrepareParallelCellAccess(m_FiberPolyData);
 #pragma omp parallel for
-  for (int i=0; i<(int)points1.size(); i++)
+  for (int i=0; i<m_NumFibers; i++)
   {
-#pragma omp critical
-    {
-      progress++;
-      std::cout << (int)(100*(float)progress/points1.size()) << "%" << '\r';
-      cout.flush();
-    }
+    FiberType fiber;
+    GetFiberPoints(m_FiberPolyData, i, fiber);
+    if (fiber.empty())
+      continue;
+
+    std::vector< itk::Point<float, 3> > v1 = {GetItkPoint(fiber.front().data_block()), GetItkPoint(fiber.back().data_block())};
+    double box[6] = {v1[0][0]-searchRadius, v1[0][0]+searchRadius,
+                     v1[0][1]-searchRadius, v1[0][1]+searchRadius,
+                     v1[0][2]-searchRadius, v1[0][2]+searchRadius};
 
     bool match = false;
-    for (unsigned int j=0; j<points2.size(); j++)
+    for (int id : fib->GetFiberIdsInBox(box))
     {
-      auto v1 = points1.at(i);
-      auto v2 = points2.at(j);
+      const std::vector< itk::Point<float, 3> >& v2 = points2.at(id);
+      if (v2.empty())
+        continue;
 
       unsigned int matches = 0;
       unsigned int reverse_matches = 0;
@@ -255,24 +390,23 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::SubtractBundle(mitk::FiberBundle*
       if (matches==v1.size() || reverse_matches==v1.size())
       {
         match = true;
-        j=points2.size();
+        break;
       }
     }
 
-#pragma omp critical
     if (!match)
-      ids.push_back(i);
+      keep[i] = 1;
   }
 
-  for( int i : ids )
+  for( int i=0; i<m_NumFibers; i++ )
   {
+    if (!keep[i])
+      continue;
+
     vtkCell* cell = m_FiberPolyData->GetCell(i);
     int numPoints = cell->GetNumberOfPoints();
     vtkPoints* points = cell->GetPoints();
 
-    if (points==nullptr || numPoints<=0)
-      continue;
-
     vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
     for( int j=0; j<numPoints; j++)
     {
@@ -311,6 +445,7 @@ void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, b
     m_FiberPolyData->DeepCopy(fiberPD);
 
   m_NumFibers = m_FiberPolyData->GetNumberOfLines();
+  m_SpatialIndexValid = false;
 
   if (updateGeometry)
     UpdateFiberGeometry();
@@ -767,179 +902,96 @@ void mitk::FiberBundle::GenerateFiberIds()
 
 mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint, bool invert, bool bothEnds, float fraction)
 {
-  vtkSmartPointer<vtkPolyData> PolyData = m_FiberPolyData;
-  if (anyPoint)
-  {
-    float minSpacing = 1;
-    if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
-      minSpacing = mask->GetSpacing()[0];
-    else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
-      minSpacing = mask->GetSpacing()[1];
-    else
-      minSpacing = mask->GetSpacing()[2];
+  float minSpacing = 1;
+  if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
+    minSpacing = mask->GetSpacing()[0];
+  else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
+    minSpacing = mask->GetSpacing()[1];
+  else
+    minSpacing = mask->GetSpacing()[2];
 
-    mitk::FiberBundle::Pointer fibCopy = this->GetDeepCopy();
-    fibCopy->ResampleLinear(minSpacing/5);
-    PolyData = fibCopy->GetFiberPolyData();
-  }
-  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  // only fibers passing the bounding box of the mask can touch it, all others are decided without sampling the mask
+  std::vector< unsigned char > isCandidate(m_NumFibers, 0);
+  double maskBounds[6];
+  if (GetMaskBounds(mask, maskBounds))
+    for (int id : this->GetFiberIdsInBox(maskBounds))
+      isCandidate[id] = 1;
 
   MITK_INFO << "Extracting fibers";
-  boost::progress_display disp(m_NumFibers);
+  std::vector< FiberType > newFibers(m_NumFibers);
+  PrepareParallelCellAccess(m_FiberPolyData);
+#pragma omp parallel for
   for (int i=0; i<m_NumFibers; i++)
   {
-    ++disp;
-
-    vtkCell* cell = PolyData->GetCell(i);
-    int numPoints = cell->GetNumberOfPoints();
-    vtkPoints* points = cell->GetPoints();
-
-    vtkCell* cellOriginal = m_FiberPolyData->GetCell(i);
-    int numPointsOriginal = cellOriginal->GetNumberOfPoints();
-    vtkPoints* pointsOriginal = cellOriginal->GetPoints();
+    if (!isCandidate[i] && !invert)
+      continue;
 
-    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    FiberType fiber;
+    GetFiberPoints(m_FiberPolyData, i, fiber);
+    if (anyPoint)
+      fiber = ResampleFiberLinear(fiber, minSpacing/5);
+    if (fiber.size()<2)
+      continue;
 
-    if (numPoints>1 && numPointsOriginal)
+    bool includeFiber = false;
+    if (!isCandidate[i])
+      includeFiber = true;
+    else if (anyPoint)
     {
-      if (anyPoint)
+      int inside = 0;
+      int outside = 0;
+      for (unsigned int j=0; j<fiber.size(); j++)
       {
-        int inside = 0;
-        int outside = 0;
-        if (!invert)
+        if ( IsInsideMask(mask, fiber[j]) )
         {
-          for (int j=0; j<numPoints; j++)
-          {
-            double* p = points->GetPoint(j);
-
-            itk::Point<float, 3> itkP;
-            itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-            itk::Index<3> idx;
-            mask->TransformPhysicalPointToIndex(itkP, idx);
-
-            if ( mask->GetLargestPossibleRegion().IsInside(idx) && mask->GetPixel(idx) != 0 )
-            {
-              inside++;
-              if (fraction==0)
-                break;
-            }
-            else
-              outside++;
-          }
-
-          float current_fraction = 0.0;
-          if (inside+outside>0)
-            current_fraction = (float)inside/(inside+outside);
-
-          if (current_fraction>fraction)
-          {
-            for (int k=0; k<numPoints; k++)
-            {
-              double* p = points->GetPoint(k);
-              vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-              container->GetPointIds()->InsertNextId(id);
-            }
-          }
+          inside++;
+          if (fraction==0 || invert)
+            break;
         }
         else
-        {
-          bool includeFiber = true;
-          for (int j=0; j<numPoints; j++)
-          {
-            double* p = points->GetPoint(j);
-
-            itk::Point<float, 3> itkP;
-            itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-            itk::Index<3> idx;
-            mask->TransformPhysicalPointToIndex(itkP, idx);
-
-            if ( mask->GetPixel(idx) != 0 && mask->GetLargestPossibleRegion().IsInside(idx) )
-            {
-              inside++;
-              includeFiber = false;
-              break;
-            }
-            else
-              outside++;
-          }
-          if (includeFiber)
-          {
-
-            for (int k=0; k<numPoints; k++)
-            {
-              double* p = points->GetPoint(k);
-              vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-              container->GetPointIds()->InsertNextId(id);
-            }
-          }
-        }
+          outside++;
       }
+
+      if (invert)
+        includeFiber = inside==0;
       else
       {
-        double* start = pointsOriginal->GetPoint(0);
-        itk::Point<float, 3> itkStart;
-        itkStart[0] = start[0]; itkStart[1] = start[1]; itkStart[2] = start[2];
-        itk::Index<3> idxStart;
-        mask->TransformPhysicalPointToIndex(itkStart, idxStart);
-
-        double* end = pointsOriginal->GetPoint(numPointsOriginal-1);
-        itk::Point<float, 3> itkEnd;
-        itkEnd[0] = end[0]; itkEnd[1] = end[1]; itkEnd[2] = end[2];
-        itk::Index<3> idxEnd;
-        mask->TransformPhysicalPointToIndex(itkEnd, idxEnd);
-
-        if (invert)
-        {
-          if (bothEnds)
-          {
-            if ( mask->GetPixel(idxStart) == 0 && mask->GetPixel(idxEnd) == 0 )
-            {
-              for (int j=0; j<numPointsOriginal; j++)
-              {
-                double* p = pointsOriginal->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-              }
-            }
-          }
-          else if ( mask->GetPixel(idxStart) == 0 || mask->GetPixel(idxEnd) == 0 )
-          {
-            for (int j=0; j<numPointsOriginal; j++)
-            {
-              double* p = pointsOriginal->GetPoint(j);
-              vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-              container->GetPointIds()->InsertNextId(id);
-            }
-          }
-        }
-        else
-        {
-          if (bothEnds)
-          {
-            if ( mask->GetPixel(idxStart) != 0 && mask->GetPixel(idxEnd) != 0 && mask->GetLargestPossibleRegion().IsInside(idxStart) && mask->GetLargestPossibleRegion().IsInside(idxEnd) )
-            {
-              for (int j=0; j<numPointsOriginal; j++)
-              {
-                double* p = pointsOriginal->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-              }
-            }
-          }
-          else if ( (mask->GetPixel(idxStart) != 0 && mask->GetLargestPossibleRegion().IsInside(idxStart)) || (mask->GetPixel(idxEnd) != 0 && mask->GetLargestPossibleRegion().IsInside(idxEnd)) )
-          {
-            for (int j=0; j<numPointsOriginal; j++)
-            {
-              double* p = pointsOriginal->GetPoint(j);
-              vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-              container->GetPointIds()->InsertNextId(id);
-            }
-          }
-        }
+        float current_fraction = 0.0;
+        if (inside+outside>0)
+          current_fraction = (float)inside/(inside+outside);
+        includeFiber = current_fraction>fraction;
       }
     }
+    else
+    {
+      bool startInside = IsInsideMask(mask, fiber.front());
+      bool endInside = IsInsideMask(mask, fiber.back());
+
+      if (invert && bothEnds)
+        includeFiber = !startInside && !endInside;
+      else if (invert)
+        includeFiber = !startInside || !endInside;
+      else if (bothEnds)
+        includeFiber = startInside && endInside;
+      else
+        includeFiber = startInside || endInside;
+    }
 
+    if (includeFiber)
+      newFibers[i].swap(fiber);
+  }
+
+  // every input fiber yields a (possibly empty) output fiber
+  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<m_NumFibers; i++)
+  {
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    for (unsigned int j=0; j<newFibers[i].size(); j++)
+    {
+      vtkIdType id = vtkNewPoints->InsertNextPoint(newFibers[i][j].data_block());
+      container->GetPointIds()->InsertNextId(id);
+    }
     vtkNewCells->InsertNextCell(container);
   }
 
@@ -962,61 +1014,59 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::RemoveFibersOutside(ItkUcharImgTyp
   else
     minSpacing = mask->GetSpacing()[2];
 
-  mitk::FiberBundle::Pointer fibCopy = this->GetDeepCopy();
-  fibCopy->ResampleLinear(minSpacing/10);
-  vtkSmartPointer<vtkPolyData> PolyData =fibCopy->GetFiberPolyData();
-
-  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  // fibers not passing the bounding box of the mask are completely outside
+  std::vector< unsigned char > isCandidate(m_NumFibers, 0);
+  double maskBounds[6];
+  if (GetMaskBounds(mask, maskBounds))
+    for (int id : this->GetFiberIdsInBox(maskBounds))
+      isCandidate[id] = 1;
 
   MITK_INFO << "Cutting fibers";
-  boost::progress_display disp(m_NumFibers);
+  std::vector< std::vector< FiberType > > newFibers(m_NumFibers);
+  PrepareParallelCellAccess(m_FiberPolyData);
+#pragma omp parallel for
   for (int i=0; i<m_NumFibers; i++)
   {
-    ++disp;
+    if (!isCandidate[i] && !invert)
+      continue;
 
-    vtkCell* cell = PolyData->GetCell(i);
-    int numPoints = cell->GetNumberOfPoints();
-    vtkPoints* points = cell->GetPoints();
+    FiberType fiber;
+    GetFiberPoints(m_FiberPolyData, i, fiber);
+    fiber = ResampleFiberLinear(fiber, minSpacing/10);
+    if (fiber.size()<2)
+      continue;
 
-    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-    if (numPoints>1)
+    // split the fiber into its pieces inside (or outside if inverted) of the mask
+    FiberType piece;
+    for (unsigned int j=0; j<fiber.size(); j++)
     {
-      int newNumPoints = 0;
-      for (int j=0; j<numPoints; j++)
+      bool inside = isCandidate[i] && IsInsideMask(mask, fiber[j]);
+      if (inside != invert)
+        piece.push_back(fiber[j]);
+      else if (!piece.empty())
       {
-        double* p = points->GetPoint(j);
-
-        itk::Point<float, 3> itkP;
-        itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-        itk::Index<3> idx;
-        mask->TransformPhysicalPointToIndex(itkP, idx);
-
-        if ( mask->GetPixel(idx) != 0 && mask->GetLargestPossibleRegion().IsInside(idx) && !invert )
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-          container->GetPointIds()->InsertNextId(id);
-          newNumPoints++;
-        }
-        else if ( (mask->GetPixel(idx) == 0 || !mask->GetLargestPossibleRegion().IsInside(idx)) && invert )
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-          container->GetPointIds()->InsertNextId(id);
-          newNumPoints++;
-        }
-        else if (newNumPoints>0)
-        {
-          vtkNewCells->InsertNextCell(container);
-
-          newNumPoints = 0;
-          container = vtkSmartPointer<vtkPolyLine>::New();
-        }
+        newFibers[i].push_back(piece);
+        piece.clear();
       }
-
-      if (newNumPoints>0)
-        vtkNewCells->InsertNextCell(container);
     }
+    if (!piece.empty())
+      newFibers[i].push_back(piece);
+  }
 
+  vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+  for (int i=0; i<m_NumFibers; i++)
+  {
+    for (const FiberType& piece : newFibers[i])
+    {
+      vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+      for (unsigned int j=0; j<piece.size(); j++)
+      {
+        vtkIdType id = vtkNewPoints->InsertNextPoint(piece[j].data_block());
+        container->GetPointIds()->InsertNextId(id);
+      }
+      vtkNewCells->InsertNextCell(container);
+    }
   }
 
   if (vtkNewCells->GetNumberOfCells()<=0)
@@ -1127,38 +1177,52 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
         polygonVtk->GetPointIds()->InsertNextId(id);
       }
 
-      MITK_INFO << "Extracting with polygon";
-      boost::progress_display disp(m_NumFibers);
-      for (int i=0; i<m_NumFibers; i++)
+      double tolerance = 0.001;
+      double bounds[6];
+      polygonVtk->GetPoints()->GetBounds(bounds);
+      for (int d=0; d<3; d++)
       {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        bounds[2*d] -= tolerance;
+        bounds[2*d+1] += tolerance;
+      }
+      std::vector< int > candidates = this->GetFiberIdsInBox(bounds);
+      std::vector< unsigned char > hit(candidates.size(), 0);
 
-        for (int j=0; j<numPoints-1; j++)
-        {
-          // Inputs
-          double p1[3] = {0,0,0};
-          points->GetPoint(j, p1);
-          double p2[3] = {0,0,0};
-          points->GetPoint(j+1, p2);
-          double tolerance = 0.001;
+      MITK_INFO << "Extracting with polygon (" << candidates.size() << " candidate fibers)";
+      PrepareParallelCellAccess(m_FiberPolyData);
+#pragma omp parallel
+      {
+        // vtkPolygon::IntersectWithLine updates the cached bounds of the polygon, so every thread needs its own copy
+        vtkSmartPointer<vtkPolygon> threadPolygon = vtkSmartPointer<vtkPolygon>::New();
+        threadPolygon->DeepCopy(polygonVtk);
+        FiberType fiber;
 
-          // Outputs
-          double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
-          double x[3] = {0,0,0}; // The coordinate of the intersection
-          double pcoords[3] = {0,0,0};
-          int subId = 0;
+#pragma omp for
+        for (int c=0; c<(int)candidates.size(); c++)
+        {
+          GetFiberPoints(m_FiberPolyData, candidates[c], fiber);
 
-          int iD = polygonVtk->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId);
-          if (iD!=0)
+          for (int j=0; j<(int)fiber.size()-1; j++)
           {
-            result.push_back(i);
-            break;
+            // Outputs
+            double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
+            double x[3] = {0,0,0}; // The coordinate of the intersection
+            double pcoords[3] = {0,0,0};
+            int subId = 0;
+
+            int iD = threadPolygon->IntersectWithLine(fiber[j].data_block(), fiber[j+1].data_block(), tolerance, t, x, pcoords, subId);
+            if (iD!=0)
+            {
+              hit[c] = 1;
+              break;
+            }
           }
         }
       }
+
+      for (unsigned int c=0; c<candidates.size(); c++)
+        if (hit[c])
+          result.push_back(candidates[c]);
     }
     else if ( dynamic_cast<mitk::PlanarCircle*>(roi->GetData()) )
     {
@@ -1171,42 +1235,44 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
       mitk::Point3D V2w  = planarFigure->GetWorldControlPoint(1); //radiusPoint
 
       double radius = V1w.EuclideanDistanceTo(V2w);
+      double bounds[6] = {V1w[0]-radius, V1w[0]+radius,
+                          V1w[1]-radius, V1w[1]+radius,
+                          V1w[2]-radius, V1w[2]+radius};
       radius *= radius;
+      std::vector< int > candidates = this->GetFiberIdsInBox(bounds);
+      std::vector< unsigned char > hit(candidates.size(), 0);
 
-      MITK_INFO << "Extracting with circle";
-      boost::progress_display disp(m_NumFibers);
-      for (int i=0; i<m_NumFibers; i++)
+      MITK_INFO << "Extracting with circle (" << candidates.size() << " candidate fibers)";
+      PrepareParallelCellAccess(m_FiberPolyData);
+#pragma omp parallel for
+      for (int c=0; c<(int)candidates.size(); c++)
       {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        FiberType fiber;
+        GetFiberPoints(m_FiberPolyData, candidates[c], fiber);
 
-        for (int j=0; j<numPoints-1; j++)
+        for (int j=0; j<(int)fiber.size()-1; j++)
         {
-          // Inputs
-          double p1[3] = {0,0,0};
-          points->GetPoint(j, p1);
-          double p2[3] = {0,0,0};
-          points->GetPoint(j+1, p2);
-
           // Outputs
           double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
           double x[3] = {0,0,0}; // The coordinate of the intersection
 
-          int iD = vtkPlane::IntersectWithLine(p1,p2,planeNormal.GetDataPointer(),V1w.GetDataPointer(),t,x);
+          int iD = vtkPlane::IntersectWithLine(fiber[j].data_block(),fiber[j+1].data_block(),planeNormal.GetDataPointer(),V1w.GetDataPointer(),t,x);
 
           if (iD!=0)
           {
             double dist = (x[0]-V1w[0])*(x[0]-V1w[0])+(x[1]-V1w[1])*(x[1]-V1w[1])+(x[2]-V1w[2])*(x[2]-V1w[2]);
             if( dist <= radius)
             {
-              result.push_back(i);
+              hit[c] = 1;
               break;
             }
           }
         }
       }
+
+      for (unsigned int c=0; c<candidates.size(); c++)
+        if (hit[c])
+          result.push_back(candidates[c]);
     }
     return result;
   }
@@ -1221,6 +1287,7 @@ void mitk::FiberBundle::UpdateFiberGeometry()
   cleaner->PointMergingOff();
   cleaner->Update();
   m_FiberPolyData = cleaner->GetOutput();
+  m_SpatialIndexValid = false;
 
   m_FiberLengths.clear();
   m_MeanFiberLength = 0;
@@ -1306,6 +1373,119 @@ void mitk::FiberBundle::UpdateFiberGeometry()
   m_UpdateTime2D.Modified();
 }
 
+int mitk::FiberBundle::GetSpatialIndexCell(double coordinate, int axis) const
+{
+  int cell = (int)std::floor((coordinate-m_SpatialIndexOrigin[axis])/m_SpatialIndexCellSize);
+  return std::min(std::max(cell, 0), m_SpatialIndexSize[axis]-1);
+}
+
+void mitk::FiberBundle::UpdateSpatialIndex()
+{
+  if (m_SpatialIndexValid)
+    return;
+
+  std::vector< int >().swap(m_SpatialIndexOffsets);
+  std::vector< int >().swap(m_SpatialIndexFiberIds);
+  m_SpatialIndexValid = true;
+  if (m_NumFibers<=0 || m_FiberPolyData->GetNumberOfPoints()<=0)
+    return;
+
+  // at most 32 cells along the largest extent keep the index small compared to the fibers themselves
+  double b[6];
+  m_FiberPolyData->GetBounds(b);
+  double maxExtent = std::max(b[1]-b[0], std::max(b[3]-b[2], b[5]-b[4]));
+  m_SpatialIndexCellSize = std::max(maxExtent/32, 1.0);
+  for (int d=0; d<3; d++)
+  {
+    m_SpatialIndexOrigin[d] = b[2*d];
+    m_SpatialIndexSize[d] = (int)((b[2*d+1]-b[2*d])/m_SpatialIndexCellSize) + 1;
+  }
+  int numCells = m_SpatialIndexSize[0]*m_SpatialIndexSize[1]*m_SpatialIndexSize[2];
+
+  // every segment is registered in all cells overlapped by its bounding box
+  std::vector< std::vector< int > > fiberCells(m_NumFibers);
+  PrepareParallelCellAccess(m_FiberPolyData);
+#pragma omp parallel for
+  for (int i=0; i<m_NumFibers; i++)
+  {
+    FiberType fiber;
+    GetFiberPoints(m_FiberPolyData, i, fiber);
+
+    std::vector< int >& cells = fiberCells[i];
+    for (unsigned int j=0; j<fiber.size(); j++)
+    {
+      const FiberPointType& p1 = fiber[j];
+      const FiberPointType& p2 = fiber[j+1<fiber.size() ? j+1 : j];
+
+      int lo[3];
+      int hi[3];
+      for (int d=0; d<3; d++)
+      {
+        lo[d] = GetSpatialIndexCell(std::min(p1[d], p2[d]), d);
+        hi[d] = GetSpatialIndexCell(std::max(p1[d], p2[d]), d);
+      }
+
+      for (int z=lo[2]; z<=hi[2]; z++)
+        for (int y=lo[1]; y<=hi[1]; y++)
+          for (int x=lo[0]; x<=hi[0]; x++)
+            cells.push_back(x + m_SpatialIndexSize[0]*(y + m_SpatialIndexSize[1]*z));
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+  }
+
+  // filling the cells in fiber order keeps the ids of every cell sorted
+  m_SpatialIndexOffsets.assign(numCells+1, 0);
+  for (int i=0; i<m_NumFibers; i++)
+    for (int c : fiberCells[i])
+      m_SpatialIndexOffsets[c+1]++;
+  for (int c=0; c<numCells; c++)
+    m_SpatialIndexOffsets[c+1] += m_SpatialIndexOffsets[c];
+
+  m_SpatialIndexFiberIds.resize(m_SpatialIndexOffsets[numCells]);
+  std::vector< int > next(m_SpatialIndexOffsets.begin(), m_SpatialIndexOffsets.end()-1);
+  for (int i=0; i<m_NumFibers; i++)
+  {
+    for (int c : fiberCells[i])
+      m_SpatialIndexFiberIds[next[c]++] = i;
+    std::vector< int >().swap(fiberCells[i]);
+  }
+}
+
+std::vector< int > mitk::FiberBundle::GetFiberIdsInBox(const double bounds[6])
+{
+  this->UpdateSpatialIndex();
+
+  std::vector< int > ids;
+  if (m_SpatialIndexOffsets.empty())
+    return ids;
+
+  int lo[3];
+  int hi[3];
+  for (int d=0; d<3; d++)
+  {
+    if (bounds[2*d+1]<m_SpatialIndexOrigin[d] || bounds[2*d]>m_SpatialIndexOrigin[d]+m_SpatialIndexSize[d]*m_SpatialIndexCellSize)
+      return ids;
+    lo[d] = GetSpatialIndexCell(bounds[2*d], d);
+    hi[d] = GetSpatialIndexCell(bounds[2*d+1], d);
+  }
+
+  for (int z=lo[2]; z<=hi[2]; z++)
+    for (int y=lo[1]; y<=hi[1]; y++)
+      for (int x=lo[0]; x<=hi[0]; x++)
+      {
+        int c = x + m_SpatialIndexSize[0]*(y + m_SpatialIndexSize[1]*z);
+        ids.insert(ids.end(), m_SpatialIndexFiberIds.begin()+m_SpatialIndexOffsets[c], m_SpatialIndexFiberIds.begin()+m_SpatialIndexOffsets[c+1]);
+      }
+
+  if (lo[0]!=hi[0] || lo[1]!=hi[1] || lo[2]!=hi[2])
+  {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  }
+  return ids;
+}
+
 float mitk::FiberBundle::GetFiberWeight(unsigned int fiber) const
 {
   return m_FiberWeights->GetValue(fiber);
@@ -2130,106 +2310,33 @@ void mitk::FiberBundle::Compress(float error)
 
 void mitk::FiberBundle::ResampleLinear(double pointDistance)
 {
+  MITK_INFO << "Resampling fibers (linear)";
+  std::vector< FiberType > newFibers(m_NumFibers);
+  PrepareParallelCellAccess(m_FiberPolyData);
+#pragma omp parallel for
+  for (int i=0; i<m_NumFibers; i++)
+  {
+    FiberType vertices;
+    GetFiberPoints(m_FiberPolyData, i, vertices);
+    newFibers[i] = ResampleFiberLinear(vertices, pointDistance);
+  }
+
   vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
   vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-  MITK_INFO << "Resampling fibers (linear)";
-  boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
   vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
   newFiberWeights->SetName("FIBER_WEIGHTS");
   newFiberWeights->SetNumberOfValues(m_NumFibers);
 
-#pragma omp parallel for
-  for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+  for (int i=0; i<m_NumFibers; i++)
   {
-
-    std::vector< vnl_vector_fixed< double, 3 > > vertices;
-    float weight = 1;
-
-#pragma omp critical
-    {
-      ++disp;
-      weight = m_FiberWeights->GetValue(i);
-      vtkCell* cell = m_FiberPolyData->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
-
-      for (int j=0; j<numPoints; j++)
-      {
-        double cand[3];
-        points->GetPoint(j, cand);
-        vnl_vector_fixed< double, 3 > candV;
-        candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
-        vertices.push_back(candV);
-      }
-    }
-
     vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-    vnl_vector_fixed< double, 3 > lastV = vertices.at(0);
-
-#pragma omp critical
+    for (unsigned int j=0; j<newFibers[i].size(); j++)
     {
-      vtkIdType id = vtkNewPoints->InsertNextPoint(lastV.data_block());
+      vtkIdType id = vtkNewPoints->InsertNextPoint(newFibers[i][j].data_block());
       container->GetPointIds()->InsertNextId(id);
     }
-    for (unsigned int j=1; j<vertices.size(); j++)
-    {
-      vnl_vector_fixed< double, 3 > vec = vertices.at(j) - lastV;
-      double new_dist = vec.magnitude();
-
-      if (new_dist >= pointDistance)
-      {
-        vnl_vector_fixed< double, 3 > newV = lastV;
-        if ( new_dist-pointDistance <= mitk::eps )
-        {
-          vec.normalize();
-          newV += vec * pointDistance;
-        }
-        else
-        {
-          // intersection between sphere (radius 'pointDistance', center 'lastV') and line (direction 'd' and point 'p')
-          vnl_vector_fixed< double, 3 > p = vertices.at(j-1);
-          vnl_vector_fixed< double, 3 > d = vertices.at(j) - p;
-
-          double a = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
-          double b = 2 * (d[0] * (p[0] - lastV[0]) + d[1] * (p[1] - lastV[1]) + d[2] * (p[2] - lastV[2]));
-          double c = (p[0] - lastV[0])*(p[0] - lastV[0]) + (p[1] - lastV[1])*(p[1] - lastV[1]) + (p[2] - lastV[2])*(p[2] - lastV[2]) - pointDistance*pointDistance;
-
-          double v1 =(-b + std::sqrt(b*b-4*a*c))/(2*a);
-          double v2 =(-b - std::sqrt(b*b-4*a*c))/(2*a);
-
-          if (v1>0)
-            newV = p + d * v1;
-          else if (v2>0)
-            newV = p + d * v2;
-          else
-            MITK_INFO << "ERROR1 - linear resampling";
-
-          j--;
-        }
-
-#pragma omp critical
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(newV.data_block());
-          container->GetPointIds()->InsertNextId(id);
-        }
-        lastV = newV;
-      }
-      else if (j==vertices.size()-1 && new_dist>0.0001)
-      {
-#pragma omp critical
-        {
-          vtkIdType id = vtkNewPoints->InsertNextPoint(vertices.at(j).data_block());
-          container->GetPointIds()->InsertNextId(id);
-        }
-      }
-    }
-
-#pragma omp critical
-    {
-      newFiberWeights->SetValue(vtkNewCells->GetNumberOfCells(), weight);
-      vtkNewCells->InsertNextCell(container);
-    }
+    newFiberWeights->SetValue(i, m_FiberWeights->GetValue(i));
+    vtkNewCells->InsertNextCell(container);
   }
 
   if (vtkNewCells->GetNumberOfCells()>0)
@@ -104,6 +104,14 @@ public:
     FiberBundle::Pointer           ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint, bool invert=false, bool bothEnds=true, float fraction=0.0);
     FiberBundle::Pointer           RemoveFibersOutside(ItkUcharImgType* mask, bool invert=false);
 
+    /**
+     * \brief Sorted ids of all fibers that may pass through the axis aligned box {xmin, xmax, ymin, ymax, zmin, zmax}.
+     *
+     * The candidates are looked up in a uniform grid over the fiber segments, which is built on the first query and
+     * cached until the fiber geometry changes. The result is a superset of the fibers actually intersecting the box.
+     */
+    std::vector<int>               GetFiberIdsInBox(const double bounds[6]);
+
     vtkSmartPointer<vtkPolyData>    GeneratePolyDataByIds( std::vector<long> ); // TODO: make protected
     void                            GenerateFiberIds(); // TODO: make protected
 
@@ -149,6 +157,10 @@ protected:
     // calculate geometry from fiber extent
     void UpdateFiberGeometry();
 
+    // build the cached fiber grid used by GetFiberIdsInBox if it is outdated
+    void UpdateSpatialIndex();
+    int GetSpatialIndexCell(double coordinate, int axis) const;
+
 private:
 
     // actual fiber container
@@ -170,6 +182,15 @@ private:
     itk::TimeStamp m_UpdateTime2D;
     itk::TimeStamp m_UpdateTime3D;
     mitk::BaseGeometry::Pointer m_ReferenceGeometry;
+
+    // uniform grid over the fiber bounds; the ids of the fibers passing through cell c are
+    // m_SpatialIndexFiberIds[m_SpatialIndexOffsets[c] ... m_SpatialIndexOffsets[c+1]-1] in ascending order
+    bool                m_SpatialIndexValid;
+    double              m_SpatialIndexOrigin[3];
+    double              m_SpatialIndexCellSize;
+    int                 m_SpatialIndexSize[3];
+    std::vector< int >  m_SpatialIndexOffsets;
+    std::vector< int >  m_SpatialIndexFiberIds;
 };
 
 } // namespace mitk
@@ -1,5 +1,38 @@
 #include <mitkTrackvis.h>
-#include <vtkTransformPolyDataFilter.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMatrix4x4.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Size of the blocks in which fibers are written
+    const std::size_t TrackVisBufferSize = 64*1024*1024;
+
+    // Number of bytes from the current position to the end of the file, -1 if it cannot be determined
+    long long GetRemainingFileSize(std::FILE* file)
+    {
+#ifdef _WIN32
+        const long long begin = _ftelli64(file);
+        if (begin < 0 || _fseeki64(file, 0, SEEK_END) != 0)
+            return -1;
+        const long long end = _ftelli64(file);
+        if (_fseeki64(file, begin, SEEK_SET) != 0)
+            return -1;
+#else
+        const long long begin = ftello(file);
+        if (begin < 0 || fseeko(file, 0, SEEK_END) != 0)
+            return -1;
+        const long long end = ftello(file);
+        if (fseeko(file, begin, SEEK_SET) != 0)
+            return -1;
+#endif
+        return end < begin ? -1 : end - begin;
+    }
+}
 
 TrackVisFiberReader::TrackVisFiberReader()  { m_Filename = ""; m_FilePointer = nullptr; }
 
@@ -92,97 +125,163 @@ short TrackVisFiberReader::open( string filename )
 short TrackVisFiberReader::append(const mitk::FiberBundle *fib)
 {
     vtkPolyData* poly = fib->GetFiberPolyData();
-    for (int i=0; i<fib->GetNumFibers(); i++)
-    {
-        vtkCell* cell = poly->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+    vtkPoints* points = poly->GetPoints();
+    vtkCellArray* lines = poly->GetLines();
 
-        unsigned int     numSaved, pos = 0;
-        //float* tmp = new float[3*maxSteps];
-        std::vector< float > tmp;
-        tmp.reserve(3*numPoints);
+    // The fibers are collected in a large buffer, which is written at once when it is full
+    std::vector< char > buffer;
+    buffer.reserve(TrackVisBufferSize);
 
-        numSaved = numPoints;
-        for(unsigned int i=0; i<numSaved ;i++)
+    vtkIdType numPoints;
+    vtkIdType* pointIds;
+    lines->InitTraversal();
+    while (lines->GetNextCell(numPoints, pointIds))
+    {
+        std::size_t fiberSize = 4 + 12*numPoints;
+        if (!buffer.empty() && buffer.size()+fiberSize > TrackVisBufferSize)
         {
-            double* p = points->GetPoint(i);
-
-            tmp[pos++] = p[0];
-            tmp[pos++] = p[1];
-            tmp[pos++] = p[2];
+            if ( fwrite(buffer.data(), 1, buffer.size(), m_FilePointer) != buffer.size() )
+            {
+                printf( "[ERROR] Problems saving the fiber!\n" );
+                return 1;
+            }
+            buffer.clear();
         }
 
-        // write the coordinates to the file
-        if ( fwrite((char*)&numSaved, 1, 4, m_FilePointer) != 4 )
-        {
-            printf( "[ERROR] Problems saving the fiber!\n" );
-            return 1;
-        }
-        if ( fwrite((char*)&(tmp.front()), 1, 4*pos, m_FilePointer) != 4*pos )
+        std::size_t pos = buffer.size();
+        buffer.resize(pos + fiberSize);
+
+        int numSaved = numPoints;
+        memcpy(&buffer[pos], &numSaved, 4);
+        pos += 4;
+
+        for (vtkIdType i=0; i<numPoints; i++)
         {
-            printf( "[ERROR] Problems saving the fiber!\n" );
-            return 1;
+            double* p = points->GetPoint(pointIds[i]);
+            float tmp[3] = { static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]) };
+            memcpy(&buffer[pos], tmp, 12);
+            pos += 12;
         }
     }
 
+    if ( !buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), m_FilePointer) != buffer.size() )
+    {
+        printf( "[ERROR] Problems saving the fiber!\n" );
+        return 1;
+    }
+
     return 0;
 }
 
-//// Read one fiber from the file
-//// ----------------------------
+//// Read all fibers from the file
+//// -----------------------------
 short TrackVisFiberReader::read( mitk::FiberBundle* fib )
 {
-    int numPoints;
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    // Read the fiber data with a single call into a buffer of the remaining file size
+    const long long remainingSize = GetRemainingFileSize(m_FilePointer);
+    if (remainingSize < 0)
+    {
+        MITK_ERROR << "TrackVis::read: Could not determine the size of " << m_Filename;
+        return -1;
+    }
+
+    std::vector< char > buffer(static_cast<std::size_t>(remainingSize));
+    const std::size_t size = fread(buffer.data(), 1, buffer.size(), m_FilePointer);
+    if (size != buffer.size())
+        MITK_ERROR << "TrackVis::read: Only " << size << " of " << buffer.size() << " bytes could be read.";
+
+    // Locate the fibers. Scalars and properties are skipped.
+    const std::size_t pointSize = 4 * (3 + std::max(0, static_cast<int>(m_Header.n_scalars)));
+    const std::size_t propertiesSize = 4 * std::max(0, static_cast<int>(m_Header.n_properties));
 
-    while (fread((char*)&numPoints, 1, 4, m_FilePointer)==4)
+    std::vector< std::size_t > fiberOffsets;
+    std::vector< vtkIdType > fiberPointOffsets(1, 0);
+    std::size_t pos = 0;
+    while (pos + 4 <= size)
     {
+        int numPoints;
+        memcpy(&numPoints, &buffer[pos], 4);
         if ( numPoints <= 0 )
         {
             printf( "[ERROR] Trying to read a fiber with %d points!\n", numPoints );
             return -1;
         }
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
 
-        float tmp[3];
-        for(int i=0; i<numPoints; i++)
+        std::size_t fiberSize = numPoints*pointSize + propertiesSize;
+        if (pos + 4 + fiberSize > size)
         {
-            if (fread((char*)tmp, 1, 12, m_FilePointer) == 0)
-                MITK_ERROR << "TrackVis::read: Error during read.";
+            MITK_ERROR << "TrackVis::read: Error during read.";
+            break;
+        }
+
+        fiberOffsets.push_back(pos + 4);
+        fiberPointOffsets.push_back(fiberPointOffsets.back() + numPoints);
+        pos += 4 + fiberSize;
+    }
 
-            vtkIdType id = vtkNewPoints->InsertNextPoint(tmp);
-            container->GetPointIds()->InsertNextId(id);
+    MITK_INFO << "Coordinate convention: " << m_Header.voxel_order;
+
+    // Convert the coordinates to LPS while decoding them
+    float sign[3] = { 1, 1, 1 };
+    if (m_Header.voxel_order[0]=='R')
+        sign[0] = -1;
+    if (m_Header.voxel_order[1]=='A')
+        sign[1] = -1;
+    if (m_Header.voxel_order[2]=='I')
+        sign[2] = -1;
+
+    // The points and cells are decoded directly into preallocated arrays, each fiber independently of the others
+    const int numFibers = fiberOffsets.size();
+    const vtkIdType totalNumPoints = fiberPointOffsets.back();
+
+    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkNewPoints->SetDataTypeToFloat();
+    vtkNewPoints->SetNumberOfPoints(totalNumPoints);
+    float* pointData = static_cast<vtkFloatArray*>(vtkNewPoints->GetData())->GetPointer(0);
+
+    vtkSmartPointer<vtkIdTypeArray> cellData = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellData->SetNumberOfValues(numFibers + totalNumPoints);
+    vtkIdType* cellIds = cellData->GetPointer(0);
+
+#pragma omp parallel for
+    for (int i=0; i<numFibers; i++)
+    {
+        const char* fiberData = &buffer[fiberOffsets[i]];
+        const vtkIdType firstPoint = fiberPointOffsets[i];
+        const vtkIdType numPoints = fiberPointOffsets[i+1] - firstPoint;
+
+        vtkIdType* ids = cellIds + firstPoint + i;
+        *ids++ = numPoints;
+
+        for (vtkIdType j=0; j<numPoints; j++)
+        {
+            float tmp[3];
+            memcpy(tmp, fiberData + j*pointSize, 12);
+
+            float* p = pointData + 3*(firstPoint + j);
+            p[0] = sign[0]*tmp[0];
+            p[1] = sign[1]*tmp[1];
+            p[2] = sign[2]*tmp[2];
+
+            ids[j] = firstPoint + j;
         }
-        vtkNewCells->InsertNextCell(container);
     }
 
+    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    vtkNewCells->SetCells(numFibers, cellData);
+
     vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
     fiberPolyData->SetPoints(vtkNewPoints);
     fiberPolyData->SetLines(vtkNewCells);
-
-    MITK_INFO << "Coordinate convention: " << m_Header.voxel_order;
+    fib->SetFiberPolyData(fiberPolyData);
 
     mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
     vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
     matrix->Identity();
-
-    if (m_Header.voxel_order[0]=='R')
-        matrix->SetElement(0,0,-matrix->GetElement(0,0));
-    if (m_Header.voxel_order[1]=='A')
-        matrix->SetElement(1,1,-matrix->GetElement(1,1));
-    if (m_Header.voxel_order[2]=='I')
-        matrix->SetElement(2,2,-matrix->GetElement(2,2));
-
+    for (int i=0; i<3; i++)
+        matrix->SetElement(i,i,sign[i]);
     geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
 
-    vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-    transformFilter->SetInputData(fiberPolyData);
-    transformFilter->SetTransform(geometry->GetVtkTransform());
-    transformFilter->Update();
-    fib->SetFiberPolyData(transformFilter->GetOutput());
-
     mitk::Point3D origin;
     origin[0]=m_Header.origin[0];
     origin[1]=m_Header.origin[1];
@@ -201,7 +300,7 @@ short TrackVisFiberReader::read( mitk::FiberBundle* fib )
 
     fib->SetReferenceGeometry(dynamic_cast<mitk::BaseGeometry*>(geometry.GetPointer()));
 
-    return numPoints;
+    return 1;
 }
 
 
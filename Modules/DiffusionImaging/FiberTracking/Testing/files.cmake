@@ -1,6 +1,7 @@
 SET(MODULE_CUSTOM_TESTS
   mitkFiberBundleReaderWriterTest.cpp
   mitkGibbsTrackingTest.cpp
+  mitkGibbsTrackingDomainsTest.cpp
   mitkStreamlineTractographyTest.cpp
   mitkPeakExtractionTest.cpp
   mitkLocalFiberPlausibilityTest.cpp
@@ -10,6 +11,8 @@ SET(MODULE_CUSTOM_TESTS
   mitkFiberfoxSignalGenerationTest.cpp
   mitkMachineLearningTrackingTest.cpp
   mitkFiberProcessingTest.cpp
+  mitkTractDensityImageFilterTest.cpp
+  mitkStreamlineTrackingScalingTest.cpp
 )
 
 
@@ -23,11 +23,23 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkTestFixture.h"
 
+#include <itkTimeProbe.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyLine.h>
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+
 class mitkFiberBundleReaderWriterTestSuite : public mitk::TestFixture
 {
 
   CPPUNIT_TEST_SUITE(mitkFiberBundleReaderWriterTestSuite);
   MITK_TEST(Equal_SaveLoad_ReturnsTrue);
+  MITK_TEST(Equal_SaveLoadSyntheticTrk_ReturnsTrue);
+  MITK_TEST(Equal_LoadSyntheticTck_ReturnsTrue);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -36,6 +48,54 @@ private:
   mitk::FiberBundle::Pointer fib1;
   mitk::FiberBundle::Pointer fib2;
 
+  /** Creates helical fibers with the given number of points */
+  mitk::FiberBundle::Pointer CreateSyntheticTractogram(int numFibers, int numPoints)
+  {
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    for (int i=0; i<numFibers; i++)
+    {
+      vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+      for (int j=0; j<numPoints; j++)
+      {
+        double p[3] = { 10*std::cos(0.1*j + i) + 0.01*i, 10*std::sin(0.1*j + i), 0.5*j - 0.001*i };
+        container->GetPointIds()->InsertNextId(points->InsertNextPoint(p));
+      }
+      lines->InsertNextCell(container);
+    }
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    return mitk::FiberBundle::New(polyData);
+  }
+
+  /** Writes the fibers in MRtrix' tck format, which stores them in RAS space */
+  void WriteSyntheticTck(const std::string& filename, mitk::FiberBundle* fib)
+  {
+    std::string header = "mrtrix tracks\ndatatype: Float32LE\ncount: " + std::to_string(fib->GetNumFibers()) + "\nfile: . 128\nEND\n";
+    header.resize(128, '\0');
+
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    file.write(header.data(), header.size());
+
+    vtkPolyData* polyData = fib->GetFiberPolyData();
+    for (int i=0; i<fib->GetNumFibers(); i++)
+    {
+      vtkCell* cell = polyData->GetCell(i);
+      for (int j=0; j<cell->GetNumberOfPoints(); j++)
+      {
+        double* p = cell->GetPoints()->GetPoint(j);
+        float tmp[3] = { static_cast<float>(-p[0]), static_cast<float>(-p[1]), static_cast<float>(p[2]) };
+        file.write(reinterpret_cast<char*>(tmp), 12);
+      }
+      float delimiter[3] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN() };
+      file.write(reinterpret_cast<char*>(delimiter), 12);
+    }
+    float end[3] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+    file.write(reinterpret_cast<char*>(end), 12);
+  }
+
 public:
 
   void setUp() override
@@ -66,6 +126,45 @@ public:
     //MITK_ASSERT_EQUAL(fib1, fib2, "A saved and re-loaded file should be equal");
   }
 
+  void Equal_SaveLoadSyntheticTrk_ReturnsTrue()
+  {
+    mitk::FiberBundle::Pointer synthetic = CreateSyntheticTractogram(50000, 40);
+    std::string filename = std::string(MITK_TEST_OUTPUT_DIR)+"/writerTest.trk";
+
+    itk::TimeProbe writeProbe;
+    writeProbe.Start();
+    mitk::IOUtil::Save(synthetic.GetPointer(), filename);
+    writeProbe.Stop();
+
+    itk::TimeProbe readProbe;
+    readProbe.Start();
+    std::vector<mitk::BaseData::Pointer> baseData = mitk::IOUtil::Load(filename);
+    readProbe.Stop();
+
+    MITK_INFO << "TrackVis with " << synthetic->GetNumFibers() << " fibers: writing took " << writeProbe.GetTotal()
+              << "s, loading took " << readProbe.GetTotal() << "s";
+
+    fib2 = dynamic_cast<mitk::FiberBundle*>(baseData[0].GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Should be equal", synthetic->Equals(fib2, 0.0001));
+  }
+
+  void Equal_LoadSyntheticTck_ReturnsTrue()
+  {
+    mitk::FiberBundle::Pointer synthetic = CreateSyntheticTractogram(50000, 40);
+    std::string filename = std::string(MITK_TEST_OUTPUT_DIR)+"/readerTest.tck";
+    WriteSyntheticTck(filename, synthetic);
+
+    itk::TimeProbe readProbe;
+    readProbe.Start();
+    std::vector<mitk::BaseData::Pointer> baseData = mitk::IOUtil::Load(filename);
+    readProbe.Stop();
+
+    MITK_INFO << "TCK with " << synthetic->GetNumFibers() << " fibers: loading took " << readProbe.GetTotal() << "s";
+
+    fib2 = dynamic_cast<mitk::FiberBundle*>(baseData[0].GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Should be equal", synthetic->Equals(fib2, 0.0001));
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkFiberBundleReaderWriter)
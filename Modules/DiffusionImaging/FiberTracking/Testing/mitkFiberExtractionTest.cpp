@@ -108,6 +108,14 @@ int mitkFiberExtractionTest(int argc, char* argv[])
 
         testFibs = dynamic_cast<mitk::FiberBundle*>(mitk::IOUtil::Load(argv[10]).front().GetPointer());
         MITK_TEST_CONDITION_REQUIRED(ending->Equals(testFibs),"check ending in mask extraction");
+
+        // test the spatial index used by the extraction methods
+        double bounds[6];
+        groundTruthFibs->GetFiberPolyData()->GetBounds(bounds);
+        MITK_TEST_CONDITION_REQUIRED(groundTruthFibs->GetFiberIdsInBox(bounds).size()==(unsigned int)groundTruthFibs->GetNumFibers(),"check spatial index query enclosing all fibers");
+
+        double outside[6] = {bounds[1]+10, bounds[1]+20, bounds[3]+10, bounds[3]+20, bounds[5]+10, bounds[5]+20};
+        MITK_TEST_CONDITION_REQUIRED(groundTruthFibs->GetFiberIdsInBox(outside).empty(),"check spatial index query outside of all fibers");
     }
     catch(...) {
         return EXIT_FAILURE;
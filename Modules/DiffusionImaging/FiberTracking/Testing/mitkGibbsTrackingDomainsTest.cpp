@@ -0,0 +1,151 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkQBallImage.h>
+#include <itkGibbsTrackingFilter.h>
+#include <itkOrientationDistributionFunction.h>
+#include <omp.h>
+#include "mitkTestFixture.h"
+
+#include <cmath>
+
+class mitkGibbsTrackingDomainsTestSuite : public mitk::TestFixture
+{
+
+  CPPUNIT_TEST_SUITE(mitkGibbsTrackingDomainsTestSuite);
+  MITK_TEST(Track_FixedSeedDomains_IndependentOfNumberOfThreads);
+  MITK_TEST(Track_Domains_StatisticallyEqualToSerial);
+  CPPUNIT_TEST_SUITE_END();
+
+  typedef itk::Vector<float, QBALL_ODFSIZE> OdfVectorType;
+  typedef itk::Image<OdfVectorType,3> OdfVectorImgType;
+  typedef itk::Image<float,3> MaskImgType;
+  typedef itk::GibbsTrackingFilter<OdfVectorImgType> GibbsTrackingFilterType;
+
+private:
+
+  /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+  OdfVectorImgType::Pointer m_OdfImage;
+  MaskImgType::Pointer m_MaskImage;
+  int m_NumberOfThreads;
+
+  /** Small image with ODFs along x everywhere, so the fibers run through the whole image along x */
+  void CreateSyntheticImages()
+  {
+    OdfVectorImgType::SizeType imageSize;
+    imageSize[0] = 48; imageSize[1] = 8; imageSize[2] = 8;
+    OdfVectorImgType::RegionType region(imageSize);
+
+    OdfVectorType odf;
+    for (int i=0; i<QBALL_ODFSIZE; i++)
+    {
+      double x = itk::OrientationDistributionFunction<float, QBALL_ODFSIZE>::GetDirection(i)[0];
+      odf[i] = std::exp(8*(x*x-1));
+    }
+
+    m_OdfImage = OdfVectorImgType::New();
+    m_OdfImage->SetRegions(region);
+    m_OdfImage->Allocate();
+    m_OdfImage->FillBuffer(odf);
+
+    m_MaskImage = MaskImgType::New();
+    m_MaskImage->SetRegions(region);
+    m_MaskImage->Allocate();
+    m_MaskImage->FillBuffer(1);
+  }
+
+  mitk::FiberBundle::Pointer Track(int seed, int numDomains, int numThreads)
+  {
+    omp_set_num_threads(numThreads);
+
+    GibbsTrackingFilterType::Pointer gibbsTracker = GibbsTrackingFilterType::New();
+    gibbsTracker->SetQBallImage(m_OdfImage);
+    gibbsTracker->SetMaskImage(m_MaskImage);
+    gibbsTracker->SetIterations(2e6);
+    gibbsTracker->SetMinFiberLength(5);
+    gibbsTracker->SetRandomSeed(seed);
+    gibbsTracker->SetNumberOfDomains(numDomains);
+    gibbsTracker->Update();
+
+    return mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_NumberOfThreads = omp_get_max_threads();
+    CreateSyntheticImages();
+  }
+
+  void tearDown() override
+  {
+    omp_set_num_threads(m_NumberOfThreads);
+    m_OdfImage = nullptr;
+    m_MaskImage = nullptr;
+  }
+
+  /** With a fixed seed the result only depends on the number of domains */
+  void Track_FixedSeedDomains_IndependentOfNumberOfThreads()
+  {
+    mitk::FiberBundle::Pointer singleThreaded = Track(1, 4, 1);
+    CPPUNIT_ASSERT_MESSAGE("Should reconstruct fibers", singleThreaded->GetNumFibers()>0);
+
+    mitk::FiberBundle::Pointer multiThreaded = Track(1, 4, 4);
+    CPPUNIT_ASSERT_MESSAGE("Should not depend on the number of threads", singleThreaded->Equals(multiThreaded));
+
+    mitk::FiberBundle::Pointer repeated = Track(1, 4, 4);
+    CPPUNIT_ASSERT_MESSAGE("Should be reproducible", multiThreaded->Equals(repeated));
+  }
+
+  /** The domains sample the same distribution as the serial sampler, so the tractograms of several seeds have to agree on average */
+  void Track_Domains_StatisticallyEqualToSerial()
+  {
+    const int numSeeds = 3;
+    double serialNumFibers = 0;
+    double serialMeanLength = 0;
+    double serialMedianLength = 0;
+    double parallelNumFibers = 0;
+    double parallelMeanLength = 0;
+    double parallelMedianLength = 0;
+    for (int seed=1; seed<=numSeeds; seed++)
+    {
+      mitk::FiberBundle::Pointer serial = Track(seed, 1, 1);
+      serialNumFibers += serial->GetNumFibers();
+      serialMeanLength += serial->GetMeanFiberLength();
+      serialMedianLength += serial->GetMedianFiberLength();
+
+      mitk::FiberBundle::Pointer parallel = Track(seed, 4, 4);
+      parallelNumFibers += parallel->GetNumFibers();
+      parallelMeanLength += parallel->GetMeanFiberLength();
+      parallelMedianLength += parallel->GetMedianFiberLength();
+    }
+
+    MITK_INFO << "Serial: " << serialNumFibers/numSeeds << " fibers, mean length " << serialMeanLength/numSeeds << ", median length " << serialMedianLength/numSeeds;
+    MITK_INFO << "Domains: " << parallelNumFibers/numSeeds << " fibers, mean length " << parallelMeanLength/numSeeds << ", median length " << parallelMedianLength/numSeeds;
+
+    CPPUNIT_ASSERT_MESSAGE("Serial tracking should reconstruct fibers", serialNumFibers>0);
+    CPPUNIT_ASSERT_MESSAGE("Parallel tracking should reconstruct fibers", parallelNumFibers>0);
+    CPPUNIT_ASSERT_MESSAGE("Number of fibers should match", std::fabs(parallelNumFibers-serialNumFibers) <= 0.25*serialNumFibers);
+    CPPUNIT_ASSERT_MESSAGE("Mean fiber length should match", std::fabs(parallelMeanLength-serialMeanLength) <= 0.25*serialMeanLength);
+    CPPUNIT_ASSERT_MESSAGE("Median fiber length should match", std::fabs(parallelMedianLength-serialMedianLength) <= 0.25*serialMedianLength);
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkGibbsTrackingDomains)
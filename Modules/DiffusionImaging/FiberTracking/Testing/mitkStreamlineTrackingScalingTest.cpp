@@ -0,0 +1,173 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <itkStreamlineTrackingFilter.h>
+#include <Algorithms/TrackingHandlers/mitkTrackingHandlerPeaks.h>
+#include <omp.h>
+#include "mitkTestFixture.h"
+
+#include <itkTimeProbe.h>
+
+#include <cmath>
+#include <cstring>
+
+class mitkStreamlineTrackingScalingTestSuite : public mitk::TestFixture
+{
+
+  CPPUNIT_TEST_SUITE(mitkStreamlineTrackingScalingTestSuite);
+  MITK_TEST(Equal_Tractogram_ReturnsTrue);
+  MITK_TEST(Equal_ProbabilityMap_ReturnsTrue);
+  CPPUNIT_TEST_SUITE_END();
+
+  typedef mitk::TrackingHandlerPeaks::PeakImgType PeakImgType;
+  typedef itk::StreamlineTrackingFilter::ItkDoubleImgType ItkDoubleImgType;
+
+private:
+
+  /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+  PeakImgType::Pointer m_PeakImage;
+  int m_NumberOfThreads;
+
+  /** One smoothly bending peak per voxel, so that the streamlines have very different lengths */
+  PeakImgType::Pointer CreateSyntheticPeakImage(int size)
+  {
+    PeakImgType::SizeType imageSize;
+    imageSize[0] = size; imageSize[1] = size; imageSize[2] = size; imageSize[3] = 3;
+    PeakImgType::RegionType region(imageSize);
+
+    PeakImgType::Pointer image = PeakImgType::New();
+    image->SetRegions(region);
+    image->Allocate();
+
+    for (int x=0; x<size; x++)
+      for (int y=0; y<size; y++)
+        for (int z=0; z<size; z++)
+        {
+          vnl_vector_fixed<float,3> dir;
+          dir[0] = 1;
+          dir[1] = 0.6*std::sin(0.3*z);
+          dir[2] = 0.6*std::cos(0.2*x + 0.1*y);
+          dir.normalize();
+
+          PeakImgType::IndexType index;
+          index[0] = x; index[1] = y; index[2] = z;
+          for (int i=0; i<3; i++)
+          {
+            index[3] = i;
+            image->SetPixel(index, dir[i]);
+          }
+        }
+    return image;
+  }
+
+  itk::StreamlineTrackingFilter::Pointer Track(bool probabilityMap, int numThreads, double& seconds)
+  {
+    omp_set_num_threads(numThreads);
+
+    mitk::TrackingHandlerPeaks handler;
+    handler.SetPeakImage(m_PeakImage);
+    handler.SetPeakThreshold(0.1);
+
+    itk::StreamlineTrackingFilter::Pointer tracker = itk::StreamlineTrackingFilter::New();
+    tracker->SetRandom(false);
+    tracker->SetNumberOfSamples(0);
+    tracker->SetAngularThreshold(-1);
+    tracker->SetSeedsPerVoxel(1);
+    tracker->SetStepSize(0.5);
+    tracker->SetMinTractLength(5);
+    tracker->SetMaxNumTracts(-1);
+    tracker->SetTrackingHandler(&handler);
+    tracker->SetUseOutputProbabilityMap(probabilityMap);
+
+    itk::TimeProbe probe;
+    probe.Start();
+    tracker->Update();
+    probe.Stop();
+    seconds = probe.GetTotal();
+
+    return tracker;
+  }
+
+  bool IsIdentical(itk::StreamlineTrackingFilter* tracker1, itk::StreamlineTrackingFilter* tracker2, bool probabilityMap)
+  {
+    if (probabilityMap)
+    {
+      ItkDoubleImgType::Pointer image1 = tracker1->GetOutputProbabilityMap();
+      ItkDoubleImgType::Pointer image2 = tracker2->GetOutputProbabilityMap();
+      return std::memcmp(image1->GetBufferPointer(), image2->GetBufferPointer(), image1->GetLargestPossibleRegion().GetNumberOfPixels()*sizeof(double))==0;
+    }
+
+    vtkSmartPointer<vtkPolyData> poly1 = tracker1->GetFiberPolyData();
+    vtkSmartPointer<vtkPolyData> poly2 = tracker2->GetFiberPolyData();
+    if (poly1->GetNumberOfCells()!=poly2->GetNumberOfCells() || poly1->GetNumberOfPoints()!=poly2->GetNumberOfPoints())
+      return false;
+    for (vtkIdType i=0; i<poly1->GetNumberOfPoints(); i++)
+    {
+      double* p1 = poly1->GetPoint(i);
+      double* p2 = poly2->GetPoint(i);
+      if (p1[0]!=p2[0] || p1[1]!=p2[1] || p1[2]!=p2[2])
+        return false;
+    }
+    return true;
+  }
+
+  /** Logs the timings for up to 32 threads. The result has to be the same for every number of threads. */
+  void CheckTracking(bool probabilityMap)
+  {
+    double singleThreadedSeconds = 0;
+    itk::StreamlineTrackingFilter::Pointer singleThreaded = Track(probabilityMap, 1, singleThreadedSeconds);
+    MITK_INFO << "Streamline tracking with 1 thread took " << singleThreadedSeconds << "s";
+    if (!probabilityMap)
+      CPPUNIT_ASSERT_MESSAGE("Should reconstruct fibers", singleThreaded->GetFiberPolyData()->GetNumberOfCells()>0);
+
+    for (int numThreads=2; numThreads<=32; numThreads*=2)
+    {
+      double seconds = 0;
+      itk::StreamlineTrackingFilter::Pointer multiThreaded = Track(probabilityMap, numThreads, seconds);
+      MITK_INFO << "Streamline tracking with " << numThreads << " threads took " << seconds << "s (speedup " << singleThreadedSeconds/seconds << ")";
+      CPPUNIT_ASSERT_MESSAGE("Should not depend on the number of threads", IsIdentical(singleThreaded, multiThreaded, probabilityMap));
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_NumberOfThreads = omp_get_max_threads();
+    m_PeakImage = CreateSyntheticPeakImage(48);
+  }
+
+  void tearDown() override
+  {
+    omp_set_num_threads(m_NumberOfThreads);
+    m_PeakImage = nullptr;
+  }
+
+  void Equal_Tractogram_ReturnsTrue()
+  {
+    CheckTracking(false);
+  }
+
+  void Equal_ProbabilityMap_ReturnsTrue()
+  {
+    CheckTracking(true);
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkStreamlineTrackingScaling)
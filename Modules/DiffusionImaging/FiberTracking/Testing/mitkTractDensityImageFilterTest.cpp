@@ -0,0 +1,253 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <itkTractDensityImageFilter.h>
+#include <omp.h>
+#include "mitkTestFixture.h"
+
+#include <itkTimeProbe.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyLine.h>
+
+#include <cmath>
+#include <cstring>
+
+class mitkTractDensityImageFilterTestSuite : public mitk::TestFixture
+{
+
+  CPPUNIT_TEST_SUITE(mitkTractDensityImageFilterTestSuite);
+  MITK_TEST(Equal_WeightedDensity_ReturnsTrue);
+  MITK_TEST(Equal_TrilinearDensity_ReturnsTrue);
+  MITK_TEST(Equal_BinaryEnvelope_ReturnsTrue);
+  CPPUNIT_TEST_SUITE_END();
+
+  typedef itk::Image<float, 3> FloatImageType;
+  typedef itk::TractDensityImageFilter< FloatImageType > TdiFilterType;
+
+private:
+
+  /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+  mitk::FiberBundle::Pointer m_Fibers;
+  int m_NumberOfThreads;
+
+  /** Helices with irregular fiber weights, so the summation order matters for the weighted density */
+  mitk::FiberBundle::Pointer CreateSyntheticTractogram(int numFibers, int numPoints)
+  {
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    for (int i=0; i<numFibers; i++)
+    {
+      vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+      for (int j=0; j<numPoints; j++)
+      {
+        double p[3] = { 10*std::cos(0.1*j + i) + 0.001*i, 10*std::sin(0.1*j + i), 0.5*j - 0.0001*i };
+        container->GetPointIds()->InsertNextId(points->InsertNextPoint(p));
+      }
+      lines->InsertNextCell(container);
+    }
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New(polyData);
+    for (int i=0; i<numFibers; i++)
+      fib->SetFiberWeight(i, 0.3f + 0.37f*(i%11));
+    return fib;
+  }
+
+  FloatImageType::Pointer ComputeDensity(bool trilinear, bool binary, int numThreads, double& seconds)
+  {
+    omp_set_num_threads(numThreads);
+
+    TdiFilterType::Pointer filter = TdiFilterType::New();
+    filter->SetFiberBundle(m_Fibers);
+    filter->SetDoFiberResampling(false);
+    filter->SetOutputAbsoluteValues(true);
+    filter->SetUseTrilinearInterpolation(trilinear);
+    filter->SetBinaryOutput(binary);
+    filter->SetUpsamplingFactor(4);
+
+    itk::TimeProbe probe;
+    probe.Start();
+    filter->Update();
+    probe.Stop();
+    seconds = probe.GetTotal();
+
+    return filter->GetOutput();
+  }
+
+  /** The single threaded rasterization the filter used before, without normalization */
+  FloatImageType::Pointer ComputeReferenceDensity(const FloatImageType* geometry, bool trilinear, bool binary)
+  {
+    FloatImageType::Pointer outImage = FloatImageType::New();
+    outImage->CopyInformation(geometry);
+    outImage->SetRegions(geometry->GetLargestPossibleRegion());
+    outImage->Allocate();
+    outImage->FillBuffer(0.0);
+
+    FloatImageType::SizeType size = outImage->GetLargestPossibleRegion().GetSize();
+    int w = size[0];
+    int h = size[1];
+    int d = size[2];
+    float* outImageBufferPointer = outImage->GetBufferPointer();
+
+    vtkSmartPointer<vtkPolyData> fiberPolyData = m_Fibers->GetFiberPolyData();
+    for( int i=0; i<m_Fibers->GetNumFibers(); i++ )
+    {
+      vtkCell* cell = fiberPolyData->GetCell(i);
+      int numPoints = cell->GetNumberOfPoints();
+      vtkPoints* points = cell->GetPoints();
+
+      float weight = m_Fibers->GetFiberWeight(i);
+
+      for( int j=0; j<numPoints; j++)
+      {
+        double* p = points->GetPoint(j);
+        itk::Point<float, 3> vertex;
+        vertex[0] = p[0]; vertex[1] = p[1]; vertex[2] = p[2];
+        itk::Index<3> index;
+        itk::ContinuousIndex<float, 3> contIndex;
+        outImage->TransformPhysicalPointToIndex(vertex, index);
+        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+
+        if (!trilinear && outImage->GetLargestPossibleRegion().IsInside(index))
+        {
+          if (binary)
+            outImage->SetPixel(index, 1);
+          else
+            outImage->SetPixel(index, outImage->GetPixel(index)+weight);
+          continue;
+        }
+
+        float frac_x = contIndex[0] - index[0];
+        float frac_y = contIndex[1] - index[1];
+        float frac_z = contIndex[2] - index[2];
+
+        if (frac_x<0)
+        {
+          index[0] -= 1;
+          frac_x += 1;
+        }
+        if (frac_y<0)
+        {
+          index[1] -= 1;
+          frac_y += 1;
+        }
+        if (frac_z<0)
+        {
+          index[2] -= 1;
+          frac_z += 1;
+        }
+
+        frac_x = 1-frac_x;
+        frac_y = 1-frac_y;
+        frac_z = 1-frac_z;
+
+        if (index[0] < 0 || index[0] >= w-1)
+          continue;
+        if (index[1] < 0 || index[1] >= h-1)
+          continue;
+        if (index[2] < 0 || index[2] >= d-1)
+          continue;
+
+        if (binary)
+        {
+          outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] = 1;
+          outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] = 1;
+          outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] = 1;
+          outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] = 1;
+          outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] = 1;
+          outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] = 1;
+          outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] = 1;
+          outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] = 1;
+        }
+        else
+        {
+          outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] += (  frac_x)*(  frac_y)*(  frac_z);
+          outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] += (  frac_x)*(1-frac_y)*(  frac_z);
+          outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] += (  frac_x)*(  frac_y)*(1-frac_z);
+          outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] += (  frac_x)*(1-frac_y)*(1-frac_z);
+          outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] += (1-frac_x)*(  frac_y)*(  frac_z);
+          outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] += (1-frac_x)*(  frac_y)*(1-frac_z);
+          outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] += (1-frac_x)*(1-frac_y)*(  frac_z);
+          outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] += (1-frac_x)*(1-frac_y)*(1-frac_z);
+        }
+      }
+    }
+    return outImage;
+  }
+
+  bool IsIdentical(const FloatImageType* image1, const FloatImageType* image2)
+  {
+    if (image1->GetLargestPossibleRegion()!=image2->GetLargestPossibleRegion())
+      return false;
+    return std::memcmp(image1->GetBufferPointer(), image2->GetBufferPointer(), image1->GetLargestPossibleRegion().GetNumberOfPixels()*sizeof(float))==0;
+  }
+
+  /** Compares against the serial reference and logs the timings for up to 32 threads */
+  void CheckDensity(bool trilinear, bool binary)
+  {
+    double singleThreadedSeconds = 0;
+    FloatImageType::Pointer singleThreaded = ComputeDensity(trilinear, binary, 1, singleThreadedSeconds);
+    FloatImageType::Pointer reference = ComputeReferenceDensity(singleThreaded, trilinear, binary);
+    CPPUNIT_ASSERT_MESSAGE("Should be identical to the serial reference", IsIdentical(reference, singleThreaded));
+
+    MITK_INFO << "Tract density of " << m_Fibers->GetNumFibers() << " fibers with 1 thread took " << singleThreadedSeconds << "s";
+    for (int numThreads=2; numThreads<=32; numThreads*=2)
+    {
+      double seconds = 0;
+      FloatImageType::Pointer multiThreaded = ComputeDensity(trilinear, binary, numThreads, seconds);
+      MITK_INFO << "Tract density with " << numThreads << " threads took " << seconds << "s (speedup " << singleThreadedSeconds/seconds << ")";
+      CPPUNIT_ASSERT_MESSAGE("Should not depend on the number of threads", IsIdentical(singleThreaded, multiThreaded));
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_NumberOfThreads = omp_get_max_threads();
+    m_Fibers = CreateSyntheticTractogram(20000, 100);
+  }
+
+  void tearDown() override
+  {
+    omp_set_num_threads(m_NumberOfThreads);
+    m_Fibers = nullptr;
+  }
+
+  void Equal_WeightedDensity_ReturnsTrue()
+  {
+    CheckDensity(false, false);
+  }
+
+  void Equal_TrilinearDensity_ReturnsTrue()
+  {
+    CheckDensity(true, false);
+  }
+
+  void Equal_BinaryEnvelope_ReturnsTrue()
+  {
+    CheckDensity(false, true);
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkTractDensityImageFilter)
@@ -100,6 +100,8 @@ int main(int argc, char* argv[])
     parser.addArgument("shConvention", "s", mitkCommandLineParser::String, "SH coefficient:", "sh coefficient convention (FSL, MRtrix)", string("FSL"), true);
     parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output fiber bundle (.fib)", us::Any(), false);
     parser.addArgument("noFlip", "f", mitkCommandLineParser::Bool, "No flip:", "do not flip input image to match MITK coordinate convention");
+    parser.addArgument("domains", "d", mitkCommandLineParser::Int, "Domains:", "number of image slabs that are sampled in parallel (1: serial tracking)", 1, true);
+    parser.addArgument("seed", "r", mitkCommandLineParser::Int, "Random seed:", "seed of the random generator (-1: random seeding)", -1, true);
 
     map<string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -113,6 +115,14 @@ int main(int argc, char* argv[])
     if (parsedArgs.count("noFlip"))
         noFlip = us::any_cast<bool>(parsedArgs["noFlip"]);
 
+    int numDomains = 1;
+    if (parsedArgs.count("domains"))
+        numDomains = us::any_cast<int>(parsedArgs["domains"]);
+
+    int randomSeed = -1;
+    if (parsedArgs.count("seed"))
+        randomSeed = us::any_cast<int>(parsedArgs["seed"]);
+
     try
     {
         // instantiate gibbs tracker
@@ -213,6 +223,8 @@ int main(int argc, char* argv[])
 
         gibbsTracker->SetDuplicateImage(false);
         gibbsTracker->SetLoadParameterFile( paramFileName );
+        gibbsTracker->SetNumberOfDomains( numDomains );
+        gibbsTracker->SetRandomSeed( randomSeed );
 //        gibbsTracker->SetLutPath( "" );
         gibbsTracker->Update();
 
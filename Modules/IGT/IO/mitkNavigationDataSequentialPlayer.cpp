@@ -85,7 +85,7 @@ void mitk::NavigationDataSequentialPlayer::GenerateData()
       mitk::NavigationData* output = this->GetOutput(index);
       if( !output ) { mitkThrowException(mitk::IGTException) << "Output of index "<<index<<" is null."; }
 
-      output->Graft(m_NavigationDataSetIterator->at(index));
+      m_NavigationDataSet->CopyNavigationData(m_NavigationDataSetIterator.GetIndex(), index, output);
     }
   }
 }
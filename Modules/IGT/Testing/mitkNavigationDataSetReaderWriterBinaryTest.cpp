@@ -0,0 +1,177 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkMappedNavigationDataSet.h>
+#include <mitkNavigationDataSequentialPlayer.h>
+#include <mitkIOUtil.h>
+#include <mitkIGTIOException.h>
+
+#include <cstdio>
+#include <fstream>
+
+class mitkNavigationDataSetReaderWriterBinaryTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkNavigationDataSetReaderWriterBinaryTestSuite);
+  MITK_TEST(TestReadWrite);
+  MITK_TEST(TestSequentialPlayer);
+  MITK_TEST(TestReadOnly);
+  MITK_TEST(TestTruncatedFileException);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  std::string m_FileName;
+  mitk::NavigationDataSet::Pointer m_Set;
+
+  /** Two tools with different names, some invalid datas and a covariance matrix which changes once */
+  mitk::NavigationDataSet::Pointer CreateNavigationDataSet(unsigned int numberOfTimeSteps)
+  {
+    mitk::NavigationDataSet::Pointer set = mitk::NavigationDataSet::New(2);
+    for (unsigned int i = 0; i < numberOfTimeSteps; i++)
+    {
+      std::vector<mitk::NavigationData::Pointer> step;
+      for (unsigned int tool = 0; tool < 2; tool++)
+      {
+        mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+        mitk::NavigationData::PositionType position;
+        position[0] = i + 0.1 * tool; position[1] = -2.5 * i; position[2] = 1000.0 / (i + 1);
+        nd->SetPosition(position);
+        nd->SetOrientation(mitk::NavigationData::OrientationType(0.1 * tool, 0.2, 0.3, 0.9));
+        nd->SetIGTTimeStamp(i * 16.7 + tool);
+        nd->SetDataValid(i % 7 != 0);
+        nd->SetHasOrientation(tool == 0);
+        nd->SetName(tool == 0 ? "Pointer" : "Reference");
+        if (i >= numberOfTimeSteps / 2)
+        {
+          mitk::NavigationData::CovarianceMatrixType matrix;
+          matrix.SetIdentity();
+          matrix[0][1] = 0.5 + tool;
+          nd->SetCovErrorMatrix(matrix);
+        }
+        step.push_back(nd);
+      }
+      set->AddNavigationDatas(step);
+    }
+    return set;
+  }
+
+  bool IsEqual(mitk::NavigationDataSet* set1, mitk::NavigationDataSet* set2)
+  {
+    if (set1->Size() != set2->Size() || set1->GetNumberOfTools() != set2->GetNumberOfTools())
+      return false;
+    for (unsigned int i = 0; i < set1->Size(); i++)
+      for (unsigned int tool = 0; tool < set1->GetNumberOfTools(); tool++)
+      {
+        mitk::NavigationData::Pointer nd1 = set1->GetNavigationDataForIndex(i, tool);
+        mitk::NavigationData::Pointer nd2 = set2->GetNavigationDataForIndex(i, tool);
+        if (!mitk::Equal(*nd1, *nd2, mitk::eps, true) || nd1->IsDataValid() != nd2->IsDataValid()
+          || nd1->GetHasPosition() != nd2->GetHasPosition() || nd1->GetHasOrientation() != nd2->GetHasOrientation())
+          return false;
+      }
+    return true;
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_FileName = mitk::IOUtil::CreateTemporaryFile("NavigationDataSetReaderWriterBinaryTest-XXXXXX.nds");
+    m_Set = CreateNavigationDataSet(100);
+  }
+
+  void tearDown() override
+  {
+    std::remove(m_FileName.c_str());
+    m_Set = nullptr;
+  }
+
+  void TestReadWrite()
+  {
+    mitk::IOUtil::Save(m_Set, m_FileName);
+    mitk::NavigationDataSet::Pointer loaded = dynamic_cast<mitk::NavigationDataSet*>(mitk::IOUtil::Load(m_FileName)[0].GetPointer());
+
+    CPPUNIT_ASSERT_MESSAGE("Binary sets should be read as mapped sets", dynamic_cast<mitk::MappedNavigationDataSet*>(loaded.GetPointer()) != nullptr);
+    CPPUNIT_ASSERT_MESSAGE("Read set should be equal to the written set", IsEqual(m_Set, loaded));
+    CPPUNIT_ASSERT_MESSAGE("Tool names should be read", loaded->GetToolName(1) == "Reference");
+
+    // writing a mapped set again has to give the same set
+    std::string fileName2 = mitk::IOUtil::CreateTemporaryFile("NavigationDataSetReaderWriterBinaryTest-XXXXXX.nds");
+    mitk::IOUtil::Save(loaded, fileName2);
+    mitk::NavigationDataSet::Pointer loaded2 = dynamic_cast<mitk::NavigationDataSet*>(mitk::IOUtil::Load(fileName2)[0].GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Writing a mapped set should give the same set", IsEqual(m_Set, loaded2));
+    loaded2 = nullptr;
+    std::remove(fileName2.c_str());
+  }
+
+  void TestSequentialPlayer()
+  {
+    mitk::IOUtil::Save(m_Set, m_FileName);
+    mitk::MappedNavigationDataSet::Pointer mapped = mitk::MappedNavigationDataSet::New(m_FileName);
+
+    mitk::NavigationDataSequentialPlayer::Pointer player = mitk::NavigationDataSequentialPlayer::New();
+    player->SetNavigationDataSet(mapped.GetPointer());
+
+    player->GoToSnapshot(42);
+    player->Update();
+    CPPUNIT_ASSERT_MESSAGE("Player should seek in the mapped set", mitk::Equal(*player->GetOutput(1), *m_Set->GetNavigationDataForIndex(42, 1)));
+
+    player->GoToNextSnapshot();
+    player->Update();
+    CPPUNIT_ASSERT_MESSAGE("Player should go to the next snapshot of the mapped set", mitk::Equal(*player->GetOutput(0), *m_Set->GetNavigationDataForIndex(43, 0)));
+  }
+
+  void TestReadOnly()
+  {
+    mitk::IOUtil::Save(m_Set, m_FileName);
+    mitk::MappedNavigationDataSet::Pointer mapped = mitk::MappedNavigationDataSet::New(m_FileName);
+
+    std::vector<mitk::NavigationData::Pointer> step = m_Set->GetTimeStep(0);
+    for (unsigned int tool = 0; tool < step.size(); tool++)
+      step[tool]->SetIGTTimeStamp(1e6);
+    CPPUNIT_ASSERT_MESSAGE("Mapped sets should not be changed", !mapped->AddNavigationDatas(step));
+    CPPUNIT_ASSERT_MESSAGE("Mapped sets should keep their size", mapped->Size() == m_Set->Size());
+  }
+
+  void TestTruncatedFileException()
+  {
+    mitk::IOUtil::Save(m_Set, m_FileName);
+
+    std::string truncatedFileName = mitk::IOUtil::CreateTemporaryFile("NavigationDataSetReaderWriterBinaryTest-XXXXXX.nds");
+    {
+      std::ifstream in(m_FileName.c_str(), std::ios::binary);
+      std::ofstream out(truncatedFileName.c_str(), std::ios::binary);
+      std::vector<char> data(1000);
+      in.read(data.data(), data.size());
+      out.write(data.data(), in.gcount());
+    }
+
+    bool exceptionThrown = false;
+    try
+    {
+      mitk::MappedNavigationDataSet::New(truncatedFileName);
+    }
+    catch (mitk::IGTIOException&)
+    {
+      exceptionThrown = true;
+    }
+    std::remove(truncatedFileName.c_str());
+    CPPUNIT_ASSERT_MESSAGE("Reading a truncated file should throw", exceptionThrown);
+  }
+};
+MITK_TEST_SUITE_REGISTRATION(mitkNavigationDataSetReaderWriterBinary)
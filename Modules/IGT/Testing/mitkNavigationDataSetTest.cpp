@@ -63,22 +63,58 @@ static void TestSetAndGet()
   MITK_TEST_CONDITION_REQUIRED(!(navigationDataSet->AddNavigationDatas(step3)),
     "Adding an invalid third set, should be unsusuccessful.");
 
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(0, 0) == nd11,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(0, 0), *nd11),
     "First NavigationData object for tool 0 should be the same as added previously.");
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(0, 1) == nd21,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(0, 1), *nd21),
     "Second NavigationData object for tool 0 should be the same as added previously.");
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(1, 0) == nd12,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(1, 0), *nd12),
     "First NavigationData object for tool 0 should be the same as added previously.");
-  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(1, 1) == nd22,
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*navigationDataSet->GetNavigationDataForIndex(1, 1), *nd22),
     "Second NavigationData object for tool 0 should be the same as added previously.");
 
   std::vector<mitk::NavigationData::Pointer> result = navigationDataSet->GetTimeStep(1);
-  MITK_TEST_CONDITION_REQUIRED(nd12 == result[0],"Comparing returned datas from GetTimeStep().");
-  MITK_TEST_CONDITION_REQUIRED(nd22 == result[1],"Comparing returned datas from GetTimeStep().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd12, *result[0]),"Comparing returned datas from GetTimeStep().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd22, *result[1]),"Comparing returned datas from GetTimeStep().");
 
   result = navigationDataSet->GetDataStreamForTool(1);
-  MITK_TEST_CONDITION_REQUIRED(nd21 == result[0],"Comparing returned datas from GetStreamForTool().");
-  MITK_TEST_CONDITION_REQUIRED(nd22 == result[1],"Comparing returned datas from GetStreamForTool().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd21, *result[0]),"Comparing returned datas from GetStreamForTool().");
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd22, *result[1]),"Comparing returned datas from GetStreamForTool().");
+
+  // the set stores copies of the added navigation datas
+  nd11->SetIGTTimeStamp(5);
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetNavigationDataForIndex(0, 0)->GetIGTTimeStamp() == 0,
+    "Changing an added NavigationData should not change the set.");
+
+  mitk::NavigationData::Pointer output = mitk::NavigationData::New();
+  navigationDataSet->CopyNavigationData(1, 1, output);
+  MITK_TEST_CONDITION_REQUIRED(mitk::Equal(*nd22, *output), "Comparing datas copied by CopyNavigationData().");
+
+  unsigned int count = 0;
+  for (mitk::NavigationDataSet::NavigationDataSetConstIterator it = navigationDataSet->Begin(); it != navigationDataSet->End(); ++it, ++count)
+    MITK_TEST_CONDITION_REQUIRED(it->size() == 2 && mitk::Equal(*it->at(1), *navigationDataSet->GetNavigationDataForIndex(count, 1)),
+      "Comparing datas returned by the iterator.");
+  MITK_TEST_CONDITION_REQUIRED(count == 2 && navigationDataSet->End() - navigationDataSet->Begin() == 2, "Iterating over all time steps.");
+}
+
+static void TestGetIndexForIGTTimeStamp()
+{
+  mitk::NavigationDataSet::Pointer navigationDataSet = mitk::NavigationDataSet::New(1);
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetIndexForIGTTimeStamp(10) == 0, "Searching in an empty set should return 0.");
+
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    nd->SetIGTTimeStamp(10 + 2 * i);
+    std::vector<mitk::NavigationData::Pointer> step;
+    step.push_back(nd);
+    navigationDataSet->AddNavigationDatas(step);
+  }
+
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetIndexForIGTTimeStamp(5) == 0, "Timestamp before the first time step.");
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetIndexForIGTTimeStamp(10) == 0, "Timestamp of the first time step.");
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetIndexForIGTTimeStamp(15) == 2, "Timestamp between two time steps.");
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetIndexForIGTTimeStamp(16) == 3, "Timestamp of a time step.");
+  MITK_TEST_CONDITION_REQUIRED(navigationDataSet->GetIndexForIGTTimeStamp(100) == 9, "Timestamp behind the last time step.");
 }
 
 /**
@@ -90,6 +126,7 @@ int mitkNavigationDataSetTest(int /* argc */, char* /*argv*/[])
 
   TestEmptySet();
   TestSetAndGet();
+  TestGetIndexForIGTTimeStamp();
 
   MITK_TEST_END();
 }
\ No newline at end of file
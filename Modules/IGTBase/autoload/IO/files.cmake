@@ -4,4 +4,6 @@ set(CPP_FILES
    mitkNavigationDataSetWriterCSV.cpp
    mitkNavigationDataReaderXML.cpp
    mitkNavigationDataReaderCSV.cpp
+   mitkNavigationDataSetWriterBinary.cpp
+   mitkNavigationDataReaderBinary.cpp
 )
@@ -0,0 +1,49 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// MITK
+#include "mitkNavigationDataReaderBinary.h"
+#include <mitkIGTMimeTypes.h>
+#include <mitkMappedNavigationDataSet.h>
+
+mitk::NavigationDataReaderBinary::NavigationDataReaderBinary() : AbstractFileReader(
+  mitk::IGTMimeTypes::NAVIGATIONDATASETBINARY_MIMETYPE(),
+  "MITK NavigationData Reader (binary)")
+{
+  RegisterService();
+}
+
+mitk::NavigationDataReaderBinary::NavigationDataReaderBinary(const mitk::NavigationDataReaderBinary& other) : AbstractFileReader(other)
+{
+}
+
+mitk::NavigationDataReaderBinary::~NavigationDataReaderBinary()
+{
+}
+
+mitk::NavigationDataReaderBinary* mitk::NavigationDataReaderBinary::Clone() const
+{
+  return new NavigationDataReaderBinary(*this);
+}
+
+std::vector<itk::SmartPointer<mitk::BaseData>> mitk::NavigationDataReaderBinary::Read()
+{
+  mitk::MappedNavigationDataSet::Pointer set = mitk::MappedNavigationDataSet::New(this->GetLocalFileName());
+
+  std::vector<mitk::BaseData::Pointer> result;
+  result.push_back(set.GetPointer());
+  return result;
+}
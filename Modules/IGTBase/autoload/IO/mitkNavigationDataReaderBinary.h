@@ -0,0 +1,51 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNavigationDataReaderBinary_H_HEADER_INCLUDED_
+#define MITKNavigationDataReaderBinary_H_HEADER_INCLUDED_
+
+#include <MitkIGTIOExports.h>
+
+#include <mitkAbstractFileReader.h>
+#include <mitkNavigationDataSet.h>
+
+namespace mitk {
+  /** This class reads navigation data sets in the compact binary format. The returned
+   *  set is a mitk::MappedNavigationDataSet, which maps the file into memory instead of
+   *  loading all navigation datas.
+   */
+  class MITKIGTIO_EXPORT NavigationDataReaderBinary : public AbstractFileReader
+  {
+  public:
+
+    NavigationDataReaderBinary();
+    virtual ~NavigationDataReaderBinary();
+
+    /** @return Returns the mitk::MappedNavigationDataSet of the given file.
+     *  @throw mitk::IGTIOException if the file is not a valid binary NavigationDataSet.
+     */
+    using AbstractFileReader::Read;
+    virtual std::vector<itk::SmartPointer<BaseData>> Read() override;
+
+  protected:
+
+    NavigationDataReaderBinary(const NavigationDataReaderBinary& other);
+
+    virtual mitk::NavigationDataReaderBinary* Clone() const override;
+  };
+}
+
+#endif // MITKNavigationDataReaderBinary_H_HEADER_INCLUDED_
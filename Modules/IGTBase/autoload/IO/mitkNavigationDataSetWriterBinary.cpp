@@ -0,0 +1,127 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataSetWriterBinary.h"
+#include <mitkIGTMimeTypes.h>
+#include <mitkIGTIOException.h>
+#include <mitkMappedNavigationDataSet.h>
+
+#include <cstring>
+
+mitk::NavigationDataSetWriterBinary::NavigationDataSetWriterBinary() : AbstractFileWriter(NavigationDataSet::GetStaticNameOfClass(),
+  mitk::IGTMimeTypes::NAVIGATIONDATASETBINARY_MIMETYPE(),
+  "MITK NavigationDataSet Writer (binary)")
+{
+  RegisterService();
+}
+
+mitk::NavigationDataSetWriterBinary::~NavigationDataSetWriterBinary()
+{}
+
+mitk::NavigationDataSetWriterBinary::NavigationDataSetWriterBinary(const mitk::NavigationDataSetWriterBinary& other) : AbstractFileWriter(other)
+{
+}
+
+mitk::NavigationDataSetWriterBinary* mitk::NavigationDataSetWriterBinary::Clone() const
+{
+  return new NavigationDataSetWriterBinary(*this);
+}
+
+void mitk::NavigationDataSetWriterBinary::Write()
+{
+  typedef mitk::MappedNavigationDataSet::FileHeader FileHeader;
+  typedef mitk::MappedNavigationDataSet::Record Record;
+
+  mitk::NavigationDataSet::ConstPointer data = dynamic_cast<const NavigationDataSet*> (this->GetInput());
+  if (data.IsNull())
+  {
+    mitkThrowException(mitk::IGTIOException) << "Input of the binary NavigationDataSet writer is not a NavigationDataSet.";
+  }
+
+  unsigned int numberOfTools = data->GetNumberOfTools();
+  unsigned int numberOfTimeSteps = data->Size();
+
+  // first pass: collect the distinct covariance matrices, which are stored behind the records
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+  std::vector<mitk::NavigationData::CovarianceMatrixType> covErrorMatrices;
+  std::vector<unsigned int> covErrorMatrixIndices;
+  covErrorMatrixIndices.reserve(static_cast<std::size_t>(numberOfTimeSteps) * numberOfTools);
+  for (unsigned int i = 0; i < numberOfTimeSteps; i++)
+    for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
+    {
+      data->CopyNavigationData(i, toolIndex, nd);
+      covErrorMatrixIndices.push_back(mitk::NavigationDataSet::AddCovErrorMatrix(covErrorMatrices, covErrorMatrixIndices, numberOfTools, nd->GetCovErrorMatrix()));
+    }
+
+  std::string toolNames;
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
+  {
+    std::string name = data->GetToolName(toolIndex);
+    std::uint32_t length = name.size();
+    toolNames.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    toolNames.append(name);
+  }
+  // records start at a multiple of 8 bytes, so they can be accessed in place when the file is mapped
+  toolNames.resize((sizeof(FileHeader) + toolNames.size() + sizeof(double) - 1) / sizeof(double) * sizeof(double) - sizeof(FileHeader), '\0');
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.Magic, mitk::MappedNavigationDataSet::GetFileMagic(), sizeof(header.Magic));
+  header.Version = mitk::MappedNavigationDataSet::FILE_VERSION;
+  header.ByteOrder = mitk::MappedNavigationDataSet::BYTE_ORDER_MARK;
+  header.NumberOfTools = numberOfTools;
+  header.NumberOfTimeSteps = numberOfTimeSteps;
+  header.RecordSize = sizeof(Record);
+  header.NumberOfCovErrorMatrices = covErrorMatrices.size();
+  header.ToolNamesOffset = sizeof(FileHeader);
+  header.RecordsOffset = sizeof(FileHeader) + toolNames.size();
+  header.CovErrorMatricesOffset = header.RecordsOffset + static_cast<std::uint64_t>(numberOfTimeSteps) * numberOfTools * sizeof(Record);
+
+  OutputStream out(this, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(toolNames.data(), toolNames.size());
+
+  // second pass: write the records
+  Record record;
+  std::memset(&record, 0, sizeof(record));
+  for (unsigned int i = 0; i < numberOfTimeSteps; i++)
+    for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
+    {
+      data->CopyNavigationData(i, toolIndex, nd);
+      record.IGTTimeStamp = nd->GetIGTTimeStamp();
+      for (int j = 0; j < 3; ++j)
+        record.Position[j] = nd->GetPosition()[j];
+      for (int j = 0; j < 4; ++j)
+        record.Orientation[j] = nd->GetOrientation()[j];
+      record.CovErrorMatrixIndex = covErrorMatrixIndices[static_cast<std::size_t>(i) * numberOfTools + toolIndex];
+      record.Flags = mitk::NavigationDataSet::GetFlags(nd);
+      out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+
+  for (std::size_t i = 0; i < covErrorMatrices.size(); i++)
+    for (unsigned int row = 0; row < 6; row++)
+      for (unsigned int column = 0; column < 6; column++)
+      {
+        double value = covErrorMatrices[i][row][column];
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+      }
+
+  out.flush();
+  if (!out)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Could not write binary NavigationDataSet to " << this->GetOutputLocation() << ".";
+  }
+}
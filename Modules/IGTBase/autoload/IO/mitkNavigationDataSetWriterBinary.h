@@ -0,0 +1,45 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNavigationDataSetWriterBinary_H_HEADER_INCLUDED_
+#define MITKNavigationDataSetWriterBinary_H_HEADER_INCLUDED_
+
+#include <MitkIGTIOExports.h>
+
+#include <mitkNavigationDataSet.h>
+#include <mitkAbstractFileWriter.h>
+
+namespace mitk {
+  /** This class writes navigation data sets in the compact binary format which is
+   *  read by mitk::MappedNavigationDataSet, see there for a description of the format.
+   */
+  class MITKIGTIO_EXPORT NavigationDataSetWriterBinary : public AbstractFileWriter
+  {
+  public:
+    NavigationDataSetWriterBinary();
+    virtual~NavigationDataSetWriterBinary();
+
+    using AbstractFileWriter::Write;
+    virtual void Write() override;
+
+  protected:
+    NavigationDataSetWriterBinary(const NavigationDataSetWriterBinary& other);
+
+    virtual mitk::NavigationDataSetWriterBinary* Clone() const override;
+  };
+}
+
+#endif // MITKNavigationDataSetWriterBinary_H_HEADER_INCLUDED_
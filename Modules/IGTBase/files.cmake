@@ -4,6 +4,7 @@ set(CPP_FILES
   mitkRealTimeClock.cpp
   mitkNavigationData.cpp
   mitkNavigationDataSet.cpp
+  mitkMappedNavigationDataSet.cpp
   mitkStaticIGTHelperFunctions.cpp
   mitkQuaternionAveraging.cpp
   mitkIGTMimeTypes.cpp
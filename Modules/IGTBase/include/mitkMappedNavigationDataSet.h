@@ -0,0 +1,144 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKMAPPEDNAVIGATIONDATASET_H_HEADER_INCLUDED_
+#define MITKMAPPEDNAVIGATIONDATASET_H_HEADER_INCLUDED_
+
+#include "mitkNavigationDataSet.h"
+
+#include <cstdint>
+
+namespace mitk {
+  /**
+  * \brief Read only mitk::NavigationDataSet which reads its navigation datas directly from a file
+  * in the binary NavigationDataSet format.
+  *
+  * The file is mapped into memory (mmap on POSIX, MapViewOfFile on Windows), so opening even very
+  * long recordings is fast and only the parts which are accessed, e.g. by mitk::NavigationDataPlayer,
+  * are loaded by the operating system. If the file cannot be mapped, it is read into memory.
+  *
+  * The binary format consists of a FileHeader, followed by the tool names, one Record per navigation
+  * data (time step by time step, see NavigationDataSet) and the table of the distinct covariance matrices.
+  * All values are stored in the byte order of the writing machine.
+  */
+  class MITKIGTBASE_EXPORT MappedNavigationDataSet : public NavigationDataSet
+  {
+  public:
+
+    mitkClassMacro(MappedNavigationDataSet, NavigationDataSet);
+
+    /**
+    * \brief Opens the given file.
+    * @throw mitk::IGTIOException if the file cannot be opened or is not a valid binary NavigationDataSet.
+    */
+    mitkNewMacro1Param(Self, const std::string&);
+
+    /**
+    * \brief Header at the start of a binary NavigationDataSet file.
+    */
+    struct FileHeader
+    {
+      char Magic[8];
+      std::uint32_t Version;
+      std::uint32_t ByteOrder;
+      std::uint32_t NumberOfTools;
+      std::uint32_t NumberOfTimeSteps;
+      std::uint32_t RecordSize;
+      std::uint32_t NumberOfCovErrorMatrices;
+      std::uint64_t ToolNamesOffset;
+      std::uint64_t RecordsOffset;
+      std::uint64_t CovErrorMatricesOffset;
+    };
+
+    /**
+    * \brief One navigation data in a binary NavigationDataSet file.
+    *
+    * The orientation is stored as x, y, z, r. The flags are the NavigationDataFlags.
+    */
+    struct Record
+    {
+      double IGTTimeStamp;
+      double Position[3];
+      double Orientation[4];
+      std::uint32_t CovErrorMatrixIndex;
+      std::uint32_t Flags;
+    };
+
+    /**
+    * \brief Returns the magic bytes every binary NavigationDataSet file starts with.
+    */
+    static const char* GetFileMagic();
+
+    static const std::uint32_t FILE_VERSION = 1;
+    static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    /**
+    * \brief A mapped set cannot be changed, so this always returns false.
+    */
+    virtual bool AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas ) override;
+
+    virtual void CopyNavigationData( unsigned int index, unsigned int toolIndex, NavigationData* navigationData ) const override;
+
+    virtual NavigationData::TimeStampType GetIGTTimeStamp( unsigned int index, unsigned int toolIndex ) const override;
+
+    /**
+    * \brief Returns true if the file is mapped into memory, false if it was read.
+    */
+    bool IsMapped() const;
+
+  protected:
+    MappedNavigationDataSet( const std::string& fileName );
+    virtual ~MappedNavigationDataSet();
+
+    /**
+    * \brief Checks the header of the file and reads the tool names and covariance matrices.
+    */
+    void ReadHeader( const std::string& fileName );
+
+    /**
+    * \brief Maps the file into memory, returns false if this is not possible.
+    */
+    bool Map( const std::string& fileName );
+    void Unmap();
+
+    const Record& GetRecord( unsigned int index, unsigned int toolIndex ) const
+    {
+      return m_Records[static_cast<std::size_t>(index) * m_NumberOfTools + toolIndex];
+    }
+
+    /**
+    * \brief Start of the file in memory, either mapped or in m_Buffer.
+    */
+    const char* m_Data;
+    std::size_t m_DataSize;
+    const Record* m_Records;
+
+    /**
+    * \brief Holds the file if it could not be mapped.
+    */
+    std::vector<char> m_Buffer;
+
+    /**
+    * \brief The mapped file, a file descriptor on POSIX and file and mapping handles on Windows.
+    */
+    int m_FileDescriptor;
+    void* m_FileHandle;
+    void* m_MappingHandle;
+    bool m_Mapped;
+  };
+}
+
+#endif // MITKMAPPEDNAVIGATIONDATASET_H_HEADER_INCLUDED_
@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseData.h"
 #include "mitkNavigationData.h"
 
+#include <iterator>
+
 namespace mitk {
   /**
   * \brief Data structure which stores streams of mitk::NavigationData for
@@ -29,6 +31,10 @@ namespace mitk {
   * Use mitk::NavigationDataRecorder to create these sets easily from pipelines.
   * Use mitk::NavigationDataPlayer to stream from these sets easily.
   *
+  * The values of the navigation datas are stored in one array per member of mitk::NavigationData
+  * instead of one object per navigation data. Recordings stored in the binary format are read
+  * by mitk::MappedNavigationDataSet, which does not load the whole file.
+  *
   */
   class MITKIGTBASE_EXPORT NavigationDataSet : public BaseData
   {
@@ -38,17 +44,59 @@ namespace mitk {
     * \brief This iterator iterates over the distinct time steps in this set.
     *
     * It returns an array of the length equal to GetNumberOfTools(), containing a
-    * mitk::NavigationData for each tool..
+    * mitk::NavigationData for each tool. The array is created from the stored values
+    * when the iterator is dereferenced, so changing it does not change the set.
     */
-    typedef std::vector< std::vector<mitk::NavigationData::Pointer> >::iterator NavigationDataSetIterator;
+    class MITKIGTBASE_EXPORT TimeStepIterator
+    {
+    public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef std::vector<mitk::NavigationData::Pointer> value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const value_type* pointer;
+      typedef const value_type& reference;
+
+      TimeStepIterator() : m_Set(nullptr), m_Index(0) {}
+      TimeStepIterator(const NavigationDataSet* set, unsigned int index) : m_Set(set), m_Index(index) {}
+
+      reference operator*() const;
+      pointer operator->() const { return &**this; }
+
+      TimeStepIterator& operator++() { ++m_Index; m_TimeStep.clear(); return *this; }
+      TimeStepIterator operator++(int) { TimeStepIterator result(*this); ++*this; return result; }
+      TimeStepIterator& operator--() { --m_Index; m_TimeStep.clear(); return *this; }
+      TimeStepIterator operator--(int) { TimeStepIterator result(*this); --*this; return result; }
+      TimeStepIterator& operator+=(difference_type n) { m_Index += n; m_TimeStep.clear(); return *this; }
+      TimeStepIterator& operator-=(difference_type n) { m_Index -= n; m_TimeStep.clear(); return *this; }
+      TimeStepIterator operator+(difference_type n) const { return TimeStepIterator(m_Set, m_Index + n); }
+      TimeStepIterator operator-(difference_type n) const { return TimeStepIterator(m_Set, m_Index - n); }
+      difference_type operator-(const TimeStepIterator& other) const { return difference_type(m_Index) - difference_type(other.m_Index); }
+
+      bool operator==(const TimeStepIterator& other) const { return m_Set == other.m_Set && m_Index == other.m_Index; }
+      bool operator!=(const TimeStepIterator& other) const { return !(*this == other); }
+      bool operator<(const TimeStepIterator& other) const { return m_Index < other.m_Index; }
+
+      /**
+      * \brief Returns the index of the time step the iterator points to.
+      */
+      unsigned int GetIndex() const { return m_Index; }
+
+    private:
+      const NavigationDataSet* m_Set;
+      unsigned int m_Index;
+      mutable std::vector<mitk::NavigationData::Pointer> m_TimeStep;
+    };
+
+    /**
+    * \brief Iterator over the time steps of this set, kept for compatibility. The time steps cannot
+    * be changed through it.
+    */
+    typedef TimeStepIterator NavigationDataSetIterator;
 
     /**
     * \brief This iterator iterates over the distinct time steps in this set. And is const.
-    *
-    * It returns an array of the length equal to GetNumberOfTools(), containing a
-    * mitk::NavigationData for each tool..
     */
-    typedef std::vector< std::vector<mitk::NavigationData::Pointer> >::const_iterator NavigationDataSetConstIterator;
+    typedef TimeStepIterator NavigationDataSetConstIterator;
 
     mitkClassMacro(NavigationDataSet, BaseData);
 
@@ -60,18 +108,51 @@ namespace mitk {
     * @param navigationDatas vector of mitk::NavigationData objects to be added. Make sure that the size of the
     * vector equals the number of tools given in the constructor
     * @return true if object was be added to the set successfully, false otherwise
+    *
+    * The values of the navigation datas are copied into the set, later changes of the
+    * given objects do not affect the set. The tool names are taken from the first time step.
     */
-    bool AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas );
+    virtual bool AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas );
 
     /**
     * \brief Get mitk::NavigationData from the given tool at given index.
     *
     * @param toolIndex Index of the tool from which mitk::NavigationData should be returned.
     * @param index Index of the mitk::NavigationData object that should be returned.
-    * @return mitk::NavigationData at the specified indices, 0 if there is no object at the indices.
+    * @return new mitk::NavigationData holding the values at the specified indices, 0 if there is no object at the indices.
     */
     NavigationData::Pointer GetNavigationDataForIndex( unsigned int index, unsigned int toolIndex ) const;
 
+    /**
+    * \brief Copies the values stored for the given tool at the given index into an existing mitk::NavigationData.
+    *
+    * Unlike GetNavigationDataForIndex() this does not create a new object, which makes it the
+    * preferred way for filling the outputs of a player. The indices are not checked.
+    *
+    * @param index Index of the time step, has to be smaller than Size().
+    * @param toolIndex Index of the tool, has to be smaller than GetNumberOfTools().
+    * @param navigationData Object the values are copied to.
+    */
+    virtual void CopyNavigationData( unsigned int index, unsigned int toolIndex, NavigationData* navigationData ) const;
+
+    /**
+    * \brief Returns the IGT time stamp stored for the given tool at the given index. The indices are not checked.
+    */
+    virtual NavigationData::TimeStampType GetIGTTimeStamp( unsigned int index, unsigned int toolIndex ) const;
+
+    /**
+    * \brief Returns the index of the last time step whose time stamp of the given tool is not
+    * greater than the given time stamp, or 0 if there is no such time step.
+    *
+    * The time stamps of a set are strictly increasing, so this is a binary search.
+    */
+    unsigned int GetIndexForIGTTimeStamp( NavigationData::TimeStampType timestamp, unsigned int toolIndex = 0 ) const;
+
+    /**
+    * \brief Returns the name of the given tool, as given by the navigation datas of the first time step.
+    */
+    std::string GetToolName( unsigned int toolIndex ) const;
+
     ///**
     //* \brief Get last mitk::Navigation object for given tool whose timestamp is less than the given timestamp.
     //* @param toolIndex Index of the tool from which mitk::NavigationData should be returned.
@@ -134,6 +215,36 @@ namespace mitk {
     */
     virtual NavigationDataSetConstIterator End() const;
 
+    /**
+    * \brief Bits of the flags stored for every navigation data.
+    */
+    enum NavigationDataFlags
+    {
+      DataValidFlag = 1,
+      HasPositionFlag = 2,
+      HasOrientationFlag = 4
+    };
+
+    /**
+    * \brief Returns the flags describing the given navigation data.
+    */
+    static unsigned char GetFlags( const NavigationData* navigationData );
+
+    /**
+    * \brief Returns the index of the given covariance matrix in the table of distinct matrices.
+    *
+    * Consecutive navigation datas almost always share their covariance matrix, so the matrix
+    * of the previous time step of the same tool and the last added matrix are reused if they are equal.
+    * Otherwise the matrix is appended to the table. Also used by the writers of binary sets.
+    *
+    * @param matrices Table of the distinct matrices.
+    * @param indices Indices into the table of all navigation datas added before, time step by time step.
+    * @param numberOfTools Number of navigation datas per time step.
+    * @param matrix The matrix of the navigation data which is added.
+    */
+    static unsigned int AddCovErrorMatrix( std::vector<NavigationData::CovarianceMatrixType>& matrices,
+      const std::vector<unsigned int>& indices, unsigned int numberOfTools, const NavigationData::CovarianceMatrixType& matrix );
+
     // virtual methods, that need to be implemented, but aren't reasonable for NavigationData
     virtual void SetRequestedRegionToLargestPossibleRegion( ) override;
     virtual bool RequestedRegionIsOutsideOfTheBufferedRegion( ) override;
@@ -157,12 +268,35 @@ namespace mitk {
     virtual ~NavigationDataSet( );
 
     /**
-    * \brief Holds all the mitk::NavigationData objects managed by this class.
+    * \brief Holds the values of all navigation datas managed by this class, one array per member of mitk::NavigationData.
     *
-    * The first dimension is the index of the navigation data, the second is the
-    * tool to which this data belongs. i.e. the first dimension is usually the longer one.
+    * The navigation data of a tool at a time step is found at index * m_NumberOfTools + toolIndex, i.e. the
+    * datas of one time step are stored next to each other.
+    */
+    std::vector<NavigationData::TimeStampType> m_IGTTimeStamps;
+    std::vector<NavigationData::PositionType> m_Positions;
+    std::vector<NavigationData::OrientationType> m_Orientations;
+    std::vector<unsigned char> m_Flags;
+
+    /**
+    * \brief Index into m_CovErrorMatrices for every navigation data.
+    */
+    std::vector<unsigned int> m_CovErrorMatrixIndices;
+
+    /**
+    * \brief The distinct covariance matrices of all navigation datas.
+    */
+    std::vector<NavigationData::CovarianceMatrixType> m_CovErrorMatrices;
+
+    /**
+    * \brief The names of the tools.
+    */
+    std::vector<std::string> m_ToolNames;
+
+    /**
+    * \brief The number of time steps stored in this set.
     */
-    std::vector<std::vector<NavigationData::Pointer> > m_NavigationDataVectors;
+    unsigned int m_NumberOfTimeSteps;
 
     /**
     * \brief The Number of Tools that this class is going to support.
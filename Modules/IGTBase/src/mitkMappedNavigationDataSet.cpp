@@ -0,0 +1,267 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkMappedNavigationDataSet.h"
+#include "mitkIGTIOException.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const std::uint32_t mitk::MappedNavigationDataSet::FILE_VERSION;
+const std::uint32_t mitk::MappedNavigationDataSet::BYTE_ORDER_MARK;
+
+const char* mitk::MappedNavigationDataSet::GetFileMagic()
+{
+  return "MITKNDS";
+}
+
+mitk::MappedNavigationDataSet::MappedNavigationDataSet( const std::string& fileName )
+  : NavigationDataSet(0), m_Data(nullptr), m_DataSize(0), m_Records(nullptr), m_FileDescriptor(-1),
+    m_FileHandle(nullptr), m_MappingHandle(nullptr), m_Mapped(false)
+{
+  if (!this->Map(fileName))
+  {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if (!file)
+    {
+      mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' could not be opened.";
+    }
+    MITK_WARN("MappedNavigationDataSet") << "Could not map " << fileName << ". Reading it into memory.";
+    m_Buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_Data = m_Buffer.data();
+    m_DataSize = m_Buffer.size();
+  }
+
+  try
+  {
+    this->ReadHeader(fileName);
+  }
+  catch (...)
+  {
+    // the destructor is not called if the constructor throws
+    this->Unmap();
+    throw;
+  }
+}
+
+mitk::MappedNavigationDataSet::~MappedNavigationDataSet()
+{
+  this->Unmap();
+}
+
+bool mitk::MappedNavigationDataSet::Map( const std::string& fileName )
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr)
+  {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  m_FileHandle = file;
+  m_MappingHandle = mapping;
+  m_Data = static_cast<const char*>(data);
+  m_DataSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+  int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (fileDescriptor == -1)
+    return false;
+
+  struct stat fileStatus;
+  if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0)
+  {
+    close(fileDescriptor);
+    return false;
+  }
+
+  void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  if (data == MAP_FAILED)
+  {
+    close(fileDescriptor);
+    return false;
+  }
+
+  m_FileDescriptor = fileDescriptor;
+  m_Data = static_cast<const char*>(data);
+  m_DataSize = fileStatus.st_size;
+#endif
+  m_Mapped = true;
+  return true;
+}
+
+void mitk::MappedNavigationDataSet::Unmap()
+{
+  if (!m_Mapped)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(m_Data);
+  CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+  CloseHandle(static_cast<HANDLE>(m_FileHandle));
+  m_MappingHandle = nullptr;
+  m_FileHandle = nullptr;
+#else
+  munmap(const_cast<char*>(m_Data), m_DataSize);
+  close(m_FileDescriptor);
+  m_FileDescriptor = -1;
+#endif
+  m_Data = nullptr;
+  m_DataSize = 0;
+  m_Mapped = false;
+}
+
+void mitk::MappedNavigationDataSet::ReadHeader( const std::string& fileName )
+{
+  FileHeader header;
+  if (m_DataSize < sizeof(FileHeader))
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' is too small for a binary NavigationDataSet.";
+  }
+  std::memcpy(&header, m_Data, sizeof(FileHeader));
+
+  if (std::memcmp(header.Magic, GetFileMagic(), sizeof(header.Magic)) != 0)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' is not a binary NavigationDataSet.";
+  }
+  if (header.Version != FILE_VERSION)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' has unsupported version " << header.Version << ".";
+  }
+  if (header.ByteOrder != BYTE_ORDER_MARK)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' was written on a machine with a different byte order.";
+  }
+  if (header.RecordSize != sizeof(Record) || header.RecordsOffset % sizeof(double) != 0)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' has an unsupported record layout.";
+  }
+
+  // the offsets are read from the file, so compare against the remaining size to avoid overflows
+  std::uint64_t dataSize = m_DataSize;
+  std::uint64_t recordsSize = static_cast<std::uint64_t>(header.NumberOfTimeSteps) * header.NumberOfTools * sizeof(Record);
+  std::uint64_t matricesSize = static_cast<std::uint64_t>(header.NumberOfCovErrorMatrices) * 36 * sizeof(double);
+  if (header.ToolNamesOffset > dataSize
+    || header.RecordsOffset > dataSize || recordsSize > dataSize - header.RecordsOffset
+    || header.CovErrorMatricesOffset > dataSize || matricesSize > dataSize - header.CovErrorMatricesOffset)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' is truncated.";
+  }
+
+  // tool names are stored as length and characters
+  m_ToolNames.clear();
+  std::uint64_t offset = header.ToolNamesOffset;
+  for (unsigned int i = 0; i < header.NumberOfTools; i++)
+  {
+    std::uint32_t length = 0;
+    if (sizeof(length) > dataSize - offset)
+    {
+      mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' is truncated.";
+    }
+    std::memcpy(&length, m_Data + offset, sizeof(length));
+    offset += sizeof(length);
+    if (length > dataSize - offset)
+    {
+      mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' is truncated.";
+    }
+    m_ToolNames.push_back(std::string(m_Data + offset, length));
+    offset += length;
+  }
+
+  m_CovErrorMatrices.resize(header.NumberOfCovErrorMatrices);
+  const char* matrices = m_Data + header.CovErrorMatricesOffset;
+  for (unsigned int i = 0; i < header.NumberOfCovErrorMatrices; i++)
+    for (unsigned int row = 0; row < 6; row++)
+      for (unsigned int column = 0; column < 6; column++)
+      {
+        double value;
+        std::memcpy(&value, matrices + ((i * 6 + row) * 6 + column) * sizeof(double), sizeof(double));
+        m_CovErrorMatrices[i][row][column] = value;
+      }
+
+  m_Records = reinterpret_cast<const Record*>(m_Data + header.RecordsOffset);
+  m_NumberOfTools = header.NumberOfTools;
+  m_NumberOfTimeSteps = header.NumberOfTimeSteps;
+}
+
+bool mitk::MappedNavigationDataSet::AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> )
+{
+  MITK_WARN("MappedNavigationDataSet") << "Cannot add NavigationDatas to a set which is read from a file.";
+  return false;
+}
+
+void mitk::MappedNavigationDataSet::CopyNavigationData( unsigned int index, unsigned int toolIndex, mitk::NavigationData* navigationData ) const
+{
+  const Record& record = this->GetRecord(index, toolIndex);
+  if (record.CovErrorMatrixIndex >= m_CovErrorMatrices.size())
+  {
+    mitkThrowException(mitk::IGTIOException) << "Invalid covariance matrix index at index " << index << " for tool " << toolIndex << ".";
+  }
+
+  mitk::NavigationData::PositionType position;
+  for (int i = 0; i < 3; ++i)
+    position[i] = record.Position[i];
+  mitk::NavigationData::OrientationType orientation(record.Orientation[0], record.Orientation[1],
+    record.Orientation[2], record.Orientation[3]);
+
+  navigationData->SetIGTTimeStamp(record.IGTTimeStamp);
+  navigationData->SetPosition(position);
+  navigationData->SetOrientation(orientation);
+  navigationData->SetDataValid((record.Flags & DataValidFlag) != 0);
+  navigationData->SetHasPosition((record.Flags & HasPositionFlag) != 0);
+  navigationData->SetHasOrientation((record.Flags & HasOrientationFlag) != 0);
+  navigationData->SetCovErrorMatrix(m_CovErrorMatrices[record.CovErrorMatrixIndex]);
+  navigationData->SetName(m_ToolNames[toolIndex]);
+}
+
+mitk::NavigationData::TimeStampType mitk::MappedNavigationDataSet::GetIGTTimeStamp( unsigned int index, unsigned int toolIndex ) const
+{
+  return this->GetRecord(index, toolIndex).IGTTimeStamp;
+}
+
+bool mitk::MappedNavigationDataSet::IsMapped() const
+{
+  return m_Mapped;
+}
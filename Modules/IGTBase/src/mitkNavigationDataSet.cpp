@@ -18,8 +18,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkPointSet.h"
 #include "mitkBaseRenderer.h"
 
+#include <algorithm>
+
 mitk::NavigationDataSet::NavigationDataSet( unsigned int numberOfTools )
-  : m_NavigationDataVectors(std::vector<std::vector<mitk::NavigationData::Pointer> >()), m_NumberOfTools(numberOfTools)
+  : m_ToolNames(numberOfTools), m_NumberOfTimeSteps(0), m_NumberOfTools(numberOfTools)
 {
 }
 
@@ -37,35 +39,117 @@ bool mitk::NavigationDataSet::AddNavigationDatas( std::vector<mitk::NavigationDa
   }
 
   // test for consistent timestamp
-  if ( m_NavigationDataVectors.size() > 0)
+  if ( m_NumberOfTimeSteps > 0)
   {
     for (std::vector<mitk::NavigationData::Pointer>::size_type i = 0; i < navigationDatas.size(); i++)
-      if (navigationDatas[i]->GetIGTTimeStamp() <= m_NavigationDataVectors.back()[i]->GetIGTTimeStamp())
+      if (navigationDatas[i]->GetIGTTimeStamp() <= this->GetIGTTimeStamp(m_NumberOfTimeSteps - 1, i))
       {
         MITK_WARN("NavigationDataSet") << "IGTTimeStamp of new NavigationData should be newer than timestamp of last NavigationData.";
         return false;
       }
   }
+  else
+  {
+    for (unsigned int i = 0; i < m_NumberOfTools; i++)
+      m_ToolNames[i] = navigationDatas[i]->GetName();
+  }
+
+  for (unsigned int i = 0; i < m_NumberOfTools; i++)
+  {
+    const mitk::NavigationData* nd = navigationDatas[i];
+    m_IGTTimeStamps.push_back(nd->GetIGTTimeStamp());
+    m_Positions.push_back(nd->GetPosition());
+    m_Orientations.push_back(nd->GetOrientation());
+    m_Flags.push_back(GetFlags(nd));
+    m_CovErrorMatrixIndices.push_back(AddCovErrorMatrix(m_CovErrorMatrices, m_CovErrorMatrixIndices, m_NumberOfTools, nd->GetCovErrorMatrix()));
+  }
 
-  m_NavigationDataVectors.push_back(navigationDatas);
+  ++m_NumberOfTimeSteps;
   return true;
 }
 
+unsigned char mitk::NavigationDataSet::GetFlags( const mitk::NavigationData* navigationData )
+{
+  unsigned char flags = 0;
+  if (navigationData->IsDataValid()) flags |= DataValidFlag;
+  if (navigationData->GetHasPosition()) flags |= HasPositionFlag;
+  if (navigationData->GetHasOrientation()) flags |= HasOrientationFlag;
+  return flags;
+}
+
+unsigned int mitk::NavigationDataSet::AddCovErrorMatrix( std::vector<mitk::NavigationData::CovarianceMatrixType>& matrices,
+  const std::vector<unsigned int>& indices, unsigned int numberOfTools, const mitk::NavigationData::CovarianceMatrixType& matrix )
+{
+  // the index of the same tool in the previous time step
+  if (numberOfTools > 0 && indices.size() >= numberOfTools && matrices[indices[indices.size() - numberOfTools]] == matrix)
+    return indices[indices.size() - numberOfTools];
+
+  if (matrices.empty() || !(matrices.back() == matrix))
+    matrices.push_back(matrix);
+  return matrices.size() - 1;
+}
+
 mitk::NavigationData::Pointer mitk::NavigationDataSet::GetNavigationDataForIndex( unsigned int index, unsigned int toolIndex ) const
 {
-  if ( index >= m_NavigationDataVectors.size() )
+  if ( index >= m_NumberOfTimeSteps )
   {
     MITK_WARN("NavigationDataSet") << "There is no NavigationData available at index " << index << ".";
     return nullptr;
   }
 
-  if ( toolIndex >= m_NavigationDataVectors.at(index).size() )
+  if ( toolIndex >= m_NumberOfTools )
   {
     MITK_WARN("NavigationDataSet") << "There is NavigatitionData available at index " << index << " for tool " << toolIndex << ".";
     return nullptr;
   }
 
-  return m_NavigationDataVectors.at(index).at(toolIndex);
+  mitk::NavigationData::Pointer result = mitk::NavigationData::New();
+  this->CopyNavigationData(index, toolIndex, result);
+  return result;
+}
+
+void mitk::NavigationDataSet::CopyNavigationData( unsigned int index, unsigned int toolIndex, mitk::NavigationData* navigationData ) const
+{
+  std::vector<NavigationData::TimeStampType>::size_type i = static_cast<std::vector<NavigationData::TimeStampType>::size_type>(index) * m_NumberOfTools + toolIndex;
+  navigationData->SetIGTTimeStamp(m_IGTTimeStamps[i]);
+  navigationData->SetPosition(m_Positions[i]);
+  navigationData->SetOrientation(m_Orientations[i]);
+  navigationData->SetDataValid((m_Flags[i] & DataValidFlag) != 0);
+  navigationData->SetHasPosition((m_Flags[i] & HasPositionFlag) != 0);
+  navigationData->SetHasOrientation((m_Flags[i] & HasOrientationFlag) != 0);
+  navigationData->SetCovErrorMatrix(m_CovErrorMatrices[m_CovErrorMatrixIndices[i]]);
+  navigationData->SetName(m_ToolNames[toolIndex]);
+}
+
+mitk::NavigationData::TimeStampType mitk::NavigationDataSet::GetIGTTimeStamp( unsigned int index, unsigned int toolIndex ) const
+{
+  return m_IGTTimeStamps[static_cast<std::vector<NavigationData::TimeStampType>::size_type>(index) * m_NumberOfTools + toolIndex];
+}
+
+unsigned int mitk::NavigationDataSet::GetIndexForIGTTimeStamp( mitk::NavigationData::TimeStampType timestamp, unsigned int toolIndex ) const
+{
+  // find the first time step which is newer than the given timestamp
+  unsigned int first = 0;
+  unsigned int count = m_NumberOfTimeSteps;
+  while (count > 0)
+  {
+    unsigned int step = count / 2;
+    if (this->GetIGTTimeStamp(first + step, toolIndex) <= timestamp)
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+  return first > 0 ? first - 1 : 0;
+}
+
+std::string mitk::NavigationDataSet::GetToolName( unsigned int toolIndex ) const
+{
+  return toolIndex < m_ToolNames.size() ? m_ToolNames[toolIndex] : std::string();
 }
 
 // Method not yet supported, code below compiles but delivers wrong results
@@ -109,15 +193,31 @@ std::vector< mitk::NavigationData::Pointer > mitk::NavigationDataSet::GetDataStr
 
   std::vector< mitk::NavigationData::Pointer > result;
 
-  for(std::vector<std::vector<NavigationData::Pointer> >::size_type i = 0; i < m_NavigationDataVectors.size(); i++)
-    result.push_back(m_NavigationDataVectors[i][toolIndex]);
+  result.reserve(m_NumberOfTimeSteps);
+
+  for(unsigned int i = 0; i < m_NumberOfTimeSteps; i++)
+  {
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    this->CopyNavigationData(i, toolIndex, nd);
+    result.push_back(nd);
+  }
 
   return result;
 }
 
 std::vector< mitk::NavigationData::Pointer > mitk::NavigationDataSet::GetTimeStep(unsigned int index) const
 {
-  return m_NavigationDataVectors[index];
+  std::vector< mitk::NavigationData::Pointer > result;
+  result.reserve(m_NumberOfTools);
+
+  for (unsigned int toolIndex = 0; toolIndex < m_NumberOfTools; toolIndex++)
+  {
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    this->CopyNavigationData(index, toolIndex, nd);
+    result.push_back(nd);
+  }
+
+  return result;
 }
 
 unsigned int mitk::NavigationDataSet::GetNumberOfTools() const
@@ -127,7 +227,7 @@ unsigned int mitk::NavigationDataSet::GetNumberOfTools() const
 
 unsigned int mitk::NavigationDataSet::Size() const
 {
-  return m_NavigationDataVectors.size();
+  return m_NumberOfTimeSteps;
 }
 
 // ---> methods necessary for BaseData
@@ -161,10 +261,12 @@ void mitk::NavigationDataSet::ConvertNavigationDataToPointSet() const
   {
     mitk::PointSet::Pointer _tempPointSet = mitk::PointSet::New();
     //iterate over all time steps
-    for (unsigned int time = 0; time < m_NavigationDataVectors.size(); time++)
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    for (unsigned int time = 0; time < m_NumberOfTimeSteps; time++)
     {
-      _tempPointSet->InsertPoint(time,m_NavigationDataVectors[time][toolIndex]->GetPosition());
-      MITK_DEBUG << m_NavigationDataVectors[time][toolIndex]->GetPosition() << " --- " << _tempPointSet->GetPoint(time);
+      this->CopyNavigationData(time, toolIndex, nd);
+      _tempPointSet->InsertPoint(time,nd->GetPosition());
+      MITK_DEBUG << nd->GetPosition() << " --- " << _tempPointSet->GetPoint(time);
     }
     mitk::DataNode::Pointer dn = mitk::DataNode::New();
     std::stringstream str;
@@ -181,10 +283,18 @@ void mitk::NavigationDataSet::ConvertNavigationDataToPointSet() const
 
 mitk::NavigationDataSet::NavigationDataSetConstIterator mitk::NavigationDataSet::Begin() const
 {
-  return m_NavigationDataVectors.cbegin();
+  return NavigationDataSetConstIterator(this, 0);
 }
 
 mitk::NavigationDataSet::NavigationDataSetConstIterator mitk::NavigationDataSet::End() const
 {
-  return m_NavigationDataVectors.cend();
+  return NavigationDataSetConstIterator(this, m_NumberOfTimeSteps);
+}
+
+mitk::NavigationDataSet::TimeStepIterator::reference mitk::NavigationDataSet::TimeStepIterator::operator*() const
+{
+  // the time step is only created once per position of the iterator
+  if (m_TimeStep.empty())
+    m_TimeStep = m_Set->GetTimeStep(m_Index);
+  return m_TimeStep;
 }
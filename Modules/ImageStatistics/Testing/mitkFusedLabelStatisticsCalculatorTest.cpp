@@ -0,0 +1,368 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkExtendedLabelStatisticsImageFilter.h>
+#include <mitkFusedLabelStatisticsCalculator.h>
+#include <mitkMinMaxLabelmageFilterWithIndex.h>
+
+#include <itkTimeProbe.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Test class for mitkFusedLabelStatisticsCalculator
+ *
+ * Compares the fused statistics with the filter chain used before (MinMaxLabelImageFilterWithIndex and
+ * ExtendedLabelStatisticsImageFilter), for pixel types whose values are counted during the sweep and for those which
+ * are binned in a second pass, and measures both for a 150 label atlas.
+ */
+class mitkFusedLabelStatisticsCalculatorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkFusedLabelStatisticsCalculatorTestSuite);
+  MITK_TEST(Compute_EqualsLabelStatisticsFilters);
+  MITK_TEST(Compute_BinSize_EqualsLabelStatisticsFilters);
+  MITK_TEST(Compute_WithoutLabelImage_WholeImageIsLabel1);
+  MITK_TEST(Compute_MultipleInputs_EqualSeparateComputation);
+  MITK_TEST(Compute_FloatImage_EqualsLabelStatisticsFilters);
+  MITK_TEST(Compute_AllTimeSteps_EqualsLabelStatisticsFilters);
+  MITK_TEST(Compute_Performance);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<short, 3> ImageType;
+  typedef itk::Image<unsigned short, 3> LabelImageType;
+  typedef mitk::FusedLabelStatisticsCalculator<ImageType, LabelImageType> CalculatorType;
+  typedef itk::MinMaxLabelImageFilterWithIndex<ImageType, LabelImageType> MinMaxFilterType;
+  typedef itk::ExtendedLabelStatisticsImageFilter<ImageType, LabelImageType> StatisticsFilterType;
+  typedef itk::Image<float, 3> FloatImageType;
+
+  template <typename TImage>
+  typename TImage::Pointer CreateImage(unsigned int size, unsigned int seed, double scale = 1.0)
+  {
+    typedef typename TImage::PixelType PixelType;
+
+    typename TImage::Pointer image = TImage::New();
+    typename TImage::SizeType imageSize;
+    imageSize.Fill(size);
+    image->SetRegions(imageSize);
+    image->Allocate();
+
+    std::srand(seed);
+    PixelType *buffer = image->GetBufferPointer();
+    for (std::size_t i = 0; i < image->GetBufferedRegion().GetNumberOfPixels(); ++i)
+    {
+      // limited range, so that min and max occur several times
+      buffer[i] = static_cast<PixelType>((std::rand() % 2000 - 500) * scale);
+    }
+
+    return image;
+  }
+
+  ImageType::Pointer CreateImage(unsigned int size, unsigned int seed)
+  {
+    return this->CreateImage<ImageType>(size, seed);
+  }
+
+  /** Times the calculator and the filter chain on the same time steps and checks that they yield the same statistics */
+  template <typename TImage>
+  void MeasureAgainstFilters(const std::string &pixelTypeName, double scale)
+  {
+    typedef mitk::FusedLabelStatisticsCalculator<TImage, LabelImageType> FusedCalculatorType;
+
+    const unsigned int numberOfTimeSteps = 5;
+    LabelImageType::Pointer labelImage = this->CreateLabelImage(96);
+    std::vector<typename TImage::Pointer> images;
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      images.push_back(this->CreateImage<TImage>(96, 20 + t, scale));
+    }
+
+    itk::TimeProbe calculatorProbe;
+    std::vector<typename FusedCalculatorType::Pointer> calculators;
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      calculatorProbe.Start();
+      typename FusedCalculatorType::Pointer calculator = FusedCalculatorType::New();
+      calculator->AddInput(images[t], labelImage);
+      calculator->Compute();
+      calculatorProbe.Stop();
+      calculators.push_back(calculator);
+    }
+
+    itk::TimeProbe filterProbe;
+    std::vector<typename itk::ExtendedLabelStatisticsImageFilter<TImage, LabelImageType>::Pointer> statisticsFilters;
+    std::vector<typename itk::MinMaxLabelImageFilterWithIndex<TImage, LabelImageType>::Pointer> minMaxFilters(numberOfTimeSteps);
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      filterProbe.Start();
+      statisticsFilters.push_back(this->RunFilters<TImage>(images[t], labelImage, false, minMaxFilters[t]));
+      filterProbe.Stop();
+    }
+
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      this->CompareWithFilters<TImage>(calculators[t]->GetStatistics(), statisticsFilters[t], minMaxFilters[t]);
+    }
+
+    MITK_INFO << "Statistics of 150 labels in " << numberOfTimeSteps << " time steps of 96^3 " << pixelTypeName
+              << " voxels: " << calculatorProbe.GetTotal() * 1000.0 << " ms (FusedLabelStatisticsCalculator), "
+              << filterProbe.GetTotal() * 1000.0 << " ms (MinMaxLabelImageFilterWithIndex + ExtendedLabelStatisticsImageFilter)";
+  }
+
+  /** Atlas of 8x8x8 blocks with labels 0 to 149 */
+  LabelImageType::Pointer CreateLabelImage(unsigned int size)
+  {
+    LabelImageType::Pointer labelImage = LabelImageType::New();
+    LabelImageType::SizeType imageSize;
+    imageSize.Fill(size);
+    labelImage->SetRegions(imageSize);
+    labelImage->Allocate();
+
+    unsigned short *buffer = labelImage->GetBufferPointer();
+    for (unsigned int z = 0; z < size; ++z)
+      for (unsigned int y = 0; y < size; ++y)
+        for (unsigned int x = 0; x < size; ++x)
+          *buffer++ = static_cast<unsigned short>((x / 8 + 7 * (y / 8) + 31 * (z / 8)) % 150);
+
+    return labelImage;
+  }
+
+  template <typename TImage>
+  typename itk::ExtendedLabelStatisticsImageFilter<TImage, LabelImageType>::Pointer RunFilters(TImage *image,
+    LabelImageType *labelImage,
+    bool useBinSize,
+    typename itk::MinMaxLabelImageFilterWithIndex<TImage, LabelImageType>::Pointer &minMaxFilter)
+  {
+    typedef itk::MinMaxLabelImageFilterWithIndex<TImage, LabelImageType> MinMaxFilterType;
+    typedef itk::ExtendedLabelStatisticsImageFilter<TImage, LabelImageType> StatisticsFilterType;
+    typedef typename TImage::PixelType PixelType;
+
+    minMaxFilter = MinMaxFilterType::New();
+    minMaxFilter->SetInput(image);
+    minMaxFilter->SetLabelInput(labelImage);
+    minMaxFilter->UpdateLargestPossibleRegion();
+
+    std::map<unsigned short, PixelType> minVals;
+    std::map<unsigned short, PixelType> maxVals;
+    std::map<unsigned short, unsigned int> nBins;
+    for (unsigned short label : minMaxFilter->GetRelevantLabels())
+    {
+      minVals[label] = minMaxFilter->GetMin(label);
+      maxVals[label] = minMaxFilter->GetMax(label);
+      nBins[label] = useBinSize ? std::max(std::ceil(static_cast<double>(maxVals[label] - minVals[label])) / 3.0, 10.) : 100;
+    }
+
+    typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
+    statisticsFilter->SetInput(image);
+    statisticsFilter->SetLabelInput(labelImage);
+    statisticsFilter->SetHistogramParametersForLabels(nBins, minVals, maxVals);
+    statisticsFilter->Update();
+
+    return statisticsFilter;
+  }
+
+  template <typename TImage>
+  void CompareWithFilters(const typename mitk::FusedLabelStatisticsCalculator<TImage, LabelImageType>::LabelStatisticsMapType &statistics,
+                          itk::ExtendedLabelStatisticsImageFilter<TImage, LabelImageType> *statisticsFilter,
+                          itk::MinMaxLabelImageFilterWithIndex<TImage, LabelImageType> *minMaxFilter)
+  {
+    std::list<int> labels = statisticsFilter->GetRelevantLabels();
+    CPPUNIT_ASSERT_EQUAL(labels.size(), statistics.size());
+
+    for (int label : labels)
+    {
+      auto it = statistics.find(static_cast<unsigned short>(label));
+      CPPUNIT_ASSERT(it != statistics.end());
+      const auto &labelStatistics = it->second;
+
+      CPPUNIT_ASSERT_EQUAL(static_cast<double>(statisticsFilter->GetCount(label)), static_cast<double>(labelStatistics.Count));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetMinimum(label), labelStatistics.Minimum, mitk::eps);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetMaximum(label), labelStatistics.Maximum, mitk::eps);
+      CPPUNIT_ASSERT(minMaxFilter->GetMinIndex(label) == labelStatistics.MinimumIndex);
+      CPPUNIT_ASSERT(minMaxFilter->GetMaxIndex(label) == labelStatistics.MaximumIndex);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetMean(label), labelStatistics.Mean, 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetMPP(label), labelStatistics.MPP, 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetVariance(label), labelStatistics.Variance, 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetSkewness(label), labelStatistics.Skewness, 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetKurtosis(label), labelStatistics.Kurtosis, 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetMedian(label), labelStatistics.Median, mitk::eps);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetEntropy(label), labelStatistics.Entropy, mitk::eps);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(statisticsFilter->GetUniformity(label), labelStatistics.Uniformity, mitk::eps);
+
+      auto histogram = statisticsFilter->GetHistogram(label);
+      CPPUNIT_ASSERT_EQUAL(histogram->Size(), labelStatistics.Histogram->Size());
+      for (unsigned int bin = 0; bin < histogram->Size(); ++bin)
+      {
+        CPPUNIT_ASSERT_EQUAL(histogram->GetFrequency(bin), labelStatistics.Histogram->GetFrequency(bin));
+      }
+    }
+  }
+
+public:
+  void Compute_EqualsLabelStatisticsFilters()
+  {
+    ImageType::Pointer image = this->CreateImage(48, 1);
+    LabelImageType::Pointer labelImage = this->CreateLabelImage(48);
+
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->AddInput(image, labelImage);
+    calculator->Compute();
+
+    MinMaxFilterType::Pointer minMaxFilter;
+    StatisticsFilterType::Pointer statisticsFilter = this->RunFilters<ImageType>(image, labelImage, false, minMaxFilter);
+
+    this->CompareWithFilters<ImageType>(calculator->GetStatistics(), statisticsFilter, minMaxFilter);
+  }
+
+  void Compute_BinSize_EqualsLabelStatisticsFilters()
+  {
+    ImageType::Pointer image = this->CreateImage(40, 2);
+    LabelImageType::Pointer labelImage = this->CreateLabelImage(40);
+
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->AddInput(image, labelImage);
+    calculator->SetBinSize(3.0);
+    calculator->SetUseBinSize(true);
+    calculator->Compute();
+
+    MinMaxFilterType::Pointer minMaxFilter;
+    StatisticsFilterType::Pointer statisticsFilter = this->RunFilters<ImageType>(image, labelImage, true, minMaxFilter);
+
+    this->CompareWithFilters<ImageType>(calculator->GetStatistics(), statisticsFilter, minMaxFilter);
+  }
+
+  void Compute_WithoutLabelImage_WholeImageIsLabel1()
+  {
+    ImageType::Pointer image = this->CreateImage(20, 3);
+
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->AddInput(image);
+    calculator->Compute();
+
+    const CalculatorType::LabelStatisticsMapType &statistics = calculator->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), statistics.size());
+    CPPUNIT_ASSERT(statistics.begin()->first == 1);
+
+    const CalculatorType::LabelStatistics &labelStatistics = statistics.begin()->second;
+    CPPUNIT_ASSERT_EQUAL(static_cast<double>(20 * 20 * 20), static_cast<double>(labelStatistics.Count));
+
+    double sum = 0;
+    short minimum = image->GetBufferPointer()[0];
+    for (std::size_t i = 0; i < labelStatistics.Count; ++i)
+    {
+      sum += image->GetBufferPointer()[i];
+      minimum = std::min(minimum, image->GetBufferPointer()[i]);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(sum / labelStatistics.Count, labelStatistics.Mean, 1e-9);
+    CPPUNIT_ASSERT_EQUAL(minimum, labelStatistics.Minimum);
+    CPPUNIT_ASSERT_EQUAL(minimum, image->GetPixel(labelStatistics.MinimumIndex));
+  }
+
+  void Compute_MultipleInputs_EqualSeparateComputation()
+  {
+    LabelImageType::Pointer labelImage = this->CreateLabelImage(32);
+    std::vector<ImageType::Pointer> images;
+    for (unsigned int t = 0; t < 3; ++t)
+    {
+      images.push_back(this->CreateImage(32, 10 + t));
+    }
+
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    for (unsigned int t = 0; t < images.size(); ++t)
+    {
+      CPPUNIT_ASSERT_EQUAL(t, calculator->AddInput(images[t], labelImage));
+    }
+    calculator->Compute();
+
+    for (unsigned int t = 0; t < images.size(); ++t)
+    {
+      CalculatorType::Pointer separateCalculator = CalculatorType::New();
+      separateCalculator->AddInput(images[t], labelImage);
+      separateCalculator->Compute();
+
+      const CalculatorType::LabelStatisticsMapType &expected = separateCalculator->GetStatistics();
+      const CalculatorType::LabelStatisticsMapType &actual = calculator->GetStatistics(t);
+      CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+
+      for (const auto &labelStatistics : expected)
+      {
+        const CalculatorType::LabelStatistics &actualStatistics = actual.find(labelStatistics.first)->second;
+        CPPUNIT_ASSERT_EQUAL(labelStatistics.second.Count, actualStatistics.Count);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(labelStatistics.second.Mean, actualStatistics.Mean, 1e-9);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(labelStatistics.second.Median, actualStatistics.Median, mitk::eps);
+        CPPUNIT_ASSERT(labelStatistics.second.MaximumIndex == actualStatistics.MaximumIndex);
+      }
+    }
+
+    CPPUNIT_ASSERT_THROW(calculator->GetStatistics(3), mitk::Exception);
+  }
+
+  void Compute_FloatImage_EqualsLabelStatisticsFilters()
+  {
+    typedef mitk::FusedLabelStatisticsCalculator<FloatImageType, LabelImageType> FloatCalculatorType;
+
+    FloatImageType::Pointer image = this->CreateImage<FloatImageType>(40, 4, 0.37);
+    LabelImageType::Pointer labelImage = this->CreateLabelImage(40);
+
+    FloatCalculatorType::Pointer calculator = FloatCalculatorType::New();
+    calculator->AddInput(image, labelImage);
+    calculator->Compute();
+
+    itk::MinMaxLabelImageFilterWithIndex<FloatImageType, LabelImageType>::Pointer minMaxFilter;
+    itk::ExtendedLabelStatisticsImageFilter<FloatImageType, LabelImageType>::Pointer statisticsFilter =
+      this->RunFilters<FloatImageType>(image, labelImage, false, minMaxFilter);
+
+    this->CompareWithFilters<FloatImageType>(calculator->GetStatistics(), statisticsFilter, minMaxFilter);
+  }
+
+  void Compute_AllTimeSteps_EqualsLabelStatisticsFilters()
+  {
+    const unsigned int numberOfTimeSteps = 4;
+    LabelImageType::Pointer labelImage = this->CreateLabelImage(64);
+    std::vector<ImageType::Pointer> images;
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      images.push_back(this->CreateImage(64, 20 + t));
+    }
+
+    CalculatorType::Pointer calculator = CalculatorType::New();
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      calculator->AddInput(images[t], labelImage);
+    }
+    calculator->Compute();
+
+    for (unsigned int t = 0; t < numberOfTimeSteps; ++t)
+    {
+      MinMaxFilterType::Pointer minMaxFilter;
+      StatisticsFilterType::Pointer statisticsFilter = this->RunFilters<ImageType>(images[t], labelImage, false, minMaxFilter);
+      this->CompareWithFilters<ImageType>(calculator->GetStatistics(t), statisticsFilter, minMaxFilter);
+    }
+  }
+
+  void Compute_Performance()
+  {
+    this->MeasureAgainstFilters<ImageType>("short", 1.0);
+    this->MeasureAgainstFilters<FloatImageType>("float", 0.37);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFusedLabelStatisticsCalculator)
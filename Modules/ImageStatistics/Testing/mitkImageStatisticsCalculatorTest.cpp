@@ -70,6 +70,7 @@ class mitkImageStatisticsCalculatorTestSuite : public mitk::TestFixture
   MITK_TEST(TestUS4DCylImageMaskStatistics_time1_label_1);
   MITK_TEST(TestUS4DCylImageMaskStatistics_time2_label_1);
   MITK_TEST(TestUS4DCylImageMaskStatistics_time1_label_2);
+  MITK_TEST(TestUS4DCylImageMaskStatistics_allTimeSteps);
   MITK_TEST(TestUS4DCylIgnorePixelValueMaskStatistics_time1);
   MITK_TEST(TestUS4DCylSecondaryMaskStatistics_time1);
   CPPUNIT_TEST_SUITE_END();
@@ -113,6 +114,7 @@ public:
   void TestUS4DCylImageMaskStatistics_time1_label_1();
   void TestUS4DCylImageMaskStatistics_time2_label_1();
   void TestUS4DCylImageMaskStatistics_time1_label_2();
+  void TestUS4DCylImageMaskStatistics_allTimeSteps();
   void TestUS4DCylIgnorePixelValueMaskStatistics_time1();
   void TestUS4DCylSecondaryMaskStatistics_time1();
 
@@ -1463,6 +1465,40 @@ void mitkImageStatisticsCalculatorTestSuite::TestUS4DCylImageMaskStatistics_time
 }
 
 
+void mitkImageStatisticsCalculatorTestSuite::TestUS4DCylImageMaskStatistics_allTimeSteps()
+{
+    MITK_INFO << std::endl << "Test US4D image mask all time steps:-----------------------------------------------------------------------------------";
+
+    mitk::ImageMaskGenerator::Pointer imgMask1 = mitk::ImageMaskGenerator::New();
+    imgMask1->SetInputImage(m_US4DImage);
+    imgMask1->SetImageMask(m_US4DImageMask);
+
+    mitk::ImageStatisticsCalculator::Pointer imgStatCalc = mitk::ImageStatisticsCalculator::New();
+    imgStatCalc->SetInputImage(m_US4DImage);
+    imgStatCalc->SetMask(imgMask1.GetPointer());
+
+    // every request computes only its time step, switching between time steps and labels of one calculator has to
+    // yield the same values as separate calculators (see the time1/time2 tests above)
+    mitk::ImageStatisticsCalculator::StatisticsContainer::Pointer time2Label1 = imgStatCalc->GetStatistics(2, 1);
+    mitk::ImageStatisticsCalculator::StatisticsContainer::Pointer time1Label1 = imgStatCalc->GetStatistics(1, 1);
+    mitk::ImageStatisticsCalculator::StatisticsContainer::Pointer time1Label2 = imgStatCalc->GetStatistics(1, 2);
+
+    MITK_TEST_CONDITION(time2Label1->GetN() == 891, "time 2 label 1: calculated N: " << time2Label1->GetN() << " expected N: 891");
+    MITK_TEST_CONDITION(std::abs(time2Label1->GetMean() - 167.97194163860831) < mitk::eps, "time 2 label 1: calculated mean: " << time2Label1->GetMean());
+    MITK_TEST_CONDITION(std::abs(time2Label1->GetMedian() - 184.39499664306641) < mitk::eps, "time 2 label 1: calculated median: " << time2Label1->GetMedian());
+    MITK_TEST_CONDITION(std::abs(time2Label1->GetEntropy() - 5.1857604214916506) < mitk::eps, "time 2 label 1: calculated entropy: " << time2Label1->GetEntropy());
+
+    MITK_TEST_CONDITION(time1Label1->GetN() == 716, "time 1 label 1: calculated N: " << time1Label1->GetN() << " expected N: 716");
+    MITK_TEST_CONDITION(std::abs(time1Label1->GetMean() - 169.58938547486034) < mitk::eps, "time 1 label 1: calculated mean: " << time1Label1->GetMean());
+    MITK_TEST_CONDITION(std::abs(time1Label1->GetMedian() - 187.44000244140625) < mitk::eps, "time 1 label 1: calculated median: " << time1Label1->GetMedian());
+    MITK_TEST_CONDITION(std::abs(time1Label1->GetEntropy() - 5.0082903903398677) < mitk::eps, "time 1 label 1: calculated entropy: " << time1Label1->GetEntropy());
+
+    MITK_TEST_CONDITION(time1Label2->GetN() == 2287, "time 1 label 2: calculated N: " << time1Label2->GetN() << " expected N: 2287");
+    MITK_TEST_CONDITION(std::abs(time1Label2->GetMean() - 20.624836029733274) < mitk::eps, "time 1 label 2: calculated mean: " << time1Label2->GetMean());
+    MITK_TEST_CONDITION(std::abs(time1Label2->GetMedian() - 20.010000228881836) < mitk::eps, "time 1 label 2: calculated median: " << time1Label2->GetMedian());
+    MITK_TEST_CONDITION(std::abs(time1Label2->GetEntropy() - 5.0822234230119001) < mitk::eps, "time 1 label 2: calculated entropy: " << time1Label2->GetEntropy());
+}
+
 void mitkImageStatisticsCalculatorTestSuite::TestUS4DCylIgnorePixelValueMaskStatistics_time1()
 {
     MITK_INFO << std::endl << "Test US4D ignore zero pixels:-----------------------------------------------------------------------------------";
@@ -0,0 +1,229 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKFUSEDLABELSTATISTICSCALCULATOR_H
+#define MITKFUSEDLABELSTATISTICSCALCULATOR_H
+
+#include <itkHistogram.h>
+#include <itkImage.h>
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+
+#include <limits>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+namespace mitk
+{
+/**
+ * @brief Computes the statistics of all labels of one or more label images in a single multi-threaded sweep.
+ *
+ * This is the engine behind ImageStatisticsCalculator. It replaces the chain of MinMaxLabelImageFilterWithIndex and
+ * ExtendedLabelStatisticsImageFilter, which walks the voxels once per filter, and yields the same values:
+ * - a single sweep accumulates count, sum, the sums of the powers up to 4, the positive pixels and min/max with their
+ *   (first) index for all labels at once,
+ * - the range of the per label histograms is only known after the sweep. For integer pixel types of at most 16 bit, the
+ *   sweep counts the pixels per value and label, and the counts are sorted into the histogram bins afterwards without
+ *   reading the images again. The values of other pixel types (e.g. int or float) are not buffered, since this would
+ *   copy the whole image; their pixels are binned in a second multi-threaded pass over the same blocks instead.
+ *
+ * The voxels are split into one contiguous block per thread. Every block has its own accumulators, which are reduced
+ * in block order at the end, so the result does not depend on the scheduling of the threads.
+ *
+ * Several pairs of image and label image can be added, e.g. all time steps of a 4D image. All of them are processed
+ * in the same sweep and the statistics are returned per input. Without a label image, all pixels of an input belong
+ * to label 1. Label images have to be of an unsigned integer pixel type of at most 16 bit (the mask type used in this
+ * module) and must have the same buffered region size as their image.
+ */
+template <typename TInputImage, typename TLabelImage>
+class FusedLabelStatisticsCalculator: public itk::Object
+    {
+    public:
+        /** Standard Self typedef */
+        typedef FusedLabelStatisticsCalculator      Self;
+        typedef itk::Object                         Superclass;
+        typedef itk::SmartPointer< Self >           Pointer;
+        typedef itk::SmartPointer< const Self >     ConstPointer;
+
+        /** Method for creation through the object factory. */
+        itkNewMacro(Self)
+
+        /** Runtime information support. */
+        itkTypeMacro(FusedLabelStatisticsCalculator, itk::Object)
+
+        typedef typename TInputImage::PixelType     PixelType;
+        typedef typename TInputImage::IndexType     IndexType;
+        typedef typename TLabelImage::PixelType     LabelPixelType;
+        typedef double                              RealType;
+        typedef itk::Statistics::Histogram<double>  HistogramType;
+
+        static_assert(std::numeric_limits<LabelPixelType>::is_integer && !std::numeric_limits<LabelPixelType>::is_signed && sizeof(LabelPixelType) <= 2,
+                      "FusedLabelStatisticsCalculator supports unsigned integer labels of at most 16 bit");
+
+        /**
+         * @brief Statistics of one label, see ExtendedLabelStatisticsImageFilter for the definitions.
+         */
+        struct LabelStatistics
+        {
+            itk::SizeValueType Count;
+            itk::SizeValueType PositivePixelCount;
+            RealType Sum;
+            RealType SumOfPositivePixels;
+            RealType SumOfSquares;
+            RealType SumOfCubes;
+            RealType SumOfQuadruples;
+
+            PixelType Minimum;
+            PixelType Maximum;
+            IndexType MinimumIndex;
+            IndexType MaximumIndex;
+
+            RealType Mean;
+            RealType MPP;
+            RealType Variance;
+            RealType Sigma;
+            RealType Skewness;
+            RealType Kurtosis;
+            RealType Median;
+            RealType Entropy;
+            RealType Uniformity;
+            RealType UPP;
+
+            typename HistogramType::Pointer Histogram;
+        };
+
+        typedef std::map<LabelPixelType, LabelStatistics> LabelStatisticsMapType;
+
+        /**
+         * @brief Adds an image and its label image. Without label image, all pixels belong to label 1.
+         * @return the number of the input, to be passed to GetStatistics()
+         */
+        unsigned int AddInput(const TInputImage* image, const TLabelImage* labelImage = nullptr);
+
+        /**
+         * @brief Removes all inputs and results
+         */
+        void ClearInputs();
+
+        /**
+         * @brief Number of histogram bins of each label, used unless UseBinSize is set
+         */
+        itkSetMacro(NumberOfBins, unsigned int)
+        itkGetConstMacro(NumberOfBins, unsigned int)
+
+        /**
+         * @brief If UseBinSize is set, the number of bins of each label is ceil(max - min) / BinSize, but at least 10
+         */
+        itkSetMacro(BinSize, double)
+        itkGetConstMacro(BinSize, double)
+        itkSetMacro(UseBinSize, bool)
+        itkGetConstMacro(UseBinSize, bool)
+
+        /**
+         * @brief Computes the statistics of all labels of all inputs
+         */
+        void Compute();
+
+        /**
+         * @brief Statistics of all labels that occur in input @a input, sorted by label
+         */
+        const LabelStatisticsMapType& GetStatistics(unsigned int input = 0) const;
+
+    protected:
+        FusedLabelStatisticsCalculator();
+
+        ~FusedLabelStatisticsCalculator(){}
+
+    private:
+        struct Input
+        {
+            typename TInputImage::ConstPointer Image;
+            typename TLabelImage::ConstPointer LabelImage;
+            itk::SizeValueType NumberOfPixels;
+            itk::SizeValueType FirstPixel; // position within all inputs
+        };
+
+        struct Accumulator
+        {
+            unsigned int Input;
+            LabelPixelType Label;
+            itk::SizeValueType Count;
+            itk::SizeValueType PositivePixelCount;
+            RealType Sum;
+            RealType SumOfPositivePixels;
+            RealType SumOfSquares;
+            RealType SumOfCubes;
+            RealType SumOfQuadruples;
+            PixelType Minimum;
+            PixelType Maximum;
+            itk::OffsetValueType MinimumOffset;
+            itk::OffsetValueType MaximumOffset;
+        };
+
+        struct Binning
+        {
+            RealType LowerBound;
+            RealType UpperBound;
+            RealType BinWidth;
+            std::vector<RealType> BinMinimums;
+
+            std::size_t GetBin(RealType value) const;
+        };
+
+        /** Pixel values of one label within a block, see RecordValue() */
+        struct ValueRecord
+        {
+            long long LowestValue;
+            std::vector<itk::SizeValueType> Counts; // number of pixels with value LowestValue + i
+        };
+
+        /** Whether the pixel values are counted per value during the sweep (true_type) or binned in a second pass (false_type) */
+        typedef std::integral_constant<bool, std::numeric_limits<PixelType>::is_integer && sizeof(PixelType) <= 2> CountValuesType;
+
+        /** Contiguous range of pixels of all inputs, processed by one thread */
+        struct Block
+        {
+            itk::SizeValueType Begin;
+            itk::SizeValueType End;
+            std::vector<std::vector<int>> SlotOfLabel; // per input, lazily allocated
+            std::vector<Accumulator> Accumulators;
+            std::vector<ValueRecord> Values;           // per slot
+            std::vector<const Binning*> Binnings;      // per slot
+            std::vector<std::vector<itk::SizeValueType>> Frequencies; // per slot
+        };
+
+        void AccumulateBlock(Block& block) const;
+        void BinValuesOfBlock(Block& block, std::true_type) const;
+        void BinValuesOfBlock(Block& block, std::false_type) const;
+
+        static void RecordValue(ValueRecord& record, PixelType value, std::true_type);
+        static void RecordValue(ValueRecord&, PixelType, std::false_type) {}
+
+        static void Merge(Accumulator& accumulator, const Accumulator& other);
+
+        std::vector<Input> m_Inputs;
+        std::vector<LabelStatisticsMapType> m_Statistics;
+
+        unsigned int m_NumberOfBins;
+        double m_BinSize;
+        bool m_UseBinSize;
+    };
+}
+
+#include "mitkFusedLabelStatisticsCalculator.hxx"
+
+#endif
@@ -0,0 +1,455 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKFUSEDLABELSTATISTICSCALCULATOR_HXX
+#define MITKFUSEDLABELSTATISTICSCALCULATOR_HXX
+
+#include <mitkFusedLabelStatisticsCalculator.h>
+#include <mitkHistogramStatisticsCalculator.h>
+#include <mitkExceptionMacro.h>
+
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace mitk
+{
+    template <typename TInputImage, typename TLabelImage>
+    FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::FusedLabelStatisticsCalculator():
+        m_NumberOfBins(100),
+        m_BinSize(10),
+        m_UseBinSize(false)
+    {
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    unsigned int FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::AddInput(const TInputImage* image, const TLabelImage* labelImage)
+    {
+        if (image == nullptr)
+        {
+            mitkThrow() << "FusedLabelStatisticsCalculator: image must not be null";
+        }
+
+        if (labelImage != nullptr && labelImage->GetBufferedRegion().GetSize() != image->GetBufferedRegion().GetSize())
+        {
+            mitkThrow() << "FusedLabelStatisticsCalculator: label image does not match the size of the image";
+        }
+
+        Input input;
+        input.Image = image;
+        input.LabelImage = labelImage;
+        input.NumberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+        input.FirstPixel = m_Inputs.empty() ? 0 : m_Inputs.back().FirstPixel + m_Inputs.back().NumberOfPixels;
+        m_Inputs.push_back(input);
+
+        this->Modified();
+        return m_Inputs.size() - 1;
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::ClearInputs()
+    {
+        m_Inputs.clear();
+        m_Statistics.clear();
+        this->Modified();
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    const typename FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::LabelStatisticsMapType&
+    FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::GetStatistics(unsigned int input) const
+    {
+        if (input >= m_Statistics.size())
+        {
+            mitkThrow() << "FusedLabelStatisticsCalculator: no statistics for input " << input << ", call Compute() first";
+        }
+
+        return m_Statistics[input];
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    std::size_t FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::Binning::GetBin(RealType value) const
+    {
+        const std::size_t lastBin = BinMinimums.size() - 1;
+        if (!(BinWidth > 0) || value >= UpperBound)
+        {
+            return lastBin;
+        }
+
+        // the arithmetic guess is corrected against the bin boundaries of the histogram, so that every value ends up
+        // in the same bin as with itk::Statistics::Histogram::GetIndex()
+        const RealType guess = std::floor((value - LowerBound) / BinWidth);
+        std::size_t bin = guess <= 0 ? 0 : std::min(static_cast<std::size_t>(guess), lastBin);
+
+        while (bin > 0 && value < BinMinimums[bin])
+        {
+            --bin;
+        }
+        while (bin < lastBin && value >= BinMinimums[bin + 1])
+        {
+            ++bin;
+        }
+
+        return bin;
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::Merge(Accumulator& accumulator, const Accumulator& other)
+    {
+        accumulator.Count += other.Count;
+        accumulator.PositivePixelCount += other.PositivePixelCount;
+        accumulator.Sum += other.Sum;
+        accumulator.SumOfPositivePixels += other.SumOfPositivePixels;
+        accumulator.SumOfSquares += other.SumOfSquares;
+        accumulator.SumOfCubes += other.SumOfCubes;
+        accumulator.SumOfQuadruples += other.SumOfQuadruples;
+
+        // ties are resolved towards the first occurrence, like a serial scan would do
+        if (other.Minimum < accumulator.Minimum || (other.Minimum == accumulator.Minimum && other.MinimumOffset < accumulator.MinimumOffset))
+        {
+            accumulator.Minimum = other.Minimum;
+            accumulator.MinimumOffset = other.MinimumOffset;
+        }
+        if (other.Maximum > accumulator.Maximum || (other.Maximum == accumulator.Maximum && other.MaximumOffset < accumulator.MaximumOffset))
+        {
+            accumulator.Maximum = other.Maximum;
+            accumulator.MaximumOffset = other.MaximumOffset;
+        }
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::AccumulateBlock(Block& block) const
+    {
+        const std::size_t numberOfLabelValues = static_cast<std::size_t>(std::numeric_limits<LabelPixelType>::max()) + 1;
+
+        for (unsigned int inputNumber = 0; inputNumber < m_Inputs.size(); ++inputNumber)
+        {
+            const Input& input = m_Inputs[inputNumber];
+            const itk::SizeValueType begin = std::max(block.Begin, input.FirstPixel);
+            const itk::SizeValueType end = std::min(block.End, input.FirstPixel + input.NumberOfPixels);
+            if (begin >= end)
+            {
+                continue;
+            }
+
+            std::vector<int>& slotOfLabel = block.SlotOfLabel[inputNumber];
+            slotOfLabel.assign(numberOfLabelValues, -1);
+
+            const PixelType* pixels = input.Image->GetBufferPointer();
+            const LabelPixelType* labels = input.LabelImage.IsNotNull() ? input.LabelImage->GetBufferPointer() : nullptr;
+
+            const itk::OffsetValueType firstOffset = begin - input.FirstPixel;
+            const itk::OffsetValueType endOffset = end - input.FirstPixel;
+            for (itk::OffsetValueType offset = firstOffset; offset < endOffset; ++offset)
+            {
+                const PixelType pixel = pixels[offset];
+                const LabelPixelType label = labels != nullptr ? labels[offset] : 1;
+
+                int& slot = slotOfLabel[label];
+                if (slot < 0)
+                {
+                    Accumulator accumulator = Accumulator();
+                    accumulator.Input = inputNumber;
+                    accumulator.Label = label;
+                    accumulator.Minimum = pixel;
+                    accumulator.Maximum = pixel;
+                    accumulator.MinimumOffset = offset;
+                    accumulator.MaximumOffset = offset;
+
+                    slot = static_cast<int>(block.Accumulators.size());
+                    block.Accumulators.push_back(accumulator);
+                    block.Values.push_back(ValueRecord());
+                }
+
+                RecordValue(block.Values[slot], pixel, CountValuesType());
+
+                Accumulator& accumulator = block.Accumulators[slot];
+                const RealType value = static_cast<RealType>(pixel);
+                const RealType square = value * value;
+
+                ++accumulator.Count;
+                accumulator.Sum += value;
+                accumulator.SumOfSquares += square;
+                accumulator.SumOfCubes += square * value;
+                accumulator.SumOfQuadruples += square * square;
+
+                if (value > 0)
+                {
+                    ++accumulator.PositivePixelCount;
+                    accumulator.SumOfPositivePixels += value;
+                }
+
+                if (pixel < accumulator.Minimum)
+                {
+                    accumulator.Minimum = pixel;
+                    accumulator.MinimumOffset = offset;
+                }
+                if (pixel > accumulator.Maximum)
+                {
+                    accumulator.Maximum = pixel;
+                    accumulator.MaximumOffset = offset;
+                }
+            }
+        }
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::RecordValue(ValueRecord& record, PixelType pixel, std::true_type)
+    {
+        const long long value = static_cast<long long>(pixel);
+        if (record.Counts.empty())
+        {
+            record.LowestValue = value;
+            record.Counts.assign(1, 0);
+        }
+
+        // the table grows by at least its current size, so that it is not moved for every new extreme value
+        if (value < record.LowestValue)
+        {
+            const std::size_t missing = std::max<std::size_t>(record.LowestValue - value, record.Counts.size());
+            record.Counts.insert(record.Counts.begin(), missing, 0);
+            record.LowestValue -= missing;
+        }
+        const std::size_t position = static_cast<std::size_t>(value - record.LowestValue);
+        if (position >= record.Counts.size())
+        {
+            record.Counts.resize(std::max(position + 1, 2 * record.Counts.size()), 0);
+        }
+
+        ++record.Counts[position];
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::BinValuesOfBlock(Block& block, std::true_type) const
+    {
+        block.Frequencies.resize(block.Accumulators.size());
+        for (std::size_t slot = 0; slot < block.Accumulators.size(); ++slot)
+        {
+            std::vector<itk::SizeValueType>& frequencies = block.Frequencies[slot];
+            frequencies.assign(block.Binnings[slot]->BinMinimums.size(), 0);
+
+            const ValueRecord& record = block.Values[slot];
+            for (std::size_t position = 0; position < record.Counts.size(); ++position)
+            {
+                if (record.Counts[position] > 0)
+                {
+                    frequencies[block.Binnings[slot]->GetBin(static_cast<RealType>(record.LowestValue + static_cast<long long>(position)))] += record.Counts[position];
+                }
+            }
+
+            // the counts are not needed anymore
+            block.Values[slot] = ValueRecord();
+        }
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::BinValuesOfBlock(Block& block, std::false_type) const
+    {
+        block.Frequencies.resize(block.Accumulators.size());
+        for (std::size_t slot = 0; slot < block.Accumulators.size(); ++slot)
+        {
+            block.Frequencies[slot].assign(block.Binnings[slot]->BinMinimums.size(), 0);
+        }
+
+        // second pass over the pixels of the block, the labels are mapped to the slots of the first one
+        for (unsigned int inputNumber = 0; inputNumber < m_Inputs.size(); ++inputNumber)
+        {
+            const Input& input = m_Inputs[inputNumber];
+            const itk::SizeValueType begin = std::max(block.Begin, input.FirstPixel);
+            const itk::SizeValueType end = std::min(block.End, input.FirstPixel + input.NumberOfPixels);
+            if (begin >= end)
+            {
+                continue;
+            }
+
+            const std::vector<int>& slotOfLabel = block.SlotOfLabel[inputNumber];
+            const PixelType* pixels = input.Image->GetBufferPointer();
+            const LabelPixelType* labels = input.LabelImage.IsNotNull() ? input.LabelImage->GetBufferPointer() : nullptr;
+
+            const itk::OffsetValueType endOffset = end - input.FirstPixel;
+            for (itk::OffsetValueType offset = begin - input.FirstPixel; offset < endOffset; ++offset)
+            {
+                const int slot = slotOfLabel[labels != nullptr ? labels[offset] : 1];
+                ++block.Frequencies[slot][block.Binnings[slot]->GetBin(static_cast<RealType>(pixels[offset]))];
+            }
+        }
+    }
+
+    template <typename TInputImage, typename TLabelImage>
+    void FusedLabelStatisticsCalculator<TInputImage, TLabelImage>::Compute()
+    {
+        m_Statistics.assign(m_Inputs.size(), LabelStatisticsMapType());
+        if (m_Inputs.empty())
+        {
+            return;
+        }
+
+        const itk::SizeValueType numberOfPixels = m_Inputs.back().FirstPixel + m_Inputs.back().NumberOfPixels;
+
+        // one block per thread, but do not bother threads with tiny images
+        const itk::SizeValueType minimumPixelsPerBlock = 65536;
+        const itk::SizeValueType numberOfBlocks = std::max<itk::SizeValueType>(1,
+            std::min<itk::SizeValueType>(itk::MultiThreader::GetGlobalDefaultNumberOfThreads(), numberOfPixels / minimumPixelsPerBlock));
+
+        std::vector<Block> blocks(numberOfBlocks);
+        for (itk::SizeValueType i = 0; i < numberOfBlocks; ++i)
+        {
+            blocks[i].Begin = numberOfPixels * i / numberOfBlocks;
+            blocks[i].End = numberOfPixels * (i + 1) / numberOfBlocks;
+            blocks[i].SlotOfLabel.resize(m_Inputs.size());
+        }
+
+        const int numberOfBlocksInt = static_cast<int>(numberOfBlocks);
+
+        // sweep over the pixels: moments, extrema and, for small integer types, the values for the histograms
+#pragma omp parallel for schedule(dynamic) if (numberOfBlocksInt > 1)
+        for (int i = 0; i < numberOfBlocksInt; ++i)
+        {
+            this->AccumulateBlock(blocks[i]);
+        }
+
+        std::vector<std::map<LabelPixelType, Accumulator>> accumulators(m_Inputs.size());
+        for (const Block& block : blocks)
+        {
+            for (const Accumulator& accumulator : block.Accumulators)
+            {
+                auto inserted = accumulators[accumulator.Input].insert(std::make_pair(accumulator.Label, accumulator));
+                if (!inserted.second)
+                {
+                    Merge(inserted.first->second, accumulator);
+                }
+            }
+        }
+
+        // histogram ranges of every label are known now
+        std::vector<std::map<LabelPixelType, Binning>> binnings(m_Inputs.size());
+        for (unsigned int inputNumber = 0; inputNumber < m_Inputs.size(); ++inputNumber)
+        {
+            for (const auto& labelAccumulator : accumulators[inputNumber])
+            {
+                const Accumulator& accumulator = labelAccumulator.second;
+
+                unsigned int numberOfBins = std::max(m_NumberOfBins, 1u);
+                if (m_UseBinSize)
+                {
+                    numberOfBins = static_cast<unsigned int>(std::max(static_cast<double>(std::ceil(accumulator.Maximum - accumulator.Minimum)) / m_BinSize, 10.)); // do not allow less than 10 bins
+                }
+
+                LabelStatistics statistics = LabelStatistics();
+                statistics.Histogram = HistogramType::New();
+                typename HistogramType::SizeType size(1);
+                typename HistogramType::MeasurementVectorType lowerBound(1);
+                typename HistogramType::MeasurementVectorType upperBound(1);
+                size[0] = numberOfBins;
+                lowerBound[0] = accumulator.Minimum;
+                upperBound[0] = accumulator.Maximum;
+                statistics.Histogram->SetMeasurementVectorSize(1);
+                statistics.Histogram->Initialize(size, lowerBound, upperBound);
+                m_Statistics[inputNumber].insert(std::make_pair(labelAccumulator.first, statistics));
+
+                Binning& binning = binnings[inputNumber][labelAccumulator.first];
+                binning.LowerBound = lowerBound[0];
+                binning.UpperBound = upperBound[0];
+                binning.BinWidth = (upperBound[0] - lowerBound[0]) / numberOfBins;
+                binning.BinMinimums.resize(numberOfBins);
+                for (unsigned int bin = 0; bin < numberOfBins; ++bin)
+                {
+                    binning.BinMinimums[bin] = statistics.Histogram->GetBinMin(0, bin);
+                }
+            }
+        }
+
+        for (Block& block : blocks)
+        {
+            block.Binnings.resize(block.Accumulators.size());
+            for (std::size_t slot = 0; slot < block.Accumulators.size(); ++slot)
+            {
+                const Accumulator& accumulator = block.Accumulators[slot];
+                block.Binnings[slot] = &binnings[accumulator.Input][accumulator.Label];
+            }
+        }
+
+        // sort the counted values or the pixels into the bins
+#pragma omp parallel for schedule(dynamic) if (numberOfBlocksInt > 1)
+        for (int i = 0; i < numberOfBlocksInt; ++i)
+        {
+            this->BinValuesOfBlock(blocks[i], CountValuesType());
+        }
+
+        for (const Block& block : blocks)
+        {
+            for (std::size_t slot = 0; slot < block.Accumulators.size(); ++slot)
+            {
+                const Accumulator& accumulator = block.Accumulators[slot];
+                HistogramType* histogram = m_Statistics[accumulator.Input][accumulator.Label].Histogram;
+
+                const std::vector<itk::SizeValueType>& frequencies = block.Frequencies[slot];
+                for (std::size_t bin = 0; bin < frequencies.size(); ++bin)
+                {
+                    if (frequencies[bin] > 0)
+                    {
+                        histogram->IncreaseFrequency(bin, frequencies[bin]);
+                    }
+                }
+            }
+        }
+
+        // derived statistics, same formulas as ExtendedLabelStatisticsImageFilter
+        for (unsigned int inputNumber = 0; inputNumber < m_Inputs.size(); ++inputNumber)
+        {
+            for (auto& labelStatistics : m_Statistics[inputNumber])
+            {
+                const Accumulator& accumulator = accumulators[inputNumber][labelStatistics.first];
+                LabelStatistics& statistics = labelStatistics.second;
+
+                statistics.Count = accumulator.Count;
+                statistics.PositivePixelCount = accumulator.PositivePixelCount;
+                statistics.Sum = accumulator.Sum;
+                statistics.SumOfPositivePixels = accumulator.SumOfPositivePixels;
+                statistics.SumOfSquares = accumulator.SumOfSquares;
+                statistics.SumOfCubes = accumulator.SumOfCubes;
+                statistics.SumOfQuadruples = accumulator.SumOfQuadruples;
+                statistics.Minimum = accumulator.Minimum;
+                statistics.Maximum = accumulator.Maximum;
+                statistics.MinimumIndex = m_Inputs[inputNumber].Image->ComputeIndex(accumulator.MinimumOffset);
+                statistics.MaximumIndex = m_Inputs[inputNumber].Image->ComputeIndex(accumulator.MaximumOffset);
+
+                const RealType count = static_cast<RealType>(statistics.Count);
+                statistics.Mean = statistics.Sum / count;
+                statistics.MPP = statistics.SumOfPositivePixels / static_cast<RealType>(statistics.PositivePixelCount);
+                statistics.Variance = (statistics.SumOfSquares - statistics.Sum * statistics.Sum / count) / count;
+                statistics.Sigma = std::sqrt(statistics.Variance);
+
+                const RealType secondMoment = statistics.SumOfSquares / count;
+                const RealType thirdMoment = statistics.SumOfCubes / count;
+                const RealType fourthMoment = statistics.SumOfQuadruples / count;
+                const RealType mean = statistics.Mean;
+                statistics.Skewness = (thirdMoment - 3. * secondMoment * mean + 2. * std::pow(mean, 3.)) / std::pow(secondMoment - std::pow(mean, 2.), 1.5);
+                statistics.Kurtosis = (fourthMoment - 4. * thirdMoment * mean + 6. * secondMoment * std::pow(mean, 2.) - 3. * std::pow(mean, 4.)) / std::pow(secondMoment - std::pow(mean, 2.), 2.);
+
+                mitk::HistogramStatisticsCalculator histStatCalc;
+                histStatCalc.SetHistogram(statistics.Histogram);
+                histStatCalc.CalculateStatistics();
+                statistics.Median = histStatCalc.GetMedian();
+                statistics.Entropy = histStatCalc.GetEntropy();
+                statistics.Uniformity = histStatCalc.GetUniformity();
+                statistics.UPP = histStatCalc.GetUPP();
+            }
+        }
+    }
+}
+
+#endif
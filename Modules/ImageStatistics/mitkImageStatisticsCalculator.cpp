@@ -18,11 +18,8 @@
 #include <mitkHistogramStatisticsCalculator.h>
 #include <mitkImageAccessByItk.h>
 #include <mitkImageToItk.h>
-#include <mitkExtendedStatisticsImageFilter.h>
-#include <mitkExtendedLabelStatisticsImageFilter.h>
+#include <mitkFusedLabelStatisticsCalculator.h>
 #include <mitkImageTimeSelector.h>
-#include <mitkMinMaxImageFilterWithIndex.h>
-#include <mitkMinMaxLabelmageFilterWithIndex.h>
 #include <mitkitkMaskImageFilter.h>
 #include <mitkImageCast.h>
 
@@ -34,6 +31,29 @@
 
 namespace mitk
 {
+    namespace
+    {
+        template <typename TLabelStatistics>
+        void SetStatisticsOfLabel(ImageStatisticsCalculator::StatisticsContainer* statisticsResult, const TLabelStatistics& labelStatistics)
+        {
+            statisticsResult->SetN(labelStatistics.Count);
+            statisticsResult->SetMean(labelStatistics.Mean);
+            statisticsResult->SetMin(labelStatistics.Minimum);
+            statisticsResult->SetMax(labelStatistics.Maximum);
+            statisticsResult->SetVariance(labelStatistics.Variance);
+            statisticsResult->SetStd(labelStatistics.Sigma);
+            statisticsResult->SetSkewness(labelStatistics.Skewness);
+            statisticsResult->SetKurtosis(labelStatistics.Kurtosis);
+            statisticsResult->SetRMS(std::sqrt(std::pow(labelStatistics.Mean, 2.) + labelStatistics.Variance)); // variance = sigma^2
+            statisticsResult->SetMPP(labelStatistics.MPP);
+
+            statisticsResult->SetEntropy(labelStatistics.Entropy);
+            statisticsResult->SetMedian(labelStatistics.Median);
+            statisticsResult->SetUniformity(labelStatistics.Uniformity);
+            statisticsResult->SetUPP(labelStatistics.UPP);
+            statisticsResult->SetHistogram(labelStatistics.Histogram);
+        }
+    }
 
     void ImageStatisticsCalculator::SetInputImage(mitk::Image::Pointer image)
     {
@@ -130,6 +150,11 @@ namespace mitk
 
         if (IsUpdateRequired(timeStep))
         {
+            // only the requested time step is computed, so that a single time slice and its masks are held in memory
+            m_InternalImageForStatistics = m_Image;
+            m_InternalMask = nullptr;
+            m_SecondaryMask = nullptr;
+
             if (m_MaskGenerator.IsNotNull())
             {
                 m_MaskGenerator->SetTimeStep(timeStep);
@@ -138,20 +163,29 @@ namespace mitk
                 {
                     m_InternalImageForStatistics = m_MaskGenerator->GetReferenceImage();
                 }
-                else
-                {
-                    m_InternalImageForStatistics = m_Image;
-                }
-            }
-            else
-            {
-                m_InternalImageForStatistics = m_Image;
             }
 
             if (m_SecondaryMaskGenerator.IsNotNull())
             {
                 m_SecondaryMaskGenerator->SetTimeStep(timeStep);
                 m_SecondaryMask = m_SecondaryMaskGenerator->GetMask();
+
+                // dirty workaround for a bug when pf mask + any other mask is used in conjunction. We need a proper fix for this (Fabian Isensee is responsible and probably working on it!)
+                if (m_InternalMask.IsNotNull() && m_InternalMask->GetDimension() == 2 && (m_SecondaryMask->GetDimension() == 3 || m_SecondaryMask->GetDimension() == 4))
+                {
+                    mitk::Image::Pointer old_img = m_SecondaryMaskGenerator->GetReferenceImage();
+                    m_SecondaryMaskGenerator->SetInputImage(m_MaskGenerator->GetReferenceImage());
+                    m_SecondaryMask = m_SecondaryMaskGenerator->GetMask();
+                    m_SecondaryMaskGenerator->SetInputImage(old_img);
+                }
+            }
+
+            // workaround: if m_SecondaryMaskGenerator ist not null but m_MaskGenerator is! (this is the case if we request a 'ignore zuero valued pixels'
+            // mask in the gui but do not define a primary mask)
+            if (m_SecondaryMask.IsNotNull() && m_InternalMask.IsNull())
+            {
+                m_InternalMask = m_SecondaryMask;
+                m_SecondaryMask = nullptr;
             }
 
             ImageTimeSelector::Pointer imgTimeSel = ImageTimeSelector::New();
@@ -160,7 +194,6 @@ namespace mitk
             imgTimeSel->UpdateLargestPossibleRegion();
             m_ImageTimeSlice = imgTimeSel->GetOutput();
 
-
             // Calculate statistics with/without mask
             if (m_MaskGenerator.IsNull() && m_SecondaryMaskGenerator.IsNull())
             {
@@ -174,12 +207,13 @@ namespace mitk
                 AccessByItk_1(m_ImageTimeSlice, InternalCalculateStatisticsMasked, timeStep)
             }
 
+            m_ImageTimeSlice = nullptr;
+            m_InternalMask = nullptr;
+            m_SecondaryMask = nullptr;
 
-            //this->Modified();
+            m_StatisticsUpdateTimePerTimeStep[timeStep] = m_StatisticsByTimeStep[timeStep][m_StatisticsByTimeStep[timeStep].size()-1]->GetMTime();
         }
 
-        m_StatisticsUpdateTimePerTimeStep[timeStep] = m_StatisticsByTimeStep[timeStep][m_StatisticsByTimeStep[timeStep].size()-1]->GetMTime();
-
         for (std::vector<StatisticsContainer::Pointer>::iterator it = m_StatisticsByTimeStep[timeStep].begin(); it != m_StatisticsByTimeStep[timeStep].end(); ++it)
         {
             StatisticsContainer::Pointer statCont = *it;
@@ -198,88 +232,37 @@ namespace mitk
             typename itk::Image< TPixel, VImageDimension >* image, unsigned int timeStep)
     {
         typedef typename itk::Image< TPixel, VImageDimension > ImageType;
-        typedef typename itk::ExtendedStatisticsImageFilter<ImageType> ImageStatisticsFilterType;
-        typedef typename itk::MinMaxImageFilterWithIndex<ImageType> MinMaxFilterType;
-
-        StatisticsContainer::Pointer statisticsResult = StatisticsContainer::New();
-
-        typename ImageStatisticsFilterType::Pointer statisticsFilter = ImageStatisticsFilterType::New();
-        statisticsFilter->SetInput(image);
-        statisticsFilter->SetCoordinateTolerance(0.001);
-        statisticsFilter->SetDirectionTolerance(0.001);
-
-        // TODO: this is single threaded. Implement our own image filter that does this multi threaded
-//        typename itk::MinimumMaximumImageCalculator<ImageType>::Pointer imgMinMaxFilter = itk::MinimumMaximumImageCalculator<ImageType>::New();
-//        imgMinMaxFilter->SetImage(image);
-//        imgMinMaxFilter->Compute();
-        vnl_vector<int> minIndex, maxIndex;
+        typedef itk::Image< MaskPixelType, VImageDimension > MaskType;
+        typedef FusedLabelStatisticsCalculator< ImageType, MaskType > StatisticsCalculatorType;
 
-        typename MinMaxFilterType::Pointer minMaxFilter = MinMaxFilterType::New();
-        minMaxFilter->SetInput(image);
-        minMaxFilter->UpdateLargestPossibleRegion();
-        typename ImageType::PixelType minval = minMaxFilter->GetMin();
-        typename ImageType::PixelType maxval = minMaxFilter->GetMax();
+        // no mask, therefore just one label = the whole image
+        typename StatisticsCalculatorType::Pointer statisticsCalculator = StatisticsCalculatorType::New();
+        statisticsCalculator->AddInput(image);
+        statisticsCalculator->SetNumberOfBins(m_nBinsForHistogramStatistics);
+        statisticsCalculator->SetBinSize(m_binSizeForHistogramStatistics);
+        statisticsCalculator->SetUseBinSize(m_UseBinSizeOverNBins);
+        statisticsCalculator->Compute();
 
-        typename ImageType::IndexType tmpMinIndex = minMaxFilter->GetMinIndex();
-        typename ImageType::IndexType tmpMaxIndex = minMaxFilter->GetMaxIndex();
+        const typename StatisticsCalculatorType::LabelStatistics& labelStatistics = statisticsCalculator->GetStatistics().begin()->second;
 
-//        typename ImageType::IndexType tmpMinIndex = imgMinMaxFilter->GetIndexOfMinimum();
-//        typename ImageType::IndexType tmpMaxIndex = imgMinMaxFilter->GetIndexOfMaximum();
+        StatisticsContainer::Pointer statisticsResult = StatisticsContainer::New();
+        SetStatisticsOfLabel(statisticsResult, labelStatistics);
+        statisticsResult->SetLabel(1);
 
-        minIndex.set_size(tmpMaxIndex.GetIndexDimension());
-        maxIndex.set_size(tmpMaxIndex.GetIndexDimension());
+        vnl_vector<int> minIndex, maxIndex;
+        minIndex.set_size(VImageDimension);
+        maxIndex.set_size(VImageDimension);
 
-        for (unsigned int i=0; i < tmpMaxIndex.GetIndexDimension(); i++)
+        for (unsigned int d=0; d < VImageDimension; d++)
         {
-            minIndex[i] = tmpMinIndex[i];
-            maxIndex[i] = tmpMaxIndex[i];
+            minIndex[d] = labelStatistics.MinimumIndex[d];
+            maxIndex[d] = labelStatistics.MaximumIndex[d];
         }
 
         statisticsResult->SetMinIndex(minIndex);
         statisticsResult->SetMaxIndex(maxIndex);
 
-        //convert m_binSize in m_nBins if necessary
-        unsigned int nBinsForHistogram;
-        if (m_UseBinSizeOverNBins)
-        {
-            nBinsForHistogram = std::max(static_cast<double>(std::ceil(maxval - minval)) / m_binSizeForHistogramStatistics, 10.); // do not allow less than 10 bins
-        }
-        else
-        {
-            nBinsForHistogram = m_nBinsForHistogramStatistics;
-        }
-
-        statisticsFilter->SetHistogramParameters(nBinsForHistogram, minval, maxval);
-
-        try
-        {
-          statisticsFilter->Update();
-        }
-        catch (const itk::ExceptionObject& e)
-        {
-          mitkThrow() << "Image statistics calculation failed due to following ITK Exception: \n " << e.what();
-        }
-
-        // no mask, therefore just one label = the whole image
         m_StatisticsByTimeStep[timeStep].resize(1);
-        statisticsResult->SetLabel(1);
-        statisticsResult->SetN(image->GetLargestPossibleRegion().GetNumberOfPixels());
-        statisticsResult->SetMean(statisticsFilter->GetMean());
-        statisticsResult->SetMin(statisticsFilter->GetMinimum());
-        statisticsResult->SetMax(statisticsFilter->GetMaximum());
-        statisticsResult->SetVariance(statisticsFilter->GetVariance());
-        statisticsResult->SetStd(statisticsFilter->GetSigma());
-        statisticsResult->SetSkewness(statisticsFilter->GetSkewness());
-        statisticsResult->SetKurtosis(statisticsFilter->GetKurtosis());
-        statisticsResult->SetRMS(std::sqrt(std::pow(statisticsFilter->GetMean(), 2.) + statisticsFilter->GetVariance())); // variance = sigma^2
-        statisticsResult->SetMPP(statisticsFilter->GetMPP());
-
-        statisticsResult->SetEntropy(statisticsFilter->GetEntropy());
-        statisticsResult->SetMedian(statisticsFilter->GetMedian());
-        statisticsResult->SetUniformity(statisticsFilter->GetUniformity());
-        statisticsResult->SetUPP(statisticsFilter->GetUPP());
-        statisticsResult->SetHistogram(statisticsFilter->GetHistogram());
-
         m_StatisticsByTimeStep[timeStep][0] = statisticsResult;
     }
 
@@ -290,21 +273,8 @@ namespace mitk
     {
         typedef itk::Image< TPixel, VImageDimension > ImageType;
         typedef itk::Image< MaskPixelType, VImageDimension > MaskType;
-        typedef typename MaskType::PixelType LabelPixelType;
-        typedef itk::ExtendedLabelStatisticsImageFilter< ImageType, MaskType > ImageStatisticsFilterType;
+        typedef FusedLabelStatisticsCalculator< ImageType, MaskType > StatisticsCalculatorType;
         typedef MaskUtilities< TPixel, VImageDimension > MaskUtilType;
-        typedef typename itk::MinMaxLabelImageFilterWithIndex<ImageType, MaskType> MinMaxLabelFilterType;
-        typedef typename ImageType::PixelType InputImgPixelType;
-
-        // workaround: if m_SecondaryMaskGenerator ist not null but m_MaskGenerator is! (this is the case if we request a 'ignore zuero valued pixels'
-        // mask in the gui but do not define a primary mask)
-        bool swapMasks = false;
-        if (m_SecondaryMask.IsNotNull() && m_InternalMask.IsNull())
-        {
-            m_InternalMask = m_SecondaryMask;
-            m_SecondaryMask = nullptr;
-            swapMasks = true;
-        }
 
         // maskImage has to have the same dimension as image
         typename MaskType::Pointer maskImage = MaskType::New();
@@ -322,14 +292,6 @@ namespace mitk
         // if we have a secondary mask (say a ignoreZeroPixelMask) we need to combine the masks (corresponds to AND)
         if (m_SecondaryMask.IsNotNull())
         {
-            // dirty workaround for a bug when pf mask + any other mask is used in conjunction. We need a proper fix for this (Fabian Isensee is responsible and probably working on it!)
-            if (m_InternalMask->GetDimension() == 2 && (m_SecondaryMask->GetDimension() == 3 || m_SecondaryMask->GetDimension() == 4))
-            {
-                mitk::Image::Pointer old_img = m_SecondaryMaskGenerator->GetReferenceImage();
-                m_SecondaryMaskGenerator->SetInputImage(m_MaskGenerator->GetReferenceImage());
-                m_SecondaryMask = m_SecondaryMaskGenerator->GetMask();
-                m_SecondaryMaskGenerator->SetInputImage(old_img);
-            }
             typename MaskType::Pointer secondaryMaskImage = MaskType::New();
             secondaryMaskImage = ImageToItkImage< MaskPixelType, VImageDimension >(m_SecondaryMask);
 
@@ -352,116 +314,49 @@ namespace mitk
         maskUtil->SetMask(maskImage.GetPointer());
 
         // if mask is smaller than image, extract the image region where the mask is
-        typename ImageType::Pointer adaptedImage = ImageType::New();
-
-        adaptedImage = maskUtil->ExtractMaskImageRegion(); // this also checks mask sanity
-
-        // find min, max, minindex and maxindex
-        typename MinMaxLabelFilterType::Pointer minMaxFilter = MinMaxLabelFilterType::New();
-        minMaxFilter->SetInput(adaptedImage);
-        minMaxFilter->SetLabelInput(maskImage);
-        minMaxFilter->UpdateLargestPossibleRegion();
-
-        // set histogram parameters for each label individually (min/max may be different for each label)
-        typedef typename std::map<LabelPixelType, InputImgPixelType> MapType;
-        typedef typename std::pair<LabelPixelType, InputImgPixelType> PairType;
-
-        std::vector<LabelPixelType> relevantLabels = minMaxFilter->GetRelevantLabels();
-        MapType minVals;
-        MapType maxVals;
-        std::map<LabelPixelType, unsigned int> nBins;
-
-        for (LabelPixelType label:relevantLabels)
-        {
-            minVals.insert(PairType(label, minMaxFilter->GetMin(label)));
-            maxVals.insert(PairType(label, minMaxFilter->GetMax(label)));
-
-            unsigned int nBinsForHistogram;
-            if (m_UseBinSizeOverNBins)
-            {
-                nBinsForHistogram = std::max(static_cast<double>(std::ceil(minMaxFilter->GetMax(label) - minMaxFilter->GetMin(label))) / m_binSizeForHistogramStatistics, 10.); // do not allow less than 10 bins
-            }
-            else
-            {
-                nBinsForHistogram = m_nBinsForHistogramStatistics;
-            }
+        typename ImageType::Pointer adaptedImage = maskUtil->ExtractMaskImageRegion(); // this also checks mask sanity
 
-            nBins.insert(typename std::pair<LabelPixelType, unsigned int>(label, nBinsForHistogram));
-        }
+        // moments, min/max with index and histograms of all labels in one go
+        typename StatisticsCalculatorType::Pointer statisticsCalculator = StatisticsCalculatorType::New();
+        statisticsCalculator->AddInput(adaptedImage, maskImage);
+        statisticsCalculator->SetNumberOfBins(m_nBinsForHistogramStatistics);
+        statisticsCalculator->SetBinSize(m_binSizeForHistogramStatistics);
+        statisticsCalculator->SetUseBinSize(m_UseBinSizeOverNBins);
+        statisticsCalculator->Compute();
 
-        typename ImageStatisticsFilterType::Pointer imageStatisticsFilter = ImageStatisticsFilterType::New();
-        imageStatisticsFilter->SetDirectionTolerance(0.001);
-        imageStatisticsFilter->SetCoordinateTolerance(0.001);
-        imageStatisticsFilter->SetInput(adaptedImage);
-        imageStatisticsFilter->SetLabelInput(maskImage);
-        imageStatisticsFilter->SetHistogramParametersForLabels(nBins, minVals, maxVals);
-        imageStatisticsFilter->Update();
-
-        std::list<int> labels = imageStatisticsFilter->GetRelevantLabels();
-        std::list<int>::iterator it = labels.begin();
         m_StatisticsByTimeStep[timeStep].resize(0);
 
-        while(it != labels.end())
+        for (const auto& labelAndStatistics : statisticsCalculator->GetStatistics())
         {
-            StatisticsContainer::Pointer statisticsResult = StatisticsContainer::New();
+            const typename StatisticsCalculatorType::LabelStatistics& labelStatistics = labelAndStatistics.second;
 
-            // find min, max, minindex and maxindex
-            // make sure to only look in the masked region, use a masker for this
+            StatisticsContainer::Pointer statisticsResult = StatisticsContainer::New();
+            SetStatisticsOfLabel(statisticsResult, labelStatistics);
+            statisticsResult->SetLabel(labelAndStatistics.first);
 
             vnl_vector<int> minIndex, maxIndex;
             mitk::Point3D worldCoordinateMin;
             mitk::Point3D worldCoordinateMax;
             mitk::Point3D indexCoordinateMin;
             mitk::Point3D indexCoordinateMax;
-            m_InternalImageForStatistics->GetGeometry()->IndexToWorld(minMaxFilter->GetMinIndex(*it), worldCoordinateMin);
-            m_InternalImageForStatistics->GetGeometry()->IndexToWorld(minMaxFilter->GetMaxIndex(*it), worldCoordinateMax);
+            m_InternalImageForStatistics->GetGeometry()->IndexToWorld(labelStatistics.MinimumIndex, worldCoordinateMin);
+            m_InternalImageForStatistics->GetGeometry()->IndexToWorld(labelStatistics.MaximumIndex, worldCoordinateMax);
             m_Image->GetGeometry()->WorldToIndex(worldCoordinateMin, indexCoordinateMin);
             m_Image->GetGeometry()->WorldToIndex(worldCoordinateMax, indexCoordinateMax);
 
             minIndex.set_size(3);
             maxIndex.set_size(3);
 
-            //for (unsigned int i=0; i < tmpMaxIndex.GetIndexDimension(); i++)
-            for (unsigned int i=0; i < 3; i++)
+            for (unsigned int d=0; d < 3; d++)
             {
-                minIndex[i] = indexCoordinateMin[i];
-                maxIndex[i] = indexCoordinateMax[i];
+                minIndex[d] = indexCoordinateMin[d];
+                maxIndex[d] = indexCoordinateMax[d];
             }
 
             statisticsResult->SetMinIndex(minIndex);
             statisticsResult->SetMaxIndex(maxIndex);
 
-            assert(abs(minMaxFilter->GetMax(*it) - imageStatisticsFilter->GetMaximum(*it)) < mitk::eps);
-            assert(abs(minMaxFilter->GetMin(*it) - imageStatisticsFilter->GetMinimum(*it)) < mitk::eps);
-
-
-            statisticsResult->SetN(imageStatisticsFilter->GetSum(*it) / (double) imageStatisticsFilter->GetMean(*it));
-            statisticsResult->SetMean(imageStatisticsFilter->GetMean(*it));
-            statisticsResult->SetMin(imageStatisticsFilter->GetMinimum(*it));
-            statisticsResult->SetMax(imageStatisticsFilter->GetMaximum(*it));
-            statisticsResult->SetVariance(imageStatisticsFilter->GetVariance(*it));
-            statisticsResult->SetStd(imageStatisticsFilter->GetSigma(*it));
-            statisticsResult->SetSkewness(imageStatisticsFilter->GetSkewness(*it));
-            statisticsResult->SetKurtosis(imageStatisticsFilter->GetKurtosis(*it));
-            statisticsResult->SetRMS(std::sqrt(std::pow(imageStatisticsFilter->GetMean(*it), 2.) + imageStatisticsFilter->GetVariance(*it))); // variance = sigma^2
-            statisticsResult->SetMPP(imageStatisticsFilter->GetMPP(*it));
-            statisticsResult->SetLabel(*it);
-
-            statisticsResult->SetEntropy(imageStatisticsFilter->GetEntropy(*it));
-            statisticsResult->SetMedian(imageStatisticsFilter->GetMedian(*it));
-            statisticsResult->SetUniformity(imageStatisticsFilter->GetUniformity(*it));
-            statisticsResult->SetUPP(imageStatisticsFilter->GetUPP(*it));
-            statisticsResult->SetHistogram(imageStatisticsFilter->GetHistogram(*it));
-
             m_StatisticsByTimeStep[timeStep].push_back(statisticsResult);
-            ++it;
-        }
-
-        // swap maskGenerators back
-        if (swapMasks)
-        {
-            m_SecondaryMask = m_InternalMask;
-            m_InternalMask = nullptr;
         }
     }
 
@@ -358,7 +358,7 @@ namespace mitk
 
         /**Documentation
         @brief Returns the statistics for label @a label and timeStep @a timeStep. If these requested statistics are not computed yet the computation is done as well.
-        For performance reasons, statistics for all labels in the image are computed at once.
+        For performance reasons, statistics for all labels of the time step are computed at once, in a single multi-threaded sweep (see FusedLabelStatisticsCalculator).
          */
         StatisticsContainer::Pointer GetStatistics(unsigned int timeStep=0, unsigned int label=1);
 
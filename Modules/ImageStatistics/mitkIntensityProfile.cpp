@@ -19,60 +19,42 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkPolyLineParametricPath.h>
 #include <itkWindowedSincInterpolateImageFunction.h>
 #include <mitkImageAccessByItk.h>
-#include <mitkImagePixelReadAccessor.h>
-#include <mitkPixelTypeMultiplex.h>
+#include <mitkImagePixelSampler.h>
 #include "mitkIntensityProfile.h"
 
 using namespace mitk;
 
-template <class T>
-static void ReadPixel(const PixelType&, Image::Pointer image, const itk::Index<3>& index, ScalarType* returnValue)
-{
-  switch (image->GetDimension())
-  {
-  case 2:
-    {
-      ImagePixelReadAccessor<T, 2> readAccess(image, image->GetSliceData(0));
-      *returnValue = readAccess.GetPixelByIndex(reinterpret_cast<const itk::Index<2>&>(index));
-      break;
-    }
-
-  case 3:
-    {
-      ImagePixelReadAccessor<T, 3> readAccess(image, image->GetVolumeData(0));
-      *returnValue = readAccess.GetPixelByIndex(index);
-      break;
-    }
-
-  default:
-    *returnValue = 0;
-    break;
-  }
-}
-
 static IntensityProfile::Pointer ComputeIntensityProfile(Image::Pointer image, itk::PolyLineParametricPath<3>::Pointer path)
 {
   IntensityProfile::Pointer intensityProfile = IntensityProfile::New();
   itk::PolyLineParametricPath<3>::InputType input = path->StartOfInput();
-  BaseGeometry* imageGeometry = image->GetGeometry();
-  const PixelType pixelType = image->GetPixelType();
-
-  IntensityProfile::MeasurementVectorType measurementVector;
   itk::PolyLineParametricPath<3>::OffsetType offset;
-  Point3D worldPoint;
-  itk::Index<3> index;
+
+  // collect all positions first, so the image is accessed only once
+  std::vector<Point3D> indices;
 
   do
   {
-    imageGeometry->IndexToWorld(path->Evaluate(input), worldPoint);
-    imageGeometry->WorldToIndex(worldPoint, index);
+    const itk::PolyLineParametricPath<3>::OutputType continuousIndex = path->Evaluate(input);
 
-    mitkPixelTypeMultiplex3(ReadPixel, pixelType, image, index, measurementVector.GetDataPointer());
-    intensityProfile->PushBack(measurementVector);
+    Point3D index;
+    index[0] = continuousIndex[0];
+    index[1] = continuousIndex[1];
+    index[2] = continuousIndex[2];
+    indices.push_back(index);
 
     offset = path->IncrementInput(input);
   } while ((offset[0] | offset[1] | offset[2]) != 0);
 
+  const std::vector<ScalarType> values = ImagePixelSampler(image).SampleByIndex(indices);
+
+  IntensityProfile::MeasurementVectorType measurementVector;
+  for (auto value : values)
+  {
+    measurementVector[0] = value;
+    intensityProfile->PushBack(measurementVector);
+  }
+
   return intensityProfile;
 }
 
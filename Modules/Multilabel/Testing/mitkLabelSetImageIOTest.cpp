@@ -27,6 +27,7 @@ class mitkLabelSetImageIOTestSuite : public mitk::TestFixture
   CPPUNIT_TEST_SUITE(mitkLabelSetImageIOTestSuite);
   MITK_TEST(TestReadWrite3DLabelSetImage);
   MITK_TEST(TestReadWrite3DplusTLabelSetImage);
+  MITK_TEST(TestReadWriteLayerVisibility);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -134,6 +135,39 @@ public:
 
     itksys::SystemTools::RemoveFile(pathToImage);
   }
+
+  void TestReadWriteLayerVisibility()
+  {
+    unsigned int dimensions[3] = {64, 64, 32};
+    regularImage->Initialize(mitk::MakeScalarPixelType<int>(), 3, dimensions);
+
+    multilabelImage = mitk::LabelSetImage::New();
+    multilabelImage->Initialize(regularImage);
+    multilabelImage->AddLayer();
+    multilabelImage->AddLayer();
+    multilabelImage->SetActiveLayer(2);
+    multilabelImage->SetLayerVisibility(0, false);
+
+    pathToImage = mitk::IOUtil::CreateTemporaryDirectory();
+    pathToImage.append("/LabelSetTestImageLayerVisibility.nrrd");
+
+    mitk::IOUtil::Save(multilabelImage, pathToImage);
+
+    mitk::LabelSetImage::Pointer loadedImage =
+      dynamic_cast<mitk::LabelSetImage *>(mitk::IOUtil::Load(pathToImage)[0].GetPointer());
+
+    CPPUNIT_ASSERT_MESSAGE("Error reading label set image", loadedImage.IsNotNull());
+    CPPUNIT_ASSERT_EQUAL(multilabelImage->GetNumberOfLayers(), loadedImage->GetNumberOfLayers());
+    CPPUNIT_ASSERT_MESSAGE("Hidden layer was read as visible", !loadedImage->GetLayerVisibility(0));
+    CPPUNIT_ASSERT_MESSAGE("Visible layer was read as hidden", loadedImage->GetLayerVisibility(1));
+    CPPUNIT_ASSERT_MESSAGE("Visible layer was read as hidden", loadedImage->GetLayerVisibility(2));
+
+    loadedImage->SetActiveLayer(multilabelImage->GetActiveLayer());
+    CPPUNIT_ASSERT_MESSAGE("Hidden inactive layer is not stored sparsely", loadedImage->IsLayerStoredSparsely(0));
+    CPPUNIT_ASSERT_MESSAGE("Error reading label set image", mitk::Equal(*multilabelImage, *loadedImage, 0.0001, true));
+
+    itksys::SystemTools::RemoveFile(pathToImage);
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkLabelSetImageIO)
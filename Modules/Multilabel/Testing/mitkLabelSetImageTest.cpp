@@ -15,11 +15,19 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include <mitkIOUtil.h>
+#include <mitkImagePixelReadAccessor.h>
+#include <mitkImagePixelWriteAccessor.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
 #include <mitkImageStatisticsHolder.h>
 #include <mitkLabelSetImage.h>
+#include <mitkSparseLabelImageData.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingMacros.h>
 
+#include <algorithm>
+#include <cstring>
+
 class mitkLabelSetImageTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkLabelSetImageTestSuite);
@@ -35,6 +43,9 @@ class mitkLabelSetImageTestSuite : public mitk::TestFixture
   MITK_TEST(TestExistsLabel);
   MITK_TEST(TestExistsLabelSet);
   MITK_TEST(TestSetActiveLayer);
+  MITK_TEST(TestSetActiveLayerKeepsLayerData);
+  MITK_TEST(TestHiddenLayersAreStoredSparsely);
+  MITK_TEST(TestSparseLabelImageData);
   MITK_TEST(TestRemoveLayer);
   MITK_TEST(TestRemoveLabels);
   MITK_TEST(TestMergeLabel);
@@ -336,6 +347,149 @@ public:
                            mitk::Equal(*newlayer, *m_LabelSetImage->GetActiveLabelSet(), 0.00001, true));
   }
 
+  mitk::LabelSetImage::PixelType GetPixel(const mitk::Image *image, const itk::Index<3> &index)
+  {
+    mitk::ImagePixelReadAccessor<mitk::LabelSetImage::PixelType, 3> accessor(image);
+    return accessor.GetPixelByIndex(index);
+  }
+
+  void SetPixel(mitk::Image *image, const itk::Index<3> &index, mitk::LabelSetImage::PixelType value)
+  {
+    mitk::ImagePixelWriteAccessor<mitk::LabelSetImage::PixelType, 3> accessor(image);
+    accessor.SetPixelByIndex(index, value);
+  }
+
+  bool SharesImageData(const mitk::Image *image, const mitk::Image *other)
+  {
+    mitk::ImageReadAccessor accessor(image);
+    mitk::ImageReadAccessor otherAccessor(other);
+    return accessor.GetData() == otherAccessor.GetData();
+  }
+
+  void TestSetActiveLayerKeepsLayerData()
+  {
+    itk::Index<3> index = {{10, 20, 30}};
+    SetPixel(m_LabelSetImage, index, 7);
+
+    m_LabelSetImage->AddLayer();
+    CPPUNIT_ASSERT_MESSAGE("New layer is not empty", GetPixel(m_LabelSetImage, index) == 0);
+    CPPUNIT_ASSERT_MESSAGE("Data of inactive layer was lost", GetPixel(m_LabelSetImage->GetLayerImage(0), index) == 7);
+    SetPixel(m_LabelSetImage, index, 9);
+
+    m_LabelSetImage->SetActiveLayer(0);
+    CPPUNIT_ASSERT_MESSAGE("Wrong data after switching the layer", GetPixel(m_LabelSetImage, index) == 7);
+    CPPUNIT_ASSERT_MESSAGE("Data of inactive layer was lost", GetPixel(m_LabelSetImage->GetLayerImage(1), index) == 9);
+    CPPUNIT_ASSERT_MESSAGE("Image data is not the data of the active layer image",
+                           SharesImageData(m_LabelSetImage, m_LabelSetImage->GetLayerImage(0)));
+
+    mitk::LabelSetImage::Pointer clone = m_LabelSetImage->Clone();
+    CPPUNIT_ASSERT_MESSAGE("Clone has wrong data", GetPixel(clone, index) == 7);
+    CPPUNIT_ASSERT_MESSAGE("Clone shares data with original", !SharesImageData(clone, m_LabelSetImage));
+    SetPixel(clone, index, 3);
+    clone->SetActiveLayer(1);
+    CPPUNIT_ASSERT_MESSAGE("Clone has wrong data after switching the layer", GetPixel(clone, index) == 9);
+    CPPUNIT_ASSERT_MESSAGE("Data of inactive layer of clone was lost", GetPixel(clone->GetLayerImage(0), index) == 3);
+    CPPUNIT_ASSERT_MESSAGE("Changing the clone changed the original", GetPixel(m_LabelSetImage, index) == 7);
+
+    m_LabelSetImage->SetActiveLayer(1);
+    m_LabelSetImage->RemoveLayer();
+    CPPUNIT_ASSERT_MESSAGE("Wrong data after removing a layer", GetPixel(m_LabelSetImage, index) == 7);
+    m_LabelSetImage->RemoveLayer();
+    CPPUNIT_ASSERT_MESSAGE("Data was lost after removing all layers", GetPixel(m_LabelSetImage, index) == 7);
+  }
+
+  void TestHiddenLayersAreStoredSparsely()
+  {
+    itk::Index<3> index = {{10, 20, 30}};
+    itk::Index<3> otherIndex = {{200, 100, 300}};
+    SetPixel(m_LabelSetImage, index, 7);
+    m_LabelSetImage->AddLayer();
+    SetPixel(m_LabelSetImage, otherIndex, 9);
+
+    CPPUNIT_ASSERT_MESSAGE("Layers are not visible by default", m_LabelSetImage->GetLayerVisibility(0));
+    m_LabelSetImage->SetLayerVisibility(0, false);
+    CPPUNIT_ASSERT_MESSAGE("Hidden layer is not stored sparsely", m_LabelSetImage->IsLayerStoredSparsely(0));
+
+    m_LabelSetImage->SetLayerVisibility(1, false);
+    CPPUNIT_ASSERT_MESSAGE("Active layer is stored sparsely", !m_LabelSetImage->IsLayerStoredSparsely(1));
+
+    m_LabelSetImage->SetActiveLayer(0);
+    CPPUNIT_ASSERT_MESSAGE("Active layer is stored sparsely", !m_LabelSetImage->IsLayerStoredSparsely(0));
+    CPPUNIT_ASSERT_MESSAGE("Previously active hidden layer is not stored sparsely",
+                           m_LabelSetImage->IsLayerStoredSparsely(1));
+    CPPUNIT_ASSERT_MESSAGE("Wrong data after expanding the layer", GetPixel(m_LabelSetImage, index) == 7);
+    CPPUNIT_ASSERT_MESSAGE("Wrong data after expanding the layer", GetPixel(m_LabelSetImage, otherIndex) == 0);
+
+    mitk::LabelSetImage::Pointer clone = m_LabelSetImage->Clone();
+    CPPUNIT_ASSERT_MESSAGE("Clone does not store the hidden layer sparsely", clone->IsLayerStoredSparsely(1));
+    CPPUNIT_ASSERT_MESSAGE("Clone has wrong data in the hidden layer", GetPixel(clone->GetLayerImage(1), otherIndex) == 9);
+    CPPUNIT_ASSERT_MESSAGE("Layer image of the clone is not expanded", !clone->IsLayerStoredSparsely(1));
+    CPPUNIT_ASSERT_MESSAGE("Expanding the layer of the clone changed the original",
+                           m_LabelSetImage->IsLayerStoredSparsely(1));
+
+    CPPUNIT_ASSERT_MESSAGE("Wrong data in the hidden layer",
+                           GetPixel(m_LabelSetImage->GetLayerImage(1), otherIndex) == 9);
+    m_LabelSetImage->SetLayerVisibility(1, true);
+    CPPUNIT_ASSERT_MESSAGE("Visible layer is stored sparsely", !m_LabelSetImage->IsLayerStoredSparsely(1));
+    m_LabelSetImage->SetActiveLayer(1);
+    CPPUNIT_ASSERT_MESSAGE("Wrong data after switching the layer", GetPixel(m_LabelSetImage, otherIndex) == 9);
+  }
+
+  void TestSparseLabelImageData()
+  {
+    // a small lesion in a large volume
+    mitk::Image::Pointer layerImage = m_LabelSetImage->GetLayerImage(0);
+    for (itk::IndexValueType z = 40; z < 50; ++z)
+      for (itk::IndexValueType y = 40; y < 50; ++y)
+        for (itk::IndexValueType x = 40; x < 50; ++x)
+        {
+          itk::Index<3> index = {{x, y, z}};
+          SetPixel(layerImage, index, 5);
+        }
+
+    mitk::SparseLabelImageData sparseData(layerImage);
+    const std::size_t denseSize = 256 * 256 * 312 * sizeof(mitk::LabelSetImage::PixelType);
+    CPPUNIT_ASSERT_MESSAGE("Sparse storage is not small", sparseData.GetMemorySize() < denseSize / 100);
+
+    mitk::Image::Pointer expandedImage = layerImage->Clone();
+    {
+      mitk::ImagePixelWriteAccessor<mitk::LabelSetImage::PixelType, 3> writeAccessor(expandedImage);
+      std::fill(writeAccessor.GetData(), writeAccessor.GetData() + 256 * 256 * 312, 3);
+    }
+    sparseData.Expand(expandedImage);
+
+    mitk::ImageReadAccessor accessor(layerImage);
+    mitk::ImageReadAccessor expandedAccessor(expandedImage);
+    CPPUNIT_ASSERT_MESSAGE("Expanded image differs from the stored one",
+                           std::memcmp(accessor.GetData(), expandedAccessor.GetData(), denseSize) == 0);
+
+    // sizes which are no multiple of the tile size, several time steps and non uniform tiles
+    mitk::Image::Pointer image = mitk::Image::New();
+    unsigned int dimensions[4] = {70, 33, 5, 2};
+    image->Initialize(mitk::MakeScalarPixelType<int>(), 4, dimensions);
+    {
+      mitk::ImageWriteAccessor imageAccessor(image);
+      int *data = static_cast<int *>(imageAccessor.GetData());
+      for (int i = 0; i < 70 * 33 * 5 * 2; ++i)
+        data[i] = (i % 70 > 40 && i % 7 == 0) ? i : 0x01020304;
+    }
+
+    mitk::SparseLabelImageData sparseImageData(image);
+    mitk::Image::Pointer expandedImage4D = mitk::Image::New();
+    expandedImage4D->Initialize(mitk::MakeScalarPixelType<int>(), 4, dimensions);
+    sparseImageData.Expand(expandedImage4D);
+
+    mitk::ImageReadAccessor imageAccessor(image);
+    mitk::ImageReadAccessor expandedImageAccessor(expandedImage4D);
+    CPPUNIT_ASSERT_MESSAGE("Expanded 4D image differs from the stored one",
+                           std::memcmp(imageAccessor.GetData(), expandedImageAccessor.GetData(), 70 * 33 * 5 * 2 * sizeof(int)) == 0);
+
+    mitk::Image::Pointer wrongImage = mitk::Image::New();
+    unsigned int wrongDimensions[4] = {70, 33, 5, 1};
+    wrongImage->Initialize(mitk::MakeScalarPixelType<int>(), 4, wrongDimensions);
+    CPPUNIT_ASSERT_THROW(sparseImageData.Expand(wrongImage), mitk::Exception);
+  }
+
   void TestRemoveLayer()
   {
     // Cache active layer
@@ -192,6 +192,11 @@ namespace mitk
         itk::EncapsulateMetaData<std::string>(
           nrrdImageIo->GetMetaDataDictionary(), std::string(keybuffer), std::string(valbuffer));
 
+        sprintf(keybuffer, "org.mitk.layer_visibility_%03u", layerIdx); // visibility of the layer
+        sprintf(valbuffer, "%1d", input->GetLayerVisibility(layerIdx) ? 1 : 0);
+        itk::EncapsulateMetaData<std::string>(
+          nrrdImageIo->GetMetaDataDictionary(), std::string(keybuffer), std::string(valbuffer));
+
         mitk::LabelSet::LabelContainerConstIteratorType iter = input->GetLabelSet(layerIdx)->IteratorConstBegin();
         unsigned int count(0);
         while (iter != input->GetLabelSet(layerIdx)->IteratorConstEnd())
@@ -411,6 +416,17 @@ namespace mitk
       output->AddLabelSetToLayer(layerIdx, labelSet);
     }
 
+    // hidden layers are stored sparsely once all layers are read, files without the key show all layers
+    for (unsigned int layerIdx = 0; layerIdx < output->GetNumberOfLayers(); layerIdx++)
+    {
+      std::string visibility;
+      sprintf(keybuffer, "org.mitk.layer_visibility_%03u", layerIdx);
+      if (itk::ExposeMetaData<std::string>(dictionary, keybuffer, visibility))
+      {
+        output->SetLayerVisibility(layerIdx, atoi(visibility.c_str()) != 0);
+      }
+    }
+
     MITK_INFO << "...finished!" << std::endl;
 
     std::vector<BaseData::Pointer> result;
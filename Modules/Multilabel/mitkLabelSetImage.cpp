@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageAccessByItk.h"
 #include "mitkImageCast.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 #include "mitkInteractionConst.h"
 #include "mitkLookupTableProperty.h"
 #include "mitkPadImageFilter.h"
@@ -29,18 +30,52 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkTransformPolyDataFilter.h>
 
 #include <itkImageRegionIterator.h>
+#include <itkMutexLockHolder.h>
 #include <itkQuadEdgeMesh.h>
 #include <itkTriangleMeshToBinaryImageFilter.h>
 //#include <itkRelabelComponentImageFilter.h>
 
 #include <itkCommand.h>
 
+#include <algorithm>
+#include <cstring>
+
 template <typename TPixel, unsigned int VDimensions>
 void SetToZero(itk::Image<TPixel, VDimensions> *source)
 {
   source->FillBuffer(0);
 }
 
+namespace
+{
+  std::size_t GetImageDataSize(const mitk::Image *image)
+  {
+    std::size_t size = image->GetPixelType().GetSize();
+    for (unsigned int i = 0; i < image->GetDimension(); ++i)
+      size *= image->GetDimension(i);
+    return size;
+  }
+
+  const void *GetImageData(const mitk::Image *image)
+  {
+    mitk::ImageReadAccessor accessor(image);
+    return accessor.GetData();
+  }
+
+  // copies nothing if both images share their image data
+  void CopyImageData(const mitk::Image *source, mitk::Image *target)
+  {
+    mitk::ImageReadAccessor sourceAccessor(source);
+    mitk::ImageWriteAccessor targetAccessor(target);
+    if (sourceAccessor.GetData() != targetAccessor.GetData())
+    {
+      std::memcpy(targetAccessor.GetData(),
+                  sourceAccessor.GetData(),
+                  std::min(GetImageDataSize(source), GetImageDataSize(target)));
+    }
+  }
+}
+
 mitk::LabelSetImage::LabelSetImage()
   : mitk::Image(), m_ActiveLayer(0), m_activeLayerInvalid(false), m_ExteriorLabel(nullptr)
 {
@@ -71,9 +106,29 @@ mitk::LabelSetImage::LabelSetImage(const mitk::LabelSetImage &other)
     lsClone->AddObserver(itk::ModifiedEvent(), command);
     m_LabelSetContainer.push_back(lsClone);
 
+    m_LayerVisibility.push_back(other.GetLayerVisibility(i));
+    if (other.IsLayerStoredSparsely(i))
+    {
+      // the sparse storage is never changed, so it can be shared
+      m_LayerContainer.push_back(nullptr);
+      m_SparseLayerContainer.push_back(other.m_SparseLayerContainer[i]);
+      continue;
+    }
+
     // clone layer Image data
     mitk::Image::Pointer liClone = other.GetLayerImage(i)->Clone();
+    if (i == other.GetActiveLayer() && GetImageData(&other) != GetImageData(other.GetLayerImage(i)))
+    {
+      // the image data of other does not refer to its active layer image (any more), it is the up-to-date one
+      CopyImageData(&other, liClone);
+    }
     m_LayerContainer.push_back(liClone);
+    m_SparseLayerContainer.push_back(nullptr);
+  }
+
+  if (m_ActiveLayer < static_cast<int>(m_LayerContainer.size()))
+  {
+    this->ReferenceLayerImage(m_ActiveLayer);
   }
 }
 
@@ -134,14 +189,86 @@ mitk::LabelSetImage::~LabelSetImage()
 
 mitk::Image *mitk::LabelSetImage::GetLayerImage(unsigned int layer)
 {
+  this->ExpandLayer(layer);
   return m_LayerContainer[layer];
 }
 
 const mitk::Image *mitk::LabelSetImage::GetLayerImage(unsigned int layer) const
 {
+  this->ExpandLayer(layer);
   return m_LayerContainer[layer];
 }
 
+void mitk::LabelSetImage::SetLayerVisibility(unsigned int layer, bool visible)
+{
+  if (layer >= m_LayerVisibility.size() || m_LayerVisibility[layer] == visible)
+    return;
+
+  m_LayerVisibility[layer] = visible;
+  this->StoreHiddenLayersSparsely();
+  this->Modified();
+}
+
+bool mitk::LabelSetImage::GetLayerVisibility(unsigned int layer) const
+{
+  return layer < m_LayerVisibility.size() ? m_LayerVisibility[layer] : false;
+}
+
+bool mitk::LabelSetImage::IsLayerStoredSparsely(unsigned int layer) const
+{
+  return layer < m_SparseLayerContainer.size() && m_SparseLayerContainer[layer] != nullptr;
+}
+
+void mitk::LabelSetImage::ExpandLayer(unsigned int layer) const
+{
+  if (!this->IsLayerStoredSparsely(layer))
+    return;
+
+  mitk::Image::Pointer layerImage = mitk::Image::New();
+  layerImage->Initialize(this->GetPixelType(),
+                         this->GetDimension(),
+                         this->GetDimensions(),
+                         this->GetImageDescriptor()->GetNumberOfChannels());
+  layerImage->SetTimeGeometry(this->GetTimeGeometry()->Clone());
+  m_SparseLayerContainer[layer]->Expand(layerImage);
+
+  m_LayerContainer[layer] = layerImage;
+  m_SparseLayerContainer[layer] = nullptr;
+}
+
+void mitk::LabelSetImage::StoreHiddenLayersSparsely()
+{
+  for (unsigned int layer = 0; layer < m_LayerContainer.size(); ++layer)
+  {
+    if (!m_LayerVisibility[layer] && layer != this->GetActiveLayer() && !this->IsLayerStoredSparsely(layer))
+    {
+      m_SparseLayerContainer[layer] = std::make_shared<const SparseLabelImageData>(m_LayerContainer[layer]);
+      m_LayerContainer[layer] = nullptr;
+    }
+  }
+}
+
+void mitk::LabelSetImage::ReferenceLayerImage(unsigned int layer)
+{
+  ImageWriteAccessor layerAccessor(m_LayerContainer[layer]);
+  this->ReplaceChannelData(layerAccessor.GetData(), ReferenceMemory);
+}
+
+void mitk::LabelSetImage::ReplaceChannelData(void *data, ImportMemoryManagementType importMemoryManagement)
+{
+  {
+    // volumes and slices point into the previous channel data
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataArraysLock);
+    std::fill(m_Slices.begin(), m_Slices.end(), nullptr);
+    std::fill(m_Volumes.begin(), m_Volumes.end(), nullptr);
+    m_CompleteData = nullptr;
+  }
+
+  ImageDataItemPointer channel = this->AllocateChannelData(0, data, importMemoryManagement);
+  channel->SetComplete(true);
+  m_ImageDescriptor->GetChannelDescriptor(0).SetData(channel->GetData());
+}
+
 unsigned int mitk::LabelSetImage::GetActiveLayer() const
 {
   return m_ActiveLayer;
@@ -158,6 +285,12 @@ void mitk::LabelSetImage::RemoveLayer()
   // remove all observers from active label set
   GetLabelSet(layerToDelete)->RemoveAllObservers();
 
+  // the image data may still refer to the layer image until another layer is active
+  mitk::Image::Pointer layerImageToDelete = m_LayerContainer[layerToDelete];
+
+  // the layer is removed anyway, it does not need to be stored sparsely when another layer becomes active
+  m_LayerVisibility[layerToDelete] = true;
+
   // set the active layer to one below, if exists.
   if (layerToDelete != 0)
   {
@@ -172,12 +305,21 @@ void mitk::LabelSetImage::RemoveLayer()
   // remove labelset and image data
   m_LabelSetContainer.erase(m_LabelSetContainer.begin() + layerToDelete);
   m_LayerContainer.erase(m_LayerContainer.begin() + layerToDelete);
+  m_SparseLayerContainer.erase(m_SparseLayerContainer.begin() + layerToDelete);
+  m_LayerVisibility.erase(m_LayerVisibility.begin() + layerToDelete);
 
   if (layerToDelete == 0)
   {
     this->SetActiveLayer(layerToDelete);
   }
 
+  if (m_LayerContainer.empty())
+  {
+    // there is no layer left to refer to, keep a copy of the image data
+    ImageReadAccessor layerAccessor(layerImageToDelete);
+    this->ReplaceChannelData(const_cast<void *>(layerAccessor.GetData()), CopyMemory);
+  }
+
   this->Modified();
 }
 
@@ -206,6 +348,11 @@ unsigned int mitk::LabelSetImage::AddLayer(mitk::LabelSet::Pointer lset)
 
 unsigned int mitk::LabelSetImage::AddLayer(mitk::Image::Pointer layerImage, mitk::LabelSet::Pointer lset)
 {
+  if (layerImage->GetPixelType() != this->GetPixelType() || GetImageDataSize(layerImage) != GetImageDataSize(this))
+  {
+    mitkThrow() << "Layer image does not match the pixel type or size of the image.";
+  }
+
   unsigned int newLabelSetId = m_LayerContainer.size();
 
   // Add labelset to layer
@@ -227,6 +374,8 @@ unsigned int mitk::LabelSetImage::AddLayer(mitk::Image::Pointer layerImage, mitk
 
   // push a new working image for the new layer
   m_LayerContainer.push_back(layerImage);
+  m_SparseLayerContainer.push_back(nullptr);
+  m_LayerVisibility.push_back(true);
 
   // push a new labelset for the new layer
   m_LabelSetContainer.push_back(ls);
@@ -236,6 +385,12 @@ unsigned int mitk::LabelSetImage::AddLayer(mitk::Image::Pointer layerImage, mitk
   command->SetCallbackFunction(this, &mitk::LabelSetImage::OnLabelSetModified);
   ls->AddObserver(itk::ModifiedEvent(), command);
 
+  if (newLabelSetId == 0)
+  {
+    // the first layer is active from the start, SetActiveLayer() would not switch to it
+    this->ReferenceLayerImage(newLabelSetId);
+  }
+
   SetActiveLayer(newLabelSetId);
   // MITK_INFO << GetActiveLayer();
   this->Modified();
@@ -269,54 +424,34 @@ void mitk::LabelSetImage::AddLabelSetToLayer(const unsigned int layerIdx, const
 
 void mitk::LabelSetImage::SetActiveLayer(unsigned int layer)
 {
-  try
+  if ((layer != GetActiveLayer() || m_activeLayerInvalid) && (layer < this->GetNumberOfLayers()))
   {
-    if (4 == this->GetDimension())
+    BeforeChangeLayerEvent.Send();
+
+    if (m_activeLayerInvalid)
     {
-      if ((layer != GetActiveLayer() || m_activeLayerInvalid) && (layer < this->GetNumberOfLayers()))
-      {
-        BeforeChangeLayerEvent.Send();
-
-        if (m_activeLayerInvalid)
-        {
-          // We should not write the invalid layer back to the vector
-          m_activeLayerInvalid = false;
-        }
-        else
-        {
-          AccessFixedDimensionByItk_n(this, ImageToLayerContainerProcessing, 4, (GetActiveLayer()));
-        }
-        m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
-        AccessFixedDimensionByItk_n(this, LayerContainerToImageProcessing, 4, (GetActiveLayer()));
-
-        AfterChangeLayerEvent.Send();
-      }
+      // We should not write the invalid layer back to the vector
+      m_activeLayerInvalid = false;
     }
     else
     {
-      if ((layer != GetActiveLayer() || m_activeLayerInvalid) && (layer < this->GetNumberOfLayers()))
-      {
-        BeforeChangeLayerEvent.Send();
-
-        if (m_activeLayerInvalid)
-        {
-          // We should not write the invalid layer back to the vector
-          m_activeLayerInvalid = false;
-        }
-        else
-        {
-          AccessByItk_1(this, ImageToLayerContainerProcessing, GetActiveLayer());
-        }
-        m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
-        AccessByItk_1(this, LayerContainerToImageProcessing, GetActiveLayer());
-
-        AfterChangeLayerEvent.Send();
-      }
+      // Usually the image data is the data of the active layer image and nothing is copied. It is only copied
+      // back if it has been replaced in the meantime, e.g. by re-initializing the image.
+      CopyImageData(this, m_LayerContainer[GetActiveLayer()]);
     }
-  }
-  catch (itk::ExceptionObject &e)
-  {
-    mitkThrow() << e.GetDescription();
+    m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
+    this->ExpandLayer(GetActiveLayer());
+
+    {
+      // wait until nobody accesses the image data any more
+      ImageWriteAccessor accessor(this);
+      this->ReferenceLayerImage(GetActiveLayer());
+    }
+
+    // the previously active layer may be hidden
+    this->StoreHiddenLayersSparsely();
+
+    AfterChangeLayerEvent.Send();
   }
   this->Modified();
 }
@@ -792,57 +927,6 @@ void mitk::LabelSetImage::ConcatenateProcessing(ImageType *itkTarget, mitk::Labe
   }
 }
 
-template <typename TPixel, unsigned int VImageDimension>
-void mitk::LabelSetImage::LayerContainerToImageProcessing(itk::Image<TPixel, VImageDimension> *target,
-                                                          unsigned int layer)
-{
-  typedef itk::Image<TPixel, VImageDimension> ImageType;
-  typename ImageType::Pointer itkSource;
-  // mitk::CastToItkImage(m_LayerContainer[layer], itkSource);
-  itkSource = ImageToItkImage<TPixel, VImageDimension>(m_LayerContainer[layer]);
-  typedef itk::ImageRegionConstIterator<ImageType> SourceIteratorType;
-  typedef itk::ImageRegionIterator<ImageType> TargetIteratorType;
-
-  SourceIteratorType sourceIter(itkSource, itkSource->GetLargestPossibleRegion());
-  sourceIter.GoToBegin();
-
-  TargetIteratorType targetIter(target, target->GetLargestPossibleRegion());
-  targetIter.GoToBegin();
-
-  while (!sourceIter.IsAtEnd())
-  {
-    targetIter.Set(sourceIter.Get());
-    ++sourceIter;
-    ++targetIter;
-  }
-}
-
-template <typename TPixel, unsigned int VImageDimension>
-void mitk::LabelSetImage::ImageToLayerContainerProcessing(itk::Image<TPixel, VImageDimension> *source,
-                                                          unsigned int layer) const
-{
-  typedef itk::Image<TPixel, VImageDimension> ImageType;
-  typename ImageType::Pointer itkTarget;
-  // mitk::CastToItkImage(m_LayerContainer[layer], itkTarget);
-  itkTarget = ImageToItkImage<TPixel, VImageDimension>(m_LayerContainer[layer]);
-
-  typedef itk::ImageRegionConstIterator<ImageType> SourceIteratorType;
-  typedef itk::ImageRegionIterator<ImageType> TargetIteratorType;
-
-  SourceIteratorType sourceIter(source, source->GetLargestPossibleRegion());
-  sourceIter.GoToBegin();
-
-  TargetIteratorType targetIter(itkTarget, itkTarget->GetLargestPossibleRegion());
-  targetIter.GoToBegin();
-
-  while (!sourceIter.IsAtEnd())
-  {
-    targetIter.Set(sourceIter.Get());
-    ++sourceIter;
-    ++targetIter;
-  }
-}
-
 template <typename ImageType>
 void mitk::LabelSetImage::EraseLabelProcessing(ImageType *itkImage, PixelType pixelValue, unsigned int /*layer*/)
 {
@@ -19,15 +19,22 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkImage.h>
 #include <mitkLabelSet.h>
+#include <mitkSparseLabelImageData.h>
 
 #include <MitkMultilabelExports.h>
 
+#include <memory>
+
 namespace mitk
 {
   //##Documentation
   //## @brief LabelSetImage class for handling labels and layers in a segmentation session.
   //##
   //## Handles operations for adding, removing, erasing and editing labels and layers.
+  //## The image data of every layer is held by its layer image (see GetLayerImage()). The image data of the
+  //## LabelSetImage itself refers to the image data of the active layer image, so switching layers does not copy
+  //## any voxels. Hidden layers which are not active are not rendered, their voxels are kept in a sparse storage
+  //## (see SetLayerVisibility()).
   //## @ingroup Data
 
   class MITKMULTILABEL_EXPORT LabelSetImage : public Image
@@ -202,7 +209,10 @@ namespace mitk
     void MaskStamp(mitk::Image *mask, bool forceOverwrite);
 
     /**
-      * \brief  */
+      * \brief Makes the given layer the active one. Nothing happens if the layer does not exist.
+      *
+      * The image data is switched to the image data of the layer image in constant time.
+      */
     void SetActiveLayer(unsigned int layer);
 
     /**
@@ -218,7 +228,7 @@ namespace mitk
 
     /**
     * \brief Add a layer based on a provided mitk::Image
-    * \param layerImage is added to the vector of label images
+    * \param layerImage is added to the vector of label images, it must have the pixel type and size of this image
     * \param lset a label set that will be added to the new layer if provided
     *\return the layer ID of the new layer
     */
@@ -245,11 +255,33 @@ namespace mitk
     void RemoveLayer();
 
     /**
-      * \brief  */
+      * \brief Returns the image of the given layer.
+      *
+      * A layer held in the sparse storage is expanded to a dense layer image. It stays dense until the next call of
+      * SetActiveLayer() or SetLayerVisibility(), which store it sparsely again if it is still hidden and inactive.
+      * The returned pointer is only valid until then.
+      */
     mitk::Image *GetLayerImage(unsigned int layer);
 
     const mitk::Image *GetLayerImage(unsigned int layer) const;
 
+    /**
+      * \brief Shows or hides a layer. Hidden layers are not rendered by the LabelSetImageVtkMapper2D, unless they are
+      * the active layer.
+      *
+      * The voxels of hidden layers which are not active are not held by a dense layer image but by a
+      * SparseLabelImageData, so a hidden layer with a few small segmentations costs little memory. All layers are
+      * visible by default. The LabelSetImageIO writes the visibility to the NRRD header and restores it on reading.
+      */
+    void SetLayerVisibility(unsigned int layer, bool visible);
+
+    bool GetLayerVisibility(unsigned int layer) const;
+
+    /**
+      * \brief Returns true if the voxels of the layer are held in the sparse storage.
+      */
+    bool IsLayerStoredSparsely(unsigned int layer) const;
+
     void OnLabelSetModified();
 
     /**
@@ -276,11 +308,25 @@ namespace mitk
     template <typename ImageType1, typename ImageType2>
     void ChangeLayerProcessing(ImageType1 *source, ImageType2 *target);
 
-    template <typename TPixel, unsigned int VImageDimension>
-    void LayerContainerToImageProcessing(itk::Image<TPixel, VImageDimension> *source, unsigned int layer);
+    /**
+     * @brief Lets the image data of this image refer to the image data of the given layer image, nothing is copied.
+     */
+    void ReferenceLayerImage(unsigned int layer);
+
+    /**
+     * @brief Replaces the image data of this image and drops all volumes and slices of the previous image data.
+     */
+    void ReplaceChannelData(void *data, ImportMemoryManagementType importMemoryManagement);
 
-    template <typename TPixel, unsigned int VImageDimension>
-    void ImageToLayerContainerProcessing(itk::Image<TPixel, VImageDimension> *source, unsigned int layer) const;
+    /**
+     * @brief Expands a layer held in the sparse storage to a dense layer image.
+     */
+    void ExpandLayer(unsigned int layer) const;
+
+    /**
+     * @brief Moves the voxels of all hidden layers which are not active into the sparse storage.
+     */
+    void StoreHiddenLayersSparsely();
 
     template <typename ImageType>
     void CalculateCenterOfMassProcessing(ImageType *input, PixelType index, unsigned int layer);
@@ -310,7 +356,10 @@ namespace mitk
     void InitializeByLabeledImageProcessing(LabelSetImageType *input, ImageType *other);
 
     std::vector<LabelSet::Pointer> m_LabelSetContainer;
-    std::vector<Image::Pointer> m_LayerContainer;
+    // the layer images and the sparse storage are filled on demand, also by the const GetLayerImage()
+    mutable std::vector<Image::Pointer> m_LayerContainer;
+    mutable std::vector<std::shared_ptr<const SparseLabelImageData>> m_SparseLayerContainer;
+    std::vector<bool> m_LayerVisibility;
 
     int m_ActiveLayer;
 
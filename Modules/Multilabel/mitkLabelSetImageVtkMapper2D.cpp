@@ -149,6 +149,15 @@ void mitk::LabelSetImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer
 
   for (int lidx = 0; lidx < numberOfLayers; ++lidx)
   {
+    // hidden layers are not resliced, so their voxels can stay in the sparse storage
+    if (lidx != activeLayer && !image->GetLayerVisibility(lidx))
+    {
+      localStorage->m_ReslicedImageVector[lidx] = nullptr;
+      localStorage->m_LayerActorVector[lidx]->SetVisibility(false);
+      continue;
+    }
+    localStorage->m_LayerActorVector[lidx]->SetVisibility(true);
+
     mitk::Image *layerImage = nullptr;
 
     // set main input for ExtractSliceFilter
@@ -580,7 +589,9 @@ void mitk::LabelSetImageVtkMapper2D::TransformActor(mitk::BaseRenderer *renderer
   LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
   // get the transformation matrix of the reslicer in order to render the slice as axial, coronal or saggital
   vtkSmartPointer<vtkTransform> trans = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_ReslicerVector[0]->GetResliceAxes(); // same for all layers
+  // same for all layers, take the active one because hidden layers are not resliced
+  const mitk::LabelSetImage *image = dynamic_cast<const mitk::LabelSetImage *>(this->GetDataNode()->GetData());
+  vtkSmartPointer<vtkMatrix4x4> matrix = localStorage->m_ReslicerVector[image->GetActiveLayer()]->GetResliceAxes();
   trans->SetMatrix(matrix);
 
   for (int lidx = 0; lidx < localStorage->m_NumberOfLayers; ++lidx)
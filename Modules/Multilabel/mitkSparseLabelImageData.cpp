@@ -0,0 +1,158 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkSparseLabelImageData.h"
+
+#include <mitkExceptionMacro.h>
+#include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+
+#include <algorithm>
+#include <cstring>
+
+const unsigned int mitk::SparseLabelImageData::TileSize;
+
+template <typename TFunctor>
+void mitk::SparseLabelImageData::VisitRowsOfTile(std::size_t tile, TFunctor functor) const
+{
+  unsigned int tileIndex[4];
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    tileIndex[i] = tile % m_NumberOfTiles[i];
+    tile /= m_NumberOfTiles[i];
+  }
+
+  const unsigned int beginX = tileIndex[0] * TileSize;
+  const unsigned int endX = std::min(beginX + TileSize, m_Dimensions[0]);
+  const unsigned int beginY = tileIndex[1] * TileSize;
+  const unsigned int endY = std::min(beginY + TileSize, m_Dimensions[1]);
+  const unsigned int beginZ = tileIndex[2] * TileSize;
+  const unsigned int endZ = std::min(beginZ + TileSize, m_Dimensions[2]);
+  const unsigned int t = tileIndex[3];
+
+  for (unsigned int z = beginZ; z < endZ; ++z)
+  {
+    for (unsigned int y = beginY; y < endY; ++y)
+    {
+      const std::size_t offset =
+        ((static_cast<std::size_t>(t) * m_Dimensions[2] + z) * m_Dimensions[1] + y) * m_Dimensions[0] + beginX;
+      functor(offset, endX - beginX);
+    }
+  }
+}
+
+mitk::SparseLabelImageData::SparseLabelImageData(const mitk::Image *image) : m_PixelSize(image->GetPixelType().GetSize())
+{
+  std::size_t numberOfTiles = 1;
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    m_Dimensions[i] = i < image->GetDimension() ? image->GetDimension(i) : 1;
+    // tiles do not extend over time steps
+    m_NumberOfTiles[i] = i < 3 ? (m_Dimensions[i] + TileSize - 1) / TileSize : m_Dimensions[i];
+    numberOfTiles *= m_NumberOfTiles[i];
+  }
+
+  m_TileData.resize(numberOfTiles);
+  m_TileValues.resize(numberOfTiles * m_PixelSize);
+
+  mitk::ImageReadAccessor accessor(image);
+  const char *data = static_cast<const char *>(accessor.GetData());
+
+  std::vector<char> tileData;
+  for (std::size_t tile = 0; tile < numberOfTiles; ++tile)
+  {
+    tileData.clear();
+    this->VisitRowsOfTile(tile, [&](std::size_t offset, std::size_t length) {
+      const char *row = data + offset * m_PixelSize;
+      tileData.insert(tileData.end(), row, row + length * m_PixelSize);
+    });
+
+    char *tileValue = &m_TileValues[tile * m_PixelSize];
+    std::memcpy(tileValue, tileData.data(), m_PixelSize);
+
+    bool uniform = true;
+    for (std::size_t position = m_PixelSize; uniform && position < tileData.size(); position += m_PixelSize)
+    {
+      uniform = std::memcmp(tileValue, &tileData[position], m_PixelSize) == 0;
+    }
+
+    if (!uniform)
+    {
+      m_TileData[tile] = tileData;
+    }
+  }
+}
+
+void mitk::SparseLabelImageData::Expand(mitk::Image *image) const
+{
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    const unsigned int dimension = i < image->GetDimension() ? image->GetDimension(i) : 1;
+    if (dimension != m_Dimensions[i])
+    {
+      mitkThrow() << "Image does not match the size of the sparse label image data.";
+    }
+  }
+  if (image->GetPixelType().GetSize() != m_PixelSize)
+  {
+    mitkThrow() << "Image does not match the pixel size of the sparse label image data.";
+  }
+
+  mitk::ImageWriteAccessor accessor(image);
+  char *data = static_cast<char *>(accessor.GetData());
+
+  for (std::size_t tile = 0; tile < m_TileData.size(); ++tile)
+  {
+    const std::vector<char> &tileData = m_TileData[tile];
+    if (!tileData.empty())
+    {
+      std::size_t position = 0;
+      this->VisitRowsOfTile(tile, [&](std::size_t offset, std::size_t length) {
+        std::memcpy(data + offset * m_PixelSize, &tileData[position], length * m_PixelSize);
+        position += length * m_PixelSize;
+      });
+      continue;
+    }
+
+    const char *tileValue = &m_TileValues[tile * m_PixelSize];
+    const bool bytewise = std::all_of(tileValue, tileValue + m_PixelSize, [&](char byte) { return byte == tileValue[0]; });
+    this->VisitRowsOfTile(tile, [&](std::size_t offset, std::size_t length) {
+      char *row = data + offset * m_PixelSize;
+      if (bytewise)
+      {
+        std::memset(row, tileValue[0], length * m_PixelSize);
+      }
+      else
+      {
+        for (std::size_t i = 0; i < length; ++i)
+        {
+          std::memcpy(row + i * m_PixelSize, tileValue, m_PixelSize);
+        }
+      }
+    });
+  }
+}
+
+std::size_t mitk::SparseLabelImageData::GetMemorySize() const
+{
+  std::size_t size = m_TileValues.size() + m_TileData.size() * sizeof(std::vector<char>);
+  for (const auto &tileData : m_TileData)
+  {
+    size += tileData.size();
+  }
+  return size;
+}
@@ -0,0 +1,77 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __mitkSparseLabelImageData_H_
+#define __mitkSparseLabelImageData_H_
+
+#include <MitkMultilabelExports.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mitk
+{
+  class Image;
+
+  /**
+   * \brief Sparse copy of the image data of a label image.
+   *
+   * The image data is split into cubic tiles of TileSize voxels per edge (per time step). Tiles in which all voxels
+   * have the same value, e.g. the exterior label, are stored as that value only. All other tiles are stored densely.
+   * Label images which mostly consist of background, like a layer with a few lesions in a whole-body CT, therefore
+   * only cost the memory of the tiles which touch a segmentation.
+   *
+   * Used by LabelSetImage for hidden layers which are not active. The voxels are compared bytewise, so any pixel type
+   * is supported.
+   */
+  class MITKMULTILABEL_EXPORT SparseLabelImageData
+  {
+  public:
+    static const unsigned int TileSize = 32;
+
+    /**
+     * \brief Stores the image data of the given image.
+     */
+    explicit SparseLabelImageData(const mitk::Image *image);
+
+    /**
+     * \brief Writes the stored voxels into the image data of the given image.
+     * @throw mitk::Exception if the image does not have the size and pixel size of the stored image.
+     */
+    void Expand(mitk::Image *image) const;
+
+    /**
+     * \brief Number of bytes held for the voxels.
+     */
+    std::size_t GetMemorySize() const;
+
+  private:
+    /** Calls the functor with the offset (in voxels) and length of every row of the given tile */
+    template <typename TFunctor>
+    void VisitRowsOfTile(std::size_t tile, TFunctor functor) const;
+
+    unsigned int m_Dimensions[4];
+    unsigned int m_NumberOfTiles[4];
+    std::size_t m_PixelSize;
+
+    /** Per tile, empty if all voxels of the tile have the value in m_TileValues */
+    std::vector<std::vector<char>> m_TileData;
+    /** m_PixelSize bytes per tile */
+    std::vector<char> m_TileValues;
+  };
+}
+
+#endif
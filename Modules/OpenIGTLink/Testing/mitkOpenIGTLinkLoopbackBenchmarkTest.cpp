@@ -0,0 +1,215 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+//TEST
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+//STD
+#include <thread>
+#include <chrono>
+
+//ITK
+#include <itkTimeProbe.h>
+
+//MITK
+#include "mitkIGTLServer.h"
+#include "mitkIGTLClient.h"
+
+//IGTL
+#include "igtlTransformMessage.h"
+
+static int PORT = 35353;
+static const std::string HOSTNAME = "localhost";
+static const int NUMBER_OF_ROUND_TRIPS = 200;
+static const int NUMBER_OF_MESSAGES = 2000;
+static const double TIMEOUT_SECONDS = 10.0;
+
+class mitkOpenIGTLinkLoopbackBenchmarkTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkOpenIGTLinkLoopbackBenchmarkTestSuite);
+  MITK_TEST(Benchmark_PollingCommunication_AllMessagesReceived);
+  MITK_TEST(Benchmark_EventDrivenCommunication_AllMessagesReceived);
+  MITK_TEST(Receive_PollingBodyExceedsMaximum_ConnectionClosed);
+  MITK_TEST(Receive_EventDrivenBodyExceedsMaximum_ConnectionClosed);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::IGTLServer::Pointer m_Server;
+  mitk::IGTLClient::Pointer m_Client;
+
+  void Connect(bool eventDriven)
+  {
+    m_Server->SetUseEventDrivenCommunication(eventDriven);
+    m_Client->SetUseEventDrivenCommunication(eventDriven);
+
+    //every message has to arrive, not only the latest one
+    m_Server->EnableNoBufferingMode(false);
+    m_Client->EnableNoBufferingMode(false);
+    m_Server->GetMessageQueue()->SetCapacity(mitk::IGTLMessageQueue::SendMessages, NUMBER_OF_MESSAGES);
+    m_Client->GetMessageQueue()->SetCapacity(mitk::IGTLMessageQueue::TransformMessages, NUMBER_OF_MESSAGES);
+
+    CPPUNIT_ASSERT_MESSAGE("Could not open Connection with Server", m_Server->OpenConnection());
+    CPPUNIT_ASSERT_MESSAGE("Could not start communication with Server", m_Server->StartCommunication());
+    CPPUNIT_ASSERT_MESSAGE("Could not connect to Server with client", m_Client->OpenConnection());
+    CPPUNIT_ASSERT_MESSAGE("Could not start communication with client", m_Client->StartCommunication());
+
+    int steps = 0;
+    while (m_Server->GetNumberOfConnections() == 0 && ++steps < 200)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CPPUNIT_ASSERT_MESSAGE("Server did not register the client", m_Server->GetNumberOfConnections() == 1);
+  }
+
+  void Disconnect()
+  {
+    CPPUNIT_ASSERT(m_Client->StopCommunication());
+    CPPUNIT_ASSERT(m_Server->StopCommunication());
+    CPPUNIT_ASSERT(m_Client->CloseConnection());
+    CPPUNIT_ASSERT(m_Server->CloseConnection());
+  }
+
+  /** The index of the message is stored in the translation to check the order */
+  mitk::IGTLMessage::Pointer CreateMessage(int index)
+  {
+    igtl::TransformMessage::Pointer msg = igtl::TransformMessage::New();
+    msg->SetDeviceName("Benchmark");
+    igtl::Matrix4x4 matrix;
+    igtl::IdentityMatrix(matrix);
+    matrix[0][3] = index;
+    msg->SetMatrix(matrix);
+    return mitk::IGTLMessage::New(msg.GetPointer());
+  }
+
+  int GetIndex(igtl::TransformMessage::Pointer msg)
+  {
+    igtl::Matrix4x4 matrix;
+    msg->GetMatrix(matrix);
+    return static_cast<int>(matrix[0][3]);
+  }
+
+  igtl::TransformMessage::Pointer WaitForMessage(std::chrono::steady_clock::time_point deadline)
+  {
+    igtl::TransformMessage::Pointer msg;
+    while ((msg = m_Client->GetNextTransformMessage()).IsNull() && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+    return msg;
+  }
+
+  /** Logs the latency of single messages and the throughput of a burst from the server to the client */
+  void RunBenchmark(bool eventDriven)
+  {
+    std::string mode = eventDriven ? "event-driven" : "polling";
+    this->Connect(eventDriven);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(TIMEOUT_SECONDS));
+
+    //one message in flight at a time
+    itk::TimeProbe latencyProbe;
+    for (int i = 0; i < NUMBER_OF_ROUND_TRIPS; ++i)
+    {
+      latencyProbe.Start();
+      m_Server->SendMessage(this->CreateMessage(i));
+      igtl::TransformMessage::Pointer msg = this->WaitForMessage(deadline);
+      latencyProbe.Stop();
+      CPPUNIT_ASSERT_MESSAGE("Message was not received in time", msg.IsNotNull());
+      CPPUNIT_ASSERT_MESSAGE("Received the wrong message", this->GetIndex(msg) == i);
+    }
+    MITK_INFO << "Loopback latency (" << mode << "): " << latencyProbe.GetMean() * 1000 << " ms";
+
+    //a burst of messages
+    itk::TimeProbe throughputProbe;
+    throughputProbe.Start();
+    for (int i = 0; i < NUMBER_OF_MESSAGES; ++i)
+      m_Server->SendMessage(this->CreateMessage(i));
+    int received = 0;
+    while (received < NUMBER_OF_MESSAGES)
+    {
+      igtl::TransformMessage::Pointer msg = this->WaitForMessage(deadline);
+      if (msg.IsNull())
+        break;
+      CPPUNIT_ASSERT_MESSAGE("Messages arrived out of order", this->GetIndex(msg) == received);
+      ++received;
+    }
+    throughputProbe.Stop();
+    MITK_INFO << "Loopback throughput (" << mode << "): " << received / throughputProbe.GetTotal() << " messages/s";
+
+    this->Disconnect();
+    CPPUNIT_ASSERT_MESSAGE("Not all messages were received in time", received == NUMBER_OF_MESSAGES);
+  }
+
+  /** The server must drop a client that announces a body larger than the maximum */
+  void RunMaximumBodySizeTest(bool eventDriven)
+  {
+    //a transform message has a body of 48 bytes
+    m_Server->SetMaximumMessageBodySize(16);
+    this->Connect(eventDriven);
+
+    m_Client->SendMessage(this->CreateMessage(0));
+
+    int steps = 0;
+    while (m_Server->GetNumberOfConnections() != 0 && ++steps < 200)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CPPUNIT_ASSERT_MESSAGE("Server did not close the connection", m_Server->GetNumberOfConnections() == 0);
+    CPPUNIT_ASSERT_MESSAGE("Server received the message", m_Server->GetNextTransformMessage().IsNull());
+
+    this->Disconnect();
+  }
+
+public:
+
+  void setUp() override
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    m_Server = mitk::IGTLServer::New(true);
+    m_Client = mitk::IGTLClient::New(true);
+
+    m_Server->SetHostname(HOSTNAME);
+    m_Server->SetName("Benchmark Server");
+    m_Server->SetPortNumber(PORT);
+
+    m_Client->SetHostname(HOSTNAME);
+    m_Client->SetName("Benchmark Client");
+    m_Client->SetPortNumber(PORT);
+  }
+
+  void tearDown() override
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    m_Server = nullptr;
+    m_Client = nullptr;
+  }
+
+  void Benchmark_PollingCommunication_AllMessagesReceived()
+  {
+    this->RunBenchmark(false);
+  }
+
+  void Benchmark_EventDrivenCommunication_AllMessagesReceived()
+  {
+    this->RunBenchmark(true);
+  }
+
+  void Receive_PollingBodyExceedsMaximum_ConnectionClosed()
+  {
+    this->RunMaximumBodySizeTest(false);
+  }
+
+  void Receive_EventDrivenBodyExceedsMaximum_ConnectionClosed()
+  {
+    this->RunMaximumBodySizeTest(true);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkOpenIGTLinkLoopbackBenchmark)
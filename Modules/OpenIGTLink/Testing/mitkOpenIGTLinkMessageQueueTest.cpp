@@ -0,0 +1,173 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+//TEST
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+//STD
+#include <thread>
+
+//MITK
+#include "mitkIGTLMessageQueue.h"
+#include "mitkException.h"
+
+//IGTL
+#include "igtlTransformMessage.h"
+#include "igtlStatusMessage.h"
+
+class mitkOpenIGTLinkMessageQueueTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkOpenIGTLinkMessageQueueTestSuite);
+  MITK_TEST(Test_NoBufferingMode_KeepsLatestMessage);
+  MITK_TEST(Test_DropOldestPolicy_KeepsNewestMessages);
+  MITK_TEST(Test_BoundedFIFOPolicy_RejectsNewMessages);
+  MITK_TEST(Test_ConcurrentPushAndPull_MessagesInOrder);
+  MITK_TEST(Test_InvalidMessageClass_Throws);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::IGTLMessageQueue::Pointer m_Queue;
+
+  /** The index of the message is stored in the translation to check the order */
+  igtl::TransformMessage::Pointer CreateTransformMessage(int index)
+  {
+    igtl::TransformMessage::Pointer msg = igtl::TransformMessage::New();
+    igtl::Matrix4x4 matrix;
+    igtl::IdentityMatrix(matrix);
+    matrix[0][3] = index;
+    msg->SetMatrix(matrix);
+    return msg;
+  }
+
+  int GetIndex(igtl::TransformMessage::Pointer msg)
+  {
+    igtl::Matrix4x4 matrix;
+    msg->GetMatrix(matrix);
+    return static_cast<int>(matrix[0][3]);
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Queue = mitk::IGTLMessageQueue::New();
+  }
+
+  void tearDown() override
+  {
+    m_Queue = nullptr;
+  }
+
+  void Test_NoBufferingMode_KeepsLatestMessage()
+  {
+    m_Queue->EnableNoBufferingMode(true);
+    for (int i = 0; i < 10; ++i)
+      m_Queue->PushMessage(this->CreateTransformMessage(i).GetPointer());
+
+    igtl::TransformMessage::Pointer msg = m_Queue->PullTransformMessage();
+    CPPUNIT_ASSERT_MESSAGE("No message in the queue", msg.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Not the latest message", this->GetIndex(msg) == 9);
+    CPPUNIT_ASSERT_MESSAGE("More than one message in the queue", m_Queue->PullTransformMessage().IsNull());
+    CPPUNIT_ASSERT(m_Queue->GetNumberOfDroppedMessages(mitk::IGTLMessageQueue::TransformMessages) == 9);
+  }
+
+  void Test_DropOldestPolicy_KeepsNewestMessages()
+  {
+    m_Queue->EnableNoBufferingMode(false);
+    m_Queue->SetCapacity(mitk::IGTLMessageQueue::TransformMessages, 4);
+    m_Queue->SetBufferingPolicy(mitk::IGTLMessageQueue::TransformMessages, mitk::IGTLMessageQueue::DropOldest);
+    for (int i = 0; i < 10; ++i)
+      m_Queue->PushMessage(this->CreateTransformMessage(i).GetPointer());
+
+    CPPUNIT_ASSERT(m_Queue->GetSize() == 4);
+    for (int i = 6; i < 10; ++i)
+    {
+      igtl::TransformMessage::Pointer msg = m_Queue->PullTransformMessage();
+      CPPUNIT_ASSERT_MESSAGE("Message is missing", msg.IsNotNull());
+      CPPUNIT_ASSERT_MESSAGE("Messages are not in order", this->GetIndex(msg) == i);
+    }
+    CPPUNIT_ASSERT(m_Queue->PullTransformMessage().IsNull());
+  }
+
+  void Test_BoundedFIFOPolicy_RejectsNewMessages()
+  {
+    m_Queue->EnableNoBufferingMode(false);
+    m_Queue->SetCapacity(mitk::IGTLMessageQueue::CommandMessages, 4);
+    m_Queue->SetBufferingPolicy(mitk::IGTLMessageQueue::CommandMessages, mitk::IGTLMessageQueue::BoundedFIFO);
+    for (int i = 0; i < 6; ++i)
+    {
+      igtl::StatusMessage::Pointer msg = igtl::StatusMessage::New();
+      msg->SetCode(i);
+      m_Queue->PushCommandMessage(msg.GetPointer());
+    }
+
+    CPPUNIT_ASSERT(m_Queue->GetNumberOfDroppedMessages(mitk::IGTLMessageQueue::CommandMessages) == 2);
+    for (int i = 0; i < 4; ++i)
+    {
+      igtl::StatusMessage::Pointer msg = dynamic_cast<igtl::StatusMessage*>(m_Queue->PullCommandMessage().GetPointer());
+      CPPUNIT_ASSERT_MESSAGE("Message is missing", msg.IsNotNull());
+      CPPUNIT_ASSERT_MESSAGE("Messages are not in order", msg->GetCode() == i);
+    }
+    CPPUNIT_ASSERT(m_Queue->PullCommandMessage().IsNull());
+  }
+
+  void Test_ConcurrentPushAndPull_MessagesInOrder()
+  {
+    const int numberOfMessages = 100000;
+    m_Queue->EnableNoBufferingMode(false);
+    m_Queue->SetCapacity(mitk::IGTLMessageQueue::TransformMessages, 64);
+    m_Queue->SetBufferingPolicy(mitk::IGTLMessageQueue::TransformMessages, mitk::IGTLMessageQueue::DropOldest);
+
+    std::thread producer([&]()
+    {
+      for (int i = 0; i < numberOfMessages; ++i)
+        m_Queue->PushMessage(this->CreateTransformMessage(i).GetPointer());
+    });
+
+    //the consumer may miss messages but never sees them twice or out of order
+    int last = -1;
+    int received = 0;
+    bool inOrder = true;
+    while (last < numberOfMessages - 1)
+    {
+      igtl::TransformMessage::Pointer msg = m_Queue->PullTransformMessage();
+      if (msg.IsNull())
+        continue;
+      int index = this->GetIndex(msg);
+      inOrder = inOrder && index > last;
+      last = index;
+      ++received;
+    }
+    producer.join();
+
+    CPPUNIT_ASSERT_MESSAGE("Messages are not in order", inOrder);
+
+    unsigned long dropped = m_Queue->GetNumberOfDroppedMessages(mitk::IGTLMessageQueue::TransformMessages);
+    CPPUNIT_ASSERT_MESSAGE("Messages were lost", received + dropped == static_cast<unsigned long>(numberOfMessages));
+  }
+
+  void Test_InvalidMessageClass_Throws()
+  {
+    const mitk::IGTLMessageQueue::MessageClass invalidClass = mitk::IGTLMessageQueue::NumberOfMessageClasses;
+    CPPUNIT_ASSERT_THROW(m_Queue->SetBufferingPolicy(invalidClass, mitk::IGTLMessageQueue::DropOldest), mitk::Exception);
+    CPPUNIT_ASSERT_THROW(m_Queue->GetBufferingPolicy(invalidClass), mitk::Exception);
+    CPPUNIT_ASSERT_THROW(m_Queue->SetCapacity(invalidClass, 4), mitk::Exception);
+    CPPUNIT_ASSERT_THROW(m_Queue->GetNumberOfDroppedMessages(invalidClass), mitk::Exception);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkOpenIGTLinkMessageQueue)
@@ -2,6 +2,7 @@ set(CPP_FILES
   mitkIGTLClient.cpp
   mitkIGTLServer.cpp
   mitkIGTLDevice.cpp
+  mitkIGTLSocket.cpp
   mitkIGTLMessageSource.cpp
   mitkIGTLMessageCommon.cpp
   mitkIGTLDeviceSource.cpp
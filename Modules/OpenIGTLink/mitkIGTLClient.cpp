@@ -23,7 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <itkMutexLockHolder.h>
 
-#include <igtlClientSocket.h>
+#include "mitkIGTLSocket.h"
 #include <igtl_status.h>
 
 typedef itk::MutexLockHolder<itk::FastMutexLock> MutexLockHolder;
@@ -57,11 +57,11 @@ bool mitk::IGTLClient::OpenConnection()
   }
 
   //create a new client socket
-  m_Socket = igtl::ClientSocket::New();
+  mitk::IGTLClientSocket::Pointer clientSocket = mitk::IGTLClientSocket::New();
+  m_Socket = clientSocket;
 
   //try to connect to the igtl server
-  int response = dynamic_cast<igtl::ClientSocket*>(m_Socket.GetPointer())->
-    ConnectToServer(hostname.c_str(), portNumber);
+  int response = clientSocket->ConnectToServer(hostname.c_str(), portNumber);
 
   //check the response
   if (response != 0)
@@ -84,7 +84,20 @@ void mitk::IGTLClient::Receive()
   //MITK_INFO << "Trying to receive message";
   //try to receive a message, if the socket is not present anymore stop the
   //communication
-  unsigned int status = this->ReceivePrivate(this->m_Socket);
+  unsigned int status = IGTL_STATUS_OK;
+  if (this->m_UseEventDrivenCommunication)
+  {
+    //sleep until the server sent something, then read everything at once
+    std::vector<igtl::Socket*> sockets(1, this->m_Socket.GetPointer());
+    std::vector<bool> readable;
+    if (this->WaitForReadableSockets(sockets, readable) <= 0)
+      return;
+    status = this->ReceiveBufferedPrivate(this->m_Socket);
+  }
+  else
+  {
+    status = this->ReceivePrivate(this->m_Socket);
+  }
   if (status == IGTL_STATUS_NOT_PRESENT)
   {
     this->StopCommunicationWithSocket(this->m_Socket);
@@ -96,6 +109,17 @@ void mitk::IGTLClient::Receive()
 
 void mitk::IGTLClient::Send()
 {
+  if (this->m_UseEventDrivenCommunication)
+  {
+    //sleep until messages are enqueued, then send all of them at once
+    std::vector<mitk::IGTLMessage::Pointer> messages = this->WaitForSendMessages();
+    if (!messages.empty() && this->SendMessagesPrivate(messages, this->m_Socket) != IGTL_STATUS_OK)
+    {
+      MITK_WARN("IGTLDevice") << "Could not send the messages.";
+    }
+    return;
+  }
+
   mitk::IGTLMessage::Pointer mitkMessage;
 
   //get the latest message from the queue
@@ -14,11 +14,24 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 ===================================================================*/
 
+//winsock2.h has to be included before anything pulls in windows.h
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
 #include "mitkIGTLDevice.h"
+#include "mitkIGTLSocket.h"
 //#include "mitkIGTException.h"
 //#include "mitkIGTTimeStamp.h"
 #include <itkMutexLockHolder.h>
 #include <itksys/SystemTools.hxx>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 
 #include <igtlTransformMessage.h>
@@ -31,8 +44,177 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 //TODO: Which timeout is acceptable and also needed to transmit image data? Is there a maximum data limit?
 static const int SOCKET_SEND_RECEIVE_TIMEOUT_MSEC = 100;
+//number of bytes that are read at once in the event-driven mode
+static const size_t RECEIVE_CHUNK_SIZE = 65536;
+//maximum number of messages that are sent with one scatter-gather write
+static const size_t MAX_SEND_BATCH_SIZE = 64;
+//default limit of the body size of received messages
+static const unsigned long long DEFAULT_MAXIMUM_MESSAGE_BODY_SIZE = 512ULL * 1024 * 1024;
 typedef itk::MutexLockHolder<itk::FastMutexLock> MutexLockHolder;
 
+#if !defined(_WIN32) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+  /** Returns the descriptor of a socket created by IGTLClient or IGTLServer, -1 for other sockets */
+  int GetSocketDescriptor(igtl::Socket* socket)
+  {
+    if (auto clientSocket = dynamic_cast<mitk::IGTLClientSocket*>(socket))
+      return clientSocket->GetDescriptor();
+    if (auto serverSocket = dynamic_cast<mitk::IGTLServerSocket*>(socket))
+      return serverSocket->GetDescriptor();
+    return -1;
+  }
+
+  /** GET_, STP_ and RTS_ messages are pushed into the command queue without a body */
+  bool IsHeaderOnlyCommand(const char* deviceType)
+  {
+    return std::strstr(deviceType, "GET_") != nullptr ||
+      std::strstr(deviceType, "STP_") != nullptr ||
+      std::strstr(deviceType, "RTS_") != nullptr;
+  }
+
+  bool IsInterrupted()
+  {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEINTR || error == WSAEWOULDBLOCK || error == WSAETIMEDOUT;
+#else
+    return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+  }
+
+  /**
+  * Waits until one of the descriptors is readable, returns the number of
+  * readable descriptors, 0 on timeout and -1 on error. Negative descriptors
+  * are ignored.
+  */
+  int WaitForReadableDescriptors(const std::vector<int>& descriptors, std::vector<bool>& readable, int timeoutMsec)
+  {
+    readable.assign(descriptors.size(), false);
+#ifdef _WIN32
+    //like igtl::Socket use select(), WSAPoll() is not available for _WIN32_WINNT 0x0501
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    for (int descriptor : descriptors)
+    {
+      if (descriptor >= 0)
+        FD_SET(static_cast<SOCKET>(descriptor), &readSet);
+    }
+    if (readSet.fd_count == 0)
+    {
+      return 0;
+    }
+
+    timeval timeout;
+    timeout.tv_sec = timeoutMsec / 1000;
+    timeout.tv_usec = (timeoutMsec % 1000) * 1000;
+    int r = select(0, &readSet, nullptr, nullptr, &timeout);
+    if (r == SOCKET_ERROR)
+    {
+      return -1;
+    }
+
+    //a closed or broken connection is readable as well, the following read
+    //detects it
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+      readable[i] = descriptors[i] >= 0 && FD_ISSET(static_cast<SOCKET>(descriptors[i]), &readSet);
+    }
+    return r;
+#else
+    std::vector<pollfd> pollDescriptors(descriptors.size());
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+      pollDescriptors[i].fd = descriptors[i];
+      pollDescriptors[i].events = POLLIN;
+      pollDescriptors[i].revents = 0;
+    }
+
+    int r = poll(pollDescriptors.data(), static_cast<nfds_t>(pollDescriptors.size()), timeoutMsec);
+    if (r <= 0)
+    {
+      return r;
+    }
+
+    //a closed or broken connection is readable as well, the following read
+    //detects it
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+      readable[i] = (pollDescriptors[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    }
+    return r;
+#endif
+  }
+
+  /** Reads whatever is available, returns the number of bytes, 0 if the peer closed the connection or -1 */
+  long ReceiveAvailable(int descriptor, char* data, size_t length)
+  {
+    return recv(descriptor, data, static_cast<int>(length), 0);
+  }
+
+  /** Writes all buffers, using as few system calls as possible */
+  bool SendBuffers(int descriptor, const std::vector<std::pair<const char*, size_t>>& buffers)
+  {
+    size_t first = 0;
+    size_t offset = 0;
+    while (first < buffers.size())
+    {
+      size_t count = std::min(buffers.size() - first, MAX_SEND_BATCH_SIZE);
+#ifdef _WIN32
+      WSABUF vectors[MAX_SEND_BATCH_SIZE];
+      for (size_t i = 0; i < count; ++i)
+      {
+        size_t skip = (i == 0) ? offset : 0;
+        vectors[i].buf = const_cast<char*>(buffers[first + i].first + skip);
+        vectors[i].len = static_cast<ULONG>(buffers[first + i].second - skip);
+      }
+      DWORD sentBytes = 0;
+      long sent = -1;
+      if (WSASend(descriptor, vectors, static_cast<DWORD>(count), &sentBytes, 0, nullptr, nullptr) == 0)
+        sent = static_cast<long>(sentBytes);
+#else
+      iovec vectors[MAX_SEND_BATCH_SIZE];
+      for (size_t i = 0; i < count; ++i)
+      {
+        size_t skip = (i == 0) ? offset : 0;
+        vectors[i].iov_base = const_cast<char*>(buffers[first + i].first + skip);
+        vectors[i].iov_len = buffers[first + i].second - skip;
+      }
+      msghdr header;
+      std::memset(&header, 0, sizeof(header));
+      header.msg_iov = vectors;
+      header.msg_iovlen = count;
+      long sent = sendmsg(descriptor, &header, MSG_NOSIGNAL);
+#endif
+      if (sent < 0)
+      {
+#ifdef _WIN32
+        if (WSAGetLastError() == WSAEINTR)
+          continue;
+#else
+        if (errno == EINTR)
+          continue;
+#endif
+        return false;
+      }
+
+      //skip everything that was written, the last buffer may be incomplete
+      size_t remaining = static_cast<size_t>(sent);
+      while (first < buffers.size() && remaining >= buffers[first].second - offset)
+      {
+        remaining -= buffers[first].second - offset;
+        offset = 0;
+        ++first;
+      }
+      offset += remaining;
+    }
+    return true;
+  }
+}
+
 mitk::IGTLDevice::IGTLDevice(bool ReadFully) :
 //  m_Data(mitk::DeviceDataUnspecified),
 m_State(mitk::IGTLDevice::Setup),
@@ -40,9 +222,13 @@ m_Name("Unspecified Device"),
 m_StopCommunication(false),
 m_Hostname("127.0.0.1"),
 m_PortNumber(-1),
+m_LogMessages(false),
+m_UseEventDrivenCommunication(false),
+m_MaximumMessageBodySize(DEFAULT_MAXIMUM_MESSAGE_BODY_SIZE),
 m_MultiThreader(nullptr), m_SendThreadID(0), m_ReceiveThreadID(0), m_ConnectThreadID(0)
 {
   m_ReadFully = ReadFully;
+  m_WakeUpSendingThread = false;
   m_StopCommunicationMutex = itk::FastMutexLock::New();
   m_StateMutex = itk::FastMutexLock::New();
   //  m_LatestMessageMutex = itk::FastMutexLock::New();
@@ -180,15 +366,21 @@ unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
       //if it is a GET_, STP_ or RTS_ command push it into the command queue
       //otherwise continue reading the whole message from the socket
       const char* curDevType = headerMsg->GetDeviceType();
-      if (std::strstr(curDevType, "GET_") != nullptr ||
-        std::strstr(curDevType, "STP_") != nullptr ||
-        std::strstr(curDevType, "RTS_") != nullptr)
+      if (IsHeaderOnlyCommand(curDevType))
       {
         this->m_MessageQueue->PushCommandMessage(headerMsg);
         this->InvokeEvent(CommandReceivedEvent());
         return IGTL_STATUS_OK;
       }
 
+      if (headerMsg->GetBodySizeToRead() > m_MaximumMessageBodySize)
+      {
+        //the rest of the stream cannot be trusted, close the connection
+        MITK_WARN("IGTLDevice") << "Received a header announcing a body of " << headerMsg->GetBodySizeToRead()
+          << " bytes, which exceeds the maximum of " << m_MaximumMessageBodySize << " bytes. Closing the connection.";
+        return IGTL_STATUS_NOT_PRESENT;
+      }
+
       //Create a message according to the header message
       igtl::MessageBase::Pointer curMessage;
       curMessage = m_MessageFactory->CreateInstance(headerMsg);
@@ -214,30 +406,7 @@ unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
 
       if (receiveCheck > 0)
       {
-        int c = curMessage->Unpack(1);
-        if (!(c & igtl::MessageHeader::UNPACK_BODY))
-        {
-          return IGTL_STATUS_CHECKSUM_ERROR;
-        }
-
-        //check the type of the received message
-        //if it is a command push it into the command queue
-        //otherwise into the normal receive queue
-        //STP_ commands are handled here because they implemented additional
-        //member variables that are not stored in the header message
-        if (std::strstr(curDevType, "STT_") != nullptr)
-        {
-          this->m_MessageQueue->PushCommandMessage(curMessage);
-          this->InvokeEvent(CommandReceivedEvent());
-        }
-        else
-        {
-          if(m_LogMessages)
-            MITK_INFO << "Received Message: " << mitk::IGTLMessage::New(curMessage)->ToString();
-          this->m_MessageQueue->PushMessage(curMessage);
-          this->InvokeEvent(MessageReceivedEvent());
-        }
-        return IGTL_STATUS_OK;
+        return this->DispatchReceivedMessage(curMessage);
       }
       else
       {
@@ -262,9 +431,228 @@ unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
   }
 }
 
+unsigned int mitk::IGTLDevice::DispatchReceivedMessage(igtl::MessageBase::Pointer curMessage)
+{
+  int c = curMessage->Unpack(1);
+  if (!(c & igtl::MessageHeader::UNPACK_BODY))
+  {
+    return IGTL_STATUS_CHECKSUM_ERROR;
+  }
+
+  //check the type of the received message
+  //if it is a command push it into the command queue
+  //otherwise into the normal receive queue
+  //STP_ commands are handled here because they implemented additional
+  //member variables that are not stored in the header message
+  if (std::strstr(curMessage->GetDeviceType(), "STT_") != nullptr)
+  {
+    this->m_MessageQueue->PushCommandMessage(curMessage);
+    this->InvokeEvent(CommandReceivedEvent());
+  }
+  else
+  {
+    if(m_LogMessages)
+      MITK_INFO << "Received Message: " << mitk::IGTLMessage::New(curMessage)->ToString();
+    this->m_MessageQueue->PushMessage(curMessage);
+    this->InvokeEvent(MessageReceivedEvent());
+  }
+  return IGTL_STATUS_OK;
+}
+
+unsigned int mitk::IGTLDevice::UnpackReceivedMessage(igtl::MessageHeader::Pointer headerMsg,
+  const char* body, size_t bodySize)
+{
+  if (IsHeaderOnlyCommand(headerMsg->GetDeviceType()))
+  {
+    this->m_MessageQueue->PushCommandMessage(headerMsg);
+    this->InvokeEvent(CommandReceivedEvent());
+    return IGTL_STATUS_OK;
+  }
+
+  //the message type is not supported, its body is skipped by the caller
+  igtl::MessageBase::Pointer curMessage = m_MessageFactory->CreateInstance(headerMsg);
+  if (curMessage.IsNull())
+  {
+    return IGTL_STATUS_NOT_FOUND;
+  }
+
+  curMessage->SetMessageHeader(headerMsg);
+  curMessage->AllocatePack();
+  if (static_cast<size_t>(curMessage->GetPackBodySize()) != bodySize)
+  {
+    MITK_WARN("IGTLDevice") << "Received a message with an unexpected body size.";
+    return IGTL_STATUS_UNKNOWN_ERROR;
+  }
+  std::memcpy(curMessage->GetPackBodyPointer(), body, bodySize);
+
+  return this->DispatchReceivedMessage(curMessage);
+}
+
+unsigned int mitk::IGTLDevice::ReceiveBufferedPrivate(igtl::Socket* socket)
+{
+  ReceiveBuffer& buffer = m_ReceiveBuffers[socket];
+
+  //move the incomplete message to the front, so that the free space behind it
+  //can be filled with a single read
+  if (buffer.Begin > 0)
+  {
+    std::memmove(buffer.Data.data(), buffer.Data.data() + buffer.Begin, buffer.End - buffer.Begin);
+    buffer.End -= buffer.Begin;
+    buffer.Begin = 0;
+  }
+  if (buffer.Data.size() < buffer.End + RECEIVE_CHUNK_SIZE)
+  {
+    buffer.Data.resize(buffer.End + RECEIVE_CHUNK_SIZE);
+  }
+
+  long r = ReceiveAvailable(GetSocketDescriptor(socket),
+    buffer.Data.data() + buffer.End, buffer.Data.size() - buffer.End);
+  if (r < 0 && IsInterrupted())
+  {
+    return IGTL_STATUS_TIME_OUT;
+  }
+  if (r <= 0)
+  {
+    //the connection was closed or broke down
+    m_ReceiveBuffers.erase(socket);
+    return IGTL_STATUS_NOT_PRESENT;
+  }
+  buffer.End += r;
+
+  //unpack every message that has arrived completely
+  unsigned int status = IGTL_STATUS_TIME_OUT;
+  while (buffer.End > buffer.Begin)
+  {
+    igtl::MessageHeader::Pointer headerMsg = igtl::MessageHeader::New();
+    headerMsg->InitPack();
+    size_t headerSize = headerMsg->GetPackSize();
+    size_t available = buffer.End - buffer.Begin;
+    if (available < headerSize)
+      break;
+
+    std::memcpy(headerMsg->GetPackPointer(), buffer.Data.data() + buffer.Begin, headerSize);
+    if (!(headerMsg->Unpack(1) & igtl::MessageHeader::UNPACK_HEADER))
+    {
+      //there is no way to find the next message in the stream, drop everything
+      MITK_WARN << "CRC Check failed";
+      buffer.Begin = buffer.End = 0;
+      return IGTL_STATUS_CHECKSUM_ERROR;
+    }
+
+    if (headerMsg->GetBodySizeToRead() > m_MaximumMessageBodySize)
+    {
+      //the rest of the stream cannot be trusted, close the connection
+      MITK_WARN("IGTLDevice") << "Received a header announcing a body of " << headerMsg->GetBodySizeToRead()
+        << " bytes, which exceeds the maximum of " << m_MaximumMessageBodySize << " bytes. Closing the connection.";
+      m_ReceiveBuffers.erase(socket);
+      return IGTL_STATUS_NOT_PRESENT;
+    }
+
+    size_t messageSize = headerSize + static_cast<size_t>(headerMsg->GetBodySizeToRead());
+    if (available < messageSize)
+    {
+      //make room for the rest of the message, so that large images are not
+      //read in many small pieces
+      if (buffer.Data.size() < buffer.Begin + messageSize)
+        buffer.Data.resize(buffer.Begin + messageSize);
+      break;
+    }
+
+    status = this->UnpackReceivedMessage(headerMsg,
+      buffer.Data.data() + buffer.Begin + headerSize, messageSize - headerSize);
+    buffer.Begin += messageSize;
+  }
+
+  if (buffer.Begin == buffer.End)
+  {
+    buffer.Begin = buffer.End = 0;
+  }
+  return status;
+}
+
+int mitk::IGTLDevice::WaitForReadableSockets(const std::vector<igtl::Socket*>& sockets,
+  std::vector<bool>& readable)
+{
+  std::vector<int> descriptors(sockets.size());
+  for (size_t i = 0; i < sockets.size(); ++i)
+  {
+    descriptors[i] = GetSocketDescriptor(sockets[i]);
+  }
+
+  int r = WaitForReadableDescriptors(descriptors, readable, SOCKET_SEND_RECEIVE_TIMEOUT_MSEC);
+  if (r <= 0)
+  {
+    return (r < 0 && !IsInterrupted()) ? -1 : 0;
+  }
+  return r;
+}
+
 void mitk::IGTLDevice::SendMessage(mitk::IGTLMessage::Pointer msg)
 {
   m_MessageQueue->PushSendMessage(msg);
+  this->WakeUpSendingThread();
+}
+
+void mitk::IGTLDevice::WakeUpSendingThread()
+{
+  std::lock_guard<std::mutex> lock(m_SendingThreadMutex);
+  m_WakeUpSendingThread = true;
+  m_SendingThreadCondition.notify_one();
+}
+
+std::vector<mitk::IGTLMessage::Pointer> mitk::IGTLDevice::WaitForSendMessages()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_SendingThreadMutex);
+    if (!m_WakeUpSendingThread)
+    {
+      m_SendingThreadCondition.wait_for(lock,
+        std::chrono::milliseconds(SOCKET_SEND_RECEIVE_TIMEOUT_MSEC));
+    }
+    m_WakeUpSendingThread = false;
+  }
+
+  std::vector<mitk::IGTLMessage::Pointer> messages;
+  mitk::IGTLMessage::Pointer msg;
+  while (messages.size() < MAX_SEND_BATCH_SIZE &&
+    (msg = m_MessageQueue->PullSendMessage()).IsNotNull())
+  {
+    msg->GetMessage()->Pack();
+    messages.push_back(msg);
+  }
+
+  //there are more messages waiting, do not sleep before sending them
+  if (messages.size() == MAX_SEND_BATCH_SIZE)
+  {
+    std::lock_guard<std::mutex> lock(m_SendingThreadMutex);
+    m_WakeUpSendingThread = true;
+  }
+  return messages;
+}
+
+unsigned int mitk::IGTLDevice::SendMessagesPrivate(const std::vector<mitk::IGTLMessage::Pointer>& messages,
+  igtl::Socket* socket)
+{
+  std::vector<std::pair<const char*, size_t>> buffers;
+  buffers.reserve(messages.size());
+  for (const mitk::IGTLMessage::Pointer& msg : messages)
+  {
+    igtl::MessageBase* sendMessage = msg->GetMessage();
+    buffers.push_back(std::make_pair(static_cast<const char*>(sendMessage->GetPackPointer()),
+      static_cast<size_t>(sendMessage->GetPackSize())));
+  }
+
+  if (!SendBuffers(GetSocketDescriptor(socket), buffers))
+  {
+    return IGTL_STATUS_UNKNOWN_ERROR;
+  }
+
+  for (const mitk::IGTLMessage::Pointer& msg : messages)
+  {
+    if (m_LogMessages) { MITK_INFO << "Send IGTL message: " << msg->ToString(); }
+    this->InvokeEvent(MessageSentEvent());
+  }
+  return IGTL_STATUS_OK;
 }
 
 unsigned int mitk::IGTLDevice::SendMessagePrivate(mitk::IGTLMessage::Pointer msg,
@@ -325,7 +713,10 @@ void mitk::IGTLDevice::RunCommunication(void (IGTLDevice::*ComFunction)(void), i
       this->m_StopCommunicationMutex->Unlock();
 
       // time to relax, this sets the maximum ever possible framerate to 1000 Hz
-      itksys::SystemTools::Delay(1);
+      // in the event-driven mode the communication functions block until
+      // there is something to do
+      if (!m_UseEventDrivenCommunication)
+        itksys::SystemTools::Delay(1);
     }
   }
   catch (...)
@@ -360,6 +751,9 @@ bool mitk::IGTLDevice::StartCommunication()
   this->m_StopCommunication = false;
   this->m_StopCommunicationMutex->Unlock();
 
+  // the receive buffers of a previous communication are not valid anymore
+  m_ReceiveBuffers.clear();
+
   // transfer the execution rights to tracking thread
   m_SendingFinishedMutex->Unlock();
   m_ReceivingFinishedMutex->Unlock();
@@ -370,8 +764,13 @@ bool mitk::IGTLDevice::StartCommunication()
     m_MultiThreader->SpawnThread(this->ThreadStartSending, this);
   m_ReceiveThreadID =
     m_MultiThreader->SpawnThread(this->ThreadStartReceiving, this);
-  m_ConnectThreadID =
-    m_MultiThreader->SpawnThread(this->ThreadStartConnecting, this);
+  // in the event-driven mode new connections are accepted by the receiving
+  // thread, which waits for the server socket together with the clients
+  if (!m_UseEventDrivenCommunication)
+  {
+    m_ConnectThreadID =
+      m_MultiThreader->SpawnThread(this->ThreadStartConnecting, this);
+  }
   //  mitk::IGTTimeStamp::GetInstance()->Start(this);
   return true;
 }
@@ -385,6 +784,7 @@ bool mitk::IGTLDevice::StopCommunication()
     m_StopCommunicationMutex->Lock();
     m_StopCommunication = true;
     m_StopCommunicationMutex->Unlock();
+    this->WakeUpSendingThread();
     // we have to wait here that the other thread recognizes the STOP-command
     // and executes it
     m_SendingFinishedMutex->Lock();
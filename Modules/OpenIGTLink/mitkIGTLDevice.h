@@ -24,9 +24,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkFastMutexLock.h"
 #include "itkMultiThreader.h"
 
+//std
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
 //igtl
 #include "igtlSocket.h"
 #include "igtlMessageBase.h"
+#include "igtlMessageHeader.h"
 #include "igtlTransformMessage.h"
 
 //mitkIGTL
@@ -55,6 +62,12 @@ namespace mitk {
   * call StopCommunication() (to arrive in Ready state) or CloseConnection()
   * (to arrive in the Setup state).
   *
+  * By default the communication threads poll the sockets and sleep for a
+  * millisecond after every iteration. With SetUseEventDrivenCommunication()
+  * the threads instead wait until a socket is readable or a message is
+  * enqueued, read everything that is available at once and send all queued
+  * messages with a single scatter-gather write.
+  *
   * \ingroup OpenIGTLink
   *
   */
@@ -252,6 +265,26 @@ namespace mitk {
     itkGetMacro(LogMessages, bool);
     itkSetMacro(LogMessages, bool);
 
+    /**
+    * \brief Enables the event-driven communication mode.
+    *
+    * Has to be set before StartCommunication() is called.
+    */
+    itkSetMacro(UseEventDrivenCommunication, bool);
+    itkGetConstMacro(UseEventDrivenCommunication, bool);
+    itkBooleanMacro(UseEventDrivenCommunication);
+
+    /**
+    * \brief Maximum body size of a received message in bytes.
+    *
+    * The body size is announced by the header of the message and the body is
+    * allocated before it is read, so a corrupted or malicious header could
+    * otherwise exhaust the memory. The connection to a peer that announces a
+    * larger body is closed. Defaults to 512 MB.
+    */
+    itkSetMacro(MaximumMessageBodySize, unsigned long long);
+    itkGetConstMacro(MaximumMessageBodySize, unsigned long long);
+
   protected:
     /**
      * \brief Sends a message.
@@ -293,6 +326,54 @@ namespace mitk {
     */
     unsigned int ReceivePrivate(igtl::Socket* device);
 
+    /**
+    * \brief Reads all data that is available on the given socket and unpacks
+    * every message that is complete.
+    *
+    * Incomplete messages are kept in a buffer per socket until the rest
+    * arrives. Only call this if the socket is readable, see
+    * WaitForReadableSockets().
+    *
+    * \retval IGTL_STATUS_OK at least one message or command was received
+    * \retval IGTL_STATUS_NOT_PRESENT the socket is not connected anymore
+    * \retval IGTL_STATUS_TIME_OUT no message is complete yet
+    * \retval IGTL_STATUS_CHECKSUM_ERROR the checksum of a received msg was
+    * incorrect
+    */
+    unsigned int ReceiveBufferedPrivate(igtl::Socket* socket);
+
+    /**
+    * \brief Sends the given packed messages with as few system calls as
+    * possible.
+    *
+    * \retval IGTL_STATUS_OK the messages were sent
+    * \retval IGTL_STATUS_UNKONWN_ERROR the messages were not sent completely
+    */
+    unsigned int SendMessagesPrivate(const std::vector<mitk::IGTLMessage::Pointer>& messages,
+      igtl::Socket* socket);
+
+    /**
+    * \brief Blocks until at least one of the sockets is readable or the
+    * socket timeout elapsed.
+    *
+    * \param sockets the sockets to wait for
+    * \param readable is set to true for every socket that can be read
+    * \return the number of readable sockets, 0 on timeout and -1 on error
+    */
+    int WaitForReadableSockets(const std::vector<igtl::Socket*>& sockets,
+      std::vector<bool>& readable);
+
+    /**
+    * \brief Blocks until a message is enqueued or the socket timeout elapsed
+    * and returns all queued messages in packed form.
+    */
+    std::vector<mitk::IGTLMessage::Pointer> WaitForSendMessages();
+
+    /**
+    * \brief Wakes up the sending thread if it waits in WaitForSendMessages()
+    */
+    void WakeUpSendingThread();
+
     /**
     * \brief Call this method to send a message. The message will be read from
     * the queue.
@@ -356,8 +437,44 @@ namespace mitk {
 
     bool m_LogMessages;
 
+    /** wait for socket readiness instead of polling with a fixed delay */
+    bool m_UseEventDrivenCommunication;
+
+    /** messages with a larger body are not received, see SetMaximumMessageBodySize() */
+    unsigned long long m_MaximumMessageBodySize;
+
   private:
 
+    /**
+    * \brief Unpacks the body of a message and pushes it into the matching
+    * queue.
+    */
+    unsigned int DispatchReceivedMessage(igtl::MessageBase::Pointer curMessage);
+
+    /**
+    * \brief Creates the message for the given header from a complete body in
+    * memory and dispatches it.
+    */
+    unsigned int UnpackReceivedMessage(igtl::MessageHeader::Pointer headerMsg,
+      const char* body, size_t bodySize);
+
+    /** data that was received but not unpacked yet */
+    struct ReceiveBuffer
+    {
+      ReceiveBuffer() : Begin(0), End(0) {}
+      std::vector<char> Data;
+      size_t Begin;
+      size_t End;
+    };
+
+    /** the receive buffers of the event-driven mode, only used by the receiving thread */
+    std::map<igtl::Socket*, ReceiveBuffer> m_ReceiveBuffers;
+
+    /** wakes up the sending thread when a message is enqueued */
+    std::mutex m_SendingThreadMutex;
+    std::condition_variable m_SendingThreadCondition;
+    bool m_WakeUpSendingThread;
+
     /** creates worker thread that continuously polls interface for new
     messages */
     itk::MultiThreader::Pointer m_MultiThreader;
@@ -15,206 +15,158 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkIGTLMessageQueue.h"
+#include <mitkExceptionMacro.h>
 #include <string>
 #include "igtlMessageBase.h"
 
-void mitk::IGTLMessageQueue::PushSendMessage(mitk::IGTLMessage::Pointer message)
+namespace
 {
-  this->m_Mutex->Lock();
+  void CheckMessageClass(mitk::IGTLMessageQueue::MessageClass messageClass)
+  {
+    if (static_cast<int>(messageClass) < 0 || messageClass >= mitk::IGTLMessageQueue::NumberOfMessageClasses)
+      mitkThrow() << "Invalid message class " << messageClass;
+  }
+}
+
+template <typename TPointer>
+void mitk::IGTLMessageQueue::Push(MessageClass messageClass,
+  IGTLMessageRingBuffer<TPointer>& buffer, const TPointer& message)
+{
+  size_t dropped = 0;
   if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-    m_SendQueue.clear();
+  {
+    dropped = buffer.PushLatestOnly(message);
+  }
+  else
+  {
+    switch (this->m_BufferingPolicies[messageClass].load())
+    {
+    case LatestOnly:
+      dropped = buffer.PushLatestOnly(message);
+      break;
+    case DropOldest:
+      dropped = buffer.PushDropOldest(message);
+      break;
+    case BoundedFIFO:
+      if (!buffer.Push(message))
+      {
+        dropped = 1;
+        // a full buffer usually rejects many messages in a row, the dropped messages are counted anyway
+        if (!this->m_RejectionWarned[messageClass].exchange(true))
+          MITK_WARN("IGTLMessageQueue") << "Buffer of message class " << messageClass
+            << " is full, messages are rejected (see GetNumberOfDroppedMessages()).";
+      }
+      break;
+    }
+  }
+  if (dropped > 0)
+    this->m_DroppedMessages[messageClass] += dropped;
+}
 
-  m_SendQueue.push_back(message);
-  this->m_Mutex->Unlock();
+void mitk::IGTLMessageQueue::PushSendMessage(mitk::IGTLMessage::Pointer message)
+{
+  this->Push(SendMessages, m_SendQueue, message);
 }
 
 void mitk::IGTLMessageQueue::PushCommandMessage(igtl::MessageBase::Pointer message)
 {
-  this->m_Mutex->Lock();
-  if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-    m_CommandQueue.clear();
-
-  m_CommandQueue.push_back(message);
-  this->m_Mutex->Unlock();
+  this->Push(CommandMessages, m_CommandQueue, message);
 }
 
 void mitk::IGTLMessageQueue::PushMessage(igtl::MessageBase::Pointer msg)
 {
-  this->m_Mutex->Lock();
-
-  std::stringstream infolog;
-
-  infolog << "Received message of type ";
-
   if (dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_TrackingDataQueue.clear();
-
-    this->m_TrackingDataQueue.push_back(dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer()));
-
-    infolog << "TDATA";
+    igtl::TrackingDataMessage::Pointer trackingMsg = dynamic_cast<igtl::TrackingDataMessage*>(msg.GetPointer());
+    this->Push(TrackingDataMessages, m_TrackingDataQueue, trackingMsg);
   }
   else if (dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_TransformQueue.clear();
-
-    this->m_TransformQueue.push_back(dynamic_cast<igtl::TransformMessage*>(msg.GetPointer()));
-
-    infolog << "TRANSFORM";
+    igtl::TransformMessage::Pointer transformMsg = dynamic_cast<igtl::TransformMessage*>(msg.GetPointer());
+    this->Push(TransformMessages, m_TransformQueue, transformMsg);
   }
   else if (dynamic_cast<igtl::StringMessage*>(msg.GetPointer()) != nullptr)
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_StringQueue.clear();
-
-    this->m_StringQueue.push_back(dynamic_cast<igtl::StringMessage*>(msg.GetPointer()));
-
-    infolog << "STRING";
+    igtl::StringMessage::Pointer stringMsg = dynamic_cast<igtl::StringMessage*>(msg.GetPointer());
+    this->Push(StringMessages, m_StringQueue, stringMsg);
   }
   else if (dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()) != nullptr)
   {
     igtl::ImageMessage::Pointer imageMsg = dynamic_cast<igtl::ImageMessage*>(msg.GetPointer());
-    int* dim = new int[3];
+    int dim[3];
     imageMsg->GetDimensions(dim);
     if (dim[2] > 1)
     {
-      if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-        m_Image3dQueue.clear();
-
-      this->m_Image3dQueue.push_back(dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()));
-
-      infolog << "IMAGE3D";
+      this->Push(Image3dMessages, m_Image3dQueue, imageMsg);
     }
     else
     {
-      if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-        m_Image2dQueue.clear();
-
-      this->m_Image2dQueue.push_back(dynamic_cast<igtl::ImageMessage*>(msg.GetPointer()));
-
-      infolog << "IMAGE2D";
+      this->Push(Image2dMessages, m_Image2dQueue, imageMsg);
     }
   }
   else
   {
-    if (this->m_BufferingType == IGTLMessageQueue::NoBuffering)
-      m_MiscQueue.clear();
-
-    this->m_MiscQueue.push_back(msg);
-
-    infolog << "OTHER";
+    this->Push(MiscMessages, m_MiscQueue, msg);
   }
 
+  this->m_Mutex->Lock();
   m_Latest_Message = msg;
-
-  //MITK_INFO << infolog.str();
-
   this->m_Mutex->Unlock();
 }
 
 mitk::IGTLMessage::Pointer mitk::IGTLMessageQueue::PullSendMessage()
 {
   mitk::IGTLMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_SendQueue.size() > 0)
-  {
-    ret = this->m_SendQueue.front();
-    this->m_SendQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_SendQueue.Pull(ret);
   return ret;
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullMiscMessage()
 {
   igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_MiscQueue.size() > 0)
-  {
-    ret = this->m_MiscQueue.front();
-    this->m_MiscQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_MiscQueue.Pull(ret);
   return ret;
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLMessageQueue::PullImage2dMessage()
 {
   igtl::ImageMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_Image2dQueue.size() > 0)
-  {
-    ret = this->m_Image2dQueue.front();
-    this->m_Image2dQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_Image2dQueue.Pull(ret);
   return ret;
 }
 
 igtl::ImageMessage::Pointer mitk::IGTLMessageQueue::PullImage3dMessage()
 {
   igtl::ImageMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_Image3dQueue.size() > 0)
-  {
-    ret = this->m_Image3dQueue.front();
-    this->m_Image3dQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_Image3dQueue.Pull(ret);
   return ret;
 }
 
 igtl::TrackingDataMessage::Pointer mitk::IGTLMessageQueue::PullTrackingMessage()
 {
   igtl::TrackingDataMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_TrackingDataQueue.size() > 0)
-  {
-    ret = this->m_TrackingDataQueue.front();
-    this->m_TrackingDataQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_TrackingDataQueue.Pull(ret);
   return ret;
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullCommandMessage()
 {
   igtl::MessageBase::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_CommandQueue.size() > 0)
-  {
-    ret = this->m_CommandQueue.front();
-    this->m_CommandQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_CommandQueue.Pull(ret);
   return ret;
 }
 
 igtl::StringMessage::Pointer mitk::IGTLMessageQueue::PullStringMessage()
 {
   igtl::StringMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_StringQueue.size() > 0)
-  {
-    ret = this->m_StringQueue.front();
-    this->m_StringQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_StringQueue.Pull(ret);
   return ret;
 }
 
 igtl::TransformMessage::Pointer mitk::IGTLMessageQueue::PullTransformMessage()
 {
   igtl::TransformMessage::Pointer ret = nullptr;
-  this->m_Mutex->Lock();
-  if (this->m_TransformQueue.size() > 0)
-  {
-    ret = this->m_TransformQueue.front();
-    this->m_TransformQueue.pop_front();
-  }
-  this->m_Mutex->Unlock();
+  this->m_TransformQueue.Pull(ret);
   return ret;
 }
 
@@ -286,27 +238,100 @@ std::string mitk::IGTLMessageQueue::GetLatestMsgDeviceType()
 
 int mitk::IGTLMessageQueue::GetSize()
 {
-  return (this->m_CommandQueue.size() + this->m_Image2dQueue.size() + this->m_Image3dQueue.size() + this->m_MiscQueue.size()
-    + this->m_StringQueue.size() + this->m_TrackingDataQueue.size() + this->m_TransformQueue.size());
+  return static_cast<int>(this->m_CommandQueue.GetSize() + this->m_Image2dQueue.GetSize() + this->m_Image3dQueue.GetSize() + this->m_MiscQueue.GetSize()
+    + this->m_StringQueue.GetSize() + this->m_TrackingDataQueue.GetSize() + this->m_TransformQueue.GetSize());
 }
 
 void mitk::IGTLMessageQueue::EnableNoBufferingMode(bool enable)
 {
-  this->m_Mutex->Lock();
   if (enable)
     this->m_BufferingType = IGTLMessageQueue::BufferingType::NoBuffering;
   else
     this->m_BufferingType = IGTLMessageQueue::BufferingType::Infinit;
-  this->m_Mutex->Unlock();
+}
+
+void mitk::IGTLMessageQueue::SetBufferingPolicy(MessageClass messageClass, BufferingPolicy policy)
+{
+  CheckMessageClass(messageClass);
+  this->m_BufferingPolicies[messageClass] = policy;
+}
+
+mitk::IGTLMessageQueue::BufferingPolicy mitk::IGTLMessageQueue::GetBufferingPolicy(MessageClass messageClass) const
+{
+  CheckMessageClass(messageClass);
+  return this->m_BufferingPolicies[messageClass];
+}
+
+void mitk::IGTLMessageQueue::SetCapacity(MessageClass messageClass, unsigned int capacity)
+{
+  switch (messageClass)
+  {
+  case CommandMessages: this->m_CommandQueue.Allocate(capacity); break;
+  case Image2dMessages: this->m_Image2dQueue.Allocate(capacity); break;
+  case Image3dMessages: this->m_Image3dQueue.Allocate(capacity); break;
+  case TransformMessages: this->m_TransformQueue.Allocate(capacity); break;
+  case TrackingDataMessages: this->m_TrackingDataQueue.Allocate(capacity); break;
+  case StringMessages: this->m_StringQueue.Allocate(capacity); break;
+  case MiscMessages: this->m_MiscQueue.Allocate(capacity); break;
+  case SendMessages: this->m_SendQueue.Allocate(capacity); break;
+  default: mitkThrow() << "Invalid message class " << messageClass;
+  }
+}
+
+unsigned int mitk::IGTLMessageQueue::GetCapacity(MessageClass messageClass) const
+{
+  switch (messageClass)
+  {
+  case CommandMessages: return this->m_CommandQueue.GetCapacity();
+  case Image2dMessages: return this->m_Image2dQueue.GetCapacity();
+  case Image3dMessages: return this->m_Image3dQueue.GetCapacity();
+  case TransformMessages: return this->m_TransformQueue.GetCapacity();
+  case TrackingDataMessages: return this->m_TrackingDataQueue.GetCapacity();
+  case StringMessages: return this->m_StringQueue.GetCapacity();
+  case MiscMessages: return this->m_MiscQueue.GetCapacity();
+  case SendMessages: return this->m_SendQueue.GetCapacity();
+  default: mitkThrow() << "Invalid message class " << messageClass;
+  }
+}
+
+unsigned long mitk::IGTLMessageQueue::GetNumberOfDroppedMessages(MessageClass messageClass) const
+{
+  CheckMessageClass(messageClass);
+  return this->m_DroppedMessages[messageClass];
 }
 
 mitk::IGTLMessageQueue::IGTLMessageQueue()
 {
   this->m_Mutex = itk::FastMutexLock::New();
   this->m_BufferingType = IGTLMessageQueue::NoBuffering;
+
+  //tracking data and images are only interesting as long as they are recent,
+  //commands and messages to be sent must not get lost silently
+  this->SetCapacity(CommandMessages, 64);
+  this->SetCapacity(Image2dMessages, 32);
+  this->SetCapacity(Image3dMessages, 8);
+  this->SetCapacity(TransformMessages, 1024);
+  this->SetCapacity(TrackingDataMessages, 1024);
+  this->SetCapacity(StringMessages, 256);
+  this->SetCapacity(MiscMessages, 256);
+  this->SetCapacity(SendMessages, 256);
+
+  this->m_BufferingPolicies[CommandMessages] = BoundedFIFO;
+  this->m_BufferingPolicies[Image2dMessages] = DropOldest;
+  this->m_BufferingPolicies[Image3dMessages] = DropOldest;
+  this->m_BufferingPolicies[TransformMessages] = DropOldest;
+  this->m_BufferingPolicies[TrackingDataMessages] = DropOldest;
+  this->m_BufferingPolicies[StringMessages] = BoundedFIFO;
+  this->m_BufferingPolicies[MiscMessages] = BoundedFIFO;
+  this->m_BufferingPolicies[SendMessages] = BoundedFIFO;
+
+  for (int i = 0; i < NumberOfMessageClasses; ++i)
+  {
+    this->m_DroppedMessages[i] = 0;
+    this->m_RejectionWarned[i] = false;
+  }
 }
 
 mitk::IGTLMessageQueue::~IGTLMessageQueue()
 {
-  this->m_Mutex->Unlock();
 }
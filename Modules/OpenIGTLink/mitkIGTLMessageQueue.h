@@ -23,8 +23,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkFastMutexLock.h"
 #include "mitkCommon.h"
 
-#include <deque>
+#include <atomic>
 #include <mitkIGTLMessage.h>
+#include "mitkIGTLMessageRingBuffer.h"
 
 //OpenIGTLink
 #include "igtlMessageBase.h"
@@ -38,6 +39,12 @@ namespace mitk {
   * \class IGTLMessageQueue
   * \brief Thread safe message queue to store OpenIGTLink messages.
   *
+  * Every class of messages is stored in its own preallocated lock-free ring
+  * buffer, so the receiving thread and the pipeline do not block each other
+  * and the memory is bounded. What happens when a buffer is full is defined
+  * per message class by its BufferingPolicy. In the no buffering mode every
+  * buffer just keeps the latest message.
+  *
   * \ingroup OpenIGTLink
   */
   class MITKOPENIGTLINK_EXPORT IGTLMessageQueue : public itk::Object
@@ -54,6 +61,20 @@ namespace mitk {
        */
     enum BufferingType { Infinit, NoBuffering };
 
+    /**
+    * \brief The classes of messages, each of them has its own buffer
+    */
+    enum MessageClass { CommandMessages, Image2dMessages, Image3dMessages,
+      TransformMessages, TrackingDataMessages, StringMessages, MiscMessages,
+      SendMessages, NumberOfMessageClasses };
+
+    /**
+     * \brief Defines what happens when a message is pushed into a full buffer
+     * LatestOnly keeps only the new message, DropOldest removes the oldest
+     * message to make room and BoundedFIFO rejects the new message
+     */
+    enum BufferingPolicy { LatestOnly, DropOldest, BoundedFIFO };
+
     void PushSendMessage(mitk::IGTLMessage::Pointer message);
 
     /**
@@ -105,38 +126,90 @@ namespace mitk {
     std::string GetLatestMsgDeviceType();
 
     /**
-     */
+    * \brief If enabled every buffer keeps only the latest message, otherwise
+    * the buffering policy of the message class is applied
+    */
     void EnableNoBufferingMode(bool enable);
 
+    /**
+    * \brief Sets the policy that is applied when the buffer of the given
+    * message class is full and the no buffering mode is disabled
+    */
+    void SetBufferingPolicy(MessageClass messageClass, BufferingPolicy policy);
+    BufferingPolicy GetBufferingPolicy(MessageClass messageClass) const;
+
+    /**
+    * \brief Sets the number of messages the buffer of the given message class
+    * can hold, the capacity is rounded up to a power of two
+    *
+    * The buffer is reallocated and all its messages are discarded. This is
+    * not thread safe, call it before the communication is started.
+    */
+    void SetCapacity(MessageClass messageClass, unsigned int capacity);
+    unsigned int GetCapacity(MessageClass messageClass) const;
+
+    /**
+    * \brief Returns the number of messages of the given class that were
+    * dropped because the buffer was full
+    *
+    * Invalid message classes throw an mitk::Exception, like in
+    * SetBufferingPolicy() and SetCapacity().
+    */
+    unsigned long GetNumberOfDroppedMessages(MessageClass messageClass) const;
+
   protected:
     IGTLMessageQueue();
     virtual ~IGTLMessageQueue();
 
+    /**
+    * \brief Pushes the message into the buffer according to the buffering
+    * mode and the policy of the message class
+    */
+    template <typename TPointer>
+    void Push(MessageClass messageClass, IGTLMessageRingBuffer<TPointer>& buffer,
+      const TPointer& message);
+
   protected:
     /**
-    * \brief Mutex to take car of the queue
+    * \brief Mutex to take care of the latest message
     */
     itk::FastMutexLock::Pointer m_Mutex;
 
     /**
-    * \brief the queue that stores pointer to the inserted messages
+    * \brief the buffers that store pointer to the inserted messages
     */
-    std::deque< igtl::MessageBase::Pointer > m_CommandQueue;
-    std::deque< igtl::ImageMessage::Pointer > m_Image2dQueue;
-    std::deque< igtl::ImageMessage::Pointer > m_Image3dQueue;
-    std::deque< igtl::TransformMessage::Pointer > m_TransformQueue;
-    std::deque< igtl::TrackingDataMessage::Pointer > m_TrackingDataQueue;
-    std::deque< igtl::StringMessage::Pointer > m_StringQueue;
-    std::deque< igtl::MessageBase::Pointer > m_MiscQueue;
+    IGTLMessageRingBuffer< igtl::MessageBase::Pointer > m_CommandQueue;
+    IGTLMessageRingBuffer< igtl::ImageMessage::Pointer > m_Image2dQueue;
+    IGTLMessageRingBuffer< igtl::ImageMessage::Pointer > m_Image3dQueue;
+    IGTLMessageRingBuffer< igtl::TransformMessage::Pointer > m_TransformQueue;
+    IGTLMessageRingBuffer< igtl::TrackingDataMessage::Pointer > m_TrackingDataQueue;
+    IGTLMessageRingBuffer< igtl::StringMessage::Pointer > m_StringQueue;
+    IGTLMessageRingBuffer< igtl::MessageBase::Pointer > m_MiscQueue;
 
-    std::deque< mitk::IGTLMessage::Pointer > m_SendQueue;
+    IGTLMessageRingBuffer< mitk::IGTLMessage::Pointer > m_SendQueue;
 
     igtl::MessageBase::Pointer m_Latest_Message;
 
     /**
     * \brief defines the kind of buffering
     */
-    BufferingType m_BufferingType;
+    std::atomic<BufferingType> m_BufferingType;
+
+    /**
+    * \brief the policy of every message class for the buffered mode
+    */
+    std::atomic<BufferingPolicy> m_BufferingPolicies[NumberOfMessageClasses];
+
+    /**
+    * \brief the number of messages that were dropped per message class
+    */
+    std::atomic<unsigned long> m_DroppedMessages[NumberOfMessageClasses];
+
+    /**
+    * \brief whether the rejection of a message was already logged per message
+    * class, BoundedFIFO warns only once
+    */
+    std::atomic<bool> m_RejectionWarned[NumberOfMessageClasses];
   };
 }
 
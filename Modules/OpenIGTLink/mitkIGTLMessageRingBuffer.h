@@ -0,0 +1,210 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef IGTLMessageRingBuffer_H
+#define IGTLMessageRingBuffer_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace mitk {
+  /**
+  * \class IGTLMessageRingBuffer
+  * \brief Preallocated lock-free ring buffer of message pointers.
+  *
+  * Every slot carries a sequence number that tells whether it is free or
+  * filled, so producer and consumer never wait for each other. The buffer is
+  * meant to be filled by one thread and emptied by another one. The sequence
+  * numbers also make it safe if the producer removes the oldest entries
+  * itself when the buffer is full (see PushDropOldest()) or if several
+  * threads push, as for the send queue.
+  *
+  * The capacity is rounded up to a power of two.
+  *
+  * \ingroup OpenIGTLink
+  */
+  template <typename TPointer>
+  class IGTLMessageRingBuffer
+  {
+  public:
+    explicit IGTLMessageRingBuffer(size_t capacity = 1)
+    {
+      this->Allocate(capacity);
+    }
+
+    /**
+    * \brief Discards all entries and changes the capacity.
+    *
+    * Not thread safe, only call this while no other thread uses the buffer.
+    */
+    void Allocate(size_t capacity)
+    {
+      size_t size = 1;
+      while (size < capacity)
+        size <<= 1;
+
+      std::vector<Slot> slots(size);
+      for (size_t i = 0; i < size; ++i)
+        slots[i].Sequence.store(i, std::memory_order_relaxed);
+      m_Slots.swap(slots);
+      m_Mask = size - 1;
+      m_PushPosition.store(0, std::memory_order_relaxed);
+      m_PullPosition.store(0, std::memory_order_relaxed);
+    }
+
+    size_t GetCapacity() const
+    {
+      return m_Slots.size();
+    }
+
+    /**
+    * \brief Approximate number of entries, exact if no other thread modifies
+    * the buffer at the same time
+    */
+    size_t GetSize() const
+    {
+      size_t pull = m_PullPosition.load(std::memory_order_acquire);
+      size_t push = m_PushPosition.load(std::memory_order_acquire);
+      return push > pull ? push - pull : 0;
+    }
+
+    /**
+    * \brief Adds the entry, returns false if the buffer is full
+    */
+    bool Push(const TPointer& entry)
+    {
+      size_t position = m_PushPosition.load(std::memory_order_relaxed);
+      Slot* slot;
+      for (;;)
+      {
+        slot = &m_Slots[position & m_Mask];
+        size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0)
+        {
+          if (m_PushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (difference < 0)
+        {
+          return false;
+        }
+        else
+        {
+          position = m_PushPosition.load(std::memory_order_relaxed);
+        }
+      }
+      slot->Entry = entry;
+      slot->Sequence.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+    * \brief Adds the entry and removes the oldest ones if the buffer is full
+    * \return the number of entries that were dropped
+    */
+    size_t PushDropOldest(const TPointer& entry)
+    {
+      size_t dropped = 0;
+      TPointer oldest;
+      while (!this->Push(entry))
+      {
+        if (this->Pull(oldest))
+          ++dropped;
+      }
+      return dropped;
+    }
+
+    /**
+    * \brief Removes all entries and adds the given one
+    * \return the number of entries that were dropped
+    */
+    size_t PushLatestOnly(const TPointer& entry)
+    {
+      size_t dropped = this->Clear();
+      return dropped + this->PushDropOldest(entry);
+    }
+
+    /**
+    * \brief Removes the oldest entry, returns false if the buffer is empty
+    */
+    bool Pull(TPointer& entry)
+    {
+      size_t position = m_PullPosition.load(std::memory_order_relaxed);
+      Slot* slot;
+      for (;;)
+      {
+        slot = &m_Slots[position & m_Mask];
+        size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+        if (difference == 0)
+        {
+          if (m_PullPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (difference < 0)
+        {
+          return false;
+        }
+        else
+        {
+          position = m_PullPosition.load(std::memory_order_relaxed);
+        }
+      }
+      entry = slot->Entry;
+      // release the reference held by the slot
+      slot->Entry = TPointer();
+      slot->Sequence.store(position + m_Mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+    * \brief Removes all entries
+    * \return the number of removed entries
+    */
+    size_t Clear()
+    {
+      size_t removed = 0;
+      TPointer entry;
+      while (this->Pull(entry))
+        ++removed;
+      return removed;
+    }
+
+  private:
+    IGTLMessageRingBuffer(const IGTLMessageRingBuffer&);
+    IGTLMessageRingBuffer& operator=(const IGTLMessageRingBuffer&);
+
+    struct Slot
+    {
+      Slot() : Sequence(0) {}
+      std::atomic<size_t> Sequence;
+      TPointer Entry;
+    };
+
+    std::vector<Slot> m_Slots;
+    size_t m_Mask;
+    // keep producer and consumer position on different cache lines
+    char m_PaddingBefore[64];
+    std::atomic<size_t> m_PushPosition;
+    char m_PaddingBetween[64];
+    std::atomic<size_t> m_PullPosition;
+    char m_PaddingAfter[64];
+  };
+}
+
+#endif
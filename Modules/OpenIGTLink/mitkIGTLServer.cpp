@@ -20,7 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <itkMutexLockHolder.h>
 
-#include <igtlServerSocket.h>
+#include "mitkIGTLSocket.h"
 #include <igtlTrackingDataMessage.h>
 #include <igtlImageMessage.h>
 #include <igtl_status.h>
@@ -56,11 +56,11 @@ bool mitk::IGTLServer::OpenConnection()
   }
 
   //create a new server socket
-  m_Socket = igtl::ServerSocket::New();
+  mitk::IGTLServerSocket::Pointer serverSocket = mitk::IGTLServerSocket::New();
+  m_Socket = serverSocket;
 
   //try to create the igtl server
-  int response = dynamic_cast<igtl::ServerSocket*>(m_Socket.GetPointer())->
-    CreateServer(portNumber);
+  int response = serverSocket->CreateServer(portNumber);
 
   //check the response
   if (response != 0)
@@ -94,7 +94,7 @@ void mitk::IGTLServer::Connect()
   igtl::Socket::Pointer socket;
   //check if another igtl device wants to connect to this socket
   socket =
-    ((igtl::ServerSocket*)(this->m_Socket.GetPointer()))->WaitForConnection(1);
+    static_cast<mitk::IGTLServerSocket*>(this->m_Socket.GetPointer())->WaitForConnection(1);
   //if there is a new connection the socket is not null
   if (socket.IsNotNull())
   {
@@ -112,6 +112,12 @@ void mitk::IGTLServer::Connect()
 
 void mitk::IGTLServer::Receive()
 {
+  if (this->m_UseEventDrivenCommunication)
+  {
+    this->ReceiveEventDriven();
+    return;
+  }
+
   unsigned int status = IGTL_STATUS_OK;
   SocketListType socketsToBeRemoved;
 
@@ -148,8 +154,65 @@ void mitk::IGTLServer::Receive()
   }
 }
 
+void mitk::IGTLServer::ReceiveEventDriven()
+{
+  //wait for the server socket and all registered clients at once, the server
+  //socket becomes readable when a new client wants to connect
+  m_ReceiveListMutex->Lock();
+  SocketListType clients(this->m_RegisteredClients);
+  m_ReceiveListMutex->Unlock();
+
+  std::vector<igtl::Socket*> sockets;
+  sockets.reserve(clients.size() + 1);
+  sockets.push_back(this->m_Socket.GetPointer());
+  for (auto it = clients.begin(); it != clients.end(); ++it)
+    sockets.push_back(*it);
+
+  std::vector<bool> readable;
+  if (this->WaitForReadableSockets(sockets, readable) <= 0)
+    return;
+
+  if (readable[0])
+  {
+    this->Connect();
+  }
+
+  SocketListType socketsToBeRemoved;
+  size_t i = 1;
+  for (auto it = clients.begin(); it != clients.end(); ++it, ++i)
+  {
+    if (!readable[i])
+      continue;
+
+    unsigned int status = this->ReceiveBufferedPrivate(*it);
+    if (status == IGTL_STATUS_NOT_PRESENT)
+    {
+      socketsToBeRemoved.push_back(*it);
+      MITK_WARN("IGTLServer") << "Lost connection to a client socket. ";
+    }
+    else if (status != IGTL_STATUS_OK)
+    {
+      MITK_DEBUG("IGTLServer") << "IGTL Message with status: " << status;
+    }
+  }
+
+  if (socketsToBeRemoved.size() > 0)
+  {
+    //remove the sockets that are not connected anymore
+    this->StopCommunicationWithSocket(socketsToBeRemoved);
+    //inform observers about loosing the connection to these sockets
+    this->InvokeEvent(LostConnectionEvent());
+  }
+}
+
 void mitk::IGTLServer::Send()
 {
+  if (this->m_UseEventDrivenCommunication)
+  {
+    this->SendEventDriven();
+    return;
+  }
+
   //get the latest message from the queue
   mitk::IGTLMessage::Pointer curMessage = this->m_MessageQueue->PullSendMessage();
 
@@ -177,6 +240,25 @@ void mitk::IGTLServer::Send()
   m_SentListMutex->Unlock();
 }
 
+void mitk::IGTLServer::SendEventDriven()
+{
+  //sleeps until messages are enqueued
+  std::vector<mitk::IGTLMessage::Pointer> messages = this->WaitForSendMessages();
+  if (messages.empty())
+    return;
+
+  //broadcast all pending messages to every registered client
+  m_SentListMutex->Lock();
+  for (auto it = this->m_RegisteredClients.begin(); it != this->m_RegisteredClients.end(); ++it)
+  {
+    if (this->SendMessagesPrivate(messages, *it) != IGTL_STATUS_OK)
+    {
+      MITK_DEBUG("IGTLServer") << "Could not send " << messages.size() << " IGTL messages";
+    }
+  }
+  m_SentListMutex->Unlock();
+}
+
 void mitk::IGTLServer::StopCommunicationWithSocket(
   SocketListType& toBeRemovedSockets)
 {
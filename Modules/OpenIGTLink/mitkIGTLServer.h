@@ -97,6 +97,18 @@ namespace mitk
     */
     virtual void Send() override;
 
+    /**
+    * \brief Waits for new clients and for messages of all registered clients
+    * at once and receives everything that is available.
+    */
+    virtual void ReceiveEventDriven();
+
+    /**
+    * \brief Waits for queued messages and sends them to all registered
+    * clients.
+    */
+    virtual void SendEventDriven();
+
     /**
       * \brief Stops the communication with the given sockets.
       *
@@ -0,0 +1,76 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIGTLSocket.h"
+
+#include <mitkLogMacros.h>
+
+mitk::IGTLClientSocket::IGTLClientSocket()
+{
+}
+
+mitk::IGTLClientSocket::~IGTLClientSocket()
+{
+}
+
+int mitk::IGTLClientSocket::GetDescriptor() const
+{
+  return this->m_SocketDescriptor;
+}
+
+mitk::IGTLServerSocket::IGTLServerSocket()
+{
+}
+
+mitk::IGTLServerSocket::~IGTLServerSocket()
+{
+}
+
+int mitk::IGTLServerSocket::GetDescriptor() const
+{
+  return this->m_SocketDescriptor;
+}
+
+igtl::ClientSocket::Pointer mitk::IGTLServerSocket::WaitForConnection(unsigned long msec)
+{
+  if (this->m_SocketDescriptor < 0)
+  {
+    return nullptr;
+  }
+
+  int ret = this->SelectSocket(this->m_SocketDescriptor, msec);
+  if (ret == 0)
+  {
+    //no connection within the given time
+    return nullptr;
+  }
+  if (ret < 0)
+  {
+    MITK_ERROR("IGTLServerSocket") << "Error selecting the server socket.";
+    return nullptr;
+  }
+
+  int clientDescriptor = this->Accept(this->m_SocketDescriptor);
+  if (clientDescriptor < 0)
+  {
+    MITK_ERROR("IGTLServerSocket") << "Failed to accept a connection.";
+    return nullptr;
+  }
+
+  mitk::IGTLClientSocket::Pointer clientSocket = mitk::IGTLClientSocket::New();
+  clientSocket->m_SocketDescriptor = clientDescriptor;
+  return clientSocket.GetPointer();
+}
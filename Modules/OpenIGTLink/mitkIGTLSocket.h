@@ -0,0 +1,92 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIGTLSOCKET_H
+#define MITKIGTLSOCKET_H
+
+#include <igtlClientSocket.h>
+#include <igtlServerSocket.h>
+
+#include "MitkOpenIGTLinkExports.h"
+
+namespace mitk
+{
+  class IGTLServerSocket;
+
+  /**
+  * \brief igtl::ClientSocket that exposes its socket descriptor
+  *
+  * mitk::IGTLDevice needs the descriptor to wait for several sockets at once
+  * and to send several messages with one system call.
+  *
+  * \ingroup OpenIGTLink
+  */
+  class MITKOPENIGTLINK_EXPORT IGTLClientSocket : public igtl::ClientSocket
+  {
+  public:
+    typedef IGTLClientSocket Self;
+    typedef igtl::ClientSocket Superclass;
+    typedef igtl::SmartPointer<Self> Pointer;
+    typedef igtl::SmartPointer<const Self> ConstPointer;
+
+    igtlTypeMacro(mitk::IGTLClientSocket, igtl::ClientSocket);
+    igtlNewMacro(mitk::IGTLClientSocket);
+
+    /** \brief Returns the descriptor of the socket, -1 if it is not connected */
+    int GetDescriptor() const;
+
+  protected:
+    IGTLClientSocket();
+    virtual ~IGTLClientSocket();
+
+    /** sockets accepted by IGTLServerSocket are created with the descriptor of the connection */
+    friend class IGTLServerSocket;
+  };
+
+  /**
+  * \brief igtl::ServerSocket that exposes its socket descriptor and accepts
+  * connections as IGTLClientSocket
+  *
+  * \ingroup OpenIGTLink
+  */
+  class MITKOPENIGTLINK_EXPORT IGTLServerSocket : public igtl::ServerSocket
+  {
+  public:
+    typedef IGTLServerSocket Self;
+    typedef igtl::ServerSocket Superclass;
+    typedef igtl::SmartPointer<Self> Pointer;
+    typedef igtl::SmartPointer<const Self> ConstPointer;
+
+    igtlTypeMacro(mitk::IGTLServerSocket, igtl::ServerSocket);
+    igtlNewMacro(mitk::IGTLServerSocket);
+
+    /** \brief Returns the descriptor of the socket, -1 if the server was not created */
+    int GetDescriptor() const;
+
+    /**
+    * \brief Waits for a connection like igtl::ServerSocket::WaitForConnection()
+    * \return the accepted connection as IGTLClientSocket or nullptr if there
+    * was no connection within msec milliseconds
+    */
+    igtl::ClientSocket::Pointer WaitForConnection(unsigned long msec = 0);
+
+  protected:
+    IGTLServerSocket();
+    virtual ~IGTLServerSocket();
+  };
+}
+
+#endif
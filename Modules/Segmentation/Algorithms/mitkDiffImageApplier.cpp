@@ -47,6 +47,11 @@ void mitk::DiffImageApplier::ExecuteOperation(Operation *operation)
     Image::Pointer image3D = m_Image; // will be changed later in case of 3D+t
 
     m_SliceDifferenceImage = imageOperation->GetDiffImage();
+    if (m_SliceDifferenceImage.IsNull())
+    {
+      MITK_ERROR << "Could not restore the difference image of the undo operation, the image is left unchanged.";
+      return;
+    }
     m_TimeStep = imageOperation->GetTimeStep();
 
     m_Factor = imageOperation->GetFactor();
@@ -90,6 +90,11 @@ mitk::Image::Pointer mitk::DiffSliceOperation::GetSlice()
   return image;
 }
 
+std::size_t mitk::DiffSliceOperation::GetMemoryUsage() const
+{
+  return m_zlibSliceContainer.IsNotNull() ? m_zlibSliceContainer->GetCompressedSize() : 0;
+}
+
 bool mitk::DiffSliceOperation::IsValid()
 {
   return m_ImageIsValid && m_zlibSliceContainer.IsNotNull() && (m_WorldGeometry.IsNotNull()); // TODO improve
@@ -64,6 +64,9 @@ namespace mitk
     /** \brief Check if it is a valid operation.*/
     bool IsValid();
 
+    /** \brief Size of the compressed slice.*/
+    virtual std::size_t GetMemoryUsage() const override;
+
     /** \brief Set the image volume.*/
     void SetImage(mitk::Image *image) { this->m_Image = image; }
     /** \brief Get th image volume.*/
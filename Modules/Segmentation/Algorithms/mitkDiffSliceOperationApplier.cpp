@@ -48,6 +48,12 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation(Operation *operation)
     vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
 
     mitk::Image::Pointer slice = imageOperation->GetSlice();
+    if (slice.IsNull())
+    {
+      MITK_ERROR << "Could not restore the slice of the undo operation, the image is left unchanged.";
+      return;
+    }
+
     // Set the slice as 'input'
     reslice->SetInputSlice(const_cast<vtkImageData *>(slice->GetVtkImageData()));
 
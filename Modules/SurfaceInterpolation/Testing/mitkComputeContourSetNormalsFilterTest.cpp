@@ -17,6 +17,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkComputeContourSetNormalsFilter.h>
 #include <mitkIOUtil.h>
 #include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
 #include <mitkSurface.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingMacros.h>
@@ -26,6 +28,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <vtkDebugLeaks.h>
 
+#include <cstring>
+
 class mitkComputeContourSetNormalsFilterTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkComputeContourSetNormalsFilterTestSuite);
@@ -35,6 +39,7 @@ class mitkComputeContourSetNormalsFilterTestSuite : public mitk::TestFixture
 
   MITK_TEST(TestComputeNormals);
   MITK_TEST(TestComputeNormalsWithHole);
+  MITK_TEST(TestComputeNormalsWithHoleAfterSegmentationChanged);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -98,6 +103,51 @@ public:
                            contourWithNormals->GetVtkPolyData()->GetCellData()->GetNormals()->GetNumberOfTuples() ==
                              contourReference->GetVtkPolyData()->GetNumberOfPoints());
   }
+
+  // The normals of unchanged contours are reused, but not if the segmentation which orients them changed
+  void TestComputeNormalsWithHoleAfterSegmentationChanged()
+  {
+    mitk::Image::Pointer segmentationImage =
+      dynamic_cast<mitk::Image*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverSegmentation.nrrd"))[0].GetPointer());
+
+    mitk::Surface::Pointer contour =
+      dynamic_cast<mitk::Surface*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/ComputeNormals/ContourWithHoles.vtk"))[0].GetPointer());
+
+    // First orient the normals with an empty segmentation
+    mitk::Image::Pointer changingSegmentationImage = segmentationImage->Clone();
+    const std::size_t size = changingSegmentationImage->GetDimension(0) * changingSegmentationImage->GetDimension(1) *
+                             changingSegmentationImage->GetDimension(2) *
+                             changingSegmentationImage->GetPixelType().GetSize();
+    {
+      mitk::ImageWriteAccessor writeAccess(changingSegmentationImage);
+      std::memset(writeAccess.GetData(), 0, size);
+    }
+    changingSegmentationImage->Modified();
+
+    m_ContourNormalsFilter->SetInput(contour);
+    m_ContourNormalsFilter->SetSegmentationBinaryImage(changingSegmentationImage);
+    m_ContourNormalsFilter->Update();
+
+    // Then change the segmentation in place, the contour stays the same
+    {
+      mitk::ImageReadAccessor readAccess(segmentationImage);
+      mitk::ImageWriteAccessor writeAccess(changingSegmentationImage);
+      std::memcpy(writeAccess.GetData(), readAccess.GetData(), size);
+    }
+    changingSegmentationImage->Modified();
+
+    // the segmentation is no input of the pipeline
+    m_ContourNormalsFilter->Modified();
+    m_ContourNormalsFilter->Update();
+    mitk::Surface::Pointer normals = m_ContourNormalsFilter->GetNormalsAsSurface();
+
+    mitk::Surface::Pointer normalsReference =
+      dynamic_cast<mitk::Surface*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/NormalsWithHoles.vtk"))[0].GetPointer());
+
+    CPPUNIT_ASSERT_MESSAGE(
+      "Normals were not oriented with the changed segmentation",
+      mitk::Equal(*(normals->GetVtkPolyData()), *(normalsReference->GetVtkPolyData()), 0.000001, true));
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkComputeContourSetNormalsFilter)
@@ -18,10 +18,21 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkCreateDistanceImageFromSurfaceFilter.h>
 #include <mitkIOUtil.h>
 #include <mitkImageAccessByItk.h>
+#include <mitkImagePixelReadAccessor.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingMacros.h>
 
+#include <itkImage.h>
+#include <itkMath.h>
+
+#include <vtkCellArray.h>
 #include <vtkDebugLeaks.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
 
 class mitkCreateDistanceImageFromSurfaceFilterTestSuite : public mitk::TestFixture
 {
@@ -29,6 +40,9 @@ class mitkCreateDistanceImageFromSurfaceFilterTestSuite : public mitk::TestFixtu
   vtkDebugLeaks::SetExitError(0);
   MITK_TEST(TestCreateDistanceImageForLiver);
   MITK_TEST(TestCreateDistanceImageForTube);
+  MITK_TEST(TestCreateDistanceImageForLiverWithCompactlySupportedRBF);
+  MITK_TEST(TestUpdateAfterAddingContour);
+  MITK_TEST(TestUpdateAfterAddingContourWithCompactlySupportedRBF);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -36,6 +50,145 @@ private:
 
 public:
   void setUp() override {}
+
+  // Circular contour around the z axis at (50, 50)
+  mitk::Surface::Pointer CreateCircularContour(double z, double radius)
+  {
+    const unsigned int numberOfPoints = 36;
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->InsertNextCell(numberOfPoints);
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      const double angle = 2.0 * itk::Math::pi * i / numberOfPoints;
+      polys->InsertCellPoint(
+        points->InsertNextPoint(50.0 + radius * std::cos(angle), 50.0 + radius * std::sin(angle), z));
+    }
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetPolys(polys);
+
+    mitk::Surface::Pointer contour = mitk::Surface::New();
+    contour->SetVtkPolyData(polyData);
+    return contour;
+  }
+
+  // Interpolates the first contours, adds the last one and interpolates again with the same filter. Returns the
+  // result and the result of a new filter for all contours.
+  void InterpolateBeforeAndAfterAddingContour(bool useCompactlySupportedRBF,
+                                              mitk::Image::Pointer &updatedDistanceImage,
+                                              mitk::Image::Pointer &distanceImage)
+  {
+    // The added contour lies within the bounds of the others, so the distance image keeps its geometry
+    contourList.push_back(CreateCircularContour(10.0, 30.0));
+    contourList.push_back(CreateCircularContour(40.0, 30.0));
+    contourList.push_back(CreateCircularContour(25.0, 20.0));
+
+    typedef itk::Image<unsigned char, 3> ReferenceImageType;
+    ReferenceImageType::Pointer referenceImage = ReferenceImageType::New();
+    ReferenceImageType::SizeType size;
+    size.Fill(100);
+    referenceImage->SetRegions(size);
+
+    mitk::ComputeContourSetNormalsFilter::Pointer normalsFilter = mitk::ComputeContourSetNormalsFilter::New();
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer interpolateSurfaceFilter =
+      mitk::CreateDistanceImageFromSurfaceFilter::New();
+    interpolateSurfaceFilter->SetUseCompactlySupportedRBF(useCompactlySupportedRBF);
+    interpolateSurfaceFilter->SetSupportRadius(15.0);
+    interpolateSurfaceFilter->SetReferenceImage(referenceImage.GetPointer());
+
+    for (unsigned int j = 0; j < contourList.size() - 1; j++)
+    {
+      normalsFilter->SetInput(j, contourList.at(j));
+      interpolateSurfaceFilter->SetInput(j, normalsFilter->GetOutput(j));
+    }
+    interpolateSurfaceFilter->Update();
+
+    const unsigned int last = contourList.size() - 1;
+    normalsFilter->SetInput(last, contourList.at(last));
+    interpolateSurfaceFilter->SetInput(last, normalsFilter->GetOutput(last));
+    interpolateSurfaceFilter->Update();
+    updatedDistanceImage = interpolateSurfaceFilter->GetOutput();
+
+    mitk::ComputeContourSetNormalsFilter::Pointer newNormalsFilter = mitk::ComputeContourSetNormalsFilter::New();
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer newInterpolateSurfaceFilter =
+      mitk::CreateDistanceImageFromSurfaceFilter::New();
+    newInterpolateSurfaceFilter->SetUseCompactlySupportedRBF(useCompactlySupportedRBF);
+    newInterpolateSurfaceFilter->SetSupportRadius(15.0);
+    newInterpolateSurfaceFilter->SetReferenceImage(referenceImage.GetPointer());
+
+    for (unsigned int j = 0; j < contourList.size(); j++)
+    {
+      newNormalsFilter->SetInput(j, contourList.at(j));
+      newInterpolateSurfaceFilter->SetInput(j, newNormalsFilter->GetOutput(j));
+    }
+    newInterpolateSurfaceFilter->Update();
+    distanceImage = newInterpolateSurfaceFilter->GetOutput();
+
+    CPPUNIT_ASSERT(updatedDistanceImage.IsNotNull());
+    CPPUNIT_ASSERT(distanceImage.IsNotNull());
+  }
+
+  // The factorization of the first contours is extended by the added one, which has to yield the same result
+  void TestUpdateAfterAddingContour()
+  {
+    mitk::Image::Pointer updatedDistanceImage;
+    mitk::Image::Pointer distanceImage;
+    this->InterpolateBeforeAndAfterAddingContour(false, updatedDistanceImage, distanceImage);
+
+    CPPUNIT_ASSERT_MESSAGE("Distance image of the updated interpolation differs!",
+                           mitk::Equal(*distanceImage, *updatedDistanceImage, 0.0001, true));
+  }
+
+  // Only the distances around the added contour are evaluated again, which has to yield nearly the same result
+  void TestUpdateAfterAddingContourWithCompactlySupportedRBF()
+  {
+    mitk::Image::Pointer updatedDistanceImage;
+    mitk::Image::Pointer distanceImage;
+    this->InterpolateBeforeAndAfterAddingContour(true, updatedDistanceImage, distanceImage);
+
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Distance images differ in size!",
+                                   distanceImage->GetDimension(dim),
+                                   updatedDistanceImage->GetDimension(dim));
+    }
+
+    // Weight changes below 1e-4 of the spacing are dropped, so the distances differ slightly
+    const double spacing = distanceImage->GetGeometry()->GetSpacing()[0];
+    mitk::ImagePixelReadAccessor<double, 3> accessor(updatedDistanceImage);
+    mitk::ImagePixelReadAccessor<double, 3> referenceAccessor(distanceImage);
+    itk::Index<3> index;
+    unsigned int numberOfNarrowBandPixels = 0;
+    unsigned int numberOfComparedPixels = 0;
+    double maximumError = 0.0;
+    for (index[2] = 0; index[2] < static_cast<itk::IndexValueType>(distanceImage->GetDimension(2)); ++index[2])
+    {
+      for (index[1] = 0; index[1] < static_cast<itk::IndexValueType>(distanceImage->GetDimension(1)); ++index[1])
+      {
+        for (index[0] = 0; index[0] < static_cast<itk::IndexValueType>(distanceImage->GetDimension(0)); ++index[0])
+        {
+          const double referenceDistance = referenceAccessor.GetPixelByIndex(index);
+          if (std::fabs(referenceDistance) > 2 * spacing)
+            continue;
+          ++numberOfNarrowBandPixels;
+
+          const double distance = accessor.GetPixelByIndex(index);
+          if (std::fabs(distance) > 2 * spacing)
+            continue;
+          ++numberOfComparedPixels;
+
+          maximumError = std::max(maximumError, std::fabs(distance - referenceDistance));
+        }
+      }
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Interpolation has no narrow band!", numberOfNarrowBandPixels > 0);
+    CPPUNIT_ASSERT_MESSAGE("Narrow band of the updated interpolation differs!",
+                           numberOfComparedPixels >= 0.99 * numberOfNarrowBandPixels);
+    CPPUNIT_ASSERT_MESSAGE("Distances of the updated interpolation differ!", maximumError <= 0.01 * spacing);
+  }
   template <typename TPixel, unsigned int VImageDimension>
   void GetImageBase(itk::Image<TPixel, VImageDimension> *input, itk::ImageBase<3>::Pointer &result)
   {
@@ -87,6 +240,101 @@ public:
                            mitk::Equal(*(liverDistanceImageReference), *(liverDistanceImage), 0.0001, true));
   }
 
+  // Interpolate the shape of a liver with compactly supported RBFs, which has to yield nearly the same segmentation
+  void TestCreateDistanceImageForLiverWithCompactlySupportedRBF()
+  {
+    unsigned int NUMBER_OF_LIVER_CONTOURS = 18;
+
+    for (unsigned int i = 0; i <= NUMBER_OF_LIVER_CONTOURS; ++i)
+    {
+      std::stringstream s;
+      s << "SurfaceInterpolation/InterpolateLiver/LiverContourWithNormals_";
+      s << i;
+      s << ".vtk";
+      mitk::Surface::Pointer contour = dynamic_cast<mitk::Surface*>(mitk::IOUtil::Load(GetTestDataFilePath(s.str()))[0].GetPointer());
+      contourList.push_back(contour);
+    }
+
+    mitk::Image::Pointer segmentationImage =
+      dynamic_cast<mitk::Image*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverSegmentation.nrrd"))[0].GetPointer());
+
+    mitk::ComputeContourSetNormalsFilter::Pointer m_NormalsFilter = mitk::ComputeContourSetNormalsFilter::New();
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter =
+      mitk::CreateDistanceImageFromSurfaceFilter::New();
+    m_InterpolateSurfaceFilter->UseCompactlySupportedRBFOn();
+
+    itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+    AccessFixedDimensionByItk_1(segmentationImage, GetImageBase, 3, itkImage);
+    m_InterpolateSurfaceFilter->SetReferenceImage(itkImage.GetPointer());
+
+    for (unsigned int j = 0; j < contourList.size(); j++)
+    {
+      m_NormalsFilter->SetInput(j, contourList.at(j));
+      m_InterpolateSurfaceFilter->SetInput(j, m_NormalsFilter->GetOutput(j));
+    }
+
+    m_InterpolateSurfaceFilter->Update();
+
+    mitk::Image::Pointer liverDistanceImage = m_InterpolateSurfaceFilter->GetOutput();
+    CPPUNIT_ASSERT(liverDistanceImage.IsNotNull());
+
+    mitk::Image::Pointer liverDistanceImageReference =
+      dynamic_cast<mitk::Image*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverDistanceImage.nrrd"))[0].GetPointer());
+
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("LiverDistanceImages differ in size!",
+                                   liverDistanceImageReference->GetDimension(dim),
+                                   liverDistanceImage->GetDimension(dim));
+    }
+
+    // The reference is the dense solution. Compare the distances in the narrow band around its surface, where the
+    // distance values are computed (outside of it the pixels are set to +/- 10 * spacing).
+    const double spacing = liverDistanceImage->GetGeometry()->GetSpacing()[0];
+    mitk::ImagePixelReadAccessor<double, 3> accessor(liverDistanceImage);
+    mitk::ImagePixelReadAccessor<double, 3> referenceAccessor(liverDistanceImageReference);
+    const itk::IndexValueType sizeX = liverDistanceImage->GetDimension(0);
+    const itk::IndexValueType sizeY = liverDistanceImage->GetDimension(1);
+    const itk::IndexValueType sizeZ = liverDistanceImage->GetDimension(2);
+    itk::Index<3> index;
+    unsigned int numberOfNarrowBandPixels = 0;
+    unsigned int numberOfComparedPixels = 0;
+    double squaredErrorSum = 0.0;
+    double maximumError = 0.0;
+    for (index[2] = 0; index[2] < sizeZ; ++index[2])
+    {
+      for (index[1] = 0; index[1] < sizeY; ++index[1])
+      {
+        for (index[0] = 0; index[0] < sizeX; ++index[0])
+        {
+          const double referenceDistance = referenceAccessor.GetPixelByIndex(index);
+          if (std::fabs(referenceDistance) > 2 * spacing)
+            continue;
+          ++numberOfNarrowBandPixels;
+
+          const double distance = accessor.GetPixelByIndex(index);
+          if (std::fabs(distance) > 2 * spacing)
+            continue;
+          ++numberOfComparedPixels;
+
+          const double error = std::fabs(distance - referenceDistance);
+          squaredErrorSum += error * error;
+          maximumError = std::max(maximumError, error);
+        }
+      }
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Reference has no narrow band!", numberOfNarrowBandPixels > 0);
+    CPPUNIT_ASSERT_MESSAGE("Narrow band of the interpolation with compactly supported RBFs differs from the reference!",
+                           numberOfComparedPixels >= 0.95 * numberOfNarrowBandPixels);
+
+    const double rootMeanSquareError = std::sqrt(squaredErrorSum / numberOfComparedPixels);
+    CPPUNIT_ASSERT_MESSAGE("Distances of the interpolation with compactly supported RBFs differ too much on average!",
+                           rootMeanSquareError <= 0.5 * spacing);
+    CPPUNIT_ASSERT_MESSAGE("Distances of the interpolation with compactly supported RBFs differ too much!",
+                           maximumError <= 2 * spacing);
+  }
+
   void TestCreateDistanceImageForTube()
   {
     // That's the number of available contours with holes in MITK-Data
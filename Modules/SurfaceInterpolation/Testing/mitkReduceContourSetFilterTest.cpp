@@ -26,6 +26,7 @@ class mitkReduceContourSetFilterTestSuite : public mitk::TestFixture
   CPPUNIT_TEST_SUITE(mitkReduceContourSetFilterTestSuite);
   MITK_TEST(TestReduceContourWithNthPoint);
   MITK_TEST(TestReduceContourWithDouglasPeuker);
+  MITK_TEST(TestReduceContourReusesUnchangedContour);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -74,6 +75,37 @@ public:
       "Unequal contours",
       mitk::Equal(*(reducedContour->GetVtkPolyData()), *(reference->GetVtkPolyData()), 0.000001, true));
   }
+
+  // An unchanged contour is not reduced again
+  void TestReduceContourReusesUnchangedContour()
+  {
+    mitk::Surface::Pointer contour =
+      dynamic_cast<mitk::Surface*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/SingleContour.vtk"))[0].GetPointer());
+    m_ContourReducer->SetInput(contour);
+    m_ContourReducer->SetReductionType(mitk::ReduceContourSetFilter::NTH_POINT);
+    m_ContourReducer->SetStepSize(20);
+    m_ContourReducer->Update();
+    vtkPolyData *firstReducedContour = m_ContourReducer->GetOutput()->GetVtkPolyData();
+
+    m_ContourReducer->Modified();
+    m_ContourReducer->Update();
+    CPPUNIT_ASSERT_MESSAGE("Unchanged contour was reduced again",
+                           m_ContourReducer->GetOutput()->GetVtkPolyData() == firstReducedContour);
+
+    contour->GetVtkPolyData()->Modified();
+    m_ContourReducer->Modified();
+    m_ContourReducer->Update();
+    mitk::Surface::Pointer reducedContour = m_ContourReducer->GetOutput();
+    CPPUNIT_ASSERT_MESSAGE("Changed contour was not reduced again",
+                           reducedContour->GetVtkPolyData() != firstReducedContour);
+
+    mitk::Surface::Pointer reference =
+      dynamic_cast<mitk::Surface*>(mitk::IOUtil::Load(GetTestDataFilePath("SurfaceInterpolation/Reference/ReducedContourNthPoint_20.vtk"))[0].GetPointer());
+
+    CPPUNIT_ASSERT_MESSAGE(
+      "Unequal contours",
+      mitk::Equal(*(reducedContour->GetVtkPolyData()), *(reference->GetVtkPolyData()), 0.000001, true));
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkReduceContourSetFilter)
@@ -39,6 +39,11 @@ void mitk::ComputeContourSetNormalsFilter::GenerateData()
 {
   unsigned int numberOfInputs = this->GetNumberOfIndexedInputs();
 
+  // Only the normals of the current inputs are kept, the others are dropped at the end
+  NormalsCacheType normalsCache;
+  const mitk::Image *segmentation = m_SegmentationBinaryImage.GetPointer();
+  const unsigned long segmentationMTime = segmentation != nullptr ? segmentation->GetMTime() : 0;
+
   // Iterating over each input
   for (unsigned int i = 0; i < numberOfInputs; i++)
   {
@@ -46,6 +51,16 @@ void mitk::ComputeContourSetNormalsFilter::GenerateData()
     Surface *currentSurface = const_cast<Surface *>(this->GetInput(i));
     vtkPolyData *polyData = currentSurface->GetVtkPolyData();
 
+    // The normals of a contour only depend on the contour and the segmentation, so they are reused if neither changed
+    auto cacheIter = m_NormalsCache.find(polyData);
+    if (cacheIter != m_NormalsCache.end() && cacheIter->second.MTime == polyData->GetMTime() &&
+        cacheIter->second.Segmentation == segmentation && cacheIter->second.SegmentationMTime == segmentationMTime)
+    {
+      this->GetOutput(i)->GetVtkPolyData()->GetCellData()->SetNormals(cacheIter->second.Normals);
+      normalsCache.insert(*cacheIter);
+      continue;
+    }
+
     vtkSmartPointer<vtkCellArray> existingPolys = polyData->GetPolys();
 
     vtkSmartPointer<vtkPoints> existingPoints = polyData->GetPoints();
@@ -242,8 +257,17 @@ void mitk::ComputeContourSetNormalsFilter::GenerateData()
 
     Surface::Pointer surface = this->GetOutput(i);
     surface->GetVtkPolyData()->GetCellData()->SetNormals(normals);
+
+    CachedNormals &cachedNormals = normalsCache[polyData];
+    cachedNormals.Contour = polyData;
+    cachedNormals.MTime = polyData->GetMTime();
+    cachedNormals.Segmentation = segmentation;
+    cachedNormals.SegmentationMTime = segmentationMTime;
+    cachedNormals.Normals = normals;
   } // end for all inputs
 
+  m_NormalsCache.swap(normalsCache);
+
   // Setting progressbar
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(this->m_ProgressStepSize);
@@ -315,6 +339,9 @@ mitk::Surface::Pointer mitk::ComputeContourSetNormalsFilter::GetNormalsAsSurface
 
 void mitk::ComputeContourSetNormalsFilter::SetMaxSpacing(double maxSpacing)
 {
+  if (m_MaxSpacing != maxSpacing)
+    m_NormalsCache.clear();
+
   m_MaxSpacing = maxSpacing;
 }
 
@@ -32,6 +32,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkImage.h"
 
+#include <map>
+
 namespace mitk
 {
   /**
@@ -49,6 +51,9 @@ namespace mitk
    Note: If a segmentation binary image is provided this filter assures that the computed normals
          do not point into the segmentation image
 
+   The normals of each contour are kept until the next update. Contours whose vtkPolyData did not change since
+   then are not processed again, so adding a contour to a set of contours only computes the normals of the new one.
+
    $Author: fetzer$
 */
   class MITKSURFACEINTERPOLATION_EXPORT ComputeContourSetNormalsFilter : public SurfaceToSurfaceFilter
@@ -62,7 +67,7 @@ namespace mitk
      */
       mitk::Surface::Pointer GetNormalsAsSurface();
 
-    // Resets the filter, i.e. removes all inputs and outputs
+    // Resets the filter, i.e. removes all inputs and outputs. The normals of the previous update are kept.
     void Reset();
 
     void SetMaxSpacing(double);
@@ -99,6 +104,20 @@ namespace mitk
     bool m_UseProgressBar;
     unsigned int m_ProgressStepSize;
 
+    struct CachedNormals
+    {
+      vtkSmartPointer<vtkPolyData> Contour; // keeps the key of the cache alive
+      unsigned long MTime;
+      // The normals are flipped using the segmentation, so they are only valid for this segmentation and state.
+      // The MTime is unique across objects, so a new segmentation at the same address is not mistaken for the old one.
+      const mitk::Image *Segmentation;
+      unsigned long SegmentationMTime;
+      vtkSmartPointer<vtkDoubleArray> Normals;
+    };
+    typedef std::map<const vtkPolyData *, CachedNormals> NormalsCacheType;
+
+    NormalsCacheType m_NormalsCache;
+
   }; // class
 
 } // namespace
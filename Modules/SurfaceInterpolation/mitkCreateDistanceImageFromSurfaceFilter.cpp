@@ -16,17 +16,151 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkCreateDistanceImageFromSurfaceFilter.h"
 #include "mitkImageCast.h"
+#include "mitkPointLocator.h"
 
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkDoubleArray.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
 #include "vtkSmartPointer.h"
 
 #include "itkImageRegionIteratorWithIndex.h"
-#include "itkNeighborhoodIterator.h"
 
-#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+
+namespace
+{
+  typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseMatrixType;
+
+  // The cells of the center grid are addressed by 21 bits per dimension
+  const long long CenterGridCellOffset = 1 << 20;
+
+  long long GetCenterGridKey(long long x, long long y, long long z)
+  {
+    return ((x + CenterGridCellOffset) << 42) | ((y + CenterGridCellOffset) << 21) | (z + CenterGridCellOffset);
+  }
+
+  mitk::CreateDistanceImageFromSurfaceFilter::CenterKeyType GetCenterKey(
+    const mitk::CreateDistanceImageFromSurfaceFilter::PointType &point)
+  {
+    mitk::CreateDistanceImageFromSurfaceFilter::CenterKeyType key = {{point[0], point[1], point[2]}};
+    return key;
+  }
+
+  // Wendland's C2 function, which is positive definite in 3D
+  double Wendland(double r, double supportRadius)
+  {
+    const double q = r / supportRadius;
+    if (q >= 1.0)
+      return 0.0;
+
+    const double t = 1.0 - q;
+    return t * t * t * t * (4.0 * q + 1.0);
+  }
+
+  void Multiply(const SparseMatrixType &matrix, const Eigen::VectorXd &vector, Eigen::VectorXd &result)
+  {
+    const int numberOfRows = static_cast<int>(matrix.outerSize());
+
+#pragma omp parallel for schedule(static) if (numberOfRows > 1)
+    for (int row = 0; row < numberOfRows; ++row)
+    {
+      double sum = 0.0;
+      for (SparseMatrixType::InnerIterator it(matrix, row); it; ++it)
+        sum += it.value() * vector[it.index()];
+      result[row] = sum;
+    }
+  }
+
+  // Conjugate gradient method for symmetric positive definite matrices. x is used as initial guess if it has the size
+  // of b and reduces the residual. Returns the number of iterations or -1 if the relative residual did not fall below
+  // the tolerance.
+  int SolveConjugateGradient(const SparseMatrixType &matrix,
+                             const Eigen::VectorXd &b,
+                             Eigen::VectorXd &x,
+                             int maximumNumberOfIterations,
+                             double tolerance)
+  {
+    const double bNorm = b.norm();
+    if (bNorm == 0.0 || x.size() != b.size())
+      x.setZero(b.size());
+
+    if (bNorm == 0.0)
+      return 0;
+
+    Eigen::VectorXd Ap(b.size());
+    Multiply(matrix, x, Ap);
+    Eigen::VectorXd r = b - Ap;
+    if (r.norm() >= bNorm)
+    {
+      x.setZero(b.size());
+      r = b;
+    }
+
+    if (r.norm() <= tolerance * bNorm)
+      return 0;
+
+    Eigen::VectorXd p = r;
+    double rr = r.squaredNorm();
+
+    for (int iteration = 1; iteration <= maximumNumberOfIterations; ++iteration)
+    {
+      Multiply(matrix, p, Ap);
+      const double alpha = rr / p.dot(Ap);
+      x += alpha * p;
+      r -= alpha * Ap;
+
+      const double rrNew = r.squaredNorm();
+      if (std::sqrt(rrNew) <= tolerance * bNorm)
+        return iteration;
+
+      p = r + (rrNew / rr) * p;
+      rr = rrNew;
+    }
+
+    return -1;
+  }
+}
+
+template <typename TFunctor>
+void mitk::CreateDistanceImageFromSurfaceFilter::VisitCentersInSupport(const PointType &p,
+                                                                       const CenterGridType &grid,
+                                                                       const CenterList &centers,
+                                                                       TFunctor functor) const
+{
+  long long cell[3];
+  for (unsigned int dim = 0; dim < 3; ++dim)
+  {
+    cell[dim] = static_cast<long long>(std::floor((p[dim] - m_CenterGridOrigin[dim]) / m_CurrentSupportRadius));
+    if (cell[dim] <= -CenterGridCellOffset || cell[dim] >= CenterGridCellOffset - 1)
+      return; // far away from all centers
+  }
+
+  for (long long x = cell[0] - 1; x <= cell[0] + 1; ++x)
+  {
+    for (long long y = cell[1] - 1; y <= cell[1] + 1; ++y)
+    {
+      for (long long z = cell[2] - 1; z <= cell[2] + 1; ++z)
+      {
+        auto cellIter = grid.find(GetCenterGridKey(x, y, z));
+        if (cellIter == grid.end())
+          continue;
+
+        for (unsigned int centerIndex : cellIter->second)
+        {
+          const double distance = (p - centers[centerIndex]).two_norm();
+          if (distance < m_CurrentSupportRadius)
+            functor(centerIndex, distance);
+        }
+      }
+    }
+  }
+}
 
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateEmptyDistanceImage()
 {
@@ -113,6 +247,10 @@ mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImageFromSurfaceFilter
   m_DistanceImageVolume = 50000;
   this->m_UseProgressBar = false;
   this->m_ProgressStepSize = 5;
+  m_UseCompactlySupportedRBF = false;
+  m_SupportRadius = 0.0;
+  m_CurrentSupportRadius = 0.0;
+  m_EvaluatedSupportRadius = 0.0;
 
   mitk::Image::Pointer output = mitk::Image::New();
   this->SetNthOutput(0, output.GetPointer());
@@ -133,7 +271,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(1);
 
-  m_Weights = m_SolutionMatrix.partialPivLu().solve(m_FunctionValues);
+  this->SolveEquationSystem();
 
   if (this->m_UseProgressBar)
     mitk::ProgressBar::GetInstance()->Progress(2);
@@ -146,6 +284,225 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
 
   m_Centers.clear();
   m_Normals.clear();
+  m_ContourIndices.clear();
+  m_CenterGrid.clear();
+  m_ChangedCenters.clear();
+  m_ChangedCenterGrid.clear();
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SolveEquationSystem()
+{
+  if (m_UseCompactlySupportedRBF)
+  {
+    // Centers of contours that did not change since the last update start with their previous weight. As the support
+    // of the RBFs is local, most of them are close to the new solution and only few iterations are needed.
+    for (unsigned int i = 0; i < m_Centers.size(); ++i)
+    {
+      auto weightIter = m_PreviousWeights.find(GetCenterKey(m_Centers[i]));
+      m_Weights[i] = weightIter != m_PreviousWeights.end() ? weightIter->second : 0.0;
+    }
+
+    int iterations = SolveConjugateGradient(
+      m_SparseSolutionMatrix, m_FunctionValues, m_Weights, static_cast<int>(m_FunctionValues.size()), 1e-6);
+    if (iterations < 0)
+    {
+      MITK_WARN << "mitk::CreateDistanceImageFromSurfaceFilter: The conjugate gradient method did not converge, "
+                   "the interpolation may be inaccurate. Try a smaller support radius.";
+    }
+
+    this->DetermineChangedCenters();
+
+    // the factorization of the dense equation system is not needed anymore
+    m_Factorization.resize(0, 0);
+    m_FactorizationPermutation.resize(0);
+    m_FactorizedCenters.clear();
+    m_FactorizationBlockEnds.clear();
+  }
+  else
+  {
+    this->SolveDenseEquationSystem();
+    m_PreviousWeights.clear();
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SolveDenseEquationSystem()
+{
+  const unsigned int numberOfCenters = m_Centers.size();
+  const unsigned int numberOfContourPoints = m_ContourIndices.size();
+
+  // Look up the position of each center in the factorization of the last update
+  std::map<CenterKeyType, unsigned int> factorizedPositions;
+  for (unsigned int i = 0; i < m_FactorizedCenters.size(); ++i)
+    factorizedPositions[GetCenterKey(m_FactorizedCenters[i])] = i;
+
+  std::vector<unsigned int> positions(numberOfCenters, std::numeric_limits<unsigned int>::max());
+  std::vector<char> isFactorizedCenterUsed(m_FactorizedCenters.size(), 0);
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+  {
+    auto positionIter = factorizedPositions.find(GetCenterKey(m_Centers[i]));
+    if (positionIter != factorizedPositions.end() && !isFactorizedCenterUsed[positionIter->second])
+    {
+      positions[i] = positionIter->second;
+      isFactorizedCenterUsed[positionIter->second] = 1;
+    }
+  }
+
+  // The blocks are kept up to the first one with a center which does not exist anymore
+  unsigned int numberOfKeptCenters = 0;
+  for (unsigned int blockEnd : m_FactorizationBlockEnds)
+  {
+    if (std::find(isFactorizedCenterUsed.begin() + numberOfKeptCenters, isFactorizedCenterUsed.begin() + blockEnd, 0) !=
+        isFactorizedCenterUsed.begin() + blockEnd)
+      break;
+
+    numberOfKeptCenters = blockEnd;
+  }
+
+  if (numberOfKeptCenters < m_FactorizedCenters.size())
+  {
+    m_FactorizationBlockEnds.erase(
+      std::upper_bound(m_FactorizationBlockEnds.begin(), m_FactorizationBlockEnds.end(), numberOfKeptCenters),
+      m_FactorizationBlockEnds.end());
+    m_FactorizedCenters.resize(numberOfKeptCenters);
+    m_Factorization.conservativeResize(numberOfKeptCenters, numberOfKeptCenters);
+    Eigen::VectorXi keptIndices = m_FactorizationPermutation.indices().head(numberOfKeptCenters);
+    m_FactorizationPermutation = PermutationType(keptIndices);
+  }
+
+  // The other centers are appended contour by contour, so if a contour is changed later on, only the blocks from
+  // this contour on have to be factorized again
+  std::vector<std::vector<unsigned int>> newCentersPerContour(this->GetNumberOfIndexedInputs());
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+  {
+    if (positions[i] >= numberOfKeptCenters)
+      newCentersPerContour[m_ContourIndices[i % numberOfContourPoints]].push_back(i);
+  }
+
+  for (const auto &newCenterIndices : newCentersPerContour)
+  {
+    if (newCenterIndices.empty())
+      continue;
+
+    CenterList newCenters;
+    newCenters.reserve(newCenterIndices.size());
+    for (unsigned int centerIndex : newCenterIndices)
+    {
+      positions[centerIndex] = m_FactorizedCenters.size() + newCenters.size();
+      newCenters.push_back(m_Centers[centerIndex]);
+    }
+
+    this->AppendToFactorization(newCenters);
+  }
+
+  Eigen::VectorXd functionValues(numberOfCenters);
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+    functionValues[positions[i]] = m_FunctionValues[i];
+
+  Eigen::VectorXd solution = m_FactorizationPermutation * functionValues;
+  m_Factorization.triangularView<Eigen::UnitLower>().solveInPlace(solution);
+  m_Factorization.triangularView<Eigen::Upper>().solveInPlace(solution);
+
+  for (unsigned int i = 0; i < numberOfCenters; ++i)
+    m_Weights[i] = solution[positions[i]];
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::AppendToFactorization(const CenterList &centers)
+{
+  const int numberOfFactorizedCenters = static_cast<int>(m_FactorizedCenters.size());
+  const int numberOfNewCenters = static_cast<int>(centers.size());
+
+  // The new columns B of the equation system and the new diagonal block C. Currently using Phi(r) = r with r is the
+  // euclidian distance between two points
+  Eigen::MatrixXd B(numberOfFactorizedCenters, numberOfNewCenters);
+  Eigen::MatrixXd C(numberOfNewCenters, numberOfNewCenters);
+
+#pragma omp parallel for schedule(dynamic) if (numberOfNewCenters > 1)
+  for (int j = 0; j < numberOfNewCenters; ++j)
+  {
+    for (int i = 0; i < numberOfFactorizedCenters; ++i)
+      B(i, j) = (m_FactorizedCenters[i] - centers[j]).two_norm();
+
+    for (int i = 0; i < numberOfNewCenters; ++i)
+      C(i, j) = (centers[i] - centers[j]).two_norm();
+  }
+
+  // With P * A = L * U the extended system is factorized as
+  //   [P 0; 0 Q] * [A B; B^T C] = [L 0; Q * Z L_S] * [U Y; 0 U_S]
+  // with Y = L^-1 * P * B, Z = B^T * U^-1 and Q * S = L_S * U_S for the Schur complement S = C - Z * Y
+  Eigen::MatrixXd Y = B;
+  Eigen::MatrixXd Zt = B;
+  if (numberOfFactorizedCenters > 0)
+  {
+    Y = m_FactorizationPermutation * B;
+    m_Factorization.triangularView<Eigen::UnitLower>().solveInPlace(Y);
+    m_Factorization.triangularView<Eigen::Upper>().transpose().solveInPlace(Zt);
+    C -= Zt.transpose() * Y;
+  }
+
+  Eigen::PartialPivLU<Eigen::MatrixXd> schurComplementLU(C);
+
+  const int numberOfCenters = numberOfFactorizedCenters + numberOfNewCenters;
+  m_Factorization.conservativeResize(numberOfCenters, numberOfCenters);
+  m_Factorization.topRightCorner(numberOfFactorizedCenters, numberOfNewCenters) = Y;
+  m_Factorization.bottomLeftCorner(numberOfNewCenters, numberOfFactorizedCenters) =
+    schurComplementLU.permutationP() * Zt.transpose();
+  m_Factorization.bottomRightCorner(numberOfNewCenters, numberOfNewCenters) = schurComplementLU.matrixLU();
+
+  Eigen::VectorXi indices(numberOfCenters);
+  indices.head(numberOfFactorizedCenters) = m_FactorizationPermutation.indices();
+  indices.tail(numberOfNewCenters) =
+    schurComplementLU.permutationP().indices().array() + numberOfFactorizedCenters;
+  m_FactorizationPermutation = PermutationType(indices);
+
+  m_FactorizedCenters.insert(m_FactorizedCenters.end(), centers.begin(), centers.end());
+  m_FactorizationBlockEnds.push_back(numberOfCenters);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::DetermineChangedCenters()
+{
+  // A weight changes the distance values by at most its own value, so smaller changes are far below a pixel
+  const double weightTolerance = 1e-4 * m_DistanceImageSpacing;
+
+  m_ChangedCenters.clear();
+  std::set<CenterKeyType> currentCenters;
+  for (unsigned int i = 0; i < m_Centers.size(); ++i)
+  {
+    const CenterKeyType key = GetCenterKey(m_Centers[i]);
+    currentCenters.insert(key);
+
+    auto weightIter = m_PreviousWeights.find(key);
+    if (weightIter != m_PreviousWeights.end() && std::fabs(m_Weights[i] - weightIter->second) <= weightTolerance)
+      m_Weights[i] = weightIter->second;
+    else
+      m_ChangedCenters.push_back(m_Centers[i]);
+  }
+
+  // The removed centers changed the distance values within their support as well
+  for (const auto &previousWeight : m_PreviousWeights)
+  {
+    if (currentCenters.find(previousWeight.first) == currentCenters.end())
+    {
+      PointType removedCenter;
+      removedCenter.copy_in(previousWeight.first.data());
+      m_ChangedCenters.push_back(removedCenter);
+    }
+  }
+
+  this->FillCenterGrid(m_ChangedCenters, m_ChangedCenterGrid);
+
+  m_PreviousWeights.clear();
+  for (unsigned int i = 0; i < m_Centers.size(); ++i)
+    m_PreviousWeights[GetCenterKey(m_Centers[i])] = m_Weights[i];
+}
+
+bool mitk::CreateDistanceImageFromSurfaceFilter::CanReuseEvaluatedDistances() const
+{
+  return m_UseCompactlySupportedRBF && m_EvaluatedDistanceImage.IsNotNull() &&
+         m_EvaluatedSupportRadius == m_CurrentSupportRadius &&
+         m_EvaluatedDistanceImage->GetLargestPossibleRegion() == m_DistanceImageITK->GetLargestPossibleRegion() &&
+         m_EvaluatedDistanceImage->GetOrigin() == m_DistanceImageITK->GetOrigin() &&
+         m_EvaluatedDistanceImage->GetSpacing() == m_DistanceImageITK->GetSpacing() &&
+         m_EvaluatedDistanceImage->GetDirection() == m_DistanceImageITK->GetDirection();
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
@@ -172,6 +529,8 @@ void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
   PointType currentPoint;
   PointType normal;
 
+  std::set<CenterKeyType> existingCenters;
+
   for (unsigned int i = 0; i < numberOfInputs; i++)
   {
     currentSurface = const_cast<Surface *>(this->GetInput(i));
@@ -203,9 +562,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
 
         currentPoint.copy_in(p);
 
-        int count = std::count(m_Centers.begin(), m_Centers.end(), currentPoint);
-
-        if (count == 0)
+        if (existingCenters.insert(GetCenterKey(currentPoint)).second)
         {
           double currentNormal[3];
           currentCellNormals->GetTuple(cell[j], currentNormal);
@@ -215,6 +572,7 @@ void mitk::CreateDistanceImageFromSurfaceFilter::PreprocessContourPoints()
           m_Normals.push_back(normal);
 
           m_Centers.push_back(currentPoint);
+          m_ContourIndices.push_back(i);
         }
 
       } // end for all points
@@ -268,25 +626,202 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
   // Now we have created all centers and all function values. Next step is to create the solution matrix
   numberOfCenters = m_Centers.size();
 
-  m_SolutionMatrix.resize(numberOfCenters, numberOfCenters);
-
   m_Weights.resize(numberOfCenters);
 
-  PointType p1;
-  PointType p2;
-  double norm;
+  // The dense equation system is only set up for the changed centers when its factorization is updated
+  if (m_UseCompactlySupportedRBF)
+    this->CreateSparseSolutionMatrix();
+}
 
-  for (unsigned int i = 0; i < numberOfCenters; i++)
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateSparseSolutionMatrix()
+{
+  m_CurrentSupportRadius = this->DetermineSupportRadius();
+  this->CreateCenterGrid();
+
+  const int numberOfCenters = static_cast<int>(m_Centers.size());
+  std::vector<std::vector<Eigen::Triplet<double>>> rows(numberOfCenters);
+
+#pragma omp parallel for schedule(dynamic) if (numberOfCenters > 1)
+  for (int i = 0; i < numberOfCenters; i++)
+  {
+    std::vector<Eigen::Triplet<double>> &row = rows[i];
+    this->VisitCentersInSupport(m_Centers[i], m_CenterGrid, m_Centers, [&row, i, this](unsigned int j, double distance) {
+      row.push_back(Eigen::Triplet<double>(i, j, Wendland(distance, m_CurrentSupportRadius)));
+    });
+  }
+
+  std::size_t numberOfEntries = 0;
+  for (const auto &row : rows)
+    numberOfEntries += row.size();
+
+  std::vector<Eigen::Triplet<double>> entries;
+  entries.reserve(numberOfEntries);
+  for (const auto &row : rows)
+    entries.insert(entries.end(), row.begin(), row.end());
+
+  m_SparseSolutionMatrix.resize(numberOfCenters, numberOfCenters);
+  m_SparseSolutionMatrix.setFromTriplets(entries.begin(), entries.end());
+}
+
+double mitk::CreateDistanceImageFromSurfaceFilter::DetermineSupportRadius() const
+{
+  if (m_SupportRadius > 0.0)
+    return m_SupportRadius;
+
+  // The contour points are stored contour by contour, so each contour is a range of m_Centers
+  struct Contour
+  {
+    unsigned int Begin;
+    unsigned int End;
+    PointType MinPoint;
+    PointType MaxPoint;
+    double Gap; // distance to the closest neighboring contour
+    PointLocator::Pointer Locator;
+  };
+
+  const unsigned int numberOfContourPoints = static_cast<unsigned int>(m_ContourIndices.size());
+  std::vector<Contour> contours;
+  for (unsigned int i = 0; i < numberOfContourPoints; ++i)
+  {
+    if (contours.empty() || m_ContourIndices[i] != m_ContourIndices[contours.back().Begin])
+    {
+      Contour contour = {i, i, m_Centers[i], m_Centers[i], std::numeric_limits<double>::max(), nullptr};
+      contours.push_back(contour);
+    }
+
+    Contour &contour = contours.back();
+    contour.End = i + 1;
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      contour.MinPoint[dim] = std::min(contour.MinPoint[dim], m_Centers[i][dim]);
+      contour.MaxPoint[dim] = std::max(contour.MaxPoint[dim], m_Centers[i][dim]);
+    }
+  }
+
+  PointType minPoint = m_Centers[0];
+  PointType maxPoint = m_Centers[0];
+  for (const auto &contour : contours)
+  {
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      minPoint[dim] = std::min(minPoint[dim], contour.MinPoint[dim]);
+      maxPoint[dim] = std::max(maxPoint[dim], contour.MaxPoint[dim]);
+    }
+  }
+
+  // Pairs of contours ordered by the distance of their bounding boxes, which is a lower bound of their distance
+  std::vector<std::pair<double, std::pair<unsigned int, unsigned int>>> contourPairs;
+  for (unsigned int c = 0; c < contours.size(); ++c)
+  {
+    for (unsigned int d = c + 1; d < contours.size(); ++d)
+    {
+      double squaredDistance = 0.0;
+      for (unsigned int dim = 0; dim < 3; ++dim)
+      {
+        const double gap = std::max(0.0,
+                                    std::max(contours[c].MinPoint[dim] - contours[d].MaxPoint[dim],
+                                             contours[d].MinPoint[dim] - contours[c].MaxPoint[dim]));
+        squaredDistance += gap * gap;
+      }
+      contourPairs.push_back(std::make_pair(std::sqrt(squaredDistance), std::make_pair(c, d)));
+    }
+  }
+  std::sort(contourPairs.begin(), contourPairs.end());
+
+  for (const auto &contourPair : contourPairs)
+  {
+    Contour &first = contours[contourPair.second.first];
+    Contour &second = contours[contourPair.second.second];
+
+    // the pair cannot be closer than the closest neighbors found so far
+    if (contourPair.first >= first.Gap && contourPair.first >= second.Gap)
+      continue;
+
+    // look up the points of the smaller contour in the search tree of the larger one
+    Contour &queried = (first.End - first.Begin) <= (second.End - second.Begin) ? first : second;
+    Contour &searched = &queried == &first ? second : first;
+
+    if (searched.Locator.IsNull())
+    {
+      vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+      for (unsigned int i = searched.Begin; i < searched.End; ++i)
+        points->InsertNextPoint(m_Centers[i].data_block());
+
+      vtkSmartPointer<vtkPolyData> pointSet = vtkSmartPointer<vtkPolyData>::New();
+      pointSet->SetPoints(points);
+
+      searched.Locator = PointLocator::New();
+      searched.Locator->SetPoints(pointSet);
+    }
+
+    double distance = std::numeric_limits<double>::max();
+    for (unsigned int i = queried.Begin; i < queried.End; ++i)
+    {
+      const unsigned int closest = searched.Begin + searched.Locator->FindClosestPoint(m_Centers[i].data_block());
+      distance = std::min(distance, (m_Centers[i] - m_Centers[closest]).two_norm());
+    }
+
+    first.Gap = std::min(first.Gap, distance);
+    second.Gap = std::min(second.Gap, distance);
+  }
+
+  double largestGap = 0.0;
+  for (const auto &contour : contours)
+  {
+    if (contour.Gap < std::numeric_limits<double>::max())
+      largestGap = std::max(largestGap, contour.Gap);
+  }
+
+  // there is only a single contour, let its support cover the whole contour
+  if (largestGap == 0.0)
+    largestGap = 0.5 * (maxPoint - minPoint).two_norm();
+
+  const double minimumSupportRadius = 4.0 * m_DistanceImageSpacing;
+  double supportRadius = std::max(2.0 * largestGap, minimumSupportRadius);
+
+  // A single contour far away from all others must not make the equation system dense
+  const double maximumSupportRadius = std::max(0.25 * (maxPoint - minPoint).two_norm(), minimumSupportRadius);
+  if (supportRadius > maximumSupportRadius)
+  {
+    MITK_WARN << "mitk::CreateDistanceImageFromSurfaceFilter: The gap between the contours requires a support radius of "
+              << supportRadius << " mm, it is limited to " << maximumSupportRadius
+              << " mm. The interpolation may not bridge the largest gap.";
+    supportRadius = maximumSupportRadius;
+  }
+
+  return supportRadius;
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateCenterGrid()
+{
+  m_CenterGridOrigin = m_Centers[0];
+  for (const auto &center : m_Centers)
+  {
+    for (unsigned int dim = 0; dim < 3; ++dim)
+      m_CenterGridOrigin[dim] = std::min(m_CenterGridOrigin[dim], center[dim]);
+  }
+
+  this->FillCenterGrid(m_Centers, m_CenterGrid);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::FillCenterGrid(const CenterList &centers, CenterGridType &grid) const
+{
+  grid.clear();
+
+  for (unsigned int i = 0; i < centers.size(); ++i)
   {
-    for (unsigned int j = 0; j < numberOfCenters; j++)
+    long long cell[3];
+    bool isInGrid = true;
+    for (unsigned int dim = 0; dim < 3; ++dim)
     {
-      // Calculate the RBF value. Currently using Phi(r) = r with r is the euclidian distance between two points
-      p1 = m_Centers.at(i);
-      p2 = m_Centers.at(j);
-      p1 = p1 - p2;
-      norm = p1.two_norm();
-      m_SolutionMatrix(i, j) = norm;
+      cell[dim] =
+        static_cast<long long>(std::floor((centers[i][dim] - m_CenterGridOrigin[dim]) / m_CurrentSupportRadius));
+      isInGrid = isInGrid && cell[dim] > -CenterGridCellOffset && cell[dim] < CenterGridCellOffset - 1;
     }
+
+    // removed centers far away from the current ones are not in the support of any pixel
+    if (isInGrid)
+      grid[GetCenterGridKey(cell[0], cell[1], cell[2])].push_back(i);
   }
 }
 
@@ -304,11 +839,10 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   */
 
   typedef itk::ImageRegionIteratorWithIndex<DistanceImageType> ImageIterator;
-  typedef itk::NeighborhoodIterator<DistanceImageType> NeighborhoodImageIterator;
 
-  std::queue<DistanceImageType::IndexType> narrowbandPoints;
   PointType currentPoint = m_Centers.at(0);
-  double distance = this->CalculateDistanceValue(currentPoint);
+  bool isInSupport = true;
+  double distance = this->CalculateDistanceValue(currentPoint, isInSupport);
 
   // create itk::Point from vnl_vector
   DistanceImageType::PointType currentPointAsPoint;
@@ -320,52 +854,124 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   DistanceImageType::IndexType currentIndex;
   m_DistanceImageITK->TransformPhysicalPointToIndex(currentPointAsPoint, currentIndex);
 
-  assert(
-    m_DistanceImageITK->GetLargestPossibleRegion().IsInside(currentIndex)); // we are quite certain this should hold
+  const DistanceImageType::RegionType region = m_DistanceImageITK->GetLargestPossibleRegion();
+  assert(region.IsInside(currentIndex)); // we are quite certain this should hold
 
-  narrowbandPoints.push(currentIndex);
   m_DistanceImageITK->SetPixel(currentIndex, distance);
 
-  NeighborhoodImageIterator::RadiusType radius;
-  radius.Fill(1);
-  NeighborhoodImageIterator nIt(radius, m_DistanceImageITK, m_DistanceImageITK->GetLargestPossibleRegion());
-  unsigned int relativeNbIdx[] = {4, 10, 12, 14, 16, 22};
+  /*
+  * The narrowband is grown front by front: the distances of all 6-neighbors of the current front that have not been
+  * checked yet are calculated in parallel and the ones below the threshold form the next front. This yields the same
+  * pixels and values as growing the narrowband pixel by pixel.
+  */
+  std::vector<char> isChecked(region.GetNumberOfPixels(), 0);
+  isChecked[m_DistanceImageITK->ComputeOffset(currentIndex)] = 1;
+
+  // With compactly supported RBFs the distance values outside the support of the changed centers are the same as in
+  // the last update, so they are only calculated again if the last update evaluated them on another grid
+  const bool reuseEvaluatedDistances = this->CanReuseEvaluatedDistances();
+  DistanceImageType::Pointer evaluatedDistanceImage;
+  if (m_UseCompactlySupportedRBF)
+  {
+    evaluatedDistanceImage = DistanceImageType::New();
+    evaluatedDistanceImage->CopyInformation(m_DistanceImageITK);
+    evaluatedDistanceImage->SetRegions(region);
+    evaluatedDistanceImage->Allocate();
+    evaluatedDistanceImage->FillBuffer(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  std::vector<DistanceImageType::IndexType> front(1, currentIndex);
+  std::vector<DistanceImageType::IndexType> candidates;
+  std::vector<double> distances;
+  std::vector<char> isInNarrowband;
 
-  bool isInBounds = false;
-  while (!narrowbandPoints.empty())
+  while (!front.empty())
   {
-    nIt.SetLocation(narrowbandPoints.front());
-    narrowbandPoints.pop();
+    candidates.clear();
+    for (const auto &index : front)
+    {
+      for (unsigned int dim = 0; dim < 3; ++dim)
+      {
+        for (int step = -1; step <= 1; step += 2)
+        {
+          DistanceImageType::IndexType neighbor = index;
+          neighbor[dim] += step;
+          if (!region.IsInside(neighbor))
+            continue;
+
+          char &checked = isChecked[m_DistanceImageITK->ComputeOffset(neighbor)];
+          if (!checked)
+          {
+            checked = 1;
+            candidates.push_back(neighbor);
+          }
+        }
+      }
+    }
+
+    const int numberOfCandidates = static_cast<int>(candidates.size());
+    distances.resize(numberOfCandidates);
+    isInNarrowband.resize(numberOfCandidates);
 
-    unsigned int *relativeNb = &relativeNbIdx[0];
-    for (int i = 0; i < 6; i++)
+#pragma omp parallel for schedule(dynamic, 16) if (numberOfCandidates > 1)
+    for (int i = 0; i < numberOfCandidates; ++i)
     {
-      nIt.GetPixel(*relativeNb, isInBounds);
-      if (isInBounds && nIt.GetPixel(*relativeNb) == m_DistanceImageDefaultBufferValue)
+      // Transform the currently checked point from index-coordinates to world-coordinates
+      DistanceImageType::PointType candidateAsPoint;
+      m_DistanceImageITK->TransformIndexToPhysicalPoint(candidates[i], candidateAsPoint);
+
+      PointType candidate;
+      candidate[0] = candidateAsPoint[0];
+      candidate[1] = candidateAsPoint[1];
+      candidate[2] = candidateAsPoint[2];
+
+      double evaluatedDistance = std::numeric_limits<double>::quiet_NaN();
+      if (reuseEvaluatedDistances)
       {
-        currentIndex = nIt.GetIndex(*relativeNb);
+        evaluatedDistance = m_EvaluatedDistanceImage->GetPixel(candidates[i]);
+        this->VisitCentersInSupport(candidate,
+                                    m_ChangedCenterGrid,
+                                    m_ChangedCenters,
+                                    [&evaluatedDistance](unsigned int, double) {
+                                      evaluatedDistance = std::numeric_limits<double>::quiet_NaN();
+                                    });
+      }
 
-        // Transform the currently checked point from index-coordinates to
-        // world-coordinates
-        m_DistanceImageITK->TransformIndexToPhysicalPoint(currentIndex, currentPointAsPoint);
+      // and check the distance
+      bool candidateIsInSupport = true;
+      if (std::isnan(evaluatedDistance))
+      {
+        distances[i] = this->CalculateDistanceValue(candidate, candidateIsInSupport);
+      }
+      else
+      {
+        candidateIsInSupport = !std::isinf(evaluatedDistance);
+        distances[i] = candidateIsInSupport ? evaluatedDistance : 0.0;
+      }
 
-        // create a vnl_vector
-        currentPoint[0] = currentPointAsPoint[0];
-        currentPoint[1] = currentPointAsPoint[1];
-        currentPoint[2] = currentPointAsPoint[2];
+      if (evaluatedDistanceImage.IsNotNull())
+      {
+        evaluatedDistanceImage->SetPixel(
+          candidates[i], candidateIsInSupport ? distances[i] : std::numeric_limits<double>::infinity());
+      }
 
-        // and check the distance
-        distance = this->CalculateDistanceValue(currentPoint);
-        if (std::fabs(distance) <= m_DistanceImageSpacing * 2)
-        {
-          nIt.SetPixel(*relativeNb, distance);
-          narrowbandPoints.push(currentIndex);
-        }
+      isInNarrowband[i] = candidateIsInSupport && std::fabs(distances[i]) <= m_DistanceImageSpacing * 2;
+    }
+
+    front.clear();
+    for (int i = 0; i < numberOfCandidates; ++i)
+    {
+      if (isInNarrowband[i])
+      {
+        m_DistanceImageITK->SetPixel(candidates[i], distances[i]);
+        front.push_back(candidates[i]);
       }
-      relativeNb++;
     }
   }
 
+  m_EvaluatedDistanceImage = evaluatedDistanceImage;
+  m_EvaluatedSupportRadius = m_CurrentSupportRadius;
+
   ImageIterator imgRegionIterator(m_DistanceImageITK, m_DistanceImageITK->GetLargestPossibleRegion());
   imgRegionIterator.GoToBegin();
 
@@ -423,20 +1029,31 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillDistanceImage()
   CastToMitkImage(m_DistanceImageITK, resultImage);
 }
 
-double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(PointType p)
+double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(const PointType &p,
+                                                                          bool &isInSupport) const
 {
   double distanceValue(0);
-  PointType p1;
+
+  if (m_UseCompactlySupportedRBF)
+  {
+    isInSupport = false;
+    this->VisitCentersInSupport(
+      p, m_CenterGrid, m_Centers, [&distanceValue, &isInSupport, this](unsigned int centerIndex, double distance) {
+        distanceValue += Wendland(distance, m_CurrentSupportRadius) * m_Weights[centerIndex];
+        isInSupport = true;
+      });
+    return distanceValue;
+  }
+
+  isInSupport = true;
+
   PointType p2;
   double norm;
 
-  CenterList::iterator centerIter;
-
   unsigned int count(0);
-  for (centerIter = m_Centers.begin(); centerIter != m_Centers.end(); centerIter++)
+  for (auto centerIter = m_Centers.cbegin(); centerIter != m_Centers.cend(); centerIter++)
   {
-    p1 = *centerIter;
-    p2 = p - p1;
+    p2 = p - *centerIter;
     norm = p2.two_norm();
     distanceValue = distanceValue + (norm * m_Weights[count]);
     ++count;
@@ -451,22 +1068,29 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateOutputInformation()
 void mitk::CreateDistanceImageFromSurfaceFilter::PrintEquationSystem()
 {
   std::stringstream out;
-  out << "Nummber of rows: " << m_SolutionMatrix.rows() << " ****** Number of columns: " << m_SolutionMatrix.cols()
+  if (m_UseCompactlySupportedRBF)
+  {
+    out << "Support radius: " << m_CurrentSupportRadius << endl << m_SparseSolutionMatrix << endl;
+    std::cout << "Equation system: \n\n\n" << out.str();
+    return;
+  }
+  // The equation system of the last update in the order of its factorization
+  out << "Nummber of rows: " << m_FactorizedCenters.size() << " ****** Number of columns: " << m_FactorizedCenters.size()
       << endl;
   out << "[ ";
-  for (int i = 0; i < m_SolutionMatrix.rows(); i++)
+  for (unsigned int i = 0; i < m_FactorizedCenters.size(); i++)
   {
-    for (int j = 0; j < m_SolutionMatrix.cols(); j++)
+    for (unsigned int j = 0; j < m_FactorizedCenters.size(); j++)
     {
-      out << m_SolutionMatrix(i, j) << "   ";
+      out << (m_FactorizedCenters[i] - m_FactorizedCenters[j]).two_norm() << "   ";
     }
     out << ";" << endl;
   }
   out << " ]\n\n\n";
 
-  for (unsigned int i = 0; i < m_Centers.size(); i++)
+  for (unsigned int i = 0; i < m_FactorizedCenters.size(); i++)
   {
-    out << m_Centers.at(i) << ";" << endl;
+    out << m_FactorizedCenters.at(i) << ";" << endl;
   }
   std::cout << "Equation system: \n\n\n" << out.str();
 }
@@ -28,6 +28,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageBase.h"
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <array>
+#include <map>
+#include <unordered_map>
 
 namespace mitk
 {
@@ -36,6 +41,14 @@ namespace mitk
          are the edge-points of contours that are drawn into an image.
 
          The interpolation itself is performed via Radial Basis Function Interpolation.
+         By default Phi(r) = r is used as radial basis function. Its equation system is dense and solved directly,
+         the effort grows with the cube of the number of contour points. For many contour points compactly
+         supported radial basis functions can be used instead, see SetUseCompactlySupportedRBF().
+
+         The LU factorization of the dense equation system is kept between updates. It is built block by block,
+         one block per contour. If the centers of the first contours did not change, their blocks are kept and
+         only the blocks of the changed and added contours are appended by updating the Schur complement. This
+         costs O(n^2 k) instead of O(n^3) for k new centers.
 
          ATTENTION:
          This filter needs beside the edge points of the delineated contours additionally the normals for each
@@ -69,6 +82,7 @@ namespace mitk
   {
   public:
     typedef vnl_vector_fixed<double, 3> PointType;
+    typedef std::array<double, 3> CenterKeyType;
 
     typedef itk::Image<double, 3> DistanceImageType;
     typedef DistanceImageType::IndexType IndexType;
@@ -103,9 +117,38 @@ namespace mitk
     */
     itkSetMacro(DistanceImageVolume, unsigned int);
 
+    /**
+    \brief Set whether compactly supported radial basis functions are used instead of Phi(r) = r (default false)
+
+    Wendland's C2 function Phi(r) = (1 - r/s)^4 * (4r/s + 1), which is zero for r >= s, is used with the support
+    radius s. The equation system is sparse and solved with the conjugate gradient method. Only the centers within
+    the support radius contribute to a distance value, so both the solve and the evaluation of the distance image
+    stay fast for thousands of contour points.
+
+    The weights of the last update are used as initial guess for the centers that still exist, so updating the
+    interpolation after a contour was added or changed needs much fewer iterations than the first solve.
+    Weights which changed by less than 1e-4 of the spacing of the distance image keep their previous value. If the
+    geometry of the distance image and the support radius did not change, only the pixels within the support of
+    the changed, added and removed centers are evaluated again.
+    */
+    itkSetMacro(UseCompactlySupportedRBF, bool);
+    itkGetMacro(UseCompactlySupportedRBF, bool);
+    itkBooleanMacro(UseCompactlySupportedRBF);
+
+    /**
+    \brief Set the support radius of the compactly supported radial basis functions in mm.
+           If it is not positive (default), twice the largest distance between a contour and its closest
+           neighboring contour is used, so that the interpolation bridges the gaps between the contours.
+           This radius is limited to a quarter of the diagonal of the contours' bounding box, so a single
+           outlying contour does not make the equation system dense.
+    */
+    itkSetMacro(SupportRadius, double);
+    itkGetMacro(SupportRadius, double);
+
     void PrintEquationSystem();
 
-    // Resets the filter, i.e. removes all inputs and outputs
+    // Resets the filter, i.e. removes all inputs and outputs. The weights, the factorization and the evaluated
+    // distances of the last update are kept.
     void Reset();
 
     /**
@@ -131,8 +174,55 @@ namespace mitk
     virtual void GenerateOutputInformation() override;
 
   private:
+    typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseMatrixType;
+    typedef Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> PermutationType;
+    typedef std::unordered_map<long long, std::vector<unsigned int>> CenterGridType;
+
     void CreateSolutionMatrixAndFunctionValues();
-    double CalculateDistanceValue(PointType p);
+    void CreateSparseSolutionMatrix();
+    void SolveEquationSystem();
+
+    /**
+    * \brief Solves the dense equation system with the kept factorization, which is updated for the changed centers.
+    */
+    void SolveDenseEquationSystem();
+
+    /**
+    * \brief Appends the given centers as new block to the LU factorization of the dense equation system.
+    */
+    void AppendToFactorization(const CenterList &centers);
+
+    /**
+    * \brief Keeps the previous weights of the centers which did not change noticeably and collects the changed,
+    * added and removed centers in m_ChangedCenters.
+    */
+    void DetermineChangedCenters();
+
+    /**
+    * \brief Returns true if m_EvaluatedDistanceImage can be used for the distance image of the current update.
+    */
+    bool CanReuseEvaluatedDistances() const;
+
+    /**
+    * \brief Calculates the interpolated distance value at point p.
+    *
+    * \a isInSupport is set to false if p is outside the support of all centers (compactly supported RBFs only),
+    * the distance value is zero then without being close to the surface.
+    */
+    double CalculateDistanceValue(const PointType &p, bool &isInSupport) const;
+
+    double DetermineSupportRadius() const;
+    void CreateCenterGrid();
+    void FillCenterGrid(const CenterList &centers, CenterGridType &grid) const;
+
+    /**
+    * \brief Calls functor(centerIndex, distance) for all centers of the grid closer than the support radius to p.
+    */
+    template <typename TFunctor>
+    void VisitCentersInSupport(const PointType &p,
+                               const CenterGridType &grid,
+                               const CenterList &centers,
+                               TFunctor functor) const;
 
     void FillDistanceImage();
 
@@ -161,10 +251,29 @@ namespace mitk
     // Datastructures for the interpolation
     CenterList m_Centers;
     NormalList m_Normals;
+    std::vector<unsigned int> m_ContourIndices; // input index of each contour point
 
-    Eigen::MatrixXd m_SolutionMatrix;
+    SparseMatrixType m_SparseSolutionMatrix;
     Eigen::VectorXd m_FunctionValues;
     Eigen::VectorXd m_Weights;
+    std::map<CenterKeyType, double> m_PreviousWeights; // weights of the last compactly supported solve per center
+
+    // LU factorization P * A = L * U of the dense equation system of m_FactorizedCenters. L (unit diagonal) and U
+    // are stored in one matrix. The permutation only swaps rows within a block, so the factorization of the first
+    // blocks is the factorization of the equation system of their centers.
+    Eigen::MatrixXd m_Factorization;
+    PermutationType m_FactorizationPermutation;
+    CenterList m_FactorizedCenters;
+    std::vector<unsigned int> m_FactorizationBlockEnds;
+
+    // Centers whose weight changed since the last compactly supported solve, including the removed centers
+    CenterList m_ChangedCenters;
+    CenterGridType m_ChangedCenterGrid;
+
+    // Distance values of the last compactly supported update per pixel, NaN if not evaluated and infinity outside
+    // the support of all centers
+    DistanceImageType::Pointer m_EvaluatedDistanceImage;
+    double m_EvaluatedSupportRadius;
 
     DistanceImageType::Pointer m_DistanceImageITK;
     itk::ImageBase<3>::Pointer m_ReferenceImage;
@@ -175,6 +284,14 @@ namespace mitk
 
     bool m_UseProgressBar;
     unsigned int m_ProgressStepSize;
+
+    bool m_UseCompactlySupportedRBF;
+    double m_SupportRadius;
+    double m_CurrentSupportRadius;
+
+    // Uniform grid with the support radius as cell size, which holds the indices of the centers per cell
+    CenterGridType m_CenterGrid;
+    PointType m_CenterGridOrigin;
   };
 
 } // namespace
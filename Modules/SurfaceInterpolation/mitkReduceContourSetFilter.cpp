@@ -27,6 +27,9 @@ mitk::ReduceContourSetFilter::ReduceContourSetFilter()
   this->m_UseProgressBar = false;
   this->m_ProgressStepSize = 1;
   m_NumberOfPointsAfterReduction = 0;
+  m_CachedReductionType = m_ReductionType;
+  m_CachedStepSize = m_StepSize;
+  m_CachedTolerance = m_Tolerance;
 
   mitk::Surface::Pointer output = mitk::Surface::New();
   this->SetNthOutput(0, output.GetPointer());
@@ -52,9 +55,12 @@ void mitk::ReduceContourSetFilter::GenerateData()
   unsigned int numberOfInputs = this->GetNumberOfIndexedInputs();
   unsigned int numberOfOutputs(0);
 
-  vtkSmartPointer<vtkPolyData> newPolyData;
-  vtkSmartPointer<vtkCellArray> newPolygons;
-  vtkSmartPointer<vtkPoints> newPoints;
+  // The reduced polygons depend on these parameters only, so they can be reused as long as they do not change
+  if (m_ReductionType != m_CachedReductionType || m_StepSize != m_CachedStepSize || m_Tolerance != m_CachedTolerance)
+    m_ReducedContourCache.clear();
+
+  // Only the reduced contours of the current inputs are kept, the others are dropped at the end
+  ReducedContourCacheType reducedContourCache;
 
   // For the purpose of evaluation
   //  unsigned int numberOfPointsBefore (0);
@@ -65,9 +71,18 @@ void mitk::ReduceContourSetFilter::GenerateData()
     mitk::Surface *currentSurface = const_cast<mitk::Surface *>(this->GetInput(i));
     vtkSmartPointer<vtkPolyData> polyData = currentSurface->GetVtkPolyData();
 
-    newPolyData = vtkSmartPointer<vtkPolyData>::New();
-    newPolygons = vtkSmartPointer<vtkCellArray>::New();
-    newPoints = vtkSmartPointer<vtkPoints>::New();
+    ReducedContour &reducedContour = reducedContourCache[polyData.GetPointer()];
+    auto cacheIter = m_ReducedContourCache.find(polyData.GetPointer());
+    if (cacheIter != m_ReducedContourCache.end() && cacheIter->second.MTime == polyData->GetMTime())
+    {
+      reducedContour = cacheIter->second;
+    }
+    else
+    {
+      reducedContour.Contour = polyData;
+      reducedContour.MTime = polyData->GetMTime();
+      reducedContour.Polygons.assign(polyData->GetNumberOfPolys(), ReducedPolygon());
+    }
 
     vtkSmartPointer<vtkCellArray> existingPolys = polyData->GetPolys();
 
@@ -77,52 +92,68 @@ void mitk::ReduceContourSetFilter::GenerateData()
 
     vtkIdType *cell(nullptr);
     vtkIdType cellSize(0);
+    vtkIdType cellId(0);
+
+    // Whether a polygon is incorporated depends on the other inputs and has to be checked again, but the expensive
+    // reduction of the polygon is only done once
+    std::vector<bool> incorporatedPolygons(reducedContour.Polygons.size(), false);
 
-    for (existingPolys->InitTraversal(); existingPolys->GetNextCell(cellSize, cell);)
+    for (existingPolys->InitTraversal(); existingPolys->GetNextCell(cellSize, cell); ++cellId)
     {
       bool incorporatePolygon =
         this->CheckForIntersection(cell, cellSize, existingPoints, /*numberOfIntersections, intersectionPoints, */ i);
       if (!incorporatePolygon)
         continue;
 
-      vtkSmartPointer<vtkPolygon> newPolygon = vtkSmartPointer<vtkPolygon>::New();
+      incorporatedPolygons[cellId] = true;
 
-      if (m_ReductionType == NTH_POINT)
+      ReducedPolygon &reducedPolygon = reducedContour.Polygons[cellId];
+      if (reducedPolygon.Polygon.GetPointer() == nullptr)
       {
-        this->ReduceNumberOfPointsByNthPoint(cellSize, cell, existingPoints, newPolygon, newPoints);
-        if (newPolygon->GetPointIds()->GetNumberOfIds() != 0)
+        reducedPolygon.Polygon = vtkSmartPointer<vtkPolygon>::New();
+        reducedPolygon.Points = vtkSmartPointer<vtkPoints>::New();
+
+        if (m_ReductionType == NTH_POINT)
         {
-          newPolygons->InsertNextCell(newPolygon);
+          this->ReduceNumberOfPointsByNthPoint(
+            cellSize, cell, existingPoints, reducedPolygon.Polygon, reducedPolygon.Points);
+          reducedPolygon.IsValid = reducedPolygon.Polygon->GetPointIds()->GetNumberOfIds() != 0;
         }
-      }
-      else if (m_ReductionType == DOUGLAS_PEUCKER)
-      {
-        this->ReduceNumberOfPointsByDouglasPeucker(cellSize, cell, existingPoints, newPolygon, newPoints);
-        if (newPolygon->GetPointIds()->GetNumberOfIds() > 3)
+        else if (m_ReductionType == DOUGLAS_PEUCKER)
         {
-          newPolygons->InsertNextCell(newPolygon);
+          this->ReduceNumberOfPointsByDouglasPeucker(
+            cellSize, cell, existingPoints, reducedPolygon.Polygon, reducedPolygon.Points);
+          reducedPolygon.IsValid = reducedPolygon.Polygon->GetPointIds()->GetNumberOfIds() > 3;
         }
       }
 
       // Again for evaluation
       //      numberOfPointsBefore += cellSize;
-      m_NumberOfPointsAfterReduction += newPolygon->GetPointIds()->GetNumberOfIds();
+      m_NumberOfPointsAfterReduction += reducedPolygon.Polygon->GetPointIds()->GetNumberOfIds();
     }
 
-    if (newPolygons->GetNumberOfCells() != 0)
+    // If the same polygons are incorporated as in the last update the previous output is still valid
+    if (reducedContour.Output.GetPointer() == nullptr || incorporatedPolygons != reducedContour.IncorporatedPolygons)
     {
-      newPolyData->SetPolys(newPolygons);
-      newPolyData->SetPoints(newPoints);
-      newPolyData->BuildLinks();
+      reducedContour.IncorporatedPolygons = incorporatedPolygons;
+      reducedContour.Output = this->CreateReducedPolyData(reducedContour);
+    }
 
+    if (reducedContour.Output.GetPointer() != nullptr)
+    {
       this->SetNumberOfIndexedOutputs(numberOfOutputs + 1);
       mitk::Surface::Pointer surface = mitk::Surface::New();
       this->SetNthOutput(numberOfOutputs, surface.GetPointer());
-      surface->SetVtkPolyData(newPolyData);
+      surface->SetVtkPolyData(reducedContour.Output);
       numberOfOutputs++;
     }
   }
 
+  m_ReducedContourCache.swap(reducedContourCache);
+  m_CachedReductionType = m_ReductionType;
+  m_CachedStepSize = m_StepSize;
+  m_CachedTolerance = m_Tolerance;
+
   //  MITK_INFO<<"Points before: "<<numberOfPointsBefore<<" ##### Points after: "<<numberOfPointsAfter;
   this->SetNumberOfIndexedOutputs(numberOfOutputs);
 
@@ -137,6 +168,45 @@ void mitk::ReduceContourSetFilter::GenerateData()
     mitk::ProgressBar::GetInstance()->Progress(this->m_ProgressStepSize);
 }
 
+vtkSmartPointer<vtkPolyData> mitk::ReduceContourSetFilter::CreateReducedPolyData(
+  const ReducedContour &reducedContour) const
+{
+  vtkSmartPointer<vtkCellArray> newPolygons = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+
+  for (std::size_t cellId = 0; cellId < reducedContour.Polygons.size(); ++cellId)
+  {
+    if (!reducedContour.IncorporatedPolygons[cellId])
+      continue;
+
+    const ReducedPolygon &reducedPolygon = reducedContour.Polygons[cellId];
+    const vtkIdType offset = newPoints->GetNumberOfPoints();
+    for (vtkIdType j = 0; j < reducedPolygon.Points->GetNumberOfPoints(); ++j)
+      newPoints->InsertNextPoint(reducedPolygon.Points->GetPoint(j));
+
+    if (!reducedPolygon.IsValid)
+      continue;
+
+    vtkSmartPointer<vtkPolygon> newPolygon = vtkSmartPointer<vtkPolygon>::New();
+    vtkIdList *pointIds = reducedPolygon.Polygon->GetPointIds();
+    newPolygon->GetPointIds()->SetNumberOfIds(pointIds->GetNumberOfIds());
+    for (vtkIdType j = 0; j < pointIds->GetNumberOfIds(); ++j)
+      newPolygon->GetPointIds()->SetId(j, pointIds->GetId(j) + offset);
+
+    newPolygons->InsertNextCell(newPolygon);
+  }
+
+  if (newPolygons->GetNumberOfCells() == 0)
+    return vtkSmartPointer<vtkPolyData>();
+
+  vtkSmartPointer<vtkPolyData> newPolyData = vtkSmartPointer<vtkPolyData>::New();
+  newPolyData->SetPolys(newPolygons);
+  newPolyData->SetPoints(newPoints);
+  newPolyData->BuildLinks();
+
+  return newPolyData;
+}
+
 void mitk::ReduceContourSetFilter::ReduceNumberOfPointsByNthPoint(
   vtkIdType cellSize, vtkIdType *cell, vtkPoints *points, vtkPolygon *reducedPolygon, vtkPoints *reducedPoints)
 {
@@ -29,7 +29,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkPolygon.h"
 #include "vtkSmartPointer.h"
 
+#include <map>
 #include <stack>
+#include <vector>
 
 namespace mitk
 {
@@ -50,6 +52,10 @@ namespace mitk
 
     The output is a mitk::Surface.
 
+    The reduced polygons of each input are kept until the next update. Inputs whose vtkPolyData did not change
+    since then are not reduced again, only the check for intersection contours is repeated. If its result did not
+    change either, the output shares the vtkPolyData of the previous update.
+
     $Author: fetzer$
   */
 
@@ -79,7 +85,7 @@ namespace mitk
 
     itkGetMacro(NumberOfPointsAfterReduction, unsigned int);
 
-    // Resets the filter, i.e. removes all inputs and outputs
+    // Resets the filter, i.e. removes all inputs and outputs. The reduced contours of the previous update are kept.
     void Reset();
 
     /**
@@ -107,6 +113,26 @@ namespace mitk
     virtual void GenerateOutputInformation() override;
 
   private:
+    struct ReducedPolygon
+    {
+      ReducedPolygon() : IsValid(false) {}
+      vtkSmartPointer<vtkPolygon> Polygon; // point ids refer to Points
+      vtkSmartPointer<vtkPoints> Points;
+      bool IsValid; // false if the polygon became too small and is not part of the output
+    };
+
+    struct ReducedContour
+    {
+      vtkSmartPointer<vtkPolyData> Contour; // keeps the key of the cache alive
+      unsigned long MTime;
+      std::vector<ReducedPolygon> Polygons; // per polygon of the input, reduced on demand
+      std::vector<bool> IncorporatedPolygons;
+      vtkSmartPointer<vtkPolyData> Output;
+    };
+    typedef std::map<const vtkPolyData *, ReducedContour> ReducedContourCacheType;
+
+    vtkSmartPointer<vtkPolyData> CreateReducedPolyData(const ReducedContour &reducedContour) const;
+
     void ReduceNumberOfPointsByNthPoint(
       vtkIdType cellSize, vtkIdType *cell, vtkPoints *points, vtkPolygon *reducedPolygon, vtkPoints *reducedPoints);
 
@@ -132,6 +158,11 @@ namespace mitk
 
     unsigned int m_NumberOfPointsAfterReduction;
 
+    ReducedContourCacheType m_ReducedContourCache;
+    Reduction_Type m_CachedReductionType;
+    unsigned int m_CachedStepSize;
+    double m_CachedTolerance;
+
   }; // class
 
 } // namespace
@@ -363,6 +363,11 @@ void mitk::SurfaceInterpolationController::SetDistanceImageVolume(unsigned int d
   m_InterpolateSurfaceFilter->SetDistanceImageVolume(distImgVolume);
 }
 
+void mitk::SurfaceInterpolationController::SetUseCompactlySupportedRBF(bool useCompactlySupportedRBF)
+{
+  m_InterpolateSurfaceFilter->SetUseCompactlySupportedRBF(useCompactlySupportedRBF);
+}
+
 mitk::Image::Pointer mitk::SurfaceInterpolationController::GetCurrentSegmentation()
 {
   return m_SelectedSegmentation;
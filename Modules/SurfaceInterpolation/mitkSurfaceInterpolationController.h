@@ -122,6 +122,9 @@ namespace mitk
 
     /**
      * Interpolates the 3D surface from the given extracted contours
+     *
+     * The reduced contours and their normals are only computed for contours that were added or changed since the last
+     * interpolation, and the compactly supported equation system starts from the previous weights.
      */
     void Interpolate();
 
@@ -145,6 +148,13 @@ namespace mitk
      */
     void SetDistanceImageVolume(unsigned int distImageVolume);
 
+    /**
+     * Sets whether compactly supported radial basis functions are used for the interpolation
+     * This keeps the interpolation fast for many contour points, see
+     * CreateDistanceImageFromSurfaceFilter::SetUseCompactlySupportedRBF()
+     */
+    void SetUseCompactlySupportedRBF(bool useCompactlySupportedRBF);
+
     /**
      * @brief Get the current selected segmentation for which the interpolation is performed
      * @return the current segmentation image
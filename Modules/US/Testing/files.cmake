@@ -14,6 +14,7 @@ SET(MODULE_TESTS
 
 SET(MODULE_CUSTOM_TESTS
   mitkUSImageVideoSourceTest.cpp
+  mitkUSImageVideoSourceBenchmarkTest.cpp
 )
 
 
@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkUSImageLoggingFilter.h"
+#include "mitkUSImageStreamReader.h"
 #include <mitkTestingMacros.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingConfig.h>
@@ -25,11 +26,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIMimeTypeProvider.h>
 
 #include "mitkImageGenerator.h"
+#include "mitkImageReadAccessor.h"
 
 #include "itksys/SystemTools.hxx"
 
 #include "Poco/File.h"
 
+#include <cstring>
+
 class mitkUSImageLoggingFilterTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkUSImageLoggingFilterTestSuite);
@@ -40,6 +44,8 @@ class mitkUSImageLoggingFilterTestSuite : public mitk::TestFixture
   MITK_TEST(TestSavingAfterMupltipleUpdateCalls);
   MITK_TEST(TestFilterWithEmptyImages);
   MITK_TEST(TestFilterWithInvalidPath);
+  MITK_TEST(TestRecording);
+  MITK_TEST(TestCompressedRecording);
   //MITK_TEST(TestJpgFileExtension); //bug 19614
   CPPUNIT_TEST_SUITE_END();
 
@@ -162,6 +168,69 @@ public:
                                mitk::Exception);
   }
 
+  void CheckRecording(mitk::Image::Pointer image, bool compressed)
+  {
+  std::string filename = mitk::IOUtil::CreateTemporaryFile("USImageLoggingFilterTest-XXXXXX.usis");
+
+  m_TestFilter->SetInput(image);
+  m_TestFilter->SetRecordingCompression(compressed);
+  m_TestFilter->SetRecordingQueueSize(2);
+  m_TestFilter->StartRecording(filename);
+  CPPUNIT_ASSERT_MESSAGE("Testing if recording is started",m_TestFilter->GetIsRecording());
+
+  for(int i=0; i<5; i++)
+    {
+    m_TestFilter->Modified();
+    m_TestFilter->Update();
+    if (i%2 == 0)
+      {
+      std::stringstream testmessage;
+      testmessage << "testmessage" << i;
+      m_TestFilter->AddMessageToCurrentImage(testmessage.str());
+      }
+    }
+  m_TestFilter->StopRecording();
+  CPPUNIT_ASSERT_MESSAGE("Testing if recording is stopped",!m_TestFilter->GetIsRecording());
+
+  mitk::USImageStreamReader::Pointer reader = mitk::USImageStreamReader::New();
+  reader->Open(filename);
+  CPPUNIT_ASSERT_MESSAGE("Testing if correct number of images was recorded",reader->GetNumberOfImages() == 5);
+
+  mitk::ImageReadAccessor inputAccessor(image, image->GetVolumeData(0));
+  size_t size = image->GetPixelType().GetSize();
+  for(unsigned int i=0; i<image->GetDimension(); i++) size *= image->GetDimension(i);
+
+  for(unsigned int i=0; i<5; i++)
+    {
+    mitk::Image::Pointer recordedImage = reader->GetImage(i);
+    mitk::ImageReadAccessor recordedAccessor(recordedImage, recordedImage->GetVolumeData(0));
+    CPPUNIT_ASSERT_MESSAGE("Testing if recorded pixel type is correct",recordedImage->GetPixelType() == image->GetPixelType());
+    CPPUNIT_ASSERT_MESSAGE("Testing if recorded image data is correct",std::memcmp(recordedAccessor.GetData(),inputAccessor.GetData(),size) == 0);
+    CPPUNIT_ASSERT_MESSAGE("Testing if recorded spacing is correct",
+                           mitk::Equal(recordedImage->GetGeometry()->GetSpacing(),image->GetGeometry()->GetSpacing()));
+    if (i>0) CPPUNIT_ASSERT_MESSAGE("Testing if timestamps are ascending",reader->GetTimestamp(i) >= reader->GetTimestamp(i-1));
+    CPPUNIT_ASSERT_MESSAGE("Testing if image can be found by its timestamp",reader->GetTimestamp(reader->GetImageIndex(reader->GetTimestamp(i))) == reader->GetTimestamp(i));
+
+    std::stringstream testmessage;
+    if (i%2 == 0) testmessage << "testmessage" << i;
+    CPPUNIT_ASSERT_MESSAGE("Testing if recorded message is correct",reader->GetImageMessage(i) == testmessage.str());
+    }
+
+  //clean up
+  reader->Close();
+  std::remove(filename.c_str());
+  }
+
+  void TestRecording()
+  {
+  CheckRecording(m_RandomSingleSliceImage, false);
+  }
+
+  void TestCompressedRecording()
+  {
+  CheckRecording(m_RealTestImage, true);
+  }
+
   void TestJpgFileExtension()
   {
   CPPUNIT_ASSERT_MESSAGE("Testing setting of jpg extension.",m_TestFilter->SetImageFilesExtension(".jpg"));
@@ -0,0 +1,140 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageVideoSource.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkTestingMacros.h"
+
+#include <itkTimeProbe.h>
+
+#include <cstring>
+
+class mitkUSImageVideoSourceBenchmarkTestClass
+{
+public:
+
+  static const unsigned int NUMBER_OF_FRAMES = 100;
+
+  static mitk::USImageVideoSource::Pointer OpenVideoFile(std::string videoFilePath, bool useFramePool)
+  {
+    mitk::USImageVideoSource::Pointer usSource = mitk::USImageVideoSource::New();
+    if (!useFramePool)
+    {
+      usSource->GetFramePool()->SetNumberOfFrames(0);
+    }
+    usSource->SetVideoFileInput(videoFilePath);
+    MITK_TEST_CONDITION_REQUIRED(usSource->GetIsVideoReady(), "USImageVideoSource should have isVideoReady flag set after opening a Video File");
+    return usSource;
+  }
+
+  static void TestFramesAreRecycled(std::string videoFilePath)
+  {
+    mitk::USImageVideoSource::Pointer usSource = OpenVideoFile(videoFilePath, true);
+
+    unsigned int numberOfFrames = 0;
+    bool allFramesPooled = true;
+    for (; numberOfFrames < NUMBER_OF_FRAMES; ++numberOfFrames)
+    {
+      mitk::Image::Pointer frame = usSource->GetNextImage();
+      if (frame.IsNull() || !frame->IsInitialized()) { break; }
+      allFramesPooled = allFramesPooled && usSource->GetFramePool()->Contains(frame);
+    }
+
+    MITK_TEST_CONDITION_REQUIRED(numberOfFrames > 1, "Video should contain more than one frame.");
+    MITK_TEST_CONDITION(allFramesPooled, "Every frame should be taken from the frame pool.");
+    MITK_TEST_CONDITION(usSource->GetFramePool()->GetNumberOfAllocations() == 1,
+      "A released frame should be recycled instead of allocating a new one.");
+  }
+
+  static void TestFramesEqualUnpooledFrames(std::string videoFilePath)
+  {
+    mitk::USImageVideoSource::Pointer pooledSource = OpenVideoFile(videoFilePath, true);
+    mitk::USImageVideoSource::Pointer unpooledSource = OpenVideoFile(videoFilePath, false);
+
+    bool allFramesEqual = true;
+    for (unsigned int i = 0; i < 10; ++i)
+    {
+      mitk::Image::Pointer pooledFrame = pooledSource->GetNextImage();
+      mitk::Image::Pointer unpooledFrame = unpooledSource->GetNextImage();
+      MITK_TEST_CONDITION_REQUIRED(pooledFrame->IsInitialized() && unpooledFrame->IsInitialized(), "Frames should be initialized.");
+
+      if (pooledFrame->GetPixelType() != unpooledFrame->GetPixelType() ||
+        pooledFrame->GetDimension(0) != unpooledFrame->GetDimension(0) ||
+        pooledFrame->GetDimension(1) != unpooledFrame->GetDimension(1))
+      {
+        allFramesEqual = false;
+        break;
+      }
+
+      mitk::ImageReadAccessor pooledAccessor(pooledFrame, pooledFrame->GetVolumeData(0));
+      mitk::ImageReadAccessor unpooledAccessor(unpooledFrame, unpooledFrame->GetVolumeData(0));
+      size_t size = pooledFrame->GetDimension(0) * pooledFrame->GetDimension(1) * pooledFrame->GetPixelType().GetSize();
+      allFramesEqual = allFramesEqual && std::memcmp(pooledAccessor.GetData(), unpooledAccessor.GetData(), size) == 0;
+    }
+
+    MITK_TEST_CONDITION(allFramesEqual, "Frames of the frame pool should equal the converted frames.");
+  }
+
+  static double MeasureFramesPerSecond(std::string videoFilePath, bool useFramePool)
+  {
+    mitk::USImageVideoSource::Pointer usSource = OpenVideoFile(videoFilePath, useFramePool);
+
+    unsigned int numberOfFrames = 0;
+    itk::TimeProbe probe;
+    probe.Start();
+    for (; numberOfFrames < NUMBER_OF_FRAMES; ++numberOfFrames)
+    {
+      mitk::Image::Pointer frame = usSource->GetNextImage();
+      if (frame.IsNull() || !frame->IsInitialized()) { break; }
+    }
+    probe.Stop();
+
+    return probe.GetTotal() > 0 ? numberOfFrames / probe.GetTotal() : 0;
+  }
+
+  static void TestThroughput(std::string videoFilePath)
+  {
+    double unpooledFramesPerSecond = MeasureFramesPerSecond(videoFilePath, false);
+    double pooledFramesPerSecond = MeasureFramesPerSecond(videoFilePath, true);
+
+    MITK_INFO << "Video frames without frame pool: " << unpooledFramesPerSecond << " fps";
+    MITK_INFO << "Video frames with frame pool: " << pooledFramesPerSecond << " fps";
+    MITK_TEST_CONDITION(pooledFramesPerSecond > 0, "Frames should be delivered with frame pool.");
+  }
+};
+
+#ifdef WIN32 // Video file compression is currently only supported under windows.
+/**
+* This function is measuring the frame rate of the class USImageVideoSource
+* and testing that its frames are recycled.
+*/
+int mitkUSImageVideoSourceBenchmarkTest(int, char* argv[])
+{
+  MITK_TEST_BEGIN("mitkUSImageVideoSourceBenchmarkTest");
+
+  mitkUSImageVideoSourceBenchmarkTestClass::TestFramesAreRecycled(argv[1]);
+  mitkUSImageVideoSourceBenchmarkTestClass::TestFramesEqualUnpooledFrames(argv[1]);
+  mitkUSImageVideoSourceBenchmarkTestClass::TestThroughput(argv[1]);
+
+  MITK_TEST_END();
+}
+#else
+int mitkUSImageVideoSourceBenchmarkTest(int, char* [] )
+{
+  MITK_TEST_BEGIN("mitkUSImageVideoSourceBenchmarkTest");
+  MITK_TEST_END();
+}
+#endif
@@ -0,0 +1,117 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageFramePool.h"
+
+mitk::USImageFramePool::USImageFramePool()
+  : m_NumberOfFrames(8),
+  m_NextFrame(0),
+  m_NumberOfAllocations(0),
+  m_FramesMutex(itk::FastMutexLock::New())
+{
+}
+
+mitk::USImageFramePool::~USImageFramePool()
+{
+}
+
+mitk::Image::Pointer mitk::USImageFramePool::GetFreeFrame(const mitk::PixelType& pixelType,
+  unsigned int width, unsigned int height, void*& buffer)
+{
+  buffer = nullptr;
+  m_FramesMutex->Lock();
+
+  // the format of the source changed, frames which are still in use are
+  // released by their last user
+  if (!m_Frames.empty())
+  {
+    mitk::Image* image = m_Frames.front().Image;
+    if (image->GetPixelType() != pixelType || image->GetDimension(0) != width || image->GetDimension(1) != height)
+    {
+      m_Frames.clear();
+      m_NextFrame = 0;
+    }
+  }
+
+  // look for a frame that is only referenced by the pool, starting after the
+  // frame that was handed out last
+  for (unsigned int i = 0; i < m_Frames.size(); ++i)
+  {
+    Frame& frame = m_Frames[(m_NextFrame + i) % m_Frames.size()];
+    if (frame.Image->GetReferenceCount() == 1)
+    {
+      m_NextFrame = (m_NextFrame + i + 1) % m_Frames.size();
+      buffer = frame.Buffer;
+      mitk::Image::Pointer result = frame.Image;
+      m_FramesMutex->Unlock();
+      return result;
+    }
+  }
+
+  // all frames are in use, add a new one if the pool is not full yet
+  if (m_Frames.size() >= m_NumberOfFrames)
+  {
+    m_FramesMutex->Unlock();
+    return nullptr;
+  }
+
+  unsigned int dimensions[2] = { width, height };
+  Frame frame;
+  frame.Image = mitk::Image::New();
+  frame.Image->Initialize(pixelType, 2, dimensions);
+
+  // the image takes the ownership of the buffer, so a frame that outlives the
+  // pool stays valid
+  size_t size = static_cast<size_t>(width) * height * pixelType.GetSize();
+  frame.Buffer = new unsigned char[size];
+  frame.Image->SetImportVolume(frame.Buffer, 0, 0, mitk::Image::ManageMemory);
+  m_Frames.push_back(frame);
+  ++m_NumberOfAllocations;
+
+  buffer = frame.Buffer;
+  mitk::Image::Pointer result = frame.Image;
+  m_FramesMutex->Unlock();
+  return result;
+}
+
+bool mitk::USImageFramePool::Contains(const mitk::Image* image) const
+{
+  if (image == nullptr)
+    return false;
+
+  m_FramesMutex->Lock();
+  bool found = false;
+  for (const Frame& frame : m_Frames)
+  {
+    if (frame.Image.GetPointer() == image)
+    {
+      found = true;
+      break;
+    }
+  }
+  m_FramesMutex->Unlock();
+  return found;
+}
+
+void mitk::USImageFramePool::SetNumberOfFrames(unsigned int numberOfFrames)
+{
+  m_FramesMutex->Lock();
+  m_NumberOfFrames = numberOfFrames;
+  m_Frames.clear();
+  m_NextFrame = 0;
+  m_FramesMutex->Unlock();
+  this->Modified();
+}
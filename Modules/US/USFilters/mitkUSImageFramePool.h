@@ -0,0 +1,96 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageFramePool_H_HEADER_INCLUDED_
+#define MITKUSImageFramePool_H_HEADER_INCLUDED_
+
+// ITK
+#include <itkObject.h>
+#include <itkFastMutexLock.h>
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+
+#include <vector>
+
+namespace mitk {
+  /**
+  * \brief Pool of preallocated 2D images for the frames of an image source.
+  *
+  * Every frame is an mitk::Image that imported a preallocated buffer, so the
+  * capture thread can write the next frame directly into memory that is
+  * already wrapped by an image. A frame is handed out again as soon as nobody
+  * but the pool references it anymore. Consumers therefore must not change
+  * the data of a frame they got from the pool.
+  *
+  * \ingroup US
+  */
+  class MITKUS_EXPORT USImageFramePool : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageFramePool, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /**
+    * \brief Returns a frame that is not referenced outside of the pool.
+    *
+    * All frames are reallocated if the pixel type or the size differs from
+    * the requested one. Returns nullptr if every frame is still in use, the
+    * caller has to allocate an image on its own then.
+    *
+    * \param[out] buffer the memory of the returned frame
+    */
+    mitk::Image::Pointer GetFreeFrame(const mitk::PixelType& pixelType,
+      unsigned int width, unsigned int height, void*& buffer);
+
+    /**
+    * \brief Returns true if the image is one of the frames of this pool
+    */
+    bool Contains(const mitk::Image* image) const;
+
+    /**
+    * \brief Sets the maximum number of frames, 0 disables the pool.
+    * Already allocated frames are released.
+    */
+    void SetNumberOfFrames(unsigned int numberOfFrames);
+    itkGetConstMacro(NumberOfFrames, unsigned int);
+
+    /**
+    * \brief Returns how often a frame buffer had to be allocated
+    */
+    itkGetConstMacro(NumberOfAllocations, unsigned long);
+
+  protected:
+    USImageFramePool();
+    virtual ~USImageFramePool();
+
+    struct Frame
+    {
+      mitk::Image::Pointer Image;
+      void* Buffer;
+    };
+
+    std::vector<Frame> m_Frames;
+    unsigned int m_NumberOfFrames;
+    unsigned int m_NextFrame;
+    unsigned long m_NumberOfAllocations;
+
+    itk::FastMutexLock::Pointer m_FramesMutex;
+  };
+} // namespace mitk
+#endif /* MITKUSImageFramePool_H_HEADER_INCLUDED_ */
@@ -26,7 +26,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 mitk::USImageLoggingFilter::USImageLoggingFilter() : m_SystemTimeClock(RealTimeClock::New()),
-                                                     m_ImageExtension(".nrrd")
+                                                     m_ImageExtension(".nrrd"),
+                                                     m_Recorder(USImageStreamWriter::New()),
+                                                     m_RecordingQueueSize(32),
+                                                     m_RecordingCompression(false)
 {
 }
 
@@ -45,6 +48,13 @@ void mitk::USImageLoggingFilter::GenerateData()
     return;
     }
 
+  //while recording the recorder copies the image and writes it in the background
+  if (m_Recorder->GetIsOpen())
+    {
+    m_Recorder->AddImage(inputImage, m_SystemTimeClock->GetCurrentStamp());
+    return;
+    }
+
   //a clone is needed for a output and to store it.
   mitk::Image::Pointer inputClone = inputImage->Clone();
 
@@ -83,6 +93,18 @@ void mitk::USImageLoggingFilter::GenerateData()
 
 void mitk::USImageLoggingFilter::AddMessageToCurrentImage(std::string message)
 {
+  if (m_Recorder->GetIsOpen())
+    {
+    unsigned int numberOfImages = m_Recorder->GetNumberOfImages();
+    if (numberOfImages == 0)
+      {
+      MITK_WARN << "No image was recorded yet. Cannot add message!";
+      return;
+      }
+    m_Recorder->AddMessage(numberOfImages-1, message);
+    return;
+    }
+
   m_LoggedMessages.insert(std::make_pair(static_cast<int>(m_LoggedImages.size()-1),message));
 }
 
@@ -163,3 +185,26 @@ bool mitk::USImageLoggingFilter::SetImageFilesExtension(std::string extension)
   }
   return false;
  }
+
+void mitk::USImageLoggingFilter::StartRecording(std::string filename)
+{
+  if (m_Recorder->GetIsOpen())
+    {
+    mitkThrow() << "Cannot start recording to " << filename << " because a recording is already running!";
+    }
+
+  if (m_RecordingCompression) m_Recorder->SetCodec(ZLibImageCompressionCodec::New());
+  else m_Recorder->SetCodec(nullptr);
+  m_Recorder->SetMaximumQueueSize(m_RecordingQueueSize);
+  m_Recorder->Open(filename);
+}
+
+void mitk::USImageLoggingFilter::StopRecording()
+{
+  m_Recorder->Close();
+}
+
+bool mitk::USImageLoggingFilter::GetIsRecording()
+{
+  return m_Recorder->GetIsOpen();
+}
@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <MitkUSExports.h>
 #include <mitkImageToImageFilter.h>
 #include <mitkRealTimeClock.h>
+#include "mitkUSImageStreamWriter.h"
 
 
 namespace mitk {
@@ -29,6 +30,9 @@ namespace mitk {
    *  add messages. All data (images, timestamps and messages) is written to the harddisc when
    *  the method SaveImages(...) is called.
    *
+   *  Long sessions can be recorded with StartRecording(...) instead. The images are then streamed to a single
+   *  file by a background thread and are not kept in memory, see mitk::USImageStreamWriter.
+   *
    *  Caution: only supports logging of one input at the moment, multiple inputs are ignored!
    *
    *  \ingroup US
@@ -76,6 +80,31 @@ namespace mitk {
      */
     bool SetImageFilesExtension(std::string extension);
 
+    /** Starts streaming all following images to the given file instead of logging them in memory. The images are
+     *  written by a background thread into a single file, which can be read by mitk::USImageStreamReader. Messages
+     *  added by AddMessageToCurrentImage(...) are written to this file, too.
+     *  @throw mitk::Exception Throws an exception if the file cannot be created.
+     */
+    void StartRecording(std::string filename);
+
+    /** Writes all images which are still queued and closes the file of the recording.
+     *  @throw mitk::Exception Throws an exception if writing to the file failed.
+     */
+    void StopRecording();
+
+    bool GetIsRecording();
+
+    /** Sets the maximum number of images which wait for being written during a recording, default is 32.
+     *  Update() blocks while this number of images is queued.
+     */
+    itkSetMacro(RecordingQueueSize, unsigned int);
+    itkGetMacro(RecordingQueueSize, unsigned int);
+
+    /** Enables the zlib compression of the recorded images, default is off. */
+    itkSetMacro(RecordingCompression, bool);
+    itkGetMacro(RecordingCompression, bool);
+    itkBooleanMacro(RecordingCompression);
+
 
   protected:
     USImageLoggingFilter();
@@ -89,6 +118,11 @@ namespace mitk {
     std::vector<double> m_LoggedMITKSystemTimes; ///< Logged system times for every logged image
     std::string m_ImageExtension; ///< stores the image extension, default is ".nrrd"
 
+    //members for recording
+    mitk::USImageStreamWriter::Pointer m_Recorder; ///< writes the images to disc while recording
+    unsigned int m_RecordingQueueSize; ///< maximum number of images waiting for the recorder
+    bool m_RecordingCompression; ///< true if the recorded images are compressed
+
   };
 } // namespace mitk
 #endif /* MITKUSImageSource_H_HEADER_INCLUDED_ */
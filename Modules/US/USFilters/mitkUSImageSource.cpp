@@ -17,11 +17,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkUSImageSource.h"
 #include "mitkProperties.h"
 
+#include <itkRGBPixel.h>
+
 const char* mitk::USImageSource::IMAGE_PROPERTY_IDENTIFIER = "id_nummer";
 
 mitk::USImageSource::USImageSource()
   : m_OpenCVToMitkFilter(mitk::OpenCVToMitkImageFilter::New()),
   m_MitkToOpenCVFilter(nullptr),
+  m_FramePool(mitk::USImageFramePool::New()),
   m_ImageFilter(mitk::BasicCombinationOpenCVImageFilter::New()),
   m_CurrentImageId(0),
   m_ImageFilterMutex(itk::FastMutexLock::New())
@@ -64,11 +67,7 @@ mitk::Image::Pointer mitk::USImageSource::GetNextImage()
       m_ImageFilterMutex->Unlock();
 
       // convert to MITK image
-      this->m_OpenCVToMitkFilter->SetOpenCVMat(image);
-      this->m_OpenCVToMitkFilter->Update();
-
-      // OpenCVToMitkImageFilter returns a standard mitk::image.
-      result = this->m_OpenCVToMitkFilter->GetOutput();
+      result = this->ConvertToMitkImage(image);
     }
   }
   // Get next image without filtering
@@ -93,6 +92,46 @@ mitk::Image::Pointer mitk::USImageSource::GetNextImage()
   }
 }
 
+mitk::Image::Pointer mitk::USImageSource::ConvertToMitkImage(const cv::Mat& image)
+{
+  mitk::Image::Pointer result;
+  void* buffer = nullptr;
+
+  if (!image.empty() && image.type() == CV_8UC3)
+  {
+    result = m_FramePool->GetFreeFrame(mitk::MakePixelType<itk::Image<itk::RGBPixel<unsigned char>, 2> >(),
+      image.cols, image.rows, buffer);
+    if (result.IsNotNull())
+    {
+      // the header just wraps the buffer of the frame, so the conversion
+      // writes directly into the frame
+      cv::Mat frame(image.rows, image.cols, CV_8UC3, buffer);
+      cv::cvtColor(image, frame, CV_BGR2RGB);
+    }
+  }
+  else if (!image.empty() && image.type() == CV_8UC1)
+  {
+    result = m_FramePool->GetFreeFrame(mitk::MakeScalarPixelType<unsigned char>(),
+      image.cols, image.rows, buffer);
+    if (result.IsNotNull())
+    {
+      cv::Mat frame(image.rows, image.cols, CV_8UC1, buffer);
+      image.copyTo(frame);
+    }
+  }
+
+  if (result.IsNotNull())
+  {
+    result->Modified();
+    return result;
+  }
+
+  // OpenCVToMitkImageFilter returns a standard mitk::image.
+  this->m_OpenCVToMitkFilter->SetOpenCVMat(image);
+  this->m_OpenCVToMitkFilter->Update();
+  return this->m_OpenCVToMitkFilter->GetOutput();
+}
+
 void mitk::USImageSource::GetNextRawImage(cv::Mat& image)
 {
   // create filter object if it does not exist yet
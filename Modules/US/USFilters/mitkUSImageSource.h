@@ -27,6 +27,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBasicCombinationOpenCVImageFilter.h"
 #include "mitkOpenCVToMitkImageFilter.h"
 #include "mitkImageToOpenCVImageFilter.h"
+#include "mitkUSImageFramePool.h"
 
 // OpenCV
 #include "cv.h"
@@ -63,6 +64,12 @@ namespace mitk {
     */
     mitk::Image::Pointer GetNextImage();
 
+    /**
+    * \brief Returns the pool which holds the buffers of the delivered frames.
+    * Setting the number of frames to 0 disables the pool.
+    */
+    itkGetObjectMacro(FramePool, mitk::USImageFramePool);
+
   protected:
     USImageSource();
     virtual ~USImageSource();
@@ -82,6 +89,13 @@ namespace mitk {
     */
     virtual void GetNextRawImage(mitk::Image::Pointer&) = 0;
 
+    /**
+    * \brief Converts the OpenCV image into a free frame of the frame pool.
+    * Pixel types which are not supported by the pool and images received
+    * while all frames are in use are converted by m_OpenCVToMitkFilter.
+    */
+    mitk::Image::Pointer ConvertToMitkImage(const cv::Mat& image);
+
     /**
     * \brief Used to convert from OpenCV Images to MITK Images.
     */
@@ -90,6 +104,10 @@ namespace mitk {
     * \brief Used to convert from MITK Images to OpenCV Images.
     */
     mitk::ImageToOpenCVImageFilter::Pointer m_MitkToOpenCVFilter;
+    /**
+    * \brief Preallocated frames which are recycled as soon as they are released.
+    */
+    mitk::USImageFramePool::Pointer m_FramePool;
 
   private:
     /**
@@ -0,0 +1,397 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageStreamReader.h"
+#include "mitkUSImageStreamWriter.h"
+#include "mitkImageWriteAccessor.h"
+#include "mitkExceptionMacro.h"
+
+#include <itkNrrdImageIO.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+  template <typename T>
+  bool ReadValue(std::istream& stream, T& value)
+  {
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return stream.good();
+  }
+
+  template <typename T>
+  T ExtractValue(const std::vector<char>& buffer, size_t& position)
+  {
+    T value;
+    if (position + sizeof(T) > buffer.size())
+    {
+      mitkThrow() << "Image record is truncated.";
+    }
+    std::memcpy(&value, buffer.data() + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+  }
+
+  const unsigned long long RECORD_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint64_t);
+  const unsigned long long FOOTER_SIZE = sizeof(uint64_t) + sizeof(mitk::USImageStreamWriter::INDEX_MAGIC);
+}
+
+mitk::USImageStreamReader::USImageStreamReader()
+  : m_FileSize(0), m_Codec(mitk::ZLibImageCompressionCodec::New().GetPointer())
+{
+}
+
+mitk::USImageStreamReader::~USImageStreamReader()
+{
+}
+
+void mitk::USImageStreamReader::Open(const std::string& filename)
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+
+  if (m_File.is_open())
+  {
+    m_File.close();
+  }
+  m_File.clear();
+  m_Offsets.clear();
+  m_Timestamps.clear();
+  m_Messages.clear();
+
+  m_File.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!m_File.is_open())
+  {
+    mitkThrow() << "Cannot open image stream file " << filename << ".";
+  }
+  m_FileName = filename;
+
+  char magic[sizeof(USImageStreamWriter::FILE_MAGIC)];
+  uint32_t version = 0;
+  m_File.read(magic, sizeof(magic));
+  if (!m_File.good() || std::memcmp(magic, USImageStreamWriter::FILE_MAGIC, sizeof(magic)) != 0 ||
+    !ReadValue(m_File, version) || version != USImageStreamWriter::FILE_VERSION)
+  {
+    m_File.close();
+    mitkThrow() << filename << " is no image stream file of version " << USImageStreamWriter::FILE_VERSION << ".";
+  }
+
+  m_File.seekg(0, std::ios::end);
+  unsigned long long fileSize = static_cast<unsigned long long>(m_File.tellg());
+  m_FileSize = fileSize;
+
+  if (!this->ReadIndex(fileSize))
+  {
+    MITK_WARN("USImageStreamReader") << "Image stream file " << filename
+      << " has no valid index, scanning all records.";
+    m_Offsets.clear();
+    m_Timestamps.clear();
+    m_Messages.clear();
+    this->ScanRecords(fileSize);
+  }
+}
+
+bool mitk::USImageStreamReader::ReadIndex(unsigned long long fileSize)
+{
+  const unsigned long long headerSize = sizeof(USImageStreamWriter::FILE_MAGIC) + sizeof(uint32_t);
+  if (fileSize < headerSize + RECORD_HEADER_SIZE + FOOTER_SIZE)
+  {
+    return false;
+  }
+
+  uint64_t indexOffset = 0;
+  char magic[sizeof(USImageStreamWriter::INDEX_MAGIC)];
+  m_File.clear();
+  m_File.seekg(fileSize - FOOTER_SIZE);
+  ReadValue(m_File, indexOffset);
+  m_File.read(magic, sizeof(magic));
+  if (!m_File.good() || std::memcmp(magic, USImageStreamWriter::INDEX_MAGIC, sizeof(magic)) != 0 ||
+    indexOffset < headerSize || indexOffset + RECORD_HEADER_SIZE + FOOTER_SIZE > fileSize)
+  {
+    return false;
+  }
+
+  uint32_t type = 0;
+  uint64_t payloadSize = 0;
+  uint64_t numberOfImages = 0;
+  m_File.seekg(indexOffset);
+  // sizes are read from the file, compare them against the known remaining sizes so that they cannot overflow
+  if (!ReadValue(m_File, type) || type != USImageStreamWriter::IndexRecord ||
+    !ReadValue(m_File, payloadSize) || payloadSize != fileSize - FOOTER_SIZE - RECORD_HEADER_SIZE - indexOffset ||
+    !ReadValue(m_File, numberOfImages) || numberOfImages > payloadSize / (sizeof(uint64_t) + sizeof(double)))
+  {
+    return false;
+  }
+
+  m_Offsets.resize(numberOfImages);
+  m_Timestamps.resize(numberOfImages);
+  for (uint64_t i = 0; i < numberOfImages; ++i)
+  {
+    uint64_t offset = 0;
+    double timestamp = 0;
+    if (!ReadValue(m_File, offset) || !ReadValue(m_File, timestamp) || offset > indexOffset - RECORD_HEADER_SIZE)
+    {
+      return false;
+    }
+    m_Offsets[i] = offset;
+    m_Timestamps[i] = timestamp;
+  }
+
+  uint64_t numberOfMessages = 0;
+  if (!ReadValue(m_File, numberOfMessages))
+  {
+    return false;
+  }
+  for (uint64_t i = 0; i < numberOfMessages; ++i)
+  {
+    uint32_t imageIndex = 0;
+    uint32_t length = 0;
+    if (!ReadValue(m_File, imageIndex) || !ReadValue(m_File, length) || length > payloadSize)
+    {
+      return false;
+    }
+    std::string message(length, '\0');
+    m_File.read(&message[0], length);
+    if (!m_File.good())
+    {
+      return false;
+    }
+    // like USImageLoggingFilter only the first message of an image is kept
+    m_Messages.insert(std::make_pair(imageIndex, message));
+  }
+
+  return true;
+}
+
+void mitk::USImageStreamReader::ScanRecords(unsigned long long fileSize)
+{
+  unsigned long long offset = sizeof(USImageStreamWriter::FILE_MAGIC) + sizeof(uint32_t);
+
+  while (offset + RECORD_HEADER_SIZE <= fileSize)
+  {
+    uint32_t type = 0;
+    uint64_t payloadSize = 0;
+    m_File.clear();
+    m_File.seekg(offset);
+    if (!ReadValue(m_File, type) || !ReadValue(m_File, payloadSize) ||
+      payloadSize > fileSize - offset - RECORD_HEADER_SIZE)
+    {
+      // the last record was not written completely
+      break;
+    }
+
+    if (type == USImageStreamWriter::ImageRecord)
+    {
+      double timestamp = 0;
+      if (payloadSize < sizeof(double) || !ReadValue(m_File, timestamp))
+      {
+        break;
+      }
+      m_Offsets.push_back(offset);
+      m_Timestamps.push_back(timestamp);
+    }
+    else if (type == USImageStreamWriter::MessageRecord)
+    {
+      uint32_t imageIndex = 0;
+      if (payloadSize < sizeof(uint32_t) || !ReadValue(m_File, imageIndex))
+      {
+        break;
+      }
+      std::string message(payloadSize - sizeof(uint32_t), '\0');
+      if (!message.empty())
+      {
+        m_File.read(&message[0], message.size());
+      }
+      m_Messages.insert(std::make_pair(imageIndex, message));
+    }
+    else
+    {
+      break;
+    }
+
+    offset += RECORD_HEADER_SIZE + payloadSize;
+  }
+  m_File.clear();
+}
+
+void mitk::USImageStreamReader::Close()
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  m_File.close();
+  m_Offsets.clear();
+  m_Timestamps.clear();
+  m_Messages.clear();
+}
+
+unsigned int mitk::USImageStreamReader::GetNumberOfImages() const
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  return static_cast<unsigned int>(m_Offsets.size());
+}
+
+mitk::Image::Pointer mitk::USImageStreamReader::GetImage(unsigned int index)
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+
+  if (index >= m_Offsets.size())
+  {
+    mitkThrow() << "Image index " << index << " is out of range, the file contains " << m_Offsets.size() << " images.";
+  }
+
+  uint32_t type = 0;
+  uint64_t payloadSize = 0;
+  m_File.clear();
+  m_File.seekg(m_Offsets[index]);
+  if (m_Offsets[index] > m_FileSize - RECORD_HEADER_SIZE || !ReadValue(m_File, type) ||
+    type != USImageStreamWriter::ImageRecord || !ReadValue(m_File, payloadSize) ||
+    payloadSize > m_FileSize - m_Offsets[index] - RECORD_HEADER_SIZE)
+  {
+    mitkThrow() << "Cannot read image " << index << " from " << m_FileName << ".";
+  }
+
+  std::vector<char> payload(payloadSize);
+  m_File.read(payload.data(), payload.size());
+  if (!m_File.good())
+  {
+    mitkThrow() << "Cannot read image " << index << " from " << m_FileName << ".";
+  }
+
+  size_t position = 0;
+  ExtractValue<double>(payload, position);
+  int32_t componentType = ExtractValue<int32_t>(payload, position);
+  int32_t pixelType = ExtractValue<int32_t>(payload, position);
+  uint32_t numberOfComponents = ExtractValue<uint32_t>(payload, position);
+  uint32_t dimension = ExtractValue<uint32_t>(payload, position);
+  if (dimension < 2 || dimension > 3)
+  {
+    mitkThrow() << "Image " << index << " in " << m_FileName << " has an invalid dimension.";
+  }
+
+  unsigned int dimensions[3] = { 1, 1, 1 };
+  for (unsigned int i = 0; i < dimension; ++i)
+  {
+    dimensions[i] = ExtractValue<uint32_t>(payload, position);
+  }
+
+  mitk::AffineTransform3D::Pointer transform = mitk::AffineTransform3D::New();
+  mitk::AffineTransform3D::MatrixType matrix;
+  mitk::AffineTransform3D::OutputVectorType offset;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      matrix[i][j] = ExtractValue<double>(payload, position);
+    }
+  }
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    offset[i] = ExtractValue<double>(payload, position);
+  }
+  transform->SetMatrix(matrix);
+  transform->SetOffset(offset);
+
+  uint32_t compressed = ExtractValue<uint32_t>(payload, position);
+  uint64_t rawSize = ExtractValue<uint64_t>(payload, position);
+
+  // the pixel type is described by the ITK ids, an image IO is the only way
+  // to build an mitk::PixelType from them
+  itk::NrrdImageIO::Pointer imageIO = itk::NrrdImageIO::New();
+  imageIO->SetComponentType(static_cast<itk::ImageIOBase::IOComponentType>(componentType));
+  imageIO->SetPixelType(static_cast<itk::ImageIOBase::IOPixelType>(pixelType));
+  imageIO->SetNumberOfComponents(numberOfComponents);
+
+  mitk::PixelType mitkPixelType = mitk::MakePixelType(imageIO);
+
+  // check the dimensions against the stored size by division, their product could overflow
+  const uint64_t pixelSize = mitkPixelType.GetSize();
+  const size_t dataSize = payload.size() - position;
+  if (pixelSize == 0 || dimensions[0] == 0 || dimensions[1] == 0 || dimensions[2] == 0 ||
+    rawSize % pixelSize != 0 || rawSize / pixelSize / dimensions[0] / dimensions[1] != dimensions[2] ||
+    (rawSize / pixelSize / dimensions[0]) % dimensions[1] != 0 || (rawSize / pixelSize) % dimensions[0] != 0 ||
+    rawSize > std::numeric_limits<size_t>::max() || (!compressed && dataSize != rawSize))
+  {
+    mitkThrow() << "Size of image " << index << " in " << m_FileName << " does not match its dimensions.";
+  }
+  const size_t imageSize = static_cast<size_t>(rawSize);
+
+  mitk::Image::Pointer image = mitk::Image::New();
+  image->Initialize(mitkPixelType, dimension, dimensions);
+
+  {
+    mitk::ImageWriteAccessor accessor(image);
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(payload.data() + position);
+    if (compressed)
+    {
+      if (m_Codec.IsNull() || !m_Codec->Decompress(data, dataSize, static_cast<unsigned char*>(accessor.GetData()), imageSize))
+      {
+        mitkThrow() << "Cannot decompress image " << index << " from " << m_FileName << ".";
+      }
+    }
+    else
+    {
+      std::memcpy(accessor.GetData(), data, imageSize);
+    }
+  }
+
+  image->GetGeometry()->SetIndexToWorldTransform(transform);
+  return image;
+}
+
+double mitk::USImageStreamReader::GetTimestamp(unsigned int index) const
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  if (index >= m_Timestamps.size())
+  {
+    mitkThrow() << "Image index " << index << " is out of range, the file contains " << m_Timestamps.size() << " images.";
+  }
+  return m_Timestamps[index];
+}
+
+unsigned int mitk::USImageStreamReader::GetImageIndex(double timestamp) const
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  std::vector<double>::const_iterator it = std::upper_bound(m_Timestamps.begin(), m_Timestamps.end(), timestamp);
+  if (it == m_Timestamps.begin())
+  {
+    return 0;
+  }
+  return static_cast<unsigned int>(it - m_Timestamps.begin() - 1);
+}
+
+std::string mitk::USImageStreamReader::GetImageMessage(unsigned int index) const
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  std::map<unsigned int, std::string>::const_iterator it = m_Messages.find(index);
+  if (it == m_Messages.end())
+  {
+    return std::string();
+  }
+  return it->second;
+}
+
+void mitk::USImageStreamReader::SetCodec(ImageCompressionCodec* codec)
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  m_Codec = codec;
+}
+
+mitk::ImageCompressionCodec* mitk::USImageStreamReader::GetCodec() const
+{
+  std::lock_guard<std::mutex> lock(m_FileMutex);
+  return m_Codec;
+}
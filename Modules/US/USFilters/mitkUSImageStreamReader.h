@@ -0,0 +1,108 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageStreamReader_H_HEADER_INCLUDED_
+#define MITKUSImageStreamReader_H_HEADER_INCLUDED_
+
+// ITK
+#include <itkObject.h>
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+#include <mitkImageCompressionCodec.h>
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace mitk {
+  /**
+  * \brief Random access to the images of a file written by mitk::USImageStreamWriter.
+  *
+  * Open() reads the index of the file, or rebuilds it by scanning the
+  * records if the recording was not closed properly. Images are only read
+  * from the file when they are requested by GetImage().
+  *
+  * \ingroup US
+  */
+  class MITKUS_EXPORT USImageStreamReader : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageStreamReader, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /**
+    * \brief Opens the file and reads its index.
+    * \throw mitk::Exception if the file cannot be opened or is no image stream file
+    */
+    void Open(const std::string& filename);
+
+    void Close();
+
+    unsigned int GetNumberOfImages() const;
+
+    /**
+    * \brief Reads the image with the given index from the file.
+    * \throw mitk::Exception if the index is out of range or the image cannot be read
+    */
+    mitk::Image::Pointer GetImage(unsigned int index);
+
+    /**
+    * \throw mitk::Exception if the index is out of range
+    */
+    double GetTimestamp(unsigned int index) const;
+
+    /**
+    * \brief Returns the index of the last image recorded at or before the
+    * timestamp, or 0 if the timestamp is before the first image.
+    */
+    unsigned int GetImageIndex(double timestamp) const;
+
+    /**
+    * \brief Returns the message of the image, an empty string if there is none.
+    */
+    std::string GetImageMessage(unsigned int index) const;
+
+    /**
+    * \brief Sets the codec used to decompress the images. It has to match the
+    * codec of the writer, the default is a ZLibImageCompressionCodec.
+    */
+    void SetCodec(ImageCompressionCodec* codec);
+    ImageCompressionCodec* GetCodec() const;
+
+  protected:
+    USImageStreamReader();
+    virtual ~USImageStreamReader();
+
+    bool ReadIndex(unsigned long long fileSize);
+    void ScanRecords(unsigned long long fileSize);
+
+    std::string m_FileName;
+    std::ifstream m_File;
+    unsigned long long m_FileSize;
+    mutable std::mutex m_FileMutex;
+
+    std::vector<unsigned long long> m_Offsets;
+    std::vector<double> m_Timestamps;
+    std::map<unsigned int, std::string> m_Messages;
+
+    ImageCompressionCodec::Pointer m_Codec;
+  };
+} // namespace mitk
+#endif /* MITKUSImageStreamReader_H_HEADER_INCLUDED_ */
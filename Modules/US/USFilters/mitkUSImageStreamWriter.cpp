@@ -0,0 +1,370 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageStreamWriter.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkExceptionMacro.h"
+
+#include <algorithm>
+#include <cstdint>
+
+const char mitk::USImageStreamWriter::FILE_MAGIC[8] = { 'M', 'I', 'T', 'K', 'U', 'S', 'I', 'S' };
+const char mitk::USImageStreamWriter::INDEX_MAGIC[8] = { 'M', 'I', 'T', 'K', 'U', 'S', 'I', 'X' };
+const unsigned int mitk::USImageStreamWriter::FILE_VERSION = 1;
+
+namespace
+{
+  template <typename T>
+  void AppendValue(std::vector<char>& buffer, const T& value)
+  {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  template <typename T>
+  void WriteValue(std::ostream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+}
+
+mitk::USImageStreamWriter::USImageStreamWriter()
+  : m_IsOpen(false),
+  m_MaximumQueueSize(32),
+  m_NumberOfImages(0),
+  m_StopWriting(false),
+  m_WriteFailed(false)
+{
+}
+
+mitk::USImageStreamWriter::~USImageStreamWriter()
+{
+  if (m_IsOpen)
+  {
+    try
+    {
+      this->Close();
+    }
+    catch (mitk::Exception& e)
+    {
+      MITK_ERROR("USImageStreamWriter") << e.GetDescription();
+    }
+  }
+}
+
+void mitk::USImageStreamWriter::Open(const std::string& filename)
+{
+  if (m_IsOpen)
+  {
+    mitkThrow() << "Cannot open " << filename << " because " << m_FileName << " is still open.";
+  }
+
+  m_File.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_File.is_open())
+  {
+    mitkThrow() << "Cannot create image stream file " << filename << ".";
+  }
+
+  m_File.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+  WriteValue<uint32_t>(m_File, FILE_VERSION);
+
+  m_FileName = filename;
+  m_Index.clear();
+  m_Messages.clear();
+  m_NumberOfImages = 0;
+  m_StopWriting = false;
+  m_WriteFailed = !m_File.good();
+  m_IsOpen = true;
+
+  m_WriterThread = std::thread(&USImageStreamWriter::WriteQueuedRecords, this);
+}
+
+unsigned int mitk::USImageStreamWriter::AddImage(const mitk::Image* image, double timestamp)
+{
+  if (!m_IsOpen)
+  {
+    mitkThrow() << "Cannot add an image because the image stream writer is not open.";
+  }
+  if (m_WriteFailed)
+  {
+    mitkThrow() << "Writing to image stream file " << m_FileName << " failed.";
+  }
+  if (image == nullptr || !image->IsInitialized())
+  {
+    mitkThrow() << "Cannot add an image which is not initialized.";
+  }
+
+  const mitk::PixelType pixelType = image->GetPixelType();
+  const unsigned int dimension = std::min(image->GetDimension(), 3u);
+
+  Record record;
+  record.Type = ImageRecord;
+  record.Timestamp = timestamp;
+  record.ImageIndex = 0;
+
+  AppendValue<double>(record.Header, timestamp);
+  AppendValue<int32_t>(record.Header, pixelType.GetComponentType());
+  AppendValue<int32_t>(record.Header, pixelType.GetPixelType());
+  AppendValue<uint32_t>(record.Header, static_cast<uint32_t>(pixelType.GetNumberOfComponents()));
+  AppendValue<uint32_t>(record.Header, dimension);
+
+  size_t size = pixelType.GetSize();
+  for (unsigned int i = 0; i < dimension; ++i)
+  {
+    AppendValue<uint32_t>(record.Header, image->GetDimension(i));
+    size *= image->GetDimension(i);
+  }
+
+  const mitk::AffineTransform3D* transform = image->GetGeometry()->GetIndexToWorldTransform();
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    for (unsigned int j = 0; j < 3; ++j)
+    {
+      AppendValue<double>(record.Header, transform->GetMatrix()[i][j]);
+    }
+  }
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    AppendValue<double>(record.Header, transform->GetOffset()[i]);
+  }
+
+  // the image may be changed or recycled by its source, so the data is copied
+  mitk::ImageReadAccessor accessor(image, image->GetVolumeData(0));
+  const unsigned char* data = static_cast<const unsigned char*>(accessor.GetData());
+  record.Data.assign(data, data + size);
+
+  return this->Enqueue(record);
+}
+
+void mitk::USImageStreamWriter::AddMessage(unsigned int imageIndex, const std::string& message)
+{
+  if (!m_IsOpen)
+  {
+    mitkThrow() << "Cannot add a message because the image stream writer is not open.";
+  }
+  if (m_WriteFailed)
+  {
+    mitkThrow() << "Writing to image stream file " << m_FileName << " failed.";
+  }
+
+  Record record;
+  record.Type = MessageRecord;
+  record.Timestamp = 0;
+  record.ImageIndex = imageIndex;
+  record.Data.assign(message.begin(), message.end());
+
+  this->Enqueue(record);
+}
+
+unsigned int mitk::USImageStreamWriter::Enqueue(Record& record)
+{
+  std::unique_lock<std::mutex> lock(m_QueueMutex);
+  m_QueueNotFull.wait(lock, [this] { return m_Queue.size() < m_MaximumQueueSize || m_WriteFailed; });
+
+  // images are counted in queue order, which is also the order in the file
+  unsigned int numberOfImages = m_NumberOfImages;
+  if (record.Type == ImageRecord)
+  {
+    ++m_NumberOfImages;
+  }
+  m_Queue.push_back(std::move(record));
+
+  lock.unlock();
+  m_QueueNotEmpty.notify_one();
+  return numberOfImages;
+}
+
+void mitk::USImageStreamWriter::WriteQueuedRecords()
+{
+  std::unique_lock<std::mutex> lock(m_QueueMutex);
+  while (true)
+  {
+    m_QueueNotEmpty.wait(lock, [this] { return !m_Queue.empty() || m_StopWriting; });
+    if (m_Queue.empty())
+    {
+      // stopped and everything is written
+      break;
+    }
+
+    Record record = std::move(m_Queue.front());
+    m_Queue.pop_front();
+    lock.unlock();
+    m_QueueNotFull.notify_all();
+
+    this->WriteRecord(record);
+
+    lock.lock();
+  }
+}
+
+void mitk::USImageStreamWriter::WriteRecord(const Record& record)
+{
+  if (m_WriteFailed)
+  {
+    return;
+  }
+
+  unsigned long long offset = static_cast<unsigned long long>(m_File.tellp());
+
+  if (record.Type == ImageRecord)
+  {
+    const unsigned char* data = record.Data.data();
+    uint64_t dataSize = record.Data.size();
+    uint32_t compressed = 0;
+
+    if (m_Codec.IsNotNull() && !record.Data.empty())
+    {
+      m_CompressionBuffer.resize(m_Codec->GetMaximumCompressedSize(record.Data.size()));
+      size_t compressedSize = m_Codec->Compress(record.Data.data(), record.Data.size(),
+        m_CompressionBuffer.data(), m_CompressionBuffer.size());
+
+      // images which do not get smaller are stored uncompressed
+      if (compressedSize > 0 && compressedSize < record.Data.size())
+      {
+        data = m_CompressionBuffer.data();
+        dataSize = compressedSize;
+        compressed = 1;
+      }
+    }
+
+    WriteValue<uint32_t>(m_File, ImageRecord);
+    WriteValue<uint64_t>(m_File, record.Header.size() + sizeof(uint32_t) + sizeof(uint64_t) + dataSize);
+    m_File.write(record.Header.data(), record.Header.size());
+    WriteValue<uint32_t>(m_File, compressed);
+    WriteValue<uint64_t>(m_File, record.Data.size());
+    m_File.write(reinterpret_cast<const char*>(data), dataSize);
+
+    IndexEntry entry;
+    entry.Offset = offset;
+    entry.Timestamp = record.Timestamp;
+    m_Index.push_back(entry);
+  }
+  else if (record.Type == MessageRecord)
+  {
+    WriteValue<uint32_t>(m_File, MessageRecord);
+    WriteValue<uint64_t>(m_File, sizeof(uint32_t) + record.Data.size());
+    WriteValue<uint32_t>(m_File, record.ImageIndex);
+    m_File.write(reinterpret_cast<const char*>(record.Data.data()), record.Data.size());
+
+    m_Messages.push_back(std::make_pair(record.ImageIndex, std::string(record.Data.begin(), record.Data.end())));
+  }
+
+  if (!m_File.good())
+  {
+    MITK_ERROR("USImageStreamWriter") << "Writing to image stream file " << m_FileName << " failed.";
+    m_WriteFailed = true;
+    m_QueueNotFull.notify_all();
+  }
+}
+
+void mitk::USImageStreamWriter::WriteIndex()
+{
+  unsigned long long offset = static_cast<unsigned long long>(m_File.tellp());
+
+  uint64_t payloadSize = sizeof(uint64_t) + m_Index.size() * (sizeof(uint64_t) + sizeof(double)) + sizeof(uint64_t);
+  for (const auto& message : m_Messages)
+  {
+    payloadSize += 2 * sizeof(uint32_t) + message.second.size();
+  }
+
+  WriteValue<uint32_t>(m_File, IndexRecord);
+  WriteValue<uint64_t>(m_File, payloadSize);
+  WriteValue<uint64_t>(m_File, m_Index.size());
+  for (const IndexEntry& entry : m_Index)
+  {
+    WriteValue<uint64_t>(m_File, entry.Offset);
+    WriteValue<double>(m_File, entry.Timestamp);
+  }
+  WriteValue<uint64_t>(m_File, m_Messages.size());
+  for (const auto& message : m_Messages)
+  {
+    WriteValue<uint32_t>(m_File, message.first);
+    WriteValue<uint32_t>(m_File, static_cast<uint32_t>(message.second.size()));
+    m_File.write(message.second.data(), message.second.size());
+  }
+
+  // the footer lets the reader find the index without scanning the file
+  WriteValue<uint64_t>(m_File, offset);
+  m_File.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+}
+
+void mitk::USImageStreamWriter::Close()
+{
+  if (!m_IsOpen)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    m_StopWriting = true;
+  }
+  m_QueueNotEmpty.notify_one();
+  m_WriterThread.join();
+
+  if (!m_WriteFailed)
+  {
+    this->WriteIndex();
+  }
+  m_File.close();
+  m_IsOpen = false;
+
+  if (m_WriteFailed || m_File.fail())
+  {
+    mitkThrow() << "Writing to image stream file " << m_FileName << " failed.";
+  }
+}
+
+bool mitk::USImageStreamWriter::GetIsOpen() const
+{
+  return m_IsOpen;
+}
+
+unsigned int mitk::USImageStreamWriter::GetNumberOfImages() const
+{
+  std::lock_guard<std::mutex> lock(m_QueueMutex);
+  return m_NumberOfImages;
+}
+
+void mitk::USImageStreamWriter::SetMaximumQueueSize(unsigned int size)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    m_MaximumQueueSize = std::max(size, 1u);
+  }
+  m_QueueNotFull.notify_all();
+}
+
+unsigned int mitk::USImageStreamWriter::GetMaximumQueueSize() const
+{
+  std::lock_guard<std::mutex> lock(m_QueueMutex);
+  return m_MaximumQueueSize;
+}
+
+void mitk::USImageStreamWriter::SetCodec(ImageCompressionCodec* codec)
+{
+  if (m_IsOpen)
+  {
+    MITK_WARN("USImageStreamWriter") << "Cannot change the codec while the writer is open.";
+    return;
+  }
+  m_Codec = codec;
+}
+
+mitk::ImageCompressionCodec* mitk::USImageStreamWriter::GetCodec() const
+{
+  return m_Codec;
+}
@@ -0,0 +1,177 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageStreamWriter_H_HEADER_INCLUDED_
+#define MITKUSImageStreamWriter_H_HEADER_INCLUDED_
+
+// ITK
+#include <itkObject.h>
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+#include <mitkImageCompressionCodec.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mitk {
+  /**
+  * \brief Appends images to a single file from a background thread.
+  *
+  * AddImage() copies the image into a queue. A writer thread compresses the
+  * queued images with the optional codec and appends them to the file. The
+  * queue holds at most GetMaximumQueueSize() records and AddImage() blocks
+  * while it is full, so memory stays bounded even if the disk is slower than
+  * the image source. Close() appends an index of all images. The file can be
+  * read by mitk::USImageStreamReader.
+  *
+  * The file starts with FILE_MAGIC and FILE_VERSION, followed by records of
+  * the form (uint32 type, uint64 payload size, payload) in native byte order.
+  * An image record holds the timestamp, pixel type, dimensions, index to
+  * world transform and the pixel data of the first time step. A message
+  * record holds the index of its image and the text. The index record
+  * lists the offsets and timestamps of all images and the messages. A footer
+  * with the index offset and INDEX_MAGIC ends the file. Files without an
+  * index, e.g. from an aborted recording, can still be read by scanning the
+  * records.
+  *
+  * \ingroup US
+  */
+  class MITKUS_EXPORT USImageStreamWriter : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageStreamWriter, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    enum RecordType
+    {
+      ImageRecord = 1,
+      MessageRecord = 2,
+      IndexRecord = 3
+    };
+
+    static const char FILE_MAGIC[8];
+    static const char INDEX_MAGIC[8];
+    static const unsigned int FILE_VERSION;
+
+    /**
+    * \brief Creates the file and starts the writer thread.
+    * \throw mitk::Exception if the file cannot be created or the writer is already open
+    */
+    void Open(const std::string& filename);
+
+    /**
+    * \brief Queues a copy of the first time step of the image. Blocks while the queue is full.
+    * \return the index of the image in the file
+    * \throw mitk::Exception if the writer is not open or a previous write failed
+    */
+    unsigned int AddImage(const mitk::Image* image, double timestamp);
+
+    /**
+    * \brief Queues a message for the image with the given index.
+    * \throw mitk::Exception if the writer is not open or a previous write failed
+    */
+    void AddMessage(unsigned int imageIndex, const std::string& message);
+
+    /**
+    * \brief Writes all queued records and the index and closes the file.
+    * \throw mitk::Exception if writing to the file failed
+    */
+    void Close();
+
+    bool GetIsOpen() const;
+
+    /**
+    * \brief Returns the number of images added since the file was opened.
+    */
+    unsigned int GetNumberOfImages() const;
+
+    /**
+    * \brief Sets the maximum number of queued records, the default is 32.
+    */
+    void SetMaximumQueueSize(unsigned int size);
+    unsigned int GetMaximumQueueSize() const;
+
+    /**
+    * \brief Sets the codec used to compress the images, nullptr (default)
+    * writes them uncompressed. Must not be changed while the writer is open.
+    */
+    void SetCodec(ImageCompressionCodec* codec);
+    ImageCompressionCodec* GetCodec() const;
+
+  protected:
+    USImageStreamWriter();
+    virtual ~USImageStreamWriter();
+
+    struct Record
+    {
+      RecordType Type;
+      double Timestamp;
+      unsigned int ImageIndex;
+      std::vector<char> Header;
+      std::vector<unsigned char> Data;
+    };
+
+    struct IndexEntry
+    {
+      unsigned long long Offset;
+      double Timestamp;
+    };
+
+    /**
+    * \brief Queues a record, blocks while the queue is full.
+    * \return the number of images queued before the record
+    */
+    unsigned int Enqueue(Record& record);
+
+    /**
+    * \brief Main loop of the writer thread.
+    */
+    void WriteQueuedRecords();
+
+    void WriteRecord(const Record& record);
+    void WriteIndex();
+
+    std::string m_FileName;
+    std::ofstream m_File;
+    std::thread m_WriterThread;
+    bool m_IsOpen;
+
+    std::deque<Record> m_Queue;
+    mutable std::mutex m_QueueMutex;
+    std::condition_variable m_QueueNotEmpty;
+    std::condition_variable m_QueueNotFull;
+    unsigned int m_MaximumQueueSize;
+    unsigned int m_NumberOfImages;
+    bool m_StopWriting;
+    std::atomic<bool> m_WriteFailed;
+
+    ImageCompressionCodec::Pointer m_Codec;
+    std::vector<unsigned char> m_CompressionBuffer;
+
+    // only accessed by the writer thread while the file is open
+    std::vector<IndexEntry> m_Index;
+    std::vector<std::pair<unsigned int, std::string> > m_Messages;
+  };
+} // namespace mitk
+#endif /* MITKUSImageStreamWriter_H_HEADER_INCLUDED_ */
@@ -197,21 +197,11 @@ void mitk::USImageVideoSource::GetNextRawImage( cv::Mat& image )
 
 void mitk::USImageVideoSource::GetNextRawImage( mitk::Image::Pointer& image )
 {
-  cv::Mat cv_img;
+  // the capture matrix is kept, so its buffer is reused for every frame
+  this->GetNextRawImage(m_CaptureMat);
 
-  this->GetNextRawImage(cv_img);
-
-  // convert to MITK-Image
-  IplImage ipl_img = cv_img;
-
-  this->m_OpenCVToMitkFilter->SetOpenCVImage(&ipl_img);
-  this->m_OpenCVToMitkFilter->Update();
-
-  // OpenCVToMitkImageFilter returns a standard mitk::image. We then transform it into an USImage
-  image = this->m_OpenCVToMitkFilter->GetOutput();
-
-  // clean up
-  cv_img.release();
+  // convert to MITK-Image, a frame of the frame pool is used if possible
+  image = this->ConvertToMitkImage(m_CaptureMat);
 }
 
 void mitk::USImageVideoSource::OverrideResolution(int width, int height)
@@ -192,6 +192,11 @@ namespace mitk {
       */
     cv::VideoCapture* m_VideoCapture;
 
+    /**
+      * \brief Receives the captured frames, kept to avoid an allocation per frame.
+      */
+    cv::Mat m_CaptureMat;
+
     /**
       * \brief If true, a frame can be grabbed anytime.
       */
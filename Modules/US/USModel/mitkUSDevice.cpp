@@ -585,12 +585,37 @@ void mitk::USDevice::GenerateData()
 
   mitk::Image::Pointer output = this->GetOutput();
 
-  if (!output->IsInitialized() ||
+  // frames of the frame pool are not written while they are referenced, so
+  // the output can use their memory instead of a copy
+  mitk::USImageSource::Pointer imageSource = this->GetUSImageSource();
+  if (imageSource.IsNotNull() && imageSource->GetFramePool()->Contains(m_Image))
+  {
+    if (m_Image != m_ReferencedFrame)
+    {
+      // initializing again drops the data items referencing the last frame
+      output->Initialize(m_Image->GetPixelType(), m_Image->GetDimension(),
+        m_Image->GetDimensions());
+
+      mitk::ImageReadAccessor inputReadAccessor(m_Image,
+        m_Image->GetVolumeData(0));
+      output->SetImportVolume(const_cast<void*>(inputReadAccessor.GetData()),
+        0, 0, mitk::Image::ReferenceMemory);
+      m_ReferencedFrame = m_Image;
+    }
+
+    // the frame keeps its geometry when it is recycled, so the output gets a copy
+    output->SetClonedGeometry(m_Image->GetGeometry());
+    m_ImageMutex->Unlock();
+    return;
+  }
+
+  if (m_ReferencedFrame.IsNotNull() || !output->IsInitialized() ||
     output->GetDimension(0) != m_Image->GetDimension(0) ||
     output->GetDimension(1) != m_Image->GetDimension(1))
   {
     output->Initialize(m_Image->GetPixelType(), m_Image->GetDimension(),
       m_Image->GetDimensions());
+    m_ReferencedFrame = nullptr;
   }
 
   mitk::ImageReadAccessor inputReadAccessor(m_Image,
@@ -323,6 +323,12 @@ namespace mitk {
     mitk::Image::Pointer m_Image;
     mitk::Image::Pointer m_OutputImage;
 
+    /**
+    * \brief Frame of the frame pool whose memory is referenced by the output.
+    * Holding it keeps the frame from being recycled while it is shown.
+    */
+    mitk::Image::Pointer m_ReferencedFrame;
+
     /**
     * \brief Registers an OpenIGTLink device as a microservice so that we can send the images of
     * this device via the network.
@@ -15,7 +15,10 @@ USModel/mitkUSDevicePersistence.cpp
 
 ## Filters and Sources
 USFilters/mitkUSImageLoggingFilter.cpp
+USFilters/mitkUSImageFramePool.cpp
 USFilters/mitkUSImageSource.cpp
+USFilters/mitkUSImageStreamReader.cpp
+USFilters/mitkUSImageStreamWriter.cpp
 USFilters/mitkUSImageVideoSource.cpp
 USFilters/mitkIGTLMessageToUSImageFilter.cpp
 
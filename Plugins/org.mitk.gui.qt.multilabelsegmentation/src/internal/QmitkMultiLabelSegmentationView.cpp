@@ -232,6 +232,7 @@ void QmitkMultiLabelSegmentationView::CreateQtPartControl(QWidget *parent)
 
   connect(m_Controls.m_btAddLayer, SIGNAL(clicked()), this, SLOT(OnAddLayer()));
   connect(m_Controls.m_btDeleteLayer, SIGNAL(clicked()), this, SLOT(OnDeleteLayer()));
+  connect(m_Controls.m_btShowInactiveLayers, SIGNAL(toggled(bool)), this, SLOT(OnShowInactiveLayersToggled(bool)));
   connect(m_Controls.m_btPreviousLayer, SIGNAL(clicked()), this, SLOT(OnPreviousLayer()));
   connect(m_Controls.m_btNextLayer, SIGNAL(clicked()), this, SLOT(OnNextLayer()));
   connect(m_Controls.m_btLockExterior, SIGNAL(toggled(bool)), this, SLOT(OnLockExteriorToggled(bool)));
@@ -239,6 +240,7 @@ void QmitkMultiLabelSegmentationView::CreateQtPartControl(QWidget *parent)
 
   m_Controls.m_btAddLayer->setEnabled(false);
   m_Controls.m_btDeleteLayer->setEnabled(false);
+  m_Controls.m_btShowInactiveLayers->setEnabled(false);
   m_Controls.m_btNextLayer->setEnabled(false);
   m_Controls.m_btPreviousLayer->setEnabled(false);
   m_Controls.m_cbActiveLayer->setEnabled(false);
@@ -525,6 +527,24 @@ void QmitkMultiLabelSegmentationView::OnDeleteLayer()
   m_Controls.m_LabelSetWidget->ResetAllTableWidgetItems();
 }
 
+void QmitkMultiLabelSegmentationView::OnShowInactiveLayersToggled(bool checked)
+{
+  mitk::DataNode *workingNode = m_ToolManager->GetWorkingData(0);
+  assert(workingNode);
+  mitk::LabelSetImage *workingImage = dynamic_cast<mitk::LabelSetImage *>(workingNode->GetData());
+  assert(workingImage);
+
+  // the active layer is always shown, hiding it as well keeps it hidden after switching to another layer
+  this->WaitCursorOn();
+  for (unsigned int layer = 0; layer < workingImage->GetNumberOfLayers(); ++layer)
+  {
+    workingImage->SetLayerVisibility(layer, checked);
+  }
+  this->WaitCursorOff();
+
+  mitk::RenderingManager::GetInstance()->RequestUpdateAll();
+}
+
 void QmitkMultiLabelSegmentationView::OnPreviousLayer()
 {
   m_ToolManager->ActivateTool(-1);
@@ -958,6 +978,7 @@ void QmitkMultiLabelSegmentationView::UpdateControls()
   m_Controls.m_LabelSetWidget->setEnabled(false);
   m_Controls.m_btAddLayer->setEnabled(false);
   m_Controls.m_btDeleteLayer->setEnabled(false);
+  m_Controls.m_btShowInactiveLayers->setEnabled(false);
   m_Controls.m_cbActiveLayer->setEnabled(false);
   m_Controls.m_btPreviousLayer->setEnabled(false);
   m_Controls.m_btNextLayer->setEnabled(false);
@@ -999,12 +1020,22 @@ void QmitkMultiLabelSegmentationView::UpdateControls()
 
       m_Controls.m_cbActiveLayer->setEnabled(numberOfLayers > 1);
       m_Controls.m_btDeleteLayer->setEnabled(numberOfLayers > 1);
+      m_Controls.m_btShowInactiveLayers->setEnabled(numberOfLayers > 1);
       m_Controls.m_btPreviousLayer->setEnabled(activeLayer > 0);
       m_Controls.m_btNextLayer->setEnabled(activeLayer != numberOfLayers - 1);
 
       m_Controls.m_btLockExterior->setChecked(workingImage->GetLabel(0, activeLayer)->GetLocked());
       m_Controls.m_pbShowLabelTable->setChecked(workingImage->GetNumberOfLabels() > 1 /*1st is exterior*/);
 
+      bool inactiveLayersVisible = numberOfLayers < 2;
+      for (int lidx = 0; lidx < numberOfLayers; ++lidx)
+      {
+        inactiveLayersVisible |= lidx != activeLayer && workingImage->GetLayerVisibility(lidx);
+      }
+      m_Controls.m_btShowInactiveLayers->blockSignals(true);
+      m_Controls.m_btShowInactiveLayers->setChecked(inactiveLayersVisible);
+      m_Controls.m_btShowInactiveLayers->blockSignals(false);
+
       //MLI TODO
       //m_Controls.m_ManualToolSelectionBox2D->SetEnabledMode(QmitkToolSelectionBox::EnabledWithWorkingDataVisible);
     }
@@ -86,6 +86,9 @@ protected slots:
   // reaction to the button "Delete Layer"
   void OnDeleteLayer();
 
+  // reaction to the button "Show/Hide Inactive Layers"
+  void OnShowInactiveLayersToggled(bool);
+
   // reaction to the button "Previous Layer"
   void OnPreviousLayer();
 